@@ -10,6 +10,7 @@
  ******************************************************************************/
 #include <stdio.h>
 #include <stdint.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
@@ -17,33 +18,93 @@
 #include "Board.h"
 #include "SerialM32.h"
 #include "System_timer.h"
+#include "Profiler.h"
+#include "Scheduler.h"
 #include "Radio_serial.h"
-#include "common/mavlink.h"
+#include "Mavlink_tx.h"
+#include "Mavlink_rx.h"
+#include "Telemetry.h"
+#include "Event_log.h"
+#include "Param.h"
+#include "GNC_params.h"
+#include "EEPROM2.h"
+#include "Mission.h"
 #include "NEO_M8N.h"
 #include "RC_RX.h"
 #include "RC_servo.h"
 #include "ICM_20948.h"
+#include "IMU_batch.h"
 #include "AHRS.h"
+#include "Lin_alg_rot.h"
+#include "Fast_math.h"
 #include "AS5047D.h"
 #include "PID.h"
+#include "HIL.h"
 
 /*******************************************************************************
  * #DEFINES                                                                    *
  ******************************************************************************/
+//#define IMU_DRDY_MODE // run the control loop on IMU data ready, IMU INT pin on INT1 (RE8)
+//#define IMU_BATCH_DIV 2 // IMU_DRDY_MODE only, batch the IMU at 1125 Hz / (1 + IMU_BATCH_DIV), 0 or 2, 500 Hz and above needs USB_BAUD 460800 or more
 #define HEARTBEAT_PERIOD 1000 //1 sec interval for hearbeat update
+#ifdef IMU_DRDY_MODE
+#define CONTROL_PERIOD 8 //msec, every IMU_DRDY_DECIMATION th IMU sample
+#ifdef IMU_BATCH_DIV
+#define IMU_DRDY_DIV IMU_BATCH_DIV // IMU sample rate set by the batched IMU telemetry
+#else
+#define IMU_DRDY_DIV 8 // 1125 Hz / 9 = 125 Hz, one IMU sample per control run
+#endif
+#define IMU_DRDY_DECIMATION (9 / (1 + IMU_DRDY_DIV)) // IMU samples per 125 Hz control run
+#define IMU_BATCH_PERIOD (1000000000UL * (1 + IMU_DRDY_DIV) / IMU_ODR_BASE) // nsec
+#define IMU_SAMPLE_TICKS (IMU_BATCH_PERIOD * SYS_TIMER_TICKS_PER_USEC / 1000) // system timer ticks per IMU sample
+#else
 #define CONTROL_PERIOD 10 //Period for control loop in msec
-#define PUBLISH_PERIOD 50 // Period for publishing data (msec)
-#define GPS_PERIOD 100 //10 Hz update rate
+#define IMU_BATCH_PERIOD (CONTROL_PERIOD * 1000000UL) // nsec, one IMU read per control run
+#endif
+#define TELEMETRY_PERIOD 10 // msec between passes of the telemetry stream scheduler
+#define MISSION_PERIOD 20 // msec, an item transfer holds the I2C bus about 3.5 msec, the 5 msec write cycle is polled
+#define STREAM_FAST 50000 // usec, 20 Hz sensors and state on USB
+#define STREAM_GPS 100000 // usec, 10 Hz GPS on USB
+#define STREAM_RADIO_ATTITUDE 200000 // usec, the radio carries a slow subset
+#define STREAM_RADIO_SLOW 500000 // usec
+#define STREAM_IMU_BATCH 10000 // usec, at most one batch per telemetry pass
+#define STREAM_PROFILE 20000 // usec, one part of the profile report per pass
+#define VEHICLE_STATE_PAYLOAD 0x8001 // TUNNEL payload_type, above 32767 for local use
+#define VEHICLE_STATE_HOME_SET 0x01 // vehicle state flags
+#define VEHICLE_STATE_HIL 0x02
+#define PROFILE_PERIOD 2000 // Period for publishing the loop timing (msec)
+#define MAVLINK_RX_BUDGET 250 // usec per main loop pass for the MAVLink receive engine
+#define USB_LINK_TIMEOUT 3000 // msec a new USB rate has to receive a MAVLink message in before it goes back
 #define KNOTS_TO_MPS 0.5144444444 //1 meter/second is equal to 1.9438444924406 knots
 #define UINT_16_MAX 0xffff
 #define BUFFER_SIZE 1024
 #define RAW 1
 #define SCALED 2
 #define NUM_MOTORS 4
-#define DT 0.01 //integration constant
+#define DT (CONTROL_PERIOD / 1000.0) //integration constant
+#define DT_MAX (4 * DT) //longest measured interval trusted for integration
 #define MSZ 3 //matrix size
 #define QSZ 4 //quaternion size
-#define NUM_WAYPTS 5
+#define WAYPT_TOLERANCE 1.0 // meters from a waypoint that count as reaching it
+/* profiler sections */
+#define PROF_AHRS 0
+#define PROF_ODOMETRY 1
+#define PROF_GUIDANCE 2
+#define PROF_PUBLISH 3
+/* task table index of the control task, released by IMU data in IMU_DRDY_MODE */
+#define TASK_CONTROL 0
+/* parts of the profile report, one per pass of its stream: the sections and
+ * the jitter, each task, then the HIL, link, receive and log counters */
+#define PROFILE_SECTIONS 0
+#define PROFILE_TASKS (PROFILE_SECTIONS + PROF_MAX_SECTIONS + 1)
+#define PROFILE_HIL (PROFILE_TASKS + NUM_TASKS)
+#define PROFILE_LINKS (PROFILE_HIL + 1)
+#define PROFILE_RX (PROFILE_LINKS + 1)
+#define PROFILE_LOG (PROFILE_RX + 1)
+#define PROFILE_DONE (PROFILE_LOG + 1)
+#define PROFILE_IDLE UINT8_MAX // past the last part, no report under way
+#define DEBUG_VECT_FRAME (MAVLINK_NUM_NON_PAYLOAD_BYTES + MAVLINK_MSG_ID_DEBUG_VECT_LEN)
+#define DEBUG_ARRAY_FRAME (MAVLINK_NUM_NON_PAYLOAD_BYTES + MAVLINK_MSG_ID_DEBUG_FLOAT_ARRAY_LEN)
 
 /*******************************************************************************
  * VARIABLES                                                                   *
@@ -54,22 +115,21 @@ static int8_t RC_system_online = FALSE;
 
 
 RCRX_channel_buffer RC_channels[CHANNELS] = {RC_RX_MID_COUNTS};
-struct IMU_out IMU_raw = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}; //container for raw IMU data
-struct IMU_out IMU_scaled = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}; //container for scaled IMU data
+struct IMU_out IMU_raw = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}; //container for raw IMU data
+struct IMU_out IMU_scaled = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}; //container for scaled IMU data
+static uint64_t AHRS_sample_time = 0; //capture time of the last IMU sample integrated
 static struct GPS_data GPS_data;
 /* publish signal booleans */
 static uint8_t pub_RC_servo = FALSE;
-static uint8_t pub_RC_signals = FALSE;
-static uint8_t pub_IMU = TRUE;
-static uint8_t pub_GPS = TRUE;
-static uint8_t pub_encoders = TRUE;
-static uint8_t pub_attitude = TRUE;
-static uint8_t pub_position = TRUE;
+static uint8_t pub_profile = TRUE;
+static uint8_t profile_part = PROFILE_IDLE; // next part of the report to send
+/* MAVLink counts at the last report; the telemetry streams measure what they
+ * send with the same counts, so the profile never resets them */
+static mavlink_tx_stats_t profile_tx;
 
 /*conversions*/
 const float knots_to_mps = KNOTS_TO_MPS;
 const float dt = DT;
-const float dt_inv = 1 / DT;
 const float deg2rad = M_PI / 180.0;
 const float rad2deg = 180.0 / M_PI;
 const float enc_ticks2radians = 2.0 * M_PI / 16384.0;
@@ -97,6 +157,18 @@ float A_mag[MSZ][MSZ] = {
 float b_acc[MSZ] = {-0.0156750747576770, -0.0118720194488050, -0.0240128301624044};
 float b_mag[MSZ] = {-0.809679246097106, 0.700742334522691, -0.571694648765172};
 
+/* USB serial link, the rate and flow control the UART was last given */
+float usb_baud = SERIAL_BAUD_DEFAULT;
+float usb_flow = SERIAL_FLOW_NONE;
+static uint32_t usb_baud_set = SERIAL_BAUD_DEFAULT;
+static uint8_t usb_flow_set = SERIAL_FLOW_NONE;
+/* the last USB rate a message came in at, the link goes back to it if the
+ * ground station does not follow a switch within USB_LINK_TIMEOUT */
+static uint32_t usb_baud_good = SERIAL_BAUD_DEFAULT;
+static uint8_t usb_flow_good = SERIAL_FLOW_NONE;
+static uint32_t usb_switch_time = 0;
+static uint8_t usb_link_trial = FALSE;
+
 // gravity inertial vector
 float a_i[MSZ] = {0, 0, 1.0};
 // Earth's magnetic field inertial vector, normalized 
@@ -110,6 +182,8 @@ float q[QSZ] = {1, 0, 0, 0};
 float gyro_bias[MSZ] = {0, 0, 0};
 /*euler angles (yaw, pitch, roll) */
 float euler[MSZ] = {0, 0, 0};
+/*attitude DCM, computed once per control tick */
+rot_cache_t att_rot = {{1, 0, 0, 0}, {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}};
 
 /* IMU data arrays */
 float gyro_cal[MSZ] = {0, 0, 0};
@@ -131,13 +205,14 @@ struct state X_old = {.x = 0.0, .y = 0.0, .psi = 0.0, .vx = 0, .vy = 0, .v = 0.0
 
 /* Encoder structs for motors and servo */
 encoder_t enc[] = {
-    {.last_theta = 0, .next_theta = 0, .omega = 0},
-    {.last_theta = 0, .next_theta = 0, .omega = 0},
-    {.last_theta = 0, .next_theta = 0, .omega = 0}
+    {.last_theta = 0, .next_theta = 0, .omega = 0, .last_time = 0, .next_time = 0},
+    {.last_theta = 0, .next_theta = 0, .omega = 0, .last_time = 0, .next_time = 0},
+    {.last_theta = 0, .next_theta = 0, .omega = 0, .last_time = 0, .next_time = 0}
 };
 
 /* steering servo zero position*/
 uint16_t heading_0 = 1805;
+const float delta_scale = 0.6958; // steering angle per servo encoder angle, theoretical linear fit
 /*******************************************************************************
  * CONTROLLERS                                                                 *
  ******************************************************************************/
@@ -164,14 +239,6 @@ PID_controller heading_PID = {
  * GUIDANCE                                                                    *
  ******************************************************************************/
 
-float waypt[NUM_WAYPTS][MSZ] = {
-    3.0, 3.0, 0.0,
-    3.0, -3.0, 0.0,
-    -3.0, 3.0, 0.0,
-    -3.0, -3.0, 0.0,
-    0.0, 0.0, 0.0
-};
-
 double home[] = {0.0, 0.0, 0.0}; // home position in {lon, lat, alt}
 double home_tp[] = {0.0, 0.0, 0.0}; // home in tangent plane (meters)
 double X_tp[] = {0.0, 0.0, 0.0}; // current position in tangent plane
@@ -213,11 +280,54 @@ enum motors {
     LIDAR_SERVO
 };
 
+/* MAVLink channels, frames are built in place in the port's DMA block */
 enum mav_output_type {
-    USB,
-    RADIO
+    USB = MAVLINK_TX_USB,
+    RADIO = MAVLINK_TX_RADIO,
+    USB_RADIO = MAVLINK_TX_ALL
 };
 
+/* Snapshot of the vehicle state taken at the end of each control run, so
+ * every field comes from the same tick.  Sent as the first
+ * VEHICLE_STATE_LENGTH bytes of a TUNNEL payload of type
+ * VEHICLE_STATE_PAYLOAD, little endian, python/state_decode.py reads it:
+ *  0 uint64  capture time of the IMU sample the run integrated, usec
+ *  8 float   attitude quaternion w, x, y, z
+ * 24 float   gyro bias x, y, z, rad/sec
+ * 36 float   X_new: x, y meters, psi rad, vx, vy, v m/s, delta rad
+ * 64 float   left and right wheel omega, rad/sec
+ * 72 float   velocity and heading PID outputs
+ * 80 uint32  control runs since boot
+ * 84 uint16  measured AHRS interval, usec
+ * 86 uint16  control run time up to the snapshot, usec
+ * 88 uint8   mission_mode, MANUAL, CRUISE, AUTO, BADRCVAL
+ * 89 uint8   VEHICLE_STATE_HOME_SET, VEHICLE_STATE_HIL flags */
+typedef struct {
+    uint64_t usec;
+    float q[QSZ];
+    float gyro_bias[MSZ];
+    struct state X;
+    float omega[2];
+    float u_v;
+    float u_heading;
+    uint32_t runs;
+    uint16_t dt;
+    uint16_t exec;
+    uint8_t mode;
+    uint8_t flags;
+} vehicle_state_t;
+#define VEHICLE_STATE_LENGTH (offsetof(vehicle_state_t, flags) + 1) // no tail padding
+
+/* control and reporting state shared by the scheduler tasks */
+static int8_t IMU_state = ERROR;
+static int8_t IMU_retry = 5;
+static uint32_t IMU_error = 0;
+static const uint8_t error_report = 50;
+static uint8_t mission_mode = MANUAL;
+static int8_t is_home_set = FALSE;
+static uint8_t HIL_outputs_parked = FALSE;
+static vehicle_state_t vehicle_state; // snapshot of the last control run
+
 /*******************************************************************************
  * FUNCTION PROTOTYPES                                                         *
  ******************************************************************************/
@@ -233,6 +343,8 @@ void check_GPS_events(void);
  * @function check_IMU_events(void)
  * @param none
  * @brief detects when IMU SPI transaction completes and then publishes data over Mavlink
+ * @note every queued sample goes to the batched IMU telemetry, the control
+ * gets the latest, in IMU_DRDY_MODE every IMU_DRDY_DECIMATION th
  * @author Aaron Hunter
  */
 void check_IMU_events(void);
@@ -244,14 +356,82 @@ void check_IMU_events(void);
  */
 void check_RC_events();
 /**
- * @function check_radio_events(void)
+ * @function check_MAVLink_events(void)
  * @param none
- * @brief looks for messages sent over the radio serial port to OSAVC, parses
- * them and provides responses, if needed
- * @note currently only pushing information to usb-serial port
+ * @brief drains the messages waiting on the radio and USB ports within
+ * MAVLINK_RX_BUDGET, each goes to its handler in mav_handlers, and puts the
+ * USB link back on its old rate if a switch hears nothing in USB_LINK_TIMEOUT
  * @author Aaron Hunter
  */
-void check_radio_events(void);
+void check_MAVLink_events(void);
+
+/**
+ * @function handle_HIL(const mavlink_message_t *msg, uint8_t port)
+ * @param msg, message received
+ * @param port, USB or RADIO, the link it arrived on
+ * @brief injects HIL data, RAW_RPM outside of HIL mode goes to
+ * handle_unknown()
+ * @author Aaron Hunter
+ */
+void handle_HIL(const mavlink_message_t *msg, uint8_t port);
+
+/**
+ * @function handle_heartbeat(const mavlink_message_t *msg, uint8_t port)
+ * @param msg, message received
+ * @param port, USB or RADIO, the link it arrived on
+ * @brief logs a ground station heartbeat
+ * @author Aaron Hunter
+ */
+void handle_heartbeat(const mavlink_message_t *msg, uint8_t port);
+
+/**
+ * @function handle_command_long(const mavlink_message_t *msg, uint8_t port)
+ * @param msg, message received
+ * @param port, USB or RADIO, the link it arrived on
+ * @brief stream interval commands go to the telemetry scheduler, the rest are
+ * logged
+ * @author Aaron Hunter
+ */
+void handle_command_long(const mavlink_message_t *msg, uint8_t port);
+
+/**
+ * @function handle_stream_request(const mavlink_message_t *msg, uint8_t port)
+ * @param msg, message received
+ * @param port, USB or RADIO, the link it arrived on
+ * @brief REQUEST_DATA_STREAM sets the rates of the port's streams, one for
+ * another system goes to handle_unknown()
+ * @author Aaron Hunter
+ */
+void handle_stream_request(const mavlink_message_t *msg, uint8_t port);
+
+/**
+ * @function handle_param(const mavlink_message_t *msg, uint8_t port)
+ * @param msg, message received
+ * @param port, USB or RADIO, the link it arrived on
+ * @brief parameter reads, sets and lists go to the parameter table, one for
+ * another system goes to handle_unknown()
+ * @author Aaron Hunter
+ */
+void handle_param(const mavlink_message_t *msg, uint8_t port);
+
+/**
+ * @function handle_mission(const mavlink_message_t *msg, uint8_t port)
+ * @param msg, message received
+ * @param port, USB or RADIO, the link it arrived on
+ * @brief mission uploads, downloads, clears and jumps go to the mission
+ * store, one for another system goes to handle_unknown()
+ * @author Aaron Hunter
+ */
+void handle_mission(const mavlink_message_t *msg, uint8_t port);
+
+/**
+ * @function handle_unknown(const mavlink_message_t *msg, uint8_t port)
+ * @param msg, message received
+ * @param port, USB or RADIO, the link it arrived on
+ * @brief logs a message without a handler
+ * @author Aaron Hunter
+ */
+void handle_unknown(const mavlink_message_t *msg, uint8_t port);
 /**
  * @function check_encoder_events(void)
  * @param none
@@ -276,61 +456,93 @@ void publish_GPS(uint8_t dest);
  */
 
 void publish_IMU_data(uint8_t data_type, uint8_t dest);
+
 /**
- * @function publish_RC_signals_raw(void)
- * @param none
+ * @function publish_IMU_scaled(uint8_t dest)
+ * @param dest, USB or RADIO
+ * @brief publish_IMU_data() of the SCALED data, the IMU telemetry stream
+ * @author Aaron Hunter
+ */
+void publish_IMU_scaled(uint8_t dest);
+
+/**
+ * @function publish_IMU_batch(uint8_t dest)
+ * @param dest, USB or RADIO
+ * @brief sends the oldest closed batch of raw IMU samples, the batched IMU
+ * telemetry stream
+ */
+void publish_IMU_batch(uint8_t dest);
+
+/**
+ * @function publish_RC_signals_raw(uint8_t dest)
+ * @param dest, USB or RADIO
  * @brief scales raw RC signals
  * @author Aaron Hunter
  */
-void publish_RC_signals_raw(void);
+void publish_RC_signals_raw(uint8_t dest);
 
 /**
- * @function publish_encoder_data(void)
+ * @function publish_encoder_data(uint8_t dest)
  * @brief publish left and right encoder data as "RPM"
  * @note: uses index 0 = LEFT_MOTOR, 1 = RIGHT_MOTOR, 2 = HEADING
  * @note for steering servo (heading) we use the absolute position in radians,
  * velocities are published as raw differences in angles (radians)
  */
-void publish_encoder_data(void);
+void publish_encoder_data(uint8_t dest);
 
 /**
- * @function publish_attitude(void)
+ * @function publish_attitude(uint8_t dest)
  * @brief publishes the quaternion attitude in ENU format
  */
-void publish_attitude(void);
+void publish_attitude(uint8_t dest);
 
 /**
- * @function publish_position(void)
+ * @function publish_position(uint8_t dest)
  * @brief publishes the rover state variables in local coordinates
  */
-void publish_position(void);
+void publish_position(uint8_t dest);
 
 /**
- * @Function publish_heartbeat(uint8_t dest)
- * @param dest, either USB or RADIO
- * @brief publishes heartbeat message 
- * @return none
- * @author Aaron Hunter
+ * @function publish_vehicle_state(uint8_t dest)
+ * @param dest, USB or RADIO
+ * @brief publishes the snapshot of the last control run as one TUNNEL
+ * message, see vehicle_state_t
  */
-void publish_heartbeat(uint8_t dest);
+void publish_vehicle_state(uint8_t dest);
 
 /**
- * @Function publish_h(uint8_t param_id[16], uint8_t dest)
- * @param parameter ID
+ * @function publish_profile(uint8_t dest)
  * @param dest, USB or RADIO
- * @brief invokes mavlink helper to send out stored parameter 
- * @author aaron hunter
+ * @brief publishes the next part of the report profile_task() started:
+ * min/mean/max execution time of each profiler section and the tick jitter
+ * as DEBUG_VECT in usec with their histograms as DEBUG_FLOAT_ARRAY, the
+ * scheduler overrun and miss counts, in HIL mode also the injection rates
+ * and latency, the MAVLink frames sent and dropped, the UART drops by class,
+ * the receive counts and pass time, the event log counts and the batched IMU
+ * rate and losses, each counter starting a new window once sent; a stream,
+ * so the report is paced with the rest, and a part waits for room in the
+ * port rather than being dropped
  */
-void publish_parameter(uint8_t param_id[16], uint8_t dest);
+void publish_profile(uint8_t dest);
+
 /**
- * @Function mavprint(char msg_buffer[], int8_t msg_length, int8_t output);
- * @param msg_buffer, string of bytes to send to receiver
- * @param msg_length, length of msg_buffer
- * @param output, either USB or RADIO, which peripheral to send the message from
- * @return SUCCESS or ERROR
+ * @function publish_telemetry(uint8_t dest)
+ * @param dest, USB or RADIO
+ * @brief publishes the telemetry bytes/sec and waits of each port as
+ * DEBUG_VECT and the achieved rate in Hz of each stream as DEBUG_FLOAT_ARRAY
+ * with array_id the port, then starts a new window; a stream itself, so the
+ * report is paced with the rest and never dropped
  */
-int8_t mavprint(uint8_t msg_buffer[], uint8_t msg_length, uint8_t output);
+void publish_telemetry(uint8_t dest);
 
+/**
+ * @Function publish_heartbeat(uint8_t dest)
+ * @param dest, USB, RADIO or USB_RADIO for both
+ * @brief publishes heartbeat message 
+ * @return none
+ * @author Aaron Hunter
+ */
+void publish_heartbeat(uint8_t dest);
 /**
  * @Function calc_pw(uint16_t raw_counts)
  * @param raw counts from the radio transmitter (11 bit unsigned int)
@@ -360,22 +572,45 @@ uint8_t check_mission_status(void);
  */
 void set_control_output(uint8_t mode);
 
+/**
+ * @Function get_waypoint(float waypt[MSZ])
+ * @param waypt, the current waypoint in meters, odometry frame
+ * @return TRUE, or FALSE if the current item is not read from the EEPROM yet
+ * or the mission has no waypoint left
+ * @brief skips the mission items that are not waypoints
+ * @author Aaron Hunter
+ */
+uint8_t get_waypoint(float waypt[MSZ]);
+
+/**
+ * @function set_output(uint16_t pulse, uint8_t output)
+ * @param pulse, servo pulse in usec
+ * @param output, MOTOR_LEFT, MOTOR_RIGHT or STEERING_SERVO
+ * @return none
+ * @brief sets the servo output, in HIL mode the pulse is returned to the
+ * simulator instead
+ * @author Aaron Hunter
+ */
+void set_output(uint16_t pulse, uint8_t output);
 
 /**
- * @function Rover_quat2euler()
- * @param q A quaternion
- * @param euler a vector of euler angles in [psi, theta, roll] order
+ * @function HIL_set_encoders(void)
+ * @return none
+ * @brief fills the encoder structs from the injected wheel rates (RAW_RPM
+ * index 0 and 1, rad/sec) and steering angle (index 2, rad) as if the
+ * encoders were read now
+ * @author Aaron Hunter
  */
-void Rover_quat2euler(float q[MSZ], float euler[MSZ]);
+void HIL_set_encoders(void);
 
 /**
- * @function q_rot_v_q()
- * Rotate a vector from the inertial frame to the body frame
- * @param v_i, a 3space vector in the inertial frame
- * @param q an attitude quaternion
- * sets v_b to the rotated inertial vector in the body frame
+ * @function publish_HIL_actuators(void)
+ * @return none
+ * @brief returns the outputs to the simulator on the link it uses
+ * @author Aaron Hunter
  */
-void q_rot_v_q(float v_i[MSZ], float q[QSZ], float v_b[MSZ]);
+void publish_HIL_actuators(void);
+
 
 /**
  * @function update_odometry(void)
@@ -391,12 +626,262 @@ void update_odometry(void);
  */
 float low_pass(float x);
 
+/**
+ * @function measured_dt(uint64_t last, uint64_t next)
+ * @param last, capture time of the previous sample
+ * @param next, capture time of the current sample
+ * @return interval between the samples in seconds, DT if it is not valid, e.g.
+ * the first sample or the same sample twice, or longer than DT_MAX
+ */
+float measured_dt(uint64_t last, uint64_t next);
+
+/**
+ * @function snapshot_state(float AHRS_dt, uint32_t start)
+ * @param AHRS_dt, interval the AHRS integrated over, seconds
+ * @param start, core timer count at the start of the control run
+ * @brief copies the state of this control run into vehicle_state
+ */
+void snapshot_state(float AHRS_dt, uint32_t start);
+
 /**
  * @function int8_t set_home();
  * @brief:  If GPS data is valid, set home position to current location
  * @return home_set, TRUE, or FALSE
  */
 int8_t set_home(void);
+
+/**
+ * @function control_task(void)
+ * @brief AHRS, odometry and guidance every CONTROL_PERIOD, then starts the
+ * next encoder and IMU acquisition, in IMU_DRDY_MODE on every
+ * IMU_DRDY_DECIMATION th IMU sample
+ * and the IMU starts its own acquisition, in HIL mode on the injected sensors
+ * and the outputs go back to the simulator
+ */
+void control_task(void);
+
+/**
+ * @function telemetry_task(void)
+ * @brief publishes the telemetry streams that are due and fit the links every
+ * TELEMETRY_PERIOD
+ */
+void telemetry_task(void);
+
+/**
+ * @function mission_task(void)
+ * @brief stores an uploaded mission item, serves a download or reads the
+ * next waypoint into RAM every MISSION_PERIOD
+ */
+void mission_task(void);
+
+/**
+ * @function heartbeat_task(void)
+ * @brief publishes the heartbeat, sets home on the first GPS fix, logs the
+ * rover state and sends the event log every HEARTBEAT_PERIOD
+ */
+void heartbeat_task(void);
+
+/**
+ * @function profile_task(void)
+ * @brief starts a profile report every PROFILE_PERIOD, its stream sends it a
+ * part per pass; a report the link has not finished yet carries on instead
+ */
+void profile_task(void);
+
+/**
+ * @function apply_velocity_gains(void)
+ * @brief new VEL_ gains take effect without resetting the velocity PID
+ */
+void apply_velocity_gains(void);
+
+/**
+ * @function apply_heading_gains(void)
+ * @brief new HDG_ gains take effect without resetting the heading PID
+ */
+void apply_heading_gains(void);
+
+/**
+ * @function apply_AHRS_gains(void)
+ * @brief loads the AHRS_ filter gains into the AHRS
+ */
+void apply_AHRS_gains(void);
+
+/**
+ * @function apply_IMU_cal(void)
+ * @brief loads the CAL_ matrices and offsets into the IMU driver
+ */
+void apply_IMU_cal(void);
+
+/**
+ * @function apply_USB_link(void)
+ * @brief moves the USB serial port to USB_BAUD with USB_FLOW flow control
+ * once the bytes queued at the old rate are out, so the reply to the
+ * PARAM_SET comes at the new rate; a rate the UART cannot make is logged
+ * and the parameters go back to the rate in use, so does a rate no MAVLink
+ * message arrives at within USB_LINK_TIMEOUT, see check_MAVLink_events()
+ */
+void apply_USB_link(void);
+
+/*******************************************************************************
+ * TASKS                                                                       *
+ ******************************************************************************/
+/* control first, the rest are phased apart so they do not share a release,
+ * but the mission store follows telemetry so its EEPROM transfer starts early
+ * enough to end before the next control release */
+static sched_task_t tasks[] = {
+#ifdef IMU_DRDY_MODE
+    SCHED_EVENT_TASK("control", control_task, CONTROL_PERIOD, 0, 0),
+#else
+    SCHED_TASK("control", control_task, CONTROL_PERIOD, 0, 0, 0),
+#endif
+    SCHED_TASK("telemetry", telemetry_task, TELEMETRY_PERIOD, 1, 1, 0),
+    SCHED_TASK("mission", mission_task, MISSION_PERIOD, 1, 2, 0),
+    SCHED_TASK("heartbeat", heartbeat_task, HEARTBEAT_PERIOD, 5, 3, 0),
+    SCHED_TASK("profile", profile_task, PROFILE_PERIOD, 7, 4, 0),
+};
+#define NUM_TASKS (sizeof (tasks) / sizeof (tasks[0]))
+
+/*******************************************************************************
+ * TELEMETRY STREAMS                                                           *
+ ******************************************************************************/
+/* default intervals for {RADIO, USB}, the first stream wins a tie for the link,
+ * ground stations change them per port with MAV_CMD_SET_MESSAGE_INTERVAL or
+ * REQUEST_DATA_STREAM */
+static const telemetry_stream_t streams[] = {
+    {MAVLINK_MSG_ID_TUNNEL, MAV_DATA_STREAM_EXTRA1, publish_vehicle_state, {TELEMETRY_OFF, STREAM_FAST}},
+    {MAVLINK_MSG_ID_ATTITUDE_QUATERNION, MAV_DATA_STREAM_EXTRA1, publish_attitude, {STREAM_RADIO_ATTITUDE, TELEMETRY_OFF}},
+    {MAVLINK_MSG_ID_HIGHRES_IMU, MAV_DATA_STREAM_RAW_SENSORS, publish_IMU_scaled, {TELEMETRY_OFF, STREAM_FAST}},
+    {MAVLINK_MSG_ID_RAW_RPM, MAV_DATA_STREAM_RAW_SENSORS, publish_encoder_data, {TELEMETRY_OFF, TELEMETRY_OFF}},
+    {MAVLINK_MSG_ID_LOCAL_POSITION_NED, MAV_DATA_STREAM_POSITION, publish_position, {STREAM_RADIO_SLOW, TELEMETRY_OFF}},
+    {MAVLINK_MSG_ID_GPS_RAW_INT, MAV_DATA_STREAM_EXTENDED_STATUS, publish_GPS, {STREAM_RADIO_SLOW, STREAM_GPS}},
+    {MAVLINK_MSG_ID_RC_CHANNELS_RAW, MAV_DATA_STREAM_RC_CHANNELS, publish_RC_signals_raw, {TELEMETRY_OFF, TELEMETRY_OFF}},
+    {MAVLINK_MSG_ID_ENCAPSULATED_DATA, MAV_DATA_STREAM_RAW_SENSORS, publish_IMU_batch, {TELEMETRY_OFF, STREAM_IMU_BATCH}},
+    {MAVLINK_MSG_ID_DEBUG_FLOAT_ARRAY, MAV_DATA_STREAM_EXTRA3, publish_telemetry, {TELEMETRY_OFF, PROFILE_PERIOD * 1000UL}},
+    {MAVLINK_MSG_ID_DEBUG_VECT, MAV_DATA_STREAM_EXTRA3, publish_profile, {TELEMETRY_OFF, STREAM_PROFILE}},
+};
+#define NUM_STREAMS (sizeof (streams) / sizeof (streams[0]))
+
+/*******************************************************************************
+ * MAVLINK HANDLERS                                                            *
+ ******************************************************************************/
+/* received messages by id, anything else goes to handle_unknown() */
+static const mavlink_rx_entry_t mav_handlers[] = {
+    {MAVLINK_MSG_ID_HIL_SENSOR, handle_HIL},
+    {MAVLINK_MSG_ID_HIL_GPS, handle_HIL},
+    {MAVLINK_MSG_ID_RAW_RPM, handle_HIL},
+    {MAVLINK_MSG_ID_HEARTBEAT, handle_heartbeat},
+    {MAVLINK_MSG_ID_COMMAND_LONG, handle_command_long},
+    {MAVLINK_MSG_ID_REQUEST_DATA_STREAM, handle_stream_request},
+    {MAVLINK_MSG_ID_PARAM_REQUEST_READ, handle_param},
+    {MAVLINK_MSG_ID_PARAM_REQUEST_LIST, handle_param},
+    {MAVLINK_MSG_ID_PARAM_SET, handle_param},
+    {MAVLINK_MSG_ID_MISSION_COUNT, handle_mission},
+    {MAVLINK_MSG_ID_MISSION_ITEM_INT, handle_mission},
+    {MAVLINK_MSG_ID_MISSION_REQUEST_LIST, handle_mission},
+    {MAVLINK_MSG_ID_MISSION_REQUEST_INT, handle_mission},
+    {MAVLINK_MSG_ID_MISSION_REQUEST, handle_mission},
+    {MAVLINK_MSG_ID_MISSION_ACK, handle_mission},
+    {MAVLINK_MSG_ID_MISSION_CLEAR_ALL, handle_mission},
+    {MAVLINK_MSG_ID_MISSION_SET_CURRENT, handle_mission},
+};
+#define NUM_MAV_HANDLERS (sizeof (mav_handlers) / sizeof (mav_handlers[0]))
+
+/*******************************************************************************
+ * EVENT LOG                                                                   *
+ ******************************************************************************/
+/* diagnostics sent as binary records on the radio, in log_events order;
+ * python/log_decode.py reads the formats from this table */
+enum log_id {
+    LOG_BOOT,
+    LOG_RC_ONLINE,
+    LOG_RC_OFFLINE,
+    LOG_IMU_RETRY,
+    LOG_IMU_DRDY_OFF,
+    LOG_IMU_ERRORS,
+    LOG_ODOMETRY,
+    LOG_LTP,
+    LOG_BAD_RC,
+    LOG_GCS_HEARTBEAT,
+    LOG_COMMAND,
+    LOG_PARAM_HASH,
+    LOG_NO_MISSION,
+    LOG_UNKNOWN_MSG,
+    LOG_USB_BAUD,
+    LOG_USB_REVERT,
+};
+
+static const log_event_t log_events[] = {
+    LOG_EVENT("ss", "Rover Manual Control App %s, %s"), // LOG_BOOT
+    LOG_EVENT("", "RC system online."), // LOG_RC_ONLINE
+    LOG_EVENT("", "RC system failed to connect!"), // LOG_RC_OFFLINE
+    LOG_EVENT("i", "IMU failed init, retrying %d"), // LOG_IMU_RETRY
+    LOG_EVENT("", "IMU data ready not enabled!"), // LOG_IMU_DRDY_OFF
+    LOG_EVENT("uu", "IMU errors: %u, buf: %u"), // LOG_IMU_ERRORS
+    LOG_EVENT("fffffff", "x: %3.1f y: %3.1f psi: %3.1f vx: %3.1f vy: %3.1f v: %3.1f delta: %3.1f"), // LOG_ODOMETRY
+    LOG_EVENT("uffll", "timer: %u;  LTP: y=%3.6f x=%3.6f, GPS: lat: %3.7f, lon: %3.7f"), // LOG_LTP
+    LOG_EVENT("iiiiii", "bad RC values thr: %d ail: %d ele: %d rud: %d hash: %d check: %d"), // LOG_BAD_RC
+    LOG_EVENT("u", "heartbeat received type(%u)"), // LOG_GCS_HEARTBEAT
+    LOG_EVENT("u", "Command ID %u received from Ground Control"), // LOG_COMMAND
+    LOG_EVENT("", "Parameter hash is stale, run python/param_hash.py"), // LOG_PARAM_HASH
+    LOG_EVENT("", "No mission stored, upload one to drive in AUTO"), // LOG_NO_MISSION
+    LOG_EVENT("uuuu", "Received message with ID %u, sequence: %u from component %u of system %u"), // LOG_UNKNOWN_MSG
+    LOG_EVENT("uu", "USB baud %u refused, staying at %u"), // LOG_USB_BAUD
+    LOG_EVENT("uu", "Nothing received at USB baud %u, back to %u"), // LOG_USB_REVERT
+};
+#define NUM_LOG_EVENTS (sizeof (log_events) / sizeof (log_events[0]))
+
+/*******************************************************************************
+ * PARAMETERS                                                                  *
+ ******************************************************************************/
+#define PID_GAIN_MAX 1000.0
+#define AHRS_GAIN_MAX 100.0
+#define CAL_SCALE_MAX 1.0 // per count, the matrices are about 6e-5 and 3.5e-3
+#define CAL_OFFSET_MAX 10.0
+#define USB_BAUD_MIN 9600.0
+#define USB_BAUD_MAX 1000000.0
+
+/* ground station tunables, the index is the PARAM_VALUE index; run
+ * python/param_hash.py after changing the ids to update GNC_params.h */
+static const param_t parameters[] = {
+    PARAM_ENTRY("VEL_KP", &v_PID.kp, 0.0, PID_GAIN_MAX, apply_velocity_gains),
+    PARAM_ENTRY("VEL_KI", &v_PID.ki, 0.0, PID_GAIN_MAX, apply_velocity_gains),
+    PARAM_ENTRY("VEL_KD", &v_PID.kd, 0.0, PID_GAIN_MAX, apply_velocity_gains),
+    PARAM_ENTRY("HDG_KP", &heading_PID.kp, 0.0, PID_GAIN_MAX, apply_heading_gains),
+    PARAM_ENTRY("HDG_KI", &heading_PID.ki, 0.0, PID_GAIN_MAX, apply_heading_gains),
+    PARAM_ENTRY("HDG_KD", &heading_PID.kd, 0.0, PID_GAIN_MAX, apply_heading_gains),
+    PARAM_ENTRY("AHRS_KP_ACC", &kp_a, 0.0, AHRS_GAIN_MAX, apply_AHRS_gains),
+    PARAM_ENTRY("AHRS_KI_ACC", &ki_a, 0.0, AHRS_GAIN_MAX, apply_AHRS_gains),
+    PARAM_ENTRY("AHRS_KP_MAG", &kp_m, 0.0, AHRS_GAIN_MAX, apply_AHRS_gains),
+    PARAM_ENTRY("AHRS_KI_MAG", &ki_m, 0.0, AHRS_GAIN_MAX, apply_AHRS_gains),
+    PARAM_ENTRY("CAL_ACC_A11", &A_acc[0][0], -CAL_SCALE_MAX, CAL_SCALE_MAX, apply_IMU_cal),
+    PARAM_ENTRY("CAL_ACC_A12", &A_acc[0][1], -CAL_SCALE_MAX, CAL_SCALE_MAX, apply_IMU_cal),
+    PARAM_ENTRY("CAL_ACC_A13", &A_acc[0][2], -CAL_SCALE_MAX, CAL_SCALE_MAX, apply_IMU_cal),
+    PARAM_ENTRY("CAL_ACC_A21", &A_acc[1][0], -CAL_SCALE_MAX, CAL_SCALE_MAX, apply_IMU_cal),
+    PARAM_ENTRY("CAL_ACC_A22", &A_acc[1][1], -CAL_SCALE_MAX, CAL_SCALE_MAX, apply_IMU_cal),
+    PARAM_ENTRY("CAL_ACC_A23", &A_acc[1][2], -CAL_SCALE_MAX, CAL_SCALE_MAX, apply_IMU_cal),
+    PARAM_ENTRY("CAL_ACC_A31", &A_acc[2][0], -CAL_SCALE_MAX, CAL_SCALE_MAX, apply_IMU_cal),
+    PARAM_ENTRY("CAL_ACC_A32", &A_acc[2][1], -CAL_SCALE_MAX, CAL_SCALE_MAX, apply_IMU_cal),
+    PARAM_ENTRY("CAL_ACC_A33", &A_acc[2][2], -CAL_SCALE_MAX, CAL_SCALE_MAX, apply_IMU_cal),
+    PARAM_ENTRY("CAL_ACC_B1", &b_acc[0], -CAL_OFFSET_MAX, CAL_OFFSET_MAX, apply_IMU_cal),
+    PARAM_ENTRY("CAL_ACC_B2", &b_acc[1], -CAL_OFFSET_MAX, CAL_OFFSET_MAX, apply_IMU_cal),
+    PARAM_ENTRY("CAL_ACC_B3", &b_acc[2], -CAL_OFFSET_MAX, CAL_OFFSET_MAX, apply_IMU_cal),
+    PARAM_ENTRY("CAL_MAG_A11", &A_mag[0][0], -CAL_SCALE_MAX, CAL_SCALE_MAX, apply_IMU_cal),
+    PARAM_ENTRY("CAL_MAG_A12", &A_mag[0][1], -CAL_SCALE_MAX, CAL_SCALE_MAX, apply_IMU_cal),
+    PARAM_ENTRY("CAL_MAG_A13", &A_mag[0][2], -CAL_SCALE_MAX, CAL_SCALE_MAX, apply_IMU_cal),
+    PARAM_ENTRY("CAL_MAG_A21", &A_mag[1][0], -CAL_SCALE_MAX, CAL_SCALE_MAX, apply_IMU_cal),
+    PARAM_ENTRY("CAL_MAG_A22", &A_mag[1][1], -CAL_SCALE_MAX, CAL_SCALE_MAX, apply_IMU_cal),
+    PARAM_ENTRY("CAL_MAG_A23", &A_mag[1][2], -CAL_SCALE_MAX, CAL_SCALE_MAX, apply_IMU_cal),
+    PARAM_ENTRY("CAL_MAG_A31", &A_mag[2][0], -CAL_SCALE_MAX, CAL_SCALE_MAX, apply_IMU_cal),
+    PARAM_ENTRY("CAL_MAG_A32", &A_mag[2][1], -CAL_SCALE_MAX, CAL_SCALE_MAX, apply_IMU_cal),
+    PARAM_ENTRY("CAL_MAG_A33", &A_mag[2][2], -CAL_SCALE_MAX, CAL_SCALE_MAX, apply_IMU_cal),
+    PARAM_ENTRY("CAL_MAG_B1", &b_mag[0], -CAL_OFFSET_MAX, CAL_OFFSET_MAX, apply_IMU_cal),
+    PARAM_ENTRY("CAL_MAG_B2", &b_mag[1], -CAL_OFFSET_MAX, CAL_OFFSET_MAX, apply_IMU_cal),
+    PARAM_ENTRY("CAL_MAG_B3", &b_mag[2], -CAL_OFFSET_MAX, CAL_OFFSET_MAX, apply_IMU_cal),
+    PARAM_ENTRY("USB_BAUD", &usb_baud, USB_BAUD_MIN, USB_BAUD_MAX, apply_USB_link),
+    PARAM_ENTRY("USB_FLOW", &usb_flow, SERIAL_FLOW_NONE, SERIAL_FLOW_RTS_CTS, apply_USB_link),
+};
+#define NUM_PARAMS (sizeof (parameters) / sizeof (parameters[0]))
+
 /*******************************************************************************
  * FUNCTIONS                                                                   *
  ******************************************************************************/
@@ -409,6 +894,12 @@ int8_t set_home(void);
  */
 void check_GPS_events(void) {
     static double X_tp[] = {0.0, 0.0, 0.0};
+    if (HIL_is_active() == TRUE) {
+        if (HIL_is_GPS_ready() == TRUE) {
+            HIL_get_GPS(&GPS_data);
+        }
+        return;
+    }
     if (GPS_is_msg_avail() == TRUE) {
         GPS_parse_stream();
     }
@@ -491,24 +982,64 @@ void GPS2LTP(float X_LTP[MSZ], double X0[MSZ], double X[MSZ], double lon, double
  * @function check_IMU_events(void)
  * @param none
  * @brief detects when IMU SPI transaction completes and then publishes data over Mavlink
+ * @note every queued sample goes to the batched IMU telemetry, the control
+ * gets the latest, in IMU_DRDY_MODE every IMU_DRDY_DECIMATION th, counted by
+ * the sample times so a burst after a long pass or a lost sample does not
+ * shift the control phase
  * @author Aaron Hunter
  */
 void check_IMU_events(void) {
-    if (IMU_is_data_ready() == TRUE) {
+    struct IMU_sample sample;
+#ifdef IMU_DRDY_MODE
+    static uint32_t sample_index = 0; // IMU samples since the start, lost ones included
+    static uint32_t control_index = 0; // sample_index the next control run is due at
+    static uint64_t last_sample_time = 0;
+#endif
+
+    /* every sample the IMU reads goes to the batched telemetry */
+    while (IMU_read_sample(&sample) == TRUE) {
+        IMU_batch_add(&sample);
+#ifdef IMU_DRDY_MODE
+        if (last_sample_time == 0) {
+            sample_index++;
+        } else {
+            sample_index += ((uint32_t) (sample.sample_time - last_sample_time) + IMU_SAMPLE_TICKS / 2)
+                    / IMU_SAMPLE_TICKS;
+        }
+        last_sample_time = sample.sample_time;
+#endif
+    }
+    if (HIL_is_active() == TRUE) {
+        if (HIL_is_IMU_ready() == FALSE) {
+            return;
+        }
+        HIL_get_IMU(&IMU_scaled); // injected sample, already normalized
+    } else if (IMU_is_data_ready() == TRUE) {
+#ifdef IMU_DRDY_MODE
+        if ((int32_t) (sample_index - control_index) < 0) {
+            return; // the control runs on every IMU_DRDY_DECIMATION th sample
+        }
+        /* a late run does not move the next off the sample grid */
+        control_index += ((sample_index - control_index) / IMU_DRDY_DECIMATION + 1) * IMU_DRDY_DECIMATION;
+#endif
         IMU_get_raw_data(&IMU_raw);
         IMU_get_norm_data(&IMU_scaled);
-
-        acc_cal[0] = (float) IMU_scaled.acc.x;
-        acc_cal[1] = (float) IMU_scaled.acc.y;
-        acc_cal[2] = (float) IMU_scaled.acc.z;
-        mag_cal[0] = (float) IMU_scaled.mag.x;
-        mag_cal[1] = (float) IMU_scaled.mag.y;
-        mag_cal[2] = (float) IMU_scaled.mag.z;
-        /*scale gyro readings into rad/sec */
-        gyro_cal[0] = (float) IMU_scaled.gyro.x * deg2rad;
-        gyro_cal[1] = (float) IMU_scaled.gyro.y * deg2rad;
-        gyro_cal[2] = (float) IMU_scaled.gyro.z * deg2rad;
+    } else {
+        return;
     }
+    acc_cal[0] = (float) IMU_scaled.acc.x;
+    acc_cal[1] = (float) IMU_scaled.acc.y;
+    acc_cal[2] = (float) IMU_scaled.acc.z;
+    mag_cal[0] = (float) IMU_scaled.mag.x;
+    mag_cal[1] = (float) IMU_scaled.mag.y;
+    mag_cal[2] = (float) IMU_scaled.mag.z;
+    /*scale gyro readings into rad/sec */
+    gyro_cal[0] = (float) IMU_scaled.gyro.x * deg2rad;
+    gyro_cal[1] = (float) IMU_scaled.gyro.y * deg2rad;
+    gyro_cal[2] = (float) IMU_scaled.gyro.z * deg2rad;
+#ifdef IMU_DRDY_MODE
+    Sched_release(TASK_CONTROL); // run the control on the fresh sample
+#endif
 }
 
 /**
@@ -524,58 +1055,137 @@ void check_RC_events() {
 }
 
 /**
- * @function check_radio_events(void)
+ * @function check_MAVLink_events(void)
  * @param none
- * @brief looks for messages sent over the radio serial port to OSAVC, parses
- * them and provides responses, if needed
- * @note currently only pushing information to usb-serial port
+ * @brief drains the messages waiting on the radio and USB ports within
+ * MAVLINK_RX_BUDGET, each goes to its handler in mav_handlers, and puts the
+ * USB link back on its old rate if a switch hears nothing in USB_LINK_TIMEOUT
  * @author Aaron Hunter
  */
-void check_radio_events(void) {
-    uint8_t channel = MAVLINK_COMM_0;
-    uint8_t msg_byte;
-    uint16_t msg_length;
-    uint8_t msg_buffer[BUFFER_SIZE];
-    mavlink_message_t msg_rx;
-    mavlink_status_t msg_rx_status;
+void check_MAVLink_events(void) {
+    const mavlink_rx_stats_t *rx = Mavlink_rx_get_stats();
+    uint32_t usb_messages = rx->messages[MAVLINK_TX_USB]; // the stats are only reset between polls
+
+    Mavlink_rx_poll(MAVLINK_RX_BUDGET);
+    if (usb_link_trial == FALSE) {
+        return;
+    }
+    if (rx->messages[MAVLINK_TX_USB] != usb_messages) {
+        usb_baud_good = usb_baud_set; // the ground station followed
+        usb_flow_good = usb_flow_set;
+        usb_link_trial = FALSE;
+    } else if (Sys_timer_get_msec() - usb_switch_time >= USB_LINK_TIMEOUT) {
+        Log_event(LOG_USB_REVERT, usb_baud_set, usb_baud_good);
+        Serial_set_baud(usb_baud_good, usb_flow_good); // it ran there before
+        usb_baud_set = usb_baud_good;
+        usb_flow_set = usb_flow_good;
+        usb_baud = usb_baud_good;
+        usb_flow = usb_flow_good;
+        usb_link_trial = FALSE;
+    }
+}
 
-    //MAVLink command structs
+/**
+ * @function handle_HIL(const mavlink_message_t *msg, uint8_t port)
+ * @param msg, message received
+ * @param port, USB or RADIO, the link it arrived on
+ * @brief injects HIL data, RAW_RPM outside of HIL mode goes to
+ * handle_unknown()
+ * @author Aaron Hunter
+ */
+void handle_HIL(const mavlink_message_t *msg, uint8_t port) {
+    if (HIL_handle_msg(msg, port) == FALSE) {
+        handle_unknown(msg, port);
+    }
+}
+
+/**
+ * @function handle_heartbeat(const mavlink_message_t *msg, uint8_t port)
+ * @param msg, message received
+ * @param port, USB or RADIO, the link it arrived on
+ * @brief logs a ground station heartbeat
+ * @author Aaron Hunter
+ */
+void handle_heartbeat(const mavlink_message_t *msg, uint8_t port) {
     mavlink_heartbeat_t heartbeat;
+
+    mavlink_msg_heartbeat_decode(msg, &heartbeat);
+    if (heartbeat.type) {
+        Log_event(LOG_GCS_HEARTBEAT, heartbeat.type);
+    }
+}
+
+/**
+ * @function handle_command_long(const mavlink_message_t *msg, uint8_t port)
+ * @param msg, message received
+ * @param port, USB or RADIO, the link it arrived on
+ * @brief stream interval commands go to the telemetry scheduler, the rest are
+ * logged
+ * @author Aaron Hunter
+ */
+void handle_command_long(const mavlink_message_t *msg, uint8_t port) {
     mavlink_command_long_t command_qgc;
-    mavlink_param_request_read_t param_read;
-
-    if (Radio_data_available()) {
-        msg_byte = Radio_get_char();
-        if (mavlink_parse_char(channel, msg_byte, &msg_rx, &msg_rx_status)) {
-            switch (msg_rx.msgid) {
-                case MAVLINK_MSG_ID_HEARTBEAT:
-                    mavlink_msg_heartbeat_decode(&msg_rx, &heartbeat);
-                    if (heartbeat.type) {
-                        msg_length = sprintf(msg_buffer, "heartbeat received type(%d)\r\n", heartbeat.type);
-                        mavprint(msg_buffer, msg_length, RADIO);
-                    }
-                    break;
-                case MAVLINK_MSG_ID_COMMAND_LONG:
-                    mavlink_msg_command_long_decode(&msg_rx, &command_qgc);
-                    msg_length = sprintf(msg_buffer, "Command ID %d received from Ground Control\r\n", command_qgc.command);
-                    mavprint(msg_buffer, msg_length, RADIO);
-                    break;
-                case MAVLINK_MSG_ID_PARAM_REQUEST_READ:
-                    mavlink_msg_param_request_read_decode(&msg_rx, &param_read);
-                    msg_length = sprintf(msg_buffer, "Parameter request ID %s received from Ground Control\r\n", param_read.param_id);
-                    mavprint(msg_buffer, msg_length, RADIO);
-                    publish_parameter(param_read.param_id, USB);
-                    break;
-                default:
-                    msg_length = sprintf(msg_buffer, "Received message with ID %d, sequence: %d from component %d of system %d\r\n",
-                            msg_rx.msgid, msg_rx.seq, msg_rx.compid, msg_rx.sysid);
-                    mavprint(msg_buffer, msg_length, RADIO);
-                    break;
-            }
-        }
+
+    if (Telemetry_handle_msg(msg, port) == TRUE) {
+        return;
+    }
+    mavlink_msg_command_long_decode(msg, &command_qgc);
+    Log_event(LOG_COMMAND, command_qgc.command);
+}
+
+/**
+ * @function handle_stream_request(const mavlink_message_t *msg, uint8_t port)
+ * @param msg, message received
+ * @param port, USB or RADIO, the link it arrived on
+ * @brief REQUEST_DATA_STREAM sets the rates of the port's streams, one for
+ * another system goes to handle_unknown()
+ * @author Aaron Hunter
+ */
+void handle_stream_request(const mavlink_message_t *msg, uint8_t port) {
+    if (Telemetry_handle_msg(msg, port) == FALSE) {
+        handle_unknown(msg, port);
+    }
+}
+
+/**
+ * @function handle_param(const mavlink_message_t *msg, uint8_t port)
+ * @param msg, message received
+ * @param port, USB or RADIO, the link it arrived on
+ * @brief parameter reads, sets and lists go to the parameter table, one for
+ * another system goes to handle_unknown()
+ * @author Aaron Hunter
+ */
+void handle_param(const mavlink_message_t *msg, uint8_t port) {
+    if (Param_handle_msg(msg, port) == FALSE) {
+        handle_unknown(msg, port);
+    }
+}
+
+/**
+ * @function handle_mission(const mavlink_message_t *msg, uint8_t port)
+ * @param msg, message received
+ * @param port, USB or RADIO, the link it arrived on
+ * @brief mission uploads, downloads, clears and jumps go to the mission
+ * store, one for another system goes to handle_unknown()
+ * @author Aaron Hunter
+ */
+void handle_mission(const mavlink_message_t *msg, uint8_t port) {
+    if (Mission_handle_msg(msg, port) == FALSE) {
+        handle_unknown(msg, port);
     }
 }
 
+/**
+ * @function handle_unknown(const mavlink_message_t *msg, uint8_t port)
+ * @param msg, message received
+ * @param port, USB or RADIO, the link it arrived on
+ * @brief logs a message without a handler
+ * @author Aaron Hunter
+ */
+void handle_unknown(const mavlink_message_t *msg, uint8_t port) {
+    Log_event(LOG_UNKNOWN_MSG, msg->msgid, msg->seq, msg->compid, msg->sysid);
+}
+
 /**
  * @function check_encoder_events(void)
  * @param none
@@ -584,55 +1194,11 @@ void check_radio_events(void) {
  * @author Aaron Hunter
  */
 void check_encoder_events(void) {
-    if (Encoder_is_data_ready()) {
+    if (HIL_is_active() == FALSE && Encoder_is_data_ready()) {
         Encoder_get_data(enc);
     }
 }
 
-void check_USB_events(void) {
-    uint8_t channel = MAVLINK_COMM_0;
-    uint8_t msg_byte;
-    uint16_t msg_length;
-    uint8_t msg_buffer[BUFFER_SIZE];
-    mavlink_message_t msg_rx;
-    mavlink_status_t msg_rx_status;
-
-    //MAVLink command structs
-    mavlink_heartbeat_t heartbeat;
-    mavlink_command_long_t command_qgc;
-    mavlink_param_request_read_t param_read;
-
-    if (msg_byte = get_char()) {
-        if (mavlink_parse_char(channel, msg_byte, &msg_rx, &msg_rx_status)) {
-            switch (msg_rx.msgid) {
-                case MAVLINK_MSG_ID_HEARTBEAT:
-                    mavlink_msg_heartbeat_decode(&msg_rx, &heartbeat);
-                    if (heartbeat.type) {
-                        msg_length = sprintf(msg_buffer, "heartbeat received type(%d)\r\n", heartbeat.type);
-                        mavprint(msg_buffer, msg_length, RADIO);
-                    }
-                    break;
-                case MAVLINK_MSG_ID_COMMAND_LONG:
-                    mavlink_msg_command_long_decode(&msg_rx, &command_qgc);
-                    msg_length = sprintf(msg_buffer, "Command ID %d received from Ground Control\r\n", command_qgc.command);
-                    mavprint(msg_buffer, msg_length, RADIO);
-                    break;
-                case MAVLINK_MSG_ID_PARAM_REQUEST_READ:
-                    mavlink_msg_param_request_read_decode(&msg_rx, &param_read);
-                    msg_length = sprintf(msg_buffer, "Parameter request ID %s received from Ground Control\r\n", param_read.param_id);
-                    mavprint(msg_buffer, msg_length, RADIO);
-                    publish_parameter(param_read.param_id, USB);
-                    break;
-                default:
-                    msg_length = sprintf(msg_buffer, "Received message with ID %d, sequence: %d from component %d of system %d\r\n",
-                            msg_rx.msgid, msg_rx.seq, msg_rx.compid, msg_rx.sysid);
-                    mavprint(msg_buffer, msg_length, RADIO);
-                    break;
-            }
-        }
-    }
-}
-
 /**
  * @function publish_GPS(void)
  * @param none
@@ -642,19 +1208,14 @@ void check_USB_events(void) {
  */
 void publish_GPS(uint8_t dest) {
     static uint8_t gps_fix = GPS_FIX_TYPE_NO_FIX;
-    mavlink_message_t msg_tx;
-    uint16_t msg_length;
-    uint8_t msg_buffer[BUFFER_SIZE];
     //verify fix status
-    if (GPS_has_fix() == TRUE) {
+    if ((HIL_is_active() == TRUE ? HIL_GPS_has_fix() : GPS_has_fix()) == TRUE) {
         gps_fix = GPS_FIX_TYPE_3D_FIX;
     } else {
         gps_fix = GPS_FIX_TYPE_NO_FIX;
     }
-    mavlink_msg_gps_raw_int_pack(mavlink_system.sysid,
-            mavlink_system.compid,
-            &msg_tx,
-            (uint64_t) Sys_timer_get_usec(),
+    mavlink_msg_gps_raw_int_send(dest,
+            Sys_timer_get_usec64(),
             gps_fix,
             (int32_t) (GPS_data.lat * 10000000.0),
             (int32_t) (GPS_data.lon * 10000000.0),
@@ -671,8 +1232,6 @@ void publish_GPS(uint8_t dest) {
             0, //heading uncertainty
             0 // yaw--GPS doesn't provide
             );
-    msg_length = mavlink_msg_to_send_buffer(msg_buffer, &msg_tx);
-    mavprint(msg_buffer, msg_length, dest);
 }
 
 /**
@@ -682,15 +1241,10 @@ void publish_GPS(uint8_t dest) {
  * @author Aaron Hunter
  */
 void publish_IMU_data(uint8_t data_type, uint8_t dest) {
-    mavlink_message_t msg_tx;
-    uint16_t msg_length;
-    uint8_t msg_buffer[BUFFER_SIZE];
     uint8_t IMU_id = 0;
     if (data_type == RAW) {
-        mavlink_msg_raw_imu_pack(mavlink_system.sysid,
-                mavlink_system.compid,
-                &msg_tx,
-                Sys_timer_get_usec(),
+        mavlink_msg_raw_imu_send(dest,
+                Sys_timer_get_usec64(),
                 (int16_t) IMU_raw.acc.x,
                 (int16_t) IMU_raw.acc.y,
                 (int16_t) IMU_raw.acc.z,
@@ -704,10 +1258,8 @@ void publish_IMU_data(uint8_t data_type, uint8_t dest) {
                 (int16_t) IMU_raw.temp
                 );
     } else if (data_type == SCALED) {
-        mavlink_msg_highres_imu_pack(mavlink_system.sysid,
-                mavlink_system.compid,
-                &msg_tx,
-                Sys_timer_get_usec(),
+        mavlink_msg_highres_imu_send(dest,
+                Sys_timer_get_usec64(),
                 (float) IMU_scaled.acc.x,
                 (float) IMU_scaled.acc.y,
                 (float) IMU_scaled.acc.z,
@@ -725,8 +1277,26 @@ void publish_IMU_data(uint8_t data_type, uint8_t dest) {
                 IMU_id
                 );
     }
-    msg_length = mavlink_msg_to_send_buffer(msg_buffer, &msg_tx);
-    mavprint(msg_buffer, msg_length, dest);
+}
+
+/**
+ * @function publish_IMU_scaled(uint8_t dest)
+ * @param dest, USB or RADIO
+ * @brief publish_IMU_data() of the SCALED data, the IMU telemetry stream
+ * @author Aaron Hunter
+ */
+void publish_IMU_scaled(uint8_t dest) {
+    publish_IMU_data(SCALED, dest);
+}
+
+/**
+ * @function publish_IMU_batch(uint8_t dest)
+ * @param dest, USB or RADIO
+ * @brief sends the oldest closed batch of raw IMU samples, the batched IMU
+ * telemetry stream
+ */
+void publish_IMU_batch(uint8_t dest) {
+    IMU_batch_send(dest);
 }
 
 /**
@@ -745,9 +1315,6 @@ void publish_IMU_data(uint8_t data_type, uint8_t dest) {
  * @author Aaron Hunter
  */
 void publish_RC_signals(void) {
-    mavlink_message_t msg_tx;
-    uint16_t msg_length;
-    uint8_t msg_buffer[BUFFER_SIZE];
     uint16_t index = 0;
     uint8_t RC_port = 0; //first 8 channels 
     int16_t scaled_channels[CHANNELS];
@@ -755,9 +1322,7 @@ void publish_RC_signals(void) {
     for (index = 0; index < CHANNELS; index++) {
         scaled_channels[index] = (RC_channels[index] - RC_RX_MID_COUNTS) * RC_raw_fs_scale;
     }
-    mavlink_msg_rc_channels_scaled_pack(mavlink_system.sysid,
-            mavlink_system.compid,
-            &msg_tx,
+    mavlink_msg_rc_channels_scaled_send(USB,
             Sys_timer_get_msec(),
             RC_port,
             scaled_channels[0],
@@ -769,26 +1334,19 @@ void publish_RC_signals(void) {
             scaled_channels[6],
             scaled_channels[7],
             rssi);
-    msg_length = mavlink_msg_to_send_buffer(msg_buffer, &msg_tx);
-    mavprint(msg_buffer, msg_length, USB);
 
 }
 
 /**
- * @function publish_RC_signals_raw(void)
- * @param none
+ * @function publish_RC_signals_raw(uint8_t dest)
+ * @param dest, USB or RADIO
  * @brief scales raw RC signals
  * @author Aaron Hunter
  */
-void publish_RC_signals_raw(void) {
-    mavlink_message_t msg_tx;
-    uint16_t msg_length;
-    uint8_t msg_buffer[BUFFER_SIZE];
+void publish_RC_signals_raw(uint8_t dest) {
     uint8_t RC_port = 0; //first 8 channels 
     uint8_t rssi = 255; //unknown--may be able to extract from receiver
-    mavlink_msg_rc_channels_raw_pack(mavlink_system.sysid,
-            mavlink_system.compid,
-            &msg_tx,
+    mavlink_msg_rc_channels_raw_send(dest,
             Sys_timer_get_msec(),
             RC_port,
             RC_channels[0],
@@ -800,62 +1358,40 @@ void publish_RC_signals_raw(void) {
             RC_channels[6],
             RC_channels[7],
             rssi);
-    msg_length = mavlink_msg_to_send_buffer(msg_buffer, &msg_tx);
-    mavprint(msg_buffer, msg_length, USB);
 }
 
 /**
- * @function publish_encoder_data(void)
+ * @function publish_encoder_data(uint8_t dest)
  * @brief publish left and right encoder data as "RPM"
  * @note: uses index 0 = LEFT_MOTOR, 1 = RIGHT_MOTOR, 2 = HEADING
  * @note for steering servo (heading) we use the absolute position in radians,
  * velocities are published as raw differences in angles (radians)
  */
-void publish_encoder_data(void) {
-    mavlink_message_t msg_tx;
-    uint16_t msg_length;
-    uint8_t msg_buffer[BUFFER_SIZE];
+void publish_encoder_data(uint8_t dest) {
     /* publish left motor raw omega*/
-    mavlink_msg_raw_rpm_pack(mavlink_system.sysid,
-            mavlink_system.compid,
-            &msg_tx,
+    mavlink_msg_raw_rpm_send(dest,
             LEFT_MOTOR,
             (float) enc[LEFT_MOTOR].omega * enc_ticks2radians
             );
-    msg_length = mavlink_msg_to_send_buffer(msg_buffer, &msg_tx);
-    mavprint(msg_buffer, msg_length, USB);
     /* publish right motor data*/
-    mavlink_msg_raw_rpm_pack(mavlink_system.sysid,
-            mavlink_system.compid,
-            &msg_tx,
+    mavlink_msg_raw_rpm_send(dest,
             RIGHT_MOTOR,
             (float) enc[RIGHT_MOTOR].omega * enc_ticks2radians
             );
-    msg_length = mavlink_msg_to_send_buffer(msg_buffer, &msg_tx);
-    mavprint(msg_buffer, msg_length, USB);
     /* publish heading angle in radians*/
-    mavlink_msg_raw_rpm_pack(mavlink_system.sysid,
-            mavlink_system.compid,
-            &msg_tx,
+    mavlink_msg_raw_rpm_send(dest,
             HEADING,
             X_new.delta
             );
-    msg_length = mavlink_msg_to_send_buffer(msg_buffer, &msg_tx);
-    mavprint(msg_buffer, msg_length, USB);
 }
 
 /**
- * @function publish_attitude(void)
+ * @function publish_attitude(uint8_t dest)
  * @brief publishes the quaternion attitude in ENU format
  */
-void publish_attitude(void) {
-    mavlink_message_t msg_tx;
-    uint16_t msg_length;
-    uint8_t msg_buffer[BUFFER_SIZE];
+void publish_attitude(uint8_t dest) {
     float repr_offset_q[QSZ] = {0, 0, 0, 0};
-    mavlink_msg_attitude_quaternion_pack(mavlink_system.sysid,
-            mavlink_system.compid,
-            &msg_tx,
+    mavlink_msg_attitude_quaternion_send(dest,
             Sys_timer_get_msec(),
             q[0],
             q[1],
@@ -866,21 +1402,14 @@ void publish_attitude(void) {
             gyro_cal[2],
             repr_offset_q
             );
-    msg_length = mavlink_msg_to_send_buffer(msg_buffer, &msg_tx);
-    mavprint(msg_buffer, msg_length, USB);
 }
 
 /**
- * @function publish_position(void)
+ * @function publish_position(uint8_t dest)
  * @brief publishes the rover state variables in local coordinates
  */
-void publish_position(void) {
-    mavlink_message_t msg_tx;
-    uint16_t msg_length;
-    uint8_t msg_buffer[BUFFER_SIZE];
-    mavlink_msg_local_position_ned_pack(mavlink_system.sysid,
-            mavlink_system.compid,
-            &msg_tx,
+void publish_position(uint8_t dest) {
+    mavlink_msg_local_position_ned_send(dest,
             Sys_timer_get_msec(),
             X_new.x,
             X_new.y,
@@ -888,84 +1417,268 @@ void publish_position(void) {
             X_new.vx,
             X_new.vy,
             0);
-    msg_length = mavlink_msg_to_send_buffer(msg_buffer, &msg_tx);
-    mavprint(msg_buffer, msg_length, USB);
+}
+
+/**
+ * @function publish_vehicle_state(uint8_t dest)
+ * @param dest, USB or RADIO
+ * @brief publishes the snapshot of the last control run as one TUNNEL
+ * message, see vehicle_state_t
+ */
+void publish_vehicle_state(uint8_t dest) {
+    uint8_t payload[MAVLINK_MSG_TUNNEL_FIELD_PAYLOAD_LEN] = {0};
+
+    memcpy(payload, &vehicle_state, VEHICLE_STATE_LENGTH);
+    mavlink_msg_tunnel_send(dest,
+            0, // broadcast
+            0,
+            VEHICLE_STATE_PAYLOAD,
+            VEHICLE_STATE_LENGTH,
+            payload);
+}
+
+/**
+ * @function publish_profile(uint8_t dest)
+ * @param dest, USB or RADIO
+ * @brief publishes the next part of the report profile_task() started:
+ * min/mean/max execution time of each profiler section and the tick jitter
+ * as DEBUG_VECT in usec with their histograms as DEBUG_FLOAT_ARRAY, the
+ * scheduler overrun and miss counts, in HIL mode also the injection rates
+ * and latency, the MAVLink frames sent and dropped, the UART drops by class,
+ * the receive counts and pass time, the event log counts and the batched IMU
+ * rate and losses, each counter starting a new window once sent; a stream,
+ * so the report is paced with the rest, and a part waits for room in the
+ * port rather than being dropped
+ */
+void publish_profile(uint8_t dest) {
+    float hist[MAVLINK_MSG_DEBUG_FLOAT_ARRAY_FIELD_DATA_LEN] = {0};
+    const prof_stats_t *stats = NULL;
+    const sched_task_t *task;
+    const hil_stats_t *hil;
+    const mavlink_tx_stats_t *tx;
+    const mavlink_rx_stats_t *rx;
+    const log_stats_t *log;
+    const imu_batch_stats_t *batch;
+    uint8_t id;
+    uint8_t i;
+
+    /* sections without samples have nothing to report */
+    while (profile_part < PROFILE_TASKS) {
+        id = profile_part - PROFILE_SECTIONS;
+        stats = id < PROF_MAX_SECTIONS ? Prof_get(id) : Prof_get_jitter();
+        if (stats != NULL && stats->count > 0) {
+            break;
+        }
+        if (++profile_part == PROFILE_TASKS) {
+            Prof_reset();
+        }
+    }
+    if (profile_part == PROFILE_HIL && HIL_is_active() == FALSE) {
+        profile_part++;
+    }
+    if (profile_part >= PROFILE_DONE) {
+        return;
+    }
+    /* the largest part is three DEBUG_VECT or one of each kind */
+    if (Mavlink_tx_space(dest) < DEBUG_VECT_FRAME + DEBUG_ARRAY_FRAME) {
+        return;
+    }
+    if (profile_part < PROFILE_TASKS) {
+        /* the sections then the jitter with array_id PROF_MAX_SECTIONS */
+        id = profile_part - PROFILE_SECTIONS;
+        mavlink_msg_debug_vect_send(dest,
+                stats->name,
+                Sys_timer_get_usec64(),
+                Prof_usec(stats->min),
+                Prof_usec(Prof_mean(stats)),
+                Prof_usec(stats->max));
+        for (i = 0; i < PROF_HIST_BINS; i++) {
+            hist[i] = (float) stats->hist[i];
+        }
+        /* overruns ride along after the jitter histogram */
+        hist[PROF_HIST_BINS] = id < PROF_MAX_SECTIONS ? 0 : (float) Prof_get_overruns();
+        mavlink_msg_debug_float_array_send(dest,
+                Sys_timer_get_usec64(),
+                stats->name,
+                id,
+                hist);
+        if (profile_part == PROFILE_TASKS - 1) {
+            Prof_reset();
+        }
+    } else if (profile_part < PROFILE_HIL) {
+        /* scheduler accounting, overruns, missed releases and the longest
+         * release to start latency in usec for each task */
+        task = Sched_get_task(profile_part - PROFILE_TASKS);
+        mavlink_msg_debug_vect_send(dest,
+                task->name,
+                Sys_timer_get_usec64(),
+                (float) task->overruns,
+                (float) task->missed,
+                (float) task->max_latency);
+        if (profile_part == PROFILE_HIL - 1) {
+            Sched_reset_stats();
+        }
+    } else if (profile_part == PROFILE_HIL) {
+        /* HIL frame rates in Hz, dropped frames and sensor to actuator
+         * latency in usec */
+        hil = HIL_get_stats();
+        mavlink_msg_debug_vect_send(dest,
+                "hil_rx",
+                Sys_timer_get_usec64(),
+                hil->sensor_frames * 1000.0 / PROFILE_PERIOD,
+                hil->gps_frames * 1000.0 / PROFILE_PERIOD,
+                hil->actuator_frames * 1000.0 / PROFILE_PERIOD);
+        mavlink_msg_debug_vect_send(dest,
+                "hil_drop",
+                Sys_timer_get_usec64(),
+                (float) hil->sensor_skipped,
+                (float) hil->stale_outputs,
+                (float) hil->rpm_frames);
+        mavlink_msg_debug_vect_send(dest,
+                "hil_lat",
+                Sys_timer_get_usec64(),
+                (float) hil->latency_min,
+                hil->latency_count ? (float) hil->latency_sum / hil->latency_count : 0.0,
+                (float) hil->latency_max);
+        HIL_reset_stats();
+    } else if (profile_part == PROFILE_LINKS) {
+        /* MAVLink frames sent and dropped for a full block per port since
+         * the last report */
+        tx = Mavlink_tx_get_stats();
+        mavlink_msg_debug_vect_send(dest,
+                "mav_tx",
+                Sys_timer_get_usec64(),
+                (float) (tx->frames[MAVLINK_TX_USB] - profile_tx.frames[MAVLINK_TX_USB]),
+                (float) (tx->frames[MAVLINK_TX_RADIO] - profile_tx.frames[MAVLINK_TX_RADIO]),
+                (float) (tx->dropped[MAVLINK_TX_USB] + tx->dropped[MAVLINK_TX_RADIO]
+                - profile_tx.dropped[MAVLINK_TX_USB] - profile_tx.dropped[MAVLINK_TX_RADIO]));
+        profile_tx = *tx; // with this frame, counted by the next report
+        /* frames the UART blocks refused since boot, bulk per port, then the
+         * urgent ones of both ports, which only a full headroom refuses */
+        mavlink_msg_debug_vect_send(dest,
+                "tx_drop",
+                Sys_timer_get_usec64(),
+                (float) Serial_tx_dropped(SERIAL_TX_BULK),
+                (float) Radio_tx_dropped(RADIO_TX_BULK),
+                (float) (Serial_tx_dropped(SERIAL_TX_URGENT) + Radio_tx_dropped(RADIO_TX_URGENT)));
+        /* USB rate in use, bytes received with framing errors or overruns and
+         * bytes lost to a full receive buffer since boot */
+        mavlink_msg_debug_vect_send(dest,
+                "usb_link",
+                Sys_timer_get_usec64(),
+                (float) Serial_get_baud(),
+                (float) Serial_rx_errors(),
+                (float) Serial_rx_dropped());
+    } else if (profile_part == PROFILE_RX) {
+        /* MAVLink messages received and bad frames, the longest receive pass
+         * in usec and the passes that ran out of budget */
+        rx = Mavlink_rx_get_stats();
+        mavlink_msg_debug_vect_send(dest,
+                "mav_rx",
+                Sys_timer_get_usec64(),
+                (float) rx->messages[MAVLINK_TX_USB],
+                (float) rx->messages[MAVLINK_TX_RADIO],
+                (float) (rx->errors[MAVLINK_TX_USB] + rx->errors[MAVLINK_TX_RADIO]));
+        mavlink_msg_debug_vect_send(dest,
+                "mav_rx_t",
+                Sys_timer_get_usec64(),
+                (float) rx->max_pass,
+                (float) rx->budget_hits,
+                0.0);
+        Mavlink_rx_reset_stats();
+    } else {
+        /* event log records and LOGGING_DATA messages sent, unknown ids */
+        log = Log_get_stats();
+        mavlink_msg_debug_vect_send(dest,
+                "log",
+                Sys_timer_get_usec64(),
+                (float) log->records,
+                (float) log->messages,
+                (float) log->errors);
+        Log_reset_stats();
+        /* batched IMU samples per second, batches closed early by a missing
+         * sample, driver queue overruns among them, and batches dropped for a
+         * slow link */
+        batch = IMU_batch_get_stats();
+        mavlink_msg_debug_vect_send(dest,
+                "imu_batch",
+                Sys_timer_get_usec64(),
+                batch->samples * 1000.0 / PROFILE_PERIOD,
+                (float) batch->gaps,
+                (float) batch->dropped);
+        IMU_batch_reset_stats();
+    }
+    profile_part++;
+}
+
+/**
+ * @function publish_telemetry(uint8_t dest)
+ * @param dest, USB or RADIO
+ * @brief publishes the telemetry bytes/sec and waits of each port as
+ * DEBUG_VECT and the achieved rate in Hz of each stream as DEBUG_FLOAT_ARRAY
+ * with array_id the port, then starts a new window; a stream itself, so the
+ * report is paced with the rest and never dropped
+ */
+void publish_telemetry(uint8_t dest) {
+    float rates[MAVLINK_MSG_DEBUG_FLOAT_ARRAY_FIELD_DATA_LEN];
+    const telemetry_stats_t *tlm = Telemetry_get_stats();
+    uint8_t port;
+    uint8_t i;
+
+    mavlink_msg_debug_vect_send(dest,
+            "tlm_link",
+            Sys_timer_get_usec64(),
+            tlm->bytes[MAVLINK_TX_USB] * 1.0e6 / tlm->window,
+            tlm->bytes[MAVLINK_TX_RADIO] * 1.0e6 / tlm->window,
+            (float) (tlm->waited[MAVLINK_TX_USB] + tlm->waited[MAVLINK_TX_RADIO]));
+    for (port = 0; port < MAVLINK_TX_PORTS; port++) {
+        memset(rates, 0, sizeof (rates));
+        for (i = 0; i < NUM_STREAMS; i++) {
+            rates[i] = tlm->sent[port][i] * 1.0e6 / tlm->window;
+        }
+        mavlink_msg_debug_float_array_send(dest,
+                Sys_timer_get_usec64(),
+                "tlm_hz",
+                port,
+                rates);
+    }
+    Telemetry_reset_stats();
+}
+
+/**
+ * @function publish_HIL_actuators(void)
+ * @return none
+ * @brief returns the outputs to the simulator on the link it uses
+ * @author Aaron Hunter
+ */
+void publish_HIL_actuators(void) {
+    uint8_t mode = MAV_MODE_FLAG_MANUAL_INPUT_ENABLED | MAV_MODE_FLAG_SAFETY_ARMED;
+
+    if (mission_mode == AUTO) {
+        mode |= MAV_MODE_FLAG_AUTO_ENABLED;
+    }
+    HIL_send_actuators(mode);
 }
 
 /**
  * @Function publish_heartbeat(mav_output_type dest)
- * @param dest, either USB or RADIO
+ * @param dest, USB, RADIO or USB_RADIO for both
  * @brief publishes heartbeat message 
  * @return none
  * @author Aaron Hunter
  */
 void publish_heartbeat(uint8_t dest) {
-    mavlink_message_t msg_tx;
-    uint16_t msg_length;
-    uint8_t msg_buffer[BUFFER_SIZE];
     uint8_t mode = MAV_MODE_FLAG_MANUAL_INPUT_ENABLED | MAV_MODE_FLAG_SAFETY_ARMED;
     uint32_t custom = 0;
     uint8_t state = MAV_STATE_STANDBY;
-    mavlink_msg_heartbeat_pack(mavlink_system.sysid
-            , mavlink_system.compid,
-            &msg_tx,
+    if (HIL_is_active() == TRUE) {
+        mode |= MAV_MODE_FLAG_HIL_ENABLED;
+    }
+    mavlink_msg_heartbeat_send(dest,
             MAV_TYPE_GROUND_ROVER, MAV_AUTOPILOT_GENERIC,
             mode,
             custom,
             state);
-    msg_length = mavlink_msg_to_send_buffer(msg_buffer, &msg_tx);
-    mavprint(msg_buffer, msg_length, dest);
-}
-
-/**
- * @Function publish_parameter(uint8_t param_id[16])
- * @param parameter ID
- * @brief invokes mavlink helper to send out stored parameter 
- * @author aaron hunter
- */
-void publish_parameter(uint8_t param_id[16], uint8_t dest) {
-    mavlink_message_t msg_tx;
-    uint16_t msg_length;
-    uint8_t msg_buffer[BUFFER_SIZE];
-    uint16_t index = 0;
-    float param_value = 320.0; // value of the requested parameter
-    uint8_t param_type = MAV_PARAM_TYPE_INT16; // onboard mavlink parameter type
-    uint16_t param_count = 1; // total number of onboard parameters
-    uint16_t param_index = 1; //index of this value
-    mavlink_msg_param_value_pack(mavlink_system.sysid,
-            mavlink_system.compid,
-            &msg_tx,
-            param_id,
-            param_value,
-            param_type,
-            param_count,
-            param_index
-            );
-    msg_length = mavlink_msg_to_send_buffer(msg_buffer, &msg_tx);
-    mavprint(msg_buffer, msg_length, USB);
-}
-
-/**
- * @Function mavprint(char msg_buffer[], int8_t msg_length, int8_t output);
- * @param msg_buffer, string of bytes to send to receiver
- * @param msg_length, length of msg_buffer
- * @param output, either USB or RADIO, which peripheral to send the message from
- * @return SUCCESS or ERROR
- */
-int8_t mavprint(uint8_t msg_buffer[], uint8_t msg_length, uint8_t output) {
-    uint8_t i;
-    if (output == USB) {
-        for (i = 0; i < msg_length; i++) {
-            putchar(msg_buffer[i]);
-        }
-    } else if (output == RADIO) {
-        for (i = 0; i < msg_length; i++) {
-            Radio_put_char(msg_buffer[i]);
-        }
-    } else {
-        return ERROR;
-    }
-    return SUCCESS;
 }
 
 /**
@@ -996,9 +1709,6 @@ static int calc_pw(int raw_counts) {
  */
 uint8_t check_mission_status(void) {
     int mode = MANUAL;
-    char message[BUFFER_SIZE];
-    uint8_t msg_len = 0;
-    int index;
     int hash;
     int hash_check;
     const int tol = 10;
@@ -1025,10 +1735,7 @@ uint8_t check_mission_status(void) {
     } else {
         mode = BADRCVAL;
         INTOL = FALSE;
-        msg_len = sprintf(message, "%d, %d, %d, %d, %d, %d, %d \r\n", RC_channels[THR], RC_channels[AIL], RC_channels[ELE], RC_channels[RUD], hash, hash_check, INTOL);
-        for (index = 0; index < msg_len; index++) {
-            Radio_put_char(message[index]);
-        }
+        Log_event(LOG_BAD_RC, RC_channels[THR], RC_channels[AIL], RC_channels[ELE], RC_channels[RUD], hash, hash_check);
     }
     return mode;
 }
@@ -1052,9 +1759,9 @@ void set_control_output(uint8_t mode) {
     float heading_vec_b[MSZ] = {0.0, 0.0, 0.0}; // vector to waypoint in body frame
     float heading_meas;
     static float heading_ref = 0.0;
-    static waypt_index = 0;
+    float waypt[MSZ] = {0.0, 0.0, 0.0};
+    uint8_t waypt_ready = FALSE;
     static int8_t mission_active = TRUE;
-    uint8_t tol = 1.0; // meters
 
     switch (mode) {
         case MANUAL:
@@ -1063,9 +1770,9 @@ void set_control_output(uint8_t mode) {
             mission_active = TRUE;
             PID_init(&v_PID); // reset PID controller if we switch into manual mode
             /* send commands to motor outputs*/
-            RC_servo_set_pulse(calc_pw(RC_channels[ELE]), MOTOR_LEFT);
-            RC_servo_set_pulse(calc_pw(RC_channels[ELE]), MOTOR_RIGHT);
-            RC_servo_set_pulse(calc_pw(RC_channels[RUD]), STEERING_SERVO);
+            set_output(calc_pw(RC_channels[ELE]), MOTOR_LEFT);
+            set_output(calc_pw(RC_channels[ELE]), MOTOR_RIGHT);
+            set_output(calc_pw(RC_channels[RUD]), STEERING_SERVO);
             error_limit = 0; // reset error counter
             break;
         }
@@ -1074,10 +1781,10 @@ void set_control_output(uint8_t mode) {
             /* set velocity */
             PID_update(&v_PID, v_ref, X_new.v);
             v_cmd = (uint16_t) (v_PID.u) + RC_SERVO_CENTER_PULSE;
-            RC_servo_set_pulse(v_cmd, MOTOR_LEFT);
-            RC_servo_set_pulse(v_cmd, MOTOR_RIGHT);
+            set_output(v_cmd, MOTOR_LEFT);
+            set_output(v_cmd, MOTOR_RIGHT);
             /* manual steering*/
-            RC_servo_set_pulse(calc_pw(RC_channels[RUD]), STEERING_SERVO);
+            set_output(calc_pw(RC_channels[RUD]), STEERING_SERVO);
             error_limit = 0; // reset error counter
             break;
         }
@@ -1089,38 +1796,42 @@ void set_control_output(uint8_t mode) {
             position[2] = 0.0;
 
             /* compute vector to waypoint */
-            lin_alg_v_v_sub(&waypt[waypt_index][0], position, heading_vec_i);
-            if (lin_alg_v_norm(heading_vec_i) < tol) {
-                /*waypoint reached*/
-                if (waypt_index < NUM_WAYPTS - 1) {
-                    waypt_index++; // go to next waypoint 
-                    lin_alg_v_v_sub(&waypt[waypt_index][0], position, heading_vec_i); //recompute heading
-                } else {
-                    mission_active = FALSE; // no more waypoints, the mission is complete
+            waypt_ready = get_waypoint(waypt);
+            if (waypt_ready == TRUE) {
+                lin_alg_v_v_sub(waypt, position, heading_vec_i);
+                if (lin_alg_v_norm(heading_vec_i) < WAYPT_TOLERANCE) {
+                    /*waypoint reached*/
+                    if (Mission_next() == ERROR) {
+                        mission_active = FALSE; // no more waypoints, the mission is complete
+                    } else {
+                        waypt_ready = get_waypoint(waypt); // go to next waypoint
+                        lin_alg_v_v_sub(waypt, position, heading_vec_i); //recompute heading
+                    }
                 }
             }
-            if (mission_active) {
+            /* an item still on its way from the EEPROM stops the car for a tick */
+            if (mission_active && waypt_ready) {
                 /*set velocity */
                 PID_update(&v_PID, v_ref, X_new.v);
                 v_cmd = (uint16_t) (v_PID.u) + RC_SERVO_CENTER_PULSE;
-                RC_servo_set_pulse(v_cmd, MOTOR_LEFT);
-                RC_servo_set_pulse(v_cmd, MOTOR_RIGHT);
+                set_output(v_cmd, MOTOR_LEFT);
+                set_output(v_cmd, MOTOR_RIGHT);
 
                 /* rotate vector into body frame */
-                q_rot_v_q(heading_vec_i, q, heading_vec_b);
+                lin_alg_rot_i2b(&att_rot, heading_vec_i, heading_vec_b);
                 /* compute angle to waypoint */
-                heading_meas = atan2f(heading_vec_b[1], heading_vec_b[0]);
+                heading_meas = fast_atan2f(heading_vec_b[1], heading_vec_b[0]);
                 heading_meas = heading_meas * rad2deg; // convert to degrees
                 /* compute control action */
                 PID_update(&heading_PID, heading_ref, heading_meas);
                 heading_cmd = (int16_t) (heading_PID.u) + RC_SERVO_CENTER_PULSE;
                 /* apply control action */
-                RC_servo_set_pulse(heading_cmd, STEERING_SERVO);
+                set_output(heading_cmd, STEERING_SERVO);
             } else {
                 /*stop the car!*/
-                RC_servo_set_pulse(calc_pw(RC_RX_MID_COUNTS + motor_trim), MOTOR_LEFT);
-                RC_servo_set_pulse(calc_pw(RC_RX_MID_COUNTS + motor_trim), MOTOR_RIGHT);
-                RC_servo_set_pulse(calc_pw(RC_RX_MID_COUNTS), STEERING_SERVO);
+                set_output(calc_pw(RC_RX_MID_COUNTS + motor_trim), MOTOR_LEFT);
+                set_output(calc_pw(RC_RX_MID_COUNTS + motor_trim), MOTOR_RIGHT);
+                set_output(calc_pw(RC_RX_MID_COUNTS), STEERING_SERVO);
             }
             error_limit = 0; // reset error counter
             break;
@@ -1129,9 +1840,9 @@ void set_control_output(uint8_t mode) {
             error_count++;
             if (error_count > error_limit) {
                 /*stop the car!*/
-                RC_servo_set_pulse(calc_pw(RC_RX_MID_COUNTS + motor_trim), MOTOR_LEFT);
-                RC_servo_set_pulse(calc_pw(RC_RX_MID_COUNTS + motor_trim), MOTOR_RIGHT);
-                RC_servo_set_pulse(calc_pw(RC_RX_MID_COUNTS), STEERING_SERVO);
+                set_output(calc_pw(RC_RX_MID_COUNTS + motor_trim), MOTOR_LEFT);
+                set_output(calc_pw(RC_RX_MID_COUNTS + motor_trim), MOTOR_RIGHT);
+                set_output(calc_pw(RC_RX_MID_COUNTS), STEERING_SERVO);
             }
             break;
         default:
@@ -1140,58 +1851,45 @@ void set_control_output(uint8_t mode) {
 }
 
 /**
- * @function quat2euler()
- * @param q A quaternion
- * @param euler a vector of euler angles in [psi, theta, roll] order
+ * @function set_output(uint16_t pulse, uint8_t output)
+ * @param pulse, servo pulse in usec
+ * @param output, MOTOR_LEFT, MOTOR_RIGHT or STEERING_SERVO
+ * @return none
+ * @brief sets the servo output, in HIL mode the pulse is returned to the
+ * simulator instead
+ * @author Aaron Hunter
  */
-void Rover_quat2euler(float q[MSZ], float euler[MSZ]) {
-
-    float q00 = q[0] * q[0];
-    float q11 = q[1] * q[1];
-    float q22 = q[2] * q[2];
-    float q33 = q[3] * q[3];
-
-    // psi
-    euler[0] = atan2(2.0 * (q[1] * q[2] + q[0] * q[3]), ((q00 + q11 - q22 - q33)));
-    // theta
-    euler[1] = asin(2.0 * (q[0] * q[2] - q[1] * q[3]));
-    // phi
-    euler[2] = atan2(2.0 * (q[2] * q[3] + q[0] * q[1]), q00 - q11 - q22 + q33);
+void set_output(uint16_t pulse, uint8_t output) {
+    if (HIL_is_active() == TRUE) {
+        HIL_set_output(output, pulse);
+        return;
+    }
+    RC_servo_set_pulse(pulse, output);
 }
 
 /**
- * @function q_rot_v_q()
- * Rotate a vector from the inertial frame to the body frame
- * @param v_i, a 3space vector in the inertial frame
- * @param q an attitude quaternion
- * sets v_b to the rotated inertial vector in the body frame
- */
-void q_rot_v_q(float v_i[MSZ], float q[QSZ], float v_b[MSZ]) {
-
-    float q_i[QSZ];
-    float q_temp[QSZ];
-    float q_conj[QSZ];
-    float q_b[QSZ]; // container for inertial vector in body frame as pure quaternion
-
-    // calculate conjugate of q 
-    q_conj[0] = q[0];
-    q_conj[1] = -q[1];
-    q_conj[2] = -q[2];
-    q_conj[3] = -q[3];
-
-    //   convert v_i to a pure quaternion --> q_i
-    q_i[0] = 0;
-    q_i[1] = v_i[0];
-    q_i[2] = v_i[1];
-    q_i[3] = v_i[2];
-    //   first quaternion product q_i by q --> q_temp
-    lin_alg_q_mult(q_i, q, q_temp);
-    //   second quaternion product q_conj by q_temp -->q_b
-    lin_alg_q_mult(q_conj, q_temp, q_b);
-    //    set v_b to imaginary part of q_b
-    v_b[0] = q_b[1];
-    v_b[1] = q_b[2];
-    v_b[2] = q_b[3];
+ * @function HIL_set_encoders(void)
+ * @return none
+ * @brief fills the encoder structs from the injected wheel rates (RAW_RPM
+ * index 0 and 1, rad/sec) and steering angle (index 2, rad) as if the
+ * encoders were read now
+ * @author Aaron Hunter
+ */
+void HIL_set_encoders(void) {
+    static float rates[HIL_NUM_RPM] = {0.0, 0.0, 0.0};
+    uint64_t now = Sys_timer_get_ticks();
+    float interval;
+    uint8_t i;
+
+    HIL_get_rpm(rates); // keeps the last rates until new ones arrive
+    interval = measured_dt(enc[LEFT_MOTOR].next_time, now);
+    for (i = LEFT_MOTOR; i <= RIGHT_MOTOR; i++) {
+        enc[i].last_time = enc[i].next_time;
+        enc[i].next_time = now;
+        enc[i].omega = (int16_t) (rates[i] * interval / enc_ticks2radians);
+    }
+    /* the servo encoder turns opposite to the steering angle */
+    enc[HEADING].next_theta = heading_0 - (int16_t) (rates[HEADING] / (enc_ticks2radians * delta_scale));
 }
 
 /**
@@ -1209,13 +1907,15 @@ void update_odometry(void) {
     float Psi_new;
     float dx; // change in x position of rover
     float dy; // change in y position of rover
+    float chord; // straight line distance along the arc
+    float Psi_mid; // heading halfway along the arc
     float d_omega; // wheel rotation amount
     float v; // speed
     float delta; // steering angle
-    float delta_scale = 0.6958; // theoretical linear fit
     const int16_t max_delta = 2730; // ~ 60 degree turn angle max in counts
     const int16_t TWO_PI_INT = 16383; // 2^14 -1
     int16_t delta_int;
+    float enc_dt; // time between the two angles of each omega [s]
 
     /* encoder is oriented in opposite orientation so we subtract the angle from
      the zero value instead of the other way around*/
@@ -1228,13 +1928,14 @@ void update_odometry(void) {
     delta = (float) (delta_int) * enc_ticks2radians * delta_scale;
     if (delta == 0.0) delta = 1e-17; // prevent divide by zero
     /* compute heading change dPsi in inertial frame */
-    R = l / sin(delta);
+    R = l / fast_sinf(delta);
     /* average the speed from the encoders */
     d_omega = (float) ((enc[LEFT_MOTOR].omega + enc[RIGHT_MOTOR].omega) >> 1) * enc_ticks2radians;
-    /* compute raw velocity */
-    v = d_omega * r_w * dt_inv; // vehicle speed [m/s]]
+    /* compute raw velocity over the measured interval between encoder reads */
+    enc_dt = measured_dt(enc[LEFT_MOTOR].last_time, enc[LEFT_MOTOR].next_time);
+    v = d_omega * r_w / enc_dt; // vehicle speed [m/s]]
     v = low_pass(v); // low pass the raw velocity to smooth out encoder variations
-    dPsi = v * dt / R; // heading change due to steering command delta
+    dPsi = v * enc_dt / R; // heading change due to steering command delta
     Psi_new = X_old.psi + dPsi;
     /* limit Psi to +/- PI*/
     if (Psi_new > M_PI) {
@@ -1244,15 +1945,18 @@ void update_odometry(void) {
 
         Psi_new = Psi_new + TWO_PI;
     }
-    /* compute change in position */
-    dx = -R * sin(X_old.psi) + R * sin(Psi_new);
-    dy = R * cos(X_old.psi) - R * cos(Psi_new);
+    /* compute change in position, R(sin(Psi_new) - sin(psi)) written as the
+     chord along the arc so it does not cancel when R is huge going straight */
+    chord = 2.0f * R * fast_sinf(0.5f * dPsi);
+    Psi_mid = X_old.psi + 0.5f * dPsi;
+    dx = chord * fast_cosf(Psi_mid);
+    dy = chord * fast_sinf(Psi_mid);
     /* update state (X_new)*/
     X_new.x = X_old.x + dx;
     X_new.y = X_old.y + dy;
     X_new.psi = euler[0]; //use AHRS heading rather than odometry
-    X_new.vx = dx*dt_inv;
-    X_new.vy = dy*dt_inv;
+    X_new.vx = dx / enc_dt;
+    X_new.vy = dy / enc_dt;
     X_new.v = v;
     X_new.delta = delta;
     /* save previous state (X_old variable) */
@@ -1281,6 +1985,81 @@ float low_pass(float x) {
     return (y_new);
 }
 
+/**
+ * @function measured_dt(uint64_t last, uint64_t next)
+ * @param last, capture time of the previous sample
+ * @param next, capture time of the current sample
+ * @return interval between the samples in seconds, DT if it is not valid, e.g.
+ * the first sample or the same sample twice, or longer than DT_MAX
+ */
+float measured_dt(uint64_t last, uint64_t next) {
+    float interval;
+
+    if (last == 0 || next <= last) {
+        return dt;
+    }
+    interval = Sys_timer_dt(last, next);
+    if (interval > DT_MAX) {
+        return dt;
+    }
+    return interval;
+}
+
+/**
+ * @function snapshot_state(float AHRS_dt, uint32_t start)
+ * @param AHRS_dt, interval the AHRS integrated over, seconds
+ * @param start, core timer count at the start of the control run
+ * @brief copies the state of this control run into vehicle_state
+ */
+void snapshot_state(float AHRS_dt, uint32_t start) {
+    uint8_t i;
+
+    vehicle_state.usec = Sys_timer_ticks_to_usec(AHRS_sample_time);
+    for (i = 0; i < QSZ; i++) {
+        vehicle_state.q[i] = q[i];
+    }
+    for (i = 0; i < MSZ; i++) {
+        vehicle_state.gyro_bias[i] = gyro_bias[i];
+    }
+    vehicle_state.X = X_new;
+    vehicle_state.omega[0] = (float) enc[LEFT_MOTOR].omega * enc_ticks2radians;
+    vehicle_state.omega[1] = (float) enc[RIGHT_MOTOR].omega * enc_ticks2radians;
+    vehicle_state.u_v = v_PID.u;
+    vehicle_state.u_heading = heading_PID.u;
+    vehicle_state.runs++;
+    vehicle_state.dt = (uint16_t) (AHRS_dt * 1e6);
+    vehicle_state.exec = (uint16_t) ((Sys_timer_get_core() - start) / SYS_TIMER_CORE_PER_USEC);
+    vehicle_state.mode = mission_mode;
+    vehicle_state.flags = (is_home_set == TRUE ? VEHICLE_STATE_HOME_SET : 0)
+            | (HIL_is_active() == TRUE ? VEHICLE_STATE_HIL : 0);
+}
+
+/**
+ * @Function get_waypoint(float waypt[MSZ])
+ * @param waypt, the current waypoint in meters, odometry frame
+ * @return TRUE, or FALSE if the current item is not read from the EEPROM yet
+ * or the mission has no waypoint left
+ * @brief skips the mission items that are not waypoints
+ * @author Aaron Hunter
+ */
+uint8_t get_waypoint(float waypt[MSZ]) {
+    const mission_item_t *item = Mission_get_item(Mission_get_current());
+
+    while (item != NULL && item->command != MAV_CMD_NAV_WAYPOINT) {
+        if (Mission_next() == ERROR) {
+            return FALSE;
+        }
+        item = Mission_get_item(Mission_get_current());
+    }
+    if (item == NULL) {
+        return FALSE;
+    }
+    waypt[0] = item->x * MISSION_LOCAL_SCALE;
+    waypt[1] = item->y * MISSION_LOCAL_SCALE;
+    waypt[2] = 0.0;
+    return TRUE;
+}
+
 /**
  * @function int8_t set_home();
  * @brief:  If GPS data is valid, set home position to current location
@@ -1296,35 +2075,224 @@ int8_t set_home(void) {
     return FALSE;
 }
 
+/**
+ * @function control_task(void)
+ * @brief AHRS, odometry and guidance every CONTROL_PERIOD, then starts the
+ * next encoder and IMU acquisition, in IMU_DRDY_MODE on every
+ * IMU_DRDY_DECIMATION th IMU sample
+ * and the IMU starts its own acquisition, in HIL mode on the injected sensors
+ * and the outputs go back to the simulator
+ */
+void control_task(void) {
+    uint32_t start = Sys_timer_get_core();
+    float AHRS_dt;
+
+    PROF_TICK();
+    PROF_BEGIN(PROF_AHRS);
+#ifdef IMU_DRDY_MODE
+    /* no new sample since the last run means the scheduler timer released the
+     * control task because the data ready stopped, count it as an IMU error */
+    IMU_state = IMU_scaled.sample_time != AHRS_sample_time ? SUCCESS : ERROR;
+#endif
+    /* integrate over the time between the captures of the IMU samples, not the
+     * nominal period, so late or early reads do not bias the attitude */
+    AHRS_dt = measured_dt(AHRS_sample_time, IMU_scaled.sample_time);
+    AHRS_sample_time = IMU_scaled.sample_time;
+    AHRS_update(acc_cal, mag_cal, gyro_cal, AHRS_dt, q, gyro_bias);
+    lin_alg_rot_set_q(&att_rot, q);
+    lin_alg_rot_euler(&att_rot, euler);
+    PROF_END(PROF_AHRS);
+    PROF_BEGIN(PROF_ODOMETRY);
+    if (HIL_is_active() == TRUE) {
+        HIL_set_encoders();
+    }
+    update_odometry();
+    PROF_END(PROF_ODOMETRY);
+    PROF_BEGIN(PROF_GUIDANCE);
+    mission_mode = check_mission_status();
+    set_control_output(mission_mode); // set actuator outputs
+    PROF_END(PROF_GUIDANCE);
+    snapshot_state(AHRS_dt, start);
+    if (HIL_is_active() == TRUE) {
+        if (HIL_outputs_parked == FALSE) {
+            /* the simulator has the outputs now, stop the real car */
+            RC_servo_set_pulse(RC_SERVO_CENTER_PULSE, MOTOR_LEFT);
+            RC_servo_set_pulse(RC_SERVO_CENTER_PULSE, MOTOR_RIGHT);
+            RC_servo_set_pulse(RC_SERVO_CENTER_PULSE, STEERING_SERVO);
+            HIL_outputs_parked = TRUE;
+        }
+        publish_HIL_actuators();
+        return; // the sensors are injected, no acquisition to start
+    }
+    /*start next data acquisition round*/
+    Encoder_start_data_acq(); // start encoder acquisition
+#ifndef IMU_DRDY_MODE
+    IMU_state = IMU_start_data_acq(); //initiate IMU measurement with SPI
+#endif
+    if (IMU_state == ERROR) { //last transaction didn't complete
+        IMU_error++;
+        if (IMU_error % error_report == 0) {
+            /* let's check frmerr bit*/
+            Log_event(LOG_IMU_ERRORS, IMU_error, SPI1STATbits.SPIROV);
+            IMU_retry = 5;
+            IMU_state = IMU_init(IMU_SPI_MODE);
+            if (IMU_state == ERROR && IMU_retry > 0) {
+                IMU_state = IMU_init(IMU_SPI_MODE);
+                IMU_retry--;
+            }
+#ifdef IMU_DRDY_MODE
+            if (IMU_state != ERROR) {
+                IMU_state = IMU_enable_drdy(IMU_DRDY_DIV);
+            }
+#endif
+        }
+    }
+}
+
+/**
+ * @function telemetry_task(void)
+ * @brief publishes the telemetry streams that are due and fit the links every
+ * TELEMETRY_PERIOD
+ */
+void telemetry_task(void) {
+    PROF_BEGIN(PROF_PUBLISH);
+    Telemetry_run();
+    PROF_END(PROF_PUBLISH);
+}
+
+/**
+ * @function mission_task(void)
+ * @brief stores an uploaded mission item, serves a download or reads the
+ * next waypoint into RAM every MISSION_PERIOD
+ */
+void mission_task(void) {
+    Mission_run();
+}
+
+/**
+ * @function heartbeat_task(void)
+ * @brief publishes the heartbeat, sets home on the first GPS fix, logs the
+ * rover state and sends the event log every HEARTBEAT_PERIOD
+ */
+void heartbeat_task(void) {
+    uint32_t timer_start;
+    uint32_t timer_end;
+
+    publish_heartbeat(USB_RADIO); // one frame for both ground stations
+    /*check for GPS location lock*/
+    if (is_home_set == FALSE) {
+        is_home_set = set_home();
+    }
+
+    Log_event(LOG_ODOMETRY, X_new.x, X_new.y, X_new.psi*rad2deg, X_new.vx,
+            X_new.vy, X_new.v, X_new.delta * rad2deg);
+    timer_start = Sys_timer_get_usec();
+    //            msg_len = sprintf(message, "Home: y=%3.6f x=%3.6f, GPS: lat: %3.6f, lon: %3.6f \r\n", home[1], home[0], GPS_data.lat, GPS_data.lon);
+    //            mavprint(message, msg_len, RADIO);
+    GPS2ECEF(&X_tp[0], GPS_data.lon, GPS_data.lat, 0.0);
+    GPS2LTP(X_ltp, home_tp, X_tp, GPS_data.lon, GPS_data.lat);
+    timer_end = Sys_timer_get_usec();
+    Log_event(LOG_LTP, timer_end - timer_start, X_ltp[1], X_ltp[0], GPS_data.lat,
+            GPS_data.lon);
+    //            msg_len = sprintf(message, "status buffer SPIROV: %d\r\n", SPI1STATbits.SPIROV);
+    //            mavprint(message, msg_len, RADIO);
+    Log_flush(); // with the records the handlers logged since the last one
+}
+
+/**
+ * @function profile_task(void)
+ * @brief starts a profile report every PROFILE_PERIOD, its stream sends it a
+ * part per pass; a report the link has not finished yet carries on instead
+ */
+void profile_task(void) {
+    if (pub_profile == TRUE && profile_part >= PROFILE_DONE) {
+        profile_part = PROFILE_SECTIONS;
+    }
+}
+
+/**
+ * @function apply_velocity_gains(void)
+ * @brief new VEL_ gains take effect without resetting the velocity PID
+ */
+void apply_velocity_gains(void) {
+    PID_update_constants(&v_PID);
+}
+
+/**
+ * @function apply_heading_gains(void)
+ * @brief new HDG_ gains take effect without resetting the heading PID
+ */
+void apply_heading_gains(void) {
+    PID_update_constants(&heading_PID);
+}
+
+/**
+ * @function apply_AHRS_gains(void)
+ * @brief loads the AHRS_ filter gains into the AHRS
+ */
+void apply_AHRS_gains(void) {
+    AHRS_set_filter_gains(kp_a, ki_a, kp_m, ki_m);
+}
+
+/**
+ * @function apply_IMU_cal(void)
+ * @brief loads the CAL_ matrices and offsets into the IMU driver
+ */
+void apply_IMU_cal(void) {
+    IMU_set_acc_cal(A_acc, b_acc);
+    IMU_set_mag_cal(A_mag, b_mag);
+}
+
+/**
+ * @function apply_USB_link(void)
+ * @brief moves the USB serial port to USB_BAUD with USB_FLOW flow control
+ * once the bytes queued at the old rate are out, so the reply to the
+ * PARAM_SET comes at the new rate; a rate the UART cannot make is logged
+ * and the parameters go back to the rate in use, so does a rate no MAVLink
+ * message arrives at within USB_LINK_TIMEOUT, see check_MAVLink_events()
+ */
+void apply_USB_link(void) {
+    uint32_t baud = (uint32_t) (usb_baud + 0.5);
+    uint8_t flow = usb_flow >= 0.5 ? SERIAL_FLOW_RTS_CTS : SERIAL_FLOW_NONE;
+
+    if (baud == usb_baud_set && flow == usb_flow_set) {
+        return;
+    }
+    if (Serial_set_baud(baud, flow) == ERROR) {
+        Log_event(LOG_USB_BAUD, baud, usb_baud_set);
+        usb_baud = usb_baud_set;
+        usb_flow = usb_flow_set;
+        return;
+    }
+    usb_baud_set = baud;
+    usb_flow_set = flow;
+    usb_switch_time = Sys_timer_get_msec();
+    usb_link_trial = TRUE;
+}
+
 int main(void) {
     uint32_t start_time = 0;
     uint32_t cur_time = 0;
     uint32_t RC_timeout = 1000;
-    uint32_t control_start_time = 0;
-    uint32_t timer_start = 0;
-    int32_t timer_end = 0;
-    uint32_t publish_start_time = 0;
-    uint32_t gps_start_time = 0;
-    uint32_t heartbeat_start_time = 0;
-    int8_t IMU_state = ERROR;
-    int8_t IMU_retry = 5;
-    uint32_t IMU_error = 0;
-    uint8_t error_report = 50;
-    uint8_t mission_mode = MANUAL;
-    int8_t is_home_set = FALSE;
-
-    /*radio variables*/
-    char c;
-    char message[BUFFER_SIZE];
-    uint8_t msg_len = 0;
 
     //Initialization routines
     Board_init(); //board configuration
     Serial_init(); //start debug terminal 
+    HIL_init(); // real sensors until a simulator sends HIL data
     Encoder_init(); // start the encoders
     Radio_serial_init(); //start the radios
+    Mavlink_rx_init(mav_handlers, NUM_MAV_HANDLERS, handle_unknown);
     GPS_init(); // initialize GPS 
     Sys_timer_init(); //start the system timer
+    Telemetry_init(streams, NUM_STREAMS); // buckets sized from the port baud rates
+    Log_init(log_events, NUM_LOG_EVENTS, RADIO);
+    if (Param_init(parameters, NUM_PARAMS, GNC_PARAM_SEED, GNC_PARAM_SLOTS) == ERROR) {
+        Log_event(LOG_PARAM_HASH); // still works, by searching the ids
+    }
+    EEPROM_init();
+    if (Mission_init(MAV_FRAME_LOCAL_NED) == ERROR) {
+        Log_event(LOG_NO_MISSION);
+    }
     cur_time = Sys_timer_get_msec();
     start_time = cur_time;
     RCRX_init(); //initialize the radio control system
@@ -1336,12 +2304,7 @@ int main(void) {
             break;
         }
     }
-    if (RC_system_online == FALSE) {
-        msg_len = sprintf(message, "RC system failed to connect!\r\n");
-    } else {
-        msg_len = sprintf(message, "RC system online.\r\n");
-    }
-    mavprint(message, msg_len, RADIO);
+    Log_event(RC_system_online == FALSE ? LOG_RC_OFFLINE : LOG_RC_ONLINE);
 
     /* With RC controller online we can set the servo PWM outputs*/
     RC_servo_init(ESC_BIDIRECTIONAL_TYPE, SERVO_PWM_1); // Left motor
@@ -1353,10 +2316,10 @@ int main(void) {
     if (IMU_state == ERROR && IMU_retry > 0) {
         IMU_state = IMU_init(IMU_SPI_MODE);
         //        printf("IMU failed init, retrying %d \r\n", IMU_retry);
-        msg_len = sprintf(message, "IMU failed init, retrying %d \r\n", IMU_retry);
-        mavprint(message, msg_len, RADIO);
+        Log_event(LOG_IMU_RETRY, IMU_retry);
         IMU_retry--;
     }
+    IMU_batch_init(IMU_BATCH_PERIOD);
 
     /* initialize the PIDs*/
     PID_init(&v_PID);
@@ -1370,8 +2333,7 @@ int main(void) {
     Encoder_get_data(enc); // get encoder values
     heading_0 = enc[STEERING_SERVO].next_theta;
 
-    msg_len = sprintf(message, "\r\nRover Manual Control App %s, %s \r\n", __DATE__, __TIME__);
-    mavprint(message, msg_len, RADIO);
+    Log_event(LOG_BOOT, __DATE__, __TIME__);
     /* load IMU calibrations */
     IMU_set_mag_cal(A_mag, b_mag);
     IMU_set_acc_cal(A_acc, b_acc);
@@ -1380,101 +2342,36 @@ int main(void) {
     AHRS_set_filter_gains(kp_a, ki_a, kp_m, ki_m);
     AHRS_set_mag_inertial(m_i);
 
-    cur_time = Sys_timer_get_msec();
-    control_start_time = cur_time;
-    publish_start_time = cur_time;
-    heartbeat_start_time = cur_time;
-    gps_start_time = cur_time;
+#ifdef IMU_DRDY_MODE
+    /* the IMU starts each read on its data ready interrupt */
+    if (IMU_state != ERROR) {
+        IMU_state = IMU_enable_drdy(IMU_DRDY_DIV);
+    }
+    if (IMU_state == ERROR) {
+        Log_event(LOG_IMU_DRDY_OFF);
+    }
+#endif
+
+    /* time the control tick sections */
+    Prof_init(CONTROL_PERIOD * 1000);
+    Prof_name(PROF_AHRS, "ahrs");
+    Prof_name(PROF_ODOMETRY, "odometry");
+    Prof_name(PROF_GUIDANCE, "guidance");
+    Prof_name(PROF_PUBLISH, "publish");
+
+    /* start the periodic tasks */
+    Sched_init(tasks, NUM_TASKS);
+    Log_flush(); // the start up reports
 
     while (1) {
         //check for all events
         check_IMU_events(); //check for IMU data ready
         check_encoder_events(); // check for encoder data ready
         check_GPS_events(); //check and process incoming GPS messages
-        check_radio_events(); //detect and process MAVLink incoming messages
-        check_USB_events(); // look for MAVLink messages
+        check_MAVLink_events(); //detect and process MAVLink incoming messages
         check_RC_events(); //check incoming RC commands
-        cur_time = Sys_timer_get_msec();
-        /* update control loop*/
-        if (cur_time - control_start_time >= CONTROL_PERIOD) {
-            control_start_time = cur_time; //reset control loop timer
-
-            AHRS_update(acc_cal, mag_cal, gyro_cal, dt, q, gyro_bias);
-            Rover_quat2euler(q, euler);
-            update_odometry();
-            mission_mode = check_mission_status();
-            set_control_output(mission_mode); // set actuator outputs
-            /*start next data acquisition round*/
-            Encoder_start_data_acq(); // start encoder acquisition
-            IMU_state = IMU_start_data_acq(); //initiate IMU measurement with SPI
-            if (IMU_state == ERROR) { //last transaction didn't complete
-                IMU_error++;
-                if (IMU_error % error_report == 0) {
-                    /* let's check frmerr bit*/
-                    msg_len = sprintf(message, "IMU errors: %d, buf: %d\r\n", IMU_error, SPI1STATbits.SPIROV);
-                    mavprint(message, msg_len, RADIO);
-                    IMU_retry = 5;
-                    IMU_state = IMU_init(IMU_SPI_MODE);
-                    if (IMU_state == ERROR && IMU_retry > 0) {
-                        IMU_state = IMU_init(IMU_SPI_MODE);
-                        IMU_retry--;
-                    }
-                }
-            }
-            /* test time duration of control actions*/
-            timer_end = Sys_timer_get_usec() - timer_start;
-        }
-        /* publish high speed sensors */
-        if (cur_time - publish_start_time > PUBLISH_PERIOD) {
-            publish_start_time = cur_time; //reset publishing timer
-            if (pub_RC_signals == TRUE) {
-                publish_RC_signals_raw();
-            }
-            if (pub_IMU == TRUE) {
-                publish_IMU_data(SCALED, USB);
-            }
-            if (pub_encoders == TRUE) {
-                publish_encoder_data();
-            }
-            if (pub_attitude == TRUE) {
-                publish_attitude();
-            }
-            if (pub_position == TRUE) {
-                publish_position();
-            }
-        }
-
-        /* publish GPS */
-        if (cur_time - gps_start_time > GPS_PERIOD) {
-            gps_start_time = cur_time; //reset GPS timer
-            if (pub_GPS == TRUE) {
-                publish_GPS(USB);
-            }
-        }
-        /* if period timer expires, publish the heartbeat message*/
-        if (cur_time - heartbeat_start_time >= HEARTBEAT_PERIOD) {
-            heartbeat_start_time = cur_time; //reset the timer
-            publish_heartbeat(USB);
-            /*check for GPS location lock*/
-            if (is_home_set == FALSE) {
-                is_home_set = set_home();
-            }
-
-            msg_len = sprintf(message, "x: %3.1f y: %3.1f psi: %3.1f vx: %3.1f vy: %3.1f v: %3.1f delta: %3.1f \r\n",
-                    X_new.x, X_new.y, X_new.psi*rad2deg, X_new.vx, X_new.vy, X_new.v, X_new.delta * rad2deg);
-            mavprint(message, msg_len, RADIO);
-            timer_start = Sys_timer_get_usec();
-            //            msg_len = sprintf(message, "Home: y=%3.6f x=%3.6f, GPS: lat: %3.6f, lon: %3.6f \r\n", home[1], home[0], GPS_data.lat, GPS_data.lon);
-            //            mavprint(message, msg_len, RADIO);
-            GPS2ECEF(&X_tp[0], GPS_data.lon, GPS_data.lat, 0.0);
-            GPS2LTP(X_ltp, home_tp, X_tp, GPS_data.lon, GPS_data.lat);
-            timer_end = Sys_timer_get_usec();
-            msg_len = sprintf(message, "timer: %d;  LTP: y=%3.6f x=%3.6f, GPS: lat: %3.6f, lon: %3.6f \r\n",
-                    timer_end-timer_start, X_ltp[1], X_ltp[0], GPS_data.lat, GPS_data.lon);
-            mavprint(message, msg_len, RADIO);
-            //            msg_len = sprintf(message, "status buffer SPIROV: %d\r\n", SPI1STATbits.SPIROV);
-            //            mavprint(message, msg_len, RADIO);
-        }
+        Param_run(); // new parameter values all at once, between the tasks
+        Sched_run(); // run the highest priority task that is due
     }
     return (0);
 }
@@ -0,0 +1,17 @@
+/*
+ * File:   GNC_params.h
+ * Brief: Perfect hash of the GNC parameter ids for Param_init(), generated by
+ * python/param_hash.py from the PARAM_ENTRY() table in GNC_main.c, do not
+ * edit; run the script again after changing the ids.
+ * Created on 10/16/2026
+ * Modified on 10/16/2026
+ */
+
+#ifndef GNC_PARAMS_H // Header guard
+#define	GNC_PARAMS_H //
+
+#define GNC_PARAM_COUNT 36
+#define GNC_PARAM_SEED 0x4fUL
+#define GNC_PARAM_SLOTS 128
+
+#endif	/* GNC_PARAMS_H */ // End of header guard
@@ -24,6 +24,7 @@
 #include "RC_servo.h"
 #include "ICM_20948.h"
 #include "AHRS.h"
+#include "Lin_alg_rot.h"
 #include "AS5047D.h"
 
 /*******************************************************************************
@@ -299,13 +300,6 @@ static int calc_pw(int raw_counts);
 void set_control_output(void);
 
 
-/**
- * @function Rover_quat2euler()
- * @param q A quaternion
- * @param euler a vector of euler angles in [psi, theta, roll] order
- */
-void Rover_quat2euler(float q[MSZ], float euler[MSZ]);
-
 /**
  * @function update_odometry(void)
  * @brief: computes the addition to the vehicle location from encoder data
@@ -505,7 +499,7 @@ void publish_GPS(uint8_t dest) {
     mavlink_msg_gps_raw_int_pack(mavlink_system.sysid,
             mavlink_system.compid,
             &msg_tx,
-            (uint64_t) Sys_timer_get_usec(),
+            Sys_timer_get_usec64(),
             gps_fix,
             (int32_t) (GPS_data.lat * 10000000.0),
             (int32_t) (GPS_data.lon * 10000000.0),
@@ -541,7 +535,7 @@ void publish_IMU_data(uint8_t data_type, uint8_t dest) {
         mavlink_msg_raw_imu_pack(mavlink_system.sysid,
                 mavlink_system.compid,
                 &msg_tx,
-                Sys_timer_get_usec(),
+                Sys_timer_get_usec64(),
                 (int16_t) IMU_raw.acc.x,
                 (int16_t) IMU_raw.acc.y,
                 (int16_t) IMU_raw.acc.z,
@@ -558,7 +552,7 @@ void publish_IMU_data(uint8_t data_type, uint8_t dest) {
         mavlink_msg_highres_imu_pack(mavlink_system.sysid,
                 mavlink_system.compid,
                 &msg_tx,
-                Sys_timer_get_usec(),
+                Sys_timer_get_usec64(),
                 (float) IMU_scaled.acc.x,
                 (float) IMU_scaled.acc.y,
                 (float) IMU_scaled.acc.z,
@@ -878,25 +872,6 @@ void set_control_output(void) {
     }
 }
 
-/**
- * @function quat2euler()
- * @param q A quaternion
- * @param euler a vector of euler angles in [psi, theta, roll] order
- */
-void Rover_quat2euler(float q[MSZ], float euler[MSZ]) {
-    float q00 = q[0] * q[0];
-    float q11 = q[1] * q[1];
-    float q22 = q[2] * q[2];
-    float q33 = q[3] * q[3];
-
-    // psi
-    euler[0] = atan2(2.0 * (q[1] * q[2] + q[0] * q[3]), ((q00 + q11 - q22 - q33)));
-    // theta
-    euler[1] = asin(2.0 * (q[0] * q[2] - q[1] * q[3]));
-    // phi
-    euler[2] = atan2(2.0 * (q[2] * q[3] + q[0] * q[1]), q00 - q11 - q22 + q33);
-}
-
 /**
  * @function update_odometry(void)
  * @brief: computes the addition to the vehicle location from encoder data
@@ -988,8 +963,6 @@ int main(void) {
     uint32_t cur_time = 0;
     uint32_t RC_timeout = 1000;
     uint32_t control_start_time = 0;
-    uint32_t timer_start = 0;
-    int32_t timer_end = 0;
     uint32_t publish_start_time = 0;
     uint32_t gps_start_time = 0;
     uint32_t heartbeat_start_time = 0;
@@ -1071,9 +1044,8 @@ int main(void) {
         /* update control loop*/
         if (cur_time - control_start_time >= CONTROL_PERIOD) {
             control_start_time = cur_time; //reset control loop timer
-            timer_start = Sys_timer_get_usec();
             AHRS_update(acc_cal, mag_cal, gyro_cal, dt, q, gyro_bias);
-            Rover_quat2euler(q, euler);
+            lin_alg_quat2euler(q, euler);
             update_odometry();
             set_control_output(); // set actuator outputs
             /*start next data acquisition round*/
@@ -1092,8 +1064,6 @@ int main(void) {
                     }
                 }
             }
-            /* test time duration of control actions*/
-            timer_end = Sys_timer_get_usec() - timer_start;
         }
         /* publish high speed sensors */
         if (cur_time - publish_start_time > PUBLISH_PERIOD) {
@@ -1137,16 +1107,9 @@ int main(void) {
             //            mavprint(message, msg_len, RADIO);
             //            msg_len = sprintf(message, "Switch D: %d, switch A: %d \r\n", RC_channels[SWITCH_D], RC_channels[SWITCH_A]);
             //            mavprint(message, msg_len, RADIO);
-            msg_len = sprintf(message, "%d \r\n", timer_end);
-            mavprint(message, msg_len, RADIO);
             //            msg_len = sprintf(message, "RCRX bytes: %d, collisions %d, parse err %d, Uart err %d\r\n",
             //                    RCRX_get_byte_count(), RCRX_get_collision_count(), RCRX_get_err(), RCRX_get_uart_err_count());
             //            mavprint(message, msg_len, RADIO);
-            msg_len = sprintf(message, "x: %3.1f y: %3.1f psi: %3.1f vx: %3.1f vy: %3.1f v: %3.1f delta: %3.1f \r\n",
-                    X_new.x, X_new.y, X_new.psi*rad2deg, X_new.vx, X_new.vy, X_new.v, X_new.delta * rad2deg);
-            mavprint(message, msg_len, RADIO);
-            msg_len = sprintf(message, "GPS: %f, %f, %f \r\n", GPS_data.time, GPS_data.lat, GPS_data.lon);
-            mavprint(message, msg_len, RADIO);
         }
     }
     return (0);
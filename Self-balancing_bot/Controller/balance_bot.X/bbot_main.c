@@ -17,8 +17,9 @@
 #include "Board.h"
 #include "SerialM32.h"
 #include "System_timer.h"
+#include "Scheduler.h"
 #include "Radio_serial.h"
-#include "common/mavlink.h"
+#include "Mavlink_tx.h"
 #include "RC_RX.h"
 #include "RC_servo.h"
 #include "ICM_20948.h"
@@ -82,6 +83,15 @@ static uint8_t pub_RC_servo = FALSE;
 static uint8_t pub_RC_signals = TRUE;
 static uint8_t pub_IMU = FALSE;
 
+/* IMU and attitude state shared by the main loop and the scheduler tasks */
+static int8_t IMU_state = ERROR;
+static uint32_t IMU_error = 0;
+static const uint8_t error_report = 50;
+static int8_t IMU_updated = TRUE; // test value for IMU update rate
+static uint32_t IMU_update_start;
+static float euler[MSZ] = {0, 0, 0};
+static float gyro_cal[MSZ] = {0, 0, 0};
+
 /*******************************************************************************
  * TYPEDEFS                                                                    *
  ******************************************************************************/
@@ -248,6 +258,36 @@ void set_motor_outputs(void);
  */
 float get_control_output(float ref, float sensor_val, PID_controller * controller);
 
+/**
+ * @function rate_control_task(void)
+ * @brief angular rate control and motor outputs every
+ * ANGULAR_RATE_CONTROL_PERIOD, then starts the next IMU acquisition and
+ * publishes the high speed sensors
+ */
+void rate_control_task(void);
+
+/**
+ * @function angle_control_task(void)
+ * @brief angle control every ANGLE_CONTROL_PERIOD
+ */
+void angle_control_task(void);
+
+/**
+ * @function heartbeat_task(void)
+ * @brief heartbeat every HEARTBEAT_PERIOD
+ */
+void heartbeat_task(void);
+
+/*******************************************************************************
+ * TASKS                                                                       *
+ ******************************************************************************/
+static sched_task_t tasks[] = {
+    SCHED_TASK("rate", rate_control_task, ANGULAR_RATE_CONTROL_PERIOD, 0, 0, 0),
+//    SCHED_TASK("angle", angle_control_task, ANGLE_CONTROL_PERIOD, 1, 1, 0),
+    SCHED_TASK("heartbeat", heartbeat_task, HEARTBEAT_PERIOD, 3, 2, 0),
+};
+#define NUM_TASKS (sizeof (tasks) / sizeof (tasks[0]))
+
 /*******************************************************************************
  * FUNCTIONS                                                                   *
  ******************************************************************************/
@@ -335,17 +375,13 @@ void publish_IMU_data(uint8_t data_type) {
     float gyro_x_bias = -0.850931981566821;
     char message[BUFFER_SIZE];
     uint8_t msg_len = 0;
-    uint16_t index = 0;
     uint8_t IMU_id = 0;
     if (data_type == RAW) {
         msg_len = sprintf(message, "%f %f %f \r\n", IMU_scaled.gyro.x - gyro_x_bias, IMU_scaled.gyro.y, IMU_scaled.gyro.z);
     } else if (data_type == SCALED) {
             ;
     }
-    // msg_length = mavlink_msg_to_send_buffer(msg_buffer, &msg_tx);
-    for (index = 0; index < msg_len; index++) {
-        Radio_put_char(message[index]);
-    }
+    Radio_write((uint8_t *) message, msg_len);
 }
 
 /**
@@ -364,9 +400,6 @@ void publish_IMU_data(uint8_t data_type) {
  * @author Aaron Hunter
  */
 void publish_RC_signals(void) {
-    mavlink_message_t msg_tx;
-    uint16_t msg_length;
-    uint8_t msg_buffer[BUFFER_SIZE];
     uint16_t index = 0;
     uint8_t RC_port = 0; //first 8 channels 
     int16_t scaled_channels[CHANNELS];
@@ -374,9 +407,7 @@ void publish_RC_signals(void) {
     for (index = 0; index < CHANNELS; index++) {
         scaled_channels[index] = (RC_channels[index] - RC_RX_MID_COUNTS) * RC_raw_fs_scale;
     }
-    mavlink_msg_rc_channels_scaled_pack(mavlink_system.sysid,
-            mavlink_system.compid,
-            &msg_tx,
+    mavlink_msg_rc_channels_scaled_send(MAVLINK_TX_RADIO,
             Sys_timer_get_msec(),
             RC_port,
             scaled_channels[0],
@@ -388,10 +419,6 @@ void publish_RC_signals(void) {
             scaled_channels[6],
             scaled_channels[7],
             rssi);
-    msg_length = mavlink_msg_to_send_buffer(msg_buffer, &msg_tx);
-    for (index = 0; index < msg_length; index++) {
-        Radio_put_char(msg_buffer[index]);
-    }
 }
 
 /**
@@ -434,7 +461,6 @@ void publish_RC_signals(void) {
  * @author Aaron Hunter
  */
 void publish_RC_signals_raw(void) {
-    int index = 0;
     uint16_t msg_length; 
     char msg_buffer[BUFFER_SIZE];
     msg_length = sprintf(msg_buffer, "%d %d %d %d %d %d %d %d %d %d\r\n", 
@@ -448,9 +474,7 @@ void publish_RC_signals_raw(void) {
         RC_channels[7],        
         RC_channels[8], 
         RC_channels[9]);
-    for (index = 0; index < msg_length; index++) {
-        Radio_put_char(msg_buffer[index]);
-    }
+    Radio_write((uint8_t *) msg_buffer, msg_length);
 }
 
 
@@ -462,24 +486,14 @@ void publish_RC_signals_raw(void) {
  * @author aaron hunter
  */
 void publish_heartbeat(void) {
-    mavlink_message_t msg_tx;
-    uint16_t msg_length;
-    uint8_t msg_buffer[BUFFER_SIZE];
-    uint16_t index = 0;
     uint8_t mode = MAV_MODE_FLAG_MANUAL_INPUT_ENABLED | MAV_MODE_FLAG_SAFETY_ARMED;
     uint32_t custom = 0;
     uint8_t state = MAV_STATE_STANDBY;
-    mavlink_msg_heartbeat_pack(mavlink_system.sysid
-            , mavlink_system.compid,
-            &msg_tx,
+    mavlink_msg_heartbeat_send(MAVLINK_TX_RADIO,
             MAV_TYPE_GROUND_ROVER, MAV_AUTOPILOT_GENERIC,
             mode,
             custom,
             state);
-    msg_length = mavlink_msg_to_send_buffer(msg_buffer, &msg_tx);
-    for (index = 0; index < msg_length; index++) {
-        Radio_put_char(msg_buffer[index]);
-    }
 }
 
 /**
@@ -489,27 +503,17 @@ void publish_heartbeat(void) {
  * @author aaron hunter
  */
 void publish_parameter(uint8_t param_id[16]) {
-    mavlink_message_t msg_tx;
-    uint16_t msg_length;
-    uint8_t msg_buffer[BUFFER_SIZE];
-    uint16_t index = 0;
     float param_value = 320.0; // value of the requested parameter
     uint8_t param_type = MAV_PARAM_TYPE_INT16; // onboard mavlink parameter type
     uint16_t param_count = 1; // total number of onboard parameters
     uint16_t param_index = 1; //index of this value
-    mavlink_msg_param_value_pack(mavlink_system.sysid,
-            mavlink_system.compid,
-            &msg_tx,
+    mavlink_msg_param_value_send(MAVLINK_TX_RADIO,
             param_id,
             param_value,
             param_type,
             param_count,
             param_index
             );
-    msg_length = mavlink_msg_to_send_buffer(msg_buffer, &msg_tx);
-    for (index = 0; index < msg_length; index++) {
-        Radio_put_char(msg_buffer[index]);
-    }
 }
 
 /**
@@ -699,24 +703,60 @@ float get_control_output(float ref, float sensor_val, PID_controller * controlle
     return (setpoint);
 }
 
+/**
+ * @function rate_control_task(void)
+ * @brief angular rate control and motor outputs every
+ * ANGULAR_RATE_CONTROL_PERIOD, then starts the next IMU acquisition and
+ * publishes the high speed sensors
+ */
+void rate_control_task(void) {
+//    set_control_output(gyro_cal, euler); // set actuator outputs
+    calc_angle_rate_output(gyro_cal);
+    set_motor_outputs();
+    /*start next data acquisition round*/
+    IMU_state = IMU_start_data_acq(); //initiate IMU measurement with SPI
+    if (IMU_updated == TRUE) {
+        IMU_update_start = Sys_timer_get_msec();
+        IMU_updated = FALSE;
+    }
+    if (IMU_state == ERROR) {
+        IMU_error++;
+        if (IMU_error % error_report == 0) {
+            printf("IMU error count %d\r\n", IMU_error);
+        }
+    }
+    /*publish high speed sensors*/
+    if (pub_RC_signals == TRUE) {
+        publish_RC_signals_raw();
+    }
+    if (pub_IMU == TRUE) {
+        publish_IMU_data(RAW);
+    }
+}
+
+/**
+ * @function angle_control_task(void)
+ * @brief angle control every ANGLE_CONTROL_PERIOD
+ */
+void angle_control_task(void) {
+    calc_angle_output(euler);
+}
+
+/**
+ * @function heartbeat_task(void)
+ * @brief heartbeat every HEARTBEAT_PERIOD
+ */
+void heartbeat_task(void) {
+    //    publish_heartbeat();
+}
+
 int main(void) {
     uint32_t start_time = 0;
     uint32_t cur_time = 0;
     uint32_t RC_timeout = 1000;
-    uint32_t angular_rate_control_start_time = 0;
-    uint32_t angle_control_start_time = 0;
-    uint32_t heartbeat_start_time = 0;
-    uint8_t index;
-    int8_t IMU_state = ERROR;
     int8_t IMU_retry = 5;
-    uint32_t IMU_error = 0;
-    uint8_t error_report = 50;
-    uint32_t IMU_update_start;
     uint32_t IMU_update_end;
 
-    /*test value for IMU update rate*/
-    int8_t IMU_updated = TRUE;
-
     /*radio variables*/
     char message[BUFFER_SIZE];
     uint8_t msg_len = 0;
@@ -756,13 +796,8 @@ int main(void) {
     float q_test[QSZ] = {1, 0, 0, 0};
     /*gyro bias*/
     float bias_test[MSZ] = {0, 0, 0};
-    /*euler angles (yaw, pitch, roll) */
-
-    // Euler angles
-    float euler[MSZ] = {0, 0, 0};
 
     /* data arrays */
-    float gyro_cal[MSZ] = {0, 0, 0};
     float acc_cal[MSZ] = {0, 0, 0};
     float mag_cal[MSZ] = {0, 0, 0};
 
@@ -772,17 +807,13 @@ int main(void) {
     Radio_serial_init(); //start the radios
     printf("Board initialization complete.\r\n");
     msg_len = sprintf(message, "Board initialization complete.\r\n");
-    for (index = 0; index < msg_len; index++) {
-        Radio_put_char(message[index]);
-    }
+    Radio_write((uint8_t *) message, msg_len);
 
     Sys_timer_init(); //start the system timer
     cur_time = Sys_timer_get_msec();
     printf("System timer initialized.  Current time %d. \r\n", cur_time);
     msg_len = sprintf(message, "System timer initialized.\r\n");
-    for (index = 0; index < msg_len; index++) {
-        Radio_put_char(message[index]);
-    }
+    Radio_write((uint8_t *) message, msg_len);
     cur_time = Sys_timer_get_msec();
     start_time = cur_time;
     RCRX_init(); //initialize the radio control system
@@ -798,9 +829,7 @@ int main(void) {
     } else {
         msg_len = sprintf(message, "RC system online.\r\n");
     }
-    for (index = 0; index < msg_len; index++) {
-        Radio_put_char(message[index]);
-    }
+    Radio_write((uint8_t *) message, msg_len);
 
     /* With RC controller online we can set the servo PWM outputs*/
     RC_servo_init(ESC_UNIDIRECTIONAL_TYPE, SERVO_PWM_1); // MOTOR 1
@@ -830,55 +859,16 @@ int main(void) {
     AHRS_set_filter_gains(kp_a, ki_a, kp_m, ki_m);
     AHRS_set_mag_inertial(m_i);
 
-    cur_time = Sys_timer_get_msec();
-    angular_rate_control_start_time = cur_time;
-    angle_control_start_time = cur_time;
-    heartbeat_start_time = cur_time;
+    /* start the periodic tasks */
+    Sched_init(tasks, NUM_TASKS);
 
     while (1) {
         //check for all events
         check_IMU_events(); //check for IMU data ready and publish when available
         //        check_radio_events(); //detect and process MAVLink incoming messages
         check_RC_events(); //check incoming RC commands
-        cur_time = Sys_timer_get_msec();
-        //publish control and sensor signals
-        if (cur_time - angular_rate_control_start_time >= ANGULAR_RATE_CONTROL_PERIOD) {
-            angular_rate_control_start_time = cur_time; //reset control loop timer
-//            set_control_output(gyro_cal, euler); // set actuator outputs
-            calc_angle_rate_output(gyro_cal);
-            set_motor_outputs();
-            /*start next data acquisition round*/
-            IMU_state = IMU_start_data_acq(); //initiate IMU measurement with SPI
-            if (IMU_updated == TRUE) {
-                IMU_update_start = Sys_timer_get_msec();
-                IMU_updated = FALSE;
-            }
-            if (IMU_state == ERROR) {
-                IMU_error++;
-                if (IMU_error % error_report == 0) {
-                    printf("IMU error count %d\r\n", IMU_error);
-                    //                    IMU_retry = 5;
-                    //                    IMU_state = IMU_init(IMU_SPI_MODE);
-                    //                    if (IMU_state == ERROR && IMU_retry > 0) {
-                    //                        IMU_state = IMU_init(IMU_SPI_MODE);
-                    //                        printf("IMU failed init, retrying %d \r\n", IMU_retry);
-                    //                        IMU_retry--;
-                }
-            }
-            /*publish high speed sensors*/
-            if (pub_RC_signals == TRUE) {
-                publish_RC_signals_raw();
-            }
-            if (pub_IMU == TRUE) {
-                publish_IMU_data(RAW);
-            }
-        }
-        /* update angular control every ANGL_CONTROL_PERIOD*/
-//        if(cur_time - angle_control_start_time >= ANGLE_CONTROL_PERIOD) {
-//            angle_control_start_time = cur_time;
-//            calc_angle_output(euler);
-//        }
-        
+        Sched_run(); // run the highest priority task that is due
+
         if (IMU_is_data_ready() == TRUE) {
             IMU_updated = TRUE;
             IMU_update_end = Sys_timer_get_msec();
@@ -898,11 +888,6 @@ int main(void) {
 
 //             printf("%+3.1f, %+3.1f, %+3.1f, %d \r\n", euler[0] * rad2deg, euler[1] * rad2deg, euler[2] * rad2deg, IMU_update_end - IMU_update_start);
         }
-        /* if period timer expires, publish the heartbeat message*/
-        if (cur_time - heartbeat_start_time >= HEARTBEAT_PERIOD) {
-            heartbeat_start_time = cur_time; //reset the timer
-            //            publish_heartbeat();
-        }
     }
     return (0);
 }
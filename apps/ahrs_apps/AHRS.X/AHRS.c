@@ -11,14 +11,11 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <math.h>
-#include <xc.h>
 #include "AHRS.h"
 #include "Board.h"
-#include "ICM_20948.h"  
-#include "ICM_20948_registers.h" 
-#include "lin_alg_float.h"
-#include "SerialM32.h"
-#include "System_timer.h"
+#include "Lin_alg_float.h"
+#include "Lin_alg_inline.h"
+#include "Lin_alg_rot.h"
 
 
 /*******************************************************************************
@@ -59,20 +56,6 @@ static float m_i[MSZ] = {0.110011998753301, 0.478219898291142, -0.87132260903107
 /*******************************************************************************
  * PRIVATE FUNCTIONS PROTOTYPES                                                *
  ******************************************************************************/
-/**
- * @function quat2euler()
- * @param q A quaternion
- * @param euler a vector of euler angles in [psi, theta, roll] order
- */
-static void quat2euler(float q[MSZ], float euler[MSZ]);
-/**
- * @function q_rot_v_q()
- * Rotate a vector from the inertial frame to the body frame
- * @param v_i, a 3space vector in the inertial frame
- * @param q an attitude quaternion
- * sets v_b to the rotated inertial vector in the body frame
- */
-static void q_rot_v_q(float v_i[MSZ], float q[QSZ], float v_b[MSZ]);
 /**
  * @function v_copy()
  * @param v_in the vector to be copied
@@ -81,13 +64,6 @@ static void q_rot_v_q(float v_i[MSZ], float q[QSZ], float v_b[MSZ]);
  */
 static void v_copy(float v_in[MSZ], float v_out[MSZ]);
 
-/**
- * @function m_norm()
- * @param M A matrix
- * @return The magnitude of the M, m_norm
- */
-static float m_norm(float M[MSZ]);
-
 /*******************************************************************************
  * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
  ******************************************************************************/
@@ -150,6 +126,25 @@ void AHRS_set_filter_gains(float kp_a_set, float ki_a_set, float kp_m_set, float
     ki_m = ki_m_set;
 }
 
+/**
+ * @Function AHRS_set_state(float q_set[QSZ], float bias_set[MSZ])
+ * @param q_set, attitude quaternion to restart the filter from
+ * @param bias_set, gyro bias estimate to restart the filter from
+ * @return none
+ * @brief overwrites the filter state, used to restart the filter between
+ * replays and after calibration
+ * @note 
+ * @author Aaron Hunter, 10/16/2026
+ * @modified */
+void AHRS_set_state(float q_set[QSZ], float bias_set[MSZ]) {
+    v_copy(bias_set, b_minus);
+    v_copy(bias_set, b_plus);
+    q_minus[0] = q_plus[0] = q_set[0];
+    q_minus[1] = q_plus[1] = q_set[1];
+    q_minus[2] = q_plus[2] = q_set[2];
+    q_minus[3] = q_plus[3] = q_set[3];
+}
+
 /**
  * @Function AHRS_update
  * @param IMU data in the form of three axis
@@ -166,98 +161,46 @@ void AHRS_set_filter_gains(float kp_a_set, float ki_a_set, float kp_m_set, float
 void AHRS_update(float accels[MSZ], float mags[MSZ], float gyros[MSZ],
         float dt, float q[QSZ], float bias[MSZ]) {
 
-    float a_b[MSZ]; //estimated gravity vector in body frame
-    float m_b[MSZ]; //estimated magnetic field vector in body frame
-
-    float gyro_cal[MSZ]; // gyros with bias correction
-    float gyro_wfb[MSZ]; // gyro 'rate' after feedback
-    float w_meas_ap[MSZ]; // accelerometer proportion correction rate
-    float w_meas_mp[MSZ]; // magnetometer proportional correction rate
-    float w_meas_ai[MSZ]; // accelerometer integral correction rate
-    float w_meas_mi[MSZ]; // magnetometer integral correction rate
-
-    float gyro_q_wfb[QSZ]; // temporary quaternion to hold feedback term
-    float q_dot[QSZ]; // quaternion derivative
-    float q_norm;
-    float acc_n;
-    float mag_n;
-
-    /* normalize inertial measurements */
-    acc_n = 1.0 / m_norm(accels);
-    accels[0] = accels[0] * acc_n;
-    accels[1] = accels[1] * acc_n;
-    accels[2] = accels[2] * acc_n;
-
-    mag_n = 1.0 / m_norm(mags);
-    mags[0] = mags[0] * mag_n;
-    mags[1] = mags[1] * mag_n;
-    mags[2] = mags[2] * mag_n;
-
-    /*Accelerometer attitude calculations */
-    q_rot_v_q(a_i, q_minus, a_b); //estimate gravity vector in body frame 
-    lin_alg_cross(accels, a_b, w_meas_ap); // calculate the accelerometer rate term
-    v_copy(w_meas_ap, w_meas_ai); // make a copy for the integral term
-    lin_alg_v_scale(kp_a, w_meas_ap); // calculate the accelerometer proportional feedback term 
-    lin_alg_v_scale(ki_a, w_meas_ai); // calculate the accelerometer integral feedback term 
-
-    /*Magnetometer attitude calculations*/
-    q_rot_v_q(m_i, q_minus, m_b); //estimate magnetic field vector in body frame
-    lin_alg_cross(mags, m_b, w_meas_mp); // calculate the magnetometer rate term
-    v_copy(w_meas_mp, w_meas_mi); //make a copy for the integral term
-    lin_alg_v_scale(kp_m, w_meas_mp); // calculate the magnetometer proportional feedback term
-    lin_alg_v_scale(ki_m, w_meas_mi); // calculate the magnetometer integral feedback term
-
-    /*Gyro attitude contributions */
-    lin_alg_v_v_sub(gyros, b_minus, gyro_cal); //correct the gyros with the b_minus vector
-
-    /* calculate total rate term gyro_wfb */
-    lin_alg_v_v_add(w_meas_ap, w_meas_mp, gyro_wfb);
-    lin_alg_v_v_add(gyro_cal, gyro_wfb, gyro_wfb);
-
-    /* convert feedback term to a pure quaternion */
-    gyro_q_wfb[0] = 0;
-    gyro_q_wfb[1] = gyro_wfb[0];
-    gyro_q_wfb[2] = gyro_wfb[1];
-    gyro_q_wfb[3] = gyro_wfb[2];
-
-    /* compute the quaternion derivative q_dot */
-    lin_alg_q_mult(q_minus, gyro_q_wfb, q_dot);
-
-    /* integrate term by term */
-    q_plus[0] = q_minus[0] + 0.5 * q_dot[0] * dt;
-    q_plus[1] = q_minus[1] + 0.5 * q_dot[1] * dt;
-    q_plus[2] = q_minus[2] + 0.5 * q_dot[2] * dt;
-    q_plus[3] = q_minus[3] + 0.5 * q_dot[3] * dt;
-
-    // normalize the quaternion for stability
-    q_norm = lin_alg_q_norm(q_plus);
-    q_plus[0] = q_plus[0] / q_norm;
-    q_plus[1] = q_plus[1] / q_norm;
-    q_plus[2] = q_plus[2] / q_norm;
-    q_plus[3] = q_plus[3] / q_norm;
-
-    // compute the integral of the bias term by term
-    b_plus[0] = b_minus[0] - (w_meas_ai[0] + w_meas_mi[0]) * dt;
-    b_plus[1] = b_minus[1] - (w_meas_ai[1] + w_meas_mi[1]) * dt;
-    b_plus[2] = b_minus[2] - (w_meas_ai[2] + w_meas_mi[2]) * dt;
-
-    /* update b_minus and q_minus */
-    b_minus[0] = b_plus[0];
-    b_minus[1] = b_plus[1];
-    b_minus[2] = b_plus[2];
-    q_minus[0] = q_plus[0];
-    q_minus[1] = q_plus[1];
-    q_minus[2] = q_plus[2];
-    q_minus[3] = q_plus[3];
+    vec3_t acc = vec3_load(accels);
+    vec3_t mag = vec3_load(mags);
+    vec3_t b = vec3_load(b_minus);
+    quat_t q_att = quat_load(q_minus);
+    vec3_t w_meas_a; // accelerometer correction rate
+    vec3_t w_meas_m; // magnetometer correction rate
+    vec3_t gyro_wfb; // gyro 'rate' after feedback
+
+    /* normalize inertial measurements, the callers see the normalized values */
+    vec3_normalize(&acc);
+    vec3_normalize(&mag);
+    vec3_store(acc, accels);
+    vec3_store(mag, mags);
+
+    /* rate terms from the estimated gravity and magnetic field vectors in the
+     * body frame */
+    w_meas_a = vec3_cross(acc, quat_rot_v(q_att, vec3_load(a_i)));
+    w_meas_m = vec3_cross(mag, quat_rot_v(q_att, vec3_load(m_i)));
+
+    /* total rate term: bias corrected gyros plus proportional feedback */
+    gyro_wfb = vec3_sub(vec3_load(gyros), b);
+    gyro_wfb = vec3_axpy(kp_a, w_meas_a, gyro_wfb);
+    gyro_wfb = vec3_axpy(kp_m, w_meas_m, gyro_wfb);
+
+    /* integrate q_dot = 1/2 q x [0 gyro_wfb] and normalize for stability */
+    quat_integrate(&q_att, gyro_wfb, dt);
+
+    /* integrate the bias from the integral feedback terms */
+    b = vec3_axpy(-ki_a * dt, w_meas_a, b);
+    b = vec3_axpy(-ki_m * dt, w_meas_m, b);
+
+    /* update the filter state */
+    vec3_store(b, b_plus);
+    vec3_store(b, b_minus);
+    quat_store(q_att, q_plus);
+    quat_store(q_att, q_minus);
 
     /* set external attitude and bias*/
-    bias[0] = b_plus[0];
-    bias[1] = b_plus[1];
-    bias[2] = b_plus[2];
-    q[0] = q_plus[0];
-    q[1] = q_plus[1];
-    q[2] = q_plus[2];
-    q[3] = q_plus[3];
+    vec3_store(b, bias);
+    quat_store(q_att, q);
 }
 
 
@@ -266,59 +209,6 @@ void AHRS_update(float accels[MSZ], float mags[MSZ], float gyros[MSZ],
  * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
  ******************************************************************************/
 
-/**
- * @function quat2euler()
- * @param q A quaternion
- * @param euler a vector of euler angles in [psi, theta, roll] order
- */
-static void quat2euler(float q[MSZ], float euler[MSZ]) {
-    float q00 = q[0] * q[0];
-    float q11 = q[1] * q[1];
-    float q22 = q[2] * q[2];
-    float q33 = q[3] * q[3];
-
-    // psi
-    euler[0] = atan2(2.0 * (q[1] * q[2] + q[0] * q[3]), ((q00 + q11 - q22 - q33)));
-    // theta
-    euler[1] = asin(2.0 * (q[0] * q[2] - q[1] * q[3]));
-    // phi
-    euler[2] = atan2(2.0 * (q[2] * q[3] + q[0] * q[1]), q00 - q11 - q22 + q33);
-}
-
-/**
- * @function q_rot_v_q()
- * Rotate a vector from the inertial frame to the body frame
- * @param v_i, a 3space vector in the inertial frame
- * @param q an attitude quaternion
- * sets v_b to the rotated inertial vector in the body frame
- */
-static void q_rot_v_q(float v_i[MSZ], float q[QSZ], float v_b[MSZ]) {
-    float q_i[QSZ];
-    float q_temp[QSZ];
-    float q_conj[QSZ];
-    float q_b[QSZ]; // container for inertial vector in body frame as pure quaternion
-
-    // calculate conjugate of q 
-    q_conj[0] = q[0];
-    q_conj[1] = -q[1];
-    q_conj[2] = -q[2];
-    q_conj[3] = -q[3];
-
-    //   convert v_i to a pure quaternion --> q_i
-    q_i[0] = 0;
-    q_i[1] = v_i[0];
-    q_i[2] = v_i[1];
-    q_i[3] = v_i[2];
-    //   first quaternion product q_i by q --> q_temp
-    lin_alg_q_mult(q_i, q, q_temp);
-    //   second quaternion product q_conj by q_temp -->q_b
-    lin_alg_q_mult(q_conj, q_temp, q_b);
-    //    set v_b to imaginary part of q_b
-    v_b[0] = q_b[1];
-    v_b[1] = q_b[2];
-    v_b[2] = q_b[3];
-}
-
 /**
  * @function v_copy()
  * @param v_in the vector to be copied
@@ -332,19 +222,15 @@ static void v_copy(float v_in[MSZ], float v_out[MSZ]) {
     }
 }
 
-/**
- * @function m_norm()
- * @param M A matrix
- * @return The magnitude of the M, m_norm
- */
-static float m_norm(float M[MSZ]) {
-    return ((float) sqrt(M[0] * M[0] + M[1] * M[1] + M[2] * M[2]));
-}
-
 
 
 
 #ifdef AHRS_TESTING
+#include <xc.h>
+#include "ICM_20948.h"  
+#include "ICM_20948_registers.h" 
+#include "SerialM32.h"
+#include "System_timer.h"
 
 #define MEAS_PERIOD 20 // measurement period in msec
 #define DT 0.02 
@@ -483,7 +369,7 @@ int main(void) {
             update_start = Sys_timer_get_usec();
             AHRS_update(acc_cal, mag_cal, gyro_cal, dt, q_test, bias_test);
             update_end = Sys_timer_get_usec();
-            quat2euler(q_test, euler_test);
+            lin_alg_quat2euler(q_test, euler_test);
             printf("%+3.1f, %+3.1f, %+3.1f, ", euler_test[0] * rad2deg, euler_test[1] * rad2deg, euler_test[2] * rad2deg);
             printf("%+1.3e, %+1.3e, %+1.3e, ", bias_test[0], bias_test[1], bias_test[2]);
             printf("%d\r\n", update_end - update_start);
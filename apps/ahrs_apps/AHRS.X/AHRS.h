@@ -16,7 +16,7 @@
  ******************************************************************************/
 
 #include <stdint.h>
-#include "lin_alg_float.h"
+#include "Lin_alg_float.h"
 
 /*******************************************************************************
  * PUBLIC #DEFINES                                                             *
@@ -73,6 +73,18 @@ void AHRS_get_filter_gains(float *kp_a_get, float *ki_a_get, float *kp_m, float
  * @modified */
 void AHRS_set_filter_gains(float kp_a_set, float ki_a_set, float kp_m_set, float ki_m_set);
 
+/**
+ * @Function AHRS_set_state(float q_set[QSZ], float bias_set[MSZ])
+ * @param q_set, attitude quaternion to restart the filter from
+ * @param bias_set, gyro bias estimate to restart the filter from
+ * @return none
+ * @brief overwrites the filter state, used to restart the filter between
+ * replays and after calibration
+ * @note 
+ * @author Aaron Hunter, 10/16/2026
+ * @modified */
+void AHRS_set_state(float q_set[QSZ], float bias_set[MSZ]);
+
 /**
  * @Function AHRS_update
  * @param IMU data in the form of three axis
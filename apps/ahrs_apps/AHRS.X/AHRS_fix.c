@@ -0,0 +1,668 @@
+/** Attitude Heading Reference System, fixed point
+ * File:   AHRS_fix.c
+ * Brief: Fixed point (Q-format) implementation of the Mahoney complementary
+ * filter in AHRS.c.  The PIC32MX has no FPU so every float operation in
+ * AHRS_update() is a soft-float library call; here the whole update step is
+ * done with 32 bit multiplies and 64 bit accumulates, no divides.  The
+ * cycles this saves on the PIC32 have not been measured yet, the board test
+ * below prints them.
+ * Created on 10/16/2026
+ * Modified on 10/17/2026
+ *
+ * Board test (PIC32 cycles of both updates on live IMU data): in the AHRS.X
+ * project replace the AHRS_TESTING preprocessor macro with AHRS_FIX_TESTING,
+ * build and read the reports on the USB serial port.
+ *
+ * Host test (compare against AHRS_update() over a recorded HIGHRES_IMU log):
+ * gcc -O2 -DAHRS_FIX_TESTING -I../../../lib/Board.X -I../../../lib/Lin_alg.X
+ *  AHRS_fix.c AHRS.c ../../../lib/Lin_alg.X/Lin_alg_float.c
+ *  ../../../lib/Lin_alg.X/Fast_math.c -lm -o ahrs_fix
+ * ./ahrs_fix ../../../python/imu_tmbl_072621.csv
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdint.h>
+#include "AHRS_fix.h"
+#include "Board.h"
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#define RSQRT_SEED_SHIFT 24 // m >> 24 indexes the seed table, m in [2^28, 2^30)
+#define RSQRT_SEED_FIRST 16
+#define RSQRT_STEPS 2 // Newton steps, the seed is within 1.6 %
+
+/*******************************************************************************
+ * PRIVATE TYPEDEFS                                                            *
+ ******************************************************************************/
+// attitude quaternion
+static q30_t q_minus[QSZ] = {Q30_ONE, 0, 0, 0};
+// gyro bias vector, kept in Q1.30 so the small integral steps are not lost
+static q30_t b_minus[MSZ] = {0, 0, 0};
+
+/*filter gains*/
+static q16_t kp_a = FLOAT_TO_Q16(2.5); //accelerometer proportional gain
+static q16_t ki_a = FLOAT_TO_Q16(0.05); // accelerometer integral gain
+static q16_t kp_m = FLOAT_TO_Q16(2.5); // magnetometer proportional gain
+static q16_t ki_m = FLOAT_TO_Q16(0.05); //magnetometer integral gain
+
+/* gravity inertial vector */
+static q30_t a_i[MSZ] = {0, 0, Q30_ONE};
+
+/* Earth's magnetic field inertial vector at 37 N, 122 W, normalized, ENU
+ * see AHRS.c */
+static q30_t m_i[MSZ] = {
+    FLOAT_TO_Q30(0.110011998753301),
+    FLOAT_TO_Q30(0.478219898291142),
+    FLOAT_TO_Q30(-0.871322609031072)
+};
+
+/* 1/sqrt(m) in Q1.30 at the middle of each 1/64 of m in [0.25, 1) */
+static const uint32_t rsqrt_seed[] = {
+    2114695713U, 2053387115U, 1997119227U, 1945237133U,
+    1897199172U, 1852552937U, 1810917218U, 1771968208U,
+    1735428857U, 1701060526U, 1668656406U, 1638036256U,
+    1609042172U, 1581535151U, 1555392273U, 1530504391U,
+    1506774204U, 1484114654U, 1462447584U, 1441702596U,
+    1421816090U, 1402730445U, 1384393311U, 1366757007U,
+    1349778000U, 1333416450U, 1317635818U, 1302402522U,
+    1287685637U, 1273456629U, 1259689126U, 1246358707U,
+    1233442724U, 1220920139U, 1208771378U, 1196978204U,
+    1185523604U, 1174391680U, 1163567563U, 1153037323U,
+    1142787899U, 1132807028U, 1123083182U, 1113605518U,
+    1104363818U, 1095348453U, 1086550331U, 1077960865U
+};
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                *
+ ******************************************************************************/
+/**
+ * @function q30_q_mult()
+ * @param q, p Q1.30 quaternions
+ * @param r the Hamilton product q x p, same ordering as lin_alg_q_mult()
+ */
+static void q30_q_mult(q30_t q[QSZ], q30_t p[QSZ], q30_t r[QSZ]);
+/**
+ * @function q30_rot_v_q()
+ * Rotate a unit vector from the inertial frame to the body frame
+ * @param v_i, a Q1.30 vector in the inertial frame
+ * @param q a Q1.30 attitude quaternion
+ * sets v_b to the rotated inertial vector in the body frame
+ */
+static void q30_rot_v_q(q30_t v_i[MSZ], q30_t q[QSZ], q30_t v_b[MSZ]);
+/**
+ * @function q30_cross()
+ * @param u, v Q1.30 vectors
+ * @param w the cross product u x v
+ */
+static void q30_cross(q30_t u[MSZ], q30_t v[MSZ], q30_t w[MSZ]);
+/**
+ * @function q16_v_normalize()
+ * @param v_in a Q16.16 vector of any magnitude
+ * @param v_out the unit vector in Q1.30
+ * @return SUCCESS or ERROR if v_in is the zero vector
+ */
+static int8_t q16_v_normalize(q16_t v_in[MSZ], q30_t v_out[MSZ]);
+/**
+ * @function q30_rsqrt()
+ * @param m in Q1.30, in [0.25, 1)
+ * @return 1/sqrt(m) in unsigned Q2.30, a table seed and RSQRT_STEPS Newton
+ * steps, only 32 x 32 bit multiplies
+ */
+static uint32_t q30_rsqrt(uint32_t m);
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function AHRS_fix_get_mag_inertial(float mag_i[MSZ])
+ * @param mag_i, vector to receive the magnetic aiding vector
+ * @return none
+ * @brief returns the normalized local magnetic field (ENU) used by the filter
+ * @author Aaron Hunter, 10/16/2026
+ * @modified */
+void AHRS_fix_get_mag_inertial(float mag_i[MSZ]) {
+    mag_i[0] = Q30_TO_FLOAT(m_i[0]);
+    mag_i[1] = Q30_TO_FLOAT(m_i[1]);
+    mag_i[2] = Q30_TO_FLOAT(m_i[2]);
+}
+
+/**
+ * @Function AHRS_fix_set_mag_inertial(float mag_i[MSZ])
+ * @param mag_i, vector with normalized local magnetic field strength (ENU)
+ * @return none
+ * @brief converts and stores the magnetic aiding vector
+ * @author Aaron Hunter, 10/16/2026
+ * @modified */
+void AHRS_fix_set_mag_inertial(float mag_i[MSZ]) {
+    m_i[0] = FLOAT_TO_Q30(mag_i[0]);
+    m_i[1] = FLOAT_TO_Q30(mag_i[1]);
+    m_i[2] = FLOAT_TO_Q30(mag_i[2]);
+}
+
+/**
+ * @Function AHRS_fix_get_filter_gains(float *kp_a_get, float *ki_a_get,
+ * float *kp_m_get, float *ki_m_get)
+ * @param pointers to receive the current filter gains
+ * @return none
+ * @author Aaron Hunter, 10/16/2026
+ * @modified */
+void AHRS_fix_get_filter_gains(float *kp_a_get, float *ki_a_get, float *kp_m_get, float *ki_m_get) {
+    *kp_a_get = Q16_TO_FLOAT(kp_a);
+    *ki_a_get = Q16_TO_FLOAT(ki_a);
+    *kp_m_get = Q16_TO_FLOAT(kp_m);
+    *ki_m_get = Q16_TO_FLOAT(ki_m);
+}
+
+/**
+ * @Function AHRS_fix_set_filter_gains(float kp_a_set, float ki_a_set,
+ * float kp_m_set, float ki_m_set)
+ * @param filter gains
+ * @return none
+ * @brief converts the gains to Q16.16 and stores them
+ * @author Aaron Hunter, 10/16/2026
+ * @modified */
+void AHRS_fix_set_filter_gains(float kp_a_set, float ki_a_set, float kp_m_set, float ki_m_set) {
+    kp_a = FLOAT_TO_Q16(kp_a_set);
+    ki_a = FLOAT_TO_Q16(ki_a_set);
+    kp_m = FLOAT_TO_Q16(kp_m_set);
+    ki_m = FLOAT_TO_Q16(ki_m_set);
+}
+
+/**
+ * @Function AHRS_fix_update_q(q16_t accels[MSZ], q16_t mags[MSZ],
+ * q16_t gyros[MSZ], q30_t dt, q30_t q[QSZ], q30_t bias[MSZ])
+ * @param accels, mags three axis measurements in Q16.16, any scale
+ * @param gyros, gyro rates in rad/sec, Q16.16
+ * @param dt, the integration time in seconds, Q1.30
+ * @return attitude quaternion and gyro bias vector (x,y,z) in Q1.30
+ * @brief complementary filter update step entirely in integer arithmetic
+ * @note measurement vectors are not modified
+ * @author Aaron Hunter, 10/16/2026
+ * @modified */
+void AHRS_fix_update_q(q16_t accels[MSZ], q16_t mags[MSZ], q16_t gyros[MSZ],
+        q30_t dt, q30_t q[QSZ], q30_t bias[MSZ]) {
+    q30_t acc_u[MSZ]; // normalized accelerometer vector
+    q30_t mag_u[MSZ]; // normalized magnetometer vector
+    q30_t a_b[MSZ]; //estimated gravity vector in body frame
+    q30_t m_b[MSZ]; //estimated magnetic field vector in body frame
+    q30_t w_a[MSZ]; // accelerometer correction direction
+    q30_t w_m[MSZ]; // magnetometer correction direction
+    q16_t gyro_wfb[MSZ]; // gyro 'rate' after feedback
+    q30_t half_theta[QSZ]; // half of the integrated rate as a pure quaternion
+    q30_t q_delta[QSZ]; // q_minus x half_theta
+    int64_t n2;
+    int64_t scale;
+    int64_t b_step;
+    int8_t acc_valid;
+    int8_t mag_valid;
+    uint8_t i;
+
+    /* normalize inertial measurements, a zero vector gives no correction */
+    acc_valid = q16_v_normalize(accels, acc_u);
+    mag_valid = q16_v_normalize(mags, mag_u);
+
+    /*Accelerometer attitude calculations */
+    if (acc_valid == SUCCESS) {
+        q30_rot_v_q(a_i, q_minus, a_b); //estimate gravity vector in body frame
+        q30_cross(acc_u, a_b, w_a); // calculate the accelerometer rate term
+    } else {
+        w_a[0] = w_a[1] = w_a[2] = 0;
+    }
+
+    /*Magnetometer attitude calculations*/
+    if (mag_valid == SUCCESS) {
+        q30_rot_v_q(m_i, q_minus, m_b); //estimate magnetic field vector in body frame
+        q30_cross(mag_u, m_b, w_m); // calculate the magnetometer rate term
+    } else {
+        w_m[0] = w_m[1] = w_m[2] = 0;
+    }
+
+    for (i = 0; i < MSZ; i++) {
+        /* total rate term: gyro - bias + kp_a * w_a + kp_m * w_m, Q16.16 */
+        gyro_wfb[i] = gyros[i] - (b_minus[i] >> (Q30_SHIFT - Q16_SHIFT))
+                + (q16_t) (((int64_t) kp_a * w_a[i]) >> Q30_SHIFT)
+                + (q16_t) (((int64_t) kp_m * w_m[i]) >> Q30_SHIFT);
+        /* integral of the bias, ki (Q16) * w (Q30) * dt (Q30) -> Q30 */
+        b_step = ((((int64_t) ki_a * w_a[i]) >> Q16_SHIFT) +
+                (((int64_t) ki_m * w_m[i]) >> Q16_SHIFT));
+        b_minus[i] -= (q30_t) ((b_step * dt) >> Q30_SHIFT);
+        /* 0.5 * gyro_wfb * dt: Q16 * Q30 = Q46, one more shift for the half */
+        half_theta[i + 1] = (q30_t) (((int64_t) gyro_wfb[i] * dt) >> (Q16_SHIFT + 1));
+    }
+    half_theta[0] = 0;
+
+    /* q_plus = q_minus + 0.5 * q_minus x w * dt */
+    q30_q_mult(q_minus, half_theta, q_delta);
+    for (i = 0; i < QSZ; i++) {
+        q_minus[i] += q_delta[i];
+    }
+
+    /* normalize with one Newton step of 1/sqrt(n2) about 1, (3 - n2) / 2,
+     * the norm only drifts by |half_theta|^2 per step */
+    n2 = 0;
+    for (i = 0; i < QSZ; i++) {
+        n2 += (int64_t) q_minus[i] * q_minus[i];
+    }
+    n2 >>= Q30_SHIFT;
+    scale = ((3LL << Q30_SHIFT) - n2) >> 1;
+    for (i = 0; i < QSZ; i++) {
+        q_minus[i] = (q30_t) ((q_minus[i] * scale) >> Q30_SHIFT);
+    }
+
+    /* set external attitude and bias*/
+    for (i = 0; i < QSZ; i++) {
+        q[i] = q_minus[i];
+    }
+    for (i = 0; i < MSZ; i++) {
+        bias[i] = b_minus[i];
+    }
+}
+
+/**
+ * @Function AHRS_fix_update(float accels[MSZ], float mags[MSZ],
+ * float gyros[MSZ], float dt, float q[QSZ], float bias[MSZ])
+ * @param IMU data in the form of three axis magnetometer and accelerometer
+ * arrays, gyro data in rad/sec
+ * @param dt, the integration time in seconds
+ * @return attitude quaternion and gyro biases vector (x,y,z)
+ * @brief drop in replacement for AHRS_update(), converts the arguments and
+ * calls AHRS_fix_update_q()
+ * @note unlike AHRS_update() the measurement vectors are not normalized in
+ * place
+ * @author Aaron Hunter, 10/16/2026
+ * @modified */
+void AHRS_fix_update(float accels[MSZ], float mags[MSZ], float gyros[MSZ],
+        float dt, float q[QSZ], float bias[MSZ]) {
+    q16_t acc_q[MSZ];
+    q16_t mag_q[MSZ];
+    q16_t gyro_q[MSZ];
+    q30_t q_q[QSZ];
+    q30_t bias_q[MSZ];
+    uint8_t i;
+
+    for (i = 0; i < MSZ; i++) {
+        acc_q[i] = FLOAT_TO_Q16(accels[i]);
+        mag_q[i] = FLOAT_TO_Q16(mags[i]);
+        gyro_q[i] = FLOAT_TO_Q16(gyros[i]);
+    }
+    AHRS_fix_update_q(acc_q, mag_q, gyro_q, FLOAT_TO_Q30(dt), q_q, bias_q);
+    for (i = 0; i < QSZ; i++) {
+        q[i] = Q30_TO_FLOAT(q_q[i]);
+    }
+    for (i = 0; i < MSZ; i++) {
+        bias[i] = Q30_TO_FLOAT(bias_q[i]);
+    }
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/**
+ * @function q30_q_mult()
+ * @param q, p Q1.30 quaternions
+ * @param r the Hamilton product q x p, same ordering as lin_alg_q_mult()
+ */
+static void q30_q_mult(q30_t q[QSZ], q30_t p[QSZ], q30_t r[QSZ]) {
+    r[0] = (q30_t) (((int64_t) p[0] * q[0] - (int64_t) p[1] * q[1]
+            - (int64_t) p[2] * q[2] - (int64_t) p[3] * q[3]) >> Q30_SHIFT);
+    r[1] = (q30_t) (((int64_t) p[1] * q[0] + (int64_t) p[0] * q[1]
+            + (int64_t) p[3] * q[2] - (int64_t) p[2] * q[3]) >> Q30_SHIFT);
+    r[2] = (q30_t) (((int64_t) p[2] * q[0] - (int64_t) p[3] * q[1]
+            + (int64_t) p[0] * q[2] + (int64_t) p[1] * q[3]) >> Q30_SHIFT);
+    r[3] = (q30_t) (((int64_t) p[3] * q[0] + (int64_t) p[2] * q[1]
+            - (int64_t) p[1] * q[2] + (int64_t) p[0] * q[3]) >> Q30_SHIFT);
+}
+
+/**
+ * @function q30_rot_v_q()
+ * Rotate a unit vector from the inertial frame to the body frame
+ * @param v_i, a Q1.30 vector in the inertial frame
+ * @param q a Q1.30 attitude quaternion
+ * sets v_b to the rotated inertial vector in the body frame
+ */
+static void q30_rot_v_q(q30_t v_i[MSZ], q30_t q[QSZ], q30_t v_b[MSZ]) {
+    q30_t q_i[QSZ];
+    q30_t q_temp[QSZ];
+    q30_t q_conj[QSZ];
+    q30_t q_b[QSZ];
+
+    q_conj[0] = q[0];
+    q_conj[1] = -q[1];
+    q_conj[2] = -q[2];
+    q_conj[3] = -q[3];
+
+    q_i[0] = 0;
+    q_i[1] = v_i[0];
+    q_i[2] = v_i[1];
+    q_i[3] = v_i[2];
+    // same product order as q_rot_v_q() in AHRS.c
+    q30_q_mult(q_i, q, q_temp);
+    q30_q_mult(q_conj, q_temp, q_b);
+    v_b[0] = q_b[1];
+    v_b[1] = q_b[2];
+    v_b[2] = q_b[3];
+}
+
+/**
+ * @function q30_cross()
+ * @param u, v Q1.30 vectors
+ * @param w the cross product u x v
+ */
+static void q30_cross(q30_t u[MSZ], q30_t v[MSZ], q30_t w[MSZ]) {
+    w[0] = (q30_t) (((int64_t) u[1] * v[2] - (int64_t) u[2] * v[1]) >> Q30_SHIFT);
+    w[1] = (q30_t) (((int64_t) u[2] * v[0] - (int64_t) u[0] * v[2]) >> Q30_SHIFT);
+    w[2] = (q30_t) (((int64_t) u[0] * v[1] - (int64_t) u[1] * v[0]) >> Q30_SHIFT);
+}
+
+/**
+ * @function q16_v_normalize()
+ * @param v_in a Q16.16 vector of any magnitude
+ * @param v_out the unit vector in Q1.30
+ * @return SUCCESS or ERROR if v_in is the zero vector
+ */
+static int8_t q16_v_normalize(q16_t v_in[MSZ], q30_t v_out[MSZ]) {
+    uint64_t sum_sq; // Q32.32
+    int32_t inv_norm; // Q2.29 mantissa of 1/|v|
+    int8_t k = 0; // |v|^2 = m * 4^(k - 1), m in [0.25, 1)
+    uint8_t i;
+
+    sum_sq = 0;
+    for (i = 0; i < MSZ; i++) {
+        sum_sq += (uint64_t) ((int64_t) v_in[i] * v_in[i]);
+    }
+    if (sum_sq == 0) {
+        return ERROR;
+    }
+    /* scale by powers of four into [2^28, 2^30), shifts and no divide */
+    while (sum_sq >= (1ULL << Q30_SHIFT)) {
+        sum_sq >>= 2;
+        k++;
+    }
+    while (sum_sq < (1ULL << (Q30_SHIFT - 2))) {
+        sum_sq <<= 2;
+        k--;
+    }
+    /* 1/|v| = rsqrt(m) * 2^(1 - k), so v (Q16) * rsqrt (Q29) >> (14 + k) is
+     * the unit vector in Q30, k is at least -14 */
+    inv_norm = (int32_t) (q30_rsqrt((uint32_t) sum_sq) >> 1);
+    for (i = 0; i < MSZ; i++) {
+        v_out[i] = (q30_t) (((int64_t) v_in[i] * inv_norm) >> (14 + k));
+    }
+    return SUCCESS;
+}
+
+/**
+ * @function q30_rsqrt()
+ * @param m in Q1.30, in [0.25, 1)
+ * @return 1/sqrt(m) in unsigned Q2.30, a table seed and RSQRT_STEPS Newton
+ * steps, only 32 x 32 bit multiplies
+ */
+static uint32_t q30_rsqrt(uint32_t m) {
+    uint32_t y = rsqrt_seed[(m >> RSQRT_SEED_SHIFT) - RSQRT_SEED_FIRST];
+    uint32_t my; // m * y, about sqrt(m), at most one
+    uint32_t my2; // m * y^2, about one
+    uint8_t i;
+
+    /* y = y * (3 - m * y^2) / 2, m * y first so nothing passes 2^32 */
+    for (i = 0; i < RSQRT_STEPS; i++) {
+        my = (uint32_t) (((uint64_t) m * y) >> Q30_SHIFT);
+        my2 = (uint32_t) (((uint64_t) my * y) >> Q30_SHIFT);
+        y = (uint32_t) (((uint64_t) y * ((3UL << Q30_SHIFT) - my2)) >> (Q30_SHIFT + 1));
+    }
+    return y;
+}
+
+
+
+
+#ifdef AHRS_FIX_TESTING
+#include <math.h>
+#include "AHRS.h"
+
+/**
+ * Runs AHRS_update() and AHRS_fix_update() side by side on the same data and
+ * reports the attitude difference and the execution time of each. On the
+ * target the data is live from the IMU and time is measured with the core
+ * timer (one count per two SYSCLK cycles), the mean includes the interrupts
+ * that land in an update and the minimum does not; on a host the data is
+ * replayed from a HIGHRES_IMU csv log (python/mavcsv_logging.py) */
+
+/**
+ * @function q_angle_diff()
+ * @return the angle in degrees of the rotation between q1 and q2, from the
+ * vector and scalar parts of q1* x q2 in double: acos of the dot product in
+ * float cannot resolve less than a few hundredths of a degree
+ */
+static double q_angle_diff(float q1[QSZ], float q2[QSZ]) {
+    double w = (double) q1[0] * q2[0] + (double) q1[1] * q2[1]
+            + (double) q1[2] * q2[2] + (double) q1[3] * q2[3];
+    double x = (double) q1[0] * q2[1] - (double) q1[1] * q2[0]
+            - (double) q1[2] * q2[3] + (double) q1[3] * q2[2];
+    double y = (double) q1[0] * q2[2] + (double) q1[1] * q2[3]
+            - (double) q1[2] * q2[0] - (double) q1[3] * q2[1];
+    double z = (double) q1[0] * q2[3] - (double) q1[1] * q2[2]
+            + (double) q1[2] * q2[1] - (double) q1[3] * q2[0];
+
+    return 2.0 * atan2(sqrt(x * x + y * y + z * z), fabs(w)) * 180.0 / M_PI;
+}
+
+#ifdef __XC32
+#include <xc.h>
+#include "ICM_20948.h"
+#include "SerialM32.h"
+#include "System_timer.h"
+
+#define MEAS_PERIOD 20 // measurement period in msec
+#define DT 0.02
+#define REPORT_PERIOD 50 // updates between reports
+
+int main(void) {
+    uint32_t start_time = 0;
+    uint32_t current_time = 0;
+    uint32_t count_start;
+    uint32_t cycles;
+    uint32_t cycles_float = 0;
+    uint32_t cycles_fix = 0;
+    uint32_t min_float = UINT32_MAX;
+    uint32_t min_fix = UINT32_MAX;
+    uint32_t updates = 0;
+    float q_float[QSZ] = {1, 0, 0, 0};
+    float q_fix[QSZ] = {1, 0, 0, 0};
+    float bias_float[MSZ];
+    float bias_fix[MSZ];
+    float acc[MSZ];
+    float mag[MSZ];
+    float gyro[MSZ];
+    float acc_copy[MSZ];
+    float mag_copy[MSZ];
+    double err_max = 0;
+    double err;
+    const float deg2rad = M_PI / 180.0;
+    struct IMU_out IMU_data = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    uint8_t i;
+
+    Board_init();
+    Serial_init();
+    Sys_timer_init();
+    IMU_init(IMU_SPI_MODE);
+    printf("Fixed point AHRS comparison %s, %s. \r\n", __DATE__, __TIME__);
+
+    while (1) {
+        current_time = Sys_timer_get_msec();
+        if ((current_time - start_time) >= MEAS_PERIOD) {
+            IMU_start_data_acq();
+            start_time = current_time;
+        }
+        if (IMU_is_data_ready() == TRUE) {
+            IMU_get_norm_data(&IMU_data);
+            acc[0] = IMU_data.acc.x;
+            acc[1] = IMU_data.acc.y;
+            acc[2] = IMU_data.acc.z;
+            mag[0] = IMU_data.mag.x;
+            mag[1] = IMU_data.mag.y;
+            mag[2] = IMU_data.mag.z;
+            gyro[0] = IMU_data.gyro.x * deg2rad;
+            gyro[1] = IMU_data.gyro.y * deg2rad;
+            gyro[2] = IMU_data.gyro.z * deg2rad;
+            for (i = 0; i < MSZ; i++) {
+                acc_copy[i] = acc[i];
+                mag_copy[i] = mag[i];
+            }
+            count_start = Sys_timer_get_core();
+            AHRS_update(acc_copy, mag_copy, gyro, DT, q_float, bias_float);
+            cycles = 2 * (Sys_timer_get_core() - count_start);
+            cycles_float += cycles;
+            if (cycles < min_float) min_float = cycles;
+            count_start = Sys_timer_get_core();
+            AHRS_fix_update(acc, mag, gyro, DT, q_fix, bias_fix);
+            cycles = 2 * (Sys_timer_get_core() - count_start);
+            cycles_fix += cycles;
+            if (cycles < min_fix) min_fix = cycles;
+            err = q_angle_diff(q_float, q_fix);
+            if (err > err_max) err_max = err;
+            updates++;
+            if (updates == REPORT_PERIOD) {
+                printf("cycles float: %u (min %u) fix: %u (min %u), fix/float %u%%, max diff %.5f deg\r\n",
+                        cycles_float / updates, min_float, cycles_fix / updates,
+                        min_fix, (100 * min_fix) / min_float, err_max);
+                cycles_float = 0;
+                cycles_fix = 0;
+                min_float = UINT32_MAX;
+                min_fix = UINT32_MAX;
+                updates = 0;
+                err_max = 0;
+            }
+        }
+    }
+    return 0;
+}
+
+#else /* host build */
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LINE_LENGTH 512
+#define MAX_COLUMNS 32
+
+/**
+ * @function find_column()
+ * @return index of name in the comma separated header or -1
+ */
+static int find_column(char *header, const char *name) {
+    char copy[LINE_LENGTH];
+    char *token;
+    int column = 0;
+    strncpy(copy, header, LINE_LENGTH - 1);
+    copy[LINE_LENGTH - 1] = 0;
+    for (token = strtok(copy, ",\r\n"); token != NULL; token = strtok(NULL, ",\r\n")) {
+        if (strcmp(token, name) == 0) return column;
+        column++;
+    }
+    return -1;
+}
+
+static double now_nsec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    const char *names[] = {"time_usec", "xacc", "yacc", "zacc", "xgyro", "ygyro",
+        "zgyro", "xmag", "ymag", "zmag"};
+    int columns[10];
+    double fields[MAX_COLUMNS];
+    char line[LINE_LENGTH];
+    char *token;
+    FILE *log;
+    float gyro_scale = M_PI / 180.0; // HIGHRES_IMU gyros are in deg/sec
+    float q_float[QSZ] = {1, 0, 0, 0};
+    float q_fix[QSZ] = {1, 0, 0, 0};
+    float bias_float[MSZ];
+    float bias_fix[MSZ];
+    float acc[MSZ];
+    float mag[MSZ];
+    float gyro[MSZ];
+    float acc_copy[MSZ];
+    float mag_copy[MSZ];
+    float dt;
+    double err;
+    double err_max = 0;
+    double err_sum = 0;
+    double ns_float = 0;
+    double ns_fix = 0;
+    double t0;
+    double last_usec = -1;
+    long samples = 0;
+    int i;
+    int c;
+
+    if (argc < 2) {
+        printf("usage: %s imu_log.csv [gyro scale to rad/sec]\r\n", argv[0]);
+        return 1;
+    }
+    if (argc > 2) gyro_scale = atof(argv[2]);
+    log = fopen(argv[1], "r");
+    if (log == NULL || fgets(line, LINE_LENGTH, log) == NULL) {
+        printf("could not read %s\r\n", argv[1]);
+        return 1;
+    }
+    for (i = 0; i < 10; i++) {
+        columns[i] = find_column(line, names[i]);
+        if (columns[i] < 0) {
+            printf("column %s missing from %s\r\n", names[i], argv[1]);
+            return 1;
+        }
+    }
+    printf("Fixed point AHRS comparison %s, %s. \r\n", __DATE__, __TIME__);
+
+    while (fgets(line, LINE_LENGTH, log) != NULL) {
+        c = 0;
+        for (token = strtok(line, ","); token != NULL && c < MAX_COLUMNS; token = strtok(NULL, ",")) {
+            fields[c++] = atof(token);
+        }
+        for (i = 0; i < MSZ; i++) {
+            acc[i] = fields[columns[1 + i]];
+            gyro[i] = fields[columns[4 + i]] * gyro_scale;
+            mag[i] = fields[columns[7 + i]];
+            acc_copy[i] = acc[i];
+            mag_copy[i] = mag[i];
+        }
+        /* logs can be spliced together, fall back to the nominal period */
+        dt = (fields[columns[0]] - last_usec) * 1e-6;
+        if (last_usec < 0 || dt <= 0 || dt > 0.5) dt = 0.02;
+        last_usec = fields[columns[0]];
+
+        t0 = now_nsec();
+        AHRS_update(acc_copy, mag_copy, gyro, dt, q_float, bias_float);
+        ns_float += now_nsec() - t0;
+        t0 = now_nsec();
+        AHRS_fix_update(acc, mag, gyro, dt, q_fix, bias_fix);
+        ns_fix += now_nsec() - t0;
+
+        err = q_angle_diff(q_float, q_fix);
+        err_sum += err;
+        if (err > err_max) err_max = err;
+        samples++;
+    }
+    fclose(log);
+    if (samples == 0) return 1;
+    printf("samples: %ld\r\n", samples);
+    printf("attitude difference mean: %.5f deg, max: %.5f deg\r\n", err_sum / samples, err_max);
+    printf("bias float: %+1.3e %+1.3e %+1.3e\r\n", bias_float[0], bias_float[1], bias_float[2]);
+    printf("bias fix:   %+1.3e %+1.3e %+1.3e\r\n", bias_fix[0], bias_fix[1], bias_fix[2]);
+    printf("host time per update float: %.1f ns, fix: %.1f ns\r\n",
+            ns_float / samples, ns_fix / samples);
+    printf("note: host times only, the host has a hardware FPU and says nothing\r\n"
+            "about PIC32 cycles, build with XC32 and run on the board for those\r\n");
+    return 0;
+}
+#endif /* __XC32 */
+#endif /* AHRS_FIX_TESTING */
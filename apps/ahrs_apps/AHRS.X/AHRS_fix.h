@@ -0,0 +1,120 @@
+/* ************************************************************************** */
+/** Attitude Heading Reference System, fixed point
+ * File:   AHRS_fix.h
+ * Brief: Fixed point (Q-format) implementation of the Mahoney complementary
+ * filter in AHRS.c for processors without a floating point unit
+ * Created on 10/16/2026
+ * Modified on
+ */
+/* ************************************************************************** */
+
+#ifndef AHRS_FIX_H    /* Guard against multiple inclusion */
+#define AHRS_FIX_H
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include "Lin_alg_float.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+/* Q formats: unit quantities (quaternions, normalized vectors, bias, dt) are
+ * carried in Q1.30, rates, gains and raw measurements in Q16.16 */
+#define Q30_SHIFT 30
+#define Q16_SHIFT 16
+#define Q30_ONE ((q30_t) 1 << Q30_SHIFT)
+#define Q16_ONE ((q16_t) 1 << Q16_SHIFT)
+
+/* conversions, use only at the API boundary or for constants */
+#define FLOAT_TO_Q30(x) ((q30_t) ((x) * 1073741824.0))
+#define Q30_TO_FLOAT(x) ((float) (x) * 9.31322574615479e-10)
+#define FLOAT_TO_Q16(x) ((q16_t) ((x) * 65536.0))
+#define Q16_TO_FLOAT(x) ((float) (x) * 1.52587890625e-05)
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+/* The formats are held in plain integers rather than the <stdfix.h> types so
+ * the same source builds with XC32 and with a host compiler for testing */
+typedef int32_t q30_t; // signed Q1.30, range [-2, 2), lsb 9.3e-10
+typedef int32_t q16_t; // signed Q16.16, range [-32768, 32768), lsb 1.5e-5
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function AHRS_fix_get_mag_inertial(float mag_i[MSZ])
+ * @param mag_i, vector to receive the magnetic aiding vector
+ * @return none
+ * @brief returns the normalized local magnetic field (ENU) used by the filter
+ * @author Aaron Hunter, 10/16/2026
+ * @modified */
+void AHRS_fix_get_mag_inertial(float mag_i[MSZ]);
+
+/**
+ * @Function AHRS_fix_set_mag_inertial(float mag_i[MSZ])
+ * @param mag_i, vector with normalized local magnetic field strength (ENU)
+ * @return none
+ * @brief converts and stores the magnetic aiding vector
+ * @author Aaron Hunter, 10/16/2026
+ * @modified */
+void AHRS_fix_set_mag_inertial(float mag_i[MSZ]);
+
+/**
+ * @Function AHRS_fix_get_filter_gains(float *kp_a_get, float *ki_a_get,
+ * float *kp_m_get, float *ki_m_get)
+ * @param pointers to receive the current filter gains
+ * @return none
+ * @author Aaron Hunter, 10/16/2026
+ * @modified */
+void AHRS_fix_get_filter_gains(float *kp_a_get, float *ki_a_get, float *kp_m_get, float *ki_m_get);
+
+/**
+ * @Function AHRS_fix_set_filter_gains(float kp_a_set, float ki_a_set,
+ * float kp_m_set, float ki_m_set)
+ * @param filter gains
+ * @return none
+ * @brief converts the gains to Q16.16 and stores them
+ * @author Aaron Hunter, 10/16/2026
+ * @modified */
+void AHRS_fix_set_filter_gains(float kp_a_set, float ki_a_set, float kp_m_set, float ki_m_set);
+
+/**
+ * @Function AHRS_fix_update_q(q16_t accels[MSZ], q16_t mags[MSZ],
+ * q16_t gyros[MSZ], q30_t dt, q30_t q[QSZ], q30_t bias[MSZ])
+ * @param accels, mags three axis measurements in Q16.16, any scale
+ * @param gyros, gyro rates in rad/sec, Q16.16
+ * @param dt, the integration time in seconds, Q1.30
+ * @return attitude quaternion and gyro bias vector (x,y,z) in Q1.30
+ * @brief complementary filter update step entirely in integer arithmetic
+ * @note measurement vectors are not modified
+ * @author Aaron Hunter, 10/16/2026
+ * @modified */
+void AHRS_fix_update_q(q16_t accels[MSZ], q16_t mags[MSZ], q16_t gyros[MSZ],
+        q30_t dt, q30_t q[QSZ], q30_t bias[MSZ]);
+
+/**
+ * @Function AHRS_fix_update(float accels[MSZ], float mags[MSZ],
+ * float gyros[MSZ], float dt, float q[QSZ], float bias[MSZ])
+ * @param IMU data in the form of three axis magnetometer and accelerometer
+ * arrays, gyro data in rad/sec
+ * @param dt, the integration time in seconds
+ * @return attitude quaternion and gyro biases vector (x,y,z)
+ * @brief drop in replacement for AHRS_update(), converts the arguments and
+ * calls AHRS_fix_update_q()
+ * @note unlike AHRS_update() the measurement vectors are not normalized in
+ * place
+ * @author Aaron Hunter, 10/16/2026
+ * @modified */
+void AHRS_fix_update(float accels[MSZ], float mags[MSZ], float gyros[MSZ],
+        float dt, float q[QSZ], float bias[MSZ]);
+
+#endif /* AHRS_FIX_H */
+
+/* *****************************************************************************
+ End of File
+ */
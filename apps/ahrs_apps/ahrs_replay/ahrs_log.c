@@ -0,0 +1,182 @@
+/*
+ * File:   ahrs_log.c
+ * Brief: Loads recorded IMU streams (csv logs written by
+ * python/mavcsv_logging.py) into memory for host side replay of the AHRS
+ * filters
+ * Created on 10/16/2026
+ * Modified on
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+
+#include "ahrs_log.h"
+#include "Board.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#define LINE_LENGTH 1024
+#define MAX_COLUMNS 64
+#define NUM_FIELDS 10
+#define INITIAL_SIZE 4096
+
+/*******************************************************************************
+ * PRIVATE TYPEDEFS                                                            *
+ ******************************************************************************/
+static const char *field_names[NUM_FIELDS] = {"time_usec", "xacc", "yacc",
+    "zacc", "xgyro", "ygyro", "zgyro", "xmag", "ymag", "zmag"};
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                *
+ ******************************************************************************/
+/**
+ * @Function split_line(char *line, char *fields[MAX_COLUMNS])
+ * @param line, comma separated line, modified in place
+ * @param fields, pointers to the start of each field
+ * @return number of fields
+ * @note empty fields are kept so the column indices stay aligned */
+static int split_line(char *line, char *fields[MAX_COLUMNS]);
+
+/**
+ * @Function ahrs_log_grow(struct ahrs_log *log, long size)
+ * @return SUCCESS or ERROR */
+static int8_t ahrs_log_grow(struct ahrs_log *log, long size);
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function ahrs_log_load(const char *file_name, float gyro_scale,
+ * struct ahrs_log *log)
+ * @param file_name, csv with time_usec, [xyz]acc, [xyz]gyro, [xyz]mag columns
+ * @param gyro_scale, multiplier to convert the gyro column to rad/sec
+ * @param log, the log to fill
+ * @return SUCCESS or ERROR
+ * @brief reads the whole file into memory so replay is not bound by parsing
+ * @author Aaron Hunter */
+int8_t ahrs_log_load(const char *file_name, float gyro_scale, struct ahrs_log *log) {
+    char line[LINE_LENGTH];
+    char *fields[MAX_COLUMNS];
+    int columns[NUM_FIELDS];
+    int num_fields;
+    int i;
+    long size = 0;
+    double usec;
+    double last_usec = -1;
+    FILE *file;
+
+    memset(log, 0, sizeof (*log));
+    log->name = file_name;
+    file = fopen(file_name, "r");
+    if (file == NULL) {
+        return ERROR;
+    }
+    if (fgets(line, LINE_LENGTH, file) == NULL) {
+        fclose(file);
+        return ERROR;
+    }
+    num_fields = split_line(line, fields);
+    for (i = 0; i < NUM_FIELDS; i++) {
+        for (columns[i] = 0; columns[i] < num_fields; columns[i]++) {
+            if (strcmp(fields[columns[i]], field_names[i]) == 0) break;
+        }
+        if (columns[i] == num_fields) {
+            fprintf(stderr, "%s: missing column %s\n", file_name, field_names[i]);
+            fclose(file);
+            return ERROR;
+        }
+    }
+    while (fgets(line, LINE_LENGTH, file) != NULL) {
+        if (split_line(line, fields) < num_fields) continue;
+        if (log->length == size) {
+            size = size ? 2 * size : INITIAL_SIZE;
+            if (ahrs_log_grow(log, size) == ERROR) {
+                fclose(file);
+                ahrs_log_free(log);
+                return ERROR;
+            }
+        }
+        usec = atof(fields[columns[0]]);
+        /* logs are often spliced together, fall back to the nominal period */
+        log->dt[log->length] = (usec - last_usec) * 1e-6;
+        if (last_usec < 0 || log->dt[log->length] <= 0 || log->dt[log->length] > 0.5) {
+            log->dt[log->length] = AHRS_LOG_NOMINAL_DT;
+        }
+        last_usec = usec;
+        for (i = 0; i < MSZ; i++) {
+            log->acc[log->length][i] = atof(fields[columns[1 + i]]);
+            log->gyro[log->length][i] = atof(fields[columns[4 + i]]) * gyro_scale;
+            log->mag[log->length][i] = atof(fields[columns[7 + i]]);
+        }
+        log->length++;
+    }
+    fclose(file);
+    return log->length > 0 ? SUCCESS : ERROR;
+}
+
+/**
+ * @Function ahrs_log_free(struct ahrs_log *log)
+ * @param log, a log filled by ahrs_log_load()
+ * @return none
+ * @author Aaron Hunter */
+void ahrs_log_free(struct ahrs_log *log) {
+    free(log->dt);
+    free(log->acc);
+    free(log->gyro);
+    free(log->mag);
+    log->dt = NULL;
+    log->acc = NULL;
+    log->gyro = NULL;
+    log->mag = NULL;
+    log->length = 0;
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/**
+ * @Function split_line(char *line, char *fields[MAX_COLUMNS])
+ * @param line, comma separated line, modified in place
+ * @param fields, pointers to the start of each field
+ * @return number of fields
+ * @note empty fields are kept so the column indices stay aligned */
+static int split_line(char *line, char *fields[MAX_COLUMNS]) {
+    int count = 0;
+    fields[count++] = line;
+    for (; *line != '\0' && count < MAX_COLUMNS; line++) {
+        if (*line == ',') {
+            *line = '\0';
+            fields[count++] = line + 1;
+        } else if (*line == '\r' || *line == '\n') {
+            *line = '\0';
+            break;
+        }
+    }
+    return count;
+}
+
+/**
+ * @Function ahrs_log_grow(struct ahrs_log *log, long size)
+ * @return SUCCESS or ERROR */
+static int8_t ahrs_log_grow(struct ahrs_log *log, long size) {
+    void *dt = realloc(log->dt, size * sizeof (*log->dt));
+    void *acc = realloc(log->acc, size * sizeof (*log->acc));
+    void *gyro = realloc(log->gyro, size * sizeof (*log->gyro));
+    void *mag = realloc(log->mag, size * sizeof (*log->mag));
+
+    if (dt) log->dt = dt;
+    if (acc) log->acc = acc;
+    if (gyro) log->gyro = gyro;
+    if (mag) log->mag = mag;
+    if (dt == NULL || acc == NULL || gyro == NULL || mag == NULL) {
+        return ERROR;
+    }
+    return SUCCESS;
+}
@@ -0,0 +1,60 @@
+/*
+ * File:   ahrs_log.h
+ * Brief: Loads recorded IMU streams (csv logs written by
+ * python/mavcsv_logging.py) into memory for host side replay of the AHRS
+ * filters
+ * Created on 10/16/2026
+ * Modified on
+ */
+
+#ifndef AHRS_LOG_H // Header guard
+#define	AHRS_LOG_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include "Lin_alg_float.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+#define AHRS_LOG_NOMINAL_DT 0.02 // used when the log time stamps jump
+#define AHRS_LOG_DEG2RAD 0.017453292519943 // HIGHRES_IMU gyros are in deg/sec
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+struct ahrs_log {
+    const char *name;
+    long length; // number of samples
+    float *dt; // seconds since the previous sample
+    float (*acc)[MSZ];
+    float (*gyro)[MSZ]; // rad/sec
+    float (*mag)[MSZ];
+};
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function ahrs_log_load(const char *file_name, float gyro_scale,
+ * struct ahrs_log *log)
+ * @param file_name, csv with time_usec, [xyz]acc, [xyz]gyro, [xyz]mag columns
+ * @param gyro_scale, multiplier to convert the gyro column to rad/sec
+ * @param log, the log to fill
+ * @return SUCCESS or ERROR
+ * @brief reads the whole file into memory so replay is not bound by parsing
+ * @author Aaron Hunter */
+int8_t ahrs_log_load(const char *file_name, float gyro_scale, struct ahrs_log *log);
+
+/**
+ * @Function ahrs_log_free(struct ahrs_log *log)
+ * @param log, a log filled by ahrs_log_load()
+ * @return none
+ * @author Aaron Hunter */
+void ahrs_log_free(struct ahrs_log *log);
+
+#endif	/* AHRS_LOG_H */ // End of header guard
@@ -0,0 +1,542 @@
+/*
+ * File:   ahrs_replay.c
+ * Brief: Host (Linux) tool that replays recorded IMU logs through every AHRS
+ * variant in apps/ahrs_apps and reports attitude error and throughput for each
+ * so the estimator and its precision can be picked from data rather than by
+ * flashing the board.  Logs are spread across worker processes, one log per
+ * worker, up to the number of cores.  Processes rather than threads because
+ * AHRS_update() and AHRS_fix_update() keep the filter state in module statics.
+ * The double precision q_ahrs_dbl filter is the reference for the errors.
+ * Created on 10/16/2026
+ * Modified on
+ *
+ * Build (from this directory):
+ * gcc -O2 -I../../../lib/Board.X -I../../../lib/Lin_alg.X -I../AHRS.X
+ *  ahrs_replay.c ahrs_log.c ../AHRS.X/AHRS.c ../AHRS.X/AHRS_fix.c
+ *  ../../../lib/Lin_alg.X/Lin_alg_float.c ../../../lib/Lin_alg.X/Lin_alg_rot.c
+ *  ../../../lib/Lin_alg.X/Fast_math.c -lm -o ahrs_replay
+ * Run:
+ * ./ahrs_replay [-j jobs] [-g gyro scale to rad/sec] log.csv [log.csv ...]
+ * e.g. ./ahrs_replay ../../../python/imu_tmbl_072621.csv
+ *      ./ahrs_replay -g 0.000133231 ../../../python/IMU_data_060321.csv
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "Board.h"
+#include "Lin_alg_float.h"
+#include "Lin_alg_rot.h"
+#include "AHRS.h"
+#include "AHRS_fix.h"
+#include "ahrs_log.h"
+
+/* The app variants are compiled into this file with their hardware and main()
+ * excluded by AHRS_REPLAY and their helpers renamed so they do not collide */
+#define AHRS_REPLAY
+
+#define v_copy q_ahrs_v_copy
+#define m_norm q_ahrs_m_norm
+#define ahrs_update q_ahrs_update
+#include "../q_ahrs.X/q_ahrs_main.c"
+#undef v_copy
+#undef m_norm
+#undef ahrs_update
+
+#define v_copy q_ahrs_dbl_v_copy
+#define m_norm q_ahrs_dbl_m_norm
+#define lin_alg_q_mult q_ahrs_dbl_q_mult
+#define lin_alg_cross q_ahrs_dbl_cross
+#define lin_alg_v_scale q_ahrs_dbl_v_scale
+#define lin_alg_v_v_add q_ahrs_dbl_v_v_add
+#define lin_alg_v_v_sub q_ahrs_dbl_v_v_sub
+#define lin_alg_q_norm q_ahrs_dbl_q_norm
+#define ahrs_update q_ahrs_dbl_update
+#include "../q_ahrs_dbl.X/q_ahrs_dbl_main.c"
+#undef v_copy
+#undef m_norm
+#undef lin_alg_q_mult
+#undef lin_alg_cross
+#undef lin_alg_v_scale
+#undef lin_alg_v_v_add
+#undef lin_alg_v_v_sub
+#undef lin_alg_q_norm
+#undef ahrs_update
+
+#include "../q_ahrs_codegen/ahrs_q_update.c"
+#include "../dcm_ahrs_matlab.X/ahrs_m_update.c"
+
+/*******************************************************************************
+ * #DEFINES                                                                    *
+ ******************************************************************************/
+#define MAX_LOGS 256
+#define RAD2DEG (180.0 / M_PI)
+/* filter setup, the defaults in AHRS.c */
+#define KP_A 2.5
+#define KI_A 0.05
+#define KP_M 2.5
+#define KI_M 0.05
+
+/*******************************************************************************
+ * TYPEDEFS                                                                    *
+ ******************************************************************************/
+/* per estimator results sent back from a worker */
+struct replay_result {
+    long samples;
+    double cpu_nsec; // time spent in the update loop
+    double sum_sq_err; // sum of squared euler angle errors, rad^2
+    double max_err; // rad
+    double bias[MSZ]; // final gyro bias estimate
+};
+
+struct estimator {
+    const char *name;
+    /* runs the whole log, fills euler[length][MSZ] (yaw, pitch, roll) and
+     * bias, returns the time spent in the updates in nsec */
+    double (*run)(const struct ahrs_log *log, double (*euler)[MSZ], double bias[MSZ]);
+};
+
+/*******************************************************************************
+ * VARIABLES                                                                   *
+ ******************************************************************************/
+static const double acc_inertial[MSZ] = {0, 0, 1.0};
+/* Santa Cruz, normalized ENU, see AHRS.c */
+static const double mag_inertial[MSZ] = {0.110011998753301, 0.478219898291142, -0.871322609031072};
+
+/*******************************************************************************
+ * FUNCTIONS                                                                   *
+ ******************************************************************************/
+
+/**
+ * @function cpu_nsec()
+ * @return process cpu time in nsec
+ */
+static double cpu_nsec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @function wall_nsec()
+ * @return monotonic wall clock in nsec
+ */
+static double wall_nsec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @function dcm_to_euler()
+ * @param dcm a row major DCM as used in dcm_ahrs_matlab.X
+ * @param euler a vector of euler angles in [psi, theta, roll] order
+ * @note same convention as extract_angles() in dcm_ahrs_matlab.X/ahrs_main.c
+ */
+static void dcm_to_euler(const double dcm[MSZ * MSZ], double euler[MSZ]) {
+    euler[0] = atan2(dcm[3], dcm[0]);
+    if (dcm[6] > 1.0) {
+        euler[1] = -M_PI / 2;
+    } else if (dcm[6] < -1.0) {
+        euler[1] = M_PI / 2;
+    } else {
+        euler[1] = -asin(dcm[6]);
+    }
+    euler[2] = atan2(dcm[7], dcm[8]);
+}
+
+/* AHRS.X AHRS_update(), float, state kept in the module */
+static double run_ahrs(const struct ahrs_log *log, double (*euler)[MSZ], double bias[MSZ]) {
+    float acc[MSZ];
+    float mag[MSZ];
+    float gyro[MSZ];
+    float q[QSZ];
+    float b[MSZ];
+    double (*att)[QSZ] = malloc(log->length * sizeof (*att));
+    double start;
+    double elapsed;
+    long n;
+    int i;
+
+    AHRS_set_filter_gains(KP_A, KI_A, KP_M, KI_M);
+    start = cpu_nsec();
+    for (n = 0; n < log->length; n++) {
+        for (i = 0; i < MSZ; i++) {
+            acc[i] = log->acc[n][i];
+            mag[i] = log->mag[n][i];
+            gyro[i] = log->gyro[n][i];
+        }
+        AHRS_update(acc, mag, gyro, log->dt[n], q, b);
+        for (i = 0; i < QSZ; i++) att[n][i] = q[i];
+    }
+    elapsed = cpu_nsec() - start;
+    for (n = 0; n < log->length; n++) lin_alg_quat2euler_dbl(att[n], euler[n]);
+    for (i = 0; i < MSZ; i++) bias[i] = b[i];
+    free(att);
+    return elapsed;
+}
+
+/* AHRS.X AHRS_fix_update(), Q1.30/Q16.16, state kept in the module */
+static double run_ahrs_fix(const struct ahrs_log *log, double (*euler)[MSZ], double bias[MSZ]) {
+    float q[QSZ];
+    float b[MSZ];
+    double (*att)[QSZ] = malloc(log->length * sizeof (*att));
+    double start;
+    double elapsed;
+    long n;
+    int i;
+
+    AHRS_fix_set_filter_gains(KP_A, KI_A, KP_M, KI_M);
+    start = cpu_nsec();
+    for (n = 0; n < log->length; n++) {
+        AHRS_fix_update(log->acc[n], log->mag[n], log->gyro[n], log->dt[n], q, b);
+        for (i = 0; i < QSZ; i++) att[n][i] = q[i];
+    }
+    elapsed = cpu_nsec() - start;
+    for (n = 0; n < log->length; n++) lin_alg_quat2euler_dbl(att[n], euler[n]);
+    for (i = 0; i < MSZ; i++) bias[i] = b[i];
+    free(att);
+    return elapsed;
+}
+
+/* q_ahrs.X ahrs_update(), float */
+static double run_q_ahrs(const struct ahrs_log *log, double (*euler)[MSZ], double bias[MSZ]) {
+    float acc[MSZ];
+    float mag[MSZ];
+    float gyro[MSZ];
+    float a_i[MSZ];
+    float m_i[MSZ];
+    float q_minus[QSZ] = {1, 0, 0, 0};
+    float q_plus[QSZ];
+    float b_minus[MSZ] = {0, 0, 0};
+    float b_plus[MSZ];
+    double (*att)[QSZ] = malloc(log->length * sizeof (*att));
+    double start;
+    double elapsed;
+    long n;
+    int i;
+
+    for (i = 0; i < MSZ; i++) {
+        a_i[i] = acc_inertial[i];
+        m_i[i] = mag_inertial[i];
+    }
+    start = cpu_nsec();
+    for (n = 0; n < log->length; n++) {
+        for (i = 0; i < MSZ; i++) {
+            acc[i] = log->acc[n][i];
+            mag[i] = log->mag[n][i];
+            gyro[i] = log->gyro[n][i];
+        }
+        q_ahrs_update(q_minus, b_minus, gyro, mag, acc, m_i, a_i, log->dt[n],
+                KP_A, KI_A, KP_M, KI_M, q_plus, b_plus);
+        for (i = 0; i < QSZ; i++) att[n][i] = q_minus[i] = q_plus[i];
+        for (i = 0; i < MSZ; i++) b_minus[i] = b_plus[i];
+    }
+    elapsed = cpu_nsec() - start;
+    for (n = 0; n < log->length; n++) lin_alg_quat2euler_dbl(att[n], euler[n]);
+    for (i = 0; i < MSZ; i++) bias[i] = b_minus[i];
+    free(att);
+    return elapsed;
+}
+
+/* q_ahrs_dbl.X ahrs_update(), double */
+static double run_q_ahrs_dbl(const struct ahrs_log *log, double (*euler)[MSZ], double bias[MSZ]) {
+    double acc[MSZ];
+    double mag[MSZ];
+    double gyro[MSZ];
+    double a_i[MSZ];
+    double m_i[MSZ];
+    double q_minus[QSZ] = {1, 0, 0, 0};
+    double q_plus[QSZ];
+    double b_minus[MSZ] = {0, 0, 0};
+    double b_plus[MSZ];
+    double (*att)[QSZ] = malloc(log->length * sizeof (*att));
+    double start;
+    double elapsed;
+    long n;
+    int i;
+
+    for (i = 0; i < MSZ; i++) {
+        a_i[i] = acc_inertial[i];
+        m_i[i] = mag_inertial[i];
+    }
+    start = cpu_nsec();
+    for (n = 0; n < log->length; n++) {
+        for (i = 0; i < MSZ; i++) {
+            acc[i] = log->acc[n][i];
+            mag[i] = log->mag[n][i];
+            gyro[i] = log->gyro[n][i];
+        }
+        q_ahrs_dbl_update(q_minus, b_minus, gyro, mag, acc, m_i, a_i, log->dt[n],
+                KP_A, KI_A, KP_M, KI_M, q_plus, b_plus);
+        for (i = 0; i < QSZ; i++) att[n][i] = q_minus[i] = q_plus[i];
+        for (i = 0; i < MSZ; i++) b_minus[i] = b_plus[i];
+    }
+    elapsed = cpu_nsec() - start;
+    for (n = 0; n < log->length; n++) lin_alg_quat2euler_dbl(att[n], euler[n]);
+    for (i = 0; i < MSZ; i++) bias[i] = b_minus[i];
+    free(att);
+    return elapsed;
+}
+
+/* q_ahrs_codegen ahrs_q_update(), MATLAB coder, double */
+static double run_codegen_q(const struct ahrs_log *log, double (*euler)[MSZ], double bias[MSZ]) {
+    double acc[MSZ];
+    double mag[MSZ];
+    double gyro[MSZ];
+    double a_i[MSZ];
+    double m_i[MSZ];
+    double q_minus[QSZ] = {1, 0, 0, 0};
+    double q_plus[QSZ];
+    double b_minus[MSZ] = {0, 0, 0};
+    double b_plus[MSZ];
+    double (*att)[QSZ] = malloc(log->length * sizeof (*att));
+    double start;
+    double elapsed;
+    long n;
+    int i;
+
+    start = cpu_nsec();
+    for (n = 0; n < log->length; n++) {
+        for (i = 0; i < MSZ; i++) {
+            acc[i] = log->acc[n][i];
+            mag[i] = log->mag[n][i];
+            gyro[i] = log->gyro[n][i];
+            a_i[i] = acc_inertial[i];
+            m_i[i] = mag_inertial[i];
+        }
+        ahrs_q_update(q_minus, b_minus, gyro, mag, acc, m_i, a_i, log->dt[n],
+                KP_A, KI_A, KP_M, KI_M, q_plus, b_plus);
+        for (i = 0; i < QSZ; i++) att[n][i] = q_minus[i] = q_plus[i];
+        for (i = 0; i < MSZ; i++) b_minus[i] = b_plus[i];
+    }
+    elapsed = cpu_nsec() - start;
+    for (n = 0; n < log->length; n++) lin_alg_quat2euler_dbl(att[n], euler[n]);
+    for (i = 0; i < MSZ; i++) bias[i] = b_minus[i];
+    free(att);
+    return elapsed;
+}
+
+/* dcm_ahrs_matlab.X ahrs_m_update(), MATLAB coder DCM, double */
+static double run_codegen_dcm(const struct ahrs_log *log, double (*euler)[MSZ], double bias[MSZ]) {
+    double acc[MSZ];
+    double mag[MSZ];
+    double gyro[MSZ];
+    double a_i[MSZ];
+    double m_i[MSZ];
+    double r_minus[MSZ * MSZ] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+    double r_plus[MSZ * MSZ];
+    double b_minus[MSZ] = {0, 0, 0};
+    double b_plus[MSZ];
+    double (*att)[MSZ * MSZ] = malloc(log->length * sizeof (*att));
+    double start;
+    double elapsed;
+    long n;
+    int i;
+
+    start = cpu_nsec();
+    for (n = 0; n < log->length; n++) {
+        for (i = 0; i < MSZ; i++) {
+            acc[i] = log->acc[n][i];
+            mag[i] = log->mag[n][i];
+            gyro[i] = log->gyro[n][i];
+            a_i[i] = acc_inertial[i];
+            m_i[i] = mag_inertial[i];
+        }
+        ahrs_m_update(r_minus, b_minus, gyro, mag, acc, m_i, a_i, log->dt[n],
+                KP_A, KI_A, KP_M, KI_M, r_plus, b_plus);
+        for (i = 0; i < MSZ * MSZ; i++) att[n][i] = r_minus[i] = r_plus[i];
+        for (i = 0; i < MSZ; i++) b_minus[i] = b_plus[i];
+    }
+    elapsed = cpu_nsec() - start;
+    for (n = 0; n < log->length; n++) dcm_to_euler(att[n], euler[n]);
+    for (i = 0; i < MSZ; i++) bias[i] = b_minus[i];
+    free(att);
+    return elapsed;
+}
+
+/* the first entry is the reference */
+static const struct estimator estimators[] = {
+    {"q_ahrs_dbl", run_q_ahrs_dbl},
+    {"q_ahrs", run_q_ahrs},
+    {"AHRS", run_ahrs},
+    {"AHRS_fix", run_ahrs_fix},
+    {"codegen_q", run_codegen_q},
+    {"codegen_dcm", run_codegen_dcm},
+};
+#define NUM_ESTIMATORS (sizeof (estimators) / sizeof (estimators[0]))
+
+/**
+ * @function replay_log()
+ * @param log the log to run
+ * @param results one entry per estimator
+ * @return SUCCESS or ERROR
+ * @brief runs every estimator over the log and scores it against the reference
+ */
+static int8_t replay_log(const struct ahrs_log *log, struct replay_result results[NUM_ESTIMATORS]) {
+    double (*reference)[MSZ] = malloc(log->length * sizeof (*reference));
+    double (*euler)[MSZ] = malloc(log->length * sizeof (*euler));
+    double err;
+    long n;
+    unsigned int e;
+    int i;
+
+    if (reference == NULL || euler == NULL) {
+        free(reference);
+        free(euler);
+        return ERROR;
+    }
+    for (e = 0; e < NUM_ESTIMATORS; e++) {
+        memset(&results[e], 0, sizeof (results[e]));
+        results[e].samples = log->length;
+        results[e].cpu_nsec = estimators[e].run(log, e == 0 ? reference : euler, results[e].bias);
+        if (e == 0) continue;
+        for (n = 0; n < log->length; n++) {
+            for (i = 0; i < MSZ; i++) {
+                err = euler[n][i] - reference[n][i];
+                err = fabs(atan2(sin(err), cos(err))); // wrap to +/- pi
+                results[e].sum_sq_err += err * err;
+                if (err > results[e].max_err) results[e].max_err = err;
+            }
+        }
+    }
+    free(reference);
+    free(euler);
+    return SUCCESS;
+}
+
+/**
+ * @function print_results()
+ * @param title heading for the table
+ * @param results one entry per estimator
+ * @param show_bias TRUE to print the final bias estimates
+ */
+static void print_results(const char *title, struct replay_result results[NUM_ESTIMATORS], int8_t show_bias) {
+    unsigned int e;
+
+    printf("\n%s\n", title);
+    printf("%-12s %10s %10s %12s %12s", "estimator", "samples",
+            "Msample/s", "rms err deg", "max err deg");
+    if (show_bias == TRUE) printf(" %11s %11s %11s", "bias x", "bias y", "bias z");
+    printf("\n");
+    for (e = 0; e < NUM_ESTIMATORS; e++) {
+        printf("%-12s %10ld %10.2f %12.5f %12.5f",
+                estimators[e].name, results[e].samples,
+                results[e].cpu_nsec > 0 ? results[e].samples * 1e3 / results[e].cpu_nsec : 0,
+                sqrt(results[e].sum_sq_err / (MSZ * (double) results[e].samples)) * RAD2DEG,
+                results[e].max_err * RAD2DEG);
+        if (show_bias == TRUE) {
+            printf(" %+11.3e %+11.3e %+11.3e", results[e].bias[0], results[e].bias[1], results[e].bias[2]);
+        }
+        printf("\n");
+    }
+}
+
+int main(int argc, char **argv) {
+    static struct replay_result results[MAX_LOGS][NUM_ESTIMATORS];
+    struct replay_result total[NUM_ESTIMATORS];
+    struct ahrs_log log;
+    const char *logs[MAX_LOGS];
+    int pipes[MAX_LOGS];
+    int8_t valid[MAX_LOGS];
+    int fds[2];
+    int num_logs = 0;
+    int jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    int running = 0;
+    int next = 0;
+    int opt;
+    int i;
+    unsigned int e;
+    long total_samples = 0;
+    float gyro_scale = AHRS_LOG_DEG2RAD;
+    double start;
+    pid_t pid;
+
+    while ((opt = getopt(argc, argv, "j:g:")) != -1) {
+        switch (opt) {
+            case 'j':
+                jobs = atoi(optarg);
+                break;
+            case 'g':
+                gyro_scale = atof(optarg);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-j jobs] [-g gyro scale] log.csv ...\n", argv[0]);
+                return 1;
+        }
+    }
+    for (i = optind; i < argc && num_logs < MAX_LOGS; i++) {
+        logs[num_logs++] = argv[i];
+    }
+    if (num_logs == 0 || jobs < 1) {
+        fprintf(stderr, "usage: %s [-j jobs] [-g gyro scale] log.csv ...\n", argv[0]);
+        return 1;
+    }
+    printf("AHRS replay %s, %s: %d logs, %d jobs\n", __DATE__, __TIME__, num_logs, jobs);
+
+    /* one worker per log, at most jobs at a time, results come back on a pipe
+     * in log order so the reads below never block on a slow worker for long */
+    start = wall_nsec();
+    while (next < num_logs || running > 0) {
+        if (next < num_logs && running < jobs) {
+            if (pipe(fds) != 0) return 1;
+            pid = fork();
+            if (pid == 0) {
+                close(fds[0]);
+                valid[0] = ahrs_log_load(logs[next], gyro_scale, &log);
+                if (valid[0] == SUCCESS) {
+                    valid[0] = replay_log(&log, results[0]);
+                }
+                if (write(fds[1], valid, sizeof (valid[0])) < 0 ||
+                        write(fds[1], results[0], sizeof (results[0])) < 0) {
+                    _exit(1);
+                }
+                _exit(0);
+            }
+            close(fds[1]);
+            pipes[next++] = fds[0];
+            running++;
+            continue;
+        }
+        wait(NULL);
+        running--;
+    }
+    for (i = 0; i < num_logs; i++) {
+        valid[i] = ERROR;
+        if (read(pipes[i], &valid[i], sizeof (valid[i])) != sizeof (valid[i]) ||
+                read(pipes[i], results[i], sizeof (results[i])) != sizeof (results[i])) {
+            valid[i] = ERROR;
+        }
+        close(pipes[i]);
+    }
+
+    memset(total, 0, sizeof (total));
+    for (i = 0; i < num_logs; i++) {
+        if (valid[i] != SUCCESS) {
+            printf("\n%s: could not be replayed\n", logs[i]);
+            continue;
+        }
+        print_results(logs[i], results[i], TRUE);
+        total_samples += results[i][0].samples;
+        for (e = 0; e < NUM_ESTIMATORS; e++) {
+            total[e].samples += results[i][e].samples;
+            total[e].cpu_nsec += results[i][e].cpu_nsec;
+            total[e].sum_sq_err += results[i][e].sum_sq_err;
+            if (results[i][e].max_err > total[e].max_err) total[e].max_err = results[i][e].max_err;
+        }
+    }
+    if (total_samples > 0) {
+        print_results("all logs", total, FALSE);
+        printf("\n%ld samples x %d estimators in %.3f s wall\n", total_samples,
+                (int) NUM_ESTIMATORS, (wall_nsec() - start) * 1e-9);
+    }
+    return 0;
+}
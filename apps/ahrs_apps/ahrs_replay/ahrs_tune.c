@@ -0,0 +1,860 @@
+/*
+ * File:   ahrs_tune.c
+ * Brief: Host (Linux) gain autotuner for the complementary filter in
+ * AHRS.X/AHRS.c.  Replays recorded IMU logs through AHRS_update() for each
+ * candidate set of kp_a, ki_a, kp_m, ki_m and scores it on convergence time,
+ * steady state error and gyro bias stability.  Candidates come from a grid,
+ * a log-uniform random search or a CMA style evolution strategy (diagonal
+ * covariance, log gain space) and are evaluated in parallel worker processes.
+ * The attitude reference is not the filter's own inputs: each log is cut into
+ * segments and each segment is one attitude carried through it by the gyros,
+ * less the bias of the stillest second of the log.  The attitude is the TRIAD
+ * solution of the accelerometer and magnetometer averaged over the whole
+ * segment, each sample turned back to the start through the gyros, so
+ * accelerations that come and go average out where a filter that follows
+ * every sample is charged for them.  Sustained acceleration still biases it,
+ * and the drift printed for each log shows how far it can be trusted.  Each cost
+ * term is divided by the score of the defaults, so the weights compare like
+ * with like, and gains that end on a search bound are reported but not
+ * printed as gains to use.  Unless -f is given the inertial magnetic vector
+ * keeps the Santa Cruz declination but takes its inclination from each log,
+ * otherwise a mag calibration that does not match AHRS.c shows up as a
+ * constant error.
+ * Created on 10/16/2026
+ * Modified on 10/17/2026
+ *
+ * Build (from this directory):
+ * gcc -O2 -I../../../lib/Board.X -I../../../lib/Lin_alg.X -I../AHRS.X
+ *  ahrs_tune.c ahrs_log.c ../AHRS.X/AHRS.c ../../../lib/Lin_alg.X/Lin_alg_float.c
+ *  ../../../lib/Lin_alg.X/Fast_math.c -lm -o ahrs_tune
+ * Run:
+ * ./ahrs_tune [-s grid|random|cma] [-n candidates] [-k grid points per gain]
+ *  [-j jobs] [-g gyro scale] [-t threshold deg] [-w conv,ss,bias] [-r seed]
+ *  [-S segment seconds] [-f fixed mag inclination] log.csv [log.csv ...]
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "Board.h"
+#include "Lin_alg_float.h"
+#include "AHRS.h"
+#include "ahrs_log.h"
+
+/*******************************************************************************
+ * #DEFINES                                                                    *
+ ******************************************************************************/
+#define MAX_LOGS 64
+#define MAX_JOBS 256
+#define NUM_GAINS 4 // kp_a, ki_a, kp_m, ki_m
+#define RAD2DEG (180.0 / M_PI)
+#define CONV_HOLD 0.5 // seconds the error must stay under threshold to converge
+#define CMA_LAMBDA 32 // candidates per generation
+#define CMA_SIGMA 0.7 // initial step size in ln(gain)
+#define CMA_LEARN 0.3 // step size learning rate
+#define NUM_BEST 5 // candidates printed at the end
+#define BIAS_WINDOW 1.0 // seconds, the stillest window gives the gyro bias
+#define BOUND_MARGIN 0.02 // a gain within 2% of a bound is on it
+
+/*******************************************************************************
+ * TYPEDEFS                                                                    *
+ ******************************************************************************/
+struct tune_score {
+    double conv_time; // seconds, mean over logs
+    double ss_err; // deg rms after convergence, mean over logs
+    double bias_std; // deg/sec, bias std dev over the second half, mean over logs
+    double cost;
+};
+
+struct candidate {
+    double gains[NUM_GAINS];
+    struct tune_score score;
+};
+
+/*******************************************************************************
+ * VARIABLES                                                                   *
+ ******************************************************************************/
+static const char *gain_names[NUM_GAINS] = {"kp_a", "ki_a", "kp_m", "ki_m"};
+static const double gain_default[NUM_GAINS] = {2.5, 0.05, 2.5, 0.05};
+static const double gain_min[NUM_GAINS] = {0.05, 0.0005, 0.05, 0.0005};
+static const double gain_max[NUM_GAINS] = {50.0, 2.0, 50.0, 2.0};
+
+static const double acc_inertial[MSZ] = {0, 0, 1.0};
+/* Santa Cruz, normalized ENU, see AHRS.c */
+static const double mag_inertial[MSZ] = {0.110011998753301, 0.478219898291142, -0.871322609031072};
+
+static struct ahrs_log logs[MAX_LOGS];
+static double (*reference[MAX_LOGS])[MSZ * MSZ]; // segment reference DCM per sample
+static double log_mag_inertial[MAX_LOGS][MSZ]; // aiding vector used for each log
+static int num_logs = 0;
+static double threshold = 5.0 / RAD2DEG; // convergence threshold
+static double weights[3] = {1.0, 1.0, 1.0}; // conv, ss, bias, each relative to the defaults
+static double scales[3] = {1.0, 1.0, 1.0}; // score of the defaults, once known
+static double segment = 10.0; // seconds between reference anchors
+
+/*******************************************************************************
+ * FUNCTIONS                                                                   *
+ ******************************************************************************/
+
+/**
+ * @function normalize()
+ * @param v vector normalized in place
+ */
+static void normalize(double v[MSZ]) {
+    double n = sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    if (n > 0) {
+        v[0] /= n;
+        v[1] /= n;
+        v[2] /= n;
+    }
+}
+
+/**
+ * @function cross()
+ */
+static void cross(const double u[MSZ], const double v[MSZ], double w[MSZ]) {
+    w[0] = u[1] * v[2] - u[2] * v[1];
+    w[1] = u[2] * v[0] - u[0] * v[2];
+    w[2] = u[0] * v[1] - u[1] * v[0];
+}
+
+/**
+ * @function triad()
+ * @param a_b, m_b measured gravity and magnetic field in the body frame
+ * @param m_i inertial magnetic field
+ * @param dcm row major rotation taking inertial vectors into the body frame
+ */
+static void triad(const float a_b[MSZ], const float m_b[MSZ], const double m_i[MSZ],
+        double dcm[MSZ * MSZ]) {
+    double tb[MSZ][MSZ]; // body triad, tb[k] is the kth basis vector
+    double ti[MSZ][MSZ]; // inertial triad
+    int i;
+    int j;
+
+    for (i = 0; i < MSZ; i++) {
+        tb[0][i] = a_b[i];
+        tb[2][i] = m_b[i];
+        ti[0][i] = acc_inertial[i];
+        ti[2][i] = m_i[i];
+    }
+    normalize(tb[0]);
+    cross(tb[0], tb[2], tb[1]);
+    normalize(tb[1]);
+    cross(tb[0], tb[1], tb[2]);
+    normalize(ti[0]);
+    cross(ti[0], ti[2], ti[1]);
+    normalize(ti[1]);
+    cross(ti[0], ti[1], ti[2]);
+    /* dcm = sum over k of tb[k] * ti[k]' */
+    for (i = 0; i < MSZ; i++) {
+        for (j = 0; j < MSZ; j++) {
+            dcm[i * MSZ + j] = tb[0][i] * ti[0][j] + tb[1][i] * ti[1][j] + tb[2][i] * ti[2][j];
+        }
+    }
+}
+
+/**
+ * @function q_error()
+ * @param q filter attitude quaternion, q* x v_i x q gives the body vector as in
+ * q_rot_v_q() in AHRS.c
+ * @param dcm reference rotation from triad()
+ * @return the angle of the rotation between the two in radians
+ */
+static double q_error(const float q[QSZ], const double dcm[MSZ * MSZ]) {
+    double q00 = q[0] * q[0];
+    double q11 = q[1] * q[1];
+    double q22 = q[2] * q[2];
+    double q33 = q[3] * q[3];
+    double r[MSZ * MSZ];
+    double trace = 0;
+    int i;
+
+    /* rotation matrix of v -> q* x v x q */
+    r[0] = q00 + q11 - q22 - q33;
+    r[1] = 2.0 * (q[1] * q[2] + q[0] * q[3]);
+    r[2] = 2.0 * (q[1] * q[3] - q[0] * q[2]);
+    r[3] = 2.0 * (q[1] * q[2] - q[0] * q[3]);
+    r[4] = q00 - q11 + q22 - q33;
+    r[5] = 2.0 * (q[2] * q[3] + q[0] * q[1]);
+    r[6] = 2.0 * (q[1] * q[3] + q[0] * q[2]);
+    r[7] = 2.0 * (q[2] * q[3] - q[0] * q[1]);
+    r[8] = q00 - q11 - q22 + q33;
+    for (i = 0; i < MSZ * MSZ; i++) {
+        trace += r[i] * dcm[i];
+    }
+    trace = (trace - 1.0) * 0.5;
+    if (trace > 1.0) trace = 1.0;
+    if (trace < -1.0) trace = -1.0;
+    return acos(trace);
+}
+
+/**
+ * @function dcm_angle()
+ * @param a, b rotations, row major
+ * @return the angle of the rotation between the two in radians
+ */
+static double dcm_angle(const double a[MSZ * MSZ], const double b[MSZ * MSZ]) {
+    double trace = 0;
+    int i;
+
+    for (i = 0; i < MSZ * MSZ; i++) {
+        trace += a[i] * b[i];
+    }
+    trace = (trace - 1.0) * 0.5;
+    if (trace > 1.0) trace = 1.0;
+    if (trace < -1.0) trace = -1.0;
+    return acos(trace);
+}
+
+/**
+ * @function match_inclination()
+ * @param log the log
+ * @param m_i returns mag_inertial with the mean inclination seen in the log
+ */
+static void match_inclination(const struct ahrs_log *log, double m_i[MSZ]) {
+    double a[MSZ];
+    double m[MSZ];
+    double dip = 0; // mean cosine between up and the field
+    double h;
+    long n;
+    int i;
+
+    for (n = 0; n < log->length; n++) {
+        for (i = 0; i < MSZ; i++) {
+            a[i] = log->acc[n][i];
+            m[i] = log->mag[n][i];
+        }
+        normalize(a);
+        normalize(m);
+        dip += (a[0] * m[0] + a[1] * m[1] + a[2] * m[2]) / log->length;
+    }
+    h = sqrt(mag_inertial[0] * mag_inertial[0] + mag_inertial[1] * mag_inertial[1]);
+    m_i[0] = mag_inertial[0] / h * sqrt(1.0 - dip * dip);
+    m_i[1] = mag_inertial[1] / h * sqrt(1.0 - dip * dip);
+    m_i[2] = dip;
+}
+
+/**
+ * @function gyro_bias()
+ * @param log the log
+ * @param bias returns the mean gyro rate over the BIAS_WINDOW with the least
+ * variance, rad/sec
+ */
+static void gyro_bias(const struct ahrs_log *log, double bias[MSZ]) {
+    double sum[MSZ] = {0, 0, 0};
+    double sq_sum[MSZ] = {0, 0, 0};
+    double best = -1;
+    double var;
+    double t = 0;
+    long count = 0;
+    long n;
+    int i;
+
+    bias[0] = bias[1] = bias[2] = 0;
+    for (n = 0; n < log->length; n++) {
+        for (i = 0; i < MSZ; i++) {
+            sum[i] += log->gyro[n][i];
+            sq_sum[i] += log->gyro[n][i] * log->gyro[n][i];
+        }
+        count++;
+        t += log->dt[n];
+        if (t >= BIAS_WINDOW || n == log->length - 1) {
+            var = 0;
+            for (i = 0; i < MSZ; i++) {
+                var += sq_sum[i] / count - (sum[i] / count) * (sum[i] / count);
+            }
+            if (best < 0 || var < best) {
+                best = var;
+                for (i = 0; i < MSZ; i++) {
+                    bias[i] = sum[i] / count;
+                }
+            }
+            memset(sum, 0, sizeof (sum));
+            memset(sq_sum, 0, sizeof (sq_sum));
+            count = 0;
+            t = 0;
+        }
+    }
+}
+
+/**
+ * @function propagate()
+ * @param prev rotation at the previous sample
+ * @param rate body rate, rad/sec, bias removed
+ * @param dt seconds
+ * @param dcm returns prev turned by the body rate, an inertial vector seen from
+ * the body turns the other way
+ */
+static void propagate(const double prev[MSZ * MSZ], const double rate[MSZ], double dt,
+        double dcm[MSZ * MSZ]) {
+    double theta = sqrt(rate[0] * rate[0] + rate[1] * rate[1] + rate[2] * rate[2]) * dt;
+    double k[MSZ];
+    double e[MSZ * MSZ];
+    double s;
+    double c;
+    int i;
+    int j;
+
+    if (theta < 1e-12) {
+        memcpy(dcm, prev, sizeof (e));
+        return;
+    }
+    for (i = 0; i < MSZ; i++) {
+        k[i] = -rate[i] * dt / theta;
+    }
+    s = sin(theta);
+    c = 1.0 - cos(theta);
+    /* Rodrigues, e = I + s K + c K^2 with K^2 = k k' - I */
+    e[0] = 1.0 + c * (k[0] * k[0] - 1.0);
+    e[1] = -s * k[2] + c * k[0] * k[1];
+    e[2] = s * k[1] + c * k[0] * k[2];
+    e[3] = s * k[2] + c * k[0] * k[1];
+    e[4] = 1.0 + c * (k[1] * k[1] - 1.0);
+    e[5] = -s * k[0] + c * k[1] * k[2];
+    e[6] = -s * k[1] + c * k[0] * k[2];
+    e[7] = s * k[0] + c * k[1] * k[2];
+    e[8] = 1.0 + c * (k[2] * k[2] - 1.0);
+    for (i = 0; i < MSZ; i++) {
+        for (j = 0; j < MSZ; j++) {
+            dcm[i * MSZ + j] = e[i * MSZ] * prev[j] + e[i * MSZ + 1] * prev[MSZ + j]
+                    + e[i * MSZ + 2] * prev[2 * MSZ + j];
+        }
+    }
+}
+
+/**
+ * @function anchor()
+ * @param log the log
+ * @param start first sample of the segment
+ * @param m_i inertial magnetic field
+ * @param bias gyro bias, rad/sec
+ * @param dcm returns the TRIAD rotation of the mean accel and mag over the
+ * segment, each sample turned back to the first through the gyros
+ */
+static void anchor(const struct ahrs_log *log, long start, const double m_i[MSZ],
+        const double bias[MSZ], double dcm[MSZ * MSZ]) {
+    double turn[MSZ * MSZ] = {1, 0, 0, 0, 1, 0, 0, 0, 1}; // start to sample n
+    double next[MSZ * MSZ];
+    double rate[MSZ];
+    float acc[MSZ] = {0, 0, 0};
+    float mag[MSZ] = {0, 0, 0};
+    double t = 0;
+    long n;
+    int i;
+
+    for (n = start; n < log->length && (n == start || t < segment); n++) {
+        if (n > start) {
+            for (i = 0; i < MSZ; i++) {
+                rate[i] = log->gyro[n][i] - bias[i];
+            }
+            propagate(turn, rate, log->dt[n], next);
+            memcpy(turn, next, sizeof (turn));
+            t += log->dt[n];
+        }
+        /* turn' takes the sample back into the body frame of the start */
+        for (i = 0; i < MSZ; i++) {
+            acc[i] += turn[i] * log->acc[n][0] + turn[MSZ + i] * log->acc[n][1]
+                    + turn[2 * MSZ + i] * log->acc[n][2];
+            mag[i] += turn[i] * log->mag[n][0] + turn[MSZ + i] * log->mag[n][1]
+                    + turn[2 * MSZ + i] * log->mag[n][2];
+        }
+    }
+    triad(acc, mag, m_i, dcm);
+}
+
+/**
+ * @function build_reference()
+ * @param log the log
+ * @param m_i inertial magnetic field
+ * @param dcm returns the reference for every sample
+ * @return mean angle in degrees between a segment's integrated end and the
+ * next anchor, how far the reference itself can be trusted
+ */
+static double build_reference(const struct ahrs_log *log, const double m_i[MSZ],
+        double (*dcm)[MSZ * MSZ]) {
+    double bias[MSZ];
+    double rate[MSZ];
+    double end[MSZ * MSZ];
+    double t = 0;
+    double drift = 0;
+    long anchors = 0;
+    long n;
+    int i;
+
+    gyro_bias(log, bias);
+    for (n = 0; n < log->length; n++) {
+        for (i = 0; i < MSZ; i++) {
+            rate[i] = log->gyro[n][i] - bias[i];
+        }
+        t += log->dt[n];
+        if (n > 0) {
+            propagate(dcm[n - 1], rate, log->dt[n], dcm[n]);
+        }
+        if (n == 0 || t >= segment) {
+            memcpy(end, dcm[n], sizeof (end));
+            anchor(log, n, m_i, bias, dcm[n]);
+            if (n > 0) {
+                drift += dcm_angle(end, dcm[n]) * RAD2DEG;
+                anchors++;
+            }
+            t = 0;
+        }
+    }
+    return anchors > 0 ? drift / anchors : 0;
+}
+
+/**
+ * @function score_log()
+ * @param log the log to replay
+ * @param dcm reference for the log from build_reference()
+ * @param m_i inertial magnetic field for the log
+ * @param gains kp_a, ki_a, kp_m, ki_m
+ * @param score filled with the results for this log
+ */
+static void score_log(const struct ahrs_log *log, double (*dcm)[MSZ * MSZ],
+        const double m_i[MSZ], const double gains[NUM_GAINS], struct tune_score *score) {
+    float acc[MSZ];
+    float mag[MSZ];
+    float gyro[MSZ];
+    float q[QSZ] = {1, 0, 0, 0};
+    float bias[MSZ] = {0, 0, 0};
+    double bias_sum[MSZ] = {0, 0, 0};
+    double bias_sq_sum[MSZ] = {0, 0, 0};
+    double t = 0;
+    double t_below = 0; // time the error has been under the threshold
+    double conv_time = -1;
+    float mag_i[MSZ] = {m_i[0], m_i[1], m_i[2]};
+    double err = 0;
+    double err_sq_sum = 0;
+    long err_count = 0;
+    long bias_count = 0;
+    long half = log->length / 2;
+    long n;
+    int i;
+
+    AHRS_set_filter_gains(gains[0], gains[1], gains[2], gains[3]);
+    AHRS_set_state(q, bias);
+    AHRS_set_mag_inertial(mag_i);
+    for (n = 0; n < log->length; n++) {
+        for (i = 0; i < MSZ; i++) {
+            acc[i] = log->acc[n][i];
+            mag[i] = log->mag[n][i];
+            gyro[i] = log->gyro[n][i];
+        }
+        AHRS_update(acc, mag, gyro, log->dt[n], q, bias);
+        t += log->dt[n];
+        err = q_error(q, dcm[n]);
+        if (conv_time < 0) {
+            t_below = err < threshold ? t_below + log->dt[n] : 0;
+            if (t_below >= CONV_HOLD) conv_time = t - t_below;
+        } else {
+            err_sq_sum += err * err;
+            err_count++;
+        }
+        if (n >= half) {
+            for (i = 0; i < MSZ; i++) {
+                bias_sum[i] += bias[i];
+                bias_sq_sum[i] += bias[i] * bias[i];
+            }
+            bias_count++;
+        }
+    }
+    /* a filter that never converges is charged the whole log and its error */
+    score->conv_time = conv_time < 0 ? t : conv_time;
+    score->ss_err = err_count > 0 ? sqrt(err_sq_sum / err_count) * RAD2DEG : err * RAD2DEG;
+    score->bias_std = 0;
+    for (i = 0; i < MSZ; i++) {
+        bias_sum[i] /= bias_count;
+        score->bias_std += bias_sq_sum[i] / bias_count - bias_sum[i] * bias_sum[i];
+    }
+    score->bias_std = sqrt(fabs(score->bias_std)) * RAD2DEG;
+}
+
+/**
+ * @function evaluate()
+ * @param c candidate to score over every log
+ */
+static void evaluate(struct candidate *c) {
+    struct tune_score s;
+    int l;
+
+    memset(&c->score, 0, sizeof (c->score));
+    for (l = 0; l < num_logs; l++) {
+        score_log(&logs[l], reference[l], log_mag_inertial[l], c->gains, &s);
+        c->score.conv_time += s.conv_time / num_logs;
+        c->score.ss_err += s.ss_err / num_logs;
+        c->score.bias_std += s.bias_std / num_logs;
+    }
+    c->score.cost = weights[0] * c->score.conv_time / scales[0]
+            + weights[1] * c->score.ss_err / scales[1]
+            + weights[2] * c->score.bias_std / scales[2];
+}
+
+/**
+ * @function evaluate_batch()
+ * @param c candidates to score
+ * @param count number of candidates
+ * @param jobs number of worker processes
+ * @return SUCCESS or ERROR
+ * @brief splits the candidates into contiguous chunks, one per worker, the
+ * logs are shared copy-on-write from the parent
+ */
+static int8_t evaluate_batch(struct candidate *c, int count, int jobs) {
+    int pipes[MAX_JOBS];
+    int fds[2];
+    int first[MAX_JOBS + 1];
+    int j;
+    int k;
+    char *p;
+    ssize_t left;
+    ssize_t got;
+    int8_t status = SUCCESS;
+
+    if (jobs > count) jobs = count;
+    for (j = 0; j <= jobs; j++) {
+        first[j] = (int) ((long) count * j / jobs);
+    }
+    for (j = 0; j < jobs; j++) {
+        if (pipe(fds) != 0) return ERROR;
+        if (fork() == 0) {
+            close(fds[0]);
+            for (k = first[j]; k < first[j + 1]; k++) {
+                evaluate(&c[k]);
+            }
+            p = (char *) &c[first[j]];
+            left = (first[j + 1] - first[j]) * sizeof (*c);
+            while (left > 0) {
+                got = write(fds[1], p, left);
+                if (got <= 0) _exit(1);
+                p += got;
+                left -= got;
+            }
+            _exit(0);
+        }
+        close(fds[1]);
+        pipes[j] = fds[0];
+    }
+    /* read every pipe to the end so no worker blocks on a full pipe */
+    for (j = 0; j < jobs; j++) {
+        p = (char *) &c[first[j]];
+        left = (first[j + 1] - first[j]) * sizeof (*c);
+        while (left > 0) {
+            got = read(pipes[j], p, left);
+            if (got <= 0) {
+                status = ERROR;
+                break;
+            }
+            p += got;
+            left -= got;
+        }
+        close(pipes[j]);
+    }
+    while (wait(NULL) > 0);
+    return status;
+}
+
+/**
+ * @function compare_cost()
+ * @brief qsort comparison, lowest cost first
+ */
+static int compare_cost(const void *a, const void *b) {
+    double ca = ((const struct candidate *) a)->score.cost;
+    double cb = ((const struct candidate *) b)->score.cost;
+    return (ca > cb) - (ca < cb);
+}
+
+/**
+ * @function clamp_gains()
+ */
+static void clamp_gains(double gains[NUM_GAINS]) {
+    int g;
+    for (g = 0; g < NUM_GAINS; g++) {
+        if (gains[g] < gain_min[g]) gains[g] = gain_min[g];
+        if (gains[g] > gain_max[g]) gains[g] = gain_max[g];
+    }
+}
+
+/**
+ * @function on_bound()
+ * @param gains to check
+ * @return index of the first gain within BOUND_MARGIN of gain_min or
+ * gain_max, or -1, a search that ends there was stopped by the bound and not
+ * by the logs
+ */
+static int on_bound(const double gains[NUM_GAINS]) {
+    int g;
+    for (g = 0; g < NUM_GAINS; g++) {
+        if (gains[g] <= gain_min[g] * (1.0 + BOUND_MARGIN)
+                || gains[g] >= gain_max[g] / (1.0 + BOUND_MARGIN)) {
+            return g;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @function gaussian()
+ * @return a standard normal sample (Box-Muller)
+ */
+static double gaussian(void) {
+    double u1 = drand48();
+    double u2 = drand48();
+    if (u1 < 1e-300) u1 = 1e-300;
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+/**
+ * @function search_grid()
+ * @param points per gain, log spaced between the bounds
+ * @param count returns the number of candidates
+ * @return candidates, caller frees
+ */
+static struct candidate *search_grid(int points, int jobs, int *count) {
+    struct candidate *c;
+    int n = 1;
+    int k;
+    int g;
+    int idx;
+
+    for (g = 0; g < NUM_GAINS; g++) n *= points;
+    c = calloc(n, sizeof (*c));
+    if (c == NULL) return NULL;
+    for (k = 0; k < n; k++) {
+        idx = k;
+        for (g = 0; g < NUM_GAINS; g++) {
+            c[k].gains[g] = gain_min[g] * pow(gain_max[g] / gain_min[g],
+                    points > 1 ? (double) (idx % points) / (points - 1) : 0.5);
+            idx /= points;
+        }
+    }
+    evaluate_batch(c, n, jobs);
+    *count = n;
+    return c;
+}
+
+/**
+ * @function search_random()
+ * @param n number of log-uniform samples, the defaults are always included
+ * @param count returns the number of candidates
+ * @return candidates, caller frees
+ */
+static struct candidate *search_random(int n, int jobs, int *count) {
+    struct candidate *c = calloc(n, sizeof (*c));
+    int k;
+    int g;
+
+    if (c == NULL) return NULL;
+    for (k = 0; k < n; k++) {
+        for (g = 0; g < NUM_GAINS; g++) {
+            c[k].gains[g] = k == 0 ? gain_default[g] :
+                    gain_min[g] * pow(gain_max[g] / gain_min[g], drand48());
+        }
+    }
+    evaluate_batch(c, n, jobs);
+    *count = n;
+    return c;
+}
+
+/**
+ * @function search_cma()
+ * @param n total evaluations, CMA_LAMBDA per generation
+ * @param count returns the number of candidates
+ * @return candidates of every generation, caller frees
+ * @brief (mu/mu_w, lambda) evolution strategy in ln(gain) with a diagonal
+ * covariance, started from the defaults in AHRS.c
+ */
+static struct candidate *search_cma(int n, int jobs, int *count) {
+    int generations = n / CMA_LAMBDA > 0 ? n / CMA_LAMBDA : 1;
+    struct candidate *all = calloc(generations * CMA_LAMBDA, sizeof (*all));
+    struct candidate *gen;
+    double mean[NUM_GAINS];
+    double sigma[NUM_GAINS];
+    double new_mean[NUM_GAINS];
+    double var[NUM_GAINS];
+    double w[CMA_LAMBDA / 2];
+    double w_sum = 0;
+    double d;
+    int mu = CMA_LAMBDA / 2;
+    int k;
+    int g;
+    int i;
+
+    if (all == NULL) return NULL;
+    for (i = 0; i < mu; i++) {
+        w[i] = log(mu + 0.5) - log(i + 1.0);
+        w_sum += w[i];
+    }
+    for (g = 0; g < NUM_GAINS; g++) {
+        mean[g] = log(gain_default[g]);
+        sigma[g] = CMA_SIGMA;
+    }
+    for (i = 0; i < generations; i++) {
+        gen = &all[i * CMA_LAMBDA];
+        for (k = 0; k < CMA_LAMBDA; k++) {
+            for (g = 0; g < NUM_GAINS; g++) {
+                gen[k].gains[g] = exp(mean[g] + sigma[g] * gaussian());
+            }
+            clamp_gains(gen[k].gains);
+        }
+        evaluate_batch(gen, CMA_LAMBDA, jobs);
+        qsort(gen, CMA_LAMBDA, sizeof (*gen), compare_cost);
+        for (g = 0; g < NUM_GAINS; g++) {
+            new_mean[g] = 0;
+            var[g] = 0;
+            for (k = 0; k < mu; k++) {
+                d = log(gen[k].gains[g]);
+                new_mean[g] += w[k] / w_sum * d;
+                var[g] += w[k] / w_sum * (d - mean[g]) * (d - mean[g]);
+            }
+            sigma[g] = sqrt((1.0 - CMA_LEARN) * sigma[g] * sigma[g] + CMA_LEARN * var[g]);
+            mean[g] = new_mean[g];
+        }
+        printf("generation %3d: best cost %8.4f, sigma %.3f %.3f %.3f %.3f\n", i,
+                gen[0].score.cost, sigma[0], sigma[1], sigma[2], sigma[3]);
+    }
+    *count = generations * CMA_LAMBDA;
+    return all;
+}
+
+int main(int argc, char **argv) {
+    struct candidate *c = NULL;
+    struct candidate defaults;
+    const char *strategy = "cma";
+    int count = 0;
+    int n = 2000;
+    int points = 6;
+    int jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    long seed = time(NULL);
+    float gyro_scale = AHRS_LOG_DEG2RAD;
+    long total_samples = 0;
+    struct timespec t0;
+    struct timespec t1;
+    double drift;
+    int8_t fixed_mag = FALSE;
+    int opt;
+    int i;
+    int g;
+
+    while ((opt = getopt(argc, argv, "s:n:k:j:g:t:w:r:S:f")) != -1) {
+        switch (opt) {
+            case 's': strategy = optarg;
+                break;
+            case 'n': n = atoi(optarg);
+                break;
+            case 'k': points = atoi(optarg);
+                break;
+            case 'j': jobs = atoi(optarg);
+                break;
+            case 'g': gyro_scale = atof(optarg);
+                break;
+            case 't': threshold = atof(optarg) / RAD2DEG;
+                break;
+            case 'w': sscanf(optarg, "%lf,%lf,%lf", &weights[0], &weights[1], &weights[2]);
+                break;
+            case 'r': seed = atol(optarg);
+                break;
+            case 'S': segment = atof(optarg);
+                break;
+            case 'f': fixed_mag = TRUE;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-s grid|random|cma] [-n candidates] [-k points] "
+                        "[-j jobs] [-g gyro scale] [-t deg] [-w conv,ss,bias] [-r seed] [-S s] [-f] log.csv ...\n", argv[0]);
+                return 1;
+        }
+    }
+    if (jobs < 1) jobs = 1;
+    if (jobs > MAX_JOBS) jobs = MAX_JOBS;
+    for (i = optind; i < argc && num_logs < MAX_LOGS; i++) {
+        if (ahrs_log_load(argv[i], gyro_scale, &logs[num_logs]) != SUCCESS) {
+            fprintf(stderr, "%s: could not be loaded, skipped\n", argv[i]);
+            continue;
+        }
+        if (fixed_mag == TRUE) {
+            memcpy(log_mag_inertial[num_logs], mag_inertial, sizeof (mag_inertial));
+        } else {
+            match_inclination(&logs[num_logs], log_mag_inertial[num_logs]);
+        }
+        reference[num_logs] = malloc(logs[num_logs].length * sizeof (*reference[num_logs]));
+        if (reference[num_logs] == NULL) {
+            fprintf(stderr, "%s: no memory for its reference, skipped\n", argv[i]);
+            ahrs_log_free(&logs[num_logs]);
+            continue;
+        }
+        drift = build_reference(&logs[num_logs], log_mag_inertial[num_logs],
+                reference[num_logs]);
+        printf("%s: %ld samples, reference drift %.2f deg per segment\n", argv[i],
+                logs[num_logs].length, drift);
+        total_samples += logs[num_logs].length;
+        num_logs++;
+    }
+    if (num_logs == 0) {
+        fprintf(stderr, "no logs to tune over\n");
+        return 1;
+    }
+    srand48(seed);
+    printf("AHRS gain tuner %s, %s: %d logs, %ld samples, %s search, %d jobs, seed %ld\n",
+            __DATE__, __TIME__, num_logs, total_samples, strategy, jobs, seed);
+
+    /* the defaults set the scale of each cost term, so their cost is the sum
+     * of the weights */
+    memcpy(defaults.gains, gain_default, sizeof (defaults.gains));
+    evaluate(&defaults);
+    scales[0] = defaults.score.conv_time > 0 ? defaults.score.conv_time : 1.0;
+    scales[1] = defaults.score.ss_err > 0 ? defaults.score.ss_err : 1.0;
+    scales[2] = defaults.score.bias_std > 0 ? defaults.score.bias_std : 1.0;
+    evaluate(&defaults);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (strcmp(strategy, "grid") == 0) {
+        c = search_grid(points, jobs, &count);
+    } else if (strcmp(strategy, "random") == 0) {
+        c = search_random(n, jobs, &count);
+    } else {
+        c = search_cma(n, jobs, &count);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if (c == NULL || count == 0) return 1;
+    qsort(c, count, sizeof (*c), compare_cost);
+
+    printf("\n%d candidates in %.2f s (%.0f candidates/s)\n", count,
+            (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9,
+            count / ((t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9));
+    printf("\n%-9s %9s %9s %9s %9s %10s %10s %10s %9s\n", "", gain_names[0], gain_names[1],
+            gain_names[2], gain_names[3], "conv s", "ss deg", "bias dps", "cost");
+    printf("%-9s %9.4f %9.5f %9.4f %9.5f %10.3f %10.4f %10.5f %9.4f\n", "default",
+            defaults.gains[0], defaults.gains[1], defaults.gains[2], defaults.gains[3],
+            defaults.score.conv_time, defaults.score.ss_err, defaults.score.bias_std,
+            defaults.score.cost);
+    for (i = 0; i < NUM_BEST && i < count; i++) {
+        printf("best %-4d %9.4f %9.5f %9.4f %9.5f %10.3f %10.4f %10.5f %9.4f\n", i + 1,
+                c[i].gains[0], c[i].gains[1], c[i].gains[2], c[i].gains[3],
+                c[i].score.conv_time, c[i].score.ss_err, c[i].score.bias_std, c[i].score.cost);
+    }
+    g = on_bound(c[0].gains);
+    if (g >= 0) {
+        printf("\n%s = %g ended on its search bound, the logs do not pin it down; "
+                "not printed as gains to use\n", gain_names[g], c[0].gains[g]);
+    } else if (c[0].score.cost >= defaults.score.cost) {
+        printf("\nno candidate beat the defaults, keep them\n");
+    } else {
+        printf("\n/*filter gains, tuned by ahrs_tune over %d logs*/\n", num_logs);
+        for (g = 0; g < NUM_GAINS; g++) {
+            printf("float %s = %g;\n", gain_names[g], c[0].gains[g]);
+        }
+    }
+    free(c);
+    for (i = 0; i < num_logs; i++) {
+        ahrs_log_free(&logs[i]);
+        free(reference[i]);
+    }
+    return 0;
+}
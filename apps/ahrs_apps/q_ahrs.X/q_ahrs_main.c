@@ -10,15 +10,18 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <math.h>
+#include "Board.h"
+#include "Lin_alg_float.h"
+#include "Lin_alg_rot.h"
+#ifndef AHRS_REPLAY // hardware is not needed to replay logs on a host, see ahrs_replay.c
 #include <sys/attribs.h>  //for ISR definitions
 #include <proc/p32mx795f512l.h>
 #include <xc.h>
-#include "Board.h"
 #include "ICM_20948.h"  
 #include "ICM_20948_registers.h" 
-#include "lin_alg_float.h"
 #include "SerialM32.h"
 #include "System_timer.h"
+#endif
 /*******************************************************************************
  * #DEFINES                                                                    *
  ******************************************************************************/
@@ -30,59 +33,6 @@
  * FUNCTIONS                                                                    *
  ******************************************************************************/
 
-/**
- * @function quat2euler()
- * @param q A quaternion
- * @param euler a vector of euler angles in [psi, theta, roll] order
- */
-void quat2euler(float q[MSZ], float euler[MSZ]) {
-    float q00 = q[0] * q[0];
-    float q11 = q[1] * q[1];
-    float q22 = q[2] * q[2];
-    float q33 = q[3] * q[3];
-
-    // psi
-    euler[0] = atan2(2.0 * (q[1] * q[2] + q[0] * q[3]), ((q00 + q11 - q22 - q33)));
-    // theta
-    euler[1] = asin(2.0 * (q[0] * q[2] - q[1] * q[3]));
-    // phi
-    euler[2] = atan2(2.0 * (q[2] * q[3] + q[0] * q[1]), q00 - q11 - q22 + q33);
-}
-
-/**
- * @function q_rot_v_q()
- * Rotate a vector from the inertial frame to the body frame
- * @param v_i, a 3space vector in the inertial frame
- * @param q an attitude quaternion
- * sets v_b to the rotated inertial vector in the body frame
- */
-void q_rot_v_q(float v_i[MSZ], float q[QSZ], float v_b[MSZ]) {
-    float q_i[QSZ];
-    float q_temp[QSZ];
-    float q_conj[QSZ];
-    float q_b[QSZ]; // container for inertial vector in body frame as pure quaternion
-
-    // calculate conjugate of q 
-    q_conj[0] = q[0];
-    q_conj[1] = -q[1];
-    q_conj[2] = -q[2];
-    q_conj[3] = -q[3];
-
-    //   convert v_i to a pure quaternion --> q_i
-    q_i[0] = 0;
-    q_i[1] = v_i[0];
-    q_i[2] = v_i[1];
-    q_i[3] = v_i[2];
-    //   first quaternion product q_i by q --> q_temp
-    lin_alg_q_mult(q_i, q, q_temp);
-    //   second quaternion product q_conj by q_temp -->q_b
-    lin_alg_q_mult(q_conj, q_temp, q_b);
-    //    set v_b to imaginary part of q_b
-    v_b[0] = q_b[1];
-    v_b[1] = q_b[2];
-    v_b[2] = q_b[3];
-}
-
 void v_copy(float m_in[MSZ], float m_out[MSZ]) {
     int row;
     for (row = 0; row < MSZ; row++) {
@@ -133,14 +83,14 @@ void ahrs_update(float q_minus[QSZ], float bias_minus[MSZ], float gyros[MSZ],
     mags[2] = mags[2] / mag_n;
 
     /*Accelerometer attitude calculations */
-    q_rot_v_q(acc_i, q_minus, acc_b); //estimate gravity vector in body frame 
+    lin_alg_q_rot_v(acc_i, q_minus, acc_b); //estimate gravity vector in body frame 
     lin_alg_cross(accels, acc_b, w_meas_ap); // calculate the accelerometer rate term
     v_copy(w_meas_ap, w_meas_ai); // make a copy for the integral term
     lin_alg_v_scale(kp_a, w_meas_ap); // calculate the accelerometer proportional feedback term 
     lin_alg_v_scale(ki_a, w_meas_ai); // calculate the accelerometer integral feedback term 
 
     /*Magnetometer attitude calculations*/
-    q_rot_v_q(mag_i, q_minus, mag_b); //estimate magnetic field vector in body frame
+    lin_alg_q_rot_v(mag_i, q_minus, mag_b); //estimate magnetic field vector in body frame
     lin_alg_cross(mags, mag_b, w_meas_mp); // calculate the magnetometer rate term
     v_copy(w_meas_mp, w_meas_mi); //make a copy for the integral term
     lin_alg_v_scale(kp_m, w_meas_mp); // calculate the magnetometer proportional feedback term
@@ -181,6 +131,7 @@ void ahrs_update(float q_minus[QSZ], float bias_minus[MSZ], float gyros[MSZ],
     bias_plus[2] = bias_minus[2] - (w_meas_ai[2] + w_meas_mi[2]) * dt;
 }
 
+#ifndef AHRS_REPLAY
 int main(void) {
     uint32_t start_time = 0;
     const uint32_t warmup_time = 250; //msec
@@ -278,7 +229,7 @@ int main(void) {
             ahrs_update(q_minus, b_minus, gyro_cal, mag_cal, acc_cal, m_i,
                     a_i, dt, kp_a, ki_a, kp_m, ki_m, q_plus, b_plus);
             update_end = Sys_timer_get_usec();
-            quat2euler(q_plus, euler);
+            lin_alg_quat2euler(q_plus, euler);
 
             printf("%+3.1f, %+3.1f, %+3.1f, ", euler[0] * rad2deg, euler[1] * rad2deg, euler[2] * rad2deg);
             printf("%+1.3e, %+1.3e, %+1.3e, ", b_plus[0], b_plus[1], b_plus[2]);
@@ -295,3 +246,4 @@ int main(void) {
     }
     return 0;
 }
+#endif /* AHRS_REPLAY */
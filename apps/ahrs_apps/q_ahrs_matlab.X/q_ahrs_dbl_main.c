@@ -14,6 +14,7 @@
 #include <proc/p32mx795f512l.h>
 #include <xc.h>
 #include "Board.h"
+#include "Lin_alg_rot.h"
 #include "ICM_20948.h"  
 #include "ICM_20948_registers.h" 
 #include "SerialM32.h"
@@ -31,9 +32,7 @@
 /*******************************************************************************
  * FUNCTION PROTOTYPES                                                         *
  ******************************************************************************/
-void quat2euler(double q[MSZ], double euler[MSZ]);
 void lin_alg_q_mult(double q[QSZ], double p[QSZ], double r[QSZ]);
-void q_rot_v_q(double v_i[MSZ], double q[QSZ], double v_b[MSZ]);
 void v_copy(double m_in[MSZ], double m_out[MSZ]);
 void lin_alg_cross(double u[MSZ], double v[MSZ], double w_out[MSZ]);
 void lin_alg_v_scale(double s, double v[MSZ]);
@@ -45,25 +44,6 @@ double lin_alg_q_norm(double q[QSZ]);
  * FUNCTIONS                                                                    *
  ******************************************************************************/
 
-/**
- * @function quat2euler()
- * @param q A quaternion
- * @param euler a vector of euler angles in [psi, theta, roll] order
- */
-void quat2euler(double q[MSZ], double euler[MSZ]) {
-    double q00 = q[0] * q[0];
-    double q11 = q[1] * q[1];
-    double q22 = q[2] * q[2];
-    double q33 = q[3] * q[3];
-
-    // psi
-    euler[0] = atan2(2.0 * (q[1] * q[2] + q[0] * q[3]), ((q00 + q11 - q22 - q33)));
-    // theta
-    euler[1] = asin(2.0 * (q[0] * q[2] - q[1] * q[3]));
-    // phi
-    euler[2] = atan2(2.0 * (q[2] * q[3] + q[0] * q[1]), q00 - q11 - q22 + q33);
-}
-
 /**
  * @function lin_alg_q_mult()
  * Multiply two quaternions together
@@ -78,40 +58,6 @@ void lin_alg_q_mult(double q[QSZ], double p[QSZ], double r[QSZ]) {
     r[3] = p[3] * q[0] + p[2] * q[1] - p[1] * q[2] + p[0] * q[3];
 }
 
-/**
- * @function q_rot_v_q()
- * Rotate a vector from the inertial frame to the body frame
- * @param v_i, a 3space vector in the inertial frame
- * @param q an attitude quaternion
- * sets v_b to the rotated inertial vector in the body frame
- */
-void q_rot_v_q(double v_i[MSZ], double q[QSZ], double v_b[MSZ]) {
-    double q_i[QSZ];
-    double q_temp[QSZ];
-    double q_conj[QSZ];
-    double q_b[QSZ]; // container for inertial vector in body frame as pure quaternion
-
-    // calculate conjugate of q 
-    q_conj[0] = q[0];
-    q_conj[1] = -q[1];
-    q_conj[2] = -q[2];
-    q_conj[3] = -q[3];
-
-    //   convert v_i to a pure quaternion --> q_i
-    q_i[0] = 0;
-    q_i[1] = v_i[0];
-    q_i[2] = v_i[1];
-    q_i[3] = v_i[2];
-    //   first quaternion product q_i by q --> q_temp
-    lin_alg_q_mult(q_i, q, q_temp);
-    //   second quaternion product q_conj by q_temp -->q_b
-    lin_alg_q_mult(q_conj, q_temp, q_b);
-    //    set v_b to imaginary part of q_b
-    v_b[0] = q_b[1];
-    v_b[1] = q_b[2];
-    v_b[2] = q_b[3];
-}
-
 void v_copy(double m_in[MSZ], double m_out[MSZ]) {
     int row;
     for (row = 0; row < MSZ; row++) {
@@ -208,14 +154,14 @@ void ahrs_update(double q_minus[QSZ], double q_plus[QSZ], double bias_minus[MSZ]
 
 
     /*Accelerometer attitude calculations */
-    q_rot_v_q(acc_i, q_minus, acc_b); //estimate gravity vector in body frame 
+    lin_alg_q_rot_v_dbl(acc_i, q_minus, acc_b); //estimate gravity vector in body frame 
     lin_alg_cross(accels, acc_b, w_meas_ap); // calculate the accelerometer rate term
     v_copy(w_meas_ap, w_meas_ai); // make a copy for the integral term
     lin_alg_v_scale(kp_a, w_meas_ap); // calculate the accelerometer proportional feedback term 
     lin_alg_v_scale(ki_a, w_meas_ai); // calculate the accelerometer integral feedback term 
 
     /*Magnetometer attitude calculations*/
-    q_rot_v_q(mag_i, q_minus, mag_b); //estimate magnetic field vector in body frame
+    lin_alg_q_rot_v_dbl(mag_i, q_minus, mag_b); //estimate magnetic field vector in body frame
     lin_alg_cross(mags, mag_b, w_meas_mp); // calculate the magnetometer rate term
     v_copy(w_meas_mp, w_meas_mi); //make a copy for the integral term
     lin_alg_v_scale(kp_m, w_meas_mp); // calculate the magnetometer proportional feedback term
@@ -352,7 +298,7 @@ int main(void) {
             ahrs_q_update(q_minus, b_minus, gyro_cal, mag_cal, acc_cal, m_i,
                     a_i, dt, kp_a, ki_a, kp_m, ki_m, q_plus, b_plus);
             update_end = Sys_timer_get_usec();
-            quat2euler(q_plus, euler);
+            lin_alg_quat2euler_dbl(q_plus, euler);
 
             printf("%+3.1f, %+3.1f, %+3.1f, ", euler[0] * rad2deg, euler[1] * rad2deg, euler[2] * rad2deg);
             printf("%+1.3e, %+1.3e, %+1.3e, ", b_plus[0], b_plus[1], b_plus[2]);
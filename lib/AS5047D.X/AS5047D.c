@@ -13,6 +13,7 @@
 #include "AS5047D.h" // The header file for this source file. 
 #include "SerialM32.h"
 #include "Board.h"
+#include "System_timer.h"
 #include <stdio.h>
 #include <sys/attribs.h>  //for ISR definitions
 #include <proc/p32mx795f512l.h>
@@ -225,6 +226,8 @@ void Encoder_init_encoder_data(encoder_ptr_t enc) {
     enc->last_theta = 0;
     enc->next_theta = 0;
     enc->omega = 0;
+    enc->last_time = 0;
+    enc->next_time = 0;
 }
 
 /**
@@ -242,6 +245,8 @@ int8_t Encoder_is_data_ready(void) {
  * @Function Encoder_get_data(encoder_t * data)
  * @param encoder_t data--to receive private encoder data 
  * @brief copies internal encoder data to data
+ * @note omega is per read, divide by Sys_timer_dt(last_time, next_time) for the
+ * rate over the true interval between reads
  * @author Aaron Hunter
  */
 int8_t Encoder_get_data(encoder_t * data) {
@@ -250,6 +255,8 @@ int8_t Encoder_get_data(encoder_t * data) {
         data[i].last_theta = encoder_data[i].last_theta;
         data[i].next_theta = encoder_data[i].next_theta;
         data[i].omega = encoder_data[i].omega;
+        data[i].last_time = encoder_data[i].last_time;
+        data[i].next_time = encoder_data[i].next_time;
     }
     data_ready = FALSE;
     return SUCCESS;
@@ -425,10 +432,13 @@ static void run_encoder_SM(uint16_t data_short) {
     static int16_t last_theta;
     static int16_t next_theta;
     int32_t w; //temp variable for instantaneous velocity
+    uint64_t now = Sys_timer_get_ticks(); //capture time of this angle
 
     switch (current_state) {
         case ENC_START:
             encoder_data[LEFT_MOTOR].last_theta = encoder_data[LEFT_MOTOR].next_theta;
+            encoder_data[LEFT_MOTOR].last_time = encoder_data[LEFT_MOTOR].next_time;
+            encoder_data[LEFT_MOTOR].next_time = now;
             /*read LEFT_MOTOR encoder, subtract from 2pi to correct for orientation */
             encoder_data[LEFT_MOTOR].next_theta = TWO_PI - (0x3FFF & data_short); //mask top bits
             /*update encoder 1 data struct*/
@@ -448,6 +458,8 @@ static void run_encoder_SM(uint16_t data_short) {
             break;
         case(ENC_NEXT):
             encoder_data[RIGHT_MOTOR].last_theta = encoder_data[RIGHT_MOTOR].next_theta;
+            encoder_data[RIGHT_MOTOR].last_time = encoder_data[RIGHT_MOTOR].next_time;
+            encoder_data[RIGHT_MOTOR].next_time = now;
             /*read the RIGHT_MOTOR angle*/
             encoder_data[RIGHT_MOTOR].next_theta = 0x3FFF & data_short; //mask top bits
             /*update RIGHT_MOTOR data struct*/
@@ -467,6 +479,8 @@ static void run_encoder_SM(uint16_t data_short) {
             break;
         case ENC_LAST:
             encoder_data[HEADING].last_theta = encoder_data[HEADING].next_theta;
+            encoder_data[HEADING].last_time = encoder_data[HEADING].next_time;
+            encoder_data[HEADING].next_time = now;
             /*read the HEADING angle*/
             encoder_data[HEADING].next_theta = 0x3FFF & data_short; //mask top bits
             /*update HEADING data struct*/
@@ -36,6 +36,8 @@ typedef struct encoder {
     int16_t last_theta; //old angle
     int16_t next_theta; //new angle
     int16_t omega; //angular velocity
+    uint64_t last_time; //Sys_timer_get_ticks() when last_theta was read
+    uint64_t next_time; //Sys_timer_get_ticks() when next_theta was read
 } encoder_t;
 
 typedef struct encoder* encoder_ptr_t; //pointer to encoder struct
@@ -94,6 +96,8 @@ void Encoder_init_encoder_data(encoder_ptr_t enc);
  * @Function Encoder_get_data(encoder_t * data)
  * @param encoder_t data--to receive private encoder data 
  * @brief copies internal encoder data to data
+ * @note omega is per read, divide by Sys_timer_dt(last_time, next_time) for the
+ * rate over the true interval between reads
  * @author Aaron Hunter
  */
 int8_t Encoder_get_data(encoder_t * data);
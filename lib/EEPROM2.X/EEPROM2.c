@@ -1,9 +1,10 @@
 /* 
  * File:   EEPROM2.c
  * Author: Aaron Hunter
- * Brief: Blocking version of EEPROM library
+ * Brief: Blocking version of EEPROM library, with a page write that returns
+ * before the write cycle for callers that cannot wait it out
  * Created on 06/15/2021 7:41 am
- * Modified on 
+ * Modified on 10/17/2026
  */
 
 /*******************************************************************************
@@ -50,6 +51,7 @@ typedef struct {
 } EEPROM_settings_t;
 
 static EEPROM_settings_t EEPROM_settings;
+static uint8_t write_cycle = FALSE; // a page write is being committed
 /*******************************************************************************
  * PRIVATE FUNCTIONS PROTOTYPES                                                 *
  ******************************************************************************/
@@ -134,6 +136,18 @@ static int8_t EEPROM_read_data(uint8_t data[], uint8_t length, uint32_t page, ui
  */
 static int8_t EEPROM_write_data(uint8_t data[], uint8_t length, uint32_t page, uint32_t offset);
 
+/**
+ * @Function EEPROM_send_page(uint8_t data[], uint8_t length, uint32_t page, uint32_t offset)
+ * @param uint8_t data[], pointer to data
+ * @param uint8_t length, number of bytes to write <= PAGESIZE
+ * @param, uint32_t page < NUMPAGES, which page to write the data into
+ * @param, uint32_t offset <PAGESIZE, local address within the page
+ * @return SUCCESS or ERROR
+ * @brief sends 1 to PAGESIZE bytes to EEPROM, which then starts its write cycle
+ * @author Aaron Hunter
+ */
+static int8_t EEPROM_send_page(uint8_t data[], uint8_t length, uint32_t page, uint32_t offset);
+
 /*******************************************************************************
  * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
  ******************************************************************************/
@@ -183,6 +197,40 @@ int8_t EEPROM_read_byte_array(uint8_t data[], uint8_t length, uint32_t page, uin
     return EEPROM_read_data(data, length, page, offset);
 }
 
+/**
+ * @Function EEPROM_start_write_byte_array(uint8_t data[], uint8_t length, uint32_t page, uint32_t offset)
+ * @param uint8_t data[], pointer to data
+ * @param uint8_t length, number of bytes to write <= PAGESIZE (64 bytes)
+ * @param, uint32_t page < NUMPAGES (512), which page to write the data into
+ * @param, uint32_t offset <PAGESIZE, local address within the page
+ * @return SUCCESS or ERROR
+ * @brief sends 1 to PAGESIZE bytes to EEPROM without waiting for the write
+ * cycle, poll EEPROM_is_busy() until it ends
+ * @author Aaron Hunter
+ */
+int8_t EEPROM_start_write_byte_array(uint8_t data[], uint8_t length, uint32_t page, uint32_t offset) {
+    return EEPROM_send_page(data, length, page, offset);
+}
+
+/**
+ * @Function EEPROM_is_busy(void)
+ * @return TRUE while a page write cycle runs, FALSE once it is done
+ * @brief one acknowledge poll of the EEPROM, which NACKs its address until
+ * the write cycle ends
+ * @author Aaron Hunter
+ */
+uint8_t EEPROM_is_busy(void) {
+    if (write_cycle == FALSE) {
+        return FALSE;
+    }
+    EEPROM_start();
+    if (EEPROM_send_byte(EEPROM_I2C_ADDR << 1 | WRITE) == SUCCESS) {
+        write_cycle = FALSE;
+    }
+    EEPROM_stop();
+    return write_cycle;
+}
+
 /**
  * @Function  EEPROM_write_short_array(uint16_t data[], uint8_t length, uint32_t page, uint32_t offset)
  * @param uint16_t data[], pointer to data
@@ -443,6 +491,7 @@ static void EEPROM_delay(void) {
         EEPROM_stop();
     }
     EEPROM_stop();
+    write_cycle = FALSE;
 }
 
 /**
@@ -459,7 +508,7 @@ static void EEPROM_delay(void) {
 static int8_t EEPROM_read_data(uint8_t data[], uint8_t length, uint32_t page, uint32_t offset) {
     uint32_t address;
     //    EEPROM_busy = TRUE;
-    if ((length <= PAGESIZE)&& (page < NUMPAGES) && (offset + length < PAGESIZE)) {
+    if ((length <= PAGESIZE)&& (page < NUMPAGES) && (offset + length <= PAGESIZE)) {
         address = (page << LOG64 | offset); //set the address of data
         EEPROM_settings.mem_high_byte = (uint8_t) (address >> 8); //mask off high byte
         EEPROM_settings.mem_low_byte = (uint8_t) address; //mask off low byte
@@ -471,6 +520,10 @@ static int8_t EEPROM_read_data(uint8_t data[], uint8_t length, uint32_t page, ui
         //        printf("Bad address or array too large\r\n");
         return ERROR;
     }
+    // a started page write NACKs everything until it is done
+    if (write_cycle == TRUE) {
+        EEPROM_delay();
+    }
     // send start command
     EEPROM_start();
     // send device address
@@ -520,8 +573,27 @@ static int8_t EEPROM_read_data(uint8_t data[], uint8_t length, uint32_t page, ui
  * @author Aaron Hunter
  */
 static int8_t EEPROM_write_data(uint8_t data[], uint8_t length, uint32_t page, uint32_t offset) {
+    if (EEPROM_send_page(data, length, page, offset) == ERROR) {
+        return ERROR;
+    }
+    // delay until page write completes
+    EEPROM_delay();
+    return SUCCESS;
+}
+
+/**
+ * @Function EEPROM_send_page(uint8_t data[], uint8_t length, uint32_t page, uint32_t offset)
+ * @param uint8_t data[], pointer to data
+ * @param uint8_t length, number of bytes to write <= PAGESIZE
+ * @param, uint32_t page < NUMPAGES, which page to write the data into
+ * @param, uint32_t offset <PAGESIZE, local address within the page
+ * @return SUCCESS or ERROR
+ * @brief sends 1 to PAGESIZE bytes to EEPROM, which then starts its write cycle
+ * @author Aaron Hunter
+ */
+static int8_t EEPROM_send_page(uint8_t data[], uint8_t length, uint32_t page, uint32_t offset) {
     uint32_t address;
-    if ((length <= PAGESIZE)&& (page < NUMPAGES) && (offset + length < PAGESIZE)) {
+    if ((length <= PAGESIZE)&& (page < NUMPAGES) && (offset + length <= PAGESIZE)) {
         address = (page << LOG64 | offset); //set the address of data
         EEPROM_settings.mem_high_byte = (uint8_t) (address >> 8); //mask off high byte
         EEPROM_settings.mem_low_byte = (uint8_t) address; //mask off low byte
@@ -533,6 +605,9 @@ static int8_t EEPROM_write_data(uint8_t data[], uint8_t length, uint32_t page, u
         //        printf("Bad address or array too large\r\n");
         return ERROR;
     }
+    if (write_cycle == TRUE) {
+        EEPROM_delay();
+    }
     // send start command
     EEPROM_start();
     // send device address
@@ -555,8 +630,7 @@ static int8_t EEPROM_write_data(uint8_t data[], uint8_t length, uint32_t page, u
     }
     // stop transaction
     EEPROM_stop();
-    // delay until page write completes
-    EEPROM_delay();
+    write_cycle = TRUE;
     return SUCCESS;
 }
 
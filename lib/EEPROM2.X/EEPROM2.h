@@ -1,9 +1,10 @@
 /* 
  * File:   EEPROM2.h
  * Author: Aaron Hunter
- * Brief: Blocking version of EEPROM library
+ * Brief: Blocking version of EEPROM library, with a page write that returns
+ * before the write cycle for callers that cannot wait it out
  * Created on 06/15/2021 7:41 am
- * Modified on 
+ * Modified on 10/17/2026
  */
 
 #ifndef EEPROM2_H // Header guard
@@ -53,6 +54,29 @@ uint8_t EEPROM_init(void);
  */
 int8_t EEPROM_write_byte_array(uint8_t data[], uint8_t length, uint32_t page, uint32_t offset);
 
+/**
+ * @Function EEPROM_start_write_byte_array(uint8_t data[], uint8_t length, uint32_t page, uint32_t offset)
+ * @param uint8_t data[], pointer to data
+ * @param uint8_t length, number of bytes to write <= PAGESIZE (64 bytes)
+ * @param, uint32_t page < NUMPAGES (512), which page to write the data into
+ * @param, uint32_t offset <PAGESIZE, local address within the page
+ * @return SUCCESS or ERROR
+ * @brief sends 1 to PAGESIZE bytes to the EEPROM and returns without waiting
+ * for the page write cycle (about 5 msec), poll EEPROM_is_busy() until it
+ * ends.  Any other transfer started before then waits for it.
+ * @author Aaron Hunter
+ */
+int8_t EEPROM_start_write_byte_array(uint8_t data[], uint8_t length, uint32_t page, uint32_t offset);
+
+/**
+ * @Function EEPROM_is_busy(void)
+ * @return TRUE while a write cycle started by EEPROM_start_write_byte_array()
+ * runs, FALSE once it is done
+ * @brief polls the EEPROM for its acknowledge once, no wait
+ * @author Aaron Hunter
+ */
+uint8_t EEPROM_is_busy(void);
+
 /**
  * @Function EEPROM_read_byte_array(uint8_t data[], uint8_t length, uint32_t page, uint32_t offset)
  * @param uint8_t data[], pointer to data storage
@@ -0,0 +1,259 @@
+/*
+ * File:   Event_log.c
+ * Brief: Binary event log over LOGGING_DATA, see Event_log.h.  The
+ * EVENT_LOG_TESTING harness times the GNC odometry report formatted with
+ * sprintf() against the same report packed as a record and prints the cycles
+ * and bytes of each.
+ * Created on 10/16/2026
+ * Modified on 10/17/2026
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+
+#include "Event_log.h" // The header file for this source file.
+#include "Board.h"
+#include "System_timer.h"
+#include <stdarg.h>
+#include <string.h>
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#define LOG_BUFFER_LENGTH MAVLINK_MSG_LOGGING_DATA_FIELD_DATA_LEN
+#define LOG_MAX_RECORD (LOG_HEADER_LENGTH + LOG_MAX_ARGS * (LOG_MAX_STRING + 1))
+#define DEG_TO_E7 1e7
+
+/*******************************************************************************
+ * PRIVATE VARIABLES                                                           *
+ ******************************************************************************/
+static const log_event_t *events = NULL;
+static uint8_t event_count = 0;
+static uint8_t log_port = MAVLINK_TX_RADIO;
+static uint8_t buffer[LOG_BUFFER_LENGTH]; // whole records, sent as one message
+static uint8_t fill = 0;
+static uint16_t sequence = 0;
+static log_stats_t stats;
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                 *
+ ******************************************************************************/
+static uint8_t pack(uint8_t *record, uint8_t length, const void *value, uint8_t size);
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function Log_init(const log_event_t *table, uint8_t count, uint8_t port)
+ * @param table, the events, indexed by id, kept by reference
+ * @param count, entries in table
+ * @param port, MAVLINK_TX_RADIO, MAVLINK_TX_USB or MAVLINK_TX_ALL
+ * @return none
+ * @brief empties the record buffer and resets the statistics
+ * @author Aaron Hunter */
+void Log_init(const log_event_t *table, uint8_t count, uint8_t port) {
+    events = table;
+    event_count = count;
+    log_port = port;
+    memset(buffer, 0, sizeof (buffer));
+    fill = 0;
+    sequence = 0;
+    Log_reset_stats();
+}
+
+/**
+ * @Function Log_event(uint8_t id, ...)
+ * @param id, index of the event in the table
+ * @param ..., the arguments, as many and of the types the entry lists; they
+ * are not checked against the types
+ * @return SUCCESS or ERROR for an unknown id
+ * @brief packs a record stamped with the msec time, sends the buffer first
+ * if the record does not fit
+ * @author Aaron Hunter */
+int8_t Log_event(uint8_t id, ...) {
+    uint8_t record[LOG_MAX_RECORD];
+    uint8_t length = LOG_HEADER_LENGTH;
+    const char *type;
+    const char *text;
+    uint32_t msec = Sys_timer_get_msec();
+    int32_t i_value;
+    uint32_t u_value;
+    float f_value;
+    uint8_t n;
+    uint8_t count;
+    va_list args;
+
+    if (id >= event_count) {
+        stats.errors++;
+        return ERROR;
+    }
+    va_start(args, id);
+    type = events[id].types;
+    for (count = 0; type[count] != '\0' && count < LOG_MAX_ARGS; count++) {
+        switch (type[count]) {
+            case LOG_FLOAT:
+                f_value = (float) va_arg(args, double);
+                length = pack(record, length, &f_value, sizeof (f_value));
+                break;
+            case LOG_INT:
+                i_value = va_arg(args, int);
+                length = pack(record, length, &i_value, sizeof (i_value));
+                break;
+            case LOG_UINT:
+                u_value = va_arg(args, unsigned int);
+                length = pack(record, length, &u_value, sizeof (u_value));
+                break;
+            case LOG_DEG:
+                i_value = (int32_t) (va_arg(args, double) * DEG_TO_E7);
+                length = pack(record, length, &i_value, sizeof (i_value));
+                break;
+            case LOG_STRING:
+                text = va_arg(args, const char *);
+                for (n = 0; n < LOG_MAX_STRING && text[n] != '\0'; n++) {
+                    ;
+                }
+                record[length++] = n;
+                length = pack(record, length, text, n);
+                break;
+            default:
+                break; // not a type, no argument taken
+        }
+    }
+    va_end(args);
+    record[0] = id;
+    record[1] = length - LOG_HEADER_LENGTH;
+    memcpy(&record[2], &msec, sizeof (msec));
+    if (length > LOG_BUFFER_LENGTH - fill) {
+        Log_flush();
+    }
+    memcpy(&buffer[fill], record, length);
+    fill += length;
+    stats.records++;
+    return SUCCESS;
+}
+
+/**
+ * @Function Log_flush(void)
+ * @return none
+ * @brief sends the records packed so far as one LOGGING_DATA
+ * @author Aaron Hunter */
+void Log_flush(void) {
+    if (fill == 0) {
+        return;
+    }
+    /* records never straddle messages, so the first starts at 0 */
+    mavlink_msg_logging_data_send(log_port, 0, 0, sequence++, fill, 0, buffer);
+    stats.messages++;
+    stats.bytes += fill;
+    memset(buffer, 0, fill); // MAVLink 2 trims the zero tail
+    fill = 0;
+}
+
+/**
+ * @Function Log_get_stats(void)
+ * @return records, messages, bytes and errors since the last reset
+ * @author Aaron Hunter */
+const log_stats_t *Log_get_stats(void) {
+    return &stats;
+}
+
+/**
+ * @Function Log_reset_stats(void)
+ * @return none
+ * @author Aaron Hunter */
+void Log_reset_stats(void) {
+    memset(&stats, 0, sizeof (stats));
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/* pack(uint8_t *record, uint8_t length, const void *value, uint8_t size)
+ * appends the value's bytes, little endian as the PIC32 holds them, and
+ * returns the new length
+ */
+static uint8_t pack(uint8_t *record, uint8_t length, const void *value, uint8_t size) {
+    memcpy(&record[length], value, size);
+    return length + size;
+}
+
+#ifdef EVENT_LOG_TESTING
+#include "SerialM32.h"
+#include "Radio_serial.h"
+#include <stdio.h>
+
+#define REPEAT 100
+
+mavlink_system_t mavlink_system = {
+    1, // System ID (1-255)
+    MAV_COMP_ID_AUTOPILOT1 // Component ID (a MAV_COMPONENT value)
+};
+
+enum {
+    TEST_ODOMETRY,
+    TEST_BANNER,
+};
+
+static const log_event_t test_events[] = {
+    LOG_EVENT("fffffff", "x: %3.1f y: %3.1f psi: %3.1f vx: %3.1f vy: %3.1f v: %3.1f delta: %3.1f"), // TEST_ODOMETRY
+    LOG_EVENT("ss", "Event log test harness %s, %s"), // TEST_BANNER
+};
+#define TEST_EVENTS (sizeof (test_events) / sizeof (test_events[0]))
+
+static volatile float x = 12.3, y = -4.5, psi = 87.6, vx = 0.8, vy = 0.1, v = 0.81, delta = 3.2;
+static char text[128];
+static uint16_t text_length;
+
+static void odometry_text(void) {
+    text_length = sprintf(text, "x: %3.1f y: %3.1f psi: %3.1f vx: %3.1f vy: %3.1f v: %3.1f delta: %3.1f \r\n",
+            x, y, psi, vx, vy, v, delta);
+}
+
+static void odometry_record(void) {
+    Log_event(TEST_ODOMETRY, x, y, psi, vx, vy, v, delta);
+}
+
+/* mean core timer counts of fn() */
+static uint32_t core_counts(void (*fn)(void)) {
+    uint32_t start;
+    uint32_t sum = 0;
+    uint16_t i;
+
+    for (i = 0; i < REPEAT; i++) {
+        start = Sys_timer_get_core();
+        fn();
+        sum += Sys_timer_get_core() - start;
+    }
+    return sum / REPEAT;
+}
+
+int main(void) {
+    uint32_t counts;
+    const log_stats_t *log;
+
+    Board_init();
+    Serial_init();
+    Radio_serial_init();
+    Sys_timer_init();
+    Log_init(test_events, TEST_EVENTS, MAVLINK_TX_USB);
+    printf("\r\nEvent log test harness %s, %s\r\n", __DATE__, __TIME__);
+    counts = core_counts(odometry_text);
+    printf("sprintf %5u cycles, %u bytes\r\n", 2 * counts, text_length);
+    Log_reset_stats();
+    counts = core_counts(odometry_record);
+    log = Log_get_stats();
+    printf("record  %5u cycles, %u bytes\r\n", 2 * counts, (log->bytes + fill) / log->records);
+    while (Serial_tx_idle() == FALSE) {
+        ;
+    }
+    Log_event(TEST_BANNER, __DATE__, __TIME__);
+    Log_flush();
+    while (1) {
+        ;
+    }
+    return 0;
+}
+#endif //EVENT_LOG_TESTING
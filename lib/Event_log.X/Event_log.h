@@ -0,0 +1,101 @@
+/*
+ * File:   Event_log.h
+ * Brief: Binary event log.  Diagnostics go out as records, an event id, the
+ * time and the raw argument bytes, instead of text formatted with sprintf(),
+ * so a report costs a few copies where %f took thousands of soft float
+ * cycles.  The app lists its events in a table of LOG_EVENT() entries whose
+ * printf formats the preprocessor drops, so no text is kept in flash;
+ * python/log_decode.py reads the same table from the source and prints the
+ * records as text again.  Records are packed into LOGGING_DATA messages on
+ * one port and sent when the next does not fit or on Log_flush(); the
+ * message sequence numbers show the decoder what was lost.  Main loop only.
+ * Created on 10/16/2026
+ * Modified on 10/17/2026
+ */
+
+#ifndef EVENT_LOG_H // Header guard
+#define	EVENT_LOG_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+#include <stdint.h>
+#include "Mavlink_tx.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+#define LOG_MAX_ARGS 12 // characters in an event's argument types
+#define LOG_MAX_STRING 16 // bytes kept of an 's' argument
+#define LOG_HEADER_LENGTH 6 // id, argument bytes and msec of each record
+
+/* argument types, one character each in the order of the format's
+ * conversions */
+#define LOG_FLOAT 'f' // float or double, sent as float
+#define LOG_INT 'i' // int, int32_t and smaller signed types
+#define LOG_UINT 'u' // unsigned int, uint32_t and smaller unsigned types
+#define LOG_DEG 'l' // double degrees, latitude or longitude, sent in 1e-7 deg
+#define LOG_STRING 's' // char *, sent as a length and up to LOG_MAX_STRING bytes
+
+/* an event table entry; the format stays in the source for the decoder */
+#define LOG_EVENT(types, format) {types}
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+typedef struct {
+    const char *types; // LOG_FLOAT, LOG_INT, ... for each argument
+} log_event_t;
+
+typedef struct {
+    uint32_t records; // packed
+    uint32_t messages; // LOGGING_DATA sent
+    uint32_t bytes; // record bytes sent
+    uint32_t errors; // unknown ids
+} log_stats_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function Log_init(const log_event_t *table, uint8_t count, uint8_t port)
+ * @param table, the events, indexed by id, kept by reference
+ * @param count, entries in table
+ * @param port, MAVLINK_TX_RADIO, MAVLINK_TX_USB or MAVLINK_TX_ALL
+ * @return none
+ * @brief empties the record buffer and resets the statistics
+ * @author Aaron Hunter */
+void Log_init(const log_event_t *table, uint8_t count, uint8_t port);
+
+/**
+ * @Function Log_event(uint8_t id, ...)
+ * @param id, index of the event in the table
+ * @param ..., the arguments, as many and of the types the entry lists; they
+ * are not checked against the types
+ * @return SUCCESS or ERROR for an unknown id
+ * @brief packs a record stamped with the msec time, sends the buffer first
+ * if the record does not fit
+ * @author Aaron Hunter */
+int8_t Log_event(uint8_t id, ...);
+
+/**
+ * @Function Log_flush(void)
+ * @return none
+ * @brief sends the records packed so far as one LOGGING_DATA
+ * @author Aaron Hunter */
+void Log_flush(void);
+
+/**
+ * @Function Log_get_stats(void)
+ * @return records, messages, bytes and errors since the last reset
+ * @author Aaron Hunter */
+const log_stats_t *Log_get_stats(void);
+
+/**
+ * @Function Log_reset_stats(void)
+ * @return none
+ * @author Aaron Hunter */
+void Log_reset_stats(void);
+
+#endif	/* EVENT_LOG_H */ // End of header guard
@@ -0,0 +1,385 @@
+/*
+ * File:   HIL.c
+ * Brief: Sensor injection (hardware in the loop) over MAVLink, see HIL.h
+ * Created on 10/16/2026
+ * Modified on 10/16/2026
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+
+#include "HIL.h" // The header file for this source file.
+#include "Board.h"
+#include "RC_servo.h"
+#include "System_timer.h"
+#include <math.h>
+#include <string.h>
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#define G_MPS2 9.80665f // one g in m/s^2
+#define MAG_FIELD_GAUSS 0.475f // field the IMU driver normalizes to
+#define RAD2DEG (180.0f / M_PI)
+#define MPS_PER_KNOT 0.5144444444
+#define SEC_PER_DAY 86400.0
+#define HIL_FIX_3D 3 // GPS_FIX_TYPE_3D_FIX
+#define HIL_COG_UNKNOWN UINT16_MAX
+#define PULSE_HALF_RANGE ((RC_SERVO_MAX_PULSE - RC_SERVO_MIN_PULSE) / 2.0f)
+
+/*******************************************************************************
+ * PRIVATE VARIABLES                                                           *
+ ******************************************************************************/
+static uint8_t hil_active = FALSE;
+static uint8_t hil_link = 0;
+/* last HIL_SENSOR, its simulator time and receive time */
+static struct IMU_out hil_IMU;
+static uint8_t IMU_new = FALSE;
+static uint64_t IMU_time_usec = 0;
+static uint64_t IMU_rx_ticks = 0;
+/* HIL_SENSOR the app read last, the next outputs answer it */
+static uint64_t used_time_usec = 0;
+static uint64_t used_rx_ticks = 0;
+static uint8_t used_answered = TRUE;
+static struct GPS_data hil_GPS;
+static uint8_t GPS_new = FALSE;
+static uint8_t GPS_fix = FALSE;
+static float hil_rpm[HIL_NUM_RPM];
+static uint8_t rpm_new = FALSE;
+static uint16_t outputs[HIL_NUM_OUTPUTS];
+static hil_stats_t stats;
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                 *
+ ******************************************************************************/
+static void HIL_sensor(const mavlink_message_t *msg);
+static void HIL_GPS(const mavlink_message_t *msg);
+static void HIL_rpm(const mavlink_message_t *msg);
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function HIL_init(void)
+ * @return none
+ * @brief clears the injected data and the statistics, HIL mode off
+ * @author Aaron Hunter */
+void HIL_init(void) {
+    uint8_t i;
+
+    hil_active = FALSE;
+    hil_link = 0;
+    memset(&hil_IMU, 0, sizeof (hil_IMU));
+    memset(&hil_GPS, 0, sizeof (hil_GPS));
+    memset(hil_rpm, 0, sizeof (hil_rpm));
+    IMU_new = FALSE;
+    GPS_new = FALSE;
+    GPS_fix = FALSE;
+    rpm_new = FALSE;
+    used_answered = TRUE;
+    for (i = 0; i < HIL_NUM_OUTPUTS; i++) {
+        outputs[i] = RC_SERVO_CENTER_PULSE;
+    }
+    HIL_reset_stats();
+}
+
+/**
+ * @Function HIL_handle_msg(const mavlink_message_t *msg, uint8_t link)
+ * @param msg, message parsed from a link
+ * @param link, the app's id of the link, actuators are returned on the link
+ * that sent the last HIL_SENSOR
+ * @return TRUE if the message was HIL data and was consumed, FALSE to let the
+ * app handle it
+ * @brief call with every parsed message before the app's own switch
+ * @author Aaron Hunter */
+uint8_t HIL_handle_msg(const mavlink_message_t *msg, uint8_t link) {
+    switch (msg->msgid) {
+        case MAVLINK_MSG_ID_HIL_SENSOR:
+            hil_active = TRUE;
+            hil_link = link;
+            HIL_sensor(msg);
+            return TRUE;
+        case MAVLINK_MSG_ID_HIL_GPS:
+            hil_active = TRUE;
+            HIL_GPS(msg);
+            return TRUE;
+        case MAVLINK_MSG_ID_RAW_RPM:
+            if (hil_active == FALSE) {
+                return FALSE; // not ours outside of HIL mode
+            }
+            HIL_rpm(msg);
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+/**
+ * @Function HIL_is_active(void)
+ * @return TRUE once a HIL_SENSOR or HIL_GPS was received
+ * @author Aaron Hunter */
+uint8_t HIL_is_active(void) {
+    return hil_active;
+}
+
+/**
+ * @Function HIL_get_link(void)
+ * @return link of the last HIL_SENSOR
+ * @author Aaron Hunter */
+uint8_t HIL_get_link(void) {
+    return hil_link;
+}
+
+/**
+ * @Function HIL_is_IMU_ready(void)
+ * @return TRUE if a HIL_SENSOR arrived since the last HIL_get_IMU()
+ * @author Aaron Hunter */
+uint8_t HIL_is_IMU_ready(void) {
+    return IMU_new;
+}
+
+/**
+ * @Function HIL_get_IMU(struct IMU_out *IMU_data)
+ * @param IMU_data, filled like IMU_get_norm_data(): acc and mag normalized to
+ * one g and the expected field, gyro in deg/sec, sample_time the receive time
+ * @return none
+ * @brief the frame read becomes the one the next actuator output answers
+ * @author Aaron Hunter */
+void HIL_get_IMU(struct IMU_out *IMU_data) {
+    *IMU_data = hil_IMU;
+    if (IMU_new == TRUE) {
+        used_time_usec = IMU_time_usec;
+        used_rx_ticks = IMU_rx_ticks;
+        used_answered = FALSE;
+        IMU_new = FALSE;
+    }
+}
+
+/**
+ * @Function HIL_is_GPS_ready(void)
+ * @return TRUE if a HIL_GPS arrived since the last HIL_get_GPS()
+ * @author Aaron Hunter */
+uint8_t HIL_is_GPS_ready(void) {
+    return GPS_new;
+}
+
+/**
+ * @Function HIL_get_GPS(struct GPS_data *data)
+ * @param data, filled like GPS_get_data(), speed in knots, cog in deg
+ * @return none
+ * @author Aaron Hunter */
+void HIL_get_GPS(struct GPS_data *data) {
+    *data = hil_GPS;
+    GPS_new = FALSE;
+}
+
+/**
+ * @Function HIL_GPS_has_fix(void)
+ * @return TRUE if the last HIL_GPS had a 3D fix
+ * @author Aaron Hunter */
+uint8_t HIL_GPS_has_fix(void) {
+    return GPS_fix;
+}
+
+/**
+ * @Function HIL_get_rpm(float rpm[HIL_NUM_RPM])
+ * @param rpm, RAW_RPM frequency of each index, unchanged if none arrived
+ * @return TRUE if a RAW_RPM arrived since the last call
+ * @author Aaron Hunter */
+uint8_t HIL_get_rpm(float rpm[HIL_NUM_RPM]) {
+    uint8_t was_new = rpm_new;
+
+    memcpy(rpm, hil_rpm, sizeof (hil_rpm));
+    rpm_new = FALSE;
+    return was_new;
+}
+
+/**
+ * @Function HIL_set_output(uint8_t index, uint16_t pulse)
+ * @param index, output channel, 0 to HIL_NUM_OUTPUTS - 1
+ * @param pulse, servo pulse in usec
+ * @return SUCCESS or ERROR for a bad index
+ * @brief stores the pulse for the next HIL_ACTUATOR_CONTROLS
+ * @author Aaron Hunter */
+int8_t HIL_set_output(uint8_t index, uint16_t pulse) {
+    if (index >= HIL_NUM_OUTPUTS) {
+        return ERROR;
+    }
+    outputs[index] = pulse;
+    return SUCCESS;
+}
+
+/**
+ * @Function HIL_send_actuators(uint8_t mode)
+ * @param mode, MAV_MODE_FLAG bits of the app, HIL_ENABLED is added
+ * @return none
+ * @brief sends the outputs scaled to +/-1 about the center pulse with the
+ * time_usec of the HIL_SENSOR they answer on the link it came from and
+ * records the latency
+ * @author Aaron Hunter */
+void HIL_send_actuators(uint8_t mode) {
+    float controls[HIL_NUM_OUTPUTS];
+    uint32_t latency;
+    uint8_t i;
+
+    for (i = 0; i < HIL_NUM_OUTPUTS; i++) {
+        controls[i] = ((float) outputs[i] - RC_SERVO_CENTER_PULSE) / PULSE_HALF_RANGE;
+    }
+    if (used_answered == FALSE) {
+        latency = (uint32_t) Sys_timer_ticks_to_usec(Sys_timer_get_ticks() - used_rx_ticks);
+        stats.latency_sum += latency;
+        if (stats.latency_count == 0 || latency < stats.latency_min) {
+            stats.latency_min = latency;
+        }
+        if (latency > stats.latency_max) {
+            stats.latency_max = latency;
+        }
+        stats.latency_count++;
+        used_answered = TRUE;
+    } else {
+        stats.stale_outputs++;
+    }
+    stats.actuator_frames++;
+    mavlink_msg_hil_actuator_controls_send(hil_link, used_time_usec,
+            controls, mode | MAV_MODE_FLAG_HIL_ENABLED, 0);
+}
+
+/**
+ * @Function HIL_get_stats(void)
+ * @return frame counts and latency since the last HIL_reset_stats()
+ * @author Aaron Hunter */
+const hil_stats_t *HIL_get_stats(void) {
+    return &stats;
+}
+
+/**
+ * @Function HIL_reset_stats(void)
+ * @return none
+ * @brief starts a new statistics window
+ * @author Aaron Hunter */
+void HIL_reset_stats(void) {
+    memset(&stats, 0, sizeof (stats));
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/**
+ * @Function HIL_sensor(const mavlink_message_t *msg)
+ * @brief FRD SI units to the IMU driver's axes, flips y and z
+ * @author Aaron Hunter */
+static void HIL_sensor(const mavlink_message_t *msg) {
+    mavlink_hil_sensor_t sensor;
+
+    mavlink_msg_hil_sensor_decode(msg, &sensor);
+    if (IMU_new == TRUE) {
+        stats.sensor_skipped++;
+    }
+    hil_IMU.acc.x = sensor.xacc / G_MPS2;
+    hil_IMU.acc.y = -sensor.yacc / G_MPS2;
+    hil_IMU.acc.z = -sensor.zacc / G_MPS2; // specific force, +1 g at rest
+    hil_IMU.gyro.x = sensor.xgyro * RAD2DEG;
+    hil_IMU.gyro.y = -sensor.ygyro * RAD2DEG;
+    hil_IMU.gyro.z = -sensor.zgyro * RAD2DEG;
+    hil_IMU.mag.x = sensor.xmag / MAG_FIELD_GAUSS;
+    hil_IMU.mag.y = -sensor.ymag / MAG_FIELD_GAUSS;
+    hil_IMU.mag.z = -sensor.zmag / MAG_FIELD_GAUSS;
+    hil_IMU.temp = sensor.temperature;
+    hil_IMU.mag_status = 0;
+    IMU_rx_ticks = Sys_timer_get_ticks();
+    hil_IMU.sample_time = IMU_rx_ticks;
+    IMU_time_usec = sensor.time_usec;
+    IMU_new = TRUE;
+    stats.sensor_frames++;
+}
+
+/**
+ * @Function HIL_GPS(const mavlink_message_t *msg)
+ * @brief degE7, cm/s and cdeg to the NEO_M8N units
+ * @author Aaron Hunter */
+static void HIL_GPS(const mavlink_message_t *msg) {
+    mavlink_hil_gps_t gps;
+
+    mavlink_msg_hil_gps_decode(msg, &gps);
+    hil_GPS.time = fmod(gps.time_usec * 1e-6, SEC_PER_DAY);
+    hil_GPS.lat = gps.lat * 1e-7;
+    hil_GPS.lon = gps.lon * 1e-7;
+    hil_GPS.spd = gps.vel * 0.01 / MPS_PER_KNOT;
+    if (gps.cog != HIL_COG_UNKNOWN) {
+        hil_GPS.cog = gps.cog * 0.01;
+    }
+    hil_GPS.rx_time = Sys_timer_get_ticks();
+    GPS_fix = gps.fix_type >= HIL_FIX_3D;
+    GPS_new = TRUE;
+    stats.gps_frames++;
+}
+
+/**
+ * @Function HIL_rpm(const mavlink_message_t *msg)
+ * @author Aaron Hunter */
+static void HIL_rpm(const mavlink_message_t *msg) {
+    mavlink_raw_rpm_t rpm;
+
+    mavlink_msg_raw_rpm_decode(msg, &rpm);
+    if (rpm.index < HIL_NUM_RPM) {
+        hil_rpm[rpm.index] = rpm.frequency;
+        rpm_new = TRUE;
+        stats.rpm_frames++;
+    }
+}
+
+#ifdef HIL_TESTING
+#include "SerialM32.h"
+
+mavlink_system_t mavlink_system = {
+    1, // System ID (1-255)
+    MAV_COMP_ID_AUTOPILOT1 // Component ID (a MAV_COMPONENT value)
+};
+
+/* answers every HIL_SENSOR on the USB port right away with the gyro rates as
+ * outputs and reports the frame rates and latency once a second as DEBUG_VECT,
+ * python/hil_bench.py drives it */
+int main(void) {
+    mavlink_message_t msg_rx;
+    mavlink_status_t msg_rx_status;
+    struct IMU_out IMU_data;
+    const hil_stats_t *hil_stats;
+    uint32_t report_time;
+
+    Board_init();
+    Serial_init();
+    Sys_timer_init();
+    HIL_init();
+    report_time = Sys_timer_get_msec();
+    while (1) {
+        if (Serial_data_available()) {
+            if (mavlink_parse_char(MAVLINK_TX_USB, get_char(), &msg_rx, &msg_rx_status)) {
+                HIL_handle_msg(&msg_rx, MAVLINK_TX_USB);
+            }
+        }
+        if (HIL_is_IMU_ready()) {
+            HIL_get_IMU(&IMU_data);
+            HIL_set_output(0, RC_SERVO_CENTER_PULSE + (int16_t) IMU_data.gyro.x);
+            HIL_set_output(1, RC_SERVO_CENTER_PULSE + (int16_t) IMU_data.gyro.y);
+            HIL_set_output(2, RC_SERVO_CENTER_PULSE + (int16_t) IMU_data.gyro.z);
+            HIL_send_actuators(0);
+        }
+        if (Sys_timer_get_msec() - report_time >= 1000) {
+            report_time += 1000;
+            hil_stats = HIL_get_stats();
+            mavlink_msg_debug_vect_send(MAVLINK_TX_USB, "hil_rx",
+                    Sys_timer_get_usec64(), hil_stats->sensor_frames,
+                    hil_stats->gps_frames, hil_stats->sensor_skipped);
+            mavlink_msg_debug_vect_send(MAVLINK_TX_USB, "hil_lat",
+                    Sys_timer_get_usec64(), hil_stats->latency_min,
+                    hil_stats->latency_count ? hil_stats->latency_sum / hil_stats->latency_count : 0,
+                    hil_stats->latency_max);
+            HIL_reset_stats();
+        }
+    }
+    return 0;
+}
+#endif //HIL_TESTING
@@ -0,0 +1,160 @@
+/*
+ * File:   HIL.h
+ * Brief: Sensor injection (hardware in the loop) over MAVLink.  An external
+ * simulator sends HIL_SENSOR, HIL_GPS and RAW_RPM on the USB or radio link;
+ * the first HIL_SENSOR or HIL_GPS latches the app into HIL mode, where the
+ * injected frames stand in for IMU_get_norm_data(), GPS_get_data() and
+ * Encoder_get_data(), and the actuator pulses are returned in
+ * HIL_ACTUATOR_CONTROLS instead of driving the servos.  The mode holds until
+ * reset so a simulator that stops can never hand the outputs back mid run.
+ * Frames are MAVLink FRD body axes in SI units and are converted to the IMU
+ * driver's axes (x forward, y left, z up) and units.  Latency is measured
+ * from the HIL_SENSOR frame parsed to the HIL_ACTUATOR_CONTROLS computed from
+ * it, and HIL_ACTUATOR_CONTROLS carries that frame's time_usec so the
+ * simulator can measure the round trip.
+ * Created on 10/16/2026
+ * Modified on 10/16/2026
+ */
+
+#ifndef HIL_H // Header guard
+#define	HIL_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+#include <stdint.h>
+#include "Mavlink_tx.h"
+#include "ICM_20948.h"
+#include "NEO_M8N.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+#define HIL_NUM_RPM 3 // RAW_RPM indices kept, the app assigns their meaning
+#define HIL_NUM_OUTPUTS 16 // HIL_ACTUATOR_CONTROLS controls
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+typedef struct {
+    uint32_t sensor_frames; // HIL_SENSOR received
+    uint32_t gps_frames; // HIL_GPS received
+    uint32_t rpm_frames; // RAW_RPM received in HIL mode
+    uint32_t actuator_frames; // HIL_ACTUATOR_CONTROLS sent
+    uint32_t sensor_skipped; // HIL_SENSOR replaced before the app read it
+    uint32_t stale_outputs; // outputs sent without a new HIL_SENSOR
+    uint32_t latency_count; // sensor to actuator latency, usec
+    uint32_t latency_min;
+    uint32_t latency_max;
+    uint64_t latency_sum;
+} hil_stats_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function HIL_init(void)
+ * @return none
+ * @brief clears the injected data and the statistics, HIL mode off
+ * @author Aaron Hunter */
+void HIL_init(void);
+
+/**
+ * @Function HIL_handle_msg(const mavlink_message_t *msg, uint8_t link)
+ * @param msg, message parsed from a link
+ * @param link, MAVLink channel of the link, MAVLINK_TX_USB or
+ * MAVLINK_TX_RADIO, actuators are returned on the link that sent the last
+ * HIL_SENSOR
+ * @return TRUE if the message was HIL data and was consumed, FALSE to let the
+ * app handle it
+ * @brief call with every parsed message before the app's own switch
+ * @author Aaron Hunter */
+uint8_t HIL_handle_msg(const mavlink_message_t *msg, uint8_t link);
+
+/**
+ * @Function HIL_is_active(void)
+ * @return TRUE once a HIL_SENSOR or HIL_GPS was received
+ * @author Aaron Hunter */
+uint8_t HIL_is_active(void);
+
+/**
+ * @Function HIL_get_link(void)
+ * @return link of the last HIL_SENSOR
+ * @author Aaron Hunter */
+uint8_t HIL_get_link(void);
+
+/**
+ * @Function HIL_is_IMU_ready(void)
+ * @return TRUE if a HIL_SENSOR arrived since the last HIL_get_IMU()
+ * @author Aaron Hunter */
+uint8_t HIL_is_IMU_ready(void);
+
+/**
+ * @Function HIL_get_IMU(struct IMU_out *IMU_data)
+ * @param IMU_data, filled like IMU_get_norm_data(): acc and mag normalized to
+ * one g and the expected field, gyro in deg/sec, sample_time the receive time
+ * @return none
+ * @brief the frame read becomes the one the next actuator output answers
+ * @author Aaron Hunter */
+void HIL_get_IMU(struct IMU_out *IMU_data);
+
+/**
+ * @Function HIL_is_GPS_ready(void)
+ * @return TRUE if a HIL_GPS arrived since the last HIL_get_GPS()
+ * @author Aaron Hunter */
+uint8_t HIL_is_GPS_ready(void);
+
+/**
+ * @Function HIL_get_GPS(struct GPS_data *data)
+ * @param data, filled like GPS_get_data(), speed in knots, cog in deg
+ * @return none
+ * @author Aaron Hunter */
+void HIL_get_GPS(struct GPS_data *data);
+
+/**
+ * @Function HIL_GPS_has_fix(void)
+ * @return TRUE if the last HIL_GPS had a 3D fix
+ * @author Aaron Hunter */
+uint8_t HIL_GPS_has_fix(void);
+
+/**
+ * @Function HIL_get_rpm(float rpm[HIL_NUM_RPM])
+ * @param rpm, RAW_RPM frequency of each index, unchanged if none arrived
+ * @return TRUE if a RAW_RPM arrived since the last call
+ * @author Aaron Hunter */
+uint8_t HIL_get_rpm(float rpm[HIL_NUM_RPM]);
+
+/**
+ * @Function HIL_set_output(uint8_t index, uint16_t pulse)
+ * @param index, output channel, 0 to HIL_NUM_OUTPUTS - 1
+ * @param pulse, servo pulse in usec
+ * @return SUCCESS or ERROR for a bad index
+ * @brief stores the pulse for the next HIL_ACTUATOR_CONTROLS
+ * @author Aaron Hunter */
+int8_t HIL_set_output(uint8_t index, uint16_t pulse);
+
+/**
+ * @Function HIL_send_actuators(uint8_t mode)
+ * @param mode, MAV_MODE_FLAG bits of the app, HIL_ENABLED is added
+ * @return none
+ * @brief sends the outputs scaled to +/-1 about the center pulse with the
+ * time_usec of the HIL_SENSOR they answer on the link it came from and
+ * records the latency
+ * @author Aaron Hunter */
+void HIL_send_actuators(uint8_t mode);
+
+/**
+ * @Function HIL_get_stats(void)
+ * @return frame counts and latency since the last HIL_reset_stats()
+ * @author Aaron Hunter */
+const hil_stats_t *HIL_get_stats(void);
+
+/**
+ * @Function HIL_reset_stats(void)
+ * @return none
+ * @brief starts a new statistics window
+ * @author Aaron Hunter */
+void HIL_reset_stats(void);
+
+#endif	/* HIL_H */ // End of header guard
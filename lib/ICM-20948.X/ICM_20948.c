@@ -3,7 +3,7 @@
  * Author: Aaron Hunter
  * Brief: Library for the ICM-20948 IMU
  * Created on Nov 13, 2020 9:46 am
- * Modified on July 20, 2022 4:46 pm
+ * Modified on 10/16/2026
  */
 
 /*******************************************************************************
@@ -14,6 +14,7 @@
 #include "ICM_20948_registers.h"  //register definitions for the device
 #include "SerialM32.h"
 #include "Board.h"
+#include "System_timer.h"
 #include <stdio.h>
 #include <string.h>
 #include <sys/attribs.h>  //for ISR definitions
@@ -51,12 +52,12 @@
 //#define INTERFACE_MODE IMU_I2C_MODE 
 #define IMU_CS_TRIS TRISEbits.TRISE0 //chip select for IMU
 #define IMU_CS_LAT LATEbits.LATE0
+#define IMU_INT_TRIS TRISEbits.TRISE8 //INT pin of the IMU on INT1
+/*INT pin config, active high push-pull 50 usec pulse*/
+#define INT_PIN_PULSE 0x00
+#define RAW_DATA_0_RDY_EN 0x01
 
 /*IMU scaling factors*/
-#define ACCEL_SCALE 2.0  //+/-2000mg
-#define ACCEL_DIV 32767.0 // 2^15-1
-#define GYRO_SCALE 500.0 // +/- 500 deg/sec
-#define GYRO_DIV 32767.0 // 2^15-1
 #define MAG_SCALE 4912.0 //4900 uTesla FS
 #define MAG_DIV 32752.0 // max reading
 #define E_b 47.4148 //expected value of earth's mag field in uTesla
@@ -88,6 +89,8 @@ typedef enum {
 
 /*module level variables*/
 static uint8_t IMU_raw_data[IMU_NUM_BYTES];
+static volatile uint8_t IMU_last_data[IMU_NUM_BYTES]; // the last complete read, kept from the next one
+static volatile uint8_t last_data_count = 0; // bumped each time IMU_last_data is copied
 static float acc_v_raw[3] = {0, 0, 0};
 static float acc_v_scaled[3] = {0, 0, 0};
 static float acc_v_norm[3] = {0, 0, 0};
@@ -101,9 +104,19 @@ static float temp_scaled = 0;
 static int16_t status = 0;
 
 static volatile uint8_t IMU_data_ready = 0;
-const float acc_scale = ACCEL_SCALE / ACCEL_DIV;
+static volatile uint64_t acq_time = 0; // start of the read in progress
+static volatile uint64_t sample_time = 0; // start of the last complete read
+static uint64_t data_time = 0; // sample_time of the processed data
+static volatile uint32_t drdy_overruns = 0;
+static volatile uint8_t spi_restart = FALSE; // a new read began before the last one finished
+/*raw samples, written by the read interrupts and read by IMU_read_sample()*/
+static struct IMU_sample queue[IMU_QUEUE_LENGTH];
+static volatile uint8_t queue_head = 0; // free running, masked on use
+static volatile uint8_t queue_tail = 0;
+static volatile uint32_t queue_overruns = 0;
+const float acc_scale = IMU_ACC_LSB;
 const float mag_scale = MAG_SCALE / MAG_DIV;
-const float gyro_scale = GYRO_SCALE / GYRO_DIV;
+const float gyro_scale = IMU_GYRO_LSB;
 static int8_t is_A_matrix = FALSE;
 
 static float A_mag[3][3] = {
@@ -147,6 +160,8 @@ static void IMU_scale_data(void);
 /***********************************/
 static void delay(int cycles);
 static void IMU_run_I2C_state_machine(void);
+static void queue_sample(void);
+static void keep_data(void);
 /**
  * @Function IMU_run_SPI_state_machine(uint8_t byte_read)
  * @return none
@@ -353,12 +368,14 @@ int8_t IMU_start_data_acq(void) {
         // printf("IMU error found\r\n");
         SPI1BUF; //read buffer
         IFS0bits.SPI1RXIF = 0; //clear any interrupt flag
+        spi_restart = TRUE; //the state machine starts over with this read
         error = TRUE;
     } else {
         error = FALSE;
     }
     uint8_t data_reg = AGB0_REG_ACCEL_XOUT_H;
     data_reg = data_reg | (READ << 7);
+    acq_time = Sys_timer_get_ticks(); //capture time of this sample
     IMU_CS_LAT = 0; //select the IMU 
     SPI1BUF = data_reg; //start SPI transaction 
     if (error) {
@@ -367,6 +384,105 @@ int8_t IMU_start_data_acq(void) {
     return SUCCESS;
 }
 
+/**
+ * @Function IMU_enable_drdy(uint8_t divider)
+ * @param divider, accel and gyro sample rate divider, the sample rate is
+ * IMU_ODR_BASE / (1 + divider), e.g. 8 for 125 Hz
+ * @return SUCCESS or ERROR if the IMU is not in SPI mode
+ * @brief routes the raw data ready interrupt to the INT pin and starts the SPI
+ * read from the INT1 external interrupt on every new sample
+ * @author Aaron Hunter
+ **/
+int8_t IMU_enable_drdy(uint8_t divider) {
+    if (SPI1CONbits.ON == 0) {
+        return ERROR;
+    }
+    IEC0bits.INT1IE = 0;
+    /*wait for a read in progress, then configure with blocking SPI*/
+    while (IMU_CS_LAT == 0) {
+        ;
+    }
+    __builtin_disable_interrupts();
+    /*sample rate dividers on user bank 2, both sensors sample together*/
+    SPI_set_reg(AGB0_REG_REG_BANK_SEL, USER_BANK_2);
+    SPI_set_reg(AGB2_REG_GYRO_SMPLRT_DIV, divider);
+    SPI_set_reg(AGB2_REG_ACCEL_SMPLRT_DIV_1, 0); //upper 4 bits of the 12 bit divider
+    SPI_set_reg(AGB2_REG_ACCEL_SMPLRT_DIV_2, divider);
+    SPI_set_reg(AGB2_REG_REG_BANK_SEL, USER_BANK_0);
+    /*pulse the INT pin on raw data ready*/
+    SPI_set_reg(AGB0_REG_INT_PIN_CONFIG, INT_PIN_PULSE);
+    SPI_set_reg(AGB0_REG_INT_ENABLE_1, RAW_DATA_0_RDY_EN);
+    SPI1BUF; // discard the blocking reads so the SPI handler starts clean
+    IFS0bits.SPI1RXIF = 0;
+    /*INT1 on the rising edge, above the SPI so the read starts right away*/
+    IMU_INT_TRIS = 1;
+    INTCONbits.INT1EP = 1;
+    IPC1bits.INT1IP = 6;
+    IPC1bits.INT1IS = 0;
+    drdy_overruns = 0;
+    IFS0bits.INT1IF = 0;
+    IEC0bits.INT1IE = 1;
+    __builtin_enable_interrupts();
+    return SUCCESS;
+}
+
+/**
+ * @Function IMU_disable_drdy(void)
+ * @return none
+ * @brief stops the INT1 triggered reads, IMU_start_data_acq() starts each read
+ * again
+ * @author Aaron Hunter
+ **/
+void IMU_disable_drdy(void) {
+    IEC0bits.INT1IE = 0;
+    /*wait for a read in progress before using the bus*/
+    while (IMU_CS_LAT == 0) {
+        ;
+    }
+    __builtin_disable_interrupts();
+    SPI_set_reg(AGB0_REG_INT_ENABLE_1, 0);
+    SPI1BUF;
+    IFS0bits.SPI1RXIF = 0;
+    IFS0bits.INT1IF = 0;
+    __builtin_enable_interrupts();
+}
+
+/**
+ * @Function IMU_get_drdy_overruns(void)
+ * @return number of data ready interrupts that arrived while the previous SPI
+ * read was still running
+ * @author Aaron Hunter
+ **/
+uint32_t IMU_get_drdy_overruns(void) {
+    return drdy_overruns;
+}
+
+/**
+ * @Function IMU_read_sample(struct IMU_sample *sample)
+ * @param sample, gets the oldest queued sample
+ * @return TRUE or FALSE if the queue is empty
+ * @brief every complete read queues its raw accel and gyro counts
+ * @author Aaron Hunter
+ **/
+uint8_t IMU_read_sample(struct IMU_sample *sample) {
+    if (queue_tail == queue_head) {
+        return FALSE;
+    }
+    *sample = queue[queue_tail & (IMU_QUEUE_LENGTH - 1)];
+    queue_tail++; // frees the entry for the interrupt
+    return TRUE;
+}
+
+/**
+ * @Function IMU_get_queue_overruns(void)
+ * @return number of samples dropped because IMU_read_sample() had left the
+ * queue full
+ * @author Aaron Hunter
+ **/
+uint32_t IMU_get_queue_overruns(void) {
+    return queue_overruns;
+}
+
 /**
  * @Function IMU_is_data_ready(void)
  * @return TRUE or FALSE
@@ -403,6 +519,7 @@ uint8_t IMU_get_raw_data(struct IMU_out* IMU_data) {
     IMU_data->mag.y = mag_v_raw[1];
     IMU_data->mag.z = mag_v_raw[2];
     IMU_data->mag_status = status;
+    IMU_data->sample_time = data_time;
     return SUCCESS;
 }
 
@@ -433,6 +550,7 @@ void IMU_get_norm_data(struct IMU_out* IMU_data) {
     IMU_data->mag.y = mag_v_norm[1];
     IMU_data->mag.z = mag_v_norm[2];
     IMU_data->mag_status = status;
+    IMU_data->sample_time = data_time;
 }
 
 /**
@@ -462,6 +580,7 @@ uint8_t IMU_get_scaled_data(struct IMU_out* IMU_data) {
     IMU_data->mag.y = mag_v_scaled[1];
     IMU_data->mag.z = mag_v_scaled[2];
     IMU_data->mag_status = status;
+    IMU_data->sample_time = data_time;
     return SUCCESS;
 }
 
@@ -710,6 +829,7 @@ static void SPI_read_data(void) {
         data_reg++;
     }
     IMU_CS_LAT = 1;
+    keep_data();
     IMU_process_data();
     IMU_data_ready = TRUE;
 }
@@ -727,6 +847,30 @@ static void __ISR(_I2C1_VECTOR, IPL2AUTO) IMU_I2C_interrupt_handler(void) {
     IFS0bits.I2C1MIF = 0; //clear flag
 }
 
+/**
+ * @Function IMU_drdy_interrupt_handler()
+ * @param none
+ * @brief starts the SPI read of a new sample on the rising edge of the IMU INT
+ * pin, the SPI interrupt handler sets IMU_data_ready when it completes
+ * @note a read still running is left to finish and the new sample is skipped;
+ * one still running a sample later has stalled and is restarted
+ * @author ahunter
+ */
+static void __ISR(_EXTERNAL_1_VECTOR, IPL6AUTO) IMU_drdy_interrupt_handler(void) {
+    static uint8_t read_busy = FALSE;
+
+    IFS0bits.INT1IF = 0; // clear interrupt flag
+    if (IMU_CS_LAT == 0 && read_busy == FALSE) {
+        read_busy = TRUE; //restarting it here could preempt the SPI handler mid byte
+        drdy_overruns++;
+        return;
+    }
+    read_busy = FALSE;
+    if (IMU_start_data_acq() == ERROR) {
+        drdy_overruns++; //last read had stalled, restarted
+    }
+}
+
 /**
  * @Function IMU_SPI_interrupt_handler()
  * @param none
@@ -743,7 +887,9 @@ static void __ISR(_SPI_1_VECTOR, IPL5AUTO) IMU_SPI_interrupt_handler(void) {
         SPI1STATCLR = 1<<6; // clear the overflow register
         IFS0bits.SPI1AEIF = 0; //clear error flag
     }
-    
+    if (IMU_CS_LAT == 1) {
+        return; //no read in progress, a byte left from the blocking setup
+    }
     IMU_run_SPI_state_machine(data);
 }
 
@@ -796,6 +942,7 @@ static void IMU_read_data() {
         LATAINV = 0x8;
     }
     I2C_stop();
+    keep_data();
     LATAINV = 0x8;
 }
 
@@ -816,6 +963,7 @@ static void IMU_run_I2C_state_machine(void) {
         case(IMU_SEND_ADDR_W):
             next_state = IMU_SEND_REG;
             I2C1TRN = (ICM_I2C_ADDR << 1 | WRITE);
+            acq_time = Sys_timer_get_ticks(); //capture time of this sample
             /*reset error and data ready flags*/
             IMU_data_ready = FALSE;
             error = FALSE;
@@ -870,6 +1018,8 @@ static void IMU_run_I2C_state_machine(void) {
             break;
         case(IMU_DATA_RCVD):
             /*indicate data is ready*/
+            keep_data();
+            queue_sample();
             IMU_data_ready = 1;
             /*stop the device*/
             I2C1CONbits.PEN = 1; //send stop condition 
@@ -901,6 +1051,12 @@ static void IMU_run_SPI_state_machine(uint8_t byte_read) {
     static uint8_t error = FALSE;
     static int8_t byte_index = -1;
     uint8_t max_index = IMU_NUM_BYTES - 1;
+    if (spi_restart == TRUE) { // the byte is the reply to a new first register
+        spi_restart = FALSE;
+        reg_address = AGB0_REG_ACCEL_XOUT_H;
+        byte_index = -1;
+        current_state = IMU_SPI_SEND_NEXT_REG;
+    }
     switch (current_state) {
         case IMU_SPI_SEND_NEXT_REG:
             //store spi buffer in raw data struct
@@ -918,6 +1074,8 @@ static void IMU_run_SPI_state_machine(uint8_t byte_read) {
         case IMU_SPI_READ_LAST_REG:
             IMU_raw_data[byte_index] = byte_read; //store last data byte in raw data struct
             IMU_CS_LAT = 1; // deselect IMU
+            keep_data();
+            queue_sample();
             IMU_data_ready = TRUE; // set data read flag
             byte_index = -1; //reset byte counter
             break;
@@ -927,6 +1085,41 @@ static void IMU_run_SPI_state_machine(uint8_t byte_read) {
     current_state = next_state;
 }
 
+/* queue_sample(void)
+ * copies the accel and gyro counts of the read that just completed to the
+ * sample queue, or counts an overrun if it is full; interrupt context
+ */
+static void queue_sample(void) {
+    struct IMU_sample *sample;
+    uint8_t i;
+
+    if ((uint8_t) (queue_head - queue_tail) >= IMU_QUEUE_LENGTH) {
+        queue_overruns++;
+        return;
+    }
+    sample = &queue[queue_head & (IMU_QUEUE_LENGTH - 1)];
+    for (i = 0; i < MSZ; i++) {
+        sample->acc[i] = (int16_t) (IMU_raw_data[2 * i] << 8 | IMU_raw_data[2 * i + 1]);
+        sample->gyro[i] = (int16_t) (IMU_raw_data[6 + 2 * i] << 8 | IMU_raw_data[7 + 2 * i]);
+    }
+    sample->sample_time = acq_time;
+    queue_head++; // publishes the entry
+}
+
+/* keep_data(void)
+ * copies the read that just completed and its time for IMU_process_data(), so
+ * the next read can fill IMU_raw_data meanwhile; interrupt context
+ */
+static void keep_data(void) {
+    uint8_t i;
+
+    for (i = 0; i < IMU_NUM_BYTES; i++) {
+        IMU_last_data[i] = IMU_raw_data[i];
+    }
+    sample_time = acq_time;
+    last_data_count++;
+}
+
 /**
  * @Function IMU_process_data(void)
  * @param none
@@ -936,22 +1129,33 @@ static void IMU_run_SPI_state_machine(uint8_t byte_read) {
  * @author ahunter
  * @modified  */
 static void IMU_process_data(void) {
+    uint8_t IMU_data[IMU_NUM_BYTES];
+    uint8_t count;
+    uint8_t i;
+
+    do { // copy again if a read interrupt kept a newer sample meanwhile
+        count = last_data_count;
+        for (i = 0; i < IMU_NUM_BYTES; i++) {
+            IMU_data[i] = IMU_last_data[i];
+        }
+        data_time = sample_time;
+    } while (count != last_data_count);
     /*store data in module vectors*/
     /*data needs to be converted to short then cast as float */
-    acc_v_raw[0] = (float) (int16_t) (IMU_raw_data[0] << 8 | IMU_raw_data[1]);
-    acc_v_raw[1] = (float) (int16_t) (IMU_raw_data[2] << 8 | IMU_raw_data[3]);
-    acc_v_raw[2] = (float) (int16_t) (IMU_raw_data[4] << 8 | IMU_raw_data[5]);
-    gyro_v_raw[0] = (float) (int16_t) (IMU_raw_data[6] << 8 | IMU_raw_data[7]);
-    gyro_v_raw[1] = (float) (int16_t) (IMU_raw_data[8] << 8 | IMU_raw_data[9]);
-    gyro_v_raw[2] = (float) (int16_t) (IMU_raw_data[10] << 8 | IMU_raw_data[11]);
-    temp_raw = (float) (IMU_raw_data[12] << 8 | IMU_raw_data[13]);
+    acc_v_raw[0] = (float) (int16_t) (IMU_data[0] << 8 | IMU_data[1]);
+    acc_v_raw[1] = (float) (int16_t) (IMU_data[2] << 8 | IMU_data[3]);
+    acc_v_raw[2] = (float) (int16_t) (IMU_data[4] << 8 | IMU_data[5]);
+    gyro_v_raw[0] = (float) (int16_t) (IMU_data[6] << 8 | IMU_data[7]);
+    gyro_v_raw[1] = (float) (int16_t) (IMU_data[8] << 8 | IMU_data[9]);
+    gyro_v_raw[2] = (float) (int16_t) (IMU_data[10] << 8 | IMU_data[11]);
+    temp_raw = (float) (IMU_data[12] << 8 | IMU_data[13]);
     //need to orient mag data to accel and gyros by rotating around x axis
-    mag_v_raw[0] = (float) (int16_t) (IMU_raw_data[16] << 8 | IMU_raw_data[15]);
-    mag_v_raw[1] = (float) (int16_t) ((IMU_raw_data[18] << 8 | IMU_raw_data[17])*-1);
-    mag_v_raw[2] = (float) (int16_t) ((IMU_raw_data[20] << 8 | IMU_raw_data[19])*-1);
+    mag_v_raw[0] = (float) (int16_t) (IMU_data[16] << 8 | IMU_data[15]);
+    mag_v_raw[1] = (float) (int16_t) ((IMU_data[18] << 8 | IMU_data[17])*-1);
+    mag_v_raw[2] = (float) (int16_t) ((IMU_data[20] << 8 | IMU_data[19])*-1);
     /*status 1 is high byte and status 2 is low byte*/
     /*status 2 indicates mag overflow only*/
-    status = (IMU_raw_data[14] << 8 | IMU_raw_data[22] & 0x8);
+    status = (IMU_data[14] << 8 | IMU_data[22] & 0x8);
 }
 
 /**
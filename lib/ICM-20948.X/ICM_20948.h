@@ -3,6 +3,7 @@
  * Author: Aaron Hunter
  * Brief: Library for the ICM-20948 IMU
  * Created on Nov 13, 2020 9:46 am
+ * Modified on 10/16/2026
  */
 
 #ifndef ICM_20948_H // Header guard
@@ -20,6 +21,12 @@
  ******************************************************************************/
 #define IMU_SPI_MODE 0
 #define IMU_I2C_MODE 1
+/*data ready mode, sample rate is IMU_ODR_BASE / (1 + divider)*/
+#define IMU_ODR_BASE 1125 //Hz, accel and gyro internal sample rate
+#define IMU_QUEUE_LENGTH 32 //raw samples kept for IMU_read_sample(), a power of two
+/*raw counts, +/-2 g and +/-500 deg/sec full scale*/
+#define IMU_ACC_LSB (2.0 / 32767.0) //g per count
+#define IMU_GYRO_LSB (500.0 / 32767.0) //deg/sec per count
 /*lin alg constants*/
 #define MSZ 3 //matrix/vector size per dimension
 
@@ -39,6 +46,13 @@ struct IMU_out {
     struct IMU_axis mag;
     float temp;
     uint16_t mag_status;
+    uint64_t sample_time; // Sys_timer_get_ticks() at the start of the read
+};
+
+struct IMU_sample {
+    int16_t acc[MSZ]; // raw counts, IMU_ACC_LSB
+    int16_t gyro[MSZ]; // raw counts, IMU_GYRO_LSB
+    uint64_t sample_time; // Sys_timer_get_ticks() at the start of the read
 };
 
 /*******************************************************************************
@@ -62,6 +76,56 @@ uint8_t IMU_init(char interface_mode);
  **/
 int8_t IMU_start_data_acq(void);
 
+/**
+ * @Function IMU_enable_drdy(uint8_t divider)
+ * @param divider, accel and gyro sample rate divider, the sample rate is
+ * IMU_ODR_BASE / (1 + divider), e.g. 8 for 125 Hz
+ * @return SUCCESS or ERROR if the IMU is not in SPI mode
+ * @brief routes the raw data ready interrupt to the INT pin and starts the SPI
+ * read from the INT1 external interrupt on every new sample, so the data is
+ * read as soon as it is sampled instead of on the next control tick.  Do not
+ * call IMU_start_data_acq() while this mode is enabled.
+ * @note the INT pin of the ICM-20948 is wired to INT1 (RE8)
+ * @author Aaron Hunter
+ **/
+int8_t IMU_enable_drdy(uint8_t divider);
+
+/**
+ * @Function IMU_disable_drdy(void)
+ * @return none
+ * @brief stops the INT1 triggered reads, IMU_start_data_acq() starts each read
+ * again
+ * @author Aaron Hunter
+ **/
+void IMU_disable_drdy(void);
+
+/**
+ * @Function IMU_get_drdy_overruns(void)
+ * @return number of data ready interrupts that arrived while the previous SPI
+ * read was still running
+ * @author Aaron Hunter
+ **/
+uint32_t IMU_get_drdy_overruns(void);
+
+/**
+ * @Function IMU_read_sample(struct IMU_sample *sample)
+ * @param sample, gets the oldest queued sample
+ * @return TRUE or FALSE if the queue is empty
+ * @brief every complete read queues its raw accel and gyro counts, so a
+ * caller slower than the sample rate still gets every sample; the queue is
+ * apart from IMU_is_data_ready() and the IMU_get_*_data() calls
+ * @author Aaron Hunter
+ **/
+uint8_t IMU_read_sample(struct IMU_sample *sample);
+
+/**
+ * @Function IMU_get_queue_overruns(void)
+ * @return number of samples dropped because IMU_read_sample() had left the
+ * queue full
+ * @author Aaron Hunter
+ **/
+uint32_t IMU_get_queue_overruns(void);
+
 /**
  * @Function IMU_is_data_ready(void)
  * @return TRUE or FALSE
@@ -75,7 +139,8 @@ uint8_t IMU_is_data_ready(void);
  * @Function IMU_get_raw_data(void)
  * @return pointer to IMU_output struct 
  * @brief returns most current (raw) data from the IMU
- * @note 
+ * @note sample_time is the capture time of the data, the difference between
+ * two samples is the true integration interval
  * @author Aaron Hunter,
  **/
 uint8_t IMU_get_raw_data(struct IMU_out* IMU_data);
@@ -0,0 +1,267 @@
+/*
+ * File:   IMU_batch.c
+ * Brief: Batched high rate IMU telemetry over ENCAPSULATED_DATA, see
+ * IMU_batch.h.  The IMU_BATCH_TESTING harness reads the IMU at its full
+ * data ready rate, sends the batches on the USB port for a few seconds and
+ * prints the sample rate and the bytes per sample against HIGHRES_IMU.
+ * Created on 10/16/2026
+ * Modified on 10/17/2026
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+
+#include "IMU_batch.h" // The header file for this source file.
+#include "Board.h"
+#include "System_timer.h"
+#include <string.h>
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#define BATCH_DATA_LENGTH MAVLINK_MSG_ENCAPSULATED_DATA_FIELD_DATA_LEN
+#define NSEC_PER_TICK (1000 / SYS_TIMER_TICKS_PER_USEC)
+
+/*******************************************************************************
+ * PRIVATE TYPEDEFS                                                            *
+ ******************************************************************************/
+typedef struct {
+    uint64_t first; // sample_time of the first sample, ticks
+    uint64_t last;
+    uint16_t sequence; // ENCAPSULATED_DATA seqnr, given on closing
+    uint8_t count;
+    int16_t axis[IMU_BATCH_AXES][IMU_BATCH_SAMPLES];
+} batch_t;
+
+/*******************************************************************************
+ * PRIVATE VARIABLES                                                           *
+ ******************************************************************************/
+static batch_t open_batch; // filling
+static batch_t closed[IMU_BATCH_QUEUE]; // waiting for the link
+static uint8_t head = 0; // free running, masked on use
+static uint8_t tail = 0;
+static uint16_t sequence = 0;
+static uint32_t period_ticks = 0;
+static imu_batch_stats_t stats;
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                 *
+ ******************************************************************************/
+static void close_batch(void);
+static uint8_t pack(uint8_t *data, uint8_t length, const void *value, uint8_t size);
+static uint8_t has_room(uint8_t port, uint16_t frame);
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function IMU_batch_init(uint32_t period_ns)
+ * @param period_ns, nominal interval between the IMU samples, a sample more
+ * than half of it early or late closes the batch
+ * @return none
+ * @brief empties the batches and resets the statistics
+ * @author Aaron Hunter */
+void IMU_batch_init(uint32_t period_ns) {
+    period_ticks = period_ns / NSEC_PER_TICK;
+    open_batch.count = 0;
+    head = 0;
+    tail = 0;
+    sequence = 0;
+    IMU_batch_reset_stats();
+}
+
+/**
+ * @Function IMU_batch_add(const struct IMU_sample *sample)
+ * @param sample, the next sample from IMU_read_sample()
+ * @return none
+ * @brief adds the sample to the open batch, closes the batch when it is full
+ * or when the sample is off the interval, then starts the next with it
+ * @author Aaron Hunter */
+void IMU_batch_add(const struct IMU_sample *sample) {
+    uint64_t interval;
+    uint8_t n = open_batch.count;
+    uint8_t i;
+
+    if (n > 0) {
+        interval = sample->sample_time - open_batch.last;
+        if (interval < period_ticks / 2 || interval > period_ticks + period_ticks / 2) {
+            stats.gaps++;
+            close_batch();
+            n = 0;
+        }
+    }
+    if (n == 0) {
+        open_batch.first = sample->sample_time;
+    }
+    for (i = 0; i < MSZ; i++) {
+        open_batch.axis[i][n] = sample->acc[i];
+        open_batch.axis[MSZ + i][n] = sample->gyro[i];
+    }
+    open_batch.last = sample->sample_time;
+    open_batch.count = n + 1;
+    stats.samples++;
+    if (open_batch.count == IMU_BATCH_SAMPLES) {
+        close_batch();
+    }
+}
+
+/**
+ * @Function IMU_batch_send(uint8_t port)
+ * @param port, MAVLINK_TX_RADIO, MAVLINK_TX_USB or MAVLINK_TX_ALL
+ * @return SUCCESS or ERROR if no batch is closed or the port has no room for
+ * its frame, the batch then waits for the next call
+ * @brief sends the oldest closed batch as one ENCAPSULATED_DATA; a batch is
+ * sent once, on the first port that asks for it
+ * @author Aaron Hunter */
+int8_t IMU_batch_send(uint8_t port) {
+    uint8_t data[BATCH_DATA_LENGTH];
+    const batch_t *batch;
+    const float acc_lsb = IMU_ACC_LSB;
+    const float gyro_lsb = IMU_GYRO_LSB;
+    uint64_t usec;
+    uint32_t interval_ns;
+    uint8_t length = 0;
+    uint8_t i;
+
+    if (tail == head) {
+        return ERROR;
+    }
+    batch = &closed[tail & (IMU_BATCH_QUEUE - 1)];
+    /* seqnr, header and samples, the zero tail is trimmed */
+    if (has_room(port, MAVLINK_NUM_NON_PAYLOAD_BYTES + 2 + IMU_BATCH_HEADER_LENGTH
+            + batch->count * IMU_BATCH_AXES * sizeof (int16_t)) == FALSE) {
+        return ERROR;
+    }
+    if (batch->count > 1) {
+        /* the measured spacing, the IMU clock is not the system clock */
+        interval_ns = (uint32_t) ((batch->last - batch->first) * NSEC_PER_TICK / (batch->count - 1));
+    } else {
+        interval_ns = period_ticks * NSEC_PER_TICK;
+    }
+    usec = Sys_timer_ticks_to_usec(batch->first);
+    memset(data, 0, sizeof (data)); // MAVLink 2 trims the zero tail
+    data[length++] = IMU_BATCH_FORMAT;
+    data[length++] = batch->count;
+    length = pack(data, length, &interval_ns, sizeof (interval_ns));
+    length = pack(data, length, &usec, sizeof (usec));
+    length = pack(data, length, &acc_lsb, sizeof (acc_lsb));
+    length = pack(data, length, &gyro_lsb, sizeof (gyro_lsb));
+    for (i = 0; i < IMU_BATCH_AXES; i++) {
+        length = pack(data, length, batch->axis[i], batch->count * sizeof (int16_t));
+    }
+    mavlink_msg_encapsulated_data_send(port, batch->sequence, data);
+    tail++;
+    stats.sent++;
+    return SUCCESS;
+}
+
+/**
+ * @Function IMU_batch_get_stats(void)
+ * @return samples, batches, gaps, messages and drops since the last reset
+ * @author Aaron Hunter */
+const imu_batch_stats_t *IMU_batch_get_stats(void) {
+    return &stats;
+}
+
+/**
+ * @Function IMU_batch_reset_stats(void)
+ * @return none
+ * @author Aaron Hunter */
+void IMU_batch_reset_stats(void) {
+    memset(&stats, 0, sizeof (stats));
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/* close_batch(void)
+ * numbers the open batch and queues it for the link, or drops it if the
+ * queue is full, the skipped number tells the decoder
+ */
+static void close_batch(void) {
+    open_batch.sequence = sequence++;
+    stats.batches++;
+    if ((uint8_t) (head - tail) >= IMU_BATCH_QUEUE) {
+        stats.dropped++;
+    } else {
+        memcpy(&closed[head & (IMU_BATCH_QUEUE - 1)], &open_batch, sizeof (open_batch));
+        head++;
+    }
+    open_batch.count = 0;
+}
+
+/* pack(uint8_t *data, uint8_t length, const void *value, uint8_t size)
+ * appends the value's bytes, little endian as the PIC32 holds them, and
+ * returns the new length
+ */
+static uint8_t pack(uint8_t *data, uint8_t length, const void *value, uint8_t size) {
+    memcpy(&data[length], value, size);
+    return length + size;
+}
+
+/* has_room(uint8_t port, uint16_t frame)
+ * TRUE if frame bytes fit the port now, on MAVLINK_TX_ALL both ports, so a
+ * batch is not taken off the queue only to be dropped by the link
+ */
+static uint8_t has_room(uint8_t port, uint16_t frame) {
+    if (port == MAVLINK_TX_ALL) {
+        return Mavlink_tx_space(MAVLINK_TX_RADIO) >= frame && Mavlink_tx_space(MAVLINK_TX_USB) >= frame;
+    }
+    return Mavlink_tx_space(port) >= frame;
+}
+
+#ifdef IMU_BATCH_TESTING
+#include "SerialM32.h"
+#include "Radio_serial.h"
+#include <stdio.h>
+
+#define TEST_SECONDS 5
+#define HIGHRES_IMU_FRAME (MAVLINK_NUM_NON_PAYLOAD_BYTES + MAVLINK_MSG_ID_HIGHRES_IMU_LEN)
+#define BATCH_FRAME (MAVLINK_NUM_NON_PAYLOAD_BYTES + 2 + IMU_BATCH_HEADER_LENGTH \
+    + IMU_BATCH_AXES * IMU_BATCH_SAMPLES * 2)
+
+mavlink_system_t mavlink_system = {
+    1, // System ID (1-255)
+    MAV_COMP_ID_AUTOPILOT1 // Component ID (a MAV_COMPONENT value)
+};
+
+int main(void) {
+    struct IMU_sample sample;
+    uint32_t start;
+
+    Board_init();
+    Serial_init();
+    Radio_serial_init();
+    Sys_timer_init();
+    printf("\r\nIMU batch test harness %s, %s\r\n", __DATE__, __TIME__);
+    if (IMU_init(IMU_SPI_MODE) == ERROR || IMU_enable_drdy(0) == ERROR) {
+        printf("IMU failed to start\r\n");
+        while (1) {
+            ;
+        }
+    }
+    IMU_batch_init(1000000000UL / IMU_ODR_BASE);
+    start = Sys_timer_get_msec();
+    while (Sys_timer_get_msec() - start < TEST_SECONDS * 1000) {
+        while (IMU_read_sample(&sample) == TRUE) {
+            IMU_batch_add(&sample);
+        }
+        IMU_batch_send(MAVLINK_TX_USB);
+    }
+    while (Serial_tx_idle() == FALSE) {
+        ;
+    }
+    printf("\r\n%u samples/sec, %u batches sent, %u gaps, %u dropped, %u queue overruns\r\n",
+            stats.samples / TEST_SECONDS, stats.sent, stats.gaps, stats.dropped,
+            IMU_get_queue_overruns());
+    printf("batch %u bytes/sample, HIGHRES_IMU %u bytes/sample\r\n",
+            BATCH_FRAME / IMU_BATCH_SAMPLES, HIGHRES_IMU_FRAME);
+    while (1) {
+        ;
+    }
+    return 0;
+}
+#endif //IMU_BATCH_TESTING
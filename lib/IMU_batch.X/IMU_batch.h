@@ -0,0 +1,99 @@
+/*
+ * File:   IMU_batch.h
+ * Brief: Batched high rate IMU telemetry.  The raw accel and gyro counts of
+ * every IMU sample are packed, IMU_BATCH_SAMPLES at a time, into one
+ * ENCAPSULATED_DATA message with the time of the first sample and a fixed
+ * interval, so the ground sees the IMU at its sample rate for a fraction of
+ * the bytes of a message per sample.  A batch is closed early when a sample
+ * is missing, so the interval always holds inside a batch.  The message
+ * sequence numbers are given as batches close, so a batch dropped for a
+ * slow link shows up as a gap; python/imu_batch_decode.py expands the
+ * batches back into samples.  Main loop only.
+ * Created on 10/16/2026
+ * Modified on 10/17/2026
+ */
+
+#ifndef IMU_BATCH_H // Header guard
+#define	IMU_BATCH_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+#include <stdint.h>
+#include "Mavlink_tx.h"
+#include "ICM_20948.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+#define IMU_BATCH_FORMAT 0xB1 // first data byte, tells a batch from other ENCAPSULATED_DATA
+#define IMU_BATCH_HEADER_LENGTH 22 // format, count, interval, time and scales
+#define IMU_BATCH_AXES 6 // accel x, y, z then gyro x, y, z
+#define IMU_BATCH_SAMPLES ((MAVLINK_MSG_ENCAPSULATED_DATA_FIELD_DATA_LEN - IMU_BATCH_HEADER_LENGTH) / (IMU_BATCH_AXES * 2))
+#define IMU_BATCH_QUEUE 4 // closed batches waiting for the link, a power of two
+
+/* Data layout, little endian:
+ *  0 uint8   IMU_BATCH_FORMAT
+ *  1 uint8   count, samples in the batch
+ *  2 uint32  interval between the samples, nsec
+ *  6 uint64  time of the first sample, usec since boot
+ * 14 float   g per accel count
+ * 18 float   deg/sec per gyro count
+ * 22 int16   accel x of each sample, then accel y, z and gyro x, y, z, each
+ *            axis count samples long */
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+typedef struct {
+    uint32_t samples; // added
+    uint32_t batches; // closed
+    uint32_t gaps; // batches closed early by a missing sample
+    uint32_t sent; // ENCAPSULATED_DATA
+    uint32_t dropped; // closed batches lost to a full queue
+} imu_batch_stats_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function IMU_batch_init(uint32_t period_ns)
+ * @param period_ns, nominal interval between the IMU samples, a sample more
+ * than half of it early or late closes the batch
+ * @return none
+ * @brief empties the batches and resets the statistics
+ * @author Aaron Hunter */
+void IMU_batch_init(uint32_t period_ns);
+
+/**
+ * @Function IMU_batch_add(const struct IMU_sample *sample)
+ * @param sample, the next sample from IMU_read_sample()
+ * @return none
+ * @brief adds the sample to the open batch, closes the batch when it is full
+ * or when the sample is off the interval, then starts the next with it
+ * @author Aaron Hunter */
+void IMU_batch_add(const struct IMU_sample *sample);
+
+/**
+ * @Function IMU_batch_send(uint8_t port)
+ * @param port, MAVLINK_TX_RADIO, MAVLINK_TX_USB or MAVLINK_TX_ALL
+ * @return SUCCESS or ERROR if no batch is closed
+ * @brief sends the oldest closed batch as one ENCAPSULATED_DATA; a batch is
+ * sent once, on the first port that asks for it
+ * @author Aaron Hunter */
+int8_t IMU_batch_send(uint8_t port);
+
+/**
+ * @Function IMU_batch_get_stats(void)
+ * @return samples, batches, gaps, messages and drops since the last reset
+ * @author Aaron Hunter */
+const imu_batch_stats_t *IMU_batch_get_stats(void);
+
+/**
+ * @Function IMU_batch_reset_stats(void)
+ * @return none
+ * @author Aaron Hunter */
+void IMU_batch_reset_stats(void);
+
+#endif	/* IMU_BATCH_H */ // End of header guard
@@ -0,0 +1,448 @@
+/*
+ * File:   Fast_math.c
+ * Brief: Bounded error replacements for the libm calls on the control loop
+ * Created on 10/16/2026
+ * Modified on
+ *
+ * Host test (sweeps each function over its input domain against libm in
+ * double, checks the documented maximum errors and times both):
+ * gcc -O2 -DFAST_MATH_TESTING -I../Board.X Fast_math.c -lm -o fast_math
+ * ./fast_math [stride], stride 1 checks every float, the default skips some
+ * On the target define FAST_MATH_TESTING, the times are then in cycles.
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+#include "Fast_math.h"
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#define INV_PI 0.318309886183791f
+/* pi split so k * PI_A is exact for the |k| reached in FAST_SINCOS_RANGE */
+#define PI_A 3.140625f
+#define PI_B 9.67653589793e-4f
+#define INV_SQRT_MAGIC 0x5f375a86 // initial guess, Lomont 2003
+
+/* atan(x) = x (1 + a2 x^2 + ... + a16 x^16), 0 <= x <= 1, A&S 4.4.49 */
+#define ATAN_A2 -0.3333314528f
+#define ATAN_A4 0.1999355085f
+#define ATAN_A6 -0.1420889944f
+#define ATAN_A8 0.1065626393f
+#define ATAN_A10 -0.0752896400f
+#define ATAN_A12 0.0429096138f
+#define ATAN_A14 -0.0161657367f
+#define ATAN_A16 0.0028662257f
+
+/* asin(x) = pi/2 - sqrt(1 - x) (a0 + a1 x + ... + a7 x^7), 0 <= x <= 1,
+ * A&S 4.4.46 */
+#define ASIN_A0 1.5707963050f
+#define ASIN_A1 -0.2145988016f
+#define ASIN_A2 0.0889789874f
+#define ASIN_A3 -0.0501743046f
+#define ASIN_A4 0.0308918810f
+#define ASIN_A5 -0.0170881256f
+#define ASIN_A6 0.0066700901f
+#define ASIN_A7 -0.0012624911f
+
+/* sin(x) Taylor terms to x^11, truncation below 6e-8 on [-pi/2, pi/2] */
+#define SIN_C3 -1.66666666667e-1f
+#define SIN_C5 8.33333333333e-3f
+#define SIN_C7 -1.98412698413e-4f
+#define SIN_C9 2.75573192240e-6f
+#define SIN_C11 -2.50521083854e-8f
+
+/*******************************************************************************
+ * PRIVATE TYPEDEFS                                                            *
+ ******************************************************************************/
+typedef union {
+    float f;
+    uint32_t i;
+} float_bits_t;
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                *
+ ******************************************************************************/
+/**
+ * @Function atan_poly(float x)
+ * @param x, in [0, 1]
+ * @return atan(x) */
+static float atan_poly(float x);
+
+/**
+ * @Function sin_poly(float x)
+ * @param x, in [-pi/2, pi/2]
+ * @return sin(x) */
+static float sin_poly(float x);
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function fast_atan2f(float y, float x)
+ * @param y, x, as for atan2f()
+ * @return the angle of (x, y) in [-pi, pi], 0 for (0, 0)
+ * @brief octant reduction, one divide and a 17th order odd polynomial
+ * (Abramowitz and Stegun 4.4.49), max error FAST_ATAN2_MAX_ERR
+ * @author Aaron Hunter, 10/16/2026 */
+float fast_atan2f(float y, float x) {
+    /* the float result near +/- pi is only good to 1.2e-7, most of the error */
+    float ax = x < 0 ? -x : x;
+    float ay = y < 0 ? -y : y;
+    float angle;
+
+    if (ax == 0 && ay == 0) {
+        return 0;
+    }
+    if (ay <= ax) {
+        angle = atan_poly(ay / ax);
+    } else {
+        angle = FAST_HALF_PI - atan_poly(ax / ay);
+    }
+    if (x < 0) {
+        angle = FAST_PI - angle;
+    }
+    return y < 0 ? -angle : angle;
+}
+
+/**
+ * @Function fast_asinf(float x)
+ * @param x, clamped to [-1, 1]
+ * @return asin(x) in [-pi/2, pi/2]
+ * @brief pi/2 - sqrt(1 - |x|) P(|x|) with a 7th order P (Abramowitz and
+ * Stegun 4.4.46), max error FAST_ASIN_MAX_ERR
+ * @author Aaron Hunter, 10/16/2026 */
+float fast_asinf(float x) {
+    float ax = x < 0 ? -x : x;
+    float p;
+    float s;
+    float angle;
+
+    if (ax >= 1.0f) {
+        return x < 0 ? -FAST_HALF_PI : FAST_HALF_PI;
+    }
+    p = ASIN_A7;
+    p = p * ax + ASIN_A6;
+    p = p * ax + ASIN_A5;
+    p = p * ax + ASIN_A4;
+    p = p * ax + ASIN_A3;
+    p = p * ax + ASIN_A2;
+    p = p * ax + ASIN_A1;
+    p = p * ax + ASIN_A0;
+    s = 1.0f - ax;
+    angle = FAST_HALF_PI - s * fast_inv_sqrtf(s) * p;
+    return x < 0 ? -angle : angle;
+}
+
+/**
+ * @Function fast_sinf(float x)
+ * @param x, angle in rad
+ * @return sin(x)
+ * @brief reduced to [-pi/2, pi/2] then an 11th order odd polynomial, max
+ * error FAST_SINCOS_MAX_ERR for |x| <= FAST_SINCOS_RANGE
+ * @author Aaron Hunter, 10/16/2026 */
+float fast_sinf(float x) {
+    /* x = k pi + r, sin(x) = (-1)^k sin(r) */
+    int32_t k = (int32_t) (x * INV_PI + (x < 0 ? -0.5f : 0.5f));
+    float r = (x - k * PI_A) - k * PI_B;
+    float s = sin_poly(r);
+
+    return (k & 1) ? -s : s;
+}
+
+/**
+ * @Function fast_cosf(float x)
+ * @param x, angle in rad
+ * @return cos(x), same error as fast_sinf()
+ * @author Aaron Hunter, 10/16/2026 */
+float fast_cosf(float x) {
+    /* x = (k + 1/2) pi + r, cos(x) = -(-1)^k sin(r) */
+    int32_t k = (int32_t) (x * INV_PI + (x < 0 ? -1.0f : 0.0f));
+    float h = k + 0.5f;
+    float r = (x - h * PI_A) - h * PI_B;
+    float s = sin_poly(r);
+
+    return (k & 1) ? s : -s;
+}
+
+/**
+ * @Function fast_inv_sqrtf(float x)
+ * @param x, positive
+ * @return 1 / sqrt(x), relative error FAST_INV_SQRT_MAX_REL_ERR
+ * @brief exponent halving initial guess and three Newton steps, multiplies
+ * only, 0 for x <= 0
+ * @author Aaron Hunter, 10/16/2026 */
+float fast_inv_sqrtf(float x) {
+    float_bits_t b;
+    float half_x = 0.5f * x;
+
+    if (!(x > 0)) {
+        return 0;
+    }
+    b.f = x;
+    b.i = INV_SQRT_MAGIC - (b.i >> 1);
+    /* each step squares the relative error, 3.4e-2 -> 1.8e-3 -> 4.7e-6 ->
+     * float rounding, two steps bias a normalized quaternion low enough to
+     * show up in the AHRS replay */
+    b.f = b.f * (1.5f - half_x * b.f * b.f);
+    b.f = b.f * (1.5f - half_x * b.f * b.f);
+    b.f = b.f * (1.5f - half_x * b.f * b.f);
+    return b.f;
+}
+
+/**
+ * @Function fast_sqrtf(float x)
+ * @param x, positive
+ * @return sqrt(x) as x * fast_inv_sqrtf(x), same relative error, 0 for x <= 0
+ * @author Aaron Hunter, 10/16/2026 */
+float fast_sqrtf(float x) {
+    return x * fast_inv_sqrtf(x);
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/**
+ * @Function atan_poly(float x)
+ * @param x, in [0, 1]
+ * @return atan(x) */
+static float atan_poly(float x) {
+    float x2 = x * x;
+    float p = ATAN_A16;
+
+    p = p * x2 + ATAN_A14;
+    p = p * x2 + ATAN_A12;
+    p = p * x2 + ATAN_A10;
+    p = p * x2 + ATAN_A8;
+    p = p * x2 + ATAN_A6;
+    p = p * x2 + ATAN_A4;
+    p = p * x2 + ATAN_A2;
+    return x + x * x2 * p;
+}
+
+/**
+ * @Function sin_poly(float x)
+ * @param x, in [-pi/2, pi/2]
+ * @return sin(x) */
+static float sin_poly(float x) {
+    float x2 = x * x;
+    float p = SIN_C11;
+
+    p = p * x2 + SIN_C9;
+    p = p * x2 + SIN_C7;
+    p = p * x2 + SIN_C5;
+    p = p * x2 + SIN_C3;
+    return x + x * x2 * p;
+}
+
+#ifdef FAST_MATH_TESTING
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "Board.h"
+
+/**
+ * Sweeps each function over its input domain against libm in double and
+ * checks the maximum errors documented in Fast_math.h, then times each against
+ * the libm call it replaces.  On the target the sweeps are coarser and the
+ * times are core timer counts converted to cycles, on a host they are nsec. */
+
+#define NUM_TIMED 1000
+
+#ifdef __XC32
+#include <xc.h>
+#include "SerialM32.h"
+#define DEFAULT_STRIDE 4096
+#define TIME_UNITS "cycles"
+#define time_now() ((double) _CP0_GET_COUNT() * 2.0)
+#else
+#include <time.h>
+#define DEFAULT_STRIDE 61
+#define TIME_UNITS "nsec"
+
+static double time_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+#endif
+
+static volatile float sink;
+static float timed_a[NUM_TIMED];
+static float timed_b[NUM_TIMED];
+
+/**
+ * @function report()
+ * @return 1 if err is over the limit
+ */
+static int report(const char *name, double err, double limit, const char *where, double at) {
+    printf("%-16s max err %.3e (limit %.1e) at %s %.7g %s\r\n", name, err, limit,
+            where, at, err <= limit ? "pass" : "FAIL");
+    return err > limit;
+}
+
+/**
+ * @function angle_diff()
+ * @return |a - b| wrapped to [0, pi], so -pi and pi (atan2 of -0 and +0) agree
+ */
+static double angle_diff(double a, double b) {
+    double d = fmod(fabs(a - b), 2.0 * M_PI);
+    return d > M_PI ? 2.0 * M_PI - d : d;
+}
+
+/**
+ * @function next_float()
+ * @return the float stride representable values above f, for sweeps
+ */
+static float next_float(float f, uint32_t stride) {
+    float_bits_t b;
+    b.f = f;
+    if (f >= 0) {
+        b.i += stride;
+    } else if (b.i - stride < 0x80000000u) {
+        b.f = 0; // crossed zero
+    } else {
+        b.i -= stride;
+    }
+    return b.f;
+}
+
+int main(int argc, char **argv) {
+    uint32_t stride = DEFAULT_STRIDE;
+    int fails = 0;
+    float x;
+    float y;
+    double err;
+    double max_err;
+    double at;
+    double at2 = 0;
+    double t_start;
+    double t_lib;
+    double t_fast;
+    int i;
+    int j;
+
+#ifdef __XC32
+    Board_init();
+    Serial_init();
+#else
+    if (argc > 1) stride = atoi(argv[1]);
+    if (stride < 1) stride = 1;
+#endif
+    printf("Fast math test harness %s, %s, stride %u\r\n", __DATE__, __TIME__,
+            (unsigned int) stride);
+
+    /* atan2: the ratio y/x over [-1, 1] in both octants of each quadrant at
+     * several radii, 16 calls per ratio so a coarser stride */
+    max_err = 0;
+    at = 0;
+    for (x = -1.0f; x <= 1.0f; x = next_float(x, 16 * stride)) {
+        for (j = 0; j < 8; j++) {
+            float r = j < 4 ? 1e-3f * (1 << (3 * j)) : -1e-3f * (1 << (3 * (j - 4)));
+            float a = x * r;
+            // (a, r) covers |y| <= |x|, (r, a) covers |y| >= |x|
+            err = angle_diff(fast_atan2f(a, r), atan2((double) a, (double) r));
+            if (err > max_err) max_err = err, at = a, at2 = r;
+            err = angle_diff(fast_atan2f(r, a), atan2((double) r, (double) a));
+            if (err > max_err) max_err = err, at = r, at2 = a;
+        }
+    }
+    printf("atan2 worst case y %.7g x %.7g\r\n", at, at2);
+    fails += report("fast_atan2f", max_err, FAST_ATAN2_MAX_ERR, "ratio", at / at2);
+    fails += fast_atan2f(0, 0) != 0;
+    fails += fabsf(fast_atan2f(0, -1) - FAST_PI) > FAST_ATAN2_MAX_ERR;
+
+    /* asin over [-1, 1] */
+    max_err = 0;
+    at = 0;
+    for (x = -1.0f; x <= 1.0f; x = next_float(x, stride)) {
+        err = fabs(fast_asinf(x) - asin((double) x));
+        if (err > max_err) max_err = err, at = x;
+    }
+    fails += report("fast_asinf", max_err, FAST_ASIN_MAX_ERR, "x", at);
+
+    /* sin and cos over +/- FAST_SINCOS_RANGE */
+    max_err = 0;
+    at = 0;
+    for (x = -FAST_SINCOS_RANGE; x <= FAST_SINCOS_RANGE; x = next_float(x, stride)) {
+        err = fabs(fast_sinf(x) - sin((double) x));
+        if (err > max_err) max_err = err, at = x;
+    }
+    fails += report("fast_sinf", max_err, FAST_SINCOS_MAX_ERR, "x", at);
+    max_err = 0;
+    at = 0;
+    for (x = -FAST_SINCOS_RANGE; x <= FAST_SINCOS_RANGE; x = next_float(x, stride)) {
+        err = fabs(fast_cosf(x) - cos((double) x));
+        if (err > max_err) max_err = err, at = x;
+    }
+    fails += report("fast_cosf", max_err, FAST_SINCOS_MAX_ERR, "x", at);
+
+    /* inverse sqrt over every positive normal float */
+    max_err = 0;
+    at = 0;
+    for (x = 1.17549435e-38f; x < 3.4e38f && x > 0; x = next_float(x, stride)) {
+        err = fabs(fast_inv_sqrtf(x) * sqrt((double) x) - 1.0);
+        if (err > max_err) max_err = err, at = x;
+    }
+    fails += report("fast_inv_sqrtf", max_err, FAST_INV_SQRT_MAX_REL_ERR, "x", at);
+    fails += fast_inv_sqrtf(0) != 0;
+    fails += fast_inv_sqrtf(-1) != 0;
+
+    /* timing on typical control loop arguments */
+    for (i = 0; i < NUM_TIMED; i++) {
+        timed_a[i] = (float) (i - NUM_TIMED / 2) / (NUM_TIMED / 2);
+        timed_b[i] = (float) ((i * 7919) % NUM_TIMED - NUM_TIMED / 2) / (NUM_TIMED / 4) + 0.01f;
+    }
+    printf("\r\n%-16s %12s %12s\r\n", TIME_UNITS, "libm", "fast");
+    t_start = time_now();
+    for (i = 0; i < NUM_TIMED; i++) sink = atan2f(timed_a[i], timed_b[i]);
+    t_lib = time_now() - t_start;
+    t_start = time_now();
+    for (i = 0; i < NUM_TIMED; i++) sink = fast_atan2f(timed_a[i], timed_b[i]);
+    t_fast = time_now() - t_start;
+    printf("%-16s %12.1f %12.1f\r\n", "atan2f", t_lib / NUM_TIMED, t_fast / NUM_TIMED);
+    t_start = time_now();
+    for (i = 0; i < NUM_TIMED; i++) sink = asinf(timed_a[i]);
+    t_lib = time_now() - t_start;
+    t_start = time_now();
+    for (i = 0; i < NUM_TIMED; i++) sink = fast_asinf(timed_a[i]);
+    t_fast = time_now() - t_start;
+    printf("%-16s %12.1f %12.1f\r\n", "asinf", t_lib / NUM_TIMED, t_fast / NUM_TIMED);
+    t_start = time_now();
+    for (i = 0; i < NUM_TIMED; i++) sink = sinf(4.0f * timed_b[i]);
+    t_lib = time_now() - t_start;
+    t_start = time_now();
+    for (i = 0; i < NUM_TIMED; i++) sink = fast_sinf(4.0f * timed_b[i]);
+    t_fast = time_now() - t_start;
+    printf("%-16s %12.1f %12.1f\r\n", "sinf", t_lib / NUM_TIMED, t_fast / NUM_TIMED);
+    t_start = time_now();
+    for (i = 0; i < NUM_TIMED; i++) sink = cosf(4.0f * timed_b[i]);
+    t_lib = time_now() - t_start;
+    t_start = time_now();
+    for (i = 0; i < NUM_TIMED; i++) sink = fast_cosf(4.0f * timed_b[i]);
+    t_fast = time_now() - t_start;
+    printf("%-16s %12.1f %12.1f\r\n", "cosf", t_lib / NUM_TIMED, t_fast / NUM_TIMED);
+    t_start = time_now();
+    for (i = 0; i < NUM_TIMED; i++) {
+        y = timed_b[i] * timed_b[i] + 0.5f;
+        sink = 1.0f / sqrtf(y);
+    }
+    t_lib = time_now() - t_start;
+    t_start = time_now();
+    for (i = 0; i < NUM_TIMED; i++) {
+        y = timed_b[i] * timed_b[i] + 0.5f;
+        sink = fast_inv_sqrtf(y);
+    }
+    t_fast = time_now() - t_start;
+    printf("%-16s %12.1f %12.1f\r\n", "1/sqrtf", t_lib / NUM_TIMED, t_fast / NUM_TIMED);
+
+    printf("\r\n%d check(s) failed\r\n", fails);
+#ifdef __XC32
+    while (1);
+#endif
+    return fails == 0 ? 0 : 1;
+}
+#endif
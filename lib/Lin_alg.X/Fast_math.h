@@ -0,0 +1,93 @@
+/*
+ * File:   Fast_math.h
+ * Brief: Bounded error replacements for the libm calls on the control loop.
+ * The PIC32MX has no FPU, so atan2(), asin(), sin(), cos(), sqrt() and the
+ * divides after them are long soft-float library routines, in double when the
+ * float versions are not called explicitly.  These are short polynomials in
+ * float with a single range reduction each.  The maximum errors below are
+ * measured by the FAST_MATH_TESTING sweep in Fast_math.c.
+ * Created on 10/16/2026
+ * Modified on
+ */
+
+#ifndef FAST_MATH_H // Header guard
+#define	FAST_MATH_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+#include <stdint.h>
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+#define FAST_PI 3.14159265358979f
+#define FAST_HALF_PI 1.57079632679490f
+#define FAST_TWO_PI 6.28318530717959f
+
+/* documented maximum errors, checked by the test harness */
+#define FAST_ATAN2_MAX_ERR 3.5e-7 // rad, all of (y, x), -pi for y = -0 is pi
+#define FAST_ASIN_MAX_ERR 5.0e-7 // rad, x in [-1, 1]
+#define FAST_SINCOS_MAX_ERR 5.0e-7 // absolute, |x| <= FAST_SINCOS_RANGE
+#define FAST_SINCOS_RANGE 1000.0f // rad, reduction error grows with |x| beyond
+#define FAST_INV_SQRT_MAX_REL_ERR 2.5e-7 // relative, all positive normal x
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function fast_atan2f(float y, float x)
+ * @param y, x, as for atan2f()
+ * @return the angle of (x, y) in [-pi, pi], 0 for (0, 0)
+ * @brief octant reduction, one divide and a 17th order odd polynomial
+ * (Abramowitz and Stegun 4.4.49), max error FAST_ATAN2_MAX_ERR
+ * @author Aaron Hunter, 10/16/2026 */
+float fast_atan2f(float y, float x);
+
+/**
+ * @Function fast_asinf(float x)
+ * @param x, clamped to [-1, 1]
+ * @return asin(x) in [-pi/2, pi/2]
+ * @brief pi/2 - sqrt(1 - |x|) P(|x|) with a 7th order P (Abramowitz and
+ * Stegun 4.4.46), max error FAST_ASIN_MAX_ERR
+ * @author Aaron Hunter, 10/16/2026 */
+float fast_asinf(float x);
+
+/**
+ * @Function fast_sinf(float x)
+ * @param x, angle in rad
+ * @return sin(x)
+ * @brief reduced to [-pi/2, pi/2] then an 11th order odd polynomial, max
+ * error FAST_SINCOS_MAX_ERR for |x| <= FAST_SINCOS_RANGE
+ * @author Aaron Hunter, 10/16/2026 */
+float fast_sinf(float x);
+
+/**
+ * @Function fast_cosf(float x)
+ * @param x, angle in rad
+ * @return cos(x), same error as fast_sinf()
+ * @author Aaron Hunter, 10/16/2026 */
+float fast_cosf(float x);
+
+/**
+ * @Function fast_inv_sqrtf(float x)
+ * @param x, positive
+ * @return 1 / sqrt(x), relative error FAST_INV_SQRT_MAX_REL_ERR
+ * @brief exponent halving initial guess and three Newton steps, multiplies
+ * only, 0 for x <= 0
+ * @author Aaron Hunter, 10/16/2026 */
+float fast_inv_sqrtf(float x);
+
+/**
+ * @Function fast_sqrtf(float x)
+ * @param x, positive
+ * @return sqrt(x) as x * fast_inv_sqrtf(x), same relative error, 0 for x <= 0
+ * @author Aaron Hunter, 10/16/2026 */
+float fast_sqrtf(float x);
+
+#endif	/* FAST_MATH_H */ // End of header guard
@@ -0,0 +1,529 @@
+/*
+ * File:   Lin_alg_bench.c
+ * Brief: Host (Linux) check and benchmark of the Lin_alg_inline.h kernels
+ * against the out of line Lin_alg_float.c functions.  Each inline kernel is
+ * first checked against its Lin_alg_float equivalent on random inputs, then
+ * both are timed on single operations and on the body of AHRS_update() (two
+ * vector rotations, two cross/scale feedback terms, the gyro correction, the
+ * quaternion derivative, integration and normalization).  Library calls made
+ * by the array version are counted so the call overhead can be compared with
+ * the inline version, which makes none.  Lin_alg_float.c is compiled as its
+ * own translation unit, as it is on the board, so its calls are not inlined.
+ * Created on 10/16/2026
+ * Modified on
+ *
+ * Build (from this directory):
+ * gcc -O2 -I../Board.X Lin_alg_bench.c Lin_alg_float.c Fast_math.c -lm
+ *  -o lin_alg_bench
+ * Run:
+ * ./lin_alg_bench [iterations]
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "Board.h"
+#include "Lin_alg_float.h"
+#include "Lin_alg_inline.h"
+
+/*******************************************************************************
+ * #DEFINES                                                                    *
+ ******************************************************************************/
+#define NUM_SAMPLES 1024 // power of 2, inputs cycled through by the benchmarks
+#define DEFAULT_ITERATIONS 2000000
+#define TOLERANCE 1e-5
+
+/* counts the library calls made by the array versions */
+#define CALL(f) (lib_calls++, f)
+
+/*******************************************************************************
+ * VARIABLES                                                                   *
+ ******************************************************************************/
+static long lib_calls;
+
+/* random inputs, unit quaternions and vectors with sensor like magnitudes */
+static float in_v1[NUM_SAMPLES][MSZ];
+static float in_v2[NUM_SAMPLES][MSZ];
+static float in_q[NUM_SAMPLES][QSZ];
+static float in_m[NUM_SAMPLES][MSZ][MSZ];
+
+/* keeps the results alive so the loops are not optimized away */
+static volatile float sink;
+
+static const float a_i[MSZ] = {0, 0, 1.0};
+static const float m_i[MSZ] = {0.110011998753301, 0.478219898291142, -0.871322609031072};
+
+/*******************************************************************************
+ * FUNCTIONS                                                                   *
+ ******************************************************************************/
+
+/**
+ * @function cpu_nsec()
+ * @return process cpu time in nsec
+ */
+static double cpu_nsec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @function rand_uniform()
+ * @return a random number in [-1, 1]
+ */
+static float rand_uniform(void) {
+    return 2.0f * rand() / (float) RAND_MAX - 1.0f;
+}
+
+/**
+ * @function fill_inputs()
+ * @brief fills the input tables
+ */
+static void fill_inputs(void) {
+    int n;
+    int i;
+    int j;
+    float q_n;
+
+    srand(1);
+    for (n = 0; n < NUM_SAMPLES; n++) {
+        for (i = 0; i < MSZ; i++) {
+            in_v1[n][i] = 10.0f * rand_uniform();
+            in_v2[n][i] = rand_uniform();
+            for (j = 0; j < MSZ; j++) {
+                in_m[n][i][j] = rand_uniform();
+            }
+        }
+        for (i = 0; i < QSZ; i++) {
+            in_q[n][i] = rand_uniform();
+        }
+        q_n = lin_alg_q_norm(in_q[n]);
+        for (i = 0; i < QSZ; i++) {
+            in_q[n][i] /= q_n;
+        }
+    }
+}
+
+/**
+ * @function max_diff()
+ * @return largest absolute difference between a and b
+ */
+static float max_diff(const float *a, const float *b, int size) {
+    float d = 0;
+    int i;
+    for (i = 0; i < size; i++) {
+        if (fabsf(a[i] - b[i]) > d) d = fabsf(a[i] - b[i]);
+    }
+    return d;
+}
+
+/**
+ * @function report()
+ * @param name, kernel name
+ * @param err, largest difference found
+ * @return TRUE if within tolerance
+ */
+static int8_t report(const char *name, float err) {
+    int8_t pass = err <= TOLERANCE ? TRUE : FALSE;
+    printf("%-18s max diff %.3e %s\n", name, err, pass == TRUE ? "pass" : "FAIL");
+    return pass;
+}
+
+/**
+ * @function q_rot_v_array()
+ * @brief inertial to body rotation q* x [0 v] x q, as AHRS.c q_rot_v_q()
+ */
+static void q_rot_v_array(const float v_i[MSZ], float q[QSZ], float v_b[MSZ]) {
+    float q_i[QSZ] = {0, v_i[0], v_i[1], v_i[2]};
+    float q_conj[QSZ] = {q[0], -q[1], -q[2], -q[3]};
+    float q_temp[QSZ];
+    float q_b[QSZ];
+
+    CALL(lin_alg_q_mult(q_i, q, q_temp));
+    CALL(lin_alg_q_mult(q_conj, q_temp, q_b));
+    v_b[0] = q_b[1];
+    v_b[1] = q_b[2];
+    v_b[2] = q_b[3];
+}
+
+/**
+ * @function q_rot_v_inline()
+ * @brief the same rotation with the inline kernels
+ */
+static inline vec3_t q_rot_v_inline(vec3_t v_i, quat_t q) {
+    quat_t q_i = {0, v_i.x, v_i.y, v_i.z};
+    quat_t q_b = quat_mult(quat_conj(q), quat_mult(q_i, q));
+
+    return vec3_set(q_b.x, q_b.y, q_b.z);
+}
+
+/**
+ * @function ahrs_step_array()
+ * @brief the arithmetic of AHRS_update() written against Lin_alg_float.c
+ */
+static void ahrs_step_array(float acc[MSZ], float mag[MSZ], float gyro[MSZ],
+        float q[QSZ], float b[MSZ], float dt) {
+    float a_b[MSZ];
+    float m_b[MSZ];
+    float w_ap[MSZ];
+    float w_mp[MSZ];
+    float w_ai[MSZ];
+    float w_mi[MSZ];
+    float gyro_cal[MSZ];
+    float gyro_wfb[MSZ];
+    float gyro_q_wfb[QSZ];
+    float q_dot[QSZ];
+    float n;
+    int i;
+
+    n = 1.0f / CALL(lin_alg_v_norm(acc));
+    CALL(lin_alg_v_scale(n, acc));
+    n = 1.0f / CALL(lin_alg_v_norm(mag));
+    CALL(lin_alg_v_scale(n, mag));
+
+    q_rot_v_array(a_i, q, a_b);
+    CALL(lin_alg_cross(acc, a_b, w_ap));
+    for (i = 0; i < MSZ; i++) w_ai[i] = w_ap[i];
+    CALL(lin_alg_v_scale(2.5f, w_ap));
+    CALL(lin_alg_v_scale(0.05f, w_ai));
+
+    q_rot_v_array(m_i, q, m_b);
+    CALL(lin_alg_cross(mag, m_b, w_mp));
+    for (i = 0; i < MSZ; i++) w_mi[i] = w_mp[i];
+    CALL(lin_alg_v_scale(2.5f, w_mp));
+    CALL(lin_alg_v_scale(0.05f, w_mi));
+
+    CALL(lin_alg_v_v_sub(gyro, b, gyro_cal));
+    CALL(lin_alg_v_v_add(w_ap, w_mp, gyro_wfb));
+    CALL(lin_alg_v_v_add(gyro_cal, gyro_wfb, gyro_wfb));
+    gyro_q_wfb[0] = 0;
+    gyro_q_wfb[1] = gyro_wfb[0];
+    gyro_q_wfb[2] = gyro_wfb[1];
+    gyro_q_wfb[3] = gyro_wfb[2];
+    CALL(lin_alg_q_mult(q, gyro_q_wfb, q_dot));
+    for (i = 0; i < QSZ; i++) q[i] += 0.5f * q_dot[i] * dt;
+    n = 1.0f / CALL(lin_alg_q_norm(q));
+    CALL(lin_alg_scale_q(n, q));
+    for (i = 0; i < MSZ; i++) b[i] -= (w_ai[i] + w_mi[i]) * dt;
+}
+
+/**
+ * @function ahrs_step_inline()
+ * @brief the arithmetic of AHRS_update() written against Lin_alg_inline.h
+ */
+static void ahrs_step_inline(vec3_t acc, vec3_t mag, vec3_t gyro,
+        quat_t *q, vec3_t *b, float dt) {
+    vec3_t e_a;
+    vec3_t e_m;
+    vec3_t w;
+
+    vec3_normalize(&acc);
+    vec3_normalize(&mag);
+    e_a = vec3_cross(acc, q_rot_v_inline(vec3_load(a_i), *q));
+    e_m = vec3_cross(mag, q_rot_v_inline(vec3_load(m_i), *q));
+    w = vec3_axpy(2.5f, e_a, vec3_axpy(2.5f, e_m, vec3_sub(gyro, *b)));
+    quat_integrate(q, w, dt);
+    *b = vec3_axpy(-0.05f * dt, vec3_add(e_a, e_m), *b);
+}
+
+/**
+ * @function check_kernels()
+ * @return number of kernels outside the tolerance
+ */
+static int check_kernels(void) {
+    float a[MSZ];
+    float b[MSZ];
+    float qa[QSZ];
+    float qb[QSZ];
+    float ma[MSZ][MSZ];
+    float mb[MSZ][MSZ];
+    float err[12] = {0};
+    int fails = 0;
+    int n;
+    int k;
+    int m;
+    mat3_t m1;
+    mat3_t m2;
+    mat3_t m3;
+    vec3_t v;
+    quat_t q;
+
+    for (n = 0; n < NUM_SAMPLES; n++) {
+        k = 0;
+        m = (n + 1) & (NUM_SAMPLES - 1);
+        lin_alg_cross(in_v1[n], in_v2[n], a);
+        vec3_store(vec3_cross(vec3_load(in_v1[n]), vec3_load(in_v2[n])), b);
+        err[k] = fmaxf(err[k], max_diff(a, b, MSZ)), k++;
+
+        lin_alg_cross(in_v1[n], in_v2[n], a);
+        lin_alg_v_scale(0.3f, a);
+        vec3_store(vec3_cross_scale(vec3_load(in_v1[n]), vec3_load(in_v2[n]), 0.3f), b);
+        err[k] = fmaxf(err[k], max_diff(a, b, MSZ)), k++;
+
+        lin_alg_s_v_mult(0.3f, in_v1[n], a);
+        lin_alg_v_v_add(a, in_v2[n], a);
+        vec3_store(vec3_axpy(0.3f, vec3_load(in_v1[n]), vec3_load(in_v2[n])), b);
+        err[k] = fmaxf(err[k], max_diff(a, b, MSZ)), k++;
+
+        a[0] = lin_alg_dot(in_v1[n], in_v2[n]);
+        b[0] = vec3_dot(vec3_load(in_v1[n]), vec3_load(in_v2[n]));
+        err[k] = fmaxf(err[k], max_diff(a, b, 1)), k++;
+
+        lin_alg_s_v_mult(1.0f / lin_alg_v_norm(in_v1[n]), in_v1[n], a);
+        v = vec3_load(in_v1[n]);
+        vec3_normalize(&v);
+        vec3_store(v, b);
+        err[k] = fmaxf(err[k], max_diff(a, b, MSZ)), k++;
+
+        lin_alg_q_mult(in_q[n], in_q[m], qa);
+        quat_store(quat_mult(quat_load(in_q[n]), quat_load(in_q[m])), qb);
+        err[k] = fmaxf(err[k], max_diff(qa, qb, QSZ)), k++;
+
+        qa[0] = 0;
+        qa[1] = in_v2[n][0];
+        qa[2] = in_v2[n][1];
+        qa[3] = in_v2[n][2];
+        lin_alg_q_mult(in_q[n], qa, qb);
+        quat_store(quat_mult_v(quat_load(in_q[n]), vec3_load(in_v2[n])), qa);
+        err[k] = fmaxf(err[k], max_diff(qa, qb, QSZ)), k++;
+
+        lin_alg_q_mult(in_q[n], in_q[m], qa);
+        lin_alg_scale_q(1.0f / lin_alg_q_norm(qa), qa);
+        q = quat_mult(quat_load(in_q[n]), quat_load(in_q[m]));
+        quat_normalize(&q);
+        quat_store(q, qb);
+        err[k] = fmaxf(err[k], max_diff(qa, qb, QSZ)), k++;
+
+        lin_alg_m_v_mult(in_m[n], in_v1[n], a);
+        m1 = mat3_load(in_m[n]);
+        vec3_store(mat3_v_mult(&m1, vec3_load(in_v1[n])), b);
+        err[k] = fmaxf(err[k], max_diff(a, b, MSZ) / 10.0f), k++;
+
+        lin_alg_m_transpose(in_m[n], ma);
+        lin_alg_m_v_mult(ma, in_v1[n], a);
+        vec3_store(mat3_t_v_mult(&m1, vec3_load(in_v1[n])), b);
+        err[k] = fmaxf(err[k], max_diff(a, b, MSZ) / 10.0f), k++;
+
+        lin_alg_m_m_mult(in_m[n], in_m[m], ma);
+        m2 = mat3_load(in_m[m]);
+        mat3_mult(&m1, &m2, &m3);
+        mat3_store(&m3, mb);
+        err[k] = fmaxf(err[k], max_diff(&ma[0][0], &mb[0][0], MSZ * MSZ)), k++;
+
+        lin_alg_m_transpose(in_m[n], ma);
+        mat3_transpose(&m1, &m3);
+        mat3_store(&m3, mb);
+        err[k] = fmaxf(err[k], max_diff(&ma[0][0], &mb[0][0], MSZ * MSZ)), k++;
+    }
+    k = 0;
+    fails += report("vec3_cross", err[k++]) == FALSE;
+    fails += report("vec3_cross_scale", err[k++]) == FALSE;
+    fails += report("vec3_axpy", err[k++]) == FALSE;
+    fails += report("vec3_dot", err[k++]) == FALSE;
+    fails += report("vec3_normalize", err[k++]) == FALSE;
+    fails += report("quat_mult", err[k++]) == FALSE;
+    fails += report("quat_mult_v", err[k++]) == FALSE;
+    fails += report("quat_normalize", err[k++]) == FALSE;
+    fails += report("mat3_v_mult", err[k++]) == FALSE;
+    fails += report("mat3_t_v_mult", err[k++]) == FALSE;
+    fails += report("mat3_mult", err[k++]) == FALSE;
+    fails += report("mat3_transpose", err[k++]) == FALSE;
+    return fails;
+}
+
+/**
+ * @function check_ahrs_step()
+ * @return TRUE if the two AHRS steps track each other over the inputs
+ */
+static int8_t check_ahrs_step(void) {
+    float q_a[QSZ] = {1, 0, 0, 0};
+    float b_a[MSZ] = {0, 0, 0};
+    float acc[MSZ];
+    float mag[MSZ];
+    float q_out[QSZ];
+    float b_out[MSZ];
+    quat_t q = {1, 0, 0, 0};
+    vec3_t b = {0, 0, 0};
+    long n;
+    int s;
+    float err;
+
+    for (n = 0; n < NUM_SAMPLES; n++) {
+        s = n & (NUM_SAMPLES - 1);
+        acc[0] = in_v1[s][0];
+        acc[1] = in_v1[s][1];
+        acc[2] = in_v1[s][2];
+        mag[0] = in_v2[s][0];
+        mag[1] = in_v2[s][1];
+        mag[2] = in_v2[s][2];
+        ahrs_step_inline(vec3_load(acc), vec3_load(mag), vec3_load(in_v2[s]), &q, &b, 0.02f);
+        ahrs_step_array(acc, mag, in_v2[s], q_a, b_a, 0.02f);
+    }
+    quat_store(q, q_out);
+    vec3_store(b, b_out);
+    err = fmaxf(max_diff(q_a, q_out, QSZ), max_diff(b_a, b_out, MSZ));
+    return report("AHRS step", err);
+}
+
+/**
+ * @function print_time()
+ * @brief one line of the timing table
+ */
+static void print_time(const char *name, double t_array, long calls, double t_inline, long iterations) {
+    printf("%-18s %12.2f %12.2f %12.2f %10.2f\n", name,
+            (double) calls / iterations, t_array / iterations,
+            t_inline / iterations, t_array / t_inline);
+}
+
+int main(int argc, char **argv) {
+    long iterations = DEFAULT_ITERATIONS;
+    long n;
+    long calls;
+    int s;
+    int m;
+    int fails;
+    double start;
+    double t_array;
+    double t_inline;
+    float a[MSZ];
+    float qa[QSZ];
+    float acc[MSZ];
+    float mag[MSZ];
+    float q_arr[QSZ] = {1, 0, 0, 0};
+    float b_arr[MSZ] = {0, 0, 0};
+    float n_inv;
+    quat_t q = {1, 0, 0, 0};
+    quat_t qi;
+    vec3_t b = {0, 0, 0};
+    vec3_t v;
+    mat3_t mt;
+
+    if (argc > 1) {
+        iterations = atol(argv[1]);
+    }
+    printf("Lin_alg inline kernel check and benchmark %s, %s\n\n", __DATE__, __TIME__);
+    fill_inputs();
+    fails = check_kernels();
+    fails += check_ahrs_step() == FALSE;
+    printf("\n%-18s %12s %12s %12s %10s\n", "operation", "calls/op",
+            "array ns/op", "inline ns/op", "speedup");
+
+    /* cross then scale, the feedback terms in AHRS_update() */
+    lib_calls = 0;
+    start = cpu_nsec();
+    for (n = 0; n < iterations; n++) {
+        s = n & (NUM_SAMPLES - 1);
+        CALL(lin_alg_cross(in_v1[s], in_v2[s], a));
+        CALL(lin_alg_v_scale(2.5f, a));
+        sink = a[0];
+    }
+    t_array = cpu_nsec() - start;
+    calls = lib_calls;
+    start = cpu_nsec();
+    for (n = 0; n < iterations; n++) {
+        s = n & (NUM_SAMPLES - 1);
+        v = vec3_cross_scale(vec3_load(in_v1[s]), vec3_load(in_v2[s]), 2.5f);
+        sink = v.x;
+    }
+    t_inline = cpu_nsec() - start;
+    print_time("cross, scale", t_array, calls, t_inline, iterations);
+
+    /* normalize */
+    lib_calls = 0;
+    start = cpu_nsec();
+    for (n = 0; n < iterations; n++) {
+        s = n & (NUM_SAMPLES - 1);
+        a[0] = in_v1[s][0];
+        a[1] = in_v1[s][1];
+        a[2] = in_v1[s][2];
+        n_inv = 1.0f / CALL(lin_alg_v_norm(a));
+        CALL(lin_alg_v_scale(n_inv, a));
+        sink = a[0];
+    }
+    t_array = cpu_nsec() - start;
+    calls = lib_calls;
+    start = cpu_nsec();
+    for (n = 0; n < iterations; n++) {
+        s = n & (NUM_SAMPLES - 1);
+        v = vec3_load(in_v1[s]);
+        vec3_normalize(&v);
+        sink = v.x;
+    }
+    t_inline = cpu_nsec() - start;
+    print_time("normalize", t_array, calls, t_inline, iterations);
+
+    /* quaternion product */
+    lib_calls = 0;
+    start = cpu_nsec();
+    for (n = 0; n < iterations; n++) {
+        s = n & (NUM_SAMPLES - 1);
+        m = (s + 1) & (NUM_SAMPLES - 1);
+        CALL(lin_alg_q_mult(in_q[s], in_q[m], qa));
+        sink = qa[0];
+    }
+    t_array = cpu_nsec() - start;
+    calls = lib_calls;
+    start = cpu_nsec();
+    for (n = 0; n < iterations; n++) {
+        s = n & (NUM_SAMPLES - 1);
+        m = (s + 1) & (NUM_SAMPLES - 1);
+        qi = quat_mult(quat_load(in_q[s]), quat_load(in_q[m]));
+        sink = qi.w;
+    }
+    t_inline = cpu_nsec() - start;
+    print_time("q mult", t_array, calls, t_inline, iterations);
+
+    /* matrix vector product */
+    lib_calls = 0;
+    start = cpu_nsec();
+    for (n = 0; n < iterations; n++) {
+        s = n & (NUM_SAMPLES - 1);
+        CALL(lin_alg_m_v_mult(in_m[s], in_v1[s], a));
+        sink = a[0];
+    }
+    t_array = cpu_nsec() - start;
+    calls = lib_calls;
+    start = cpu_nsec();
+    for (n = 0; n < iterations; n++) {
+        s = n & (NUM_SAMPLES - 1);
+        mt = mat3_load(in_m[s]);
+        v = mat3_v_mult(&mt, vec3_load(in_v1[s]));
+        sink = v.x;
+    }
+    t_inline = cpu_nsec() - start;
+    print_time("m v mult", t_array, calls, t_inline, iterations);
+
+    /* whole AHRS update */
+    lib_calls = 0;
+    start = cpu_nsec();
+    for (n = 0; n < iterations; n++) {
+        s = n & (NUM_SAMPLES - 1);
+        acc[0] = in_v1[s][0];
+        acc[1] = in_v1[s][1];
+        acc[2] = in_v1[s][2];
+        mag[0] = in_v2[s][0];
+        mag[1] = in_v2[s][1];
+        mag[2] = in_v2[s][2];
+        ahrs_step_array(acc, mag, in_v2[s], q_arr, b_arr, 0.02f);
+    }
+    t_array = cpu_nsec() - start;
+    sink = q_arr[0];
+    calls = lib_calls;
+    start = cpu_nsec();
+    for (n = 0; n < iterations; n++) {
+        s = n & (NUM_SAMPLES - 1);
+        ahrs_step_inline(vec3_load(in_v1[s]), vec3_load(in_v2[s]),
+                vec3_load(in_v2[s]), &q, &b, 0.02f);
+    }
+    t_inline = cpu_nsec() - start;
+    sink = q.w;
+    print_time("AHRS update", t_array, calls, t_inline, iterations);
+
+    printf("\ninline kernels make no library calls, %d check(s) failed\n", fails);
+    return fails == 0 ? 0 : 1;
+}
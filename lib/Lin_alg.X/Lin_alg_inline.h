@@ -0,0 +1,414 @@
+/*
+ * File:   Lin_alg_inline.h
+ * Brief: Header only vec3/quat/mat3 kernels for the attitude and guidance hot
+ * paths.  Same math as Lin_alg_float but on small structs passed by value and
+ * declared static inline so the compiler can flatten a whole update into
+ * straight line code: no call overhead, no temporaries forced to memory and no
+ * v_copy() between steps.  Fused kernels cover the patterns that show up in
+ * the filters (cross then scale, a*x + y, normalize in place, q x pure
+ * quaternion).  GCC (and XC32 at -O1) inlines functions declared inline, so
+ * this also helps the free compiler license.
+ * Quaternions are scalar first [w x y z] like the QSZ arrays, matrices are row
+ * major like the MSZ x MSZ arrays, so load/store are plain copies.
+ * Created on 10/16/2026
+ * Modified on
+ */
+
+#ifndef LIN_ALG_INLINE_H // Header guard
+#define	LIN_ALG_INLINE_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+#include <math.h>
+#include "Lin_alg_float.h"
+#include "Fast_math.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+typedef struct vec3 {
+    float x;
+    float y;
+    float z;
+} vec3_t;
+
+typedef struct quat {
+    float w; // scalar part
+    float x;
+    float y;
+    float z;
+} quat_t;
+
+typedef struct mat3 {
+    float m[MSZ][MSZ]; // row major
+} mat3_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/* array interop, to sit next to the existing float[MSZ] interfaces */
+
+/**
+ * @Function vec3_load(const float v[MSZ])
+ * @return v as a vec3_t */
+static inline vec3_t vec3_load(const float v[MSZ]) {
+    vec3_t r = {v[0], v[1], v[2]};
+    return r;
+}
+
+/**
+ * @Function vec3_store(vec3_t v, float v_out[MSZ])
+ * @return none */
+static inline void vec3_store(vec3_t v, float v_out[MSZ]) {
+    v_out[0] = v.x;
+    v_out[1] = v.y;
+    v_out[2] = v.z;
+}
+
+/**
+ * @Function quat_load(const float q[QSZ])
+ * @return q as a quat_t */
+static inline quat_t quat_load(const float q[QSZ]) {
+    quat_t r = {q[0], q[1], q[2], q[3]};
+    return r;
+}
+
+/**
+ * @Function quat_store(quat_t q, float q_out[QSZ])
+ * @return none */
+static inline void quat_store(quat_t q, float q_out[QSZ]) {
+    q_out[0] = q.w;
+    q_out[1] = q.x;
+    q_out[2] = q.y;
+    q_out[3] = q.z;
+}
+
+/**
+ * @Function mat3_load(const float m[MSZ][MSZ])
+ * @return m as a mat3_t */
+static inline mat3_t mat3_load(const float m[MSZ][MSZ]) {
+    mat3_t r = {
+        {
+            {m[0][0], m[0][1], m[0][2]},
+            {m[1][0], m[1][1], m[1][2]},
+            {m[2][0], m[2][1], m[2][2]}
+        }
+    };
+    return r;
+}
+
+/**
+ * @Function mat3_store(const mat3_t *m, float m_out[MSZ][MSZ])
+ * @return none */
+static inline void mat3_store(const mat3_t *m, float m_out[MSZ][MSZ]) {
+    int row;
+    for (row = 0; row < MSZ; row++) {
+        m_out[row][0] = m->m[row][0];
+        m_out[row][1] = m->m[row][1];
+        m_out[row][2] = m->m[row][2];
+    }
+}
+
+/* vectors */
+
+/**
+ * @Function vec3_set(float x, float y, float z)
+ * @return the vector [x y z] */
+static inline vec3_t vec3_set(float x, float y, float z) {
+    vec3_t r = {x, y, z};
+    return r;
+}
+
+/**
+ * @Function vec3_add(vec3_t u, vec3_t v)
+ * @return u + v */
+static inline vec3_t vec3_add(vec3_t u, vec3_t v) {
+    vec3_t r = {u.x + v.x, u.y + v.y, u.z + v.z};
+    return r;
+}
+
+/**
+ * @Function vec3_sub(vec3_t u, vec3_t v)
+ * @return u - v */
+static inline vec3_t vec3_sub(vec3_t u, vec3_t v) {
+    vec3_t r = {u.x - v.x, u.y - v.y, u.z - v.z};
+    return r;
+}
+
+/**
+ * @Function vec3_scale(float s, vec3_t v)
+ * @return s * v */
+static inline vec3_t vec3_scale(float s, vec3_t v) {
+    vec3_t r = {s * v.x, s * v.y, s * v.z};
+    return r;
+}
+
+/**
+ * @Function vec3_axpy(float a, vec3_t x, vec3_t y)
+ * @return a * x + y
+ * @note fused replacement for lin_alg_s_v_mult() followed by lin_alg_v_v_add() */
+static inline vec3_t vec3_axpy(float a, vec3_t x, vec3_t y) {
+    vec3_t r = {a * x.x + y.x, a * x.y + y.y, a * x.z + y.z};
+    return r;
+}
+
+/**
+ * @Function vec3_dot(vec3_t u, vec3_t v)
+ * @return u . v */
+static inline float vec3_dot(vec3_t u, vec3_t v) {
+    return u.x * v.x + u.y * v.y + u.z * v.z;
+}
+
+/**
+ * @Function vec3_cross(vec3_t u, vec3_t v)
+ * @return u x v */
+static inline vec3_t vec3_cross(vec3_t u, vec3_t v) {
+    vec3_t r = {
+        u.y * v.z - u.z * v.y,
+        u.z * v.x - u.x * v.z,
+        u.x * v.y - u.y * v.x
+    };
+    return r;
+}
+
+/**
+ * @Function vec3_cross_scale(vec3_t u, vec3_t v, float s)
+ * @return s * (u x v)
+ * @note fused replacement for lin_alg_cross() followed by lin_alg_v_scale() */
+static inline vec3_t vec3_cross_scale(vec3_t u, vec3_t v, float s) {
+    vec3_t r = {
+        s * (u.y * v.z - u.z * v.y),
+        s * (u.z * v.x - u.x * v.z),
+        s * (u.x * v.y - u.y * v.x)
+    };
+    return r;
+}
+
+/**
+ * @Function vec3_norm(vec3_t v)
+ * @return |v| */
+static inline float vec3_norm(vec3_t v) {
+    return sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+}
+
+/**
+ * @Function vec3_normalize(vec3_t *v)
+ * @param v, vector to be normalized in place
+ * @return |v| before normalizing
+ * @note fast_inv_sqrtf() of the squared norm then three multiplies, no sqrt or
+ * divide, v is left alone if it is zero */
+static inline float vec3_normalize(vec3_t *v) {
+    float n2 = v->x * v->x + v->y * v->y + v->z * v->z;
+    float n_inv = 0.0f;
+
+    if (n2 > 0.0f) {
+        n_inv = fast_inv_sqrtf(n2);
+        v->x *= n_inv;
+        v->y *= n_inv;
+        v->z *= n_inv;
+    }
+    return n2 * n_inv;
+}
+
+/* quaternions */
+
+/**
+ * @Function quat_mult(quat_t q, quat_t p)
+ * @return q x p, same product as lin_alg_q_mult(q, p, r) */
+static inline quat_t quat_mult(quat_t q, quat_t p) {
+    quat_t r = {
+        q.w * p.w - q.x * p.x - q.y * p.y - q.z * p.z,
+        q.w * p.x + q.x * p.w + q.y * p.z - q.z * p.y,
+        q.w * p.y - q.x * p.z + q.y * p.w + q.z * p.x,
+        q.w * p.z + q.x * p.y - q.y * p.x + q.z * p.w
+    };
+    return r;
+}
+
+/**
+ * @Function quat_mult_v(quat_t q, vec3_t v)
+ * @return q x [0 v]
+ * @note the pure quaternion product without building [0 v], 12 multiplies
+ * instead of 16 */
+static inline quat_t quat_mult_v(quat_t q, vec3_t v) {
+    quat_t r = {
+        -q.x * v.x - q.y * v.y - q.z * v.z,
+        q.w * v.x + q.y * v.z - q.z * v.y,
+        q.w * v.y - q.x * v.z + q.z * v.x,
+        q.w * v.z + q.x * v.y - q.y * v.x
+    };
+    return r;
+}
+
+/**
+ * @Function quat_conj(quat_t q)
+ * @return the conjugate of q */
+static inline quat_t quat_conj(quat_t q) {
+    quat_t r = {q.w, -q.x, -q.y, -q.z};
+    return r;
+}
+
+/**
+ * @Function quat_norm(quat_t q)
+ * @return |q| */
+static inline float quat_norm(quat_t q) {
+    return sqrtf(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+}
+
+/**
+ * @Function quat_normalize(quat_t *q)
+ * @param q, quaternion to be normalized in place
+ * @return |q| before normalizing
+ * @note fast_inv_sqrtf() of the squared norm then four multiplies, no sqrt or
+ * divide, q is left alone if it is zero */
+static inline float quat_normalize(quat_t *q) {
+    float n2 = q->w * q->w + q->x * q->x + q->y * q->y + q->z * q->z;
+    float n_inv = 0.0f;
+
+    if (n2 > 0.0f) {
+        n_inv = fast_inv_sqrtf(n2);
+        q->w *= n_inv;
+        q->x *= n_inv;
+        q->y *= n_inv;
+        q->z *= n_inv;
+    }
+    return n2 * n_inv;
+}
+
+/**
+ * @Function quat_integrate(quat_t *q, vec3_t w, float dt)
+ * @param q, attitude quaternion, updated in place
+ * @param w, body rates in rad/sec
+ * @param dt, integration time in sec
+ * @return none
+ * @brief first order step q = q + 1/2 q x [0 w] dt followed by
+ * quat_normalize(), the usual q_dot / integrate / normalize sequence in one
+ * kernel */
+static inline void quat_integrate(quat_t *q, vec3_t w, float dt) {
+    quat_t q_dot = quat_mult_v(*q, w);
+    float h = 0.5f * dt;
+
+    q->w += h * q_dot.w;
+    q->x += h * q_dot.x;
+    q->y += h * q_dot.y;
+    q->z += h * q_dot.z;
+    quat_normalize(q);
+}
+
+/**
+ * @Function quat_rot_v(quat_t q, vec3_t v_i)
+ * @param q, attitude quaternion, unit length
+ * @param v_i, vector in the inertial frame
+ * @return v_i in the body frame, q* x [0 v_i] x q
+ * @note with u the vector part of q and t = 2 (v_i x u):
+ * v_b = v_i + w t + t x u, 15 multiplies against 32 for two Hamilton
+ * products */
+static inline vec3_t quat_rot_v(quat_t q, vec3_t v_i) {
+    vec3_t u = {q.x, q.y, q.z};
+    vec3_t t = vec3_cross_scale(v_i, u, 2.0f);
+
+    return vec3_add(vec3_axpy(q.w, t, v_i), vec3_cross(t, u));
+}
+
+/**
+ * @Function quat_rot_v_inv(quat_t q, vec3_t v_b)
+ * @param q, attitude quaternion, unit length
+ * @param v_b, vector in the body frame
+ * @return v_b in the inertial frame, q x [0 v_b] x q*
+ * @note inverse of quat_rot_v(), t = 2 (u x v_b), v_i = v_b + w t + u x t */
+static inline vec3_t quat_rot_v_inv(quat_t q, vec3_t v_b) {
+    vec3_t u = {q.x, q.y, q.z};
+    vec3_t t = vec3_cross_scale(u, v_b, 2.0f);
+
+    return vec3_add(vec3_axpy(q.w, t, v_b), vec3_cross(u, t));
+}
+
+/* matrices */
+
+/**
+ * @Function quat_to_mat3(quat_t q, mat3_t *dcm)
+ * @param q, attitude quaternion, unit length
+ * @param dcm, inertial to body DCM, v_b = dcm * v_i, same matrix as
+ * lin_alg_q2dcm()
+ * @return none */
+static inline void quat_to_mat3(quat_t q, mat3_t *dcm) {
+    float ww = q.w * q.w;
+    float xx = q.x * q.x;
+    float yy = q.y * q.y;
+    float zz = q.z * q.z;
+    float xy = q.x * q.y;
+    float xz = q.x * q.z;
+    float yz = q.y * q.z;
+    float wx = q.w * q.x;
+    float wy = q.w * q.y;
+    float wz = q.w * q.z;
+
+    dcm->m[0][0] = ww + xx - yy - zz;
+    dcm->m[0][1] = 2.0f * (xy + wz);
+    dcm->m[0][2] = 2.0f * (xz - wy);
+    dcm->m[1][0] = 2.0f * (xy - wz);
+    dcm->m[1][1] = ww - xx + yy - zz;
+    dcm->m[1][2] = 2.0f * (yz + wx);
+    dcm->m[2][0] = 2.0f * (xz + wy);
+    dcm->m[2][1] = 2.0f * (yz - wx);
+    dcm->m[2][2] = ww - xx - yy + zz;
+}
+
+/**
+ * @Function mat3_v_mult(const mat3_t *m, vec3_t v)
+ * @return m * v */
+static inline vec3_t mat3_v_mult(const mat3_t *m, vec3_t v) {
+    vec3_t r = {
+        m->m[0][0] * v.x + m->m[0][1] * v.y + m->m[0][2] * v.z,
+        m->m[1][0] * v.x + m->m[1][1] * v.y + m->m[1][2] * v.z,
+        m->m[2][0] * v.x + m->m[2][1] * v.y + m->m[2][2] * v.z
+    };
+    return r;
+}
+
+/**
+ * @Function mat3_t_v_mult(const mat3_t *m, vec3_t v)
+ * @return transpose(m) * v
+ * @note without forming the transpose, e.g. inertial to body with a DCM */
+static inline vec3_t mat3_t_v_mult(const mat3_t *m, vec3_t v) {
+    vec3_t r = {
+        m->m[0][0] * v.x + m->m[1][0] * v.y + m->m[2][0] * v.z,
+        m->m[0][1] * v.x + m->m[1][1] * v.y + m->m[2][1] * v.z,
+        m->m[0][2] * v.x + m->m[1][2] * v.y + m->m[2][2] * v.z
+    };
+    return r;
+}
+
+/**
+ * @Function mat3_mult(const mat3_t *m1, const mat3_t *m2, mat3_t *m_out)
+ * @return none, m_out = m1 * m2
+ * @note m_out must not alias m1 or m2 */
+static inline void mat3_mult(const mat3_t *m1, const mat3_t *m2, mat3_t *m_out) {
+    int row;
+    for (row = 0; row < MSZ; row++) {
+        m_out->m[row][0] = m1->m[row][0] * m2->m[0][0] + m1->m[row][1] * m2->m[1][0] + m1->m[row][2] * m2->m[2][0];
+        m_out->m[row][1] = m1->m[row][0] * m2->m[0][1] + m1->m[row][1] * m2->m[1][1] + m1->m[row][2] * m2->m[2][1];
+        m_out->m[row][2] = m1->m[row][0] * m2->m[0][2] + m1->m[row][1] * m2->m[1][2] + m1->m[row][2] * m2->m[2][2];
+    }
+}
+
+/**
+ * @Function mat3_transpose(const mat3_t *m, mat3_t *m_out)
+ * @return none, m_out = transpose(m)
+ * @note m_out must not alias m */
+static inline void mat3_transpose(const mat3_t *m, mat3_t *m_out) {
+    int row;
+    for (row = 0; row < MSZ; row++) {
+        m_out->m[row][0] = m->m[0][row];
+        m_out->m[row][1] = m->m[1][row];
+        m_out->m[row][2] = m->m[2][row];
+    }
+}
+
+#endif	/* LIN_ALG_INLINE_H */ // End of header guard
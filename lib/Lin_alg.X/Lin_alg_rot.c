@@ -0,0 +1,471 @@
+/*
+ * File:   Lin_alg_rot.c
+ * Brief: Quaternion vector rotation and Euler angle extraction shared by the
+ * AHRS, guidance and heading control code
+ * Created on 10/16/2026
+ * Modified on
+ *
+ * Host test (accuracy against a double precision two product reference and
+ * timing against the two product q_rot_v_q()):
+ * gcc -O2 -DLIN_ALG_ROT_TESTING -I../Board.X Lin_alg_rot.c Lin_alg_float.c
+ *  Fast_math.c -lm -o lin_alg_rot
+ * On the target define LIN_ALG_ROT_TESTING, the times are then in cycles.
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+#include <math.h>
+#include "Lin_alg_rot.h"
+#include "Lin_alg_inline.h"
+#include "Fast_math.h"
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#define HALF_PI 1.57079632679489661923
+
+/*******************************************************************************
+ * PRIVATE TYPEDEFS                                                            *
+ ******************************************************************************/
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                *
+ ******************************************************************************/
+/**
+ * @Function euler_from_dcm(float c00, float c01, float c02, float c12,
+ * float c22, float euler[MSZ])
+ * @param cij, the inertial to body DCM terms used by the extraction
+ * @param euler, [psi, theta, phi] in radians */
+static void euler_from_dcm(float c00, float c01, float c02, float c12,
+        float c22, float euler[MSZ]);
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function lin_alg_q_rot_v(float v_i[MSZ], float q[QSZ], float v_b[MSZ])
+ * @param v_i, a vector in the inertial frame
+ * @param q, unit attitude quaternion
+ * @param v_b, v_i rotated into the body frame
+ * @return none
+ * @brief drop in replacement for q_rot_v_q(), 15 multiplies instead of 32
+ * @author Aaron Hunter, 10/16/2026 */
+void lin_alg_q_rot_v(float v_i[MSZ], float q[QSZ], float v_b[MSZ]) {
+    vec3_store(quat_rot_v(quat_load(q), vec3_load(v_i)), v_b);
+}
+
+/**
+ * @Function lin_alg_q_rot_v_inv(float v_b[MSZ], float q[QSZ], float v_i[MSZ])
+ * @param v_b, a vector in the body frame
+ * @param q, unit attitude quaternion
+ * @param v_i, v_b rotated into the inertial frame
+ * @return none
+ * @author Aaron Hunter, 10/16/2026 */
+void lin_alg_q_rot_v_inv(float v_b[MSZ], float q[QSZ], float v_i[MSZ]) {
+    vec3_store(quat_rot_v_inv(quat_load(q), vec3_load(v_b)), v_i);
+}
+
+/**
+ * @Function lin_alg_quat2euler(float q[QSZ], float euler[MSZ])
+ * @param q, unit attitude quaternion
+ * @param euler, [psi, theta, phi] in radians
+ * @return none
+ * @brief the Euler extraction used by every app, pitch is clamped to +/- pi/2
+ * when rounding puts the asin() argument just outside [-1, 1]
+ * @author Aaron Hunter, 10/16/2026 */
+void lin_alg_quat2euler(float q[QSZ], float euler[MSZ]) {
+    float q00 = q[0] * q[0];
+    float q11 = q[1] * q[1];
+    float q22 = q[2] * q[2];
+    float q33 = q[3] * q[3];
+
+    euler_from_dcm(q00 + q11 - q22 - q33,
+            2.0f * (q[1] * q[2] + q[0] * q[3]),
+            2.0f * (q[1] * q[3] - q[0] * q[2]),
+            2.0f * (q[2] * q[3] + q[0] * q[1]),
+            q00 - q11 - q22 + q33, euler);
+}
+
+/**
+ * @Function lin_alg_rot_set_q(rot_cache_t *rot, float q[QSZ])
+ * @param rot, cache to update
+ * @param q, unit attitude quaternion for this tick
+ * @return none
+ * @brief computes the inertial to body DCM once, call after AHRS_update()
+ * @author Aaron Hunter, 10/16/2026 */
+void lin_alg_rot_set_q(rot_cache_t *rot, float q[QSZ]) {
+    mat3_t dcm;
+
+    quat_to_mat3(quat_load(q), &dcm);
+    mat3_store(&dcm, rot->dcm);
+    rot->q[0] = q[0];
+    rot->q[1] = q[1];
+    rot->q[2] = q[2];
+    rot->q[3] = q[3];
+}
+
+/**
+ * @Function lin_alg_rot_i2b(const rot_cache_t *rot, float v_i[MSZ],
+ * float v_b[MSZ])
+ * @param rot, cache set by lin_alg_rot_set_q()
+ * @param v_i, a vector in the inertial frame
+ * @param v_b, v_i rotated into the body frame
+ * @return none
+ * @brief 9 multiplies per vector once the DCM is cached
+ * @author Aaron Hunter, 10/16/2026 */
+void lin_alg_rot_i2b(const rot_cache_t *rot, float v_i[MSZ], float v_b[MSZ]) {
+    float x = v_i[0];
+    float y = v_i[1];
+    float z = v_i[2];
+
+    v_b[0] = rot->dcm[0][0] * x + rot->dcm[0][1] * y + rot->dcm[0][2] * z;
+    v_b[1] = rot->dcm[1][0] * x + rot->dcm[1][1] * y + rot->dcm[1][2] * z;
+    v_b[2] = rot->dcm[2][0] * x + rot->dcm[2][1] * y + rot->dcm[2][2] * z;
+}
+
+/**
+ * @Function lin_alg_rot_b2i(const rot_cache_t *rot, float v_b[MSZ],
+ * float v_i[MSZ])
+ * @param rot, cache set by lin_alg_rot_set_q()
+ * @param v_b, a vector in the body frame
+ * @param v_i, v_b rotated into the inertial frame
+ * @return none
+ * @author Aaron Hunter, 10/16/2026 */
+void lin_alg_rot_b2i(const rot_cache_t *rot, float v_b[MSZ], float v_i[MSZ]) {
+    float x = v_b[0];
+    float y = v_b[1];
+    float z = v_b[2];
+
+    v_i[0] = rot->dcm[0][0] * x + rot->dcm[1][0] * y + rot->dcm[2][0] * z;
+    v_i[1] = rot->dcm[0][1] * x + rot->dcm[1][1] * y + rot->dcm[2][1] * z;
+    v_i[2] = rot->dcm[0][2] * x + rot->dcm[1][2] * y + rot->dcm[2][2] * z;
+}
+
+/**
+ * @Function lin_alg_rot_euler(const rot_cache_t *rot, float euler[MSZ])
+ * @param rot, cache set by lin_alg_rot_set_q()
+ * @param euler, [psi, theta, phi] in radians
+ * @return none
+ * @brief same result as lin_alg_quat2euler() from the cached DCM terms
+ * @author Aaron Hunter, 10/16/2026 */
+void lin_alg_rot_euler(const rot_cache_t *rot, float euler[MSZ]) {
+    euler_from_dcm(rot->dcm[0][0], rot->dcm[0][1], rot->dcm[0][2],
+            rot->dcm[1][2], rot->dcm[2][2], euler);
+}
+
+/**
+ * @Function lin_alg_q_rot_v_dbl(double v_i[MSZ], double q[QSZ],
+ * double v_b[MSZ])
+ * @brief double precision lin_alg_q_rot_v() for the q_ahrs_dbl reference
+ * @author Aaron Hunter, 10/16/2026 */
+void lin_alg_q_rot_v_dbl(double v_i[MSZ], double q[QSZ], double v_b[MSZ]) {
+    double t[MSZ];
+
+    // t = 2 (v_i x u), u the vector part of q
+    t[0] = 2.0 * (v_i[1] * q[3] - v_i[2] * q[2]);
+    t[1] = 2.0 * (v_i[2] * q[1] - v_i[0] * q[3]);
+    t[2] = 2.0 * (v_i[0] * q[2] - v_i[1] * q[1]);
+    // v_b = v_i + w t + t x u
+    v_b[0] = v_i[0] + q[0] * t[0] + t[1] * q[3] - t[2] * q[2];
+    v_b[1] = v_i[1] + q[0] * t[1] + t[2] * q[1] - t[0] * q[3];
+    v_b[2] = v_i[2] + q[0] * t[2] + t[0] * q[2] - t[1] * q[1];
+}
+
+/**
+ * @Function lin_alg_quat2euler_dbl(double q[QSZ], double euler[MSZ])
+ * @brief double precision lin_alg_quat2euler() for the q_ahrs_dbl reference
+ * @author Aaron Hunter, 10/16/2026 */
+void lin_alg_quat2euler_dbl(double q[QSZ], double euler[MSZ]) {
+    double q00 = q[0] * q[0];
+    double q11 = q[1] * q[1];
+    double q22 = q[2] * q[2];
+    double q33 = q[3] * q[3];
+    double s = 2.0 * (q[0] * q[2] - q[1] * q[3]);
+
+    euler[0] = atan2(2.0 * (q[1] * q[2] + q[0] * q[3]), q00 + q11 - q22 - q33);
+    if (s >= 1.0) {
+        euler[1] = HALF_PI;
+    } else if (s <= -1.0) {
+        euler[1] = -HALF_PI;
+    } else {
+        euler[1] = asin(s);
+    }
+    euler[2] = atan2(2.0 * (q[2] * q[3] + q[0] * q[1]), q00 - q11 - q22 + q33);
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/**
+ * @Function euler_from_dcm(float c00, float c01, float c02, float c12,
+ * float c22, float euler[MSZ])
+ * @param cij, the inertial to body DCM terms used by the extraction
+ * @param euler, [psi, theta, phi] in radians */
+static void euler_from_dcm(float c00, float c01, float c02, float c12,
+        float c22, float euler[MSZ]) {
+    // psi
+    euler[0] = fast_atan2f(c01, c00);
+    // theta
+    if (c02 <= -1.0f) {
+        euler[1] = HALF_PI;
+    } else if (c02 >= 1.0f) {
+        euler[1] = -HALF_PI;
+    } else {
+        euler[1] = fast_asinf(-c02);
+    }
+    // phi
+    euler[2] = fast_atan2f(c12, c22);
+}
+
+#ifdef LIN_ALG_ROT_TESTING
+#include <stdio.h>
+#include <stdint.h>
+#include "Board.h"
+
+/**
+ * Checks the rotations and Euler extraction against a double precision
+ * reference built from two Hamilton products, then times each against the
+ * two product q_rot_v_q() the apps used to carry.  On the target the times are
+ * core timer counts converted to cycles, on a host they are nsec. */
+
+#define NUM_TESTS 1000
+#define NUM_VECTORS 2 // vectors rotated per tick, gravity and magnetic field
+
+#ifdef __XC32
+#include <xc.h>
+#include "SerialM32.h"
+#define TIME_UNITS "cycles"
+#define time_now() ((double) _CP0_GET_COUNT() * 2.0)
+#else
+#include <time.h>
+#define TIME_UNITS "nsec"
+
+static double time_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+#endif
+
+static float test_q[NUM_TESTS][QSZ];
+static float test_v[NUM_TESTS][MSZ];
+static volatile float sink;
+
+/**
+ * @function q_rot_v_q()
+ * @brief the two product rotation from AHRS.c, kept here as the baseline
+ */
+static void q_rot_v_q(float v_i[MSZ], float q[QSZ], float v_b[MSZ]) {
+    float q_i[QSZ] = {0, v_i[0], v_i[1], v_i[2]};
+    float q_conj[QSZ] = {q[0], -q[1], -q[2], -q[3]};
+    float q_temp[QSZ];
+    float q_b[QSZ];
+
+    lin_alg_q_mult(q_i, q, q_temp);
+    lin_alg_q_mult(q_conj, q_temp, q_b);
+    v_b[0] = q_b[1];
+    v_b[1] = q_b[2];
+    v_b[2] = q_b[3];
+}
+
+/**
+ * @function q_rot_v_ref()
+ * @brief q* x [0 v] x q in double, inverse when inverse is nonzero
+ */
+static void q_rot_v_ref(float v[MSZ], float q[QSZ], int inverse, double v_out[MSZ]) {
+    double q_d[QSZ] = {q[0], q[1], q[2], q[3]};
+    double q_c[QSZ] = {q[0], -q[1], -q[2], -q[3]};
+    double x[QSZ] = {0, v[0], v[1], v[2]};
+    double *a = inverse ? q_d : q_c;
+    double *b = inverse ? q_c : q_d;
+    double r[QSZ];
+    double s[QSZ];
+
+    // r = x * b
+    r[0] = x[0] * b[0] - x[1] * b[1] - x[2] * b[2] - x[3] * b[3];
+    r[1] = x[0] * b[1] + x[1] * b[0] + x[2] * b[3] - x[3] * b[2];
+    r[2] = x[0] * b[2] - x[1] * b[3] + x[2] * b[0] + x[3] * b[1];
+    r[3] = x[0] * b[3] + x[1] * b[2] - x[2] * b[1] + x[3] * b[0];
+    // s = a * r
+    s[1] = a[0] * r[1] + a[1] * r[0] + a[2] * r[3] - a[3] * r[2];
+    s[2] = a[0] * r[2] - a[1] * r[3] + a[2] * r[0] + a[3] * r[1];
+    s[3] = a[0] * r[3] + a[1] * r[2] - a[2] * r[1] + a[3] * r[0];
+    v_out[0] = s[1];
+    v_out[1] = s[2];
+    v_out[2] = s[3];
+}
+
+/**
+ * @function v_err()
+ * @return largest component difference
+ */
+static double v_err(float v[MSZ], double ref[MSZ]) {
+    double e = 0;
+    int i;
+    for (i = 0; i < MSZ; i++) {
+        if (fabs(v[i] - ref[i]) > e) e = fabs(v[i] - ref[i]);
+    }
+    return e;
+}
+
+/**
+ * @function angle_err()
+ * @return largest wrapped angle difference
+ */
+static double angle_err(float e[MSZ], double ref[MSZ]) {
+    double d;
+    double m = 0;
+    int i;
+    for (i = 0; i < MSZ; i++) {
+        d = fabs(atan2(sin(e[i] - ref[i]), cos(e[i] - ref[i])));
+        if (d > m) m = d;
+    }
+    return m;
+}
+
+/**
+ * @function fill_tests()
+ * @brief random unit quaternions from a small LCG so the target needs no rand()
+ * plus the gimbal lock attitudes
+ */
+static void fill_tests(void) {
+    uint32_t seed = 12345;
+    float n;
+    int t;
+    int i;
+
+    for (t = 0; t < NUM_TESTS; t++) {
+        for (i = 0; i < QSZ; i++) {
+            seed = seed * 1664525 + 1013904223;
+            test_q[t][i] = (float) ((int32_t) seed) / 2147483648.0f;
+        }
+        for (i = 0; i < MSZ; i++) {
+            seed = seed * 1664525 + 1013904223;
+            test_v[t][i] = (float) ((int32_t) seed) / 2147483648.0f;
+        }
+        n = lin_alg_q_norm(test_q[t]);
+        for (i = 0; i < QSZ; i++) test_q[t][i] /= n;
+    }
+    // pitch +/- 90 deg
+    test_q[0][0] = test_q[0][2] = (float) sqrt(0.5);
+    test_q[0][1] = test_q[0][3] = 0;
+    test_q[1][0] = (float) sqrt(0.5);
+    test_q[1][2] = -test_q[1][0];
+    test_q[1][1] = test_q[1][3] = 0;
+}
+
+int main(void) {
+    double err_rot = 0;
+    double err_inv = 0;
+    double err_cache = 0;
+    double err_b2i = 0;
+    double err_euler = 0;
+    double err_euler_cache = 0;
+    double ref[MSZ];
+    double q_d[QSZ];
+    double t_start;
+    double t_two_product;
+    double t_reduced;
+    double t_cached;
+    double t_euler;
+    double t_euler_cache;
+    float v[MSZ];
+    float e[MSZ];
+    rot_cache_t rot;
+    int t;
+    int k;
+    int i;
+
+#ifdef __XC32
+    Board_init();
+    Serial_init();
+#endif
+    printf("Lin_alg_rot test harness %s, %s\r\n", __DATE__, __TIME__);
+    fill_tests();
+
+    /* accuracy against the double precision reference */
+    for (t = 0; t < NUM_TESTS; t++) {
+        q_rot_v_ref(test_v[t], test_q[t], 0, ref);
+        lin_alg_q_rot_v(test_v[t], test_q[t], v);
+        if (v_err(v, ref) > err_rot) err_rot = v_err(v, ref);
+        lin_alg_rot_set_q(&rot, test_q[t]);
+        lin_alg_rot_i2b(&rot, test_v[t], v);
+        if (v_err(v, ref) > err_cache) err_cache = v_err(v, ref);
+
+        q_rot_v_ref(test_v[t], test_q[t], 1, ref);
+        lin_alg_q_rot_v_inv(test_v[t], test_q[t], v);
+        if (v_err(v, ref) > err_inv) err_inv = v_err(v, ref);
+        lin_alg_rot_b2i(&rot, test_v[t], v);
+        if (v_err(v, ref) > err_b2i) err_b2i = v_err(v, ref);
+
+        /* skip the gimbal lock cases where yaw and roll are not unique */
+        if (t < 2) continue;
+        for (i = 0; i < QSZ; i++) q_d[i] = test_q[t][i];
+        lin_alg_quat2euler_dbl(q_d, ref);
+        lin_alg_quat2euler(test_q[t], e);
+        if (angle_err(e, ref) > err_euler) err_euler = angle_err(e, ref);
+        lin_alg_rot_euler(&rot, e);
+        if (angle_err(e, ref) > err_euler_cache) err_euler_cache = angle_err(e, ref);
+    }
+    lin_alg_quat2euler(test_q[0], e);
+    printf("pitch at +90 deg: %f\r\n", e[1]);
+    lin_alg_quat2euler(test_q[1], e);
+    printf("pitch at -90 deg: %f\r\n", e[1]);
+    printf("max error q_rot_v %.2e q_rot_v_inv %.2e rot_i2b %.2e rot_b2i %.2e\r\n",
+            err_rot, err_inv, err_cache, err_b2i);
+    printf("max error quat2euler %.2e rad, rot_euler %.2e rad\r\n",
+            err_euler, err_euler_cache);
+
+    /* timing, NUM_VECTORS rotations per tick as in AHRS_update() */
+    t_start = time_now();
+    for (t = 0; t < NUM_TESTS; t++) {
+        for (k = 0; k < NUM_VECTORS; k++) {
+            q_rot_v_q(test_v[(t + k) % NUM_TESTS], test_q[t], v);
+            sink = v[0];
+        }
+    }
+    t_two_product = (time_now() - t_start) / NUM_TESTS;
+    t_start = time_now();
+    for (t = 0; t < NUM_TESTS; t++) {
+        for (k = 0; k < NUM_VECTORS; k++) {
+            lin_alg_q_rot_v(test_v[(t + k) % NUM_TESTS], test_q[t], v);
+            sink = v[0];
+        }
+    }
+    t_reduced = (time_now() - t_start) / NUM_TESTS;
+    t_start = time_now();
+    for (t = 0; t < NUM_TESTS; t++) {
+        lin_alg_rot_set_q(&rot, test_q[t]);
+        for (k = 0; k < NUM_VECTORS; k++) {
+            lin_alg_rot_i2b(&rot, test_v[(t + k) % NUM_TESTS], v);
+            sink = v[0];
+        }
+    }
+    t_cached = (time_now() - t_start) / NUM_TESTS;
+    t_start = time_now();
+    for (t = 0; t < NUM_TESTS; t++) {
+        lin_alg_quat2euler(test_q[t], e);
+        sink = e[0];
+    }
+    t_euler = (time_now() - t_start) / NUM_TESTS;
+    t_start = time_now();
+    for (t = 0; t < NUM_TESTS; t++) {
+        lin_alg_rot_set_q(&rot, test_q[t]);
+        lin_alg_rot_euler(&rot, e);
+        sink = e[0];
+    }
+    t_euler_cache = (time_now() - t_start) / NUM_TESTS;
+
+    printf("%s per tick, %d vectors: two products %.1f, reduced %.1f, cached DCM %.1f\r\n",
+            TIME_UNITS, NUM_VECTORS, t_two_product, t_reduced, t_cached);
+    printf("%s per Euler extraction: quaternion %.1f, set_q + cached %.1f\r\n",
+            TIME_UNITS, t_euler, t_euler_cache);
+#ifdef __XC32
+    while (1);
+#endif
+    return 0;
+}
+#endif
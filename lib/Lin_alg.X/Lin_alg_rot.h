@@ -0,0 +1,128 @@
+/*
+ * File:   Lin_alg_rot.h
+ * Brief: Quaternion vector rotation and Euler angle extraction shared by the
+ * AHRS, guidance and heading control code, replacing the q_rot_v_q() and
+ * quat2euler() copies in the apps.  Rotations use the reduced operation form
+ * rather than two Hamilton products.  When several vectors are rotated with
+ * the same attitude in one tick, lin_alg_rot_set_q() computes the DCM once
+ * and the lin_alg_rot_* calls reuse it.
+ * Conventions: q is the scalar first attitude quaternion from AHRS_update(),
+ * inertial to body is q* x [0 v] x q, Euler angles are [psi, theta, phi].
+ * Created on 10/16/2026
+ * Modified on
+ */
+
+#ifndef LIN_ALG_ROT_H // Header guard
+#define	LIN_ALG_ROT_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+#include <stdint.h>
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+/* same sizes as Lin_alg_float.h, not included here so the double precision
+ * apps with their own lin_alg_* helpers can use this header */
+#ifndef MSZ
+#define MSZ 3
+#endif
+#ifndef QSZ
+#define QSZ 4
+#endif
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+typedef struct rot_cache {
+    float q[QSZ]; // attitude the DCM was computed from
+    float dcm[MSZ][MSZ]; // inertial to body, v_b = dcm * v_i
+} rot_cache_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function lin_alg_q_rot_v(float v_i[MSZ], float q[QSZ], float v_b[MSZ])
+ * @param v_i, a vector in the inertial frame
+ * @param q, unit attitude quaternion
+ * @param v_b, v_i rotated into the body frame
+ * @return none
+ * @brief drop in replacement for q_rot_v_q(), 15 multiplies instead of 32
+ * @author Aaron Hunter, 10/16/2026 */
+void lin_alg_q_rot_v(float v_i[MSZ], float q[QSZ], float v_b[MSZ]);
+
+/**
+ * @Function lin_alg_q_rot_v_inv(float v_b[MSZ], float q[QSZ], float v_i[MSZ])
+ * @param v_b, a vector in the body frame
+ * @param q, unit attitude quaternion
+ * @param v_i, v_b rotated into the inertial frame
+ * @return none
+ * @author Aaron Hunter, 10/16/2026 */
+void lin_alg_q_rot_v_inv(float v_b[MSZ], float q[QSZ], float v_i[MSZ]);
+
+/**
+ * @Function lin_alg_quat2euler(float q[QSZ], float euler[MSZ])
+ * @param q, unit attitude quaternion
+ * @param euler, [psi, theta, phi] in radians
+ * @return none
+ * @brief the Euler extraction used by every app, pitch is clamped to +/- pi/2
+ * when rounding puts the asin() argument just outside [-1, 1]
+ * @author Aaron Hunter, 10/16/2026 */
+void lin_alg_quat2euler(float q[QSZ], float euler[MSZ]);
+
+/**
+ * @Function lin_alg_rot_set_q(rot_cache_t *rot, float q[QSZ])
+ * @param rot, cache to update
+ * @param q, unit attitude quaternion for this tick
+ * @return none
+ * @brief computes the inertial to body DCM once, call after AHRS_update()
+ * @author Aaron Hunter, 10/16/2026 */
+void lin_alg_rot_set_q(rot_cache_t *rot, float q[QSZ]);
+
+/**
+ * @Function lin_alg_rot_i2b(const rot_cache_t *rot, float v_i[MSZ],
+ * float v_b[MSZ])
+ * @param rot, cache set by lin_alg_rot_set_q()
+ * @param v_i, a vector in the inertial frame
+ * @param v_b, v_i rotated into the body frame
+ * @return none
+ * @brief 9 multiplies per vector once the DCM is cached
+ * @author Aaron Hunter, 10/16/2026 */
+void lin_alg_rot_i2b(const rot_cache_t *rot, float v_i[MSZ], float v_b[MSZ]);
+
+/**
+ * @Function lin_alg_rot_b2i(const rot_cache_t *rot, float v_b[MSZ],
+ * float v_i[MSZ])
+ * @param rot, cache set by lin_alg_rot_set_q()
+ * @param v_b, a vector in the body frame
+ * @param v_i, v_b rotated into the inertial frame
+ * @return none
+ * @author Aaron Hunter, 10/16/2026 */
+void lin_alg_rot_b2i(const rot_cache_t *rot, float v_b[MSZ], float v_i[MSZ]);
+
+/**
+ * @Function lin_alg_rot_euler(const rot_cache_t *rot, float euler[MSZ])
+ * @param rot, cache set by lin_alg_rot_set_q()
+ * @param euler, [psi, theta, phi] in radians
+ * @return none
+ * @brief same result as lin_alg_quat2euler() from the cached DCM terms
+ * @author Aaron Hunter, 10/16/2026 */
+void lin_alg_rot_euler(const rot_cache_t *rot, float euler[MSZ]);
+
+/**
+ * @Function lin_alg_q_rot_v_dbl(double v_i[MSZ], double q[QSZ],
+ * double v_b[MSZ])
+ * @brief double precision lin_alg_q_rot_v() for the q_ahrs_dbl reference
+ * @author Aaron Hunter, 10/16/2026 */
+void lin_alg_q_rot_v_dbl(double v_i[MSZ], double q[QSZ], double v_b[MSZ]);
+
+/**
+ * @Function lin_alg_quat2euler_dbl(double q[QSZ], double euler[MSZ])
+ * @brief double precision lin_alg_quat2euler() for the q_ahrs_dbl reference
+ * @author Aaron Hunter, 10/16/2026 */
+void lin_alg_quat2euler_dbl(double q[QSZ], double euler[MSZ]);
+
+#endif	/* LIN_ALG_ROT_H */ // End of header guard
@@ -17,6 +17,7 @@
 #include "Board.h"
 #include "SerialM32.h"
 #include "System_timer.h"
+#include "Scheduler.h"
 #include "Radio_serial.h"
 #include "common/mavlink.h"
 #include "NEO_M8N.h"
@@ -86,6 +87,11 @@ static uint8_t pub_RC_signals = TRUE;
 static uint8_t pub_IMU = TRUE;
 static uint8_t pub_Encoder = TRUE;
 
+/* IMU acquisition state for the control task */
+static int8_t IMU_state = ERROR;
+static uint32_t IMU_error = 0;
+static const uint8_t error_report = 50;
+
 /*Pre-calculate float conversions*/
 static float omega_to_dist = WHEEL_RADIUS * 2 * M_PI / ENCODER_MAX_CTS;
 static float knots_to_mps = KNOTS_TO_MPS;
@@ -203,6 +209,50 @@ static uint16_t calc_pw(uint16_t raw_counts);
  */
 void set_control_output(void);
 
+/**
+ * @function encoder_task(void)
+ * @brief starts an encoder acquisition every ENCODER_PERIOD
+ */
+void encoder_task(void);
+
+/**
+ * @function control_task(void)
+ * @brief sets the actuator outputs and starts the next IMU acquisition every
+ * CONTROL_PERIOD
+ */
+void control_task(void);
+
+/**
+ * @function telemetry_task(void)
+ * @brief publishes the high speed sensors every CONTROL_PERIOD
+ */
+void telemetry_task(void);
+
+/**
+ * @function gps_task(void)
+ * @brief publishes the GPS data every GPS_PERIOD
+ */
+void gps_task(void);
+
+/**
+ * @function heartbeat_task(void)
+ * @brief publishes the heartbeat every HEARTBEAT_PERIOD
+ */
+void heartbeat_task(void);
+
+/*******************************************************************************
+ * TASKS                                                                       *
+ ******************************************************************************/
+/* publishing is split from the control task so it runs in the gaps */
+static sched_task_t tasks[] = {
+    SCHED_TASK("control", control_task, CONTROL_PERIOD, 0, 0, 0),
+    SCHED_TASK("encoder", encoder_task, ENCODER_PERIOD, 0, 1, 0),
+    SCHED_TASK("telemetry", telemetry_task, CONTROL_PERIOD, 1, 2, 0),
+    SCHED_TASK("gps", gps_task, GPS_PERIOD, 3, 3, 0),
+    SCHED_TASK("heartbeat", heartbeat_task, HEARTBEAT_PERIOD, 5, 4, 0),
+};
+#define NUM_TASKS (sizeof (tasks) / sizeof (tasks[0]))
+
 /*******************************************************************************
  * FUNCTIONS                                                                   *
  ******************************************************************************/
@@ -347,7 +397,7 @@ void publish_IMU_data(uint8_t data_type) {
         mavlink_msg_raw_imu_pack(mavlink_system.sysid,
                 mavlink_system.compid,
                 &msg_tx,
-                Sys_timer_get_usec(),
+                Sys_timer_get_usec64(),
                 (int16_t) IMU_raw.acc.x,
                 (int16_t) IMU_raw.acc.y,
                 (int16_t) IMU_raw.acc.z,
@@ -364,7 +414,7 @@ void publish_IMU_data(uint8_t data_type) {
         mavlink_msg_highres_imu_pack(mavlink_system.sysid,
                 mavlink_system.compid,
                 &msg_tx,
-                Sys_timer_get_usec(),
+                Sys_timer_get_usec64(),
                 (float) IMU_scaled.acc.x,
                 (float) IMU_scaled.acc.y,
                 (float) IMU_scaled.acc.z,
@@ -537,7 +587,7 @@ void publish_GPS(void) {
     mavlink_msg_gps_raw_int_pack(mavlink_system.sysid,
             mavlink_system.compid,
             &msg_tx,
-            (uint64_t) Sys_timer_get_usec(),
+            Sys_timer_get_usec64(),
             gps_fix,
             (int32_t) (GPS_data.lat * 10000000.0),
             (int32_t) (GPS_data.lon * 10000000.0),
@@ -666,18 +716,71 @@ void set_control_output(void) {
     }
 }
 
+/**
+ * @function encoder_task(void)
+ * @brief starts an encoder acquisition every ENCODER_PERIOD
+ */
+void encoder_task(void) {
+    Encoder_start_data_acq(); //initiate Encoder measurement with SPI
+}
+
+/**
+ * @function control_task(void)
+ * @brief sets the actuator outputs and starts the next IMU acquisition every
+ * CONTROL_PERIOD
+ */
+void control_task(void) {
+    set_control_output(); // set actuator outputs
+    /*start next data acquisition round*/
+    IMU_state = IMU_start_data_acq(); //initiate IMU measurement with SPI
+    if (IMU_state == ERROR) {
+        IMU_error++;
+        if (IMU_error % error_report == 0) {
+            printf("IMU error count %d\r\n", IMU_error);
+        }
+    }
+}
+
+/**
+ * @function telemetry_task(void)
+ * @brief publishes the high speed sensors every CONTROL_PERIOD
+ */
+void telemetry_task(void) {
+    if (pub_RC_signals == TRUE) {
+        publish_RC_signals_raw();
+    }
+    if (pub_IMU == TRUE) {
+        publish_IMU_data(RAW);
+    }
+    if (pub_Encoder == TRUE) {
+        publish_encoder_data();
+    }
+}
+
+/**
+ * @function gps_task(void)
+ * @brief publishes the GPS data every GPS_PERIOD
+ */
+void gps_task(void) {
+    if (pub_GPS == TRUE) {
+        publish_GPS();
+    }
+}
+
+/**
+ * @function heartbeat_task(void)
+ * @brief publishes the heartbeat every HEARTBEAT_PERIOD
+ */
+void heartbeat_task(void) {
+    publish_heartbeat();
+    //            printf("RC_RX errors: %d\r", RCRX_get_err());
+}
+
 int main(void) {
     uint32_t cur_time = 0;
     uint32_t warmup_time = 250; //time in ms to allow subsystems to stabilize (IMU))
-    uint32_t gps_start_time = 0;
-    uint32_t control_start_time = 0;
-    uint32_t encoder_start_time = 0;
-    uint32_t heartbeat_start_time = 0;
     uint8_t index;
-    int8_t IMU_state = ERROR;
     int8_t IMU_retry = 5;
-    uint32_t IMU_error = 0;
-    uint8_t error_report = 50;
 
     //Initialization routines
     Board_init(); //board configuration
@@ -706,60 +809,17 @@ int main(void) {
 
     printf("\r\nMinimal Mavlink application %s, %s \r\n", __DATE__, __TIME__);
 
+    /* start the periodic tasks */
+    Sched_init(tasks, NUM_TASKS);
+
     while (1) {
-        cur_time = Sys_timer_get_msec();
         //check for all events
         check_IMU_events(); //check for IMU data ready and publish when available
         check_encoder_events(); //check for encoder data ready and publish when available
         check_radio_events(); //detect and process MAVLink incoming messages
         check_RC_events(); //check incoming RC commands
         check_GPS_events(); //check and process incoming GPS messages
-
-        //for now start encoder every ENCODER_PERIOD but publish every CONTROL_PERIOD
-        if (cur_time - encoder_start_time >= ENCODER_PERIOD) {
-            encoder_start_time = cur_time; //reset control loop timer
-            Encoder_start_data_acq(); //initiate Encoder measurement with SPI
-        }
-
-
-        //publish control and sensor signals
-        if (cur_time - control_start_time >= CONTROL_PERIOD) {
-            control_start_time = cur_time; //reset control loop timer
-            set_control_output(); // set actuator outputs
-            /*publish high speed sensors*/
-            if (pub_RC_signals == TRUE) {
-                publish_RC_signals_raw();
-            }
-            if (pub_IMU == TRUE) {
-                publish_IMU_data(RAW);
-            }
-            if (pub_Encoder == TRUE) {
-                publish_encoder_data();
-            }
-            /*start next data acquisition round*/
-            IMU_state = IMU_start_data_acq(); //initiate IMU measurement with SPI
-            if (IMU_state == ERROR) {
-                IMU_error++;
-                if (IMU_error % error_report == 0) {
-                    printf("IMU error count %d\r\n", IMU_error);
-                }
-            }
-        }
-
-        //publish GPS
-        if (cur_time - gps_start_time > GPS_PERIOD) {
-            gps_start_time = cur_time; //reset GPS timer
-            if (pub_GPS == TRUE) {
-                publish_GPS();
-            }
-        }
-        //publish heartbeat
-        if (cur_time - heartbeat_start_time >= HEARTBEAT_PERIOD) {
-            heartbeat_start_time = cur_time; //reset the timer
-            publish_heartbeat();
-            //            printf("RC_RX errors: %d\r", RCRX_get_err());
-
-        }
+        Sched_run(); // run the highest priority task that is due
     }
     return 0;
 }
\ No newline at end of file
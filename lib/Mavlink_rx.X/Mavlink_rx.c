@@ -0,0 +1,397 @@
+/*
+ * File:   Mavlink_rx.c
+ * Brief: MAVLink receive engine, see Mavlink_rx.h.  The MAVLINK_RX_TESTING
+ * harness is a host benchmark: it replays a MAVLink byte stream into both
+ * ports in UART sized bursts and reports the sustained message rate,
+ * checking every frame arrives once on each port:
+ *     make -C sim mavlink_rx_bench && sim/mavlink_rx_bench [capture]
+ * Created on 10/16/2026
+ * Modified on 10/16/2026
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+
+#include "Mavlink_rx.h" // The header file for this source file.
+#include "Board.h"
+#include "SerialM32.h"
+#include "Radio_serial.h"
+#include "System_timer.h"
+#include <string.h>
+
+/*******************************************************************************
+ * PRIVATE VARIABLES                                                           *
+ ******************************************************************************/
+/* parser state per port, a message is handled in place where it was framed */
+static mavlink_message_t rx_msg[MAVLINK_TX_PORTS];
+static mavlink_status_t rx_status[MAVLINK_TX_PORTS];
+static const mavlink_rx_entry_t *handlers = NULL;
+static uint8_t handler_count = 0;
+static mavlink_rx_handler_t unknown_handler = NULL;
+static mavlink_rx_stats_t stats;
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                 *
+ ******************************************************************************/
+static void dispatch(const mavlink_message_t *msg, uint8_t port);
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function Mavlink_rx_init(const mavlink_rx_entry_t *table, uint8_t count, mavlink_rx_handler_t fallback)
+ * @param table, handler for each message id, kept by reference
+ * @param count, entries in table
+ * @param fallback, handler for ids not in the table, NULL to drop them
+ * @return none
+ * @brief resets both parsers and the statistics
+ * @author Aaron Hunter */
+void Mavlink_rx_init(const mavlink_rx_entry_t *table, uint8_t count, mavlink_rx_handler_t fallback) {
+    handlers = table;
+    handler_count = count;
+    unknown_handler = fallback;
+    memset(rx_msg, 0, sizeof (rx_msg));
+    memset(rx_status, 0, sizeof (rx_status));
+    Mavlink_rx_reset_stats();
+}
+
+/**
+ * @Function Mavlink_rx_poll(uint32_t budget_usec)
+ * @param budget_usec, time the pass may take, handlers included; a pass
+ * stops at the first chunk boundary past it
+ * @return messages dispatched
+ * @brief drains the USB and radio receive rings, call once per main loop pass
+ * @author Aaron Hunter */
+uint16_t Mavlink_rx_poll(uint32_t budget_usec) {
+    uint8_t chunk[MAVLINK_RX_CHUNK];
+    uint32_t start = Sys_timer_get_core();
+    uint32_t budget = budget_usec * SYS_TIMER_CORE_PER_USEC;
+    uint32_t elapsed;
+    uint16_t length;
+    uint16_t dispatched = 0;
+    uint8_t busy;
+
+    do {
+        busy = FALSE;
+        /* a chunk from each port in turn so neither starves the other */
+        length = Radio_read(chunk, sizeof (chunk));
+        if (length > 0) {
+            dispatched += Mavlink_rx_parse(MAVLINK_TX_RADIO, chunk, length);
+            busy = TRUE;
+        }
+        length = Serial_read(chunk, sizeof (chunk));
+        if (length > 0) {
+            dispatched += Mavlink_rx_parse(MAVLINK_TX_USB, chunk, length);
+            busy = TRUE;
+        }
+        elapsed = Sys_timer_get_core() - start;
+    } while (busy == TRUE && elapsed < budget);
+    if (busy == TRUE && (Radio_data_available() || Serial_data_available())) {
+        stats.budget_hits++; // the rest waits in the rings for the next pass
+    }
+    elapsed /= SYS_TIMER_CORE_PER_USEC;
+    if (elapsed > stats.max_pass) {
+        stats.max_pass = elapsed;
+    }
+    return dispatched;
+}
+
+/**
+ * @Function Mavlink_rx_parse(uint8_t port, const uint8_t *data, uint16_t length)
+ * @param port, MAVLINK_TX_RADIO or MAVLINK_TX_USB
+ * @param data, bytes received on the port
+ * @param length, number of bytes
+ * @return messages dispatched
+ * @brief runs the port's parser over the bytes, for links read elsewhere
+ * @author Aaron Hunter */
+uint16_t Mavlink_rx_parse(uint8_t port, const uint8_t *data, uint16_t length) {
+    mavlink_message_t *msg;
+    mavlink_status_t *status;
+    uint16_t dispatched = 0;
+    uint16_t i;
+
+    if (port >= MAVLINK_TX_PORTS) {
+        return 0;
+    }
+    msg = &rx_msg[port];
+    status = &rx_status[port];
+    for (i = 0; i < length; i++) {
+        /* no copy out, the handler reads the message the parser built */
+        switch (mavlink_frame_char_buffer(msg, status, data[i], NULL, NULL)) {
+            case MAVLINK_FRAMING_OK:
+                dispatch(msg, port);
+                dispatched++;
+                break;
+            case MAVLINK_FRAMING_BAD_CRC:
+            case MAVLINK_FRAMING_BAD_SIGNATURE:
+                stats.errors[port]++;
+                break;
+            default:
+                break;
+        }
+    }
+    stats.bytes[port] += length;
+    stats.messages[port] += dispatched;
+    return dispatched;
+}
+
+/**
+ * @Function Mavlink_rx_get_stats(void)
+ * @return bytes, messages and errors per port and pass timing since the last
+ * reset
+ * @author Aaron Hunter */
+const mavlink_rx_stats_t *Mavlink_rx_get_stats(void) {
+    return &stats;
+}
+
+/**
+ * @Function Mavlink_rx_reset_stats(void)
+ * @return none
+ * @author Aaron Hunter */
+void Mavlink_rx_reset_stats(void) {
+    memset(&stats, 0, sizeof (stats));
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/* dispatch(const mavlink_message_t *msg, uint8_t port)
+ * calls the handler registered for the message id, the table is short so a
+ * scan beats anything cleverer
+ */
+static void dispatch(const mavlink_message_t *msg, uint8_t port) {
+    uint8_t i;
+
+    for (i = 0; i < handler_count; i++) {
+        if (handlers[i].msgid == msg->msgid) {
+            handlers[i].handler(msg, port);
+            return;
+        }
+    }
+    if (unknown_handler != NULL) {
+        unknown_handler(msg, port);
+    }
+}
+
+#ifdef MAVLINK_RX_TESTING
+/* host only: the replay stands in for the UART drivers and the core timer */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_FRAMES 20480 // a multiple of 256 so the sequence runs on across repeats
+#define BENCH_REPEAT 20
+#define BENCH_BUDGET 250 // usec per pass, what the rover gives the engine
+#define BENCH_CORRUPT 97 // every 97th radio frame gets a payload byte flipped
+
+mavlink_system_t mavlink_system = {
+    1, // System ID (1-255)
+    MAV_COMP_ID_AUTOPILOT1 // Component ID (a MAV_COMPONENT value)
+};
+/* Mavlink_tx.c is not linked, the packing below needs the sequence numbers */
+mavlink_status_t m_mavlink_status[MAVLINK_COMM_NUM_BUFFERS];
+
+static uint8_t *stream[MAVLINK_TX_PORTS]; // the radio copy carries the bad frames
+static uint32_t stream_length = 0;
+static uint32_t position[MAVLINK_TX_PORTS]; // bytes replayed into each port
+static uint32_t replay_end = 0;
+static uint32_t seed = 12345;
+static uint32_t handled[MAVLINK_TX_PORTS];
+static uint32_t lost[MAVLINK_TX_PORTS]; // frames missing from the sequence
+static uint8_t last_seq[MAVLINK_TX_PORTS];
+static uint8_t seq_valid[MAVLINK_TX_PORTS];
+
+/* xorshift */
+static uint32_t next_random(void) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+/* bytes arrive in bursts of 1 to length like from a UART */
+static uint16_t replay(uint8_t port, uint8_t *data, uint16_t length) {
+    uint32_t count = next_random() % length + 1;
+    uint32_t index;
+    uint32_t first;
+
+    if (count > replay_end - position[port]) {
+        count = replay_end - position[port];
+    }
+    index = position[port] % stream_length;
+    first = stream_length - index;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(data, &stream[port][index], first);
+    memcpy(data + first, stream[port], count - first);
+    position[port] += count;
+    return count;
+}
+
+uint16_t Radio_read(uint8_t *data, uint16_t length) {
+    return replay(MAVLINK_TX_RADIO, data, length);
+}
+
+uint16_t Serial_read(uint8_t *data, uint16_t length) {
+    return replay(MAVLINK_TX_USB, data, length);
+}
+
+unsigned char Radio_data_available(void) {
+    return position[MAVLINK_TX_RADIO] < replay_end;
+}
+
+unsigned char Serial_data_available(void) {
+    return position[MAVLINK_TX_USB] < replay_end;
+}
+
+uint32_t Sys_timer_get_core(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t) ((now.tv_sec * 1000000000ull + now.tv_nsec) * SYS_TIMER_CORE_PER_USEC / 1000);
+}
+
+/* counts the message and the frames the sequence skipped */
+static void bench_handler(const mavlink_message_t *msg, uint8_t port) {
+    if (seq_valid[port] == TRUE) {
+        lost[port] += (uint8_t) (msg->seq - last_seq[port] - 1);
+    }
+    last_seq[port] = msg->seq;
+    seq_valid[port] = TRUE;
+    handled[port]++;
+}
+
+static const mavlink_rx_entry_t bench_table[] = {
+    {MAVLINK_MSG_ID_HEARTBEAT, bench_handler},
+    {MAVLINK_MSG_ID_PARAM_REQUEST_READ, bench_handler},
+    {MAVLINK_MSG_ID_COMMAND_LONG, bench_handler},
+    {MAVLINK_MSG_ID_HIL_SENSOR, bench_handler},
+    {MAVLINK_MSG_ID_HIL_GPS, bench_handler},
+};
+
+/* what a simulator and a ground station send: mostly HIL_SENSOR with GPS,
+ * heartbeats and commands mixed in; returns the frames made bad on the radio */
+static uint32_t make_stream(void) {
+    mavlink_message_t msg;
+    uint8_t frame[MAVLINK_MAX_PACKET_LEN];
+    uint16_t length;
+    uint32_t corrupted = 0;
+    uint32_t i;
+
+    stream[MAVLINK_TX_USB] = malloc(BENCH_FRAMES * MAVLINK_MAX_PACKET_LEN);
+    stream[MAVLINK_TX_RADIO] = malloc(BENCH_FRAMES * MAVLINK_MAX_PACKET_LEN);
+    for (i = 0; i < BENCH_FRAMES; i++) {
+        switch (i % 10) {
+            case 7:
+                mavlink_msg_hil_gps_pack(255, 1, &msg, i * 10000ull, 3, 369950000,
+                        -1220600000, 10000, 100, 100, 150, 100, 50, 0, 9000, 12, 0, 9000);
+                break;
+            case 8:
+                mavlink_msg_heartbeat_pack(255, 190, &msg, MAV_TYPE_GCS,
+                        MAV_AUTOPILOT_INVALID, 0, 0, MAV_STATE_ACTIVE);
+                break;
+            case 9:
+                mavlink_msg_command_long_pack(255, 190, &msg, 1, 1,
+                        MAV_CMD_REQUEST_MESSAGE, 0, 1.0, 0, 0, 0, 0, 0, 0);
+                break;
+            default:
+                mavlink_msg_hil_sensor_pack(255, 1, &msg, i * 1000ull, 0.01, 0.02,
+                        -9.8, 0.1, 0.2, 0.3, 0.2, 0.0, 0.4, 1013.0, 0, 10.0, 25.0,
+                        0x1fff, 0);
+                break;
+        }
+        length = mavlink_msg_to_send_buffer(frame, &msg);
+        memcpy(&stream[MAVLINK_TX_USB][stream_length], frame, length);
+        if (i % BENCH_CORRUPT == BENCH_CORRUPT - 1) {
+            frame[MAVLINK_NUM_HEADER_BYTES + 1] ^= 0x55; // payload, the CRC catches it
+            corrupted++;
+        }
+        memcpy(&stream[MAVLINK_TX_RADIO][stream_length], frame, length);
+        stream_length += length;
+    }
+    return corrupted;
+}
+
+/* a raw capture of a link, sent the same on both ports */
+static int8_t load_stream(const char *name) {
+    FILE *file = fopen(name, "rb");
+    long length;
+
+    if (file == NULL) {
+        return ERROR;
+    }
+    fseek(file, 0, SEEK_END);
+    length = ftell(file);
+    rewind(file);
+    stream[MAVLINK_TX_USB] = malloc(length > 0 ? length : 1);
+    stream_length = fread(stream[MAVLINK_TX_USB], 1, length > 0 ? length : 0, file);
+    stream[MAVLINK_TX_RADIO] = stream[MAVLINK_TX_USB];
+    fclose(file);
+    return stream_length > 0 ? SUCCESS : ERROR;
+}
+
+int main(int argc, char *argv[]) {
+    const mavlink_rx_stats_t *rx;
+    struct timespec start;
+    struct timespec end;
+    uint32_t corrupted = 0;
+    uint32_t messages = 0;
+    uint32_t passes = 0;
+    uint32_t errors = 0;
+    uint8_t port;
+    double seconds;
+
+    if (argc > 1) {
+        if (load_stream(argv[1]) == ERROR) {
+            printf("FAIL: can't read %s\r\n", argv[1]);
+            return EXIT_FAILURE;
+        }
+    } else {
+        corrupted = make_stream();
+    }
+    replay_end = stream_length * BENCH_REPEAT;
+    printf("MAVLink receive bench, %u bytes x %d on both ports, %d usec passes\r\n",
+            stream_length, BENCH_REPEAT, BENCH_BUDGET);
+    Mavlink_rx_init(bench_table, sizeof (bench_table) / sizeof (bench_table[0]), bench_handler);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (Radio_data_available() || Serial_data_available()) {
+        messages += Mavlink_rx_poll(BENCH_BUDGET);
+        passes++;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+    rx = Mavlink_rx_get_stats();
+    for (port = 0; port < MAVLINK_TX_PORTS; port++) {
+        printf("%-5s %u bytes, %u messages, %u bad frames, %u lost from the sequence\r\n",
+                port == MAVLINK_TX_USB ? "usb" : "radio", rx->bytes[port],
+                rx->messages[port], rx->errors[port], lost[port]);
+        if (handled[port] != rx->messages[port]) {
+            printf("FAIL: %s handled %u of %u\r\n", port == MAVLINK_TX_USB ? "usb" : "radio",
+                    handled[port], rx->messages[port]);
+            errors++;
+        }
+    }
+    if (argc > 1) {
+        /* the same bytes on both ports, interleaved differently */
+        errors += rx->messages[MAVLINK_TX_USB] != rx->messages[MAVLINK_TX_RADIO];
+        errors += rx->errors[MAVLINK_TX_USB] != rx->errors[MAVLINK_TX_RADIO];
+    } else {
+        errors += rx->messages[MAVLINK_TX_USB] != BENCH_FRAMES * BENCH_REPEAT;
+        errors += rx->errors[MAVLINK_TX_USB] != 0 || lost[MAVLINK_TX_USB] != 0;
+        errors += rx->messages[MAVLINK_TX_RADIO] != (BENCH_FRAMES - corrupted) * BENCH_REPEAT;
+        errors += rx->errors[MAVLINK_TX_RADIO] != corrupted * BENCH_REPEAT;
+        errors += lost[MAVLINK_TX_RADIO] != corrupted * BENCH_REPEAT;
+    }
+    printf("%u messages in %.3f s, %.0f messages/s, %.1f MB/s, %.1f nsec/byte\r\n",
+            messages, seconds, messages / seconds,
+            2.0 * replay_end / seconds * 1e-6, seconds * 1e9 / (2.0 * replay_end));
+    printf("%u passes, mean %.0f usec, longest %u usec, %u out of budget\r\n",
+            passes, seconds * 1e6 / passes, rx->max_pass, rx->budget_hits);
+    printf("%s\r\n", errors ? "FAILED" : "PASSED");
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+#endif //MAVLINK_RX_TESTING
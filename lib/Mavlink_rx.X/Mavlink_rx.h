@@ -0,0 +1,94 @@
+/*
+ * File:   Mavlink_rx.h
+ * Brief: MAVLink receive engine for the USB and radio ports.  Each pass drains
+ * the bytes waiting in both receive rings, a chunk per port in turn, until
+ * they are empty or the pass used up its time budget.  Every port has its own
+ * parser state and message, so frames arriving on both ports at once never
+ * mix, and a complete message is handed in place to the handler the app
+ * registered for its id.  No message copy and no buffer per call.  Main loop
+ * only, the handlers may send.
+ * Created on 10/16/2026
+ * Modified on 10/16/2026
+ */
+
+#ifndef MAVLINK_RX_H // Header guard
+#define	MAVLINK_RX_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+#include <stdint.h>
+#include "Mavlink_tx.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+#define MAVLINK_RX_CHUNK 64 // bytes read from a port at a time, the budget is checked between chunks
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+/* port is the link's channel, MAVLINK_TX_RADIO or MAVLINK_TX_USB, so a reply
+ * can go back where the message came from */
+typedef void (*mavlink_rx_handler_t)(const mavlink_message_t *msg, uint8_t port);
+
+typedef struct {
+    uint32_t msgid;
+    mavlink_rx_handler_t handler;
+} mavlink_rx_entry_t;
+
+typedef struct {
+    uint32_t bytes[MAVLINK_TX_PORTS];
+    uint32_t messages[MAVLINK_TX_PORTS]; // dispatched
+    uint32_t errors[MAVLINK_TX_PORTS]; // frames with a bad CRC or signature
+    uint32_t budget_hits; // passes that ran out of time with bytes waiting
+    uint32_t max_pass; // longest pass in usec
+} mavlink_rx_stats_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function Mavlink_rx_init(const mavlink_rx_entry_t *table, uint8_t count, mavlink_rx_handler_t fallback)
+ * @param table, handler for each message id, kept by reference
+ * @param count, entries in table
+ * @param fallback, handler for ids not in the table, NULL to drop them
+ * @return none
+ * @brief resets both parsers and the statistics
+ * @author Aaron Hunter */
+void Mavlink_rx_init(const mavlink_rx_entry_t *table, uint8_t count, mavlink_rx_handler_t fallback);
+
+/**
+ * @Function Mavlink_rx_poll(uint32_t budget_usec)
+ * @param budget_usec, time the pass may take, handlers included; a pass
+ * stops at the first chunk boundary past it
+ * @return messages dispatched
+ * @brief drains the USB and radio receive rings, call once per main loop pass
+ * @author Aaron Hunter */
+uint16_t Mavlink_rx_poll(uint32_t budget_usec);
+
+/**
+ * @Function Mavlink_rx_parse(uint8_t port, const uint8_t *data, uint16_t length)
+ * @param port, MAVLINK_TX_RADIO or MAVLINK_TX_USB
+ * @param data, bytes received on the port
+ * @param length, number of bytes
+ * @return messages dispatched
+ * @brief runs the port's parser over the bytes, for links read elsewhere
+ * @author Aaron Hunter */
+uint16_t Mavlink_rx_parse(uint8_t port, const uint8_t *data, uint16_t length);
+
+/**
+ * @Function Mavlink_rx_get_stats(void)
+ * @return bytes, messages and errors per port and pass timing since the last
+ * reset
+ * @author Aaron Hunter */
+const mavlink_rx_stats_t *Mavlink_rx_get_stats(void);
+
+/**
+ * @Function Mavlink_rx_reset_stats(void)
+ * @return none
+ * @author Aaron Hunter */
+void Mavlink_rx_reset_stats(void);
+
+#endif	/* MAVLINK_RX_H */ // End of header guard
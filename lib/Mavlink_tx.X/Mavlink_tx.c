@@ -0,0 +1,396 @@
+/*
+ * File:   Mavlink_tx.c
+ * Brief: Zero-copy MAVLink transmit into the USB and radio DMA blocks, see
+ * Mavlink_tx.h.  The MAVLINK_TX_TESTING harness compares the stack and core
+ * timer cost of a HIGHRES_IMU sent the old way, pack, serialize and copy,
+ * with the send path here and prints them on the USB port.
+ * Created on 10/16/2026
+ * Modified on 10/17/2026
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+
+#include "Mavlink_tx.h" // The header file for this source file.
+#include "Board.h"
+#include "SerialM32.h"
+#include "Radio_serial.h"
+#include <string.h>
+
+/*******************************************************************************
+ * PRIVATE VARIABLES                                                           *
+ ******************************************************************************/
+/* reservation of the frame being built in each port, NULL if it drops it */
+static uint8_t *span[MAVLINK_TX_PORTS];
+static mavlink_channel_t span_chan; // ports of the frame being built
+static uint16_t span_length = 0; // bytes reserved
+static uint16_t span_fill = 0; // bytes written so far
+/* a MAVLINK_TX_ALL frame gets each port's own sequence number and checksum */
+static uint8_t span_restamp = FALSE;
+static uint8_t span_seq_at = 0; // offset of the sequence number
+static uint16_t span_crc_at = 0; // offset of the checksum
+static uint8_t span_crc_extra = 0;
+static uint8_t span_seq[MAVLINK_TX_PORTS];
+static uint16_t span_crc[MAVLINK_TX_PORTS];
+static mavlink_tx_stats_t stats;
+
+/* replies and control outputs, queued urgent so sensor streams filling a link
+ * never crowd them out */
+static const uint32_t urgent_ids[] = {
+    MAVLINK_MSG_ID_HEARTBEAT,
+    MAVLINK_MSG_ID_COMMAND_ACK,
+    MAVLINK_MSG_ID_PARAM_VALUE,
+    MAVLINK_MSG_ID_MESSAGE_INTERVAL,
+    MAVLINK_MSG_ID_STATUSTEXT,
+    MAVLINK_MSG_ID_HIL_ACTUATOR_CONTROLS,
+};
+#define NUM_URGENT_IDS (sizeof (urgent_ids) / sizeof (urgent_ids[0]))
+
+/* MAVLINK_EXTERNAL_RX_STATUS, parser state and sequence numbers */
+mavlink_status_t m_mavlink_status[MAVLINK_COMM_NUM_BUFFERS];
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                 *
+ ******************************************************************************/
+static void reserve(uint8_t urgent);
+static uint8_t is_urgent(const uint8_t *header, uint16_t length);
+static void commit(uint8_t port, uint16_t length);
+static void restamp_start(const uint8_t *header, uint16_t length);
+static void restamp(uint8_t port, uint16_t offset, uint16_t length);
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function Mavlink_tx_start(mavlink_channel_t chan, uint16_t length)
+ * @param chan, MAVLINK_TX_RADIO, MAVLINK_TX_USB or MAVLINK_TX_ALL
+ * @param length, bytes in the whole frame
+ * @return none
+ * @brief MAVLINK_START_UART_SEND, the frame is reserved in each port with its
+ * header, which names the message and so its class
+ * @author Aaron Hunter */
+void Mavlink_tx_start(mavlink_channel_t chan, uint16_t length) {
+    span[MAVLINK_TX_RADIO] = NULL;
+    span[MAVLINK_TX_USB] = NULL;
+    span_chan = chan;
+    span_length = length;
+    span_fill = 0;
+}
+
+/**
+ * @Function Mavlink_tx_bytes(mavlink_channel_t chan, const uint8_t *data, uint16_t length)
+ * @param data, next part of the frame, the header first
+ * @param length, number of bytes
+ * @return none
+ * @brief MAVLINK_SEND_UART_BYTES, reserves the frame on the header, then
+ * copies the part into the reservations; the copies of a MAVLINK_TX_ALL frame
+ * get the sequence number of their port, so each link counts on without gaps
+ * @author Aaron Hunter */
+void Mavlink_tx_bytes(mavlink_channel_t chan, const uint8_t *data, uint16_t length) {
+    uint8_t port;
+
+    if (span_fill == 0) {
+        reserve(is_urgent(data, length));
+        restamp_start(data, length);
+    }
+    if (length > span_length - span_fill) {
+        length = span_length - span_fill; // never past the reservation
+    }
+    for (port = 0; port < MAVLINK_TX_PORTS; port++) {
+        if (span[port] != NULL) {
+            memcpy(span[port] + span_fill, data, length);
+            if (span_restamp == TRUE) {
+                restamp(port, span_fill, length);
+            }
+        }
+    }
+    span_fill += length;
+}
+
+/**
+ * @Function Mavlink_tx_end(mavlink_channel_t chan, uint16_t length)
+ * @param length, bytes in the whole frame
+ * @return none
+ * @brief MAVLINK_END_UART_SEND, commits the frame to each port
+ * @author Aaron Hunter */
+void Mavlink_tx_end(mavlink_channel_t chan, uint16_t length) {
+    /* a short frame is given back rather than sent cut */
+    length = span_fill == length ? length : 0;
+    commit(MAVLINK_TX_RADIO, length);
+    commit(MAVLINK_TX_USB, length);
+}
+
+/**
+ * @Function Mavlink_tx_space(uint8_t port)
+ * @param port, MAVLINK_TX_RADIO or MAVLINK_TX_USB
+ * @return bytes the port's block can take now from a frame that is not
+ * urgent, so a sender can skip a frame instead of having it dropped
+ * @author Aaron Hunter */
+uint16_t Mavlink_tx_space(uint8_t port) {
+    return port == MAVLINK_TX_RADIO ? Radio_tx_space(RADIO_TX_BULK) : Serial_tx_space(SERIAL_TX_BULK);
+}
+
+/**
+ * @Function Mavlink_tx_is_for_us(uint8_t target_system)
+ * @param target_system, from a command or request
+ * @return TRUE for mavlink_system.sysid or a broadcast
+ * @author Aaron Hunter */
+uint8_t Mavlink_tx_is_for_us(uint8_t target_system) {
+    return (target_system == 0 || target_system == mavlink_system.sysid);
+}
+
+/**
+ * @Function Mavlink_tx_get_stats(void)
+ * @return frames, bytes and drops per port since the last reset
+ * @author Aaron Hunter */
+const mavlink_tx_stats_t *Mavlink_tx_get_stats(void) {
+    return &stats;
+}
+
+/**
+ * @Function Mavlink_tx_reset_stats(void)
+ * @return none
+ * @author Aaron Hunter */
+void Mavlink_tx_reset_stats(void) {
+    memset(&stats, 0, sizeof (stats));
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/* reserve(uint8_t urgent)
+ * reserves the frame in each of its ports, a port without room drops it
+ */
+static void reserve(uint8_t urgent) {
+    if (span_chan == MAVLINK_TX_RADIO || span_chan == MAVLINK_TX_ALL) {
+        span[MAVLINK_TX_RADIO] = Radio_reserve(span_length,
+                urgent == TRUE ? RADIO_TX_URGENT : RADIO_TX_BULK);
+        if (span[MAVLINK_TX_RADIO] == NULL) {
+            stats.dropped[MAVLINK_TX_RADIO]++;
+        }
+    }
+    if (span_chan == MAVLINK_TX_USB || span_chan == MAVLINK_TX_ALL) {
+        span[MAVLINK_TX_USB] = Serial_reserve(span_length,
+                urgent == TRUE ? SERIAL_TX_URGENT : SERIAL_TX_BULK);
+        if (span[MAVLINK_TX_USB] == NULL) {
+            stats.dropped[MAVLINK_TX_USB]++;
+        }
+    }
+}
+
+/* is_urgent(const uint8_t *header, uint16_t length)
+ * TRUE if the MAVLink 2 or 1 header names a message in urgent_ids
+ */
+static uint8_t is_urgent(const uint8_t *header, uint16_t length) {
+    uint32_t msgid;
+    uint8_t i;
+
+    if (length >= MAVLINK_NUM_HEADER_BYTES && header[0] == MAVLINK_STX) {
+        msgid = header[7] | ((uint32_t) header[8] << 8) | ((uint32_t) header[9] << 16);
+    } else if (length > MAVLINK_CORE_HEADER_MAVLINK1_LEN && header[0] == MAVLINK_STX_MAVLINK1) {
+        msgid = header[5];
+    } else {
+        return FALSE;
+    }
+    for (i = 0; i < NUM_URGENT_IDS; i++) {
+        if (urgent_ids[i] == msgid) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/* commit(uint8_t port, uint16_t length)
+ * hands the port's reservation to its DMA, 0 gives it back
+ */
+static void commit(uint8_t port, uint16_t length) {
+    if (span[port] == NULL) {
+        return;
+    }
+    if (port == MAVLINK_TX_RADIO) {
+        Radio_commit(length);
+    } else {
+        Serial_commit(length);
+    }
+    span[port] = NULL;
+    if (length > 0) {
+        stats.frames[port]++;
+        stats.bytes[port] += length;
+    } else {
+        stats.dropped[port]++;
+    }
+}
+
+/* restamp_start(const uint8_t *header, uint16_t length)
+ * on the header of a MAVLINK_TX_ALL frame, takes the next sequence number of
+ * each port, as a frame sent to the port alone would; a signed frame keeps
+ * the one it has, its signature covers it
+ */
+static void restamp_start(const uint8_t *header, uint16_t length) {
+    const mavlink_msg_entry_t *entry;
+    uint32_t msgid;
+    uint8_t port;
+
+    span_restamp = FALSE;
+    if (span_chan != MAVLINK_TX_ALL) {
+        return;
+    }
+    if (length >= MAVLINK_NUM_HEADER_BYTES && header[0] == MAVLINK_STX
+            && (header[2] & MAVLINK_IFLAG_SIGNED) == 0) {
+        msgid = header[7] | ((uint32_t) header[8] << 8) | ((uint32_t) header[9] << 16);
+        span_seq_at = 4;
+        span_crc_at = MAVLINK_NUM_HEADER_BYTES + header[1];
+    } else if (length > MAVLINK_CORE_HEADER_MAVLINK1_LEN && header[0] == MAVLINK_STX_MAVLINK1) {
+        msgid = header[5];
+        span_seq_at = 2;
+        span_crc_at = MAVLINK_CORE_HEADER_MAVLINK1_LEN + 1 + header[1];
+    } else {
+        return;
+    }
+    entry = mavlink_get_msg_entry(msgid);
+    if (entry == NULL) {
+        return;
+    }
+    span_crc_extra = entry->crc_extra;
+    for (port = 0; port < MAVLINK_TX_PORTS; port++) {
+        span_seq[port] = m_mavlink_status[port].current_tx_seq++;
+        crc_init(&span_crc[port]);
+    }
+    span_restamp = TRUE;
+}
+
+/* restamp(uint8_t port, uint16_t offset, uint16_t length)
+ * puts the port's sequence number into the bytes just copied to the port and
+ * runs them through its checksum, which replaces the frame's
+ */
+static void restamp(uint8_t port, uint16_t offset, uint16_t length) {
+    uint8_t *frame = span[port];
+    uint16_t i;
+
+    for (i = offset; i < offset + length; i++) {
+        if (i == span_seq_at) {
+            frame[i] = span_seq[port];
+        }
+        if (i > 0 && i < span_crc_at) { // the magic is not in the checksum
+            crc_accumulate(frame[i], &span_crc[port]);
+        } else if (i == span_crc_at) {
+            crc_accumulate(span_crc_extra, &span_crc[port]);
+            frame[i] = (uint8_t) span_crc[port];
+        } else if (i == span_crc_at + 1) {
+            frame[i] = (uint8_t) (span_crc[port] >> 8);
+        }
+    }
+}
+
+#ifdef MAVLINK_TX_TESTING
+#include "System_timer.h"
+#include <stdio.h>
+
+#define REPEAT 100
+#define STACK_PAINT_BYTES 3072
+#define STACK_PAINT 0xA5
+#define STACK_MARGIN 64 // left for the frame that paints
+
+mavlink_system_t mavlink_system = {
+    1, // System ID (1-255)
+    MAV_COMP_ID_AUTOPILOT1 // Component ID (a MAV_COMPONENT value)
+};
+
+/* the publish path before: message, serialize buffer and a copy */
+static void send_packed(void) {
+    mavlink_message_t msg_tx;
+    uint8_t msg_buffer[1024];
+    uint16_t msg_length;
+
+    mavlink_msg_highres_imu_pack(mavlink_system.sysid, mavlink_system.compid,
+            &msg_tx, Sys_timer_get_usec64(), 0.01, 0.02, -9.8, 0.1, 0.2, 0.3,
+            0.2, 0.0, 0.4, 0.0, 0.0, 0.0, 25.0, 0, 0);
+    msg_length = mavlink_msg_to_send_buffer(msg_buffer, &msg_tx);
+    Serial_write(msg_buffer, msg_length);
+}
+
+/* built in place in the USB block */
+static void send_direct(void) {
+    mavlink_msg_highres_imu_send(MAVLINK_TX_USB, Sys_timer_get_usec64(),
+            0.01, 0.02, -9.8, 0.1, 0.2, 0.3, 0.2, 0.0, 0.4, 0.0, 0.0, 0.0, 25.0,
+            0, 0);
+}
+
+/* built once, both ports */
+static void send_both(void) {
+    mavlink_msg_highres_imu_send(MAVLINK_TX_ALL, Sys_timer_get_usec64(),
+            0.01, 0.02, -9.8, 0.1, 0.2, 0.3, 0.2, 0.0, 0.4, 0.0, 0.0, 0.0, 25.0,
+            0, 0);
+}
+
+/* deepest stack fn() uses: paints the free stack below this frame, calls it
+ * and finds the lowest byte it changed */
+static uint32_t stack_use(void (*fn)(void)) {
+    volatile uint8_t *top = (uint8_t *) __builtin_frame_address(0) - STACK_MARGIN;
+    uint32_t i;
+
+    for (i = 1; i <= STACK_PAINT_BYTES; i++) {
+        top[-i] = STACK_PAINT;
+    }
+    fn();
+    for (i = STACK_PAINT_BYTES; i > 0 && top[-i] == STACK_PAINT; i--) {
+        ;
+    }
+    return i;
+}
+
+/* mean core timer counts of fn(), waiting for the DMA between calls so a full
+ * block never turns a send into a drop */
+static uint32_t core_counts(void (*fn)(void)) {
+    uint32_t start;
+    uint32_t sum = 0;
+    uint16_t i;
+
+    for (i = 0; i < REPEAT; i++) {
+        while (Serial_tx_idle() == FALSE || Radio_tx_idle() == FALSE) {
+            ;
+        }
+        start = Sys_timer_get_core();
+        fn();
+        sum += Sys_timer_get_core() - start;
+    }
+    return sum / REPEAT;
+}
+
+static void report(const char *name, void (*fn)(void)) {
+    uint32_t counts = core_counts(fn);
+    uint32_t stack = stack_use(fn);
+
+    while (Serial_tx_idle() == FALSE) {
+        ;
+    }
+    printf("\r\n%-8s stack %4u bytes, %5u cycles, %3u.%02u usec\r\n", name,
+            stack, 2 * counts, counts / SYS_TIMER_CORE_PER_USEC,
+            counts % SYS_TIMER_CORE_PER_USEC * 100 / SYS_TIMER_CORE_PER_USEC);
+}
+
+int main(void) {
+    const mavlink_tx_stats_t *tx;
+
+    Board_init();
+    Serial_init();
+    Radio_serial_init();
+    Sys_timer_init();
+    printf("\r\nMavlink_tx HIGHRES_IMU test harness %s, %s\r\n", __DATE__, __TIME__);
+    report("packed", send_packed);
+    report("direct", send_direct);
+    report("both", send_both);
+    tx = Mavlink_tx_get_stats();
+    printf("\r\nUSB %u frames %u bytes %u dropped, radio %u frames %u bytes %u dropped\r\n",
+            tx->frames[MAVLINK_TX_USB], tx->bytes[MAVLINK_TX_USB],
+            tx->dropped[MAVLINK_TX_USB], tx->frames[MAVLINK_TX_RADIO],
+            tx->bytes[MAVLINK_TX_RADIO], tx->dropped[MAVLINK_TX_RADIO]);
+    while (1) {
+        ;
+    }
+    return 0;
+}
+#endif //MAVLINK_TX_TESTING
@@ -0,0 +1,118 @@
+/*
+ * File:   Mavlink_tx.h
+ * Brief: Zero-copy MAVLink transmit.  Include this instead of
+ * common/mavlink.h: it turns on the MAVLink convenience functions and points
+ * their UART hooks here, so mavlink_msg_xxx_send(chan, ...) packs only the
+ * payload on the stack, then writes the header, payload and CRC straight into
+ * space reserved in the port's DMA block and commits them as one frame.  No
+ * mavlink_message_t and no serialize buffer, and a frame sent on
+ * MAVLINK_TX_ALL is built once and lands in both ports, each copy with the
+ * sequence number and checksum of its port.  A port without room for the
+ * whole frame drops it and counts it.  Heartbeats, acks, parameter and
+ * interval replies, status text and HIL outputs go out urgent and may use the
+ * headroom each port keeps in its block, so a link full of sensor streams
+ * drops streams first.  Main loop only, not from interrupts.  The app defines
+ * mavlink_system.
+ * Created on 10/16/2026
+ * Modified on 10/17/2026
+ */
+
+#ifndef MAVLINK_TX_H // Header guard
+#define	MAVLINK_TX_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+#include <stdint.h>
+#include "mavlink_types.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+/* a link's transmit channel is also the channel its parser uses */
+#define MAVLINK_TX_RADIO MAVLINK_COMM_0
+#define MAVLINK_TX_USB MAVLINK_COMM_1
+#define MAVLINK_TX_ALL MAVLINK_COMM_2 // one frame, both ports
+#define MAVLINK_TX_PORTS 2 // stats index MAVLINK_TX_RADIO or MAVLINK_TX_USB
+
+#define MAVLINK_USE_CONVENIENCE_FUNCTIONS
+/* one status per channel for every file, so the sequence numbers run on */
+#define MAVLINK_EXTERNAL_RX_STATUS
+#define MAVLINK_START_UART_SEND(chan, length) Mavlink_tx_start(chan, length)
+#define MAVLINK_SEND_UART_BYTES(chan, buf, length) Mavlink_tx_bytes(chan, buf, length)
+#define MAVLINK_END_UART_SEND(chan, length) Mavlink_tx_end(chan, length)
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+typedef struct {
+    uint32_t frames[MAVLINK_TX_PORTS]; // committed to the port
+    uint32_t bytes[MAVLINK_TX_PORTS];
+    uint32_t dropped[MAVLINK_TX_PORTS]; // no room in the port's block
+} mavlink_tx_stats_t;
+
+extern mavlink_system_t mavlink_system;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function Mavlink_tx_start(mavlink_channel_t chan, uint16_t length)
+ * @param chan, MAVLINK_TX_RADIO, MAVLINK_TX_USB or MAVLINK_TX_ALL
+ * @param length, bytes in the whole frame
+ * @return none
+ * @brief MAVLINK_START_UART_SEND, the frame is reserved in each port with its
+ * header, which names the message and so its class
+ * @author Aaron Hunter */
+void Mavlink_tx_start(mavlink_channel_t chan, uint16_t length);
+
+/**
+ * @Function Mavlink_tx_bytes(mavlink_channel_t chan, const uint8_t *data, uint16_t length)
+ * @param data, next part of the frame, the header first
+ * @param length, number of bytes
+ * @return none
+ * @brief MAVLINK_SEND_UART_BYTES, reserves the frame on the header, then
+ * copies the part into the reservations
+ * @author Aaron Hunter */
+void Mavlink_tx_bytes(mavlink_channel_t chan, const uint8_t *data, uint16_t length);
+
+/**
+ * @Function Mavlink_tx_end(mavlink_channel_t chan, uint16_t length)
+ * @param length, bytes in the whole frame
+ * @return none
+ * @brief MAVLINK_END_UART_SEND, commits the frame to each port
+ * @author Aaron Hunter */
+void Mavlink_tx_end(mavlink_channel_t chan, uint16_t length);
+
+/**
+ * @Function Mavlink_tx_space(uint8_t port)
+ * @param port, MAVLINK_TX_RADIO or MAVLINK_TX_USB
+ * @return bytes the port's block can take now from a frame that is not
+ * urgent, so a sender can skip a frame instead of having it dropped
+ * @author Aaron Hunter */
+uint16_t Mavlink_tx_space(uint8_t port);
+
+/**
+ * @Function Mavlink_tx_is_for_us(uint8_t target_system)
+ * @param target_system, from a command or request
+ * @return TRUE for mavlink_system.sysid or a broadcast
+ * @author Aaron Hunter */
+uint8_t Mavlink_tx_is_for_us(uint8_t target_system);
+
+/**
+ * @Function Mavlink_tx_get_stats(void)
+ * @return frames, bytes and drops per port since the last reset
+ * @author Aaron Hunter */
+const mavlink_tx_stats_t *Mavlink_tx_get_stats(void);
+
+/**
+ * @Function Mavlink_tx_reset_stats(void)
+ * @return none
+ * @author Aaron Hunter */
+void Mavlink_tx_reset_stats(void);
+
+/* the send functions call the hooks above, so the messages come last */
+#include "common/mavlink.h"
+
+#endif	/* MAVLINK_TX_H */ // End of header guard
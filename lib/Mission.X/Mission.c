@@ -0,0 +1,588 @@
+/*
+ * File:   Mission.c
+ * Brief: MAVLink mission store, see Mission.h.  The MISSION_TESTING harness
+ * writes a mission of TEST_ITEMS items, loads it again and walks through it,
+ * printing the longest Mission_run() and any item that reads back wrong.
+ * Created on 10/16/2026
+ * Modified on 10/17/2026
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+
+#include "Mission.h" // The header file for this source file.
+#include "Board.h"
+#include "EEPROM2.h"
+#include "System_timer.h"
+#include <string.h>
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#define MISSION_MAGIC 0x4D534E31 // "MSN1", the header page holds a mission
+#define HEADER_LENGTH 2 // magic and item count, int32
+#define WINDOW_MASK (MISSION_WINDOW - 1)
+
+/*******************************************************************************
+ * PRIVATE VARIABLES                                                           *
+ ******************************************************************************/
+static uint8_t nav_frame = MAV_FRAME_LOCAL_NED;
+static uint16_t count = 0; // items stored, 0 during an upload
+static uint16_t current = 0;
+/* items window_start to window_start + filled - 1, by seq & WINDOW_MASK */
+static mission_item_t window[MISSION_WINDOW];
+static uint16_t window_start = 0;
+static uint8_t filled = 0;
+/* upload */
+static uint8_t uploading = FALSE;
+static uint16_t upload_count = 0;
+static uint16_t expected = 0; // next item to ask for
+static mission_item_t incoming;
+static uint8_t item_pending = FALSE; // incoming is to be written
+static uint32_t request_time = 0; // msec
+static uint8_t retries = 0;
+/* header write, and the MISSION_ACK that waits for it */
+static uint8_t header_pending = FALSE;
+static uint8_t ack_pending = FALSE;
+static uint8_t ack_result = MAV_MISSION_ACCEPTED;
+static uint8_t write_busy = FALSE; // the EEPROM is committing a page write
+/* the system an upload, clear or download is for */
+static uint8_t peer_port = MAVLINK_TX_USB;
+static uint8_t peer_system = 0;
+static uint8_t peer_component = 0;
+/* download */
+static uint8_t download_pending = FALSE;
+static uint16_t download_seq = 0;
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                 *
+ ******************************************************************************/
+static int8_t read_item(uint16_t seq, mission_item_t *item);
+static int8_t write_item(uint16_t seq, mission_item_t *item);
+static int8_t write_header(void);
+static void set_peer(const mavlink_message_t *msg, uint8_t port);
+static void start_store(uint16_t items);
+static void cancel_upload(uint8_t result);
+static void request_item(uint16_t seq);
+static void send_item(uint16_t seq, const mission_item_t *item);
+static void send_ack(uint8_t port, uint8_t system, uint8_t component, uint8_t result);
+static void send_count(uint8_t port, uint8_t system, uint8_t component);
+static void send_current(uint8_t port);
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function Mission_init(uint8_t frame)
+ * @param frame, the MAV_FRAME the app navigates in, uploads of items in any
+ * other frame but MAV_FRAME_MISSION are refused
+ * @return SUCCESS or ERROR if the EEPROM holds no mission, the store is then
+ * empty
+ * @brief reads the item count from the EEPROM, the window fills on the next
+ * Mission_run() calls; call after EEPROM_init() and Sys_timer_init()
+ * @author Aaron Hunter */
+int8_t Mission_init(uint8_t frame) {
+    int32_t header[HEADER_LENGTH];
+
+    nav_frame = frame;
+    count = 0;
+    current = 0;
+    window_start = 0;
+    filled = 0;
+    uploading = FALSE;
+    item_pending = FALSE;
+    header_pending = FALSE;
+    ack_pending = FALSE;
+    write_busy = FALSE;
+    download_pending = FALSE;
+    if (EEPROM_read_int_array(header, HEADER_LENGTH, MISSION_HEADER_PAGE, 0) == ERROR
+            || header[0] != MISSION_MAGIC || header[1] < 0 || header[1] > MISSION_MAX_ITEMS) {
+        return ERROR; // blank or another user's EEPROM
+    }
+    count = header[1];
+    return SUCCESS;
+}
+
+/**
+ * @Function Mission_handle_msg(const mavlink_message_t *msg, uint8_t port)
+ * @param msg, message parsed from port
+ * @param port, MAVLINK_TX_RADIO or MAVLINK_TX_USB
+ * @return TRUE if the message was a mission message for this system and was
+ * consumed, FALSE to let the app handle it
+ * @brief MISSION_COUNT starts an upload and MISSION_REQUEST_LIST a download
+ * on the port, MISSION_CLEAR_ALL and MISSION_SET_CURRENT are answered at once
+ * @author Aaron Hunter */
+uint8_t Mission_handle_msg(const mavlink_message_t *msg, uint8_t port) {
+    mavlink_mission_count_t mission_count;
+    mavlink_mission_item_int_t item;
+    mavlink_mission_request_int_t request;
+    mavlink_mission_request_list_t list;
+    mavlink_mission_clear_all_t clear;
+    mavlink_mission_set_current_t set_current;
+
+    if (port >= MAVLINK_TX_PORTS) {
+        return FALSE;
+    }
+    switch (msg->msgid) {
+        case MAVLINK_MSG_ID_MISSION_COUNT:
+            mavlink_msg_mission_count_decode(msg, &mission_count);
+            if (Mavlink_tx_is_for_us(mission_count.target_system) == FALSE) {
+                return FALSE;
+            }
+            if (mission_count.mission_type != MAV_MISSION_TYPE_MISSION) {
+                send_ack(port, msg->sysid, msg->compid, MAV_MISSION_UNSUPPORTED);
+            } else if (mission_count.count > MISSION_MAX_ITEMS) {
+                send_ack(port, msg->sysid, msg->compid, MAV_MISSION_NO_SPACE);
+            } else {
+                /* a new count restarts an upload in progress */
+                set_peer(msg, port);
+                start_store(mission_count.count);
+            }
+            return TRUE;
+        case MAVLINK_MSG_ID_MISSION_ITEM_INT:
+            mavlink_msg_mission_item_int_decode(msg, &item);
+            if (Mavlink_tx_is_for_us(item.target_system) == FALSE) {
+                return FALSE;
+            }
+            if (uploading == FALSE || item_pending == TRUE || item.seq != expected) {
+                return TRUE; // a repeat, the item asked for comes on a retry
+            }
+            if (item.frame != nav_frame && item.frame != MAV_FRAME_MISSION) {
+                cancel_upload(MAV_MISSION_UNSUPPORTED_FRAME);
+                return TRUE;
+            }
+            incoming.param1 = item.param1;
+            incoming.param2 = item.param2;
+            incoming.param3 = item.param3;
+            incoming.param4 = item.param4;
+            incoming.x = item.x;
+            incoming.y = item.y;
+            incoming.z = item.z;
+            incoming.command = item.command;
+            incoming.frame = item.frame;
+            incoming.autocontinue = item.autocontinue;
+            item_pending = TRUE;
+            return TRUE;
+        case MAVLINK_MSG_ID_MISSION_REQUEST_LIST:
+            mavlink_msg_mission_request_list_decode(msg, &list);
+            if (Mavlink_tx_is_for_us(list.target_system) == FALSE) {
+                return FALSE;
+            }
+            if (list.mission_type != MAV_MISSION_TYPE_MISSION) {
+                send_ack(port, msg->sysid, msg->compid, MAV_MISSION_UNSUPPORTED);
+            } else {
+                send_count(port, msg->sysid, msg->compid);
+            }
+            return TRUE;
+        case MAVLINK_MSG_ID_MISSION_REQUEST_INT:
+        case MAVLINK_MSG_ID_MISSION_REQUEST:
+            /* MISSION_REQUEST has the same fields, both are answered with
+             * MISSION_ITEM_INT */
+            mavlink_msg_mission_request_int_decode(msg, &request);
+            if (Mavlink_tx_is_for_us(request.target_system) == FALSE) {
+                return FALSE;
+            }
+            if (request.seq >= count) {
+                send_ack(port, msg->sysid, msg->compid, MAV_MISSION_INVALID_SEQUENCE);
+            } else {
+                set_peer(msg, port);
+                download_seq = request.seq;
+                download_pending = TRUE;
+            }
+            return TRUE;
+        case MAVLINK_MSG_ID_MISSION_ACK:
+            return TRUE; // the end of a download, nothing to do
+        case MAVLINK_MSG_ID_MISSION_CLEAR_ALL:
+            mavlink_msg_mission_clear_all_decode(msg, &clear);
+            if (Mavlink_tx_is_for_us(clear.target_system) == FALSE) {
+                return FALSE;
+            }
+            if (clear.mission_type != MAV_MISSION_TYPE_MISSION && clear.mission_type != MAV_MISSION_TYPE_ALL) {
+                send_ack(port, msg->sysid, msg->compid, MAV_MISSION_UNSUPPORTED);
+            } else {
+                set_peer(msg, port);
+                start_store(0);
+            }
+            return TRUE;
+        case MAVLINK_MSG_ID_MISSION_SET_CURRENT:
+            mavlink_msg_mission_set_current_decode(msg, &set_current);
+            if (Mavlink_tx_is_for_us(set_current.target_system) == FALSE) {
+                return FALSE;
+            }
+            if (Mission_set_current(set_current.seq) == ERROR) {
+                send_current(port); // the unchanged item
+            }
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+/**
+ * @Function Mission_run(void)
+ * @return none
+ * @brief does at most one EEPROM transfer: starts the write of an uploaded
+ * item and asks for the next, sends a requested item or reads the next item
+ * into the window; asks again for an upload item that is late.  A write
+ * returns before the EEPROM commits it, the calls after that poll the EEPROM
+ * once each and do nothing else until it is done.
+ * @author Aaron Hunter */
+void Mission_run(void) {
+    mission_item_t item;
+    uint16_t seq;
+
+    if (write_busy == TRUE) {
+        if (EEPROM_is_busy() == TRUE) {
+            return;
+        }
+        write_busy = FALSE;
+    }
+    if (header_pending == TRUE) {
+        header_pending = FALSE;
+        if (write_header() == ERROR) {
+            ack_result = MAV_MISSION_ERROR;
+        } else {
+            write_busy = TRUE;
+            return; // the ack goes once the header is in
+        }
+    }
+    if (ack_pending == TRUE) {
+        ack_pending = FALSE;
+        send_ack(peer_port, peer_system, peer_component, ack_result);
+        return;
+    }
+    if (item_pending == TRUE) {
+        item_pending = FALSE;
+        if (write_item(expected, &incoming) == ERROR) {
+            cancel_upload(MAV_MISSION_ERROR);
+            return;
+        }
+        write_busy = TRUE;
+        expected++;
+        if (expected < upload_count) {
+            retries = 0;
+            request_item(expected);
+        } else {
+            /* the count goes in last, so a reset mid upload leaves no
+             * half a mission */
+            uploading = FALSE;
+            count = upload_count;
+            header_pending = TRUE;
+            ack_pending = TRUE;
+            ack_result = MAV_MISSION_ACCEPTED;
+        }
+        return;
+    }
+    if (uploading == TRUE) {
+        if (Sys_timer_get_msec() - request_time > MISSION_TIMEOUT) {
+            if (++retries > MISSION_RETRIES) {
+                cancel_upload(MAV_MISSION_OPERATION_CANCELLED);
+            } else {
+                request_item(expected);
+            }
+        }
+        return;
+    }
+    if (download_pending == TRUE) {
+        download_pending = FALSE;
+        if (Mission_get_item(download_seq) != NULL) {
+            send_item(download_seq, Mission_get_item(download_seq));
+        } else if (read_item(download_seq, &item) == SUCCESS) {
+            send_item(download_seq, &item);
+        }
+        return;
+    }
+    /* prefetch, one item a call until the window is full */
+    seq = window_start + filled;
+    if (filled < MISSION_WINDOW && seq < count) {
+        if (read_item(seq, &window[seq & WINDOW_MASK]) == SUCCESS) {
+            filled++;
+        }
+    }
+}
+
+/**
+ * @Function Mission_get_count(void)
+ * @return items in the mission, 0 while an upload is in progress
+ * @author Aaron Hunter */
+uint16_t Mission_get_count(void) {
+    return count;
+}
+
+/**
+ * @Function Mission_get_current(void)
+ * @return sequence number of the current item
+ * @author Aaron Hunter */
+uint16_t Mission_get_current(void) {
+    return current;
+}
+
+/**
+ * @Function Mission_get_item(uint16_t seq)
+ * @param seq, sequence number of the item
+ * @return the item, NULL if it is not in the window yet
+ * @author Aaron Hunter */
+const mission_item_t *Mission_get_item(uint16_t seq) {
+    if (seq < window_start || seq >= window_start + filled) {
+        return NULL;
+    }
+    return &window[seq & WINDOW_MASK];
+}
+
+/**
+ * @Function Mission_set_current(uint16_t seq)
+ * @param seq, sequence number of the new current item
+ * @return SUCCESS or ERROR if there is no such item
+ * @brief moves the window to seq and sends MISSION_CURRENT on both ports
+ * @author Aaron Hunter */
+int8_t Mission_set_current(uint16_t seq) {
+    if (seq >= count) {
+        return ERROR;
+    }
+    /* the items already read from seq on keep their slots */
+    if (seq >= window_start && seq < window_start + filled) {
+        filled -= seq - window_start;
+    } else {
+        filled = 0;
+    }
+    window_start = seq;
+    current = seq;
+    send_current(MAVLINK_TX_ALL);
+    return SUCCESS;
+}
+
+/**
+ * @Function Mission_next(void)
+ * @return SUCCESS or ERROR if the current item was the last
+ * @brief sends MISSION_ITEM_REACHED for the current item and makes the next
+ * one current
+ * @author Aaron Hunter */
+int8_t Mission_next(void) {
+    mavlink_mission_item_reached_t reached;
+
+    reached.seq = current;
+    mavlink_msg_mission_item_reached_send_struct(MAVLINK_TX_ALL, &reached);
+    return Mission_set_current(current + 1);
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/* read_item(uint16_t seq, mission_item_t *item)
+ * the item from its half page, SUCCESS or ERROR
+ */
+static int8_t read_item(uint16_t seq, mission_item_t *item) {
+    return EEPROM_read_byte_array((uint8_t *) item, sizeof (mission_item_t),
+            MISSION_HEADER_PAGE + 1 + seq / MISSION_ITEMS_PER_PAGE,
+            (seq % MISSION_ITEMS_PER_PAGE) * sizeof (mission_item_t));
+}
+
+/* write_item(uint16_t seq, mission_item_t *item)
+ * starts the write of the item to its half page, SUCCESS or ERROR
+ */
+static int8_t write_item(uint16_t seq, mission_item_t *item) {
+    return EEPROM_start_write_byte_array((uint8_t *) item, sizeof (mission_item_t),
+            MISSION_HEADER_PAGE + 1 + seq / MISSION_ITEMS_PER_PAGE,
+            (seq % MISSION_ITEMS_PER_PAGE) * sizeof (mission_item_t));
+}
+
+/* write_header(void)
+ * starts the write of the magic and the item count to the header page
+ */
+static int8_t write_header(void) {
+    int32_t header[HEADER_LENGTH] = {MISSION_MAGIC, count};
+
+    return EEPROM_start_write_byte_array((uint8_t *) header, sizeof (header),
+            MISSION_HEADER_PAGE, 0);
+}
+
+/* set_peer(const mavlink_message_t *msg, uint8_t port)
+ * the replies go to the sender of msg on port
+ */
+static void set_peer(const mavlink_message_t *msg, uint8_t port) {
+    peer_port = port;
+    peer_system = msg->sysid;
+    peer_component = msg->compid;
+}
+
+/* start_store(uint16_t items)
+ * empties the store and asks for the first of items, with none the cleared
+ * header is acknowledged once written
+ */
+static void start_store(uint16_t items) {
+    count = 0; // the old mission is gone from the first write on
+    current = 0;
+    window_start = 0;
+    filled = 0;
+    download_pending = FALSE;
+    item_pending = FALSE;
+    header_pending = TRUE;
+    upload_count = items;
+    expected = 0;
+    retries = 0;
+    if (items == 0) {
+        uploading = FALSE;
+        ack_pending = TRUE;
+        ack_result = MAV_MISSION_ACCEPTED;
+    } else {
+        uploading = TRUE;
+        ack_pending = FALSE;
+        request_item(0);
+    }
+}
+
+/* cancel_upload(uint8_t result)
+ * stops the upload and sends result, the store is left empty
+ */
+static void cancel_upload(uint8_t result) {
+    uploading = FALSE;
+    item_pending = FALSE;
+    send_ack(peer_port, peer_system, peer_component, result);
+}
+
+/* request_item(uint16_t seq)
+ * MISSION_REQUEST_INT for an upload item, the timeout starts over
+ */
+static void request_item(uint16_t seq) {
+    mavlink_mission_request_int_t request;
+
+    memset(&request, 0, sizeof (request));
+    request.target_system = peer_system;
+    request.target_component = peer_component;
+    request.seq = seq;
+    request.mission_type = MAV_MISSION_TYPE_MISSION;
+    mavlink_msg_mission_request_int_send_struct(peer_port, &request);
+    request_time = Sys_timer_get_msec();
+}
+
+/* send_item(uint16_t seq, const mission_item_t *item)
+ * MISSION_ITEM_INT of a download
+ */
+static void send_item(uint16_t seq, const mission_item_t *item) {
+    mavlink_mission_item_int_t message;
+
+    memset(&message, 0, sizeof (message));
+    message.target_system = peer_system;
+    message.target_component = peer_component;
+    message.seq = seq;
+    message.frame = item->frame;
+    message.command = item->command;
+    message.current = (seq == current);
+    message.autocontinue = item->autocontinue;
+    message.param1 = item->param1;
+    message.param2 = item->param2;
+    message.param3 = item->param3;
+    message.param4 = item->param4;
+    message.x = item->x;
+    message.y = item->y;
+    message.z = item->z;
+    message.mission_type = MAV_MISSION_TYPE_MISSION;
+    mavlink_msg_mission_item_int_send_struct(peer_port, &message);
+}
+
+/* send_ack(uint8_t port, uint8_t system, uint8_t component, uint8_t result)
+ * MISSION_ACK with a MAV_MISSION_RESULT
+ */
+static void send_ack(uint8_t port, uint8_t system, uint8_t component, uint8_t result) {
+    mavlink_mission_ack_t ack;
+
+    memset(&ack, 0, sizeof (ack));
+    ack.target_system = system;
+    ack.target_component = component;
+    ack.type = result;
+    ack.mission_type = MAV_MISSION_TYPE_MISSION;
+    mavlink_msg_mission_ack_send_struct(port, &ack);
+}
+
+/* send_count(uint8_t port, uint8_t system, uint8_t component)
+ * MISSION_COUNT, the start of a download
+ */
+static void send_count(uint8_t port, uint8_t system, uint8_t component) {
+    mavlink_mission_count_t mission_count;
+
+    memset(&mission_count, 0, sizeof (mission_count));
+    mission_count.target_system = system;
+    mission_count.target_component = component;
+    mission_count.count = count;
+    mission_count.mission_type = MAV_MISSION_TYPE_MISSION;
+    mavlink_msg_mission_count_send_struct(port, &mission_count);
+}
+
+/* send_current(uint8_t port)
+ * MISSION_CURRENT
+ */
+static void send_current(uint8_t port) {
+    mavlink_mission_current_t mission_current;
+
+    memset(&mission_current, 0, sizeof (mission_current));
+    mission_current.seq = current;
+    mavlink_msg_mission_current_send_struct(port, &mission_current);
+}
+
+#ifdef MISSION_TESTING
+#include "SerialM32.h"
+#include "Radio_serial.h"
+#include <stdio.h>
+
+#define TEST_ITEMS 200
+
+mavlink_system_t mavlink_system = {
+    1, // System ID (1-255)
+    MAV_COMP_ID_AUTOPILOT1 // Component ID (a MAV_COMPONENT value)
+};
+
+int main(void) {
+    mission_item_t item;
+    const mission_item_t *stored;
+    uint32_t start;
+    uint32_t longest = 0;
+    uint16_t bad = 0;
+    uint16_t seq;
+
+    Board_init();
+    Serial_init();
+    Radio_serial_init();
+    Sys_timer_init();
+    EEPROM_init();
+    printf("\r\nMission test harness %s, %s\r\n", __DATE__, __TIME__);
+    /* the writes an upload makes */
+    memset(&item, 0, sizeof (item));
+    item.command = MAV_CMD_NAV_WAYPOINT;
+    item.frame = MAV_FRAME_LOCAL_NED;
+    for (seq = 0; seq < TEST_ITEMS; seq++) {
+        item.x = seq;
+        item.y = -seq;
+        write_item(seq, &item);
+    }
+    count = TEST_ITEMS;
+    write_header();
+    printf("init %s, %u items\r\n", Mission_init(MAV_FRAME_LOCAL_NED) == SUCCESS ? "SUCCESS" : "ERROR",
+            Mission_get_count());
+    seq = 0;
+    while (seq < TEST_ITEMS) {
+        start = Sys_timer_get_usec();
+        Mission_run();
+        if (Sys_timer_get_usec() - start > longest) {
+            longest = Sys_timer_get_usec() - start;
+        }
+        stored = Mission_get_item(seq);
+        if (stored != NULL) {
+            if (stored->x != seq || stored->y != -seq) {
+                bad++;
+            }
+            seq++;
+            if (seq < TEST_ITEMS) {
+                Mission_set_current(seq);
+            }
+        }
+    }
+    printf("%u items read, %u bad, longest Mission_run() %u usec\r\n", seq, bad, longest);
+    while (1) {
+        ;
+    }
+    return 0;
+}
+#endif //MISSION_TESTING
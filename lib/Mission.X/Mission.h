@@ -0,0 +1,126 @@
+/*
+ * File:   Mission.h
+ * Brief: MAVLink mission store.  Ground stations upload and download the
+ * mission with MISSION_COUNT, MISSION_REQUEST_INT, MISSION_ITEM_INT and
+ * MISSION_ACK, and the items are kept in the 24LC256 EEPROM through EEPROM2,
+ * two to a page after a header page, so a mission survives a reset and holds
+ * up to MISSION_MAX_ITEMS.  Only a window of the items from the current one
+ * on is kept in RAM.  The EEPROM library blocks on the I2C bus, so nothing
+ * touches it from the message handler: Mission_run() does at most one item
+ * transfer, the start of a write of an uploaded item or a read into the
+ * window, and polls the EEPROM rather than wait out its write cycle.  The app
+ * calls it from a scheduler task whose measured run holds it back when the
+ * control task is due.  Main loop only.
+ * Created on 10/16/2026
+ * Modified on 10/17/2026
+ */
+
+#ifndef MISSION_H // Header guard
+#define	MISSION_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+#include <stdint.h>
+#include "Mavlink_tx.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+#define MISSION_HEADER_PAGE 0 // EEPROM page of the item count, the items follow
+#define MISSION_PAGES 512 // 24LC256, 64 byte pages
+#define MISSION_ITEMS_PER_PAGE 2
+#define MISSION_MAX_ITEMS ((MISSION_PAGES - MISSION_HEADER_PAGE - 1) * MISSION_ITEMS_PER_PAGE)
+#define MISSION_WINDOW 8 // items kept in RAM, a power of two
+#define MISSION_TIMEOUT 1000 // msec for an upload item before it is asked for again
+#define MISSION_RETRIES 5 // requests of an item before the upload is cancelled
+#define MISSION_LOCAL_SCALE 1.0e-4 // meters per count of x and y in a local frame
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+/* an item as stored, 32 bytes, the fields of MISSION_ITEM_INT */
+typedef struct {
+    float param1;
+    float param2;
+    float param3;
+    float param4;
+    int32_t x; // local frames meters / MISSION_LOCAL_SCALE, global 1e-7 deg
+    int32_t y;
+    float z;
+    uint16_t command; // MAV_CMD
+    uint8_t frame; // MAV_FRAME
+    uint8_t autocontinue;
+} mission_item_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function Mission_init(uint8_t frame)
+ * @param frame, the MAV_FRAME the app navigates in, uploads of items in any
+ * other frame but MAV_FRAME_MISSION are refused
+ * @return SUCCESS or ERROR if the EEPROM holds no mission, the store is then
+ * empty
+ * @brief reads the item count from the EEPROM, the window fills on the next
+ * Mission_run() calls; call after EEPROM_init() and Sys_timer_init()
+ * @author Aaron Hunter */
+int8_t Mission_init(uint8_t frame);
+
+/**
+ * @Function Mission_handle_msg(const mavlink_message_t *msg, uint8_t port)
+ * @param msg, message parsed from port
+ * @param port, MAVLINK_TX_RADIO or MAVLINK_TX_USB
+ * @return TRUE if the message was a mission message for this system and was
+ * consumed, FALSE to let the app handle it
+ * @brief MISSION_COUNT starts an upload and MISSION_REQUEST_LIST a download
+ * on the port, MISSION_CLEAR_ALL and MISSION_SET_CURRENT are answered at once
+ * @author Aaron Hunter */
+uint8_t Mission_handle_msg(const mavlink_message_t *msg, uint8_t port);
+
+/**
+ * @Function Mission_run(void)
+ * @return none
+ * @brief does at most one EEPROM transfer: writes an uploaded item and asks
+ * for the next, sends a requested item or reads the next item into the
+ * window; asks again for an upload item that is late
+ * @author Aaron Hunter */
+void Mission_run(void);
+
+/**
+ * @Function Mission_get_count(void)
+ * @return items in the mission, 0 while an upload is in progress
+ * @author Aaron Hunter */
+uint16_t Mission_get_count(void);
+
+/**
+ * @Function Mission_get_current(void)
+ * @return sequence number of the current item
+ * @author Aaron Hunter */
+uint16_t Mission_get_current(void);
+
+/**
+ * @Function Mission_get_item(uint16_t seq)
+ * @param seq, sequence number of the item
+ * @return the item, NULL if it is not in the window yet
+ * @author Aaron Hunter */
+const mission_item_t *Mission_get_item(uint16_t seq);
+
+/**
+ * @Function Mission_set_current(uint16_t seq)
+ * @param seq, sequence number of the new current item
+ * @return SUCCESS or ERROR if there is no such item
+ * @brief moves the window to seq and sends MISSION_CURRENT on both ports
+ * @author Aaron Hunter */
+int8_t Mission_set_current(uint16_t seq);
+
+/**
+ * @Function Mission_next(void)
+ * @return SUCCESS or ERROR if the current item was the last
+ * @brief sends MISSION_ITEM_REACHED for the current item and makes the next
+ * one current
+ * @author Aaron Hunter */
+int8_t Mission_next(void);
+
+#endif	/* MISSION_H */ // End of header guard
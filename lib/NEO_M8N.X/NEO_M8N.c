@@ -13,9 +13,12 @@
 #include "NEO_M8N.h" // The header file for this source file. 
 #include "Board.h"   //Max32 setup
 #include "SerialM32.h"
+#include "System_timer.h"
+#include "Ring_buffer.h"
 #include "xc.h"
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
 #include <sys/attribs.h>
@@ -24,8 +27,7 @@
 /*******************************************************************************
  * PRIVATE #DEFINES                                                            *
  ******************************************************************************/
-#define BUFFER_LENGTH 512
-#define GPS_BUFFERSIZE 5  // how many NMEA msgs the buffer stores
+#define SENTENCE_RING_LENGTH 1024 // power of two, several sentences with their headers
 #define DEG2RAD M_PI/180.0
 #define RMC_ID "RMC"
 #define HOURS2SEC 3600
@@ -42,21 +44,11 @@
 /*******************************************************************************
  * PRIVATE TYPEDEFS                                                            *
  ******************************************************************************/
-typedef struct circular_buffer {
-    int read_index;
-    int write_index;
-    int size;
-    unsigned char data[BUFFER_LENGTH];
-} circular_buffer; /*circular  buffer */
-
-/*Buffer to place received messages*/
-typedef struct GPS_msg_buffer {
-    unsigned char payload[GPS_BUFFERSIZE][GPS_PAYLOADLENGTH];
-    unsigned char length[GPS_BUFFERSIZE];
-    unsigned char checksum[GPS_BUFFERSIZE];
-    int write_index;
-    int read_index;
-} GPS_msg_buffer;
+/*header of each received sentence in the ring, the payload follows it*/
+typedef struct {
+    uint64_t rx_time; //Sys_timer_get_ticks() at the '$'
+    uint8_t length; //payload bytes
+} GPS_sentence_t;
 
 typedef enum {
     WAITING_FOR_HEAD,
@@ -103,21 +95,21 @@ typedef enum {
 /*******************************************************************************
  * PRIVATE VARIABLES                                                            *
  ******************************************************************************/
-static struct circular_buffer U2_RX_buffer; //circular buffer for GPS strings
-static struct circular_buffer *rxp = &U2_RX_buffer; // pointer to U2_RX_buffer
-static struct GPS_msg_buffer incoming_msg_buffer;
-static struct GPS_msg_buffer *msg_buffer_p = &incoming_msg_buffer;
-static unsigned char reading_from_RX_buffer = FALSE;
-static unsigned char RX_collision = FALSE;
+/*sentences checked by the U2 ISR, parsed by the main loop*/
+static uint8_t sentence_data[SENTENCE_RING_LENGTH];
+static ring_buffer_t sentence_ring;
 static double NMEA_latitude = 0.0;
 static double NMEA_longitude = 0.0;
 static double NMEA_time = 0.0;
+static uint64_t head_time = 0; //receive time of the sentence coming in
+static uint64_t parse_time = 0; //receive time of the sentence being parsed
 struct GPS_data RMC_data = {
     .time = 0.0,
     .lat = 0.0,
     .lon = 0.0,
     .spd = 0.0,
-    .cog = 0.0
+    .cog = 0.0,
+    .rx_time = 0
 };
 static uint8_t is_data_valid = FALSE;
 static uint8_t is_data_new = FALSE;
@@ -132,22 +124,6 @@ static uint8_t is_data_new = FALSE;
  * @author Aaron Hunter
  * @modified  */
 static void __ISR(_UART_2_VECTOR, IPL3SOFT) UART2_interrupt_handler(void);
-/**
- * @Function void init_buffer(struct circular_buffer *buf);
- * @brief Initializes a new circular buffer
- * @note 
- * @author Aaron Hunter
- * @modified  */
-static void init_buffer(struct circular_buffer *buf);
-
-/**
- * @Function void initPacketBuffer(struct packetBuffer *buf)
- * @brief Initializes a new packet buffer
- * @note 
- * @author Aaron Hunter
- * @modified  */
-static void init_msg_buffer(struct GPS_msg_buffer *buf);
-
 /**
  * @Function void GPS_run_RX_state_machine(unsigned char charIn)
  * @param charIn, next character to process
@@ -225,9 +201,8 @@ static char RMC_storeData(void);
  * @brief sets up UART2 for communication and initializes GPS buffer
  * @author Aaron Hunter */
 int GPS_init(void) {
-    /*Initialize the circular buffers*/
-    init_buffer(rxp);
-    init_msg_buffer(msg_buffer_p);
+    /*Initialize the sentence ring*/
+    Ring_init(&sentence_ring, sentence_data, SENTENCE_RING_LENGTH);
 
     __builtin_disable_interrupts();
     U2MODEbits.UEN = 0; // TX/RX enabled, configure using software flow control
@@ -263,13 +238,10 @@ int GPS_init(void) {
  * @brief 
  * @author Aaron Hunter */
 char GPS_is_msg_avail(void) {
-    {
-        struct GPS_msg_buffer *buf = msg_buffer_p;
-        if (buf->read_index == buf->write_index) { //if read = write then the buffer is empty
-            return FALSE;
-        }
-        return TRUE;
+    if (Ring_count(&sentence_ring) == 0) {
+        return FALSE;
     }
+    return TRUE;
 }
 
 /**
@@ -278,12 +250,16 @@ char GPS_is_msg_avail(void) {
  * @brief 
  * @author Aaron Hunter */
 char GPS_parse_stream(void) {
-    struct GPS_msg_buffer *buf = msg_buffer_p;
+    GPS_sentence_t header;
+    char sentence[GPS_PAYLOADLENGTH + 1];
 
     if (GPS_is_msg_avail() == TRUE) {
-        NMEA_parse(buf->payload[buf->read_index]);
-        /*increment and wrap read index*/
-        buf->read_index = (buf->read_index + 1) % GPS_BUFFERSIZE;
+        /*the ISR publishes a header and its payload together*/
+        Ring_read(&sentence_ring, (uint8_t *) &header, sizeof (header));
+        Ring_read(&sentence_ring, (uint8_t *) sentence, header.length);
+        sentence[header.length] = '\0';
+        parse_time = header.rx_time;
+        NMEA_parse(sentence);
         return SUCCESS;
     } else return ERROR;
 }
@@ -322,6 +298,7 @@ char GPS_get_data(struct GPS_data * data) {
     data->lon = RMC_data.lon;
     data->spd = RMC_data.spd;
     data->cog = RMC_data.cog;
+    data->rx_time = RMC_data.rx_time;
     is_data_new = FALSE; // change flag to indicate that data has been read
     return SUCCESS;
 }
@@ -337,16 +314,12 @@ char GPS_get_data(struct GPS_data * data) {
  * @author Aaron Hunter
  * @modified  */
 void __ISR(_UART_2_VECTOR, IPL3AUTO) UART2_interrupt_handler(void) {
-    unsigned char charIn;
     if (IFS1bits.U2RXIF) { //check for received data flag
-        IFS1bits.U2RXIF = 0; //clear the flag
-        unsigned char charIn = U2RXREG;
-        /*run the state machine with the new character from the RX buffer*/
-        if (reading_from_RX_buffer == FALSE) {
+        /*run the state machine with each character in the RX FIFO*/
+        while (U2STAbits.URXDA) {
             GPS_run_RX_state_machine(U2RXREG);
-        } else {
-            RX_collision = TRUE;
         }
+        IFS1bits.U2RXIF = 0; //clear the flag
     }
     if (IFS1bits.U2TXIF) { /*check for transmission flag*/
         IFS1bits.U2TXIF = 0; /*clear the flag*/
@@ -368,43 +341,6 @@ void __ISR(_UART_2_VECTOR, IPL3AUTO) UART2_interrupt_handler(void) {
     }
 }
 
-/**
- * @Function void initBuffer(struct oBuffer *buf)
- * @brief Initializes a new circular buffer
- * @note 
- * @author Aaron Hunter
- * @modified  */
-void init_buffer(struct circular_buffer * buf) {
-    int i;
-    buf->read_index = 0; /*initialize read index to 0 */
-    buf->write_index = 0; /*initialize write index to 0 */
-    buf->size = BUFFER_LENGTH; /*Set size to buffer length const*/
-    for (i = 0; i < BUFFER_LENGTH; i++) { /*initialize data to zero*/
-        buf->data[i] = 0;
-    } /*end for */
-}
-
-/**
- * @Function void initPacketBuffer(struct packetBuffer *buf)
- * @brief Initializes a new packet buffer
- * @note 
- * @author Aaron Hunter
- * @modified  */
-void init_msg_buffer(struct GPS_msg_buffer * buf) {
-    int i;
-    int j;
-    buf->read_index = 0; /*initialize read index to 0 */
-    buf->write_index = 0; /*initialize write index to 0 */
-
-    for (i = 0; i < GPS_BUFFERSIZE; i++) { /*initialize data to zero*/
-        buf->length[j] = 0;
-        buf->checksum[j] = 0;
-        for (j = 0; j < GPS_PAYLOADLENGTH; j++) {
-            buf->payload[i][j] = 0;
-        } /*end for j */
-    } /*end for i */
-}
-
 /**
  * @Function void GPS_run_RX_state_machine(unsigned char char_in)
  * @param char_in, next character to process
@@ -427,6 +363,7 @@ void GPS_run_RX_state_machine(unsigned char char_in) {
         {
             index = 0;
             if (char_in == GPS_HEAD) {
+                head_time = Sys_timer_get_ticks(); //capture time of the sentence
                 next_state = GET_PAYLOAD;
                 payload[index] = char_in;
                 checksum = 0;
@@ -440,7 +377,9 @@ void GPS_run_RX_state_machine(unsigned char char_in) {
         {
             index++;
             payload[index] = char_in;
-            if (char_in == GPS_TAIL) {
+            if (index >= GPS_PAYLOADLENGTH - 3) { // no room for the checksum
+                next_state = WAITING_FOR_HEAD;
+            } else if (char_in == GPS_TAIL) {
                 next_state = GET_CHECKSUM;
                 cksum_index = 0;
             } else {
@@ -481,24 +420,15 @@ void GPS_run_RX_state_machine(unsigned char char_in) {
  * @brief stores the payload of an incoming message into the packet buffer
  * @author Aaron Hunter */
 int GPS_store_msg(unsigned char *payload, int length, unsigned char checksum) {
-    int i;
-    struct GPS_msg_buffer *buf = msg_buffer_p;
-
-    if (GPS_is_queue_full() == FALSE) { /*If the packet buffer is not full */
-        reading_from_RX_buffer = TRUE;
-        buf->length[buf->write_index] = length; /*write length to the bufferLength at the writeIndex */
-        for (i = 0; i < length; i++) {
-            buf->payload[buf->write_index][i] = payload[i]; //write payload data
-        }
-        /*NULL terminate the string*/
-        buf->payload[buf->write_index][length] = '\0';
-        reading_from_RX_buffer = FALSE;
-        buf->checksum[buf->write_index] = checksum;
-        buf->write_index = (buf->write_index + 1) % GPS_BUFFERSIZE; //increment and wrap
-        if (RX_collision == TRUE) {
-            IFS1bits.U2RXIF = 1; /*reset interrupt for RX*/
-            RX_collision = FALSE; /* reset collision flag */
-        }
+    static uint8_t record[sizeof (GPS_sentence_t) + GPS_PAYLOADLENGTH];
+    GPS_sentence_t *header = (GPS_sentence_t *) record;
+
+    if (Ring_space(&sentence_ring) >= sizeof (GPS_sentence_t) + length) {
+        header->rx_time = head_time;
+        header->length = length;
+        memcpy(&record[sizeof (GPS_sentence_t)], payload, length);
+        /*one write so the parser never sees a header without its payload*/
+        Ring_write(&sentence_ring, record, sizeof (GPS_sentence_t) + length);
         return SUCCESS;
     } else return ERROR;
 }
@@ -510,8 +440,7 @@ int GPS_store_msg(unsigned char *payload, int length, unsigned char checksum) {
  * @brief 
  * @author Aaron Hunter */
 char GPS_is_queue_full(void) {
-    struct GPS_msg_buffer *buf = msg_buffer_p;
-    if ((buf->write_index + 1) % GPS_BUFFERSIZE == buf->read_index) {
+    if (Ring_space(&sentence_ring) < sizeof (GPS_sentence_t) + GPS_PAYLOADLENGTH) {
         return TRUE;
     }
     return FALSE;
@@ -671,6 +600,7 @@ static char RMC_storeData(void) {
     RMC_data.lon = NMEA_longitude;
     RMC_data.cog = RMC.cog;
     RMC_data.spd = RMC.speed;
+    RMC_data.rx_time = parse_time;
     is_data_new = TRUE; //set flag to indicate that there is unread data
     return SUCCESS;
 }
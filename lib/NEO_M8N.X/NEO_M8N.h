@@ -13,6 +13,7 @@
  * PUBLIC #INCLUDES                                                            *
  ******************************************************************************/
 
+#include <sys/types.h>
 
 
 /*******************************************************************************
@@ -29,6 +30,7 @@ struct GPS_data{
     double lon; //longitude, deg 
     double spd; //GPS speed in knots
     double cog; //GPS heading in deg
+    uint64_t rx_time; //Sys_timer_get_ticks() when the sentence started
 };
 
 
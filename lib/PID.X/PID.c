@@ -41,9 +41,7 @@
 void PID_init(PID_controller *pid) {
     int i;
     /*pre compute the constant calculations*/
-    pid->c0 = pid->kp + pid->ki * pid->dt + pid->kd / pid->dt;
-    pid->c1 = -pid->kp - 2 * pid->kd / pid->dt;
-    pid->c2 = pid->kd / pid->dt;
+    PID_update_constants(pid);
     pid->u = 0;
     pid->u_calc = 0;
     /* initialize error*/
@@ -52,6 +50,19 @@ void PID_init(PID_controller *pid) {
     }
 }
 
+/**
+ * @Function PID_update_constants(PID_controller *pid)
+ * @param *pid, pointer to PID_controller type
+ * @brief recomputes c0, c1, c2 from the gains and dt
+ * @note the output and error history are kept, so the gains of a running
+ * controller change without a bump
+ * @author Aaron Hunter */
+void PID_update_constants(PID_controller *pid) {
+    pid->c0 = pid->kp + pid->ki * pid->dt + pid->kd / pid->dt;
+    pid->c1 = -pid->kp - 2 * pid->kd / pid->dt;
+    pid->c2 = pid->kd / pid->dt;
+}
+
 /**
  * @Function PID_update(PID_controller *pid, float reference, float measurement)
  * @param *pid, pointer to PID_controller type
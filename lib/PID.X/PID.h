@@ -49,6 +49,15 @@ typedef struct PID_controller {
  * @modified */
 void PID_init(PID_controller *pid);
 
+/**
+ * @Function PID_update_constants(PID_controller *pid)
+ * @param *pid, pointer to PID_controller type
+ * @brief recomputes c0, c1, c2 from the gains and dt
+ * @note the output and error history are kept, so the gains of a running
+ * controller change without a bump
+ * @author Aaron Hunter */
+void PID_update_constants(PID_controller *pid);
+
 
 
 /**
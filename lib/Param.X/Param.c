@@ -0,0 +1,381 @@
+/*
+ * File:   Param.c
+ * Brief: MAVLink parameter protocol, see Param.h.  The PARAM_TESTING harness
+ * finds a seed for a table of 48 ids the way python/param_hash.py does and
+ * prints the cycles of a hashed lookup against a search of the table.
+ * Created on 10/16/2026
+ * Modified on 10/17/2026
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+
+#include "Param.h" // The header file for this source file.
+#include "Board.h"
+#include "SerialM32.h"
+#include "Radio_serial.h"
+#include "System_timer.h"
+#include <string.h>
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#define USEC_PER_SEC 1000000UL
+#define BITS_PER_BYTE 10 // 8N1 with start and stop bits
+#define FNV_PRIME 16777619UL
+#define EMPTY_SLOT 0xFF
+#define VALUE_FRAME_LENGTH (MAVLINK_NUM_NON_PAYLOAD_BYTES + MAVLINK_MSG_ID_PARAM_VALUE_LEN)
+#define BIT(i) ((uint64_t) 1 << (i))
+
+/*******************************************************************************
+ * PRIVATE VARIABLES                                                           *
+ ******************************************************************************/
+static const param_t *params = NULL;
+static uint8_t param_count = 0;
+static uint8_t slot[PARAM_MAX_SLOTS]; // index of the id that hashes here
+static uint32_t hash_seed = 0;
+static uint8_t slot_mask = 0;
+static uint8_t hashed = FALSE; // FALSE if the seed is stale, lookups search
+static float staged[PARAM_MAX_PARAMS]; // set, not yet applied
+static uint64_t pending = 0; // staged values
+static uint64_t reply[MAVLINK_TX_PORTS]; // PARAM_VALUE owed on the port
+static uint8_t list_next[MAVLINK_TX_PORTS]; // param_count when not listing
+static uint32_t list_due[MAVLINK_TX_PORTS];
+static param_stats_t stats;
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                 *
+ ******************************************************************************/
+static uint32_t hash(const char *id, uint32_t seed);
+static int16_t search(const char *id);
+static void apply(void);
+static void send_value(uint8_t port, uint8_t index);
+static uint32_t list_interval(uint8_t port);
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function Param_init(const param_t *table, uint8_t count, uint32_t seed, uint8_t slots)
+ * @param table, the parameters, indexed as in PARAM_VALUE, kept by reference
+ * @param count, entries in table, at most PARAM_MAX_PARAMS
+ * @param seed, hash seed from python/param_hash.py
+ * @param slots, hash table length from python/param_hash.py, a power of two
+ * up to PARAM_MAX_SLOTS
+ * @return SUCCESS, ERROR if the table is too long or if two ids share a
+ * slot, the seed is stale, then lookups search the table
+ * @author Aaron Hunter */
+int8_t Param_init(const param_t *table, uint8_t count, uint32_t seed, uint8_t slots) {
+    uint8_t port;
+    uint8_t i;
+    uint8_t s;
+
+    if (count > PARAM_MAX_PARAMS) {
+        return ERROR;
+    }
+    hashed = (slots > 0 && slots <= PARAM_MAX_SLOTS && (slots & (slots - 1)) == 0);
+    params = table;
+    param_count = count;
+    hash_seed = seed;
+    slot_mask = slots - 1;
+    memset(slot, EMPTY_SLOT, sizeof (slot));
+    for (i = 0; i < param_count && hashed == TRUE; i++) {
+        s = hash(params[i].id, hash_seed) & slot_mask;
+        if (slot[s] != EMPTY_SLOT) {
+            hashed = FALSE;
+        }
+        slot[s] = i;
+    }
+    pending = 0;
+    for (port = 0; port < MAVLINK_TX_PORTS; port++) {
+        reply[port] = 0;
+        list_next[port] = param_count;
+    }
+    Param_reset_stats();
+    return hashed == TRUE ? SUCCESS : ERROR;
+}
+
+/**
+ * @Function Param_find(const char *id)
+ * @param id, up to PARAM_ID_LENGTH characters
+ * @return index of the parameter or PARAM_NOT_FOUND
+ * @author Aaron Hunter */
+int16_t Param_find(const char *id) {
+    uint8_t i;
+
+    if (hashed == FALSE) {
+        return search(id);
+    }
+    /* every id in the table has a slot of its own, so one compare decides */
+    i = slot[hash(id, hash_seed) & slot_mask];
+    if (i != EMPTY_SLOT && strncmp(params[i].id, id, PARAM_ID_LENGTH) == 0) {
+        return i;
+    }
+    return PARAM_NOT_FOUND;
+}
+
+/**
+ * @Function Param_handle_msg(const mavlink_message_t *msg, uint8_t port)
+ * @param msg, message parsed from port
+ * @param port, MAVLINK_TX_RADIO or MAVLINK_TX_USB
+ * @return TRUE if the message was a parameter request for this system and was
+ * consumed, FALSE to let the app handle it
+ * @brief PARAM_REQUEST_READ, PARAM_SET and PARAM_REQUEST_LIST; the replies go
+ * out on the next Param_run(), on the port the request came from and a new
+ * value on every port
+ * @author Aaron Hunter */
+uint8_t Param_handle_msg(const mavlink_message_t *msg, uint8_t port) {
+    mavlink_param_request_read_t read;
+    mavlink_param_request_list_t list;
+    mavlink_param_set_t set;
+    int16_t index;
+    uint8_t p;
+
+    if (port >= MAVLINK_TX_PORTS) {
+        return FALSE;
+    }
+    switch (msg->msgid) {
+        case MAVLINK_MSG_ID_PARAM_REQUEST_READ:
+            mavlink_msg_param_request_read_decode(msg, &read);
+            if (Mavlink_tx_is_for_us(read.target_system) == FALSE) {
+                return FALSE;
+            }
+            index = read.param_index >= 0 ? read.param_index : Param_find(read.param_id);
+            if (index >= 0 && index < param_count) {
+                reply[port] |= BIT(index);
+            } else {
+                stats.unknown++;
+            }
+            return TRUE;
+        case MAVLINK_MSG_ID_PARAM_SET:
+            mavlink_msg_param_set_decode(msg, &set);
+            if (Mavlink_tx_is_for_us(set.target_system) == FALSE) {
+                return FALSE;
+            }
+            index = Param_find(set.param_id);
+            if (index == PARAM_NOT_FOUND) {
+                stats.unknown++; // no reply, the ground station times out
+            } else if (set.param_value >= params[index].min && set.param_value <= params[index].max) {
+                staged[index] = set.param_value;
+                pending |= BIT(index);
+                /* every ground station sees the new value */
+                for (p = 0; p < MAVLINK_TX_PORTS; p++) {
+                    reply[p] |= BIT(index);
+                }
+            } else {
+                stats.refused++; // the old value goes back to the sender
+                reply[port] |= BIT(index);
+            }
+            return TRUE;
+        case MAVLINK_MSG_ID_PARAM_REQUEST_LIST:
+            mavlink_msg_param_request_list_decode(msg, &list);
+            if (Mavlink_tx_is_for_us(list.target_system) == FALSE) {
+                return FALSE;
+            }
+            list_next[port] = 0; // a repeated request starts over
+            list_due[port] = Sys_timer_get_usec();
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+/**
+ * @Function Param_run(void)
+ * @return none
+ * @brief applies the staged values, sends the replies and the lists that are
+ * due; call from the main loop, outside the tasks that use the values
+ * @author Aaron Hunter */
+void Param_run(void) {
+    uint32_t now = Sys_timer_get_usec();
+    uint8_t port;
+    uint8_t i;
+
+    if (pending != 0) {
+        apply();
+    }
+    for (port = 0; port < MAVLINK_TX_PORTS; port++) {
+        /* replies are urgent frames and few, they go at once */
+        for (i = 0; reply[port] != 0 && i < param_count; i++) {
+            if (reply[port] & BIT(i)) {
+                send_value(port, i);
+                reply[port] &= ~BIT(i);
+            }
+        }
+        /* a list takes one value per interval and only the bulk space, so
+         * the streams and replies keep their share of the link */
+        if (list_next[port] < param_count && (int32_t) (now - list_due[port]) >= 0
+                && Mavlink_tx_space(port) >= VALUE_FRAME_LENGTH) {
+            send_value(port, list_next[port]++);
+            list_due[port] = now + list_interval(port);
+        }
+    }
+}
+
+/**
+ * @Function Param_get_stats(void)
+ * @return sets, refusals, unknown requests and PARAM_VALUE per port since the
+ * last reset
+ * @author Aaron Hunter */
+const param_stats_t *Param_get_stats(void) {
+    return &stats;
+}
+
+/**
+ * @Function Param_reset_stats(void)
+ * @return none
+ * @author Aaron Hunter */
+void Param_reset_stats(void) {
+    memset(&stats, 0, sizeof (stats));
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/* hash(const char *id, uint32_t seed)
+ * FNV-1a of the id from the seed, python/param_hash.py has the same; the low
+ * bits of a multiply only see the low bits of the seed and characters, so the
+ * high half is folded in before the slot is masked off
+ */
+static uint32_t hash(const char *id, uint32_t seed) {
+    uint32_t h = seed;
+    uint8_t i;
+
+    for (i = 0; i < PARAM_ID_LENGTH && id[i] != '\0'; i++) {
+        h ^= (uint8_t) id[i];
+        h *= FNV_PRIME;
+    }
+    return h ^ (h >> 16);
+}
+
+/* search(const char *id)
+ * index of the id by comparing it with each in turn, for a stale seed
+ */
+static int16_t search(const char *id) {
+    uint8_t i;
+
+    for (i = 0; i < param_count; i++) {
+        if (strncmp(params[i].id, id, PARAM_ID_LENGTH) == 0) {
+            return i;
+        }
+    }
+    return PARAM_NOT_FOUND;
+}
+
+/* apply(void)
+ * writes every staged value, then calls each of their hooks once, so the
+ * structures see all the values of the pass together
+ */
+static void apply(void) {
+    uint64_t changed = pending;
+    uint8_t i;
+    uint8_t j;
+
+    pending = 0;
+    for (i = 0; i < param_count; i++) {
+        if (changed & BIT(i)) {
+            *params[i].value = staged[i];
+            stats.sets++;
+        }
+    }
+    for (i = 0; i < param_count; i++) {
+        if ((changed & BIT(i)) == 0 || params[i].apply == NULL) {
+            continue;
+        }
+        for (j = 0; j < i; j++) {
+            if ((changed & BIT(j)) && params[j].apply == params[i].apply) {
+                break; // called already
+            }
+        }
+        if (j == i) {
+            params[i].apply();
+        }
+    }
+}
+
+/* send_value(uint8_t port, uint8_t index)
+ * PARAM_VALUE of the parameter
+ */
+static void send_value(uint8_t port, uint8_t index) {
+    mavlink_msg_param_value_send(port, params[index].id, *params[index].value,
+            MAV_PARAM_TYPE_REAL32, param_count, index);
+    stats.sent[port]++;
+}
+
+/* list_interval(uint8_t port)
+ * usec between the values of a list, PARAM_LIST_SHARE of the baud rate
+ */
+static uint32_t list_interval(uint8_t port) {
+    uint32_t baud = port == MAVLINK_TX_RADIO ? Radio_get_baud() : Serial_get_baud();
+
+    return VALUE_FRAME_LENGTH * USEC_PER_SEC / (baud / BITS_PER_BYTE * PARAM_LIST_SHARE / 100);
+}
+
+#ifdef PARAM_TESTING
+#include <stdio.h>
+
+#define TEST_PARAMS 48
+#define REPEAT 100
+
+mavlink_system_t mavlink_system = {
+    1, // System ID (1-255)
+    MAV_COMP_ID_AUTOPILOT1 // Component ID (a MAV_COMPONENT value)
+};
+
+static float values[TEST_PARAMS];
+static param_t test_params[TEST_PARAMS];
+static volatile int16_t found;
+
+static void find_last(void) {
+    found = Param_find(test_params[TEST_PARAMS - 1].id);
+}
+
+/* mean core timer counts of fn() */
+static uint32_t core_counts(void (*fn)(void)) {
+    uint32_t start;
+    uint32_t sum = 0;
+    uint16_t i;
+
+    for (i = 0; i < REPEAT; i++) {
+        start = Sys_timer_get_core();
+        fn();
+        sum += Sys_timer_get_core() - start;
+    }
+    return sum / REPEAT;
+}
+
+int main(void) {
+    uint32_t seed;
+    uint32_t counts;
+    uint8_t i;
+
+    Board_init();
+    Serial_init();
+    Radio_serial_init();
+    Sys_timer_init();
+    printf("\r\nParam test harness %s, %s\r\n", __DATE__, __TIME__);
+    for (i = 0; i < TEST_PARAMS; i++) {
+        sprintf(test_params[i].id, "TEST_PARAM_%02u", i);
+        test_params[i].value = &values[i];
+        test_params[i].min = -1.0;
+        test_params[i].max = 1.0;
+    }
+    /* the search python/param_hash.py makes offline */
+    for (seed = 1; Param_init(test_params, TEST_PARAMS, seed, PARAM_MAX_SLOTS) == ERROR; seed++) {
+        ;
+    }
+    printf("seed %u for %u ids in %u slots\r\n", seed, TEST_PARAMS, PARAM_MAX_SLOTS);
+    counts = core_counts(find_last);
+    printf("hashed %5u cycles, index %d\r\n", 2 * counts, found);
+    Param_init(test_params, TEST_PARAMS, seed, 0);
+    counts = core_counts(find_last);
+    printf("search %5u cycles, index %d\r\n", 2 * counts, found);
+    while (1) {
+        ;
+    }
+    return 0;
+}
+#endif //PARAM_TESTING
@@ -0,0 +1,116 @@
+/*
+ * File:   Param.h
+ * Brief: MAVLink parameter protocol.  The app lists its tunable floats in a
+ * table of PARAM_ENTRY() lines, each with its id, limits and a hook that
+ * pushes new values into the structures using them.  Ids are found by a
+ * perfect hash: python/param_hash.py reads the table and picks a seed for
+ * which no two ids share a slot, so a lookup is one hash and one compare
+ * instead of a search through every id.  PARAM_SET only stages the value;
+ * Param_run() writes the staged values and calls their hooks together
+ * between the main loop's tasks, so a controller never runs with half its
+ * gains changed.  PARAM_REQUEST_LIST streams the table as PARAM_VALUE at a share of
+ * the port's baud rate, beside the telemetry instead of in place of it.
+ * Main loop only.
+ * Created on 10/16/2026
+ * Modified on 10/17/2026
+ */
+
+#ifndef PARAM_H // Header guard
+#define	PARAM_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+#include <stdint.h>
+#include "Mavlink_tx.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+#define PARAM_ID_LENGTH 16 // MAVLink param_id, no terminator when all are used
+#define PARAM_MAX_PARAMS 64
+#define PARAM_MAX_SLOTS 128 // hash table length, a power of two
+#define PARAM_LIST_SHARE 10 // percent of the baud rate for a PARAM_VALUE list
+#define PARAM_NOT_FOUND -1
+
+/* a parameter table entry, every value a float sent as MAV_PARAM_TYPE_REAL32 */
+#define PARAM_ENTRY(id, value, min, max, apply) {id, value, min, max, apply}
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+/* pushes changed values into the structures that use them */
+typedef void (*param_apply_t)(void);
+
+typedef struct {
+    char id[PARAM_ID_LENGTH];
+    float *value; // the live value
+    float min; // a PARAM_SET outside the limits is refused
+    float max;
+    param_apply_t apply; // once per Param_run() that changed the value, or NULL
+} param_t;
+
+typedef struct {
+    uint32_t sets; // values changed
+    uint32_t refused; // outside the limits
+    uint32_t unknown; // ids or indexes not in the table
+    uint32_t sent[MAVLINK_TX_PORTS]; // PARAM_VALUE
+} param_stats_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function Param_init(const param_t *table, uint8_t count, uint32_t seed, uint8_t slots)
+ * @param table, the parameters, indexed as in PARAM_VALUE, kept by reference
+ * @param count, entries in table, at most PARAM_MAX_PARAMS
+ * @param seed, hash seed from python/param_hash.py
+ * @param slots, hash table length from python/param_hash.py, a power of two
+ * up to PARAM_MAX_SLOTS
+ * @return SUCCESS, ERROR if the table is too long or if two ids share a
+ * slot, the seed is stale, then lookups search the table
+ * @author Aaron Hunter */
+int8_t Param_init(const param_t *table, uint8_t count, uint32_t seed, uint8_t slots);
+
+/**
+ * @Function Param_find(const char *id)
+ * @param id, up to PARAM_ID_LENGTH characters
+ * @return index of the parameter or PARAM_NOT_FOUND
+ * @author Aaron Hunter */
+int16_t Param_find(const char *id);
+
+/**
+ * @Function Param_handle_msg(const mavlink_message_t *msg, uint8_t port)
+ * @param msg, message parsed from port
+ * @param port, MAVLINK_TX_RADIO or MAVLINK_TX_USB
+ * @return TRUE if the message was a parameter request for this system and was
+ * consumed, FALSE to let the app handle it
+ * @brief PARAM_REQUEST_READ, PARAM_SET and PARAM_REQUEST_LIST; the replies go
+ * out on the next Param_run(), on the port the request came from and a new
+ * value on every port
+ * @author Aaron Hunter */
+uint8_t Param_handle_msg(const mavlink_message_t *msg, uint8_t port);
+
+/**
+ * @Function Param_run(void)
+ * @return none
+ * @brief applies the staged values, sends the replies and the lists that are
+ * due; call from the main loop, outside the tasks that use the values
+ * @author Aaron Hunter */
+void Param_run(void);
+
+/**
+ * @Function Param_get_stats(void)
+ * @return sets, refusals, unknown requests and PARAM_VALUE per port since the
+ * last reset
+ * @author Aaron Hunter */
+const param_stats_t *Param_get_stats(void);
+
+/**
+ * @Function Param_reset_stats(void)
+ * @return none
+ * @author Aaron Hunter */
+void Param_reset_stats(void);
+
+#endif	/* PARAM_H */ // End of header guard
@@ -13,7 +13,8 @@
 
 #include "RC_RX.h" // The header file for this source file. 
 #include "SerialM32.h" // The header file for this source file. 
-#include "Board.H"   //Max32 setup      
+#include "Board.h"   //Max32 setup      
+#include "System_timer.h"
 #include <xc.h>
 #include <stdio.h>
 #include <sys/attribs.h>  //for ISR definitions
@@ -38,6 +39,7 @@ struct RCRX_msg_buffer {
     uint8_t read_index;
     uint8_t write_index;
     uint8_t sbus_buffer[RX_NUM_MSGS][SBUS_BUFFER_LENGTH]; //raw data
+    uint64_t rx_time[RX_NUM_MSGS]; //Sys_timer_get_ticks() at the start byte
 };
 struct RCRX_msg_buffer RCRX_msgs;
 struct RCRX_msg_buffer* RCRX_buf_p = &RCRX_msgs;
@@ -50,6 +52,7 @@ static unsigned int parse_error_counter = 0;
 static unsigned int byte_counter = 0;
 static unsigned int collision_counter = 0;
 static unsigned int uart_err_counter = 0;
+static uint64_t cmd_time = 0; //receive time of the last RCRX_get_cmd() data
 
 //typedef enum {
 //    WAIT_FOR_START,
@@ -173,6 +176,7 @@ uint8_t RCRX_new_cmd_avail(void) {
 uint8_t RCRX_get_cmd(RCRX_channel_buffer *channels) {
     parsing_RX = TRUE;
     RCRX_calc_cmd(channels);
+    cmd_time = RCRX_msgs.rx_time[RCRX_msgs.read_index];
     parsing_RX = FALSE;
     //if a collision occurred, clear the flag and re-enable interrupt to get data
     if (RX_collision == TRUE) {
@@ -233,6 +237,20 @@ unsigned int RCRX_get_uart_err_count(void) {
     return uart_err_counter;
 }
 
+/**
+ * @Function RCRX_get_cmd_time()
+ * @param none
+ * @return Sys_timer_get_ticks() at the start byte of the SBUS frame last
+ * returned by RCRX_get_cmd()
+ * @brief 
+ * @note the age of the command is Sys_timer_dt(RCRX_get_cmd_time(),
+ * Sys_timer_get_ticks())
+ * @author aahunter
+ * @modified Aaron Hunter, 10/16/2026 */
+uint64_t RCRX_get_cmd_time(void) {
+    return cmd_time;
+}
+
 /*******************************************************************************
  * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
  ******************************************************************************/
@@ -251,6 +269,7 @@ static void RCRX_init_msg_buffer(struct RCRX_msg_buffer* buf) {
     buf->read_index = 0;
     buf->write_index = 0;
     for (i = 0; i < RX_NUM_MSGS; i++) {
+        buf->rx_time[i] = 0;
         for (j = 0; j < SBUS_BUFFER_LENGTH; j++) {
             buf->sbus_buffer[i][j] = 0;
         }
@@ -431,6 +450,7 @@ static void RCRX_run_RX_state_machine(uint8_t curr_byte) {
         case GET_START:
             if (curr_byte == START_BYTE && prev_byte == END_BYTE) {
                 byte_counter = 0;
+                RCRX_msgs.rx_time[RCRX_msgs.write_index] = Sys_timer_get_ticks();
                 //store the start byte 
                 RCRX_msgs.sbus_buffer[RCRX_msgs.write_index][byte_counter] = curr_byte;
                 byte_counter++;
@@ -107,6 +107,18 @@ unsigned int RCRX_get_collision_count(void);
  * @modified <Your Name>, <year>.<month>.<day> <hour> <pm/am> */
 unsigned int RCRX_get_uart_err_count(void);
 
+/**
+ * @Function RCRX_get_cmd_time()
+ * @param none
+ * @return Sys_timer_get_ticks() at the start byte of the SBUS frame last
+ * returned by RCRX_get_cmd()
+ * @brief 
+ * @note the age of the command is Sys_timer_dt(RCRX_get_cmd_time(),
+ * Sys_timer_get_ticks())
+ * @author aahunter
+ * @modified Aaron Hunter, 10/16/2026 */
+uint64_t RCRX_get_cmd_time(void);
+
 
 #endif	/* RC_RX_H */ // End of header guard
 
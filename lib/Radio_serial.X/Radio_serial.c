@@ -12,95 +12,72 @@
 
 #include "Radio_serial.h" // The header file for this source file. 
 #include "SerialM32.h" //debug serial
-#include "Board.H"   //Max32 setup      
+#include "Board.h"   //Max32 setup      
+#include "Ring_buffer.h"
 #include <stdio.h>
 #include <string.h>
 #include <sys/types.h>
 #include <sys/attribs.h>  //for ISR definitions
+#include <sys/kmem.h> //for KVA_TO_PA()
 #include <xc.h>
 
 /*******************************************************************************
  * PRIVATE #DEFINES                                                            *
  ******************************************************************************/
-#define BUFFER_LENGTH 2048
+#define BUFFER_LENGTH 2048 // power of two for the ring
 #define RADIO_BAUD_RATE 57600
+#define DMA_CHUNK 256 // largest DMA block, the cell counters are 8 bits
 
 /*******************************************************************************
  * PRIVATE TYPEDEFS                                                            *
  ******************************************************************************/
 
-struct circular_buffer {
-    int16_t read_index;
-    int16_t write_index;
-    int16_t size;
-    unsigned char data[BUFFER_LENGTH];
-}; /*circular  buffer */
-
-static struct circular_buffer tx_buffer; /*Circular UART TX buffer */
-static struct circular_buffer rx_buffer; /*Circular UART RX buffer */
-
-/*pointers to the buffers so we don't pass the entire buffer to the functions*/
-static struct circular_buffer *txp = &tx_buffer;
-static struct circular_buffer *rxp = &rx_buffer;
-
-static int8_t tx_collision = FALSE;
-static int8_t rx_collision = FALSE;
-static int8_t writing_tx_buffer = FALSE;
-static int8_t reading_rx_buffer = FALSE;
-static int8_t new_char_avail = FALSE;
+/* RX ring: the U4 ISR writes, the main loop reads */
+static uint8_t rx_data[BUFFER_LENGTH];
+static ring_buffer_t rx_ring;
+static volatile uint32_t rx_dropped = 0; // bytes lost to a full ring
+
+/* TX blocks: DMA channel 1 sends one while the other one fills */
+static uint8_t tx_block[2][RADIO_TX_BLOCK_LENGTH];
+static volatile uint16_t tx_fill_len[2];
+static volatile uint8_t tx_fill = 0; // block taking new data
+static volatile uint8_t dma_busy = FALSE;
+static volatile uint8_t tx_reserved = FALSE; // a frame is being built in place
+static volatile uint16_t dma_len = 0; // length of the block being sent
+static volatile uint16_t dma_sent = 0; // bytes of it handed to the UART
+static volatile uint16_t dma_chunk = 0; // bytes in the current DMA transfer
+static radio_tx_done_t tx_done = NULL;
+static volatile uint32_t tx_dropped[RADIO_TX_CLASSES]; // frames refused per class
+
+
 /*******************************************************************************
  * PRIVATE FUNCTIONS PROTOTYPES                                                 *
  ******************************************************************************/
 /**
- * @Function init_buffer(struct circular_buffer *buf)
- * @param buf, pointer to a circular buffer
- * @return none
- * @brief  initializes the circular buffer struct
+ * @Function start_block(void)
+ * @brief hands the block being filled to the DMA and fills the other one,
+ * called with the DMA interrupt masked or from the DMA ISR
  * @author Aaron Hunter
  */
-static void init_buffer(struct circular_buffer *buf);
-
-/**
- * @Function is_buffer_empty(struct circular_buffer *buf);
- * @param buf, circular buffer pointer
- * @brief checks if the buffer is empty
- * @returns TRUE or FALSE
- */
-static int8_t is_buffer_empty(struct circular_buffer *buf);
-
-/**  
- * @Function is_buffer_full(struct oBuffer *buf)
- * @param circular buffer pointer
- * @brief takes a pointer to a circular buffer and checks if it is full 
- * @return TRUE or FALSE
- */
-static int8_t is_buffer_full(struct circular_buffer *buf);
-
-/** 
- * @Function write_buffer( (struct oBuffer *buf, unsigned char c)
- * @param circular buffer pointer
- * @param unsigned char 
- * @brief writes the char to the circular buffer reference
- * returns SUCCESS or ERROR
- **/
-static int8_t write_buffer(struct circular_buffer *buf, unsigned char c);
+static void start_block(void);
 
 /**
- * @Function int read_from_buffer(struct oBuffer *buf)
- * @param circular buffer pointer   
- * @brief returns char at read index from the buffer
- * @return char at index or  0 if the buffer is empty or the pointer is invalid
+ * @Function start_chunk(void)
+ * @brief sends the next DMA_CHUNK bytes of the block, paced by the UART TX
+ * requests.  A FIFO with room raises no new request so the first byte is
+ * forced then.
+ * @author Aaron Hunter
  */
-static unsigned char read_from_buffer(struct circular_buffer *buf);
+static void start_chunk(void);
 
 /**
- * @Function get_num_elements(struct circular buffer *buf)
- * @param buf, pointer to circular buffer
- * @brief returns the number of elements in buf
- * @return returns the number of elements in buf
+ * @Function tx_room(uint8_t priority)
+ * @brief bytes a frame of the class can take in the block being filled, the
+ * last RADIO_TX_HEADROOM are kept for urgent frames, called with the DMA
+ * interrupt masked
+ * @author Aaron Hunter
  */
-static int16_t get_num_elements(struct circular_buffer *buf);
-
+static uint16_t tx_room(uint8_t priority);
 
 /*******************************************************************************
  * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
@@ -114,9 +91,14 @@ static int16_t get_num_elements(struct circular_buffer *buf);
  * @author Aaron Hunter*/
 void Radio_serial_init(void) {
     char c;
-    /*Initialize the circular buffers*/
-    init_buffer(rxp);
-    init_buffer(txp);
+    /*Initialize the buffers*/
+    Ring_init(&rx_ring, rx_data, BUFFER_LENGTH);
+    rx_dropped = 0;
+    tx_fill_len[0] = tx_fill_len[1] = 0;
+    tx_fill = 0;
+    dma_busy = FALSE;
+    tx_reserved = FALSE;
+    tx_dropped[RADIO_TX_BULK] = tx_dropped[RADIO_TX_URGENT] = 0;
     /* turn off UART while configuring */
     U4MODEbits.ON = 0;
     __builtin_disable_interrupts();
@@ -133,12 +115,26 @@ void Radio_serial_init(void) {
     // JU4,U5,U6 only have software flow control (no DTR, CTS pins)
     /*configure UART interrupts */
     U4STAbits.URXISEL = 0x0; //interrupt when buffer is not empty
-    U4STAbits.UTXISEL = 0x01; // int when all characters are sent (TRMT == TRUE)
+    U4STAbits.UTXISEL = 0x0; // TX request while the FIFO has room, paces the DMA
     IFS2bits.U4RXIF = 0; //clear interrupt flags
     IFS2bits.U4TXIF = 0;
     IPC12bits.U4IP= 2; //set interrupt priority to 1 
     IEC2bits.U4RXIE = 1; //enable interrupt on RX
-    IEC2bits.U4TXIE = 1; //enable interrupts on TX
+    IEC2bits.U4TXIE = 0; //TX is fed by the DMA, the CPU does not see it
+    /* DMA channel 1 moves the TX blocks into U4TXREG, one byte per TX request */
+    DMACONbits.ON = 1;
+    DCH1CON = 0;
+    DCH1ECON = 0;
+    DCH1ECONbits.CHSIRQ = _UART4_TX_IRQ;
+    DCH1ECONbits.SIRQEN = 1;
+    DCH1DSA = KVA_TO_PA(&U4TXREG);
+    DCH1DSIZ = 1;
+    DCH1CSIZ = 1;
+    DCH1INT = 0;
+    DCH1INTbits.CHBCIE = 1; //interrupt when the block is done
+    IFS1bits.DMA1IF = 0;
+    IPC9bits.DMA1IP = 2;
+    IEC1bits.DMA1IE = 1;
     /* turn on UART*/
     U4MODEbits.ON = 1;
     __builtin_enable_interrupts();
@@ -151,22 +147,130 @@ void Radio_serial_init(void) {
  * @brief  adds the char to the tail of the transmit buffer
  * @author Aaron Hunter*/
 char Radio_put_char(unsigned char c){
-    if (is_buffer_full(txp) == FALSE) { //if the buffer isn't full
-        writing_tx_buffer = TRUE; // set flag so that interrupt can't access the buffer
-        write_buffer(txp, c); // write to buffer 
-        writing_tx_buffer = FALSE; // allow buffer access
-        /*if interrupt isn't set, it needs to be enabled.  Note this is slightly
-         * different from get_char because the module starts with no interrupts
-         * so there are two reasons for disabled interrupts:  empty transmit
-         * buffer or a collision.  Either way we need to re-enable them */
-        if (IEC2bits.U4TXIE == 0) {
-            tx_collision = FALSE;
-            IEC2bits.U4TXIE = 1; //enable interrupts on TX
-        }
-        return SUCCESS;
+    return Radio_write(&c, 1);
+}
+
+/**
+ * @Function Radio_write(const uint8_t *data, uint16_t length)
+ * @param data, bytes to send
+ * @param length, number of bytes
+ * @return SUCCESS or ERROR if the block being filled has no room for all of
+ * them, nothing is queued then so a frame is never cut
+ * @brief copies the bytes into the block being filled and starts the DMA if
+ * it is idle, bulk class
+ * @author Aaron Hunter*/
+int8_t Radio_write(const uint8_t *data, uint16_t length) {
+    uint8_t ie = IEC1bits.DMA1IE;
+    uint16_t fill_len;
+
+    IEC1bits.DMA1IE = 0; // the DMA ISR swaps the blocks
+    if (length > tx_room(RADIO_TX_BULK)) {
+        tx_dropped[RADIO_TX_BULK]++;
+        IEC1bits.DMA1IE = ie;
+        return ERROR;
+    }
+    fill_len = tx_fill_len[tx_fill];
+    memcpy(&tx_block[tx_fill][fill_len], data, length);
+    tx_fill_len[tx_fill] = fill_len + length;
+    if (dma_busy == FALSE) {
+        start_block();
+    }
+    IEC1bits.DMA1IE = ie;
+    return SUCCESS;
+}
+
+/**
+ * @Function Radio_reserve(uint16_t length, uint8_t priority)
+ * @param length, bytes of the frame about to be built
+ * @param priority, RADIO_TX_BULK or RADIO_TX_URGENT
+ * @return where to build it in the block being filled, NULL if it does not
+ * fit or a reservation is open
+ * @brief holds the block being filled until Radio_commit()
+ * @author Aaron Hunter */
+uint8_t *Radio_reserve(uint16_t length, uint8_t priority) {
+    uint8_t ie = IEC1bits.DMA1IE;
+    uint8_t *span = NULL;
+
+    priority = priority == RADIO_TX_URGENT ? RADIO_TX_URGENT : RADIO_TX_BULK;
+    IEC1bits.DMA1IE = 0; // the DMA ISR swaps the blocks
+    if (length <= tx_room(priority)) {
+        span = &tx_block[tx_fill][tx_fill_len[tx_fill]];
+        tx_reserved = TRUE;
     } else {
-        return ERROR; //buffer is full!
+        tx_dropped[priority]++;
+    }
+    IEC1bits.DMA1IE = ie;
+    return span;
+}
+
+/**
+ * @Function Radio_commit(uint16_t length)
+ * @param length, bytes filled at the reservation, 0 to give it back
+ * @return none
+ * @brief queues the frame and starts the DMA if it is idle, a block that
+ * finished while the frame was built left the DMA idle too
+ * @author Aaron Hunter */
+void Radio_commit(uint16_t length) {
+    uint8_t ie = IEC1bits.DMA1IE;
+
+    IEC1bits.DMA1IE = 0;
+    tx_fill_len[tx_fill] += length;
+    tx_reserved = FALSE;
+    if (dma_busy == FALSE && tx_fill_len[tx_fill] > 0) {
+        start_block();
     }
+    IEC1bits.DMA1IE = ie;
+}
+
+/**
+ * @Function Radio_set_tx_done(radio_tx_done_t callback)
+ * @param callback, called from the DMA interrupt with the length of each
+ * block sent, NULL for none
+ * @return none
+ * @author Aaron Hunter*/
+void Radio_set_tx_done(radio_tx_done_t callback) {
+    tx_done = callback;
+}
+
+/**
+ * @Function Radio_tx_idle(void)
+ * @return TRUE once everything written has been handed to the UART
+ * @author Aaron Hunter*/
+uint8_t Radio_tx_idle(void) {
+    return (dma_busy == FALSE);
+}
+
+/**
+ * @Function Radio_tx_space(uint8_t priority)
+ * @param priority, RADIO_TX_BULK or RADIO_TX_URGENT
+ * @return bytes a frame of the class can queue now, 0 while a frame is being
+ * built in place
+ * @author Aaron Hunter*/
+uint16_t Radio_tx_space(uint8_t priority) {
+    uint8_t ie = IEC1bits.DMA1IE;
+    uint16_t space;
+
+    IEC1bits.DMA1IE = 0; // the DMA ISR swaps the blocks
+    space = tx_room(priority);
+    IEC1bits.DMA1IE = ie;
+    return space;
+}
+
+/**
+ * @Function Radio_tx_dropped(uint8_t priority)
+ * @param priority, RADIO_TX_BULK or RADIO_TX_URGENT
+ * @return frames of the class refused for want of room since init
+ * @author Aaron Hunter*/
+uint32_t Radio_tx_dropped(uint8_t priority) {
+    return priority == RADIO_TX_URGENT ? tx_dropped[RADIO_TX_URGENT] : tx_dropped[RADIO_TX_BULK];
+}
+
+/**
+ * @Function Radio_get_baud(void)
+ * @return baud rate the UART runs at, from its BRG
+ * @author Aaron Hunter*/
+uint32_t Radio_get_baud(void) {
+    return Board_get_PB_clock() / (16 * (U4BRG + 1));
 }
 
 /**
@@ -175,28 +279,39 @@ char Radio_put_char(unsigned char c){
  * @brief  returns the value in the receive buffer
  * @author Aaron Hunter*/
 unsigned char Radio_get_char(void){
-    unsigned char c;
-    if (is_buffer_empty(rxp) == FALSE) {
-        reading_rx_buffer = TRUE; /*set buffer access flag*/
-        c = read_from_buffer(rxp);
-        reading_rx_buffer = FALSE;
-        //if a collision occurred we need to re-enable interrupts
-        if (rx_collision == TRUE) {
-            rx_collision = FALSE;
-            IEC2bits.U4RXIE = 1;
-        }
+    uint8_t c;
+    if (Ring_get(&rx_ring, &c) == SUCCESS) {
         return c;
     }
     return 0; /*no data available*/
 }
 
+/**
+ * @Function Radio_read(uint8_t *data, uint16_t length)
+ * @param data, filled with the received bytes
+ * @param length, most bytes to read
+ * @return bytes read
+ * @brief copies what has arrived in at most two spans
+ * @author Aaron Hunter*/
+uint16_t Radio_read(uint8_t *data, uint16_t length) {
+    return Ring_read(&rx_ring, data, length);
+}
+
+/**
+ * @Function Radio_rx_dropped(void)
+ * @return bytes lost because the receive buffer was full
+ * @author Aaron Hunter*/
+uint32_t Radio_rx_dropped(void) {
+    return rx_dropped;
+}
+
 /**
  * @Function Radio_data_available();
  * @return TRUE or FALSE
  * @brief responds with TRUE if the buffer is not empty, FALSE otherwise
  * @author Aaron Hunter*/
 unsigned char Radio_data_available(void){
-    return(!is_buffer_empty(rxp));
+    return (Ring_count(&rx_ring) > 0);
 }
 
 /*******************************************************************************
@@ -205,29 +320,12 @@ unsigned char Radio_data_available(void){
 
 void __ISR(_UART_4_VECTOR, IPL2AUTO) U4_interrupt_handler(void) {
     if (IFS2bits.U4RXIF) { //check for received data flag
-        if (is_buffer_full(rxp) == FALSE) {
-            if (reading_rx_buffer == FALSE) {
-                write_buffer(rxp, U4RXREG);
-            } else {
-                /*a collision occurred need to disable interrupts to exit ISR*/
-                /*it will be re-enabled in get_char() */
-                rx_collision = TRUE;
-                IEC2bits.U4RXIE = 0;
+        while (U4STAbits.URXDA) { // empty the FIFO, the ring never blocks
+            if (Ring_put(&rx_ring, U4RXREG) == ERROR) {
+                rx_dropped++;
             }
         }
         IFS2bits.U4RXIF = 0; // clear the flag
-    } else if (IFS2bits.U4TXIF) { /*check for transmission flag*/
-        if (is_buffer_empty(txp) == TRUE) { //if tx circular buffer is empty
-            IEC2bits.U4TXIE = 0; //disable interrupts on TX
-        } else if (writing_tx_buffer == FALSE) { /*If not being accessed */
-            U4TXREG = read_from_buffer(txp);
-        } else {
-            /*a collision occurred, turn off interrupt to exit ISR*/
-            /*it will be re-enabled in put_char()*/
-            tx_collision = TRUE;
-            IEC2bits.U4TXIE = 0;
-        }
-        IFS2bits.U4TXIF = 0; /*clear the interrupt flag*/
     } else if (IFS2bits.U4EIF) { //error flag--can check U1STA for the reason
         if (U4STAbits.OERR == 1) {
             U4STAbits.OERR = 0; //over run error is the only one we can write to clear
@@ -237,98 +335,83 @@ void __ISR(_UART_4_VECTOR, IPL2AUTO) U4_interrupt_handler(void) {
 }
 
 /**
- * @Function init_buffer(struct circular_buffer *buf)
- * @param buf, pointer to a circular buffer
- * @return none
- * @brief  initializes the circular buffer struct
+ * @Function DMA1_interrupt_handler(void)
+ * @brief continues the block in DMA_CHUNK transfers, then reports it and
+ * starts the block filled meanwhile
  * @author Aaron Hunter
  */
-static void init_buffer(struct circular_buffer *buf) {
-    int i;
-    buf->read_index = 0; /*initialize read index to 0 */
-    buf->write_index = 0; /*initialize write index to 0 */
-    buf->size = BUFFER_LENGTH; /*Set size to buffer length const*/
-    for (i = 0; i < BUFFER_LENGTH; i++) { /*initialize data to zero*/
-        buf->data[i] = 0;
-    } /*end for */
-}
-
-/**
- * @Function is_buffer_empty(struct circular_buffer *buf);
- * @param buf, circular buffer pointer
- * @brief checks if the buffer is empty
- * @returns TRUE or FALSE
- */
-static int8_t is_buffer_empty(struct circular_buffer *buf) {
-    if (buf->read_index == buf->write_index) { //if read = write then the buffer is empty
-        return TRUE;
+void __ISR(_DMA_1_VECTOR, IPL2AUTO) DMA1_interrupt_handler(void) {
+    uint16_t length;
+
+    DCH1INTbits.CHBCIF = 0;
+    IFS1bits.DMA1IF = 0;
+    dma_sent += dma_chunk;
+    if (dma_sent < dma_len) {
+        start_chunk();
+        return;
+    }
+    length = dma_len;
+    tx_fill_len[tx_fill ^ 1] = 0; // the block sent is free to fill
+    if (tx_fill_len[tx_fill] > 0 && tx_reserved == FALSE) {
+        start_block();
+    } else {
+        dma_busy = FALSE;
+    }
+    if (tx_done != NULL) {
+        tx_done(length);
     }
-    return FALSE;
 }
 
-/**  
- * @Function is_buffer_full(struct oBuffer *buf)
- * @param circular buffer pointer
- * @brief takes a pointer to a circular buffer and checks if it is full 
- * @return TRUE or FALSE
+/**
+ * @Function tx_room(uint8_t priority)
+ * @brief bytes a frame of the class can take in the block being filled, the
+ * last RADIO_TX_HEADROOM are kept for urgent frames, called with the DMA
+ * interrupt masked
+ * @author Aaron Hunter
  */
-static int8_t is_buffer_full(struct circular_buffer *buf) {
-    /* write index +1 == read index is full,  the mod provides wrap around*/
-    if ((buf->write_index + 1) % BUFFER_LENGTH == buf->read_index) {
-        return TRUE;
-    }
-    return FALSE;
-}
+static uint16_t tx_room(uint8_t priority) {
+    uint16_t limit = priority == RADIO_TX_URGENT ? RADIO_TX_BLOCK_LENGTH
+            : RADIO_TX_BLOCK_LENGTH - RADIO_TX_HEADROOM;
+    uint16_t fill_len = tx_fill_len[tx_fill];
 
-/** 
- * @Function write_buffer( (struct oBuffer *buf, unsigned char c)
- * @param circular buffer pointer
- * @param unsigned char 
- * @brief writes the char to the circular buffer reference
- * returns SUCCESS or ERROR
- **/
-static int8_t write_buffer(struct circular_buffer *buf, unsigned char c) {
-    if (is_buffer_full(buf) == FALSE) {
-        buf->data[buf->write_index] = c;
-        /*increment the write index and wrap using modulus arithmetic */
-        buf->write_index = (buf->write_index + 1) % BUFFER_LENGTH;
-        return SUCCESS;
+    if (tx_reserved == TRUE || fill_len >= limit) {
+        return 0;
     }
-    return ERROR; /*no data written*/
+    return limit - fill_len;
 }
 
 /**
- * @Function int read_from_buffer(struct oBuffer *buf)
- * @param circular buffer pointer   
- * @brief returns char at read index from the buffer
- * @return char at index or  0 if the buffer is empty or the pointer is invalid
+ * @Function start_block(void)
+ * @brief hands the block being filled to the DMA and fills the other one,
+ * called with the DMA interrupt masked or from the DMA ISR
+ * @author Aaron Hunter
  */
-static unsigned char read_from_buffer(struct circular_buffer *buf) {
-    unsigned char val;
-    if (is_buffer_empty(buf) == FALSE) {
-        val = buf->data[buf->read_index]; //get the char from the buffer
-        /*increment the read index and wrap using modulus arithmetic*/
-        buf->read_index = (buf->read_index + 1) % BUFFER_LENGTH;
-        return val;
-    }
-    return 0;
+static void start_block(void) {
+    dma_len = tx_fill_len[tx_fill];
+    dma_sent = 0;
+    dma_busy = TRUE;
+    tx_fill ^= 1;
+    start_chunk();
 }
 
 /**
- * @Function get_num_elements(struct circular buffer *buf)
- * @param buf, pointer to circular buffer
- * @brief returns the number of elements in buf
- * @return returns the number of elements in buf
+ * @Function start_chunk(void)
+ * @brief sends the next DMA_CHUNK bytes of the block, paced by the UART TX
+ * requests.  A FIFO with room raises no new request so the first byte is
+ * forced then.
+ * @author Aaron Hunter
  */
-static int16_t get_num_elements(struct circular_buffer *buf) {
-    if (buf != NULL) {
-        if (buf->write_index < buf->read_index) { /*test for wrap around*/
-            return (buf->write_index + BUFFER_LENGTH - buf->read_index);
-        } else {
-            return (buf->write_index - buf->read_index);
-        }
+static void start_chunk(void) {
+    dma_chunk = dma_len - dma_sent;
+    if (dma_chunk > DMA_CHUNK) {
+        dma_chunk = DMA_CHUNK;
+    }
+    DCH1SSA = KVA_TO_PA(&tx_block[tx_fill ^ 1][dma_sent]);
+    DCH1SSIZ = dma_chunk & 0xFF; // 0 is 256
+    DCH1CONbits.CHEN = 1;
+    if (U4STAbits.UTXBF == 0) {
+        DCH1ECONbits.CFORCE = 1;
     }
-    return 0;
 }
 
 
@@ -349,12 +432,12 @@ int main(void) {
     printf("Everything in Radio serial port window will be echoed here: \r\n");
     printf("**********************************************\r\n");
     sprintf(msg, "Testing Radio Serial Port\r\n");
-    for(i = 0;i < strlen(msg); i++ ){
-        Radio_put_char(msg[i]);
+    Radio_write(msg, strlen(msg));
+    printf("Is TX idle? %d \r\n", Radio_tx_idle());
+    while (Radio_tx_idle() == FALSE) {
+        ;
     }
-    printf("elements in TX circular buffer %d\r\n", get_num_elements(txp));
-    printf("Is TX buffer empty? %d \r\n", is_buffer_empty(txp));
-    printf("Is TX buffer full? %d \r\n", is_buffer_full(txp));
+    printf("Is TX idle? %d \r\n", Radio_tx_idle());
     
     while (1) {
         if(Radio_data_available() == TRUE){
@@ -12,16 +12,22 @@
 /*******************************************************************************
  * PUBLIC #INCLUDES                                                            *
  ******************************************************************************/
+#include <stdint.h>
 
 /*******************************************************************************
  * PUBLIC #DEFINES                                                             *
  ******************************************************************************/
-
+#define RADIO_TX_BLOCK_LENGTH 1024 // bytes queued while the other block is sent
+#define RADIO_TX_HEADROOM 256 // bytes at the end of each block only urgent frames may use
+#define RADIO_TX_BULK 0 // sensor streams and text
+#define RADIO_TX_URGENT 1 // acks, heartbeats and control outputs, still queued when bulk is refused
+#define RADIO_TX_CLASSES 2
 
 /*******************************************************************************
  * PUBLIC TYPEDEFS                                                             *
  ******************************************************************************/
-
+/* called from the DMA interrupt with the length of the block just sent */
+typedef void (*radio_tx_done_t)(uint16_t length);
 
 /*******************************************************************************
  * PUBLIC FUNCTION PROTOTYPES                                                  *
@@ -43,6 +49,76 @@ void Radio_serial_init(void);
  * @author Aaron Hunter*/
 char Radio_put_char(unsigned char c);
 
+/**
+ * @Function Radio_write(const uint8_t *data, uint16_t length)
+ * @param data, bytes to send
+ * @param length, number of bytes
+ * @return SUCCESS or ERROR if they do not fit, nothing is queued then
+ * @brief  queues a whole frame for the DMA, which feeds U4TXREG without
+ * interrupting the CPU until the block is done.  Two blocks of
+ * RADIO_TX_BLOCK_LENGTH alternate: one is sent while the other fills.  Bulk
+ * class, it cannot use the last RADIO_TX_HEADROOM bytes of a block.
+ * @author Aaron Hunter*/
+int8_t Radio_write(const uint8_t *data, uint16_t length);
+
+/**
+ * @Function Radio_reserve(uint16_t length, uint8_t priority)
+ * @param length, bytes of the frame about to be built
+ * @param priority, RADIO_TX_BULK or RADIO_TX_URGENT, urgent frames may also use
+ * the last RADIO_TX_HEADROOM bytes of the block so a link full of bulk
+ * traffic still takes them
+ * @return where to build it in the block being filled, NULL if it does not
+ * fit or a reservation is open
+ * @brief  zero-copy form of Radio_write(): fill the span in place, then
+ * Radio_commit() it.  The block is not handed to the DMA while the
+ * reservation is open and Radio_write() returns ERROR meanwhile.
+ * @author Aaron Hunter*/
+uint8_t *Radio_reserve(uint16_t length, uint8_t priority);
+
+/**
+ * @Function Radio_commit(uint16_t length)
+ * @param length, bytes filled at the reservation, 0 to give it back
+ * @return none
+ * @brief  queues the frame and starts the DMA if it is idle
+ * @author Aaron Hunter*/
+void Radio_commit(uint16_t length);
+
+/**
+ * @Function Radio_set_tx_done(radio_tx_done_t callback)
+ * @param callback, called with the length of each block sent, NULL for none
+ * @return none
+ * @brief  the callback runs in the DMA interrupt at priority 2
+ * @author Aaron Hunter*/
+void Radio_set_tx_done(radio_tx_done_t callback);
+
+/**
+ * @Function Radio_tx_idle(void)
+ * @return TRUE once everything written has been handed to the UART
+ * @author Aaron Hunter*/
+uint8_t Radio_tx_idle(void);
+
+/**
+ * @Function Radio_tx_space(uint8_t priority)
+ * @param priority, RADIO_TX_BULK or RADIO_TX_URGENT
+ * @return bytes a frame of the class can queue now, 0 while a frame is being
+ * built in place
+ * @author Aaron Hunter*/
+uint16_t Radio_tx_space(uint8_t priority);
+
+/**
+ * @Function Radio_tx_dropped(uint8_t priority)
+ * @param priority, RADIO_TX_BULK or RADIO_TX_URGENT
+ * @return frames of the class refused for want of room since init, whole
+ * frames, a frame is never cut
+ * @author Aaron Hunter*/
+uint32_t Radio_tx_dropped(uint8_t priority);
+
+/**
+ * @Function Radio_get_baud(void)
+ * @return baud rate the UART runs at, from its BRG
+ * @author Aaron Hunter*/
+uint32_t Radio_get_baud(void);
+
 /**
  * @Function Radio_get_char(void)
  * @return character read from receive buffer
@@ -57,6 +133,21 @@ unsigned char Radio_get_char(void);
  * @author Aaron Hunter*/
 unsigned char Radio_data_available(void);
 
+/**
+ * @Function Radio_read(uint8_t *data, uint16_t length)
+ * @param data, filled with the received bytes
+ * @param length, most bytes to read
+ * @return bytes read, 0 if nothing has arrived
+ * @brief  bulk form of Radio_get_char()
+ * @author Aaron Hunter*/
+uint16_t Radio_read(uint8_t *data, uint16_t length);
+
+/**
+ * @Function Radio_rx_dropped(void)
+ * @return bytes lost because the receive buffer was full
+ * @author Aaron Hunter*/
+uint32_t Radio_rx_dropped(void);
+
 
 
 #endif	/* RADIOSERIAL_H */ // End of header guard
@@ -0,0 +1,348 @@
+/*
+ * File:   Ring_buffer.c
+ * Brief: Lock-free single producer, single consumer byte ring.  The
+ * RING_TESTING harness is a host stress test, one thread writes and another
+ * reads with all the access functions mixed:
+ *     make -C sim ring_test
+ * Created on 10/16/2026
+ * Modified on 10/16/2026
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+
+#include "Ring_buffer.h" // The header file for this source file.
+#include "Board.h"
+#include <string.h>
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+/* orders the data accesses before the index store that publishes them and
+ * the index load before the data it covers: the sync instruction on the
+ * PIC32, a full fence on a multi core host */
+#define RING_BARRIER() __sync_synchronize()
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function Ring_init(ring_buffer_t *ring, uint8_t *data, uint32_t size)
+ * @param ring, ring to set up
+ * @param data, storage of size bytes
+ * @param size, a power of two
+ * @return SUCCESS or ERROR if size is not a power of two
+ * @brief empties the ring, call before either side uses it
+ * @author Aaron Hunter */
+int8_t Ring_init(ring_buffer_t *ring, uint8_t *data, uint32_t size) {
+    if (size == 0 || (size & (size - 1)) != 0) {
+        return ERROR;
+    }
+    ring->data = data;
+    ring->mask = size - 1;
+    ring->head = 0;
+    ring->tail = 0;
+    RING_BARRIER();
+    return SUCCESS;
+}
+
+/**
+ * @Function Ring_count(const ring_buffer_t *ring)
+ * @return bytes waiting, at least this many if called by the consumer
+ * @author Aaron Hunter */
+uint32_t Ring_count(const ring_buffer_t *ring) {
+    return ring->head - ring->tail;
+}
+
+/**
+ * @Function Ring_space(const ring_buffer_t *ring)
+ * @return free bytes, at least this many if called by the producer
+ * @author Aaron Hunter */
+uint32_t Ring_space(const ring_buffer_t *ring) {
+    return ring->mask + 1 - (ring->head - ring->tail);
+}
+
+/**
+ * @Function Ring_put(ring_buffer_t *ring, uint8_t c)
+ * @param c, byte to add
+ * @return SUCCESS or ERROR if the ring is full
+ * @brief producer side
+ * @author Aaron Hunter */
+int8_t Ring_put(ring_buffer_t *ring, uint8_t c) {
+    uint32_t head = ring->head;
+
+    if (head - ring->tail > ring->mask) {
+        return ERROR;
+    }
+    RING_BARRIER(); // the consumer is done with the slot before it is reused
+    ring->data[head & ring->mask] = c;
+    RING_BARRIER();
+    ring->head = head + 1;
+    return SUCCESS;
+}
+
+/**
+ * @Function Ring_get(ring_buffer_t *ring, uint8_t *c)
+ * @param c, set to the oldest byte
+ * @return SUCCESS or ERROR if the ring is empty
+ * @brief consumer side
+ * @author Aaron Hunter */
+int8_t Ring_get(ring_buffer_t *ring, uint8_t *c) {
+    uint32_t tail = ring->tail;
+
+    if (ring->head == tail) {
+        return ERROR;
+    }
+    RING_BARRIER();
+    *c = ring->data[tail & ring->mask];
+    RING_BARRIER();
+    ring->tail = tail + 1;
+    return SUCCESS;
+}
+
+/**
+ * @Function Ring_write(ring_buffer_t *ring, const uint8_t *data, uint16_t length)
+ * @param data, bytes to add
+ * @param length, number of bytes
+ * @return bytes written, fewer than length if the ring filled up
+ * @brief producer side, copies in at most two spans and publishes once.
+ * Check Ring_space() first to write all or nothing.
+ * @author Aaron Hunter */
+uint16_t Ring_write(ring_buffer_t *ring, const uint8_t *data, uint16_t length) {
+    uint32_t head = ring->head;
+    uint32_t space = ring->mask + 1 - (head - ring->tail);
+    uint32_t index = head & ring->mask;
+    uint32_t first;
+
+    if (length > space) {
+        length = space;
+    }
+    first = ring->mask + 1 - index; // bytes up to the end of the buffer
+    if (first > length) {
+        first = length;
+    }
+    RING_BARRIER();
+    memcpy(&ring->data[index], data, first);
+    memcpy(ring->data, data + first, length - first);
+    RING_BARRIER();
+    ring->head = head + length;
+    return length;
+}
+
+/**
+ * @Function Ring_read(ring_buffer_t *ring, uint8_t *data, uint16_t length)
+ * @param data, filled with the oldest bytes
+ * @param length, most bytes to read
+ * @return bytes read
+ * @brief consumer side, copies out at most two spans and frees them at once
+ * @author Aaron Hunter */
+uint16_t Ring_read(ring_buffer_t *ring, uint8_t *data, uint16_t length) {
+    uint32_t tail = ring->tail;
+    uint32_t count = ring->head - tail;
+    uint32_t index = tail & ring->mask;
+    uint32_t first;
+
+    if (length > count) {
+        length = count;
+    }
+    first = ring->mask + 1 - index;
+    if (first > length) {
+        first = length;
+    }
+    RING_BARRIER();
+    memcpy(data, &ring->data[index], first);
+    memcpy(data + first, ring->data, length - first);
+    RING_BARRIER();
+    ring->tail = tail + length;
+    return length;
+}
+
+/**
+ * @Function Ring_write_span(ring_buffer_t *ring, uint8_t **span)
+ * @param span, set to the first free byte
+ * @return contiguous free bytes at span, 0 if the ring is full
+ * @brief producer side, fill the span in place then Ring_commit() it
+ * @author Aaron Hunter */
+uint32_t Ring_write_span(ring_buffer_t *ring, uint8_t **span) {
+    uint32_t head = ring->head;
+    uint32_t space = ring->mask + 1 - (head - ring->tail);
+    uint32_t index = head & ring->mask;
+    uint32_t first = ring->mask + 1 - index;
+
+    RING_BARRIER();
+    *span = &ring->data[index];
+    return first < space ? first : space;
+}
+
+/**
+ * @Function Ring_commit(ring_buffer_t *ring, uint32_t length)
+ * @param length, bytes filled at the span, no more than its length
+ * @return none
+ * @brief producer side, publishes the bytes to the consumer
+ * @author Aaron Hunter */
+void Ring_commit(ring_buffer_t *ring, uint32_t length) {
+    RING_BARRIER();
+    ring->head += length;
+}
+
+/**
+ * @Function Ring_read_span(ring_buffer_t *ring, const uint8_t **span)
+ * @param span, set to the oldest byte
+ * @return contiguous bytes waiting at span, 0 if the ring is empty
+ * @brief consumer side, use the span in place then Ring_consume() it
+ * @author Aaron Hunter */
+uint32_t Ring_read_span(ring_buffer_t *ring, const uint8_t **span) {
+    uint32_t tail = ring->tail;
+    uint32_t count = ring->head - tail;
+    uint32_t index = tail & ring->mask;
+    uint32_t first = ring->mask + 1 - index;
+
+    RING_BARRIER();
+    *span = &ring->data[index];
+    return first < count ? first : count;
+}
+
+/**
+ * @Function Ring_consume(ring_buffer_t *ring, uint32_t length)
+ * @param length, bytes used at the span, no more than its length
+ * @return none
+ * @brief consumer side, frees the bytes for the producer
+ * @author Aaron Hunter */
+void Ring_consume(ring_buffer_t *ring, uint32_t length) {
+    RING_BARRIER();
+    ring->tail += length;
+}
+
+#ifdef RING_TESTING
+/* host only: two threads stand in for the ISR and the main loop */
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define TEST_SIZE 256 // small so the indices wrap often
+#define TEST_BYTES 20000000u
+
+static uint8_t test_data[TEST_SIZE];
+static ring_buffer_t test_ring;
+
+/* byte n of the stream, the period is prime so a slip of any length shows */
+static uint8_t stream_byte(uint32_t n) {
+    return (uint8_t) (n % 251);
+}
+
+/* xorshift, each thread its own */
+static uint32_t next_random(uint32_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+static void *producer(void *arg) {
+    uint8_t chunk[64];
+    uint8_t *span;
+    uint32_t sent = 0;
+    uint32_t seed = 12345;
+    uint32_t length;
+    uint32_t i;
+
+    while (sent < TEST_BYTES) {
+        if (Ring_space(&test_ring) == 0) {
+            sched_yield(); // a single core host has to run the consumer
+        }
+        switch (next_random(&seed) % 3) {
+            case 0:
+                if (Ring_put(&test_ring, stream_byte(sent)) == SUCCESS) {
+                    sent++;
+                }
+                break;
+            case 1:
+                length = next_random(&seed) % sizeof (chunk) + 1;
+                length = length < TEST_BYTES - sent ? length : TEST_BYTES - sent;
+                for (i = 0; i < length; i++) {
+                    chunk[i] = stream_byte(sent + i);
+                }
+                sent += Ring_write(&test_ring, chunk, (uint16_t) length);
+                break;
+            default:
+                length = Ring_write_span(&test_ring, &span);
+                length = length < TEST_BYTES - sent ? length : TEST_BYTES - sent;
+                for (i = 0; i < length; i++) {
+                    span[i] = stream_byte(sent + i);
+                }
+                Ring_commit(&test_ring, length);
+                sent += length;
+                break;
+        }
+    }
+    return NULL;
+}
+
+int main(void) {
+    pthread_t thread;
+    struct timespec start;
+    struct timespec end;
+    uint8_t chunk[64];
+    const uint8_t *span;
+    uint32_t received = 0;
+    uint32_t errors = 0;
+    uint32_t seed = 67890;
+    uint32_t length;
+    uint32_t i;
+    uint8_t c;
+    double seconds;
+
+    printf("Ring buffer host stress test, %u bytes through a %d byte ring\r\n",
+            TEST_BYTES, TEST_SIZE);
+    if (Ring_init(&test_ring, test_data, 100) != ERROR) {
+        printf("FAIL: size 100 accepted\r\n");
+        errors++;
+    }
+    Ring_init(&test_ring, test_data, TEST_SIZE);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pthread_create(&thread, NULL, producer, NULL);
+    while (received < TEST_BYTES) {
+        if (Ring_count(&test_ring) == 0) {
+            sched_yield();
+        }
+        switch (next_random(&seed) % 3) {
+            case 0:
+                if (Ring_get(&test_ring, &c) == SUCCESS) {
+                    errors += c != stream_byte(received);
+                    received++;
+                }
+                break;
+            case 1:
+                length = Ring_read(&test_ring, chunk, next_random(&seed) % sizeof (chunk) + 1);
+                for (i = 0; i < length; i++) {
+                    errors += chunk[i] != stream_byte(received + i);
+                }
+                received += length;
+                break;
+            default:
+                length = Ring_read_span(&test_ring, &span);
+                for (i = 0; i < length; i++) {
+                    errors += span[i] != stream_byte(received + i);
+                }
+                Ring_consume(&test_ring, length);
+                received += length;
+                break;
+        }
+    }
+    pthread_join(thread, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+    if (Ring_count(&test_ring) != 0) {
+        printf("FAIL: %u bytes left over\r\n", Ring_count(&test_ring));
+        errors++;
+    }
+    printf("%u bytes in %.2f s, %.1f MB/s, %u errors\r\n", received, seconds,
+            received / seconds * 1e-6, errors);
+    printf("%s\r\n", errors ? "FAILED" : "PASSED");
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+#endif //RING_TESTING
@@ -0,0 +1,130 @@
+/*
+ * File:   Ring_buffer.h
+ * Brief: Lock-free single producer, single consumer byte ring shared by the
+ * UART drivers.  One side (typically an ISR) only writes and the other only
+ * reads, so neither has to mask the other's interrupt.  The head is stored
+ * by the producer only and the tail by the consumer only; both run free and
+ * are masked into a power of two buffer, count = head - tail.  A barrier
+ * orders the data accesses before the index store that publishes them.
+ * Spans give direct access to the contiguous part of the buffer for bulk
+ * copies or for filling in place.
+ * Created on 10/16/2026
+ * Modified on 10/16/2026
+ */
+
+#ifndef RING_BUFFER_H // Header guard
+#define	RING_BUFFER_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+#include <stdint.h>
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+typedef struct {
+    volatile uint32_t head; // bytes ever written, stored by the producer only
+    volatile uint32_t tail; // bytes ever read, stored by the consumer only
+    uint32_t mask; // size - 1
+    uint8_t *data;
+} ring_buffer_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function Ring_init(ring_buffer_t *ring, uint8_t *data, uint32_t size)
+ * @param ring, ring to set up
+ * @param data, storage of size bytes
+ * @param size, a power of two
+ * @return SUCCESS or ERROR if size is not a power of two
+ * @brief empties the ring, call before either side uses it
+ * @author Aaron Hunter */
+int8_t Ring_init(ring_buffer_t *ring, uint8_t *data, uint32_t size);
+
+/**
+ * @Function Ring_count(const ring_buffer_t *ring)
+ * @return bytes waiting, at least this many if called by the consumer
+ * @author Aaron Hunter */
+uint32_t Ring_count(const ring_buffer_t *ring);
+
+/**
+ * @Function Ring_space(const ring_buffer_t *ring)
+ * @return free bytes, at least this many if called by the producer
+ * @author Aaron Hunter */
+uint32_t Ring_space(const ring_buffer_t *ring);
+
+/**
+ * @Function Ring_put(ring_buffer_t *ring, uint8_t c)
+ * @param c, byte to add
+ * @return SUCCESS or ERROR if the ring is full
+ * @brief producer side
+ * @author Aaron Hunter */
+int8_t Ring_put(ring_buffer_t *ring, uint8_t c);
+
+/**
+ * @Function Ring_get(ring_buffer_t *ring, uint8_t *c)
+ * @param c, set to the oldest byte
+ * @return SUCCESS or ERROR if the ring is empty
+ * @brief consumer side
+ * @author Aaron Hunter */
+int8_t Ring_get(ring_buffer_t *ring, uint8_t *c);
+
+/**
+ * @Function Ring_write(ring_buffer_t *ring, const uint8_t *data, uint16_t length)
+ * @param data, bytes to add
+ * @param length, number of bytes
+ * @return bytes written, fewer than length if the ring filled up
+ * @brief producer side, copies in at most two spans and publishes once.
+ * Check Ring_space() first to write all or nothing.
+ * @author Aaron Hunter */
+uint16_t Ring_write(ring_buffer_t *ring, const uint8_t *data, uint16_t length);
+
+/**
+ * @Function Ring_read(ring_buffer_t *ring, uint8_t *data, uint16_t length)
+ * @param data, filled with the oldest bytes
+ * @param length, most bytes to read
+ * @return bytes read
+ * @brief consumer side, copies out at most two spans and frees them at once
+ * @author Aaron Hunter */
+uint16_t Ring_read(ring_buffer_t *ring, uint8_t *data, uint16_t length);
+
+/**
+ * @Function Ring_write_span(ring_buffer_t *ring, uint8_t **span)
+ * @param span, set to the first free byte
+ * @return contiguous free bytes at span, 0 if the ring is full
+ * @brief producer side, fill the span in place then Ring_commit() it
+ * @author Aaron Hunter */
+uint32_t Ring_write_span(ring_buffer_t *ring, uint8_t **span);
+
+/**
+ * @Function Ring_commit(ring_buffer_t *ring, uint32_t length)
+ * @param length, bytes filled at the span, no more than its length
+ * @return none
+ * @brief producer side, publishes the bytes to the consumer
+ * @author Aaron Hunter */
+void Ring_commit(ring_buffer_t *ring, uint32_t length);
+
+/**
+ * @Function Ring_read_span(ring_buffer_t *ring, const uint8_t **span)
+ * @param span, set to the oldest byte
+ * @return contiguous bytes waiting at span, 0 if the ring is empty
+ * @brief consumer side, use the span in place then Ring_consume() it
+ * @author Aaron Hunter */
+uint32_t Ring_read_span(ring_buffer_t *ring, const uint8_t **span);
+
+/**
+ * @Function Ring_consume(ring_buffer_t *ring, uint32_t length)
+ * @param length, bytes used at the span, no more than its length
+ * @return none
+ * @brief consumer side, frees the bytes for the producer
+ * @author Aaron Hunter */
+void Ring_consume(ring_buffer_t *ring, uint32_t length);
+
+#endif	/* RING_BUFFER_H */ // End of header guard
@@ -3,7 +3,7 @@
  * Author: Aaron Hunter
  * Brief: 
  * Created on November 10, 2020, 9:52 am
- * Modified on November 11/2020 9:27 am
+ * Modified on 10/16/2026
  */
 
 /*******************************************************************************
@@ -11,52 +11,65 @@
  ******************************************************************************/
 
 #include "SerialM32.h" // The header file for this source file. 
-#include "Board.H"   //Max32 setup      
+#include "Board.h"   //Max32 setup      
+#include "Ring_buffer.h"
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 #include <sys/types.h>
 #include <sys/attribs.h>  //for ISR definitions
+#include <sys/kmem.h> //for KVA_TO_PA()
 #include <proc/p32mx795f512l.h>
 
 /*******************************************************************************
  * PRIVATE #DEFINES                                                            *
  ******************************************************************************/
-#define BUFFER_LENGTH 2048
+#define BUFFER_LENGTH 2048 // power of two for the ring
 #define MESSAGE_LENGTH 128
-#define BAUD_RATE 115200
+#define DMA_CHUNK 256 // largest DMA block, the cell counters are 8 bits
+#define SERIAL_BAUD_MAX 1000000 // the FIFO holds 8 bytes, 80 usec at this rate
+#define UEN_FLOW 2 // U1TX, U1RX, U1CTS and U1RTS
 
 /*******************************************************************************
  * PRIVATE TYPEDEFS                                                            *
  ******************************************************************************/
-struct circular_buffer {
-    int read_index;
-    int write_index;
-    int size;
-    unsigned char data[BUFFER_LENGTH];
-}; /*circular  buffer */
-
-struct circular_buffer tx_buffer; /*Circular UART TX buffer */
-struct circular_buffer rx_buffer; /*Circular UART RX buffer */
-
-/*pointers to the buffers so we don't pass the entire buffer to the functions*/
-struct circular_buffer *txp = &tx_buffer;
-struct circular_buffer *rxp = &rx_buffer;
-
-static int8_t tx_collision = FALSE;
-static int8_t rx_collision = FALSE;
-static int8_t writing_tx_buffer = FALSE;
-static int8_t reading_rx_buffer = FALSE;
-static int8_t new_char_avail = FALSE;
+/* RX ring: the U1 ISR writes, the main loop reads */
+static uint8_t rx_data[BUFFER_LENGTH];
+static ring_buffer_t rx_ring;
+static volatile uint32_t rx_dropped = 0; // bytes lost to a full ring
+static volatile uint32_t rx_errors = 0; // framing errors and FIFO overruns
+
+/* TX blocks: DMA channel 0 sends one while the other one fills */
+static uint8_t tx_block[2][SERIAL_TX_BLOCK_LENGTH];
+static volatile uint16_t tx_fill_len[2];
+static volatile uint8_t tx_fill = 0; // block taking new data
+static volatile uint8_t dma_busy = FALSE;
+static volatile uint8_t tx_reserved = FALSE; // a frame is being built in place
+static volatile uint16_t dma_len = 0; // length of the block being sent
+static volatile uint16_t dma_sent = 0; // bytes of it handed to the UART
+static volatile uint16_t dma_chunk = 0; // bytes in the current DMA transfer
+static serial_tx_done_t tx_done = NULL;
+static volatile uint32_t tx_dropped[SERIAL_TX_CLASSES]; // frames refused per class
+static uint8_t line[MESSAGE_LENGTH]; // printf() text until the end of the line
+static uint8_t line_len = 0;
+
+/* rate change waiting for the old rate's bytes to leave */
+static volatile uint8_t baud_pending = FALSE;
+static volatile uint8_t baud_switched = FALSE; // the DMA ISR restarts the blocks
+static uint16_t next_brg;
+static uint8_t next_brgh;
+static uint8_t next_uen;
+
 
 /*******************************************************************************
  * PRIVATE FUNCTIONS PROTOTYPES                                                 *
  ******************************************************************************/
-static void init_buffer(struct circular_buffer *buf);
-static int8_t is_buffer_empty(struct circular_buffer *buf);
-static int8_t is_buffer_full(struct circular_buffer *buf);
-static int8_t write_buffer(struct circular_buffer *buf, unsigned char c);
-static unsigned char read_from_buffer(struct circular_buffer *buf);
-static int get_num_elements(struct circular_buffer *buf);
+static void start_block(void);
+static void start_chunk(void);
+static void next_block(void);
+static void wait_tx_empty(void);
+static uint16_t tx_room(uint8_t priority);
+static float baud_divider(uint32_t baud, uint16_t *brg, uint8_t *brgh);
 
 /*******************************************************************************
  * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
@@ -69,14 +82,24 @@ static int get_num_elements(struct circular_buffer *buf);
  * @brief enables UART and interrupts
  * @author ahunter*/
 void Serial_init(void) {
-    /*Initialize the circular buffers*/
-    init_buffer(rxp);
-    init_buffer(txp);
+    /*Initialize the buffers*/
+    Ring_init(&rx_ring, rx_data, BUFFER_LENGTH);
+    rx_dropped = 0;
+    rx_errors = 0;
+    baud_pending = FALSE;
+    baud_switched = FALSE;
+    tx_fill_len[0] = tx_fill_len[1] = 0;
+    tx_fill = 0;
+    dma_busy = FALSE;
+    tx_reserved = FALSE;
+    tx_dropped[SERIAL_TX_BULK] = tx_dropped[SERIAL_TX_URGENT] = 0;
+    line_len = 0;
     /* turn off UART while configuring */
     U1MODEbits.ON = 0;
     __builtin_disable_interrupts();
-    U1MODEbits.BRGH = 0; //M = 16
-    U1BRG = ((Board_get_PB_clock() / BAUD_RATE) / 16) - 1; //set baud rate
+    baud_divider(SERIAL_BAUD_DEFAULT, &next_brg, &next_brgh);
+    U1MODEbits.BRGH = next_brgh; //M = 16 or 4
+    U1BRG = next_brg; //set baud rate
     /* configure the RX and TX pins */
     U1STAbits.UTXEN = 1;
     U1STAbits.URXEN = 1;
@@ -84,16 +107,33 @@ void Serial_init(void) {
     if (U1STAbits.OERR == 1) {
         U1STAbits.OERR = 0;
     }
-    /* configure using software flow control, if set to 2 it would be CTS/RTS */
+    /* no flow control until Serial_set_baud() asks for RTS/CTS */
     U1MODEbits.UEN = 0;
+    U1MODEbits.RTSMD = 0; // RTS flow control mode once it is on
     /*configure UART interrupts */
     U1STAbits.URXISEL = 0x0; //interrupt when buffer is not empty
-    U1STAbits.UTXISEL = 0x01; // int when all characters are sent (TRMT == TRUE)
+    U1STAbits.UTXISEL = 0x0; // TX request while the FIFO has room, paces the DMA
     IFS0bits.U1RXIF = 0; //clear interrupt flags
     IFS0bits.U1TXIF = 0;
     IPC6bits.U1IP = 1; //set interrupt priority to 1 
     IEC0bits.U1RXIE = 1; //enable interrupt on RX
-    IEC0bits.U1TXIE = 1; //enable interrupts on TX
+    IFS0bits.U1EIF = 0;
+    IEC0bits.U1EIE = 1; // count framing errors and overruns
+    IEC0bits.U1TXIE = 0; //TX is fed by the DMA, the CPU does not see it
+    /* DMA channel 0 moves the TX blocks into U1TXREG, one byte per TX request */
+    DMACONbits.ON = 1;
+    DCH0CON = 0;
+    DCH0ECON = 0;
+    DCH0ECONbits.CHSIRQ = _UART1_TX_IRQ;
+    DCH0ECONbits.SIRQEN = 1;
+    DCH0DSA = KVA_TO_PA(&U1TXREG);
+    DCH0DSIZ = 1;
+    DCH0CSIZ = 1;
+    DCH0INT = 0;
+    DCH0INTbits.CHBCIE = 1; //interrupt when the block is done
+    IFS1bits.DMA0IF = 0;
+    IPC9bits.DMA0IP = 1;
+    IEC1bits.DMA0IE = 1;
     /* turn on UART*/
     U1MODEbits.ON = 1;
     __builtin_enable_interrupts();
@@ -101,41 +141,76 @@ void Serial_init(void) {
 
 /**
  * @Function IntUart1Handler(void)
- * @brief Handles the UART interrupts
+ * @brief Handles the UART interrupts, the TX interrupt only runs to switch
+ * the rate once the transmitter is empty
  * @note 
  * @author Aaron Hunter
  * @modified  */
 void __ISR(_UART_1_VECTOR, IPL1SOFT) IntUart1Handler(void) {
     if (IFS0bits.U1RXIF) { //check for received data flag
-        if (is_buffer_full(rxp) == FALSE) {
-            if (reading_rx_buffer == FALSE) {
-                write_buffer(rxp, U1RXREG);
-            } else {
-                /*a collision occurred need to disable interrupts to exit ISR*/
-                /*it will be re-enabled in get_char() */
-                rx_collision = TRUE;
-                IEC0bits.U1RXIE = 0;
+        while (U1STAbits.URXDA) { // empty the FIFO, the ring never blocks
+            if (U1STAbits.FERR) { // flags the byte at the top of the FIFO
+                rx_errors++;
+            }
+            if (Ring_put(&rx_ring, U1RXREG) == ERROR) {
+                rx_dropped++;
             }
         }
         IFS0bits.U1RXIF = 0; // clear the flag
-    } else if (IFS0bits.U1TXIF) { /*check for transmission flag*/
-        if (is_buffer_empty(txp) == TRUE) { //if tx circular buffer is empty
-            IEC0bits.U1TXIE = 0; //disable interrupts on TX
-        } else if (writing_tx_buffer == FALSE) { /*If not being accessed */
-            U1TXREG = read_from_buffer(txp);
-        } else {
-            /*a collision occurred, turn off interrupt to exit ISR*/
-            /*it will be re-enabled in put_char()*/
-            tx_collision = TRUE;
-            IEC0bits.U1TXIE = 0;
-        }
-        IFS0bits.U1TXIF = 0; /*clear the interrupt flag*/
-    } else if (IFS0bits.U1EIF) { //error flag--can check U1STA for the reason
+    }
+    if (IFS0bits.U1EIF) { //error flag--can check U1STA for the reason
         if (U1STAbits.OERR == 1) {
+            rx_errors++;
             U1STAbits.OERR = 0; //over run error is the only one we can write to clear
         }
         IFS0bits.U1EIF = 0;
     }
+    if (IEC0bits.U1TXIE && IFS0bits.U1TXIF) { // the last byte at the old rate is out
+        IEC0bits.U1TXIE = 0;
+        U1STAbits.UTXISEL = 0x0; // back to pacing the DMA
+        U1MODEbits.ON = 0;
+        U1MODEbits.BRGH = next_brgh;
+        U1BRG = next_brg;
+        U1MODEbits.UEN = next_uen;
+        U1MODEbits.ON = 1;
+        U1STAbits.UTXEN = 1;
+        baud_pending = FALSE;
+        baud_switched = TRUE;
+        IFS0bits.U1TXIF = 0;
+        IFS1bits.DMA0IF = 1; // the DMA ISR owns the blocks
+    }
+}
+
+/**
+ * @Function IntDma0Handler(void)
+ * @brief continues the block in DMA_CHUNK transfers, then reports it and
+ * starts the block filled meanwhile
+ * @author Aaron Hunter */
+void __ISR(_DMA_0_VECTOR, IPL1SOFT) IntDma0Handler(void) {
+    uint16_t length;
+
+    DCH0INTbits.CHBCIF = 0;
+    IFS1bits.DMA0IF = 0;
+    if (baud_switched == TRUE) { // raised by the UART ISR, at the new rate now
+        baud_switched = FALSE;
+        next_block();
+        return;
+    }
+    dma_sent += dma_chunk;
+    if (dma_sent < dma_len) {
+        start_chunk();
+        return;
+    }
+    length = dma_len;
+    tx_fill_len[tx_fill ^ 1] = 0; // the block sent is free to fill
+    if (baud_pending == TRUE) {
+        wait_tx_empty(); // the block filled meanwhile goes at the new rate
+    } else {
+        next_block();
+    }
+    if (tx_done != NULL) {
+        tx_done(length);
+    }
 }
 
 /**
@@ -144,21 +219,211 @@ void __ISR(_UART_1_VECTOR, IPL1SOFT) IntUart1Handler(void) {
  * @brief  returns the value in the receive buffer
  * @author Aaron Hunter*/
 unsigned char get_char(void) {
-    unsigned char c;
-    if (is_buffer_empty(rxp) == FALSE) {
-        reading_rx_buffer = TRUE; /*set buffer access flag*/
-        c = read_from_buffer(rxp);
-        reading_rx_buffer = FALSE;
-        //if a collision occurred we need to re-enable interrupts
-        if (rx_collision == TRUE) {
-            rx_collision = FALSE;
-            IEC0bits.U1RXIE = 1;
-        }
+    uint8_t c;
+    if (Ring_get(&rx_ring, &c) == SUCCESS) {
         return c;
     }
     return 0; /*no data available*/
 }
 
+/**
+ * @Function Serial_read(uint8_t *data, uint16_t length)
+ * @param data, filled with the received bytes
+ * @param length, most bytes to read
+ * @return bytes read
+ * @brief copies what has arrived in at most two spans
+ * @author Aaron Hunter*/
+uint16_t Serial_read(uint8_t *data, uint16_t length) {
+    return Ring_read(&rx_ring, data, length);
+}
+
+/**
+ * @Function Serial_rx_dropped(void)
+ * @return bytes lost because the receive buffer was full
+ * @author Aaron Hunter*/
+uint32_t Serial_rx_dropped(void) {
+    return rx_dropped;
+}
+
+/**
+ * @Function Serial_rx_errors(void)
+ * @return bytes received with a framing error and receive FIFO overruns since
+ * init
+ * @author Aaron Hunter*/
+uint32_t Serial_rx_errors(void) {
+    return rx_errors;
+}
+
+/**
+ * @Function Serial_data_available(void)
+ * @return TRUE or FALSE
+ * @brief responds with TRUE if the receive buffer is not empty, get_char()
+ * returns 0 for an empty buffer so binary data needs this check
+ * @author Aaron Hunter*/
+unsigned char Serial_data_available(void) {
+    return (Ring_count(&rx_ring) > 0);
+}
+
+/**
+ * @Function Serial_write(const uint8_t *data, uint16_t length)
+ * @param data, bytes to send
+ * @param length, number of bytes
+ * @return SUCCESS or ERROR if the block being filled has no room for all of
+ * them, nothing is queued then so a frame is never cut
+ * @brief copies the bytes into the block being filled and starts the DMA if
+ * it is idle, bulk class
+ * @author Aaron Hunter */
+int8_t Serial_write(const uint8_t *data, uint16_t length) {
+    uint8_t ie = IEC1bits.DMA0IE;
+    uint16_t fill_len;
+
+    IEC1bits.DMA0IE = 0; // the DMA ISR swaps the blocks
+    if (length > tx_room(SERIAL_TX_BULK)) {
+        tx_dropped[SERIAL_TX_BULK]++;
+        IEC1bits.DMA0IE = ie;
+        return ERROR;
+    }
+    fill_len = tx_fill_len[tx_fill];
+    memcpy(&tx_block[tx_fill][fill_len], data, length);
+    tx_fill_len[tx_fill] = fill_len + length;
+    if (dma_busy == FALSE) {
+        start_block();
+    }
+    IEC1bits.DMA0IE = ie;
+    return SUCCESS;
+}
+
+/**
+ * @Function Serial_reserve(uint16_t length, uint8_t priority)
+ * @param length, bytes of the frame about to be built
+ * @param priority, SERIAL_TX_BULK or SERIAL_TX_URGENT
+ * @return where to build it in the block being filled, NULL if it does not
+ * fit or a reservation is open
+ * @brief holds the block being filled until Serial_commit()
+ * @author Aaron Hunter */
+uint8_t *Serial_reserve(uint16_t length, uint8_t priority) {
+    uint8_t ie = IEC1bits.DMA0IE;
+    uint8_t *span = NULL;
+
+    priority = priority == SERIAL_TX_URGENT ? SERIAL_TX_URGENT : SERIAL_TX_BULK;
+    IEC1bits.DMA0IE = 0; // the DMA ISR swaps the blocks
+    if (length <= tx_room(priority)) {
+        span = &tx_block[tx_fill][tx_fill_len[tx_fill]];
+        tx_reserved = TRUE;
+    } else {
+        tx_dropped[priority]++;
+    }
+    IEC1bits.DMA0IE = ie;
+    return span;
+}
+
+/**
+ * @Function Serial_commit(uint16_t length)
+ * @param length, bytes filled at the reservation, 0 to give it back
+ * @return none
+ * @brief queues the frame and starts the DMA if it is idle, a block that
+ * finished while the frame was built left the DMA idle too
+ * @author Aaron Hunter */
+void Serial_commit(uint16_t length) {
+    uint8_t ie = IEC1bits.DMA0IE;
+
+    IEC1bits.DMA0IE = 0;
+    tx_fill_len[tx_fill] += length;
+    tx_reserved = FALSE;
+    if (dma_busy == FALSE && tx_fill_len[tx_fill] > 0) {
+        start_block();
+    }
+    IEC1bits.DMA0IE = ie;
+}
+
+/**
+ * @Function Serial_set_tx_done(serial_tx_done_t callback)
+ * @param callback, called from the DMA interrupt with the length of each
+ * block sent, NULL for none
+ * @return none
+ * @author Aaron Hunter */
+void Serial_set_tx_done(serial_tx_done_t callback) {
+    tx_done = callback;
+}
+
+/**
+ * @Function Serial_tx_idle(void)
+ * @return TRUE once everything written has been handed to the UART
+ * @author Aaron Hunter */
+uint8_t Serial_tx_idle(void) {
+    return (dma_busy == FALSE);
+}
+
+/**
+ * @Function Serial_tx_space(uint8_t priority)
+ * @param priority, SERIAL_TX_BULK or SERIAL_TX_URGENT
+ * @return bytes a frame of the class can queue now, 0 while a frame is being
+ * built in place
+ * @author Aaron Hunter */
+uint16_t Serial_tx_space(uint8_t priority) {
+    uint8_t ie = IEC1bits.DMA0IE;
+    uint16_t space;
+
+    IEC1bits.DMA0IE = 0; // the DMA ISR swaps the blocks
+    space = tx_room(priority);
+    IEC1bits.DMA0IE = ie;
+    return space;
+}
+
+/**
+ * @Function Serial_tx_dropped(uint8_t priority)
+ * @param priority, SERIAL_TX_BULK or SERIAL_TX_URGENT
+ * @return frames of the class refused for want of room since init
+ * @author Aaron Hunter */
+uint32_t Serial_tx_dropped(uint8_t priority) {
+    return priority == SERIAL_TX_URGENT ? tx_dropped[SERIAL_TX_URGENT] : tx_dropped[SERIAL_TX_BULK];
+}
+
+/**
+ * @Function Serial_set_baud(uint32_t baud, uint8_t flow)
+ * @param baud, new rate, 1 Mbaud at most
+ * @param flow, SERIAL_FLOW_NONE or SERIAL_FLOW_RTS_CTS
+ * @return SUCCESS or ERROR if the BRG cannot make the rate within
+ * SERIAL_BAUD_TOLERANCE
+ * @brief sets up the switch, an idle DMA is held at once so a frame written
+ * now waits for the new rate, a busy one at the end of its block
+ * @author Aaron Hunter */
+int8_t Serial_set_baud(uint32_t baud, uint8_t flow) {
+    uint8_t ie = IEC1bits.DMA0IE;
+    uint8_t tx_ie = IEC0bits.U1TXIE;
+    uint16_t brg;
+    uint8_t brgh;
+
+    if (baud == 0 || baud > SERIAL_BAUD_MAX
+            || fabsf(baud_divider(baud, &brg, &brgh)) > SERIAL_BAUD_TOLERANCE) {
+        return ERROR;
+    }
+    IEC1bits.DMA0IE = 0; // the DMA ISR swaps the blocks
+    IEC0bits.U1TXIE = 0; // and the UART ISR reads the new setting
+    next_brg = brg;
+    next_brgh = brgh;
+    next_uen = flow == SERIAL_FLOW_RTS_CTS ? UEN_FLOW : 0;
+    if (baud_pending == FALSE) {
+        baud_pending = TRUE;
+        if (dma_busy == FALSE) {
+            dma_busy = TRUE;
+            wait_tx_empty();
+            tx_ie = TRUE;
+        }
+    }
+    IEC0bits.U1TXIE = tx_ie;
+    IEC1bits.DMA0IE = ie;
+    return SUCCESS;
+}
+
+/**
+ * @Function Serial_get_baud(void)
+ * @return baud rate the UART runs at, from its BRG and BRGH
+ * @author Aaron Hunter */
+uint32_t Serial_get_baud(void) {
+    return Board_get_PB_clock() / ((U1MODEbits.BRGH ? 4 : 16) * (U1BRG + 1));
+}
+
 /**
  * @Function int8_t put_char(unsigned char c) 
  * @param c, unsigned char to put into transmit buffer
@@ -166,22 +431,7 @@ unsigned char get_char(void) {
  * @brief 
  * @author Aaron Hunter */
 char put_char(unsigned char c) {
-    if (is_buffer_full(txp) == FALSE) { //if the buffer isn't full
-        writing_tx_buffer = TRUE; // set flag so that interrupt can't access the buffer
-        write_buffer(txp, c); // write to buffer 
-        writing_tx_buffer = FALSE; // allow buffer access
-        /*if interrupt isn't set, it needs to be enabled.  Note this is slightly
-         * different from get_char because the module starts with no interrupts
-         * so there are two reasons for disabled interrupts:  empty transmit
-         * buffer or a collision.  Either way we need to re-enable them */
-        if (IEC0bits.U1TXIE == 0) {
-            tx_collision = FALSE;
-            IEC0bits.U1TXIE = 1;
-        }
-        return SUCCESS;
-    } else {
-        return ERROR; //buffer is full!
-    }
+    return Serial_write(&c, 1);
 }
 
 /**
@@ -189,89 +439,114 @@ char put_char(unsigned char c) {
  * @param c - char to be sent
  * @return None.
  * @brief  overwrites weakly define extern to use circular buffer instead of Microchip 
- * functions
+ * functions.  printf() text is held until the end of the line, then queued
+ * whole, so a full block drops lines rather than cutting them.
  * @author Max Dunne, 2011.11.10 */
 void _mon_putc(char c) {
-    put_char(c);
+    line[line_len++] = c;
+    if (c == '\n' || c == '\r' || line_len == MESSAGE_LENGTH) {
+        Serial_write(line, line_len);
+        line_len = 0;
+    }
 }
 
 /*******************************************************************************
  * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
  ******************************************************************************/
 
-static void init_buffer(struct circular_buffer *buf) {
-    int i;
-    buf->read_index = 0; /*initialize read index to 0 */
-    buf->write_index = 0; /*initialize write index to 0 */
-    buf->size = BUFFER_LENGTH; /*Set size to buffer length const*/
-    for (i = 0; i < BUFFER_LENGTH; i++) { /*initialize data to zero*/
-        buf->data[i] = 0;
-    } /*end for */
+/* tx_room(uint8_t priority)
+ * bytes a frame of the class can take in the block being filled, the last
+ * SERIAL_TX_HEADROOM are kept for urgent frames, called with the DMA
+ * interrupt masked
+ */
+static uint16_t tx_room(uint8_t priority) {
+    uint16_t limit = priority == SERIAL_TX_URGENT ? SERIAL_TX_BLOCK_LENGTH
+            : SERIAL_TX_BLOCK_LENGTH - SERIAL_TX_HEADROOM;
+    uint16_t fill_len = tx_fill_len[tx_fill];
+
+    if (tx_reserved == TRUE || fill_len >= limit) {
+        return 0;
+    }
+    return limit - fill_len;
 }
 
-/* function int is_buffer_empty(struct circular_buffer *buf)
- * takes a pointer to a circular buffer and compares the read and write indices
- * if they are equal then the buffer is empty
+/* start_block(void)
+ * hands the block being filled to the DMA and fills the other one, called
+ * with the DMA interrupt masked or from the DMA ISR
  */
-static int8_t is_buffer_empty(struct circular_buffer *buf) {
-    if (buf->read_index == buf->write_index) { //if read = write then the buffer is empty
-        return TRUE;
-    }
-    return FALSE;
+static void start_block(void) {
+    dma_len = tx_fill_len[tx_fill];
+    dma_sent = 0;
+    dma_busy = TRUE;
+    tx_fill ^= 1;
+    start_chunk();
 }
 
-/*  bufFull(struct oBuffer *buf)
- * takes a pointer to a circular buffer and compares the read and write indices
- * if write+1 = read, then the buffer is full. 
+/* next_block(void)
+ * starts the block filled while the last one was sent, or leaves the DMA
+ * idle, called with the DMA interrupt masked or from the DMA ISR
  */
-static int8_t is_buffer_full(struct circular_buffer *buf) {
-    /* write index +1 == read index is full,  the mod provides wrap around*/
-    if ((buf->write_index + 1) % BUFFER_LENGTH == buf->read_index) {
-        return TRUE;
+static void next_block(void) {
+    if (tx_fill_len[tx_fill] > 0 && tx_reserved == FALSE) {
+        start_block();
+    } else {
+        dma_busy = FALSE;
     }
-    return FALSE;
 }
 
-/* writeBuffer( (struct oBuffer *buf, unsigned char c)
- * takes a pointer to a circular buffer and a char to be written
- * returns SUCCESS or ERROR
+/* wait_tx_empty(void)
+ * holds the DMA and asks for the TX interrupt once the shift register is
+ * empty, the UART ISR switches the rate then
  */
-static int8_t write_buffer(struct circular_buffer *buf, unsigned char c) {
-    if (is_buffer_full(buf) == FALSE) {
-        buf->data[buf->write_index] = c;
-        /*increment the write index and wrap using modulus arithmetic */
-        buf->write_index = (buf->write_index + 1) % BUFFER_LENGTH;
-        return SUCCESS;
-    }
-    return ERROR; /*no data written*/
+static void wait_tx_empty(void) {
+    U1STAbits.UTXISEL = 0x1; // all characters transmitted
+    IFS0bits.U1TXIF = 0;
+    IEC0bits.U1TXIE = 1;
 }
 
-/*int readBuffer(struct oBuffer *buf)
- * takes a pointer to a circular buffer   
- * returns the value from the buffer
- * the read index is incremented and wrapped using modulus arithmetic
- * Returns 0 if the buffer is empty or the pointer is invalid
+/* baud_divider(uint32_t baud, uint16_t *brg, uint8_t *brgh)
+ * the BRG and BRGH, 16 or 4 PB clocks per bit, closest to the rate, 16 on a
+ * tie for its three samples per bit; returns the error of the rate they make
+ * in percent
  */
-static unsigned char read_from_buffer(struct circular_buffer *buf) {
-    unsigned char val;
-    if (is_buffer_empty(buf) == FALSE) {
-        val = buf->data[buf->read_index]; //get the char from the buffer
-        /*increment the read index and wrap using modulus arithmetic*/
-        buf->read_index = (buf->read_index + 1) % BUFFER_LENGTH;
-        return val;
+static float baud_divider(uint32_t baud, uint16_t *brg, uint8_t *brgh) {
+    static const uint8_t clocks[] = {16, 4};
+    uint32_t pb = Board_get_PB_clock();
+    float error = 100.0; // no divider makes the rate
+    float e;
+    uint32_t n;
+    uint8_t i;
+
+    for (i = 0; i < sizeof (clocks); i++) {
+        n = (pb + clocks[i] * baud / 2) / (clocks[i] * baud); // rounded divisor
+        if (n == 0 || n > 0x10000) {
+            continue;
+        }
+        e = 100.0 * ((float) pb / (clocks[i] * n) - baud) / baud;
+        if (fabsf(e) < fabsf(error)) {
+            error = e;
+            *brg = (uint16_t) (n - 1);
+            *brgh = clocks[i] == 4;
+        }
     }
-    return 0;
+    return error;
 }
 
-static int get_num_elements(struct circular_buffer *buf) {
-    if (buf != NULL) {
-        if (buf->write_index < buf->read_index) { /*test for wrap around*/
-            return (buf->write_index + BUFFER_LENGTH - buf->read_index);
-        } else {
-            return (buf->write_index - buf->read_index);
-        }
+/* start_chunk(void)
+ * sends the next DMA_CHUNK bytes of the block, paced by the UART TX requests.
+ * A FIFO with room raises no new request so the first byte is forced then.
+ */
+static void start_chunk(void) {
+    dma_chunk = dma_len - dma_sent;
+    if (dma_chunk > DMA_CHUNK) {
+        dma_chunk = DMA_CHUNK;
+    }
+    DCH0SSA = KVA_TO_PA(&tx_block[tx_fill ^ 1][dma_sent]);
+    DCH0SSIZ = dma_chunk & 0xFF; // 0 is 256
+    DCH0CONbits.CHEN = 1;
+    if (U1STAbits.UTXBF == 0) {
+        DCH0ECONbits.CFORCE = 1;
     }
-    return 0;
 }
 
 #ifdef SERIAL_TESTING
@@ -1,9 +1,12 @@
 /* 
  * File:   SerialM32.h
  * Author: Aaron Hunter
- * Brief: Serial library for Max32 processor
+ * Brief: Serial library for Max32 processor.  UART1 starts at
+ * SERIAL_BAUD_DEFAULT; Serial_set_baud() moves it to another rate, up to
+ * 1 Mbaud from the 80 MHz PB clock, and turns RTS/CTS flow control on or off
+ * once the bytes already queued have gone out at the old rate.
  * Created on November 10, 2020, 9:52 am
- * Modified on <month> <day>, <year>, <hour> <pm/am>
+ * Modified on 10/16/2026
  */
 
 #ifndef SERIAL_M32_H // Header guard
@@ -12,17 +15,26 @@
 /*******************************************************************************
  * PUBLIC #INCLUDES                                                            *
  ******************************************************************************/
-
+#include <stdint.h>
 
 /*******************************************************************************
  * PUBLIC #DEFINES                                                             *
  ******************************************************************************/
-
+#define SERIAL_TX_BLOCK_LENGTH 1024 // bytes queued while the other block is sent
+#define SERIAL_TX_HEADROOM 256 // bytes at the end of each block only urgent frames may use
+#define SERIAL_TX_BULK 0 // sensor streams and text
+#define SERIAL_TX_URGENT 1 // acks, heartbeats and control outputs, still queued when bulk is refused
+#define SERIAL_TX_CLASSES 2
+#define SERIAL_BAUD_DEFAULT 115200 // rate Serial_init() starts at
+#define SERIAL_BAUD_TOLERANCE 2.0 // percent error of the rate the BRG makes
+#define SERIAL_FLOW_NONE 0
+#define SERIAL_FLOW_RTS_CTS 1 // U1CTS on RD14, U1RTS on RD15, wire both to the adapter
 
 /*******************************************************************************
  * PUBLIC TYPEDEFS                                                             *
  ******************************************************************************/
-
+/* called from the DMA interrupt with the length of the block just sent */
+typedef void (*serial_tx_done_t)(uint16_t length);
 
 /*******************************************************************************
  * PUBLIC FUNCTION PROTOTYPES                                                  *
@@ -32,7 +44,8 @@
  * @Function serial_init(void)
  * @param none
  * @return none
- * @brief  Initializes the UART subsystem to 115200 and sets up the circular buffer
+ * @brief  Initializes the UART subsystem to SERIAL_BAUD_DEFAULT without flow
+ * control, the receive ring and the DMA transmit blocks
  * @author Aaron Hunter*/
 void Serial_init(void);
 
@@ -44,6 +57,90 @@ void Serial_init(void);
  * @author Aaron Hunter*/
 char put_char(unsigned char c);
 
+/**
+ * @Function Serial_write(const uint8_t *data, uint16_t length)
+ * @param data, bytes to send
+ * @param length, number of bytes
+ * @return SUCCESS or ERROR if they do not fit, nothing is queued then
+ * @brief  queues a whole frame for the DMA, which feeds U1TXREG without
+ * interrupting the CPU until the block is done.  Two blocks of
+ * SERIAL_TX_BLOCK_LENGTH alternate: one is sent while the other fills.  Bulk
+ * class, it cannot use the last SERIAL_TX_HEADROOM bytes of a block.
+ * @author Aaron Hunter*/
+int8_t Serial_write(const uint8_t *data, uint16_t length);
+
+/**
+ * @Function Serial_reserve(uint16_t length, uint8_t priority)
+ * @param length, bytes of the frame about to be built
+ * @param priority, SERIAL_TX_BULK or SERIAL_TX_URGENT, urgent frames may also use
+ * the last SERIAL_TX_HEADROOM bytes of the block so a link full of bulk
+ * traffic still takes them
+ * @return where to build it in the block being filled, NULL if it does not
+ * fit or a reservation is open
+ * @brief  zero-copy form of Serial_write(): fill the span in place, then
+ * Serial_commit() it.  The block is not handed to the DMA while the
+ * reservation is open and Serial_write() returns ERROR meanwhile.
+ * @author Aaron Hunter*/
+uint8_t *Serial_reserve(uint16_t length, uint8_t priority);
+
+/**
+ * @Function Serial_commit(uint16_t length)
+ * @param length, bytes filled at the reservation, 0 to give it back
+ * @return none
+ * @brief  queues the frame and starts the DMA if it is idle
+ * @author Aaron Hunter*/
+void Serial_commit(uint16_t length);
+
+/**
+ * @Function Serial_set_tx_done(serial_tx_done_t callback)
+ * @param callback, called with the length of each block sent, NULL for none
+ * @return none
+ * @brief  the callback runs in the DMA interrupt at priority 1
+ * @author Aaron Hunter*/
+void Serial_set_tx_done(serial_tx_done_t callback);
+
+/**
+ * @Function Serial_tx_idle(void)
+ * @return TRUE once everything written has been handed to the UART
+ * @author Aaron Hunter*/
+uint8_t Serial_tx_idle(void);
+
+/**
+ * @Function Serial_tx_space(uint8_t priority)
+ * @param priority, SERIAL_TX_BULK or SERIAL_TX_URGENT
+ * @return bytes a frame of the class can queue now, 0 while a frame is being
+ * built in place
+ * @author Aaron Hunter*/
+uint16_t Serial_tx_space(uint8_t priority);
+
+/**
+ * @Function Serial_tx_dropped(uint8_t priority)
+ * @param priority, SERIAL_TX_BULK or SERIAL_TX_URGENT
+ * @return frames of the class refused for want of room since init, whole
+ * frames, a frame is never cut
+ * @author Aaron Hunter*/
+uint32_t Serial_tx_dropped(uint8_t priority);
+
+/**
+ * @Function Serial_set_baud(uint32_t baud, uint8_t flow)
+ * @param baud, new rate, 1 Mbaud at most
+ * @param flow, SERIAL_FLOW_NONE or SERIAL_FLOW_RTS_CTS
+ * @return SUCCESS or ERROR if the BRG cannot make the rate within
+ * SERIAL_BAUD_TOLERANCE, nothing changes then
+ * @brief  picks the BRGH divider, 16 or 4 clocks per bit, that comes closest
+ * to the rate.  Returns at once: the bytes queued so far go out at the old
+ * rate, the UART interrupt switches when the last one has left the shift
+ * register, and frames written meanwhile wait in the block for the new rate.
+ * @author Aaron Hunter*/
+int8_t Serial_set_baud(uint32_t baud, uint8_t flow);
+
+/**
+ * @Function Serial_get_baud(void)
+ * @return baud rate the UART runs at, from its BRG and BRGH, the old rate
+ * until a Serial_set_baud() has taken effect
+ * @author Aaron Hunter*/
+uint32_t Serial_get_baud(void);
+
 /**
  * @Function get_char(void)
  * @return character read from receive buffer
@@ -51,12 +148,44 @@ char put_char(unsigned char c);
  * @author Aaron Hunter*/
 unsigned char get_char(void);
 
+/**
+ * @Function Serial_data_available(void)
+ * @return TRUE or FALSE
+ * @brief responds with TRUE if the receive buffer is not empty, get_char()
+ * returns 0 for an empty buffer so binary data needs this check
+ * @author Aaron Hunter*/
+unsigned char Serial_data_available(void);
+
+/**
+ * @Function Serial_read(uint8_t *data, uint16_t length)
+ * @param data, filled with the received bytes
+ * @param length, most bytes to read
+ * @return bytes read, 0 if nothing has arrived
+ * @brief  bulk form of get_char()
+ * @author Aaron Hunter*/
+uint16_t Serial_read(uint8_t *data, uint16_t length);
+
+/**
+ * @Function Serial_rx_dropped(void)
+ * @return bytes lost because the receive buffer was full
+ * @author Aaron Hunter*/
+uint32_t Serial_rx_dropped(void);
+
+/**
+ * @Function Serial_rx_errors(void)
+ * @return bytes received with a framing error and receive FIFO overruns since
+ * init, a count that grows with the rate points at the baud error or the
+ * cable
+ * @author Aaron Hunter*/
+uint32_t Serial_rx_errors(void);
+
 /**
  * @Function _mon_putc(char c)
  * @param c - char to be sent
  * @return None.
  * @brief  overwrites weakly define extern to use circular buffer instead of Microchip 
- * functions
+ * functions.  printf() text is held until the end of the line, then queued
+ * whole, so a full block drops lines rather than cutting them.
  * @author Max Dunne, 2011.11.10 */
 void _mon_putc(char c);
 
@@ -0,0 +1,367 @@
+/*
+ * File:   Profiler.c
+ * Brief: Per section execution time and control tick jitter statistics on the
+ * CP0 Count core timer
+ * Created on 10/16/2026
+ * Modified on
+ *
+ * Host test (clock_gettime() time source, two sections and a 10 msec tick):
+ * gcc -O2 -DPROFILER_TESTING -I../Board.X Profiler.c -o profiler
+ * On the target define PROFILER_TESTING and add System_timer.c.
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+#include <string.h>
+#include "Profiler.h"
+#include "System_timer.h"
+#include "Board.h"
+
+#ifndef __XC32
+#include <time.h>
+#endif
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#ifdef __XC32
+#define prof_now() Sys_timer_get_core()
+#endif
+
+/*******************************************************************************
+ * PRIVATE VARIABLES                                                           *
+ ******************************************************************************/
+static prof_stats_t sections[PROF_MAX_SECTIONS];
+static uint32_t section_start[PROF_MAX_SECTIONS];
+static prof_stats_t jitter;
+static uint32_t tick_period = 0; // core timer counts
+static uint32_t last_tick = 0;
+static uint8_t tick_started = FALSE;
+static uint32_t overruns = 0;
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                *
+ ******************************************************************************/
+#ifndef __XC32
+/**
+ * @Function prof_now(void)
+ * @return CLOCK_MONOTONIC in core timer counts, wrapping like CP0 Count */
+static uint32_t prof_now(void);
+#endif
+
+/**
+ * @Function prof_add(prof_stats_t *stats, uint32_t counts)
+ * @param stats, section to update
+ * @param counts, one sample in core timer counts
+ * @return none */
+static void prof_add(prof_stats_t *stats, uint32_t counts);
+
+/**
+ * @Function prof_clear(prof_stats_t *stats)
+ * @param stats, section to clear, the name is kept
+ * @return none */
+static void prof_clear(prof_stats_t *stats);
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function Prof_init(uint32_t tick_period_usec)
+ * @param tick_period_usec, nominal control tick period the jitter is measured
+ * against
+ * @return none
+ * @brief clears all sections, names the jitter stats "jitter"
+ * @author Aaron Hunter, 10/16/2026 */
+void Prof_init(uint32_t tick_period_usec) {
+    memset(sections, 0, sizeof (sections));
+    memset(&jitter, 0, sizeof (jitter));
+    strcpy(jitter.name, "jitter");
+    Prof_reset();
+    tick_period = tick_period_usec * SYS_TIMER_CORE_PER_USEC;
+    tick_started = FALSE;
+    overruns = 0;
+}
+
+/**
+ * @Function Prof_name(uint8_t id, const char *name)
+ * @param id, section index less than PROF_MAX_SECTIONS
+ * @param name, reported name, truncated to PROF_NAME_LEN - 1 characters
+ * @return SUCCESS or ERROR for a bad id
+ * @author Aaron Hunter, 10/16/2026 */
+int8_t Prof_name(uint8_t id, const char *name) {
+    uint8_t i;
+
+    if (id >= PROF_MAX_SECTIONS) {
+        return ERROR;
+    }
+    for (i = 0; i < PROF_NAME_LEN - 1 && name[i] != '\0'; i++) {
+        sections[id].name[i] = name[i];
+    }
+    sections[id].name[i] = '\0';
+    return SUCCESS;
+}
+
+/**
+ * @Function Prof_begin(uint8_t id)
+ * @param id, section index
+ * @return none
+ * @brief latches the core timer for the section, use PROF_BEGIN()
+ * @author Aaron Hunter, 10/16/2026 */
+void Prof_begin(uint8_t id) {
+    if (id < PROF_MAX_SECTIONS) {
+        section_start[id] = prof_now();
+    }
+}
+
+/**
+ * @Function Prof_end(uint8_t id)
+ * @param id, section index
+ * @return none
+ * @brief adds the time since Prof_begin(id) to the section, use PROF_END()
+ * @author Aaron Hunter, 10/16/2026 */
+void Prof_end(uint8_t id) {
+    uint32_t now = prof_now();
+
+    if (id < PROF_MAX_SECTIONS) {
+        prof_add(&sections[id], now - section_start[id]);
+    }
+}
+
+/**
+ * @Function Prof_tick(void)
+ * @return none
+ * @brief call at the start of each control tick, adds |period - nominal| to
+ * the jitter stats and counts the ticks that started a whole period late
+ * @author Aaron Hunter, 10/16/2026 */
+void Prof_tick(void) {
+    uint32_t now = prof_now();
+    uint32_t period = now - last_tick;
+
+    last_tick = now;
+    if (tick_started == FALSE) {
+        tick_started = TRUE;
+        return;
+    }
+    if (period >= 2 * tick_period) {
+        overruns++;
+    }
+    prof_add(&jitter, period > tick_period ? period - tick_period : tick_period - period);
+}
+
+/**
+ * @Function Prof_get(uint8_t id)
+ * @param id, section index
+ * @return the section stats, NULL for a bad id or an unnamed section
+ * @author Aaron Hunter, 10/16/2026 */
+const prof_stats_t *Prof_get(uint8_t id) {
+    if (id >= PROF_MAX_SECTIONS || sections[id].name[0] == '\0') {
+        return NULL;
+    }
+    return &sections[id];
+}
+
+/**
+ * @Function Prof_get_jitter(void)
+ * @return the tick jitter stats
+ * @author Aaron Hunter, 10/16/2026 */
+const prof_stats_t *Prof_get_jitter(void) {
+    return &jitter;
+}
+
+/**
+ * @Function Prof_get_overruns(void)
+ * @return ticks that started more than one nominal period late since
+ * Prof_init()
+ * @author Aaron Hunter, 10/16/2026 */
+uint32_t Prof_get_overruns(void) {
+    return overruns;
+}
+
+/**
+ * @Function Prof_usec(uint32_t counts)
+ * @param counts, core timer counts from the stats
+ * @return counts in usec as a float for reporting
+ * @author Aaron Hunter, 10/16/2026 */
+float Prof_usec(uint32_t counts) {
+    return (float) counts * (1.0f / SYS_TIMER_CORE_PER_USEC);
+}
+
+/**
+ * @Function Prof_mean(const prof_stats_t *stats)
+ * @return mean in core timer counts, 0 with no samples
+ * @author Aaron Hunter, 10/16/2026 */
+uint32_t Prof_mean(const prof_stats_t *stats) {
+    if (stats->count == 0) {
+        return 0;
+    }
+    return (uint32_t) (stats->sum / stats->count);
+}
+
+/**
+ * @Function Prof_reset(void)
+ * @return none
+ * @brief starts a new reporting window, clears the counts, min/max/sum and
+ * histograms of every section and the jitter, keeps the names
+ * @author Aaron Hunter, 10/16/2026 */
+void Prof_reset(void) {
+    uint8_t i;
+
+    for (i = 0; i < PROF_MAX_SECTIONS; i++) {
+        prof_clear(&sections[i]);
+    }
+    prof_clear(&jitter);
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+#ifndef __XC32
+/**
+ * @Function prof_now(void)
+ * @return CLOCK_MONOTONIC in core timer counts, wrapping like CP0 Count */
+static uint32_t prof_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) (ts.tv_sec * 1000000ULL * SYS_TIMER_CORE_PER_USEC
+            + ts.tv_nsec * SYS_TIMER_CORE_PER_USEC / 1000);
+}
+#endif
+
+/**
+ * @Function prof_add(prof_stats_t *stats, uint32_t counts)
+ * @param stats, section to update
+ * @param counts, one sample in core timer counts
+ * @return none */
+static void prof_add(prof_stats_t *stats, uint32_t counts) {
+    uint32_t usec = counts / SYS_TIMER_CORE_PER_USEC;
+    uint8_t bin = 0;
+
+    if (counts < stats->min) {
+        stats->min = counts;
+    }
+    if (counts > stats->max) {
+        stats->max = counts;
+    }
+    stats->sum += counts;
+    stats->count++;
+    /* log2 bin from the leading zero count, a single clz on the M4K */
+    if (usec > 0) {
+        bin = 32 - __builtin_clz(usec);
+        if (bin >= PROF_HIST_BINS) {
+            bin = PROF_HIST_BINS - 1;
+        }
+    }
+    stats->hist[bin]++;
+}
+
+/**
+ * @Function prof_clear(prof_stats_t *stats)
+ * @param stats, section to clear, the name is kept
+ * @return none */
+static void prof_clear(prof_stats_t *stats) {
+    stats->count = 0;
+    stats->min = UINT32_MAX;
+    stats->max = 0;
+    stats->sum = 0;
+    memset(stats->hist, 0, sizeof (stats->hist));
+}
+
+#ifdef PROFILER_TESTING
+#include <stdio.h>
+
+/**
+ * Runs two sections of known length inside a 10 msec tick and prints the
+ * stats once a second, then checks the host numbers against the busy waits. */
+
+#define TEST_TICK_USEC 10000
+#define TEST_SHORT_USEC 50
+#define TEST_LONG_USEC 900
+#define TEST_TICKS 200
+
+#ifdef __XC32
+#include <xc.h>
+#include "SerialM32.h"
+#endif
+
+enum {
+    TEST_SHORT,
+    TEST_LONG
+};
+
+/**
+ * @function busy_usec()
+ * @brief spins on the profiler time source
+ */
+static void busy_usec(uint32_t usec) {
+    uint32_t start = prof_now();
+    while (prof_now() - start < usec * SYS_TIMER_CORE_PER_USEC);
+}
+
+/**
+ * @function print_stats()
+ */
+static void print_stats(const prof_stats_t *s) {
+    uint8_t i;
+
+    printf("%-9s n %4u min %8.1f mean %8.1f max %8.1f usec, hist", s->name,
+            (unsigned int) s->count, Prof_usec(s->min), Prof_usec(Prof_mean(s)),
+            Prof_usec(s->max));
+    for (i = 0; i < PROF_HIST_BINS; i++) {
+        printf(" %u", (unsigned int) s->hist[i]);
+    }
+    printf("\r\n");
+}
+
+int main(void) {
+    uint32_t tick_start;
+    int fails = 0;
+    int n;
+
+#ifdef __XC32
+    Board_init();
+    Serial_init();
+    Sys_timer_init();
+#endif
+    printf("Profiler test harness %s, %s\r\n", __DATE__, __TIME__);
+    Prof_init(TEST_TICK_USEC);
+    Prof_name(TEST_SHORT, "short");
+    Prof_name(TEST_LONG, "long_section_name");
+    tick_start = prof_now();
+    for (n = 0; n < TEST_TICKS; n++) {
+        while (prof_now() - tick_start < TEST_TICK_USEC * SYS_TIMER_CORE_PER_USEC);
+        tick_start += TEST_TICK_USEC * SYS_TIMER_CORE_PER_USEC;
+        PROF_TICK();
+        PROF_BEGIN(TEST_SHORT);
+        busy_usec(TEST_SHORT_USEC);
+        PROF_END(TEST_SHORT);
+        PROF_BEGIN(TEST_LONG);
+        busy_usec(TEST_LONG_USEC);
+        PROF_END(TEST_LONG);
+    }
+    print_stats(Prof_get(TEST_SHORT));
+    print_stats(Prof_get(TEST_LONG));
+    print_stats(Prof_get_jitter());
+    printf("overruns %u\r\n", (unsigned int) Prof_get_overruns());
+
+    /* the busy waits are lower bounds, bins 6 and 10 hold 50 and 900 usec */
+    fails += Prof_get(TEST_SHORT)->count != TEST_TICKS;
+    fails += Prof_usec(Prof_get(TEST_SHORT)->min) < TEST_SHORT_USEC;
+    fails += Prof_usec(Prof_get(TEST_LONG)->min) < TEST_LONG_USEC;
+    fails += Prof_get(TEST_SHORT)->hist[6] == 0;
+    fails += Prof_get(TEST_LONG)->hist[10] == 0;
+    fails += Prof_get_jitter()->count != TEST_TICKS - 1;
+    fails += strcmp(Prof_get(TEST_LONG)->name, "long_sect") != 0;
+    fails += Prof_get(PROF_MAX_SECTIONS - 1) != NULL;
+    fails += Prof_name(PROF_MAX_SECTIONS, "bad") != ERROR;
+    Prof_reset();
+    fails += Prof_get(TEST_SHORT)->count != 0 || Prof_get(TEST_SHORT)->hist[6] != 0;
+    printf("%d check(s) failed\r\n", fails);
+#ifdef __XC32
+    while (1);
+#endif
+    return fails == 0 ? 0 : 1;
+}
+#endif
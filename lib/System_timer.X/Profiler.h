@@ -0,0 +1,139 @@
+/*
+ * File:   Profiler.h
+ * Brief: Per section execution time and control tick jitter statistics on the
+ * CP0 Count core timer from System_timer.  Wrap the work in
+ * PROF_BEGIN(id)/PROF_END(id) and mark the start of each control tick with
+ * PROF_TICK(), then read the stats back with Prof_get() and Prof_get_jitter()
+ * for reporting.  Each section keeps min/mean/max and a log2 histogram in
+ * usec.  The host build backs the same macros with clock_gettime(), scaled to
+ * core timer counts, so the SIL and replay tools report the same units.
+ * Define PROFILER_DISABLE to compile the markers out.
+ * Created on 10/16/2026
+ * Modified on
+ */
+
+#ifndef PROFILER_H // Header guard
+#define	PROFILER_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+#include <stdint.h>
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+#define PROF_MAX_SECTIONS 8
+#define PROF_NAME_LEN 10 // fits the MAVLink DEBUG_VECT name
+/* bin 0 is < 1 usec, bin i is [2^(i-1), 2^i) usec, the last bin is >= 16 msec */
+#define PROF_HIST_BINS 16
+
+#ifndef PROFILER_DISABLE
+#define PROF_BEGIN(id) Prof_begin(id)
+#define PROF_END(id) Prof_end(id)
+#define PROF_TICK() Prof_tick()
+#else
+#define PROF_BEGIN(id)
+#define PROF_END(id)
+#define PROF_TICK()
+#endif
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+typedef struct prof_stats {
+    char name[PROF_NAME_LEN];
+    uint32_t count; // samples since the last Prof_reset()
+    uint32_t min; // core timer counts
+    uint32_t max;
+    uint64_t sum;
+    uint32_t hist[PROF_HIST_BINS]; // samples per log2 usec bin
+} prof_stats_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function Prof_init(uint32_t tick_period_usec)
+ * @param tick_period_usec, nominal control tick period the jitter is measured
+ * against
+ * @return none
+ * @brief clears all sections, names the jitter stats "jitter"
+ * @author Aaron Hunter, 10/16/2026 */
+void Prof_init(uint32_t tick_period_usec);
+
+/**
+ * @Function Prof_name(uint8_t id, const char *name)
+ * @param id, section index less than PROF_MAX_SECTIONS
+ * @param name, reported name, truncated to PROF_NAME_LEN - 1 characters
+ * @return SUCCESS or ERROR for a bad id
+ * @author Aaron Hunter, 10/16/2026 */
+int8_t Prof_name(uint8_t id, const char *name);
+
+/**
+ * @Function Prof_begin(uint8_t id)
+ * @param id, section index
+ * @return none
+ * @brief latches the core timer for the section, use PROF_BEGIN()
+ * @author Aaron Hunter, 10/16/2026 */
+void Prof_begin(uint8_t id);
+
+/**
+ * @Function Prof_end(uint8_t id)
+ * @param id, section index
+ * @return none
+ * @brief adds the time since Prof_begin(id) to the section, use PROF_END()
+ * @author Aaron Hunter, 10/16/2026 */
+void Prof_end(uint8_t id);
+
+/**
+ * @Function Prof_tick(void)
+ * @return none
+ * @brief call at the start of each control tick, adds |period - nominal| to
+ * the jitter stats and counts the ticks that started a whole period late
+ * @author Aaron Hunter, 10/16/2026 */
+void Prof_tick(void);
+
+/**
+ * @Function Prof_get(uint8_t id)
+ * @param id, section index
+ * @return the section stats, NULL for a bad id or an unnamed section
+ * @author Aaron Hunter, 10/16/2026 */
+const prof_stats_t *Prof_get(uint8_t id);
+
+/**
+ * @Function Prof_get_jitter(void)
+ * @return the tick jitter stats
+ * @author Aaron Hunter, 10/16/2026 */
+const prof_stats_t *Prof_get_jitter(void);
+
+/**
+ * @Function Prof_get_overruns(void)
+ * @return ticks that started more than one nominal period late since
+ * Prof_init()
+ * @author Aaron Hunter, 10/16/2026 */
+uint32_t Prof_get_overruns(void);
+
+/**
+ * @Function Prof_usec(uint32_t counts)
+ * @param counts, core timer counts from the stats
+ * @return counts in usec as a float for reporting
+ * @author Aaron Hunter, 10/16/2026 */
+float Prof_usec(uint32_t counts);
+
+/**
+ * @Function Prof_mean(const prof_stats_t *stats)
+ * @return mean in core timer counts, 0 with no samples
+ * @author Aaron Hunter, 10/16/2026 */
+uint32_t Prof_mean(const prof_stats_t *stats);
+
+/**
+ * @Function Prof_reset(void)
+ * @return none
+ * @brief starts a new reporting window, clears the counts, min/max/sum and
+ * histograms of every section and the jitter, keeps the names
+ * @author Aaron Hunter, 10/16/2026 */
+void Prof_reset(void);
+
+#endif	/* PROFILER_H */ // End of header guard
@@ -0,0 +1,448 @@
+/*
+ * File:   Scheduler.c
+ * Brief: Table driven cooperative scheduler for the periodic work in the app
+ * main loops
+ * Created on 10/16/2026
+ * Modified on 10/17/2026
+ *
+ * Host test (simulated clock, a control task, a heavy publisher and a
+ * heartbeat, checks the control task is never late and no release drifts,
+ * then the same with the control task released by a simulated data ready):
+ * gcc -O2 -DSCHEDULER_TESTING -I../Board.X Scheduler.c -o scheduler
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+#include <stddef.h>
+#include "Scheduler.h"
+#include "System_timer.h"
+#include "Board.h"
+
+#if !defined(__XC32) && !defined(SCHEDULER_TESTING)
+#include <time.h>
+#endif
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#if defined(SCHEDULER_TESTING)
+static uint32_t test_clock = 0; // usec, advanced by the test tasks
+#define sched_now() test_clock
+#elif defined(__XC32)
+#define sched_now() Sys_timer_get_usec()
+#endif
+
+/* signed difference so the comparisons survive the usec counter wrapping */
+#define TIME_BEFORE(a, b) ((int32_t) ((a) - (b)) < 0)
+
+/*******************************************************************************
+ * PRIVATE VARIABLES                                                           *
+ ******************************************************************************/
+static sched_task_t *task_table = NULL;
+static uint8_t num_entries = 0;
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                *
+ ******************************************************************************/
+#if !defined(__XC32) && !defined(SCHEDULER_TESTING)
+/**
+ * @Function sched_now(void)
+ * @return CLOCK_MONOTONIC in usec, wrapping like Sys_timer_get_usec() */
+static uint32_t sched_now(void);
+#endif
+
+/**
+ * @Function is_held(uint8_t index, uint32_t now)
+ * @param index, a released task
+ * @param now, current time in usec
+ * @return TRUE if its longest run would overlap a higher priority release and
+ * it can still wait without missing its own deadline */
+static uint8_t is_held(uint8_t index, uint32_t now);
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function Sched_init(sched_task_t *tasks, uint8_t num_tasks)
+ * @param tasks, the app's task table, kept by the scheduler
+ * @param num_tasks, entries in the table
+ * @return none
+ * @brief the first release of each task is now plus its phase, call after
+ * Sys_timer_init() and the rest of the setup
+ * @author Aaron Hunter, 10/16/2026 */
+void Sched_init(sched_task_t *tasks, uint8_t num_tasks) {
+    uint32_t now = sched_now();
+    uint8_t i;
+
+    task_table = tasks;
+    num_entries = num_tasks;
+    for (i = 0; i < num_entries; i++) {
+        if (task_table[i].deadline == 0) {
+            task_table[i].deadline = task_table[i].period;
+        }
+        task_table[i].release = now + task_table[i].phase;
+        task_table[i].budget = 0;
+        task_table[i].pending = FALSE;
+    }
+    Sched_reset_stats();
+}
+
+/**
+ * @Function Sched_run(void)
+ * @return index of the task that ran or SCHED_IDLE
+ * @brief runs at most one task, the highest priority released task that fits
+ * before the next higher priority release, so call it every pass of the main
+ * loop between the event checks
+ * @author Aaron Hunter, 10/16/2026 */
+int8_t Sched_run(void) {
+    uint32_t now = sched_now();
+    uint32_t end;
+    uint32_t elapsed;
+    int8_t best = SCHED_IDLE;
+    sched_task_t *task;
+    uint8_t i;
+
+    for (i = 0; i < num_entries; i++) {
+        if (task_table[i].event == TRUE && task_table[i].pending == FALSE) {
+            /* an event a whole period late is released by the timer */
+            if (TIME_BEFORE(now, task_table[i].release + task_table[i].period)) {
+                continue;
+            }
+        } else if (TIME_BEFORE(now, task_table[i].release)) {
+            continue; // not released yet
+        }
+        if (best != SCHED_IDLE && task_table[i].priority >= task_table[best].priority) {
+            continue;
+        }
+        if (is_held(i, now) == FALSE) {
+            best = i;
+        }
+    }
+    if (best == SCHED_IDLE) {
+        return SCHED_IDLE;
+    }
+
+    task = &task_table[best];
+    if (now - task->release > task->max_latency) {
+        task->max_latency = now - task->release;
+    }
+    if (task->event == TRUE && task->pending == FALSE) {
+        task->missed++; // released by the timer, expect the next event a period on
+        task->release = now;
+    }
+    task->pending = FALSE;
+    task->run();
+    end = sched_now();
+    task->runs++;
+    if (end - now > task->max_exec) {
+        task->max_exec = end - now;
+    }
+    if (end - now > task->budget) {
+        task->budget = end - now;
+    }
+    if (end - task->release > task->deadline) {
+        task->overruns++;
+    }
+    /* next release on the grid, releases that already went by are skipped and
+     * counted rather than run back to back */
+    task->release += task->period;
+    if (task->event == FALSE && !TIME_BEFORE(now, task->release)) {
+        elapsed = (now - task->release) / task->period + 1;
+        task->missed += elapsed;
+        task->release += elapsed * task->period;
+    }
+    return best;
+}
+
+/**
+ * @Function Sched_release(uint8_t index)
+ * @param index, position of an event task in the task table
+ * @return SUCCESS or ERROR for a bad index or a periodic task
+ * @brief releases the task now, a release that overwrites one that has not run
+ * yet is counted missed.  Call from the main loop, not an interrupt.
+ * @author Aaron Hunter, 10/16/2026 */
+int8_t Sched_release(uint8_t index) {
+    if (index >= num_entries || task_table[index].event == FALSE) {
+        return ERROR;
+    }
+    if (task_table[index].pending == TRUE) {
+        task_table[index].missed++;
+    }
+    task_table[index].release = sched_now();
+    task_table[index].pending = TRUE;
+    return SUCCESS;
+}
+
+/**
+ * @Function Sched_get_task(uint8_t index)
+ * @param index, position in the task table
+ * @return the task with its statistics, NULL past the end of the table
+ * @author Aaron Hunter, 10/16/2026 */
+const sched_task_t *Sched_get_task(uint8_t index) {
+    if (index >= num_entries) {
+        return NULL;
+    }
+    return &task_table[index];
+}
+
+/**
+ * @Function Sched_reset_stats(void)
+ * @return none
+ * @brief clears the run, overrun, missed and max counters of every task, the
+ * release grid is kept
+ * @author Aaron Hunter, 10/16/2026 */
+void Sched_reset_stats(void) {
+    uint8_t i;
+
+    for (i = 0; i < num_entries; i++) {
+        task_table[i].runs = 0;
+        task_table[i].overruns = 0;
+        task_table[i].missed = 0;
+        task_table[i].max_exec = 0;
+        task_table[i].max_latency = 0;
+    }
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+#if !defined(__XC32) && !defined(SCHEDULER_TESTING)
+/**
+ * @Function sched_now(void)
+ * @return CLOCK_MONOTONIC in usec, wrapping like Sys_timer_get_usec() */
+static uint32_t sched_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) (ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+}
+#endif
+
+/**
+ * @Function is_held(uint8_t index, uint32_t now)
+ * @param index, a released task
+ * @param now, current time in usec
+ * @return TRUE if its longest run would overlap a higher priority release and
+ * it can still wait without missing its own deadline */
+static uint8_t is_held(uint8_t index, uint32_t now) {
+    const sched_task_t *task = &task_table[index];
+    uint32_t finish = now + task->budget;
+    uint8_t i;
+
+    /* only hold while there is still room for a whole run of this task
+     * before its deadline after the wait, otherwise run it now */
+    if (!TIME_BEFORE(task->release + task->deadline, finish + task->budget)) {
+        for (i = 0; i < num_entries; i++) {
+            if (task_table[i].priority < task->priority
+                    && TIME_BEFORE(task_table[i].release, finish)) {
+                return TRUE;
+            }
+        }
+    }
+    return FALSE;
+}
+
+#ifdef SCHEDULER_TESTING
+#include <stdio.h>
+
+/**
+ * Runs a 10 msec control task next to a 50 msec publisher that takes most of
+ * a control period and a 1 sec heartbeat on a simulated clock.  Each pass of
+ * the main loop costs POLL_USEC for the event checks.  Then releases the
+ * control task on a simulated data ready that runs slightly fast against the
+ * scheduler clock, and stops it to check the timer fallback.  Both control
+ * modes report the IMU sample to actuator output latency: on the timer the
+ * read started at the end of a tick returns the latest free running sample
+ * and is used on the next tick, on data ready the sample is read right away
+ * and releases the control task. */
+
+#define POLL_USEC 50
+#define CONTROL_USEC 2000
+#define PUBLISH_USEC 7000
+#define HEARTBEAT_USEC 500
+#define SLOW_USEC 30000
+#define TEST_SECONDS 10
+#define DRDY_USEC 7960 // 8 msec IMU sample period with a 0.5% fast oscillator
+#define IMU_ODR_USEC 889 // free running 1125 Hz IMU samples on the timer
+#define SPI_USEC 40 // 23 byte read at 5 MHz and the SPI handler
+
+static uint32_t drdy_period = 0; // 0 for no data ready events
+static uint32_t next_drdy = 0;
+static uint32_t sample_used = 0; // sample time of the data the control runs on
+static uint32_t sample_epoch = 0; // first free running IMU sample
+static double latency_sum = 0;
+static uint32_t latency_max = 0;
+static uint32_t latency_n = 0;
+
+static void control_task(void) {
+    uint32_t latency;
+
+    test_clock += CONTROL_USEC;
+    latency = test_clock - sample_used;
+    latency_sum += latency;
+    latency_n++;
+    if (latency > latency_max) {
+        latency_max = latency;
+    }
+    if (drdy_period == 0) {
+        /* start the next read, used on the next tick */
+        sample_used = test_clock - (test_clock - sample_epoch) % IMU_ODR_USEC;
+    }
+}
+
+static uint32_t publish_usec = PUBLISH_USEC;
+
+static void publish_task(void) {
+    test_clock += publish_usec;
+}
+
+static void heartbeat_task(void) {
+    test_clock += HEARTBEAT_USEC;
+}
+
+static void slow_task(void) {
+    test_clock += SLOW_USEC;
+}
+
+static sched_task_t tasks[] = {
+    SCHED_TASK("publish", publish_task, 50, 5, 1, 0),
+    SCHED_TASK("control", control_task, 10, 0, 0, 5),
+    SCHED_TASK("heartbeat", heartbeat_task, 1000, 0, 2, 0),
+};
+
+static sched_task_t drdy[] = {
+    SCHED_EVENT_TASK("control", control_task, 8, 0, 0),
+    SCHED_TASK("publish", publish_task, 50, 1, 1, 0),
+    SCHED_TASK("heartbeat", heartbeat_task, 1000, 0, 2, 0),
+};
+
+static sched_task_t overload[] = {
+    SCHED_TASK("control", control_task, 10, 0, 0, 0),
+    SCHED_TASK("slow", slow_task, 20, 0, 1, 0),
+};
+
+/**
+ * @function run_for()
+ * @brief main loop on the simulated clock
+ */
+static void run_for(uint32_t usec) {
+    uint32_t stop = test_clock + usec;
+    while (TIME_BEFORE(test_clock, stop)) {
+        test_clock += POLL_USEC;
+        if (drdy_period != 0 && !TIME_BEFORE(test_clock, next_drdy + SPI_USEC)) {
+            sample_used = next_drdy;
+            next_drdy += drdy_period;
+            Sched_release(0);
+        }
+        Sched_run();
+    }
+}
+
+/**
+ * @function clear_latency()
+ */
+static void clear_latency(void) {
+    latency_sum = 0;
+    latency_max = 0;
+    latency_n = 0;
+}
+
+/**
+ * @function print_latency()
+ * @return mean sample to actuator latency in usec
+ */
+static double print_latency(void) {
+    double mean = latency_sum / latency_n;
+
+    printf("sample to actuator latency mean %.0f max %u usec\r\n", mean,
+            (unsigned int) latency_max);
+    return mean;
+}
+
+/**
+ * @function print_tasks()
+ */
+static void print_tasks(uint8_t num_tasks) {
+    const sched_task_t *t;
+    uint8_t i;
+
+    for (i = 0; i < num_tasks; i++) {
+        t = Sched_get_task(i);
+        printf("%-10s runs %5u overruns %4u missed %4u max exec %6u max latency %6u usec\r\n",
+                t->name, (unsigned int) t->runs, (unsigned int) t->overruns,
+                (unsigned int) t->missed, (unsigned int) t->max_exec,
+                (unsigned int) t->max_latency);
+    }
+}
+
+int main(void) {
+    double timer_latency;
+    double drdy_latency;
+    int fails = 0;
+
+    printf("Scheduler test harness %s, %s\r\n", __DATE__, __TIME__);
+    /* start near the wrap of the usec counter */
+    test_clock = 0xffffffff - 2000000;
+    sample_epoch = test_clock;
+    Sched_init(tasks, 3);
+    /* the publisher's first run is unmeasured so it may delay one control
+     * release, measure from the second period on */
+    run_for(100000);
+    Sched_reset_stats();
+    clear_latency();
+    run_for(TEST_SECONDS * 1000000UL);
+    print_tasks(3);
+    timer_latency = print_latency();
+    fails += tasks[1].runs != TEST_SECONDS * 100;
+    fails += tasks[1].overruns != 0 || tasks[1].missed != 0;
+    fails += tasks[1].max_latency > HEARTBEAT_USEC + POLL_USEC; // never waits on a publish
+    fails += tasks[0].runs != TEST_SECONDS * 20 || tasks[0].missed != 0;
+    fails += tasks[2].runs != TEST_SECONDS;
+    fails += Sched_get_task(3) != NULL;
+    fails += Sched_release(0) != ERROR; // periodic task
+
+    /* control on data ready, the publisher has to fit between samples */
+    printf("\r\ndata ready\r\n");
+    publish_usec = 4000;
+    Sched_init(drdy, 3);
+    drdy_period = DRDY_USEC;
+    next_drdy = test_clock + DRDY_USEC;
+    run_for(100000);
+    Sched_reset_stats();
+    clear_latency();
+    run_for(TEST_SECONDS * 1000000UL);
+    print_tasks(3);
+    drdy_latency = print_latency();
+    fails += drdy_latency > timer_latency / 4; // a fraction of the period
+    fails += drdy[0].runs < TEST_SECONDS * 1000000UL / DRDY_USEC - 1;
+    fails += drdy[0].overruns != 0 || drdy[0].missed != 0;
+    fails += drdy[0].max_latency > HEARTBEAT_USEC + POLL_USEC;
+    fails += drdy[1].missed != 0 || drdy[2].runs != TEST_SECONDS;
+    /* data ready stops, the timer keeps the control task running */
+    drdy_period = 0;
+    Sched_reset_stats();
+    run_for(1000000UL);
+    print_tasks(1);
+    fails += drdy[0].runs < 1000 / 16 - 1 || drdy[0].missed != drdy[0].runs;
+    publish_usec = PUBLISH_USEC;
+
+    /* overloaded: the slow task cannot fit between control releases, it still
+     * runs before its deadline and the misses are counted, not run back to
+     * back.  Each slow run can make at most the next control run late, so the
+     * control task never falls further behind than one slow run */
+    printf("\r\noverload\r\n");
+    Sched_init(overload, 2);
+    run_for(TEST_SECONDS * 1000000UL);
+    print_tasks(2);
+    fails += overload[1].runs == 0;
+    fails += overload[1].runs + overload[1].missed < TEST_SECONDS * 50 - 1;
+    fails += overload[0].missed == 0;
+    fails += overload[0].overruns > overload[1].runs;
+    fails += overload[0].max_latency > SLOW_USEC + POLL_USEC;
+
+    printf("\r\n%d check(s) failed\r\n", fails);
+    return fails == 0 ? 0 : 1;
+}
+#endif
@@ -0,0 +1,118 @@
+/*
+ * File:   Scheduler.h
+ * Brief: Table driven cooperative scheduler for the periodic work in the app
+ * main loops.  The app declares a static table of sched_task_t with
+ * SCHED_TASK(), each with a period, phase offset, priority and optional
+ * deadline, and calls Sched_run() from the main loop after polling its
+ * events.  Releases are on a fixed grid (release += period) so tasks do not
+ * drift, the highest priority released task runs first, and a lower priority
+ * task is held back while its longest measured run would not finish before
+ * the next release of a higher priority task, so publishing cannot push the
+ * control task late.  A held task still runs once holding it longer would
+ * put it past its own deadline.
+ * Tasks declared with SCHED_EVENT_TASK() are released by Sched_release(),
+ * e.g. on new sensor data, and the expected next event one period later
+ * holds back the lower priority tasks the same way.  If the event is a whole
+ * period late the timer releases the task and the release is counted missed.
+ * Times are usec from Sys_timer_get_usec(), clock_gettime() on a host build,
+ * periods in the table are msec.
+ * Created on 10/16/2026
+ * Modified on 10/17/2026
+ */
+
+#ifndef SCHEDULER_H // Header guard
+#define	SCHEDULER_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+#include <stdint.h>
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+#define SCHED_IDLE -1 // Sched_run() return when no task was released
+
+/* table entry: name, function, period, phase and deadline in msec, priority
+ * 0 is the highest, deadline 0 means the end of the period.  Designated so
+ * the scheduler state after the table fields starts zeroed without a warning */
+#define SCHED_TASK(task_name, fn, per, ph, prio, dl) \
+    {.name = task_name, .run = fn, .period = (per) * 1000UL, .phase = (ph) * 1000UL, \
+    .priority = prio, .deadline = (dl) * 1000UL, .event = 0}
+
+/* event released entry, period is the expected time between events */
+#define SCHED_EVENT_TASK(task_name, fn, per, prio, dl) \
+    {.name = task_name, .run = fn, .period = (per) * 1000UL, .phase = 0, \
+    .priority = prio, .deadline = (dl) * 1000UL, .event = 1}
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+typedef struct sched_task {
+    /* set by SCHED_TASK() */
+    const char *name;
+    void (*run)(void);
+    uint32_t period; // usec
+    uint32_t phase; // usec after Sched_init()
+    uint8_t priority; // 0 is the highest
+    uint32_t deadline; // usec after release, 0 for the period
+    uint8_t event; // released by Sched_release()
+    /* state and statistics kept by the scheduler */
+    uint32_t release; // next release time, expected next event for event tasks
+    uint8_t pending; // event released and not run yet
+    uint32_t budget; // longest run since Sched_init(), for holding back
+    uint32_t runs;
+    uint32_t overruns; // runs that finished after their deadline
+    uint32_t missed; // releases skipped because the last one had not run
+    uint32_t max_exec; // longest run, usec
+    uint32_t max_latency; // longest release to start, usec
+} sched_task_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function Sched_init(sched_task_t *tasks, uint8_t num_tasks)
+ * @param tasks, the app's task table, kept by the scheduler
+ * @param num_tasks, entries in the table
+ * @return none
+ * @brief the first release of each task is now plus its phase, call after
+ * Sys_timer_init() and the rest of the setup
+ * @author Aaron Hunter, 10/16/2026 */
+void Sched_init(sched_task_t *tasks, uint8_t num_tasks);
+
+/**
+ * @Function Sched_run(void)
+ * @return index of the task that ran or SCHED_IDLE
+ * @brief runs at most one task, the highest priority released task that fits
+ * before the next higher priority release, so call it every pass of the main
+ * loop between the event checks
+ * @author Aaron Hunter, 10/16/2026 */
+int8_t Sched_run(void);
+
+/**
+ * @Function Sched_release(uint8_t index)
+ * @param index, position of an event task in the task table
+ * @return SUCCESS or ERROR for a bad index or a periodic task
+ * @brief releases the task now, a release that overwrites one that has not run
+ * yet is counted missed.  Call from the main loop, not an interrupt.
+ * @author Aaron Hunter, 10/16/2026 */
+int8_t Sched_release(uint8_t index);
+
+/**
+ * @Function Sched_get_task(uint8_t index)
+ * @param index, position in the task table
+ * @return the task with its statistics, NULL past the end of the table
+ * @author Aaron Hunter, 10/16/2026 */
+const sched_task_t *Sched_get_task(uint8_t index);
+
+/**
+ * @Function Sched_reset_stats(void)
+ * @return none
+ * @brief clears the run, overrun, missed and max counters of every task, the
+ * release grid is kept
+ * @author Aaron Hunter, 10/16/2026 */
+void Sched_reset_stats(void);
+
+#endif	/* SCHEDULER_H */ // End of header guard
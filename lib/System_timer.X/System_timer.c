@@ -1,34 +1,62 @@
-/* 
+/*
  * File:   System_time.c
  * Author: Aaron Hunter
- * Brief: 
+ * Brief: Millisecond tick and 64 bit microsecond clock on Timer5
  * Created on Jan 12 2021 10:13 am
- * Modified on <month> <day>, <year>, <hour> <pm/am>
+ * Modified on 10/17/2026
+ *
+ * Host test (simulated Timer5 with the tick interrupt injected between every
+ * register and counter access, across the 32 bit msec carry, from main and
+ * interrupt context):
+ * gcc -O2 -DSYSTEM_TIMER_TESTING -I../Board.X System_timer.c -o system_timer
  */
 
 /*******************************************************************************
  * #INCLUDES                                                                   *
  ******************************************************************************/
 
-#include "System_timer.h" // The header file for this source file. 
-#include "SerialM32.h" // The header file for this source file. 
-#include "Board.h"   //Max32 setup      
+#include "System_timer.h" // The header file for this source file.
+#include "Board.h"   //Max32 setup
+#ifdef __XC32
+#include "SerialM32.h" // The header file for this source file.
 #include <xc.h>
 #include <stdio.h>
 #include <sys/attribs.h>  //for ISR definitions
 #include <proc/p32mx795f512l.h>
+#endif
 
 /*******************************************************************************
  * PRIVATE #DEFINES                                                            *
  ******************************************************************************/
 #define PERIOD 9999 //  80 MHz sysclock/8 = 10000 pulses/msec
-#define TICKS_PER_USEC 10
+/* count / SYS_TIMER_TICKS_PER_USEC as a multiply and shift, exact for counts
+ * below 43690, Timer5 counts stay under 2 * (PERIOD + 1) */
+#define COUNT_TO_USEC(count) (((count) * 52429UL) >> 19)
+
+#ifdef __XC32
+#define TICK_READ(x) (x)
+#define TIMER_COUNT() TMR5
+#define TIMER_PENDING() IFS0bits.T5IF
+#define TIMER_CLEAR() (IFS0bits.T5IF = 0)
+#else
+/* simulated Timer5, see the test harness */
+#define TICK_READ(x) sim_read(&(x))
+#define TIMER_COUNT() sim_count()
+#define TIMER_PENDING() sim_pending()
+#define TIMER_CLEAR() (sim_flag = 0)
+#endif
 
 /*******************************************************************************
  * PRIVATE VARIABLES                                                           *
  ******************************************************************************/
-static uint32_t msec_counter = 0;
-static uint32_t usec_counter = 0;
+/* 64 bit msec count, only the tick interrupt writes it and it runs at IPL7 so
+ * no reader can interrupt it half way, readers retry if the low word moved */
+static volatile uint32_t msec_counter = 0;
+static volatile uint32_t msec_counter_hi = 0;
+
+#ifndef __XC32
+static volatile uint8_t sim_flag = 0;
+#endif
 /*******************************************************************************
  * PRIVATE TYPEDEFS                                                            *
  ******************************************************************************/
@@ -36,16 +64,31 @@ static uint32_t usec_counter = 0;
 /*******************************************************************************
  * PRIVATE FUNCTIONS PROTOTYPES                                                *
  ******************************************************************************/
+/**
+ * @Function read_clock(uint32_t *lo, uint32_t *hi)
+ * @param lo, gets the low word of the msec count
+ * @param hi, gets the high word
+ * @return the Timer5 count in 100 nsec ticks since that msec, can be past
+ * PERIOD when the tick interrupt has not run yet */
+static uint32_t read_clock(uint32_t *lo, uint32_t *hi);
+
+#ifndef __XC32
+static uint32_t sim_read(volatile uint32_t *counter);
+static uint32_t sim_count(void);
+static uint8_t sim_pending(void);
+static void Timer5_handler(void);
+#endif
 
 /*******************************************************************************
  * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
  ******************************************************************************/
 
+#ifdef __XC32
 /**
  * @Function void Sys_timer_init(void)
  * @param none
  * @return None.
- * @brief  Initializes the timer module 
+ * @brief  Initializes the timer module
  * @author Aaron Hunter*/
 void Sys_timer_init(void) {
     __builtin_disable_interrupts(); // disable interrupt at CPU
@@ -55,10 +98,11 @@ void Sys_timer_init(void) {
     PR5 = PERIOD; // number of ticks in one cycle (rollover)
     T5CONbits.ON = 1; //turn on the timer
     IFS0bits.T5IF = 0; //clear interrupt flag
-    IPC5bits.T5IP = 4; //priority level 4
+    IPC5bits.T5IP = 7; //priority level 7, above every reader of the clock
     IEC0bits.T5IE = 1; //enable interrupt
     __builtin_enable_interrupts(); //enable interrupts
 }
+#endif
 
 /**
  * Function: Sys_timer_get_msec(void)
@@ -76,28 +120,123 @@ uint32_t Sys_timer_get_msec(void) {
  * @author Aaron Hunter
  */
 uint32_t Sys_timer_get_usec(void) {
-    // get the timer5 count
-    // divide by scalar to convert to usecs 
-    // Add to usec_counter
-    // return sum
-    return (TMR5 / TICKS_PER_USEC + usec_counter);
+    uint32_t lo;
+    uint32_t hi;
+    uint32_t count = read_clock(&lo, &hi);
+
+    /* the high word only adds multiples of 2^32 usec, 32 bit math is enough */
+    return lo * 1000UL + COUNT_TO_USEC(count);
+}
+
+/**
+ * Function: Sys_timer_get_ticks(void)
+ * @param None
+ * @return 100 nsec ticks since Sys_timer_init()
+ * @brief lock free, safe to call from any interrupt below IPL7
+ * @author Aaron Hunter
+ */
+uint64_t Sys_timer_get_ticks(void) {
+    uint32_t lo;
+    uint32_t hi;
+    uint32_t count = read_clock(&lo, &hi);
+
+    return ((uint64_t) hi << 32 | lo) * SYS_TIMER_TICKS_PER_MSEC + count;
+}
+
+/**
+ * Function: Sys_timer_get_usec64(void)
+ * @param None
+ * @return microseconds since Sys_timer_init()
+ * @author Aaron Hunter
+ */
+uint64_t Sys_timer_get_usec64(void) {
+    uint32_t lo;
+    uint32_t hi;
+    uint32_t count = read_clock(&lo, &hi);
+
+    /* no 64 bit divide, that is a library call on the PIC32 */
+    return ((uint64_t) hi << 32 | lo) * 1000 + COUNT_TO_USEC(count);
 }
 
+/**
+ * Function: Sys_timer_ticks_to_usec(uint64_t ticks)
+ * @param ticks, 100 nsec ticks
+ * @return ticks in whole microseconds
+ * @author Aaron Hunter
+ */
+uint64_t Sys_timer_ticks_to_usec(uint64_t ticks) {
+    return ticks / SYS_TIMER_TICKS_PER_USEC;
+}
+
+/**
+ * Function: Sys_timer_dt(uint64_t start, uint64_t end)
+ * @param start, earlier Sys_timer_get_ticks() value
+ * @param end, later Sys_timer_get_ticks() value
+ * @return end - start in seconds
+ * @author Aaron Hunter
+ */
+float Sys_timer_dt(uint64_t start, uint64_t end) {
+    /* the difference fits 32 bits for anything under 7 minutes */
+    return (float) (end - start) * (1.0f / (SYS_TIMER_TICKS_PER_USEC * 1000000.0f));
+}
+
+#ifdef __XC32
+/**
+ * Function: Sys_timer_get_core(void)
+ * @param None
+ * @return the CP0 Count core timer, SYS_TIMER_CORE_PER_USEC counts per usec
+ * @author Aaron Hunter
+ */
+uint32_t Sys_timer_get_core(void) {
+    return _CP0_GET_COUNT();
+}
+#endif
+
 /*******************************************************************************
  * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
  ******************************************************************************/
 
+/**
+ * @Function read_clock(uint32_t *lo, uint32_t *hi)
+ * @param lo, gets the low word of the msec count
+ * @param hi, gets the high word
+ * @return the Timer5 count in 100 nsec ticks since that msec, can be past
+ * PERIOD when the tick interrupt has not run yet */
+static uint32_t read_clock(uint32_t *lo, uint32_t *hi) {
+    uint32_t count;
+    uint8_t pending;
 
-void __ISR(_TIMER_5_VECTOR, ipl4auto) Timer5_handler(void) {
-    // increment millisecond counter
+    /* a tick between the reads changes the low word, read again */
+    do {
+        *lo = TICK_READ(msec_counter);
+        *hi = TICK_READ(msec_counter_hi);
+        count = TIMER_COUNT();
+        pending = TIMER_PENDING();
+    } while (*lo != TICK_READ(msec_counter));
+    /* Timer5 rolled over and the tick has not run, from an interrupt or with
+     * interrupts off.  A count read just before the rollover is near PERIOD */
+    if (pending && count < PERIOD / 2) {
+        count += PERIOD + 1;
+    }
+    return count;
+}
+
+#ifdef __XC32
+void __ISR(_TIMER_5_VECTOR, ipl7auto) Timer5_handler(void) {
+#else
+static void Timer5_handler(void) {
+#endif
+    // increment millisecond counter, carry into the high word
     msec_counter++;
-    // increment microsecond counter by 1000
-    usec_counter += 1000;
-    IFS0bits.T5IF = 0; //clear interrupt flag
+    if (msec_counter == 0) {
+        msec_counter_hi++;
+    }
+    TIMER_CLEAR(); //clear interrupt flag
 }
 
 //Testing harness
 #ifdef SYSTEM_TIMER_TESTING
+#ifdef __XC32
 
 void main(void) {
     uint32_t cur_time = 0;
@@ -118,6 +257,168 @@ void main(void) {
 
 
 }
-#endif
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+/**
+ * Timer5 is simulated from a true tick count that advances a random step on
+ * every access to the timer or the msec counters, and in main context the
+ * tick interrupt runs at random between accesses.  Each read has to land
+ * between the true time before and after it and never go backwards.  The
+ * same reads without the retry and the pending check show the glitches. */
+
+#define SIM_MAX_STEP 300 // ticks per access
+#define SIM_READS 2000000
+#define SIM_START_MSEC (0xffffffffULL - 50) // 32 bit msec carry early in the run
+
+static uint64_t sim_ticks = 0; // true time
+static uint8_t sim_irq_on = TRUE; // FALSE for a reader in interrupt context
+
+/**
+ * @function sim_advance()
+ * @brief moves the true time on and raises the flag at a rollover, runs the
+ * tick interrupt when it can preempt the reader
+ */
+static void sim_advance(void) {
+    uint64_t old = sim_ticks;
+
+    sim_ticks += rand() % SIM_MAX_STEP;
+    if (sim_ticks / SYS_TIMER_TICKS_PER_MSEC != old / SYS_TIMER_TICKS_PER_MSEC) {
+        sim_flag = 1;
+    }
+    if (sim_irq_on && sim_flag && (rand() & 1)) {
+        Timer5_handler();
+    }
+}
+
+static uint32_t sim_read(volatile uint32_t *counter) {
+    sim_advance();
+    return *counter;
+}
+
+static uint32_t sim_count(void) {
+    sim_advance();
+    return (uint32_t) (sim_ticks % SYS_TIMER_TICKS_PER_MSEC);
+}
+
+static uint8_t sim_pending(void) {
+    sim_advance();
+    return sim_flag;
+}
+
+/**
+ * @function naive_ticks()
+ * @brief the old one pass read, counter and timer with no retry
+ */
+static uint64_t naive_ticks(void) {
+    uint32_t lo = TICK_READ(msec_counter);
+    uint32_t hi = TICK_READ(msec_counter_hi);
+    return ((uint64_t) hi << 32 | lo) * SYS_TIMER_TICKS_PER_MSEC + TIMER_COUNT();
+}
+
+/**
+ * @function run_reads()
+ * @param naive, use naive_ticks()
+ * @return reads out of bounds or backwards
+ */
+static uint32_t run_reads(uint8_t naive) {
+    uint64_t before;
+    uint64_t value;
+    uint64_t last = 0;
+    uint32_t errors = 0;
+    uint32_t i;
+
+    sim_ticks = SIM_START_MSEC * SYS_TIMER_TICKS_PER_MSEC + 5000;
+    msec_counter = (uint32_t) SIM_START_MSEC;
+    msec_counter_hi = (uint32_t) (SIM_START_MSEC >> 32);
+    sim_flag = 0;
+    for (i = 0; i < SIM_READS; i++) {
+        before = sim_ticks;
+        value = naive ? naive_ticks() : Sys_timer_get_ticks();
+        if (value < before || value > sim_ticks || value < last) {
+            errors++;
+        }
+        last = value;
+        if (!sim_irq_on && sim_flag) {
+            Timer5_handler(); // runs once the reading interrupt returns
+        }
+    }
+    return errors;
+}
 
+/**
+ * @function run_usec_reads()
+ * @return Sys_timer_get_usec() and Sys_timer_get_usec64() reads that are out
+ * of bounds or do not agree
+ */
+static uint32_t run_usec_reads(void) {
+    uint64_t before;
+    uint64_t usec64;
+    uint32_t usec;
+    uint32_t errors = 0;
+    uint32_t i;
 
+    for (i = 0; i < SIM_READS / 10; i++) {
+        before = sim_ticks / SYS_TIMER_TICKS_PER_USEC;
+        usec = Sys_timer_get_usec();
+        usec64 = Sys_timer_get_usec64();
+        if ((uint32_t) (usec - (uint32_t) before) > sim_ticks / SYS_TIMER_TICKS_PER_USEC - before
+                || usec64 < before || usec64 > sim_ticks / SYS_TIMER_TICKS_PER_USEC
+                || (uint32_t) (usec64 - usec) > 1000) {
+            errors++;
+        }
+        if (!sim_irq_on && sim_flag) {
+            Timer5_handler();
+        }
+    }
+    return errors;
+}
+
+int main(void) {
+    uint64_t before;
+    uint32_t usec;
+    uint32_t errors;
+    int fails = 0;
+
+    printf("System Timer host test %s, %s\r\n", __DATE__, __TIME__);
+    srand(1);
+    errors = run_reads(FALSE);
+    printf("main context: %u bad reads, msec %u:%u, %.1f sec simulated\r\n",
+            (unsigned int) errors, (unsigned int) msec_counter_hi,
+            (unsigned int) msec_counter, (double) Sys_timer_dt(
+            SIM_START_MSEC * SYS_TIMER_TICKS_PER_MSEC, sim_ticks));
+    fails += errors != 0;
+    fails += msec_counter_hi != 1; // carried
+    before = sim_ticks / SYS_TIMER_TICKS_PER_USEC;
+    usec = Sys_timer_get_usec() - (uint32_t) before; // low 32 bits of the 64 bit clock
+    fails += usec > sim_ticks / SYS_TIMER_TICKS_PER_USEC - before;
+    errors = run_usec_reads();
+    printf("usec reads: %u bad\r\n", (unsigned int) errors);
+    fails += errors != 0;
+
+    sim_irq_on = FALSE;
+    errors = run_reads(FALSE);
+    printf("interrupt context: %u bad reads\r\n", (unsigned int) errors);
+    fails += errors != 0;
+    errors = run_usec_reads();
+    printf("usec reads, interrupt context: %u bad\r\n", (unsigned int) errors);
+    fails += errors != 0;
+
+    sim_irq_on = TRUE;
+    errors = run_reads(TRUE);
+    printf("naive read, main context: %u bad reads\r\n", (unsigned int) errors);
+    fails += errors == 0; // the simulation has to catch the race
+    sim_irq_on = FALSE;
+    errors = run_reads(TRUE);
+    printf("naive read, interrupt context: %u bad reads\r\n", (unsigned int) errors);
+    fails += errors == 0;
+
+    fails += Sys_timer_ticks_to_usec(12345) != 1234;
+    fails += fabsf(Sys_timer_dt(1000, 1000 + SYS_TIMER_TICKS_PER_MSEC * 10) - 0.01f) > 1e-9f;
+    printf("%d check(s) failed\r\n", fails);
+    return fails == 0 ? 0 : 1;
+}
+#endif
+#endif
@@ -1,9 +1,12 @@
 /* 
  * File: System_timer.h
  * Author: Aaron Hunter
- * Brief: 
+ * Brief: Millisecond tick and 64 bit microsecond clock on Timer5, core timer
+ * reads for profiling.  The 64 bit clock counts 100 nsec ticks from
+ * Sys_timer_init() and never wraps in practice, reads are consistent from the
+ * main loop and from interrupts without disabling interrupts.
  * Created on Jan 12 2021 10:13 am
- * Modified on <month> <day>, <year>, <hour> <pm/am>
+ * Modified on 10/16/2026
  */
 
 #ifndef SYSTEM_TIMER_H // Header guard
@@ -18,6 +21,9 @@
 /*******************************************************************************
  * PUBLIC #DEFINES                                                             *
  ******************************************************************************/
+#define SYS_TIMER_CORE_PER_USEC 40 // CP0 Count runs at SYSCLK/2, 25 nsec/count
+#define SYS_TIMER_TICKS_PER_USEC 10 // Timer5 runs at PBCLK/8, 100 nsec/tick
+#define SYS_TIMER_TICKS_PER_MSEC 10000
 
 
 /*******************************************************************************
@@ -49,9 +55,57 @@ uint32_t Sys_timer_get_msec(void);
  * Function: Sys_timer_get_usec(void)
  * @param None
  * @return the current microsecond counter value
+ * @brief low 32 bits of Sys_timer_get_usec64(), wraps every 71 minutes so use
+ * it for differences only
  * @author Aaron Hunter
    */
 uint32_t Sys_timer_get_usec(void);
 
+/**
+ * Function: Sys_timer_get_ticks(void)
+ * @param None
+ * @return 100 nsec ticks since Sys_timer_init()
+ * @brief lock free, safe to call from any interrupt below IPL7
+ * @author Aaron Hunter
+ */
+uint64_t Sys_timer_get_ticks(void);
+
+/**
+ * Function: Sys_timer_get_usec64(void)
+ * @param None
+ * @return microseconds since Sys_timer_init(), for time stamps such as the
+ * MAVLink time_usec fields
+ * @author Aaron Hunter
+ */
+uint64_t Sys_timer_get_usec64(void);
+
+/**
+ * Function: Sys_timer_ticks_to_usec(uint64_t ticks)
+ * @param ticks, 100 nsec ticks
+ * @return ticks in whole microseconds
+ * @author Aaron Hunter
+ */
+uint64_t Sys_timer_ticks_to_usec(uint64_t ticks);
+
+/**
+ * Function: Sys_timer_dt(uint64_t start, uint64_t end)
+ * @param start, earlier Sys_timer_get_ticks() value
+ * @param end, later Sys_timer_get_ticks() value
+ * @return end - start in seconds, for integration steps
+ * @author Aaron Hunter
+ */
+float Sys_timer_dt(uint64_t start, uint64_t end);
+
+/**
+ * Function: Sys_timer_get_core(void)
+ * @param None
+ * @return the CP0 Count core timer, SYS_TIMER_CORE_PER_USEC counts per usec
+ * @brief free running from reset, wraps every 107 sec so use differences of
+ * uint32_t, no interrupt or peripheral needed so it works before
+ * Sys_timer_init()
+ * @author Aaron Hunter
+ */
+uint32_t Sys_timer_get_core(void);
+
 #endif	/* SYSTEM_TIMER_H */ // End of header guard
 
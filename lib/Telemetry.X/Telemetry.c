@@ -0,0 +1,386 @@
+/*
+ * File:   Telemetry.c
+ * Brief: MAVLink telemetry stream scheduler, see Telemetry.h.  The
+ * TELEMETRY_TESTING harness asks for four times what the radio can carry and
+ * prints the achieved rates, the link use and the frames the TX path dropped.
+ * Created on 10/16/2026
+ * Modified on 10/17/2026
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+
+#include "Telemetry.h" // The header file for this source file.
+#include "Board.h"
+#include "SerialM32.h"
+#include "Radio_serial.h"
+#include "System_timer.h"
+#include <string.h>
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#define USEC_PER_SEC 1000000UL
+#define BITS_PER_BYTE 10 // 8N1 with start and stop bits
+
+/*******************************************************************************
+ * PRIVATE VARIABLES                                                           *
+ ******************************************************************************/
+static const telemetry_stream_t *streams = NULL;
+static uint8_t stream_count = 0;
+static uint32_t interval[MAVLINK_TX_PORTS][TELEMETRY_MAX_STREAMS]; // usec
+static uint32_t next_due[MAVLINK_TX_PORTS][TELEMETRY_MAX_STREAMS];
+static uint16_t cost[TELEMETRY_MAX_STREAMS]; // bytes the stream sent last time
+/* token buckets in byte usec, bytes * USEC_PER_SEC, so the fill is a multiply */
+static uint64_t tokens[MAVLINK_TX_PORTS];
+static uint64_t depth[MAVLINK_TX_PORTS];
+static uint32_t last_fill = 0;
+static uint32_t window_start = 0;
+static telemetry_stats_t stats;
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                 *
+ ******************************************************************************/
+static uint32_t link_rate(uint8_t port);
+static uint8_t most_overdue(uint8_t port, uint32_t now);
+static void send(uint8_t port, uint8_t stream, uint32_t now);
+static void set_stream(uint8_t port, uint8_t stream, uint32_t usec);
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function Telemetry_init(const telemetry_stream_t *table, uint8_t count)
+ * @param table, the streams, the first wins a tie, kept by reference
+ * @param count, entries in table, at most TELEMETRY_MAX_STREAMS
+ * @return SUCCESS or ERROR if there are too many streams
+ * @brief default intervals, full buckets sized from the ports' baud rates,
+ * call after the UARTs and the system timer are initialized
+ * @author Aaron Hunter */
+int8_t Telemetry_init(const telemetry_stream_t *table, uint8_t count) {
+    const mavlink_msg_entry_t *entry;
+    uint8_t port;
+    uint8_t i;
+
+    if (count > TELEMETRY_MAX_STREAMS) {
+        return ERROR;
+    }
+    streams = table;
+    stream_count = count;
+    depth[MAVLINK_TX_RADIO] = (uint64_t) RADIO_TX_BLOCK_LENGTH * TELEMETRY_LINK_SHARE / 100 * USEC_PER_SEC;
+    depth[MAVLINK_TX_USB] = (uint64_t) SERIAL_TX_BLOCK_LENGTH * TELEMETRY_LINK_SHARE / 100 * USEC_PER_SEC;
+    for (i = 0; i < stream_count; i++) {
+        /* the longest frame until the stream has been sent once */
+        entry = mavlink_get_msg_entry(streams[i].msgid);
+        cost[i] = MAVLINK_NUM_NON_PAYLOAD_BYTES + (entry != NULL ? entry->max_msg_len : MAVLINK_MAX_PAYLOAD_LEN);
+    }
+    last_fill = Sys_timer_get_usec();
+    for (port = 0; port < MAVLINK_TX_PORTS; port++) {
+        tokens[port] = depth[port];
+        for (i = 0; i < stream_count; i++) {
+            set_stream(port, i, streams[i].interval[port]);
+        }
+    }
+    Telemetry_reset_stats();
+    return SUCCESS;
+}
+
+/**
+ * @Function Telemetry_run(void)
+ * @return none
+ * @brief refills the buckets and publishes the streams that are due
+ * @author Aaron Hunter */
+void Telemetry_run(void) {
+    uint32_t now = Sys_timer_get_usec();
+    uint32_t elapsed = now - last_fill;
+    uint8_t port;
+    uint8_t i;
+
+    last_fill = now;
+    for (port = 0; port < MAVLINK_TX_PORTS; port++) {
+        /* the rate is read each pass so a baud change takes effect */
+        tokens[port] += (uint64_t) elapsed * link_rate(port);
+        if (tokens[port] > depth[port]) {
+            tokens[port] = depth[port];
+        }
+        /* a stream that does not fit holds back the rest, so the tokens
+         * build up for it instead of going to smaller ones */
+        while ((i = most_overdue(port, now)) < stream_count) {
+            if (tokens[port] < (uint64_t) cost[i] * USEC_PER_SEC || Mavlink_tx_space(port) < cost[i]) {
+                stats.waited[port]++;
+                break;
+            }
+            send(port, i, now);
+        }
+    }
+}
+
+/**
+ * @Function Telemetry_set_interval(uint8_t port, uint32_t msgid, int32_t interval)
+ * @param port, MAVLINK_TX_RADIO or MAVLINK_TX_USB
+ * @param msgid, message of the stream
+ * @param interval, usec, -1 to stop it and 0 for the default, as in
+ * MAV_CMD_SET_MESSAGE_INTERVAL
+ * @return SUCCESS or ERROR if no stream sends msgid
+ * @author Aaron Hunter */
+int8_t Telemetry_set_interval(uint8_t port, uint32_t msgid, int32_t usec) {
+    int8_t result = ERROR;
+    uint8_t i;
+
+    if (port >= MAVLINK_TX_PORTS) {
+        return ERROR;
+    }
+    for (i = 0; i < stream_count; i++) {
+        if (streams[i].msgid == msgid) {
+            if (usec < 0) {
+                set_stream(port, i, TELEMETRY_OFF);
+            } else if (usec == 0) {
+                set_stream(port, i, streams[i].interval[port]);
+            } else {
+                set_stream(port, i, (uint32_t) usec);
+            }
+            result = SUCCESS;
+        }
+    }
+    return result;
+}
+
+/**
+ * @Function Telemetry_get_interval(uint8_t port, uint32_t msgid)
+ * @return usec, -1 if the stream is stopped and 0 if no stream sends msgid,
+ * as in MESSAGE_INTERVAL
+ * @author Aaron Hunter */
+int32_t Telemetry_get_interval(uint8_t port, uint32_t msgid) {
+    uint8_t i;
+
+    if (port >= MAVLINK_TX_PORTS) {
+        return 0;
+    }
+    for (i = 0; i < stream_count; i++) {
+        if (streams[i].msgid == msgid) {
+            return interval[port][i] == TELEMETRY_OFF ? -1 : (int32_t) interval[port][i];
+        }
+    }
+    return 0;
+}
+
+/**
+ * @Function Telemetry_handle_msg(const mavlink_message_t *msg, uint8_t port)
+ * @param msg, message parsed from port
+ * @param port, MAVLINK_TX_RADIO or MAVLINK_TX_USB
+ * @return TRUE if the message was a stream request for this system and was
+ * consumed, FALSE to let the app handle it
+ * @brief MAV_CMD_SET_MESSAGE_INTERVAL and MAV_CMD_GET_MESSAGE_INTERVAL in a
+ * COMMAND_LONG, answered with COMMAND_ACK and MESSAGE_INTERVAL, and
+ * REQUEST_DATA_STREAM; each changes the port it arrived on
+ * @author Aaron Hunter */
+uint8_t Telemetry_handle_msg(const mavlink_message_t *msg, uint8_t port) {
+    mavlink_command_long_t command;
+    mavlink_request_data_stream_t request;
+    uint8_t result;
+    uint8_t i;
+
+    if (port >= MAVLINK_TX_PORTS) {
+        return FALSE;
+    }
+    switch (msg->msgid) {
+        case MAVLINK_MSG_ID_COMMAND_LONG:
+            mavlink_msg_command_long_decode(msg, &command);
+            if (Mavlink_tx_is_for_us(command.target_system) == FALSE) {
+                return FALSE;
+            }
+            if (command.command == MAV_CMD_SET_MESSAGE_INTERVAL) {
+                result = Telemetry_set_interval(port, (uint32_t) command.param1,
+                        (int32_t) command.param2) == SUCCESS ? MAV_RESULT_ACCEPTED : MAV_RESULT_DENIED;
+            } else if (command.command == MAV_CMD_GET_MESSAGE_INTERVAL) {
+                mavlink_msg_message_interval_send(port, (uint16_t) command.param1,
+                        Telemetry_get_interval(port, (uint32_t) command.param1));
+                result = MAV_RESULT_ACCEPTED;
+            } else {
+                return FALSE;
+            }
+            mavlink_msg_command_ack_send(port, command.command, result, 0, 0,
+                    msg->sysid, msg->compid);
+            return TRUE;
+        case MAVLINK_MSG_ID_REQUEST_DATA_STREAM:
+            mavlink_msg_request_data_stream_decode(msg, &request);
+            if (Mavlink_tx_is_for_us(request.target_system) == FALSE) {
+                return FALSE;
+            }
+            for (i = 0; i < stream_count; i++) {
+                if (request.req_stream_id == MAV_DATA_STREAM_ALL
+                        || request.req_stream_id == streams[i].group) {
+                    set_stream(port, i, request.start_stop == 0 || request.req_message_rate == 0 ?
+                            TELEMETRY_OFF : USEC_PER_SEC / request.req_message_rate);
+                }
+            }
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+/**
+ * @Function Telemetry_get_stats(void)
+ * @return sends per stream, waits and bytes per port since the last reset
+ * @author Aaron Hunter */
+const telemetry_stats_t *Telemetry_get_stats(void) {
+    stats.window = Sys_timer_get_usec() - window_start;
+    return &stats;
+}
+
+/**
+ * @Function Telemetry_reset_stats(void)
+ * @return none
+ * @author Aaron Hunter */
+void Telemetry_reset_stats(void) {
+    memset(&stats, 0, sizeof (stats));
+    window_start = Sys_timer_get_usec();
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/* link_rate(uint8_t port)
+ * bytes/sec the streams may use on the port
+ */
+static uint32_t link_rate(uint8_t port) {
+    uint32_t baud = port == MAVLINK_TX_RADIO ? Radio_get_baud() : Serial_get_baud();
+
+    return baud / BITS_PER_BYTE * TELEMETRY_LINK_SHARE / 100;
+}
+
+/* most_overdue(uint8_t port, uint32_t now)
+ * the due stream that has waited longest, the first in the table on a tie, so
+ * an oversubscribed link shares out its bytes instead of starving the last
+ * streams, stream_count if none is due
+ */
+static uint8_t most_overdue(uint8_t port, uint32_t now) {
+    uint8_t oldest = stream_count;
+    int32_t most = -1;
+    int32_t late;
+    uint8_t i;
+
+    for (i = 0; i < stream_count; i++) {
+        late = (int32_t) (now - next_due[port][i]);
+        if (interval[port][i] != TELEMETRY_OFF && late > most) {
+            most = late;
+            oldest = i;
+        }
+    }
+    return oldest;
+}
+
+/* send(uint8_t port, uint8_t stream, uint32_t now)
+ * publishes the stream and charges what it sent to the port's bucket
+ */
+static void send(uint8_t port, uint8_t stream, uint32_t now) {
+    const mavlink_tx_stats_t *tx = Mavlink_tx_get_stats();
+    uint32_t before = tx->bytes[port];
+    uint64_t charge;
+    uint32_t length;
+
+    streams[stream].publish(port);
+    length = tx->bytes[port] - before;
+    if (length > 0) {
+        cost[stream] = length; // a stream may send several frames
+    }
+    charge = (uint64_t) length * USEC_PER_SEC;
+    tokens[port] = tokens[port] > charge ? tokens[port] - charge : 0;
+    stats.sent[port][stream]++;
+    stats.bytes[port] += length;
+    /* keep the phase, unless the stream fell a whole interval behind */
+    next_due[port][stream] += interval[port][stream];
+    if ((int32_t) (now - next_due[port][stream]) >= 0) {
+        next_due[port][stream] = now + interval[port][stream];
+    }
+}
+
+/* set_stream(uint8_t port, uint8_t stream, uint32_t usec)
+ * new interval, the first message goes on the next pass
+ */
+static void set_stream(uint8_t port, uint8_t stream, uint32_t usec) {
+    interval[port][stream] = usec;
+    next_due[port][stream] = Sys_timer_get_usec();
+}
+
+#ifdef TELEMETRY_TESTING
+#include <stdio.h>
+
+#define TEST_SECONDS 10
+#define TEST_INTERVAL 10000 // 100 Hz of each, about four times the radio
+
+mavlink_system_t mavlink_system = {
+    1, // System ID (1-255)
+    MAV_COMP_ID_AUTOPILOT1 // Component ID (a MAV_COMPONENT value)
+};
+
+static void send_imu(uint8_t port) {
+    mavlink_msg_highres_imu_send(port, Sys_timer_get_usec64(), 0.01, 0.02, -9.8,
+            0.1, 0.2, 0.3, 0.2, 0.0, 0.4, 0.0, 0.0, 0.0, 25.0, 0, 0);
+}
+
+static void send_attitude(uint8_t port) {
+    float q[4] = {1.0, 0.0, 0.0, 0.0};
+
+    mavlink_msg_attitude_quaternion_send(port, Sys_timer_get_msec(), q[0], q[1],
+            q[2], q[3], 0.1, 0.2, 0.3, q);
+}
+
+static void send_position(uint8_t port) {
+    mavlink_msg_local_position_ned_send(port, Sys_timer_get_msec(), 1.0, 2.0,
+            0.0, 0.5, 0.5, 0.0);
+}
+
+static void send_rpm(uint8_t port) {
+    mavlink_msg_raw_rpm_send(port, 0, 100.0);
+    mavlink_msg_raw_rpm_send(port, 1, 100.0);
+}
+
+static const telemetry_stream_t test_streams[] = {
+    {MAVLINK_MSG_ID_ATTITUDE_QUATERNION, MAV_DATA_STREAM_EXTRA1, send_attitude, {TEST_INTERVAL, TELEMETRY_OFF}},
+    {MAVLINK_MSG_ID_HIGHRES_IMU, MAV_DATA_STREAM_RAW_SENSORS, send_imu, {TEST_INTERVAL, TELEMETRY_OFF}},
+    {MAVLINK_MSG_ID_LOCAL_POSITION_NED, MAV_DATA_STREAM_POSITION, send_position, {TEST_INTERVAL, TELEMETRY_OFF}},
+    {MAVLINK_MSG_ID_RAW_RPM, MAV_DATA_STREAM_RAW_SENSORS, send_rpm, {TEST_INTERVAL, TELEMETRY_OFF}},
+};
+#define TEST_STREAMS (sizeof (test_streams) / sizeof (test_streams[0]))
+
+int main(void) {
+    const telemetry_stats_t *tlm;
+    const mavlink_tx_stats_t *tx;
+    uint32_t start;
+    uint8_t i;
+
+    Board_init();
+    Serial_init();
+    Radio_serial_init();
+    Sys_timer_init();
+    printf("\r\nTelemetry stream scheduler test harness %s, %s\r\n", __DATE__, __TIME__);
+    printf("radio %u baud, streams get %u bytes/sec\r\n", Radio_get_baud(),
+            Radio_get_baud() / BITS_PER_BYTE * TELEMETRY_LINK_SHARE / 100);
+    Telemetry_init(test_streams, TEST_STREAMS);
+    Mavlink_tx_reset_stats();
+    start = Sys_timer_get_msec();
+    while (Sys_timer_get_msec() - start < TEST_SECONDS * 1000) {
+        Telemetry_run();
+    }
+    tlm = Telemetry_get_stats();
+    tx = Mavlink_tx_get_stats();
+    for (i = 0; i < TEST_STREAMS; i++) {
+        printf("stream %u: asked %u Hz, got %u.%u Hz\r\n", i,
+                (unsigned int) (USEC_PER_SEC / TEST_INTERVAL),
+                tlm->sent[MAVLINK_TX_RADIO][i] / TEST_SECONDS,
+                tlm->sent[MAVLINK_TX_RADIO][i] % TEST_SECONDS * 10 / TEST_SECONDS);
+    }
+    printf("radio %u bytes/sec, %u waits, %u frames dropped\r\n",
+            tlm->bytes[MAVLINK_TX_RADIO] / TEST_SECONDS, tlm->waited[MAVLINK_TX_RADIO],
+            tx->dropped[MAVLINK_TX_RADIO]);
+    while (1) {
+        ;
+    }
+    return 0;
+}
+#endif //TELEMETRY_TESTING
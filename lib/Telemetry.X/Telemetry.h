@@ -0,0 +1,117 @@
+/*
+ * File:   Telemetry.h
+ * Brief: MAVLink telemetry stream scheduler.  The app lists its streams, one
+ * publish function per message with a default interval for each port, and
+ * calls Telemetry_run() often, every few msec.  A stream goes out on a port
+ * when its interval is up and the port's token bucket holds the bytes it sent
+ * last time.  The bucket fills at a share of the port's baud rate, up to a
+ * share of a TX block, so the streams fill the link without queuing faster
+ * than the UART drains it; a stream that has to wait is counted and goes out
+ * on a later pass, late rather than dropped.  The longest waiting stream goes
+ * first, so an oversubscribed link slows every stream instead of starving
+ * the last ones.  Ground stations change the
+ * interval of a message per port with MAV_CMD_SET_MESSAGE_INTERVAL or of a
+ * group with REQUEST_DATA_STREAM, see Telemetry_handle_msg().  Main loop only.
+ * Created on 10/16/2026
+ * Modified on 10/16/2026
+ */
+
+#ifndef TELEMETRY_H // Header guard
+#define	TELEMETRY_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+#include <stdint.h>
+#include "Mavlink_tx.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+#define TELEMETRY_MAX_STREAMS 16
+#define TELEMETRY_LINK_SHARE 80 // percent of the baud rate and TX block for the streams, the rest for text and replies
+#define TELEMETRY_OFF 0 // interval of a stream that is not sent
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+/* sends the stream's message(s) on port, MAVLINK_TX_RADIO or MAVLINK_TX_USB */
+typedef void (*telemetry_publish_t)(uint8_t port);
+
+typedef struct {
+    uint32_t msgid; // MESSAGE_INTERVAL requests name the stream by this
+    uint8_t group; // MAV_DATA_STREAM_xxx for REQUEST_DATA_STREAM
+    telemetry_publish_t publish;
+    uint32_t interval[MAVLINK_TX_PORTS]; // default usec, TELEMETRY_OFF
+} telemetry_stream_t;
+
+typedef struct {
+    uint32_t sent[MAVLINK_TX_PORTS][TELEMETRY_MAX_STREAMS];
+    uint32_t waited[MAVLINK_TX_PORTS]; // passes a due stream waited for tokens
+    uint32_t bytes[MAVLINK_TX_PORTS]; // sent by the streams
+    uint32_t window; // usec since the last reset
+} telemetry_stats_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function Telemetry_init(const telemetry_stream_t *table, uint8_t count)
+ * @param table, the streams, the first wins a tie, kept by reference
+ * @param count, entries in table, at most TELEMETRY_MAX_STREAMS
+ * @return SUCCESS or ERROR if there are too many streams
+ * @brief default intervals, full buckets sized from the ports' baud rates,
+ * call after the UARTs and the system timer are initialized
+ * @author Aaron Hunter */
+int8_t Telemetry_init(const telemetry_stream_t *table, uint8_t count);
+
+/**
+ * @Function Telemetry_run(void)
+ * @return none
+ * @brief refills the buckets and publishes the streams that are due
+ * @author Aaron Hunter */
+void Telemetry_run(void);
+
+/**
+ * @Function Telemetry_set_interval(uint8_t port, uint32_t msgid, int32_t interval)
+ * @param port, MAVLINK_TX_RADIO or MAVLINK_TX_USB
+ * @param msgid, message of the stream
+ * @param interval, usec, -1 to stop it and 0 for the default, as in
+ * MAV_CMD_SET_MESSAGE_INTERVAL
+ * @return SUCCESS or ERROR if no stream sends msgid
+ * @author Aaron Hunter */
+int8_t Telemetry_set_interval(uint8_t port, uint32_t msgid, int32_t interval);
+
+/**
+ * @Function Telemetry_get_interval(uint8_t port, uint32_t msgid)
+ * @return usec, -1 if the stream is stopped and 0 if no stream sends msgid,
+ * as in MESSAGE_INTERVAL
+ * @author Aaron Hunter */
+int32_t Telemetry_get_interval(uint8_t port, uint32_t msgid);
+
+/**
+ * @Function Telemetry_handle_msg(const mavlink_message_t *msg, uint8_t port)
+ * @param msg, message parsed from port
+ * @param port, MAVLINK_TX_RADIO or MAVLINK_TX_USB
+ * @return TRUE if the message was a stream request for this system and was
+ * consumed, FALSE to let the app handle it
+ * @brief MAV_CMD_SET_MESSAGE_INTERVAL and MAV_CMD_GET_MESSAGE_INTERVAL in a
+ * COMMAND_LONG, answered with COMMAND_ACK and MESSAGE_INTERVAL, and
+ * REQUEST_DATA_STREAM; each changes the port it arrived on
+ * @author Aaron Hunter */
+uint8_t Telemetry_handle_msg(const mavlink_message_t *msg, uint8_t port);
+
+/**
+ * @Function Telemetry_get_stats(void)
+ * @return sends per stream, waits and bytes per port since the last reset
+ * @author Aaron Hunter */
+const telemetry_stats_t *Telemetry_get_stats(void);
+
+/**
+ * @Function Telemetry_reset_stats(void)
+ * @return none
+ * @author Aaron Hunter */
+void Telemetry_reset_stats(void);
+
+#endif	/* TELEMETRY_H */ // End of header guard
@@ -0,0 +1,145 @@
+# -*- coding: utf-8 -*-
+'''
+Sensor injection bench for the HIL mode of the rover GNC app (lib/HIL.X).
+
+Sends HIL_SENSOR at --rate Hz, HIL_GPS at 10 Hz and the wheel rates and
+steering angle as RAW_RPM to the app, and matches every HIL_ACTUATOR_CONTROLS
+that comes back to the HIL_SENSOR it answers by time_usec.  Prints once a
+second the achieved send and answer rates, the lost frames and the round trip
+latency, and the app's own hil_rx, hil_drop and hil_lat DEBUG_VECT counters.
+
+    python3 hil_bench.py COM3 --baud 115200 --rate 100 --time 30
+    python3 hil_bench.py /dev/pts/4 --rate 200
+    python3 hil_bench.py udpout:localhost:14551
+
+At 115200 baud a HIL_SENSOR frame is ~77 bytes, so 100 Hz takes 7.7 of the
+11.5 kB/s the port carries; leave room for the RAW_RPM and HIL_GPS frames.
+'''
+import argparse
+import math
+import time
+from pymavlink import mavutil
+
+G = 9.80665
+MAG_FIELD = [0.052, 0.227, -0.414]  # gauss, FRD, rover pointing north
+LAT0 = 36.9990  # degrees
+LON0 = -122.0600
+M_PER_DEG = 111320.0
+
+
+def percentile(values, p):
+    '''p-th percentile of a sorted list'''
+    if not values:
+        return float('nan')
+    return values[min(len(values) - 1, int(p / 100.0 * len(values)))]
+
+
+def main():
+    parser = argparse.ArgumentParser(description='HIL sensor injection bench')
+    parser.add_argument('device', help='serial port, pty or mavutil udp string')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--rate', type=float, default=100.0, help='HIL_SENSOR rate, Hz')
+    parser.add_argument('--gps-rate', type=float, default=10.0, help='HIL_GPS rate, Hz')
+    parser.add_argument('--rpm-rate', type=float, default=20.0, help='RAW_RPM rate, Hz')
+    parser.add_argument('--time', type=float, default=10.0, help='bench length, seconds')
+    parser.add_argument('--speed', type=float, default=0.5, help='wheel rate, rad/sec')
+    parser.add_argument('--yaw-rate', type=float, default=0.2, help='rad/sec')
+    args = parser.parse_args()
+
+    master = mavutil.mavlink_connection(args.device, baud=args.baud,
+                                        source_system=255, source_component=190)
+    print('waiting for heartbeat')
+    master.wait_heartbeat()
+    print('target_system {}, target component {}'.format(master.target_system,
+                                                         master.target_component))
+
+    sent = {}  # time_usec of each HIL_SENSOR -> host send time
+    latencies = []
+    window = {'sensor': 0, 'gps': 0, 'rpm': 0, 'answer': 0, 'unmatched': 0}
+    total = dict(window)
+    all_latencies = []
+
+    start = time.time()
+    next_sensor = next_gps = next_rpm = start
+    next_report = start + 1.0
+    yaw = 0.0
+    while time.time() - start < args.time:
+        now = time.time()
+        t_sim = now - start
+        time_usec = int(t_sim * 1e6)
+        if now >= next_sensor:
+            next_sensor += 1.0 / args.rate
+            yaw = args.yaw_rate * t_sim
+            c, s = math.cos(yaw), math.sin(yaw)
+            # rotate the NED field into the body by the yaw, level rover
+            xmag = c * MAG_FIELD[0] + s * MAG_FIELD[1]
+            ymag = -s * MAG_FIELD[0] + c * MAG_FIELD[1]
+            master.mav.hil_sensor_send(time_usec,
+                                       0.0, 0.0, -G,  # specific force, FRD
+                                       0.0, 0.0, args.yaw_rate,
+                                       xmag, ymag, MAG_FIELD[2],
+                                       1013.25, 0.0, 0.0, 25.0,
+                                       0x1fff)
+            sent[time_usec] = now
+            window['sensor'] += 1
+        if now >= next_gps:
+            next_gps += 1.0 / args.gps_rate
+            dist = args.speed * 0.036 * t_sim  # wheel radius, m
+            master.mav.hil_gps_send(time_usec, 3,
+                                    int((LAT0 + dist / M_PER_DEG) * 1e7),
+                                    int(LON0 * 1e7), 0,
+                                    100, 100, int(args.speed * 3.6), 0, 0, 0,
+                                    int(math.degrees(yaw) % 360.0 * 100), 12)
+            window['gps'] += 1
+        if now >= next_rpm:
+            next_rpm += 1.0 / args.rpm_rate
+            master.mav.raw_rpm_send(0, args.speed)
+            master.mav.raw_rpm_send(1, args.speed)
+            master.mav.raw_rpm_send(2, 0.0)
+            window['rpm'] += 3
+
+        msg = master.recv_match(blocking=False)
+        while msg is not None:
+            mtype = msg.get_type()
+            if mtype == 'HIL_ACTUATOR_CONTROLS':
+                window['answer'] += 1
+                t_sent = sent.pop(msg.time_usec, None)
+                if t_sent is None:
+                    window['unmatched'] += 1
+                else:
+                    latencies.append((time.time() - t_sent) * 1e3)
+            elif mtype == 'DEBUG_VECT' and msg.name.startswith('hil'):
+                print('  app {}: {:.1f} {:.1f} {:.1f}'.format(msg.name, msg.x, msg.y, msg.z))
+            msg = master.recv_match(blocking=False)
+
+        if now >= next_report:
+            next_report += 1.0
+            latencies.sort()
+            print('sent {sensor} sensor {gps} gps {rpm} rpm/s, answered {answer}/s '
+                  '({unmatched} unmatched), '.format(**window) +
+                  'latency ms p50 {:.2f} p99 {:.2f} max {:.2f}'.format(
+                      percentile(latencies, 50), percentile(latencies, 99),
+                      latencies[-1] if latencies else float('nan')))
+            for key in window:
+                total[key] += window[key]
+                window[key] = 0
+            all_latencies += latencies
+            latencies = []
+            # frames not answered within a second are lost
+            for t_usec in [t for t, t_sent in sent.items() if now - t_sent > 1.0]:
+                del sent[t_usec]
+        time.sleep(0.0002)
+
+    all_latencies.sort()
+    elapsed = time.time() - start
+    print('\n{:.1f} s: {:.1f} sensor frames/s sent, {:.1f} answered/s, {} not answered'.format(
+        elapsed, total['sensor'] / elapsed, total['answer'] / elapsed,
+        total['sensor'] - len(all_latencies)))
+    print('round trip ms: min {:.2f} p50 {:.2f} p99 {:.2f} max {:.2f}'.format(
+        all_latencies[0] if all_latencies else float('nan'),
+        percentile(all_latencies, 50), percentile(all_latencies, 99),
+        all_latencies[-1] if all_latencies else float('nan')))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,73 @@
+# -*- coding: utf-8 -*-
+'''
+Decoder for the batched IMU telemetry of the rover GNC app (lib/IMU_batch.X).
+
+The app packs the raw accel and gyro counts of every IMU sample into
+ENCAPSULATED_DATA messages, up to 19 samples each: a format byte, the sample
+count, the interval between the samples in nsec, the time of the first sample
+in usec, the scales of the counts, then each axis of the batch in turn, little
+endian.  This expands every batch back into one CSV row per sample, in g and
+deg/sec or with --raw in counts.  Gaps in the ENCAPSULATED_DATA sequence are
+batches the app dropped for a slow link; they are reported on stderr with the
+time of the first sample after them.
+
+    python3 imu_batch_decode.py COM5 --baud 115200 > imu.csv
+    python3 imu_batch_decode.py udpin:localhost:14550
+    python3 imu_batch_decode.py flight.tlog --raw > imu_counts.csv
+'''
+import argparse
+import struct
+import sys
+
+FORMAT = 0xB1  # IMU_BATCH_FORMAT
+HEADER = struct.Struct('<BBIQff')  # format, count, nsec interval, usec time, scales
+AXES = 6  # accel x, y, z then gyro x, y, z
+DATA_LEN = 253  # ENCAPSULATED_DATA data
+COLUMNS = 'time_usec,acc_x,acc_y,acc_z,gyro_x,gyro_y,gyro_z'
+
+
+def decode(data, raw=False):
+    '''(usec, values) of each sample of a batch, an empty list if the data is
+    not a batch'''
+    data = bytes(data) + bytes(DATA_LEN - len(data))  # MAVLink 2 trims zeros
+    fmt, count, interval, usec, acc_scale, gyro_scale = HEADER.unpack_from(data)
+    if fmt != FORMAT or count == 0 or HEADER.size + AXES * 2 * count > DATA_LEN:
+        return []
+    axes = [struct.unpack_from('<%dh' % count, data, HEADER.size + axis * 2 * count)
+            for axis in range(AXES)]
+    scales = [1, 1, 1, 1, 1, 1] if raw else [acc_scale] * 3 + [gyro_scale] * 3
+    return [(usec + n * interval / 1000.0,
+             [axes[axis][n] * scales[axis] for axis in range(AXES)])
+            for n in range(count)]
+
+
+def main():
+    from pymavlink import mavutil
+
+    parser = argparse.ArgumentParser(description='GNC batched IMU decoder')
+    parser.add_argument('device', help='serial port, mavutil udp string or tlog')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--raw', action='store_true', help='counts instead of g and deg/sec')
+    args = parser.parse_args()
+
+    master = mavutil.mavlink_connection(args.device, baud=args.baud)
+    value = '%d' if args.raw else '%.5f'
+    print(COLUMNS)
+    last = None
+    while True:
+        msg = master.recv_match(type='ENCAPSULATED_DATA', blocking=True)
+        if msg is None:
+            break  # end of a tlog
+        samples = decode(msg.data, args.raw)
+        if not samples:
+            continue  # some other use of ENCAPSULATED_DATA
+        if last is not None and (msg.seqnr - last - 1) & 0xffff:
+            sys.stderr.write('-- %d batches lost before %.0f usec\n'
+                             % ((msg.seqnr - last - 1) & 0xffff, samples[0][0]))
+        last = msg.seqnr
+        for usec, values in samples:
+            print('%.0f,' % usec + ','.join(value % v for v in values))
+
+
+if __name__ == '__main__':
+    main()
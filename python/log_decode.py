@@ -0,0 +1,103 @@
+# -*- coding: utf-8 -*-
+'''
+Decoder for the binary event log of the rover GNC app (lib/Event_log.X).
+
+The app sends its diagnostics as records packed in LOGGING_DATA messages: an
+event id, the argument byte count, the msec time and the arguments, little
+endian.  This reads the LOG_EVENT(types, format) table from the app source,
+so the formats live in one place, and prints every record as text with its
+time.  Gaps in the LOGGING_DATA sequence are reported as lost messages.
+
+    python3 log_decode.py COM5 --baud 57600
+    python3 log_decode.py udpin:localhost:14550
+    python3 log_decode.py flight.tlog --source ../Rover/Controller/Rover_GNC.X/GNC_main.c
+
+The table is read in order, so the source has to be the one the running
+firmware was built from.
+'''
+import argparse
+import os
+import re
+import struct
+
+DEFAULT_SOURCE = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..',
+                              'Rover', 'Controller', 'Rover_GNC.X', 'GNC_main.c')
+EVENT = re.compile(r'LOG_EVENT\(\s*"([^"]*)"\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+COMMENT = re.compile(r'/\*.*?\*/|^\s*//.*?$', re.DOTALL | re.MULTILINE)
+HEADER = struct.Struct('<BBI')  # id, argument bytes, msec
+ARGS = {'f': struct.Struct('<f'), 'i': struct.Struct('<i'),
+        'u': struct.Struct('<I'), 'l': struct.Struct('<i')}
+DEG_E7 = 1e-7
+
+
+def load_events(path):
+    '''(types, format) of each LOG_EVENT() entry in the source, by id'''
+    with open(path) as source:
+        text = COMMENT.sub('', source.read())
+    return [(types, fmt.encode().decode('unicode_escape'))
+            for types, fmt in EVENT.findall(text)]
+
+
+def unpack(types, data):
+    '''argument values of a record, in the order of types'''
+    values = []
+    offset = 0
+    for kind in types:
+        if kind == 's':
+            length = data[offset]
+            values.append(bytes(data[offset + 1:offset + 1 + length]).decode('ascii', 'replace'))
+            offset += 1 + length
+        else:
+            value = ARGS[kind].unpack_from(data, offset)[0]
+            values.append(value * DEG_E7 if kind == 'l' else value)
+            offset += ARGS[kind].size
+    return values
+
+
+def decode(events, data, length):
+    '''(msec, text) of each record in the first length bytes of a
+    LOGGING_DATA payload'''
+    data = bytes(data[:length])
+    offset = 0
+    while offset + HEADER.size <= length:
+        event, size, msec = HEADER.unpack_from(data, offset)
+        offset += HEADER.size
+        args = data[offset:offset + size]
+        offset += size
+        if event >= len(events):
+            yield msec, 'unknown event %d, %d bytes' % (event, size)
+            continue
+        types, fmt = events[event]
+        try:
+            yield msec, fmt % tuple(unpack(types, args))
+        except (struct.error, IndexError, TypeError, ValueError):
+            yield msec, 'bad record for event %d, %d bytes' % (event, size)
+
+
+def main():
+    from pymavlink import mavutil
+
+    parser = argparse.ArgumentParser(description='GNC event log decoder')
+    parser.add_argument('device', help='serial port, mavutil udp string or tlog')
+    parser.add_argument('--baud', type=int, default=57600)
+    parser.add_argument('--source', default=DEFAULT_SOURCE,
+                        help='app source with the LOG_EVENT() table')
+    args = parser.parse_args()
+
+    events = load_events(args.source)
+    print('%d events from %s' % (len(events), args.source))
+    master = mavutil.mavlink_connection(args.device, baud=args.baud)
+    last = None
+    while True:
+        msg = master.recv_match(type='LOGGING_DATA', blocking=True)
+        if msg is None:
+            break  # end of a tlog
+        if last is not None and (msg.sequence - last - 1) & 0xffff:
+            print('-- %d messages lost' % ((msg.sequence - last - 1) & 0xffff))
+        last = msg.sequence
+        for msec, text in decode(events, msg.data, msg.length):
+            print('%10.3f %s' % (msec / 1000.0, text))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,99 @@
+# -*- coding: utf-8 -*-
+'''
+Perfect hash generator for the parameter table of the rover GNC app
+(lib/Param.X).
+
+Reads the PARAM_ENTRY("ID", ...) table from the app source and searches for
+the smallest power of two number of slots, at least twice the number of ids,
+and a seed for which the FNV-1a hash of Param.c puts every id in a slot of its
+own.  The result goes to GNC_params.h beside the source, so the firmware finds
+any id with one hash and one compare.  Run it after adding, removing or
+renaming a parameter; Param_init() reports a stale seed and falls back to
+searching the table.
+
+    python3 param_hash.py
+    python3 param_hash.py --source ../Rover/Controller/Rover_GNC.X/GNC_main.c
+'''
+import argparse
+import os
+import re
+
+DEFAULT_SOURCE = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..',
+                              'Rover', 'Controller', 'Rover_GNC.X', 'GNC_main.c')
+ENTRY = re.compile(r'PARAM_ENTRY\(\s*"([^"]*)"')
+COMMENT = re.compile(r'/\*.*?\*/|^\s*//.*?$', re.DOTALL | re.MULTILINE)
+ID_LENGTH = 16  # PARAM_ID_LENGTH
+MAX_SLOTS = 128  # PARAM_MAX_SLOTS
+MAX_SEED = 1 << 20
+FNV_PRIME = 16777619
+
+HEADER = '''/*
+ * File:   GNC_params.h
+ * Brief: Perfect hash of the GNC parameter ids for Param_init(), generated by
+ * python/param_hash.py from the PARAM_ENTRY() table in GNC_main.c, do not
+ * edit; run the script again after changing the ids.
+ * Created on 10/16/2026
+ * Modified on 10/16/2026
+ */
+
+#ifndef GNC_PARAMS_H // Header guard
+#define	GNC_PARAMS_H //
+
+#define GNC_PARAM_COUNT {count}
+#define GNC_PARAM_SEED {seed:#x}UL
+#define GNC_PARAM_SLOTS {slots}
+
+#endif	/* GNC_PARAMS_H */ // End of header guard
+'''
+
+
+def load_ids(path):
+    '''ids of the PARAM_ENTRY() lines in the source, in table order'''
+    with open(path) as source:
+        text = COMMENT.sub('', source.read())
+    return ENTRY.findall(text)
+
+
+def fnv1a(param_id, seed):
+    '''hash() of Param.c, over up to ID_LENGTH characters'''
+    h = seed
+    for char in param_id.encode('ascii')[:ID_LENGTH]:
+        h = ((h ^ char) * FNV_PRIME) & 0xffffffff
+    return h ^ (h >> 16)
+
+
+def find_seed(ids):
+    '''(seed, slots) with no two ids in a slot, the fewest slots first'''
+    slots = 1
+    while slots < 2 * len(ids):
+        slots *= 2
+    while slots <= MAX_SLOTS:
+        for seed in range(1, MAX_SEED):
+            used = set(fnv1a(param_id, seed) & (slots - 1) for param_id in ids)
+            if len(used) == len(ids):
+                return seed, slots
+        slots *= 2
+    raise SystemExit('no seed for %d ids in %d slots' % (len(ids), MAX_SLOTS))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='GNC parameter hash generator')
+    parser.add_argument('--source', default=DEFAULT_SOURCE,
+                        help='app source with the PARAM_ENTRY() table')
+    args = parser.parse_args()
+
+    ids = load_ids(args.source)
+    for param_id in ids:
+        if len(param_id) > ID_LENGTH:
+            raise SystemExit('%s is longer than %d characters' % (param_id, ID_LENGTH))
+    if len(set(ids)) != len(ids):
+        raise SystemExit('the table repeats an id')
+    seed, slots = find_seed(ids)
+    output = os.path.join(os.path.dirname(os.path.abspath(args.source)), 'GNC_params.h')
+    with open(output, 'w') as header:
+        header.write(HEADER.format(count=len(ids), seed=seed, slots=slots))
+    print('%d ids, seed %#x, %d slots, written to %s' % (len(ids), seed, slots, output))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,62 @@
+# -*- coding: utf-8 -*-
+'''
+Decoder for the vehicle state telemetry of the rover GNC app.
+
+At the end of every control run the app copies the attitude, gyro bias,
+odometry state, wheel rates, controller outputs, mission mode and loop timing
+into one snapshot, and sends it in a TUNNEL message of payload type 0x8001,
+so every field of a row comes from the same tick.  The layout is documented
+with vehicle_state_t in GNC_main.c.  This prints one CSV row per message;
+a jump in the run counter is control runs the link did not carry.
+
+    python3 state_decode.py COM5 --baud 115200 > state.csv
+    python3 state_decode.py udpin:localhost:14550
+    python3 state_decode.py drive.tlog > state.csv
+'''
+import argparse
+import struct
+
+PAYLOAD_TYPE = 0x8001  # VEHICLE_STATE_PAYLOAD
+STATE = struct.Struct('<Q4f3f7f2f2fIHHBB')  # vehicle_state_t
+MODES = ['MANUAL', 'CRUISE', 'AUTO', 'BADRCVAL']
+HOME_SET = 0x01
+HIL = 0x02
+COLUMNS = ('time_usec,q_w,q_x,q_y,q_z,bias_x,bias_y,bias_z,'
+           'x,y,psi,vx,vy,v,delta,omega_left,omega_right,u_v,u_heading,'
+           'runs,ahrs_dt_usec,exec_usec,mode,home_set,hil')
+
+
+def decode(payload_type, payload):
+    '''the fields of a snapshot as a tuple, None if the payload is not one'''
+    if payload_type != PAYLOAD_TYPE:
+        return None
+    payload = bytes(payload) + bytes(STATE.size)  # MAVLink 2 trims zeros
+    return STATE.unpack_from(payload)
+
+
+def main():
+    from pymavlink import mavutil
+
+    parser = argparse.ArgumentParser(description='GNC vehicle state decoder')
+    parser.add_argument('device', help='serial port, mavutil udp string or tlog')
+    parser.add_argument('--baud', type=int, default=115200)
+    args = parser.parse_args()
+
+    master = mavutil.mavlink_connection(args.device, baud=args.baud)
+    print(COLUMNS)
+    while True:
+        msg = master.recv_match(type='TUNNEL', blocking=True)
+        if msg is None:
+            break  # end of a tlog
+        state = decode(msg.payload_type, msg.payload)
+        if state is None:
+            continue  # some other use of TUNNEL
+        mode = MODES[state[22]] if state[22] < len(MODES) else str(state[22])
+        flags = state[23]
+        print('%d,' % state[0] + ','.join('%.5f' % v for v in state[1:19])
+              + ',%d,%d,%d,%s,%d,%d' % (state[19], state[20], state[21], mode,
+                                        bool(flags & HOME_SET), bool(flags & HIL)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,303 @@
+/*
+ * File:   Sim.h
+ * Brief: Software in the loop simulator for the PIC32 apps.  The app and the
+ * lib drivers compile unmodified for Linux against the register shim in
+ * sim/include, every register access runs the CPU model in Sim_core.c which
+ * advances virtual time, the peripherals in Sim_periph.c (UART, SPI, I2C,
+ * timers, output compare) and the devices on them in Sim_devices.c (IMU,
+ * encoders, GPS, RC receiver, EEPROM and a rover model).  The USB and radio
+ * UARTs connect to a pseudo terminal or UDP socket so a ground station talks
+ * MAVLink to the app like it would over the cable or telemetry radio.
+ * Virtual time is nsec since reset.
+ * Created on 10/16/2026
+ * Modified on 10/16/2026
+ */
+
+#ifndef SIM_H // Header guard
+#define	SIM_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+#include <stdint.h>
+#include <proc/p32mx795f512l.h>
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+#define SIM_PB_HZ 80000000ULL // peripheral bus clock
+#define SIM_PB_PS 12500ULL // one peripheral bus clock in psec
+#define SIM_NS_PER_SEC 1000000000ULL
+#define SIM_NS_PER_MSEC 1000000ULL
+#define SIM_NEVER UINT64_MAX
+#define SIM_WRITE_ONLY 0xFFFFFFFFu // read value of a write only data register
+#define SIM_NUM_VECTORS 64
+
+#define SIM_USB_UART 1 // UART1 on the USB serial bridge
+#define SIM_GPS_UART 2
+#define SIM_RADIO_UART 4 // UART4 on the telemetry radio
+#define SIM_RC_UART 5
+#define SIM_NUM_UARTS 6
+#define SIM_NUM_OC 5
+#define SIM_NUM_DMA 4 // DMA channels modeled
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+typedef struct {
+    double speed; // virtual / real time, 0 runs as fast as possible
+    double duration; // virtual seconds to run, 0 runs until interrupted
+    uint32_t access_ns; // virtual time per register access
+    uint32_t idle_ns; // time skipped once the CPU only polls
+    const char *usb; // "pty", "udp:<local port>:<remote port>" or "none"
+    const char *radio;
+    const char *eeprom; // file backing the EEPROM, NULL for none
+    int mode; // RC mode switch, 0 manual, 1 cruise, 2 auto
+    float throttle; // RC sticks -1 to 1
+    float steering;
+    int verbose;
+} sim_options_t;
+
+typedef struct {
+    uint64_t accesses; // register accesses
+    uint64_t isr_count[SIM_NUM_VECTORS];
+    uint64_t isr_ns[SIM_NUM_VECTORS]; // virtual time in the ISR, nested ones included
+    uint64_t uart_tx[SIM_NUM_UARTS + 1]; // bytes sent by the app
+    uint64_t uart_rx[SIM_NUM_UARTS + 1]; // bytes read by the app
+    uint64_t uart_overrun[SIM_NUM_UARTS + 1]; // bytes lost to OERR
+    uint64_t spi_xfers[3];
+    uint64_t i2c_bytes;
+    uint64_t dma_cells;
+    uint64_t imu_samples;
+} sim_stats_t;
+
+/* called with each byte the app sends on a UART */
+typedef void (*sim_tx_fn)(int uart, uint8_t c);
+
+/*******************************************************************************
+ * PUBLIC VARIABLES                                                            *
+ ******************************************************************************/
+extern uint32_t sim_regs[SIM_NUM_REGISTERS];
+extern uint64_t sim_now; // virtual time [nsec]
+extern uint64_t sim_next_event; // earliest peripheral or device event
+extern sim_options_t sim_opts;
+extern sim_stats_t sim_stats;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/* Sim_core.c */
+
+/**
+ * @Function Sim_core_init(void)
+ * @brief resets the registers and finds the ISRs linked into the app
+ * @author Aaron Hunter
+ */
+void Sim_core_init(void);
+
+/**
+ * @Function Sim_schedule(uint64_t time)
+ * @param time, virtual time of a new peripheral event
+ * @brief makes sure the peripherals run at time
+ * @author Aaron Hunter
+ */
+void Sim_schedule(uint64_t time);
+
+/**
+ * @Function Sim_irq_set(int ifs_reg, uint32_t mask)
+ * @param ifs_reg, SIM_IFS0 to SIM_IFS2
+ * @param mask, interrupt flags to set
+ * @brief sets interrupt flags the way the peripheral hardware does
+ * @author Aaron Hunter
+ */
+void Sim_irq_set(int ifs_reg, uint32_t mask);
+
+/**
+ * @Function Sim_irq_changed(void)
+ * @brief flags, enables or priorities changed, check for a pending interrupt
+ * @author Aaron Hunter
+ */
+void Sim_irq_changed(void);
+
+/**
+ * @Function Sim_pa_to_reg(uint32_t pa)
+ * @param pa, physical address from KVA_TO_PA()
+ * @return register index, -1 if pa is not a register
+ * @author Aaron Hunter
+ */
+int Sim_pa_to_reg(uint32_t pa);
+
+/**
+ * @Function Sim_pa_to_ram(uint32_t pa)
+ * @param pa, physical address from KVA_TO_PA()
+ * @return host address of the RAM byte, NULL if pa is not RAM
+ * @author Aaron Hunter
+ */
+uint8_t *Sim_pa_to_ram(uint32_t pa);
+
+/* Sim_periph.c */
+
+/**
+ * @Function Sim_periph_init(void)
+ * @brief reset values of the peripheral registers
+ * @author Aaron Hunter
+ */
+void Sim_periph_init(void);
+
+/**
+ * @Function Sim_periph_run(void)
+ * @brief runs all peripheral, device and host events due by sim_now and sets
+ * sim_next_event
+ * @author Aaron Hunter
+ */
+void Sim_periph_run(void);
+
+/**
+ * @Function Sim_periph_read(int reg)
+ * @param reg, register about to be accessed
+ * @brief loads the register slot, e.g. pops the UART receive FIFO
+ * @author Aaron Hunter
+ */
+void Sim_periph_read(int reg);
+
+/**
+ * @Function Sim_periph_write(int reg, uint32_t old, uint32_t value)
+ * @param reg, register the app wrote
+ * @param old, value before the write
+ * @param value, value written
+ * @brief hardware side effects of a register write
+ * @author Aaron Hunter
+ */
+void Sim_periph_write(int reg, uint32_t old, uint32_t value);
+
+/**
+ * @Function Sim_periph_levels(void)
+ * @brief sets the level triggered interrupt flags (UART RX and TX) whose
+ * condition holds, the hardware sets them again after the ISR clears them
+ * @author Aaron Hunter
+ */
+void Sim_periph_levels(void);
+
+/**
+ * @Function Sim_uart_connect(int uart, sim_tx_fn tx)
+ * @param uart, 1 to 6
+ * @param tx, called with every byte the UART sends, NULL drops them
+ * @author Aaron Hunter
+ */
+void Sim_uart_connect(int uart, sim_tx_fn tx);
+
+/**
+ * @Function Sim_uart_feed(int uart, const uint8_t *data, int len)
+ * @param uart, 1 to 6
+ * @param data, bytes arriving on the RX pin, one character time each
+ * @param len, number of bytes
+ * @return number of bytes queued
+ * @author Aaron Hunter
+ */
+int Sim_uart_feed(int uart, const uint8_t *data, int len);
+
+/**
+ * @Function Sim_uart_char_ns(int uart)
+ * @param uart, 1 to 6
+ * @return nsec for one character at the configured baud rate and format
+ * @author Aaron Hunter
+ */
+uint64_t Sim_uart_char_ns(int uart);
+
+/**
+ * @Function Sim_oc_pulse_us(int oc)
+ * @param oc, output compare 1 to 5
+ * @return PWM pulse width in usec, 0 if the output is off
+ * @author Aaron Hunter
+ */
+float Sim_oc_pulse_us(int oc);
+
+/* Sim_devices.c */
+
+/**
+ * @Function Sim_dev_init(void)
+ * @brief resets the devices and the rover model
+ * @author Aaron Hunter
+ */
+void Sim_dev_init(void);
+
+/**
+ * @Function Sim_dev_run(void)
+ * @return time of the next device event
+ * @brief steps the rover model and emits sensor data due by sim_now
+ * @author Aaron Hunter
+ */
+uint64_t Sim_dev_run(void);
+
+/**
+ * @Function Sim_dev_pins(int lat_reg, uint32_t old, uint32_t value)
+ * @brief port output change, the SPI chip selects
+ * @author Aaron Hunter
+ */
+void Sim_dev_pins(int lat_reg, uint32_t old, uint32_t value);
+
+/**
+ * @Function Sim_dev_spi_xfer(int spi, uint32_t tx, int bits)
+ * @param spi, SPI module 1 or 2
+ * @param tx, word shifted out
+ * @param bits, 8, 16 or 32
+ * @return word shifted in from the selected device
+ * @author Aaron Hunter
+ */
+uint32_t Sim_dev_spi_xfer(int spi, uint32_t tx, int bits);
+
+/**
+ * @Function Sim_dev_i2c_start(int bus)
+ * @brief start or repeated start on the bus, the next byte is an address
+ * @author Aaron Hunter
+ */
+void Sim_dev_i2c_start(int bus);
+
+/**
+ * @Function Sim_dev_i2c_write(int bus, uint8_t byte, int address)
+ * @param address, TRUE for the address byte after a start
+ * @return TRUE if a device acknowledged the byte
+ * @author Aaron Hunter
+ */
+int Sim_dev_i2c_write(int bus, uint8_t byte, int address);
+
+/**
+ * @Function Sim_dev_i2c_read(int bus)
+ * @return byte driven by the addressed device
+ * @author Aaron Hunter
+ */
+uint8_t Sim_dev_i2c_read(int bus);
+
+/**
+ * @Function Sim_dev_i2c_stop(int bus)
+ * @author Aaron Hunter
+ */
+void Sim_dev_i2c_stop(int bus);
+
+/**
+ * @Function Sim_dev_save(void)
+ * @brief writes the EEPROM back to its file
+ * @author Aaron Hunter
+ */
+void Sim_dev_save(void);
+
+/* Sim_main.c */
+
+/**
+ * @Function Sim_host_run(void)
+ * @return time of the next host poll
+ * @brief exchanges bytes with the USB and radio endpoints, paces virtual time
+ * to sim_opts.speed and ends the run after sim_opts.duration
+ * @author Aaron Hunter
+ */
+uint64_t Sim_host_run(void);
+
+/**
+ * @Function sim_app_main(void)
+ * @brief the app's main(), renamed by the build
+ * @author Aaron Hunter
+ */
+int sim_app_main(void);
+
+#endif	/* SIM_H */
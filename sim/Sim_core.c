@@ -0,0 +1,463 @@
+/*
+ * File:   Sim_core.c
+ * Brief: CPU side of the simulator.  Every register access first commits the
+ * recent ones: their slots are compared with what the accesses handed out and
+ * a change is a write, passed to Sim_periph_write() for its side effects.  A
+ * few accesses stay open so `LATE = SPI1BUF` style statements work in either
+ * evaluation order.  Then virtual time advances by sim_opts.access_ns, the
+ * peripherals run if an event is due, pending interrupts are delivered by
+ * priority like the PIC32 multi vector controller and the slot for the new
+ * access is loaded.  Function calls in the firmware cost the same time through
+ * -finstrument-functions, so loops polling a variable an ISR sets still see
+ * time pass.  When the app only polls for a while, idle_ns is skipped at once
+ * (never past the next event) so waiting on a timer does not cost host time.
+ * ISRs are found through the sections __ISR() puts them in.
+ * Created on 10/16/2026
+ * Modified on 10/16/2026
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <xc.h>
+#include <sys/kmem.h>
+#include "Board.h"
+#include "Sim.h"
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#define IDLE_ACCESSES 32 // accesses without a write before skipping idle time
+#define CORE_PER_USEC 40 // CP0 count runs at half the 80 MHz system clock
+#define OPEN_ACCESSES 4 // accesses checked for a write on every access
+#define PA_SFR 0x1F800000u // physical addresses of the registers, 4 bytes each
+#define PA_RAM 0x08000000u // physical addresses of static RAM around ram_anchor
+#define PA_RAM_SPAN 0x08000000u
+
+/* vectors with a source below, the weak symbols are NULL without an ISR */
+#define VECTOR_LIST(X) X(3) X(4) X(7) X(8) X(11) X(12) X(15) X(16) X(19) \
+    X(20) X(23) X(24) X(25) X(31) X(32) X(33) X(36) X(37) X(38) X(39) \
+    X(40) X(41) X(42) X(43) X(49) X(50) X(51)
+#define ISR_SYMBOL(v) extern char __start_sim_isr_##v[] __attribute__((weak));
+#define ISR_ENTRY(v) isr_table[v] = (sim_isr_t) __start_sim_isr_##v;
+
+/*******************************************************************************
+ * PRIVATE TYPEDEFS                                                            *
+ ******************************************************************************/
+typedef void (*sim_isr_t)(void);
+
+typedef struct {
+    int reg; // -1 for an unused entry
+    uint32_t val; // slot value when handed out or last committed
+} open_access_t;
+
+typedef struct {
+    uint8_t ifs; // IFS register index 0 to 2, same bit in IEC
+    uint8_t bit;
+    uint8_t vector;
+} irq_source_t;
+
+/*******************************************************************************
+ * PRIVATE VARIABLES                                                           *
+ ******************************************************************************/
+uint32_t sim_regs[SIM_NUM_REGISTERS];
+uint64_t sim_now = 0;
+uint64_t sim_next_event = 0;
+sim_stats_t sim_stats;
+
+static const irq_source_t irq_sources[] = {
+    {0, 3, 3}, {0, 4, 4}, {0, 7, 7}, {0, 8, 8}, {0, 11, 11}, {0, 12, 12},
+    {0, 15, 15}, {0, 16, 16}, {0, 19, 19}, {0, 20, 20},
+    {0, 23, 23}, {0, 24, 23}, {0, 25, 23}, // SPI1
+    {0, 26, 24}, {0, 27, 24}, {0, 28, 24}, // UART1
+    {0, 29, 25}, {0, 30, 25}, {0, 31, 25}, // I2C1
+    {1, 5, 31}, {1, 6, 31}, {1, 7, 31}, // SPI2
+    {1, 8, 32}, {1, 9, 32}, {1, 10, 32}, // UART2
+    {1, 11, 33}, {1, 12, 33}, {1, 13, 33}, // I2C2
+    {1, 16, 36}, {1, 17, 37}, {1, 18, 38}, {1, 19, 39}, // DMA
+    {1, 20, 40}, {1, 21, 41}, {1, 22, 42}, {1, 23, 43},
+    {2, 3, 49}, {2, 4, 49}, {2, 5, 49}, // UART4
+    {2, 6, 50}, {2, 7, 50}, {2, 8, 50}, // UART6
+    {2, 9, 51}, {2, 10, 51}, {2, 11, 51}, // UART5
+};
+#define NUM_IRQ_SOURCES (sizeof (irq_sources) / sizeof (irq_sources[0]))
+
+VECTOR_LIST(ISR_SYMBOL)
+static sim_isr_t isr_table[SIM_NUM_VECTORS];
+
+static open_access_t open[OPEN_ACCESSES]; // most recent first
+static unsigned int cpu_ie = 0; // status register IE
+static int cpu_ipl = 0; // current priority level
+static uint8_t irq_dirty = FALSE;
+static uint32_t idle_count = 0;
+static uint32_t count_offset = 0; // CP0 count set by the app
+static uint8_t in_periph = FALSE; // devices call app code, e.g. IMU_get_acc_cal()
+static uint8_t ram_anchor; // statics of the app and the simulator lie around it
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                 *
+ ******************************************************************************/
+static void Sim_commit(void);
+static void Sim_refresh(void);
+static void Sim_cycle(void);
+static void Sim_deliver(void);
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function Sim_core_init(void)
+ * @brief resets the registers and finds the ISRs linked into the app
+ * @author Aaron Hunter
+ */
+void Sim_core_init(void) {
+    int i;
+    memset(sim_regs, 0, sizeof (sim_regs));
+    memset(&sim_stats, 0, sizeof (sim_stats));
+    memset(isr_table, 0, sizeof (isr_table));
+    VECTOR_LIST(ISR_ENTRY)
+    sim_now = 0;
+    sim_next_event = 0;
+    for (i = 0; i < OPEN_ACCESSES; i++) {
+        open[i].reg = -1;
+    }
+    cpu_ie = 0;
+    cpu_ipl = 0;
+}
+
+/**
+ * @Function sim_access(int reg)
+ * @param reg, SIM_<register> index, -1 for a CPU cycle without a register
+ * @return pointer to the register slot, valid until the next access
+ * @brief one CPU access to a special function register: commits the previous
+ * access, advances virtual time and services the peripherals and interrupts
+ * @author Aaron Hunter
+ */
+volatile uint32_t *sim_access(int reg) {
+    static uint32_t dummy_reg; // slot for accesses without a register
+    int i;
+
+    Sim_cycle();
+    if (reg < 0) {
+        Sim_refresh();
+        return &dummy_reg;
+    }
+    Sim_periph_read(reg);
+    Sim_refresh();
+    /* most recent first, a register is open once */
+    for (i = 0; i < OPEN_ACCESSES - 1 && open[i].reg != reg; i++) {
+        ;
+    }
+    for (; i > 0; i--) {
+        open[i] = open[i - 1];
+    }
+    open[0].reg = reg;
+    open[0].val = sim_regs[reg];
+    return &sim_regs[reg];
+}
+
+/**
+ * @Function __cyg_profile_func_enter(void *fn, void *site)
+ * @brief -finstrument-functions hook, a firmware function call takes one CPU
+ * cycle of virtual time like a register access
+ * @author Aaron Hunter
+ */
+__attribute__((no_instrument_function))
+void __cyg_profile_func_enter(void *fn, void *site) {
+    if (in_periph) {
+        return;
+    }
+    Sim_cycle();
+    Sim_refresh();
+}
+
+/**
+ * @Function __cyg_profile_func_exit(void *fn, void *site)
+ * @author Aaron Hunter
+ */
+__attribute__((no_instrument_function))
+void __cyg_profile_func_exit(void *fn, void *site) {
+}
+
+/**
+ * @Function Sim_schedule(uint64_t time)
+ * @param time, virtual time of a new peripheral event
+ * @brief makes sure the peripherals run at time
+ * @author Aaron Hunter
+ */
+void Sim_schedule(uint64_t time) {
+    if (time < sim_next_event) {
+        sim_next_event = time;
+    }
+}
+
+/**
+ * @Function Sim_irq_set(int ifs_reg, uint32_t mask)
+ * @param ifs_reg, SIM_IFS0 to SIM_IFS2
+ * @param mask, interrupt flags to set
+ * @brief sets interrupt flags the way the peripheral hardware does
+ * @author Aaron Hunter
+ */
+void Sim_irq_set(int ifs_reg, uint32_t mask) {
+    if ((sim_regs[ifs_reg] & mask) != mask) {
+        sim_regs[ifs_reg] |= mask;
+        irq_dirty = TRUE;
+    }
+}
+
+/**
+ * @Function Sim_irq_changed(void)
+ * @brief flags, enables or priorities changed, check for a pending interrupt
+ * @author Aaron Hunter
+ */
+void Sim_irq_changed(void) {
+    irq_dirty = TRUE;
+}
+
+/**
+ * @Function sim_kva_to_pa(const volatile void *v)
+ * @param v, address of a register or of a static or global variable
+ * @return simulated physical address
+ * @brief the registers map to PA_SFR, the data and bss sections of the
+ * executable to PA_RAM, stack and heap are out of reach of the DMA like the
+ * target's would be out of its address map
+ * @author Aaron Hunter
+ */
+uint32_t sim_kva_to_pa(const volatile void *v) {
+    const volatile uint32_t *reg = (const volatile uint32_t *) v;
+    intptr_t offset = (const volatile uint8_t *) v - &ram_anchor;
+
+    if (reg >= sim_regs && reg < sim_regs + SIM_NUM_REGISTERS) {
+        return PA_SFR + 4 * (uint32_t) (reg - sim_regs);
+    }
+    if (offset < -(intptr_t) (PA_RAM_SPAN / 2) || offset >= (intptr_t) (PA_RAM_SPAN / 2)) {
+        fprintf(stderr, "sim: KVA_TO_PA(%p) is not static memory\n", (const void *) v);
+        exit(EXIT_FAILURE);
+    }
+    return PA_RAM + PA_RAM_SPAN / 2 + (uint32_t) offset;
+}
+
+/**
+ * @Function Sim_pa_to_reg(uint32_t pa)
+ * @param pa, physical address from KVA_TO_PA()
+ * @return register index, -1 if pa is not a register
+ * @author Aaron Hunter
+ */
+int Sim_pa_to_reg(uint32_t pa) {
+    if (pa < PA_SFR || pa >= PA_SFR + 4 * SIM_NUM_REGISTERS) {
+        return -1;
+    }
+    return (int) ((pa - PA_SFR) / 4);
+}
+
+/**
+ * @Function Sim_pa_to_ram(uint32_t pa)
+ * @param pa, physical address from KVA_TO_PA()
+ * @return host address of the RAM byte, NULL if pa is not RAM
+ * @author Aaron Hunter
+ */
+uint8_t *Sim_pa_to_ram(uint32_t pa) {
+    if (pa < PA_RAM || pa >= PA_RAM + PA_RAM_SPAN) {
+        return NULL;
+    }
+    return &ram_anchor + ((intptr_t) pa - (intptr_t) (PA_RAM + PA_RAM_SPAN / 2));
+}
+
+/**
+ * @Function sim_core_count(void)
+ * @return CP0 count, half the 80 MHz system clock, from virtual time
+ * @author Aaron Hunter
+ */
+uint32_t sim_core_count(void) {
+    sim_access(-1);
+    return (uint32_t) (sim_now * CORE_PER_USEC / 1000) + count_offset;
+}
+
+/**
+ * @Function sim_core_set_count(uint32_t count)
+ * @param count, new CP0 count
+ * @author Aaron Hunter
+ */
+void sim_core_set_count(uint32_t count) {
+    sim_access(-1);
+    count_offset = count - (uint32_t) (sim_now * CORE_PER_USEC / 1000);
+}
+
+/**
+ * @Function sim_disable_interrupts(void)
+ * @return previous status register, bit 0 is the interrupt enable
+ * @author Aaron Hunter
+ */
+unsigned int sim_disable_interrupts(void) {
+    unsigned int status = cpu_ie;
+    sim_access(-1);
+    cpu_ie = 0;
+    return status;
+}
+
+/**
+ * @Function sim_enable_interrupts(void)
+ * @return previous status register, bit 0 is the interrupt enable
+ * @brief pending interrupts are delivered on the next register access
+ * @author Aaron Hunter
+ */
+unsigned int sim_enable_interrupts(void) {
+    unsigned int status = cpu_ie;
+    cpu_ie = 1;
+    irq_dirty = TRUE;
+    sim_access(-1);
+    return status;
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/**
+ * @Function Sim_cycle(void)
+ * @brief one CPU cycle: commits writes, advances virtual time and runs the
+ * peripherals and interrupts that are due
+ * @author Aaron Hunter
+ */
+static void Sim_cycle(void) {
+    Sim_commit();
+    sim_stats.accesses++;
+    sim_now += sim_opts.access_ns;
+    if (++idle_count >= IDLE_ACCESSES) {
+        idle_count = 0;
+        if (sim_next_event > sim_now) {
+            sim_now += sim_opts.idle_ns;
+            if (sim_now > sim_next_event) {
+                sim_now = sim_next_event;
+            }
+        }
+    }
+    if (sim_now >= sim_next_event) {
+        in_periph = TRUE;
+        Sim_periph_run();
+        in_periph = FALSE;
+    }
+    if (irq_dirty && cpu_ie) {
+        Sim_deliver();
+    }
+}
+
+/**
+ * @Function Sim_commit(void)
+ * @brief a changed slot means the app wrote a register it was handed
+ * @author Aaron Hunter
+ */
+static void Sim_commit(void) {
+    int i;
+    int n = 0;
+    int reg[OPEN_ACCESSES];
+    uint32_t old[OPEN_ACCESSES];
+    uint32_t value[OPEN_ACCESSES];
+
+    /* find all writes first, one write can change another open slot */
+    for (i = 0; i < OPEN_ACCESSES; i++) {
+        if (open[i].reg >= 0 && sim_regs[open[i].reg] != open[i].val) {
+            reg[n] = open[i].reg;
+            old[n] = open[i].val;
+            value[n++] = sim_regs[open[i].reg];
+        }
+    }
+    for (i = n - 1; i >= 0; i--) { // oldest first
+        idle_count = 0;
+        Sim_periph_write(reg[i], old[i], value[i]);
+    }
+    if (n) {
+        Sim_refresh(); // e.g. CLR/SET registers read back 0
+    }
+}
+
+/**
+ * @Function Sim_refresh(void)
+ * @brief the hardware and ISRs changed open slots since the commit, these are
+ * not app writes
+ * @author Aaron Hunter
+ */
+static void Sim_refresh(void) {
+    int i;
+    for (i = 0; i < OPEN_ACCESSES; i++) {
+        if (open[i].reg >= 0) {
+            open[i].val = sim_regs[open[i].reg];
+        }
+    }
+}
+
+/**
+ * @Function Sim_deliver(void)
+ * @brief runs the highest priority pending ISR above the current priority
+ * level until none is left, higher priorities nest inside through the ISR's
+ * own register accesses.  The level conditions (UART FIFOs) are sampled
+ * outside of ISRs so a handler that clears its flag before it empties the
+ * FIFO runs once per character like on the target
+ * @author Aaron Hunter
+ */
+static void Sim_deliver(void) {
+    int i;
+    int best;
+    int best_ip;
+    int ip;
+    int saved_ipl;
+    uint32_t mask;
+    uint32_t ipc;
+    uint64_t isr_start;
+    open_access_t saved[OPEN_ACCESSES];
+
+    for (;;) {
+        irq_dirty = FALSE;
+        if (cpu_ipl == 0) {
+            Sim_periph_levels();
+        }
+        best = -1;
+        best_ip = cpu_ipl;
+        for (i = 0; i < NUM_IRQ_SOURCES; i++) {
+            mask = 1u << irq_sources[i].bit;
+            if ((sim_regs[SIM_IFS0 + irq_sources[i].ifs] & mask)
+                    && (sim_regs[SIM_IEC0 + irq_sources[i].ifs] & mask)) {
+                ipc = sim_regs[SIM_IPC0 + (irq_sources[i].vector >> 2)];
+                ip = (ipc >> (8 * (irq_sources[i].vector & 3) + 2)) & 0x7;
+                if (ip > best_ip) {
+                    best = i;
+                    best_ip = ip;
+                }
+            }
+        }
+        irq_dirty = FALSE;
+        if (best < 0) {
+            return;
+        }
+        if (isr_table[irq_sources[best].vector] == NULL) {
+            fprintf(stderr, "sim: no ISR for vector %d, source disabled\n",
+                    irq_sources[best].vector);
+            sim_regs[SIM_IEC0 + irq_sources[best].ifs] &= ~(1u << irq_sources[best].bit);
+            continue;
+        }
+        idle_count = 0;
+        sim_stats.isr_count[irq_sources[best].vector]++;
+        /* the interrupted code keeps its open accesses */
+        memcpy(saved, open, sizeof (open));
+        for (i = 0; i < OPEN_ACCESSES; i++) {
+            open[i].reg = -1;
+        }
+        saved_ipl = cpu_ipl;
+        cpu_ipl = best_ip;
+        isr_start = sim_now;
+        isr_table[irq_sources[best].vector]();
+        Sim_commit();
+        sim_stats.isr_ns[irq_sources[best].vector] += sim_now - isr_start;
+        cpu_ipl = saved_ipl;
+        memcpy(open, saved, sizeof (open));
+        Sim_refresh();
+        if (!cpu_ie) { // the ISR left interrupts off
+            irq_dirty = TRUE;
+            return;
+        }
+    }
+}
@@ -0,0 +1,693 @@
+/*
+ * File:   Sim_devices.c
+ * Brief: Devices on the simulated board and the rover they ride on.  A
+ * kinematic bicycle model driven by the OC2-OC4 servo pulses (both motors and
+ * the steering servo) moves the rover in a local ENU frame, the sensors report
+ * it the way the parts do:
+ *  - ICM-20948 on SPI1 (CS RE0): register banks, WHO_AM_I, the AK09916 behind
+ *    the I2C master (SLV4 one shot and SLV0 reads into EXT_SLV_SENS_DATA),
+ *    samples at the configured divider and data ready pulses on INT1.  Raw
+ *    counts invert the calibration loaded with IMU_set_acc_cal() and
+ *    IMU_set_mag_cal() so the normalized data is the ideal field.
+ *  - three AS5047D on SPI2 (CS RE1-RE3): left wheel, right wheel, steering.
+ *  - NEO-M8N on UART2: $GNRMC at 10 Hz.
+ *  - RC receiver on UART5: SBUS frames every 14 msec from the -m/-t/-s
+ *    options with the hash channel the app checks.
+ *  - 24LC256 EEPROM on I2C1, optionally backed by a file.
+ * Created on 10/16/2026
+ * Modified on 10/16/2026
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <xc.h>
+#include "Board.h"
+#include "ICM_20948_registers.h"
+#include "Sim.h"
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#define MODEL_NS 1000000ULL // rover model step, 1 msec
+#define GPS_NS 100000000ULL // 10 Hz
+#define SBUS_NS 14000000ULL // SBUS frame interval
+#define SBUS_LENGTH 25
+#define SBUS_MIN 172
+#define SBUS_MID 992
+#define SBUS_MAX 1811
+
+/* rover, matches update_odometry() in the GNC app */
+#define WHEELBASE 0.174
+#define WHEEL_RADIUS (0.032 * 1.13)
+#define DELTA_SCALE 0.6958
+#define STEER_ZERO 1805 // steering encoder count at center
+#define V_MAX 3.0 // speed at full ESC pulse [m/s]
+#define DELTA_MAX 0.5 // steering angle at full servo pulse [rad]
+#define TAU_V 0.3 // ESC/motor time constant [s]
+#define TAU_DELTA 0.08 // servo time constant [s]
+#define HOME_LAT 36.9604 // local origin
+#define HOME_LON -122.0329
+
+/* sensors */
+#define GRAVITY 9.80665
+#define ACC_LSB 16384.0 // counts per g at +/-2 g
+#define GYRO_LSB (32768.0 / 500.0) // counts per dps at +/-500 dps
+#define MAG_LSB 0.15 // uT per count
+#define MAG_FIELD 48.0 // uT
+#define ICM_ODR 1125.0 // gyro rate with divider 0
+#define ICM_WHO_AM_I 0xEA
+#define AK_WIA1 0x48
+#define AK_WIA2 0x09
+#define AK_ADDR 0x0C
+#define ENC_COUNTS 16384
+#define EEPROM_ADDR 0x50
+#define EEPROM_SIZE 32768
+#define EEPROM_PAGE 64
+#define EEPROM_WRITE_NS 5000000ULL // page write cycle
+
+/*******************************************************************************
+ * PRIVATE TYPEDEFS                                                            *
+ ******************************************************************************/
+typedef struct {
+    double x, y, psi; // ENU position [m] and heading from east [rad]
+    double v, delta; // speed [m/s], steering angle, left positive [rad]
+    double r; // yaw rate [rad/s]
+    double a; // longitudinal acceleration [m/s^2]
+    double wheel; // wheel angle [rad]
+} rover_t;
+
+/*******************************************************************************
+ * PRIVATE VARIABLES                                                           *
+ ******************************************************************************/
+static rover_t rover;
+static uint64_t model_next;
+
+/* ICM-20948 */
+static uint8_t icm[4][128];
+static uint8_t ak[0x40];
+static int icm_bank;
+static int icm_cs = 1;
+static int icm_index; // byte within the transaction
+static uint8_t icm_addr;
+static int icm_read;
+static uint64_t icm_next;
+
+/* AS5047D, pipelined: each frame returns the result of the previous command */
+static uint16_t enc_cmd[3];
+
+/* GPS and RC */
+static uint64_t gps_next;
+static uint64_t sbus_next;
+
+/* EEPROM */
+static uint8_t eeprom[EEPROM_SIZE];
+static uint16_t ee_addr;
+static int ee_state; // bytes received since the address
+static int ee_selected;
+static int ee_write;
+static int ee_dirty;
+static uint64_t ee_busy_until;
+static uint8_t ee_page[EEPROM_PAGE];
+static uint8_t ee_page_used[EEPROM_PAGE];
+
+static uint32_t noise_state = 0x12345678;
+
+/* the app's calibration when ICM_20948.c is linked */
+int8_t IMU_get_mag_cal(float A[3][3], float b[3]) __attribute__((weak));
+int8_t IMU_get_acc_cal(float A[3][3], float b[3]) __attribute__((weak));
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                 *
+ ******************************************************************************/
+static void Sim_rover_step(double dt);
+static void Sim_icm_reset(void);
+static void Sim_icm_write(uint8_t addr, uint8_t value);
+static void Sim_icm_sample(void);
+static void Sim_gps_send(void);
+static void Sim_sbus_send(void);
+static double Sim_noise(double amplitude);
+static void Sim_uncal(int8_t(*get)(float A[3][3], float b[3]), double n[3], double raw[3], double lsb);
+static int Sim_calibrated(void);
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function Sim_dev_init(void)
+ * @brief resets the devices and the rover model
+ * @author Aaron Hunter
+ */
+void Sim_dev_init(void) {
+    FILE *f;
+    memset(&rover, 0, sizeof (rover));
+    rover.psi = M_PI / 2; // facing north
+    model_next = MODEL_NS;
+    Sim_icm_reset();
+    icm_next = SIM_NEVER;
+    gps_next = GPS_NS;
+    sbus_next = SBUS_NS;
+    memset(eeprom, 0xFF, sizeof (eeprom));
+    if (sim_opts.eeprom && (f = fopen(sim_opts.eeprom, "rb")) != NULL) {
+        if (fread(eeprom, 1, sizeof (eeprom), f) == 0) {
+            fprintf(stderr, "sim: %s is empty\n", sim_opts.eeprom);
+        }
+        fclose(f);
+    }
+}
+
+/**
+ * @Function Sim_dev_run(void)
+ * @return time of the next device event
+ * @brief steps the rover model and emits sensor data due by sim_now
+ * @author Aaron Hunter
+ */
+uint64_t Sim_dev_run(void) {
+    uint64_t next;
+    while (sim_now >= model_next) {
+        Sim_rover_step(MODEL_NS * 1e-9);
+        model_next += MODEL_NS;
+    }
+    if (sim_now >= icm_next) {
+        Sim_icm_sample();
+    }
+    if (sim_now >= gps_next) {
+        Sim_gps_send();
+        gps_next += GPS_NS;
+    }
+    if (sim_now >= sbus_next) {
+        Sim_sbus_send();
+        sbus_next += SBUS_NS;
+    }
+    next = model_next;
+    next = icm_next < next ? icm_next : next;
+    next = gps_next < next ? gps_next : next;
+    next = sbus_next < next ? sbus_next : next;
+    return next;
+}
+
+/**
+ * @Function Sim_dev_pins(int lat_reg, uint32_t old, uint32_t value)
+ * @brief port output change, the SPI chip selects
+ * @author Aaron Hunter
+ */
+void Sim_dev_pins(int lat_reg, uint32_t old, uint32_t value) {
+    if (lat_reg != SIM_LATE) {
+        return;
+    }
+    if ((old ^ value) & 0x1) {
+        icm_cs = value & 0x1;
+        if (icm_cs == 0) {
+            icm_index = 0; // new transaction
+        }
+    }
+}
+
+/**
+ * @Function Sim_dev_spi_xfer(int spi, uint32_t tx, int bits)
+ * @param spi, SPI module 1 or 2
+ * @param tx, word shifted out
+ * @param bits, 8, 16 or 32
+ * @return word shifted in from the selected device
+ * @author Aaron Hunter
+ */
+uint32_t Sim_dev_spi_xfer(int spi, uint32_t tx, int bits) {
+    uint32_t lat = sim_regs[SIM_LATE];
+    uint32_t rx = 0;
+    int e;
+    uint16_t prev;
+    double counts;
+    uint16_t angle;
+
+    if (spi == 1) {
+        if (icm_cs || bits != 8) {
+            return 0xFF; // nobody driving MISO
+        }
+        if (icm_index++ == 0) {
+            icm_addr = tx & 0x7F;
+            icm_read = (tx & 0x80) != 0;
+            return 0;
+        }
+        if (icm_read) {
+            rx = icm[icm_bank][icm_addr];
+        } else {
+            Sim_icm_write(icm_addr, (uint8_t) tx);
+        }
+        icm_addr = (icm_addr + 1) & 0x7F;
+        return rx;
+    }
+    /* SPI2, one encoder selected at a time */
+    for (e = 0; e < 3; e++) {
+        if (!(lat & (1u << (e + 1)))) {
+            break;
+        }
+    }
+    if (e == 3 || bits != 16) {
+        return 0xFFFF;
+    }
+    prev = enc_cmd[e];
+    enc_cmd[e] = (uint16_t) tx;
+    if ((prev & 0x3FFF) != 0x3FFF && (prev & 0x3FFF) != 0x3FFE) {
+        return 0; // register reads and NOP
+    }
+    if (e == 0) { // left wheel faces the other way
+        counts = -rover.wheel / (2 * M_PI) * ENC_COUNTS;
+    } else if (e == 1) {
+        counts = rover.wheel / (2 * M_PI) * ENC_COUNTS;
+    } else {
+        counts = STEER_ZERO - rover.delta / (2 * M_PI / ENC_COUNTS * DELTA_SCALE);
+    }
+    angle = (uint16_t) ((int64_t) floor(counts) & (ENC_COUNTS - 1));
+    /* even parity in bit 15 */
+    if (__builtin_parity(angle)) {
+        angle |= 0x8000;
+    }
+    return angle;
+}
+
+/**
+ * @Function Sim_dev_i2c_start(int bus)
+ * @brief start or repeated start on the bus, the next byte is an address
+ * @author Aaron Hunter
+ */
+void Sim_dev_i2c_start(int bus) {
+    ee_selected = FALSE;
+}
+
+/**
+ * @Function Sim_dev_i2c_write(int bus, uint8_t byte, int address)
+ * @param address, TRUE for the address byte after a start
+ * @return TRUE if a device acknowledged the byte
+ * @author Aaron Hunter
+ */
+int Sim_dev_i2c_write(int bus, uint8_t byte, int address) {
+    if (bus != 1) {
+        return FALSE;
+    }
+    if (address) {
+        if ((byte >> 1) != EEPROM_ADDR || sim_now < ee_busy_until) {
+            return FALSE; // no device, or busy with a write cycle
+        }
+        ee_selected = TRUE;
+        ee_write = (byte & 1) == 0;
+        if (ee_write) {
+            ee_state = 0;
+            memset(ee_page_used, 0, sizeof (ee_page_used));
+        }
+        return TRUE;
+    }
+    if (!ee_selected || !ee_write) {
+        return FALSE;
+    }
+    if (ee_state == 0) {
+        ee_addr = (uint16_t) ((byte << 8) & (EEPROM_SIZE - 1));
+    } else if (ee_state == 1) {
+        ee_addr |= byte;
+    } else { // page buffer, the address wraps within the page
+        ee_page[ee_addr % EEPROM_PAGE] = byte;
+        ee_page_used[ee_addr % EEPROM_PAGE] = TRUE;
+        ee_addr = (uint16_t) ((ee_addr & ~(EEPROM_PAGE - 1))
+                | ((ee_addr + 1) & (EEPROM_PAGE - 1)));
+    }
+    ee_state++;
+    return TRUE;
+}
+
+/**
+ * @Function Sim_dev_i2c_read(int bus)
+ * @return byte driven by the addressed device
+ * @author Aaron Hunter
+ */
+uint8_t Sim_dev_i2c_read(int bus) {
+    uint8_t c;
+    if (bus != 1 || !ee_selected || ee_write) {
+        return 0xFF;
+    }
+    c = eeprom[ee_addr];
+    ee_addr = (ee_addr + 1) & (EEPROM_SIZE - 1);
+    return c;
+}
+
+/**
+ * @Function Sim_dev_i2c_stop(int bus)
+ * @author Aaron Hunter
+ */
+void Sim_dev_i2c_stop(int bus) {
+    int i;
+    if (bus == 1 && ee_selected && ee_write && ee_state > 2) {
+        for (i = 0; i < EEPROM_PAGE; i++) {
+            if (ee_page_used[i]) {
+                eeprom[(ee_addr & ~(EEPROM_PAGE - 1)) | i] = ee_page[i];
+            }
+        }
+        ee_busy_until = sim_now + EEPROM_WRITE_NS;
+        ee_dirty = TRUE;
+    }
+    ee_selected = FALSE;
+}
+
+/**
+ * @Function Sim_dev_save(void)
+ * @brief writes the EEPROM back to its file
+ * @author Aaron Hunter
+ */
+void Sim_dev_save(void) {
+    FILE *f;
+    if (sim_opts.eeprom && ee_dirty && (f = fopen(sim_opts.eeprom, "wb")) != NULL) {
+        fwrite(eeprom, 1, sizeof (eeprom), f);
+        fclose(f);
+    }
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/**
+ * @Function Sim_rover_step(double dt)
+ * @brief kinematic bicycle model, ESC and servo as first order lags from the
+ * OC2 (left motor), OC3 (right motor) and OC4 (steering) pulses
+ * @author Aaron Hunter
+ */
+static void Sim_rover_step(double dt) {
+    double left = Sim_oc_pulse_us(2);
+    double right = Sim_oc_pulse_us(3);
+    double steer = Sim_oc_pulse_us(4);
+    double v_cmd = 0.0;
+    double delta_cmd = 0.0;
+    double v_prev = rover.v;
+
+    if (left > 0 && right > 0) {
+        v_cmd = ((left + right) / 2 - 1500.0) / 500.0 * V_MAX;
+    }
+    if (steer > 0) {
+        delta_cmd = -(steer - 1500.0) / 500.0 * DELTA_MAX;
+    }
+    rover.v += (v_cmd - rover.v) * dt / TAU_V;
+    rover.delta += (delta_cmd - rover.delta) * dt / TAU_DELTA;
+    rover.r = rover.v * sin(rover.delta) / WHEELBASE;
+    rover.a = (rover.v - v_prev) / dt;
+    rover.psi += rover.r * dt;
+    if (rover.psi > M_PI) {
+        rover.psi -= 2 * M_PI;
+    } else if (rover.psi < -M_PI) {
+        rover.psi += 2 * M_PI;
+    }
+    rover.x += rover.v * cos(rover.psi) * dt;
+    rover.y += rover.v * sin(rover.psi) * dt;
+    rover.wheel += rover.v / WHEEL_RADIUS * dt;
+}
+
+/**
+ * @Function Sim_icm_reset(void)
+ * @brief power on register values
+ * @author Aaron Hunter
+ */
+static void Sim_icm_reset(void) {
+    memset(icm, 0, sizeof (icm));
+    memset(ak, 0, sizeof (ak));
+    icm[0][AGB0_REG_WHO_AM_I] = ICM_WHO_AM_I;
+    icm[0][AGB0_REG_PWR_MGMT_1] = 0x41; // asleep
+    icm[2][AGB2_REG_GYRO_CONFIG_1] = 0x01;
+    ak[M_REG_WIA1] = AK_WIA1;
+    ak[1] = AK_WIA2;
+    icm_bank = 0;
+}
+
+/**
+ * @Function Sim_icm_write(uint8_t addr, uint8_t value)
+ * @brief register write in the current bank with its side effects
+ * @author Aaron Hunter
+ */
+static void Sim_icm_write(uint8_t addr, uint8_t value) {
+    uint8_t slv_addr;
+    uint8_t slv_reg;
+    if (addr == REG_BANK_SEL) {
+        icm_bank = (value >> 4) & 0x3;
+        icm[0][REG_BANK_SEL] = icm[1][REG_BANK_SEL] = value;
+        icm[2][REG_BANK_SEL] = icm[3][REG_BANK_SEL] = value;
+        return;
+    }
+    if (icm_bank == 0 && addr == AGB0_REG_WHO_AM_I) {
+        return; // read only
+    }
+    if (icm_bank == 0 && addr == AGB0_REG_PWR_MGMT_1 && (value & 0x80)) {
+        Sim_icm_reset();
+        return;
+    }
+    icm[icm_bank][addr] = value;
+    if (icm_bank == 0 && addr == AGB0_REG_PWR_MGMT_1) {
+        if (!(value & 0x40) && icm_next == SIM_NEVER) {
+            icm_next = sim_now + (uint64_t) (SIM_NS_PER_SEC / ICM_ODR);
+            Sim_schedule(icm_next);
+        } else if (value & 0x40) {
+            icm_next = SIM_NEVER;
+        }
+    }
+    if (icm_bank == 3 && addr == AGB3_REG_I2C_SLV4_CTRL && (value & 0x80)) {
+        /* one shot transaction with the magnetometer */
+        slv_addr = icm[3][AGB3_REG_I2C_SLV4_ADDR];
+        slv_reg = icm[3][AGB3_REG_I2C_SLV4_REG] & 0x3F;
+        if ((slv_addr & 0x7F) == AK_ADDR) {
+            if (slv_addr & 0x80) {
+                icm[3][AGB3_REG_I2C_SLV4_DI] = ak[slv_reg];
+            } else {
+                ak[slv_reg] = icm[3][AGB3_REG_I2C_SLV4_DO];
+            }
+        }
+        icm[3][AGB3_REG_I2C_SLV4_CTRL] &= 0x7F;
+        icm[0][AGB0_REG_I2C_MST_STATUS] |= 0x40; // SLV4_DONE
+    }
+}
+
+/**
+ * @Function Sim_icm_sample(void)
+ * @brief loads a new sample into the data registers, the magnetometer through
+ * SLV0 when it is set up, and pulses INT1 when data ready is enabled
+ * @author Aaron Hunter
+ */
+static void Sim_icm_sample(void) {
+    double acc_n[3];
+    double mag_n[3];
+    double raw[3];
+    double gyro[3];
+    int16_t v;
+    int i;
+    uint8_t *d = &icm[0][AGB0_REG_ACCEL_XOUT_H];
+    uint8_t *ext = &icm[0][AGB0_REG_EXT_SLV_SENS_DATA_00];
+    double div = icm[2][AGB2_REG_GYRO_SMPLRT_DIV];
+    double c = cos(rover.psi);
+    double s = sin(rover.psi);
+    /* the inertial field the app uses, ENU normalized */
+    const double m_i[3] = {0.110011998753301, 0.478219898291142, -0.871322609031072};
+
+    sim_stats.imu_samples++;
+    /* specific force in g, body x forward, y left, z up */
+    acc_n[0] = rover.a / GRAVITY + Sim_noise(0.002);
+    acc_n[1] = rover.v * rover.r / GRAVITY + Sim_noise(0.002);
+    acc_n[2] = 1.0 + Sim_noise(0.002);
+    Sim_uncal(IMU_get_acc_cal, acc_n, raw, ACC_LSB);
+    for (i = 0; i < 3; i++) {
+        v = (int16_t) lrint(raw[i]);
+        d[2 * i] = (uint8_t) (v >> 8);
+        d[2 * i + 1] = (uint8_t) v;
+    }
+    gyro[0] = Sim_noise(0.05);
+    gyro[1] = Sim_noise(0.05);
+    gyro[2] = rover.r * 180.0 / M_PI + Sim_noise(0.05);
+    for (i = 0; i < 3; i++) {
+        v = (int16_t) lrint(gyro[i] * GYRO_LSB);
+        d[6 + 2 * i] = (uint8_t) (v >> 8);
+        d[7 + 2 * i] = (uint8_t) v;
+    }
+    d[12] = 0x00; // 21 C
+    d[13] = 0x00;
+    /* inertial field in the body frame */
+    mag_n[0] = c * m_i[0] + s * m_i[1];
+    mag_n[1] = -s * m_i[0] + c * m_i[1];
+    mag_n[2] = m_i[2];
+    for (i = 0; i < 3; i++) {
+        mag_n[i] += Sim_noise(0.005);
+    }
+    Sim_uncal(IMU_get_mag_cal, mag_n, raw, MAG_FIELD / MAG_LSB);
+    /* the driver flips y and z of the AK09916 into the accel axes */
+    raw[1] = -raw[1];
+    raw[2] = -raw[2];
+    if ((icm[3][AGB3_REG_I2C_SLV0_CTRL] & 0x80) && ak[M_REG_CNTL2] != 0) {
+        ext[0] = 0x01; // ST1 DRDY
+        for (i = 0; i < 3; i++) {
+            v = (int16_t) lrint(raw[i]);
+            ext[1 + 2 * i] = (uint8_t) v; // little endian
+            ext[2 + 2 * i] = (uint8_t) (v >> 8);
+        }
+        ext[7] = 0; // TMPS
+        ext[8] = 0; // ST2
+    }
+    icm[0][AGB0_REG_INT_STATUS_1] |= 0x01;
+    if (icm[0][AGB0_REG_INT_ENABLE_1] & 0x01) {
+        Sim_irq_set(SIM_IFS0, 1u << 7); // INT1
+    }
+    icm_next += (uint64_t) (SIM_NS_PER_SEC * (1.0 + div) / ICM_ODR);
+}
+
+/**
+ * @Function Sim_uncal(get, n, raw, lsb)
+ * @param get, calibration getter of the ICM driver, NULL if not linked
+ * @param n, ideal normalized vector
+ * @param raw, counts that normalize to n
+ * @param lsb, counts per unit without a calibration
+ * @brief solves A * raw + b = n for raw
+ * @author Aaron Hunter
+ */
+static void Sim_uncal(int8_t(*get)(float A[3][3], float b[3]), double n[3], double raw[3], double lsb) {
+    float A[3][3];
+    float b[3];
+    double y[3];
+    double det;
+    int i;
+
+    if (get == NULL || get(A, b) != SUCCESS || !Sim_calibrated()) {
+        for (i = 0; i < 3; i++) {
+            raw[i] = n[i] * lsb;
+        }
+        return;
+    }
+    for (i = 0; i < 3; i++) {
+        y[i] = n[i] - b[i];
+    }
+    det = A[0][0] * (A[1][1] * A[2][2] - A[1][2] * A[2][1])
+            - A[0][1] * (A[1][0] * A[2][2] - A[1][2] * A[2][0])
+            + A[0][2] * (A[1][0] * A[2][1] - A[1][1] * A[2][0]);
+    if (fabs(det) < 1e-30) {
+        for (i = 0; i < 3; i++) {
+            raw[i] = n[i] * lsb;
+        }
+        return;
+    }
+    /* Cramer's rule */
+    raw[0] = (y[0] * (A[1][1] * A[2][2] - A[1][2] * A[2][1])
+            - A[0][1] * (y[1] * A[2][2] - A[1][2] * y[2])
+            + A[0][2] * (y[1] * A[2][1] - A[1][1] * y[2])) / det;
+    raw[1] = (A[0][0] * (y[1] * A[2][2] - A[1][2] * y[2])
+            - y[0] * (A[1][0] * A[2][2] - A[1][2] * A[2][0])
+            + A[0][2] * (A[1][0] * y[2] - y[1] * A[2][0])) / det;
+    raw[2] = (A[0][0] * (A[1][1] * y[2] - y[1] * A[2][1])
+            - A[0][1] * (A[1][0] * y[2] - y[1] * A[2][0])
+            + y[0] * (A[1][0] * A[2][1] - A[1][1] * A[2][0])) / det;
+}
+
+/**
+ * @Function Sim_calibrated(void)
+ * @return TRUE once the app loaded an accelerometer calibration, the driver
+ * normalizes both sensors from then on, before that raw counts are scaled
+ * @note an identity calibration looks like none, the result is the same
+ * @author Aaron Hunter
+ */
+static int Sim_calibrated(void) {
+    float A[3][3];
+    float b[3];
+    int i;
+    int j;
+
+    if (IMU_get_acc_cal == NULL || IMU_get_acc_cal(A, b) != SUCCESS) {
+        return FALSE;
+    }
+    for (i = 0; i < 3; i++) {
+        if (b[i] != 0.0f) {
+            return TRUE;
+        }
+        for (j = 0; j < 3; j++) {
+            if (A[i][j] != (i == j ? 1.0f : 0.0f)) {
+                return TRUE;
+            }
+        }
+    }
+    return FALSE;
+}
+
+/**
+ * @Function Sim_gps_send(void)
+ * @brief $GNRMC for the rover position with a valid checksum
+ * @author Aaron Hunter
+ */
+static void Sim_gps_send(void) {
+    char body[128];
+    char sentence[160];
+    double t = sim_now * 1e-9;
+    double lat = HOME_LAT + rover.y / 111320.0 * 1.0;
+    double lon = HOME_LON + rover.x / (111320.0 * cos(HOME_LAT * M_PI / 180.0));
+    double alat = fabs(lat);
+    double alon = fabs(lon);
+    double cog = 90.0 - rover.psi * 180.0 / M_PI;
+    int hh = (int) (t / 3600) % 24;
+    int mm = (int) (t / 60) % 60;
+    double ss = fmod(t, 60.0);
+    uint8_t cksum = 0;
+    int i;
+    int len;
+
+    if (cog < 0) {
+        cog += 360.0;
+    }
+    snprintf(body, sizeof (body), "GNRMC,%02d%02d%05.2f,A,%02d%08.5f,%c,%03d%08.5f,%c,%.3f,%.2f,161026,,,A",
+            hh, mm, ss,
+            (int) alat, (alat - (int) alat) * 60.0, lat >= 0 ? 'N' : 'S',
+            (int) alon, (alon - (int) alon) * 60.0, lon >= 0 ? 'E' : 'W',
+            fabs(rover.v) / 0.5144444444, cog);
+    for (i = 0; body[i]; i++) {
+        cksum ^= (uint8_t) body[i];
+    }
+    len = snprintf(sentence, sizeof (sentence), "$%s*%02X\r\n", body, cksum);
+    Sim_uart_feed(SIM_GPS_UART, (uint8_t *) sentence, len);
+}
+
+/**
+ * @Function Sim_sbus_send(void)
+ * @brief SBUS frame, 16 channels of 11 bits packed LSB first, flags 0
+ * @author Aaron Hunter
+ */
+static void Sim_sbus_send(void) {
+    static const uint16_t mode_counts[] = {SBUS_MIN, SBUS_MID, SBUS_MAX};
+    uint16_t ch[16];
+    uint8_t frame[SBUS_LENGTH];
+    uint32_t bits = 0;
+    int nbits = 0;
+    int i;
+    int j = 1;
+
+    for (i = 0; i < 16; i++) {
+        ch[i] = SBUS_MID;
+    }
+    ch[2] = (uint16_t) (SBUS_MID + sim_opts.throttle * (SBUS_MAX - SBUS_MID)); // ELE
+    ch[3] = (uint16_t) (SBUS_MID + sim_opts.steering * (SBUS_MAX - SBUS_MID)); // RUD
+    ch[4] = (ch[0] >> 2) + (ch[1] >> 2) + (ch[2] >> 2) + (ch[3] >> 2); // HASH
+    ch[5] = mode_counts[sim_opts.mode % 3]; // SWITCH_A
+    memset(frame, 0, sizeof (frame));
+    frame[0] = 0x0F;
+    for (i = 0; i < 16; i++) {
+        bits |= (uint32_t) (ch[i] & 0x7FF) << nbits;
+        nbits += 11;
+        while (nbits >= 8) {
+            frame[j++] = (uint8_t) bits;
+            bits >>= 8;
+            nbits -= 8;
+        }
+    }
+    frame[23] = 0x00; // flags
+    frame[24] = 0x00; // end
+    Sim_uart_feed(SIM_RC_UART, frame, SBUS_LENGTH);
+}
+
+/**
+ * @Function Sim_noise(double amplitude)
+ * @return uniform noise in +/- amplitude, repeatable from run to run
+ * @author Aaron Hunter
+ */
+static double Sim_noise(double amplitude) {
+    noise_state = noise_state * 1664525u + 1013904223u;
+    return amplitude * ((double) (noise_state >> 8) / (double) (1u << 23) - 1.0);
+}
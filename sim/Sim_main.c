@@ -0,0 +1,846 @@
+/*
+ * File:   Sim_main.c
+ * Brief: Host side of the simulator: options, the USB and radio endpoints,
+ * pacing against the wall clock and the report at exit.  main() sets up the
+ * board and runs the app's main(), renamed sim_app_main() by the build.
+ * printf() from the app goes out UART1 through _mon_putc() like on the board,
+ * simulator messages go to stderr.
+ *
+ * usage: rover_gnc_sil [-d sec] [-x speed] [-u usb] [-r radio] [-m mode]
+ *        [-t throttle] [-s steering] [-q access_ns] [-i idle_ns] [-e file] [-v]
+ *  -d virtual seconds to run, 0 (default) until Ctrl-C
+ *  -x virtual time / real time, 1 (default) is real time, 0 as fast as possible
+ *  -u, -r endpoint for the USB (UART1) and radio (UART4) ports:
+ *     pty, udp:<local port>:<remote port> or none
+ *     defaults: -u pty -r udp:14551:14550, QGroundControl listens on 14550
+ *  -m RC mode switch: manual, cruise or auto (default manual)
+ *  -t, -s RC throttle and steering stick, -1 to 1 (default 0)
+ *  -q virtual nsec per register access (default 25)
+ *  -i virtual nsec skipped when the app only polls (default 10000)
+ *  -e file backing the 24LC256 EEPROM
+ *  -v verbose
+ *
+ * Test harness: make -C sim test
+ * Created on 10/16/2026
+ * Modified on 10/16/2026
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+#define _GNU_SOURCE // fopencookie(), posix_openpt()
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <xc.h>
+#include "Board.h"
+#include "Sim.h"
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#define HOST_NS SIM_NS_PER_MSEC // host poll period, virtual time
+#define HOST_BUFFER 4096
+#define MAX_SLEEP_NS 20000000LL // longest single pacing sleep
+
+/*******************************************************************************
+ * PRIVATE TYPEDEFS                                                            *
+ ******************************************************************************/
+typedef enum {
+    EP_NONE, EP_PTY, EP_UDP
+} endpoint_type_t;
+
+typedef struct {
+    endpoint_type_t type;
+    int uart;
+    int fd;
+    int slave_fd; // our own handle on the pty slave, keeps the master open
+    struct sockaddr_in remote;
+    uint8_t tx[HOST_BUFFER]; // bytes from the app waiting for the host
+    int tx_len;
+    uint8_t rx[HOST_BUFFER]; // bytes from the host waiting for the UART
+    int rx_head;
+    int rx_len;
+} endpoint_t;
+
+/*******************************************************************************
+ * PRIVATE VARIABLES                                                           *
+ ******************************************************************************/
+sim_options_t sim_opts = {
+    .speed = 1.0,
+    .duration = 0.0,
+    .access_ns = 25,
+    .idle_ns = 10000,
+    .usb = "pty",
+    .radio = "udp:14551:14550",
+    .eeprom = NULL,
+    .mode = 0,
+    .throttle = 0.0f,
+    .steering = 0.0f,
+    .verbose = FALSE,
+};
+
+static endpoint_t endpoints[2]; // USB, radio
+static uint64_t host_next = 0;
+static struct timespec real_start;
+static volatile sig_atomic_t stop_requested = FALSE;
+static FILE *host_stdout; // the terminal, when the app has no _mon_putc()
+
+/* SerialM32.c, when the app links it */
+void _mon_putc(char c) __attribute__((weak));
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                 *
+ ******************************************************************************/
+static void Sim_usage(const char *name);
+static int Sim_endpoint_open(endpoint_t *ep, const char *spec, int uart);
+static void Sim_endpoint_tx(int uart, uint8_t c);
+static void Sim_endpoint_poll(endpoint_t *ep);
+static void Sim_endpoint_flush(endpoint_t *ep);
+static ssize_t Sim_stdout_write(void *cookie, const char *buf, size_t size);
+static double Sim_real_time(void);
+static void Sim_pace(void);
+static void Sim_report(void);
+static void Sim_on_signal(int sig);
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function Sim_host_run(void)
+ * @return time of the next host poll
+ * @brief exchanges bytes with the USB and radio endpoints, paces virtual time
+ * to sim_opts.speed and ends the run after sim_opts.duration
+ * @author Aaron Hunter
+ */
+uint64_t Sim_host_run(void) {
+    int i;
+    if (sim_now < host_next) {
+        return host_next;
+    }
+    for (i = 0; i < 2; i++) {
+        Sim_endpoint_flush(&endpoints[i]);
+        Sim_endpoint_poll(&endpoints[i]);
+    }
+    Sim_pace();
+    if (stop_requested) {
+        fprintf(stderr, "\nsim: interrupted\n");
+        exit(EXIT_SUCCESS);
+    }
+    if (sim_opts.duration > 0 && sim_now >= (uint64_t) (sim_opts.duration * SIM_NS_PER_SEC)) {
+        exit(EXIT_SUCCESS);
+    }
+    host_next += HOST_NS;
+    return host_next;
+}
+
+/**
+ * @Function main(int argc, char *argv[])
+ * @brief parses the options, connects the endpoints and runs the app
+ * @author Aaron Hunter
+ */
+int main(int argc, char *argv[]) {
+    int opt;
+    static cookie_io_functions_t uart_io = {.write = Sim_stdout_write};
+
+    while ((opt = getopt(argc, argv, "d:x:u:r:m:t:s:q:i:e:vh")) != -1) {
+        switch (opt) {
+            case 'd':
+                sim_opts.duration = atof(optarg);
+                break;
+            case 'x':
+                sim_opts.speed = atof(optarg);
+                break;
+            case 'u':
+                sim_opts.usb = optarg;
+                break;
+            case 'r':
+                sim_opts.radio = optarg;
+                break;
+            case 'm':
+                if (strcmp(optarg, "manual") == 0) {
+                    sim_opts.mode = 0;
+                } else if (strcmp(optarg, "cruise") == 0) {
+                    sim_opts.mode = 1;
+                } else if (strcmp(optarg, "auto") == 0) {
+                    sim_opts.mode = 2;
+                } else {
+                    Sim_usage(argv[0]);
+                }
+                break;
+            case 't':
+                sim_opts.throttle = fmaxf(-1.0f, fminf(1.0f, (float) atof(optarg)));
+                break;
+            case 's':
+                sim_opts.steering = fmaxf(-1.0f, fminf(1.0f, (float) atof(optarg)));
+                break;
+            case 'q':
+                sim_opts.access_ns = (uint32_t) atoi(optarg);
+                break;
+            case 'i':
+                sim_opts.idle_ns = (uint32_t) atoi(optarg);
+                break;
+            case 'e':
+                sim_opts.eeprom = optarg;
+                break;
+            case 'v':
+                sim_opts.verbose = TRUE;
+                break;
+            default:
+                Sim_usage(argv[0]);
+        }
+    }
+    if (sim_opts.access_ns == 0) {
+        fprintf(stderr, "sim: -q must be at least 1 nsec\n");
+        return EXIT_FAILURE;
+    }
+    Sim_core_init();
+    Sim_periph_init();
+    Sim_dev_init();
+    if (Sim_endpoint_open(&endpoints[0], sim_opts.usb, SIM_USB_UART) == ERROR
+            || Sim_endpoint_open(&endpoints[1], sim_opts.radio, SIM_RADIO_UART) == ERROR) {
+        return EXIT_FAILURE;
+    }
+    /* printf() goes out the USB UART like it does on the board */
+    host_stdout = fdopen(dup(STDOUT_FILENO), "w");
+    if (_mon_putc != NULL) {
+        stdout = fopencookie(NULL, "w", uart_io);
+        setvbuf(stdout, NULL, _IONBF, 0);
+    }
+    signal(SIGINT, Sim_on_signal);
+    signal(SIGTERM, Sim_on_signal);
+    signal(SIGPIPE, SIG_IGN);
+    atexit(Sim_report);
+    clock_gettime(CLOCK_MONOTONIC, &real_start);
+    sim_app_main();
+    fprintf(stderr, "sim: app main() returned\n");
+    return EXIT_SUCCESS;
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/**
+ * @Function Sim_usage(const char *name)
+ * @brief prints the options and exits
+ * @author Aaron Hunter
+ */
+static void Sim_usage(const char *name) {
+    fprintf(stderr, "usage: %s [-d sec] [-x speed] [-u usb] [-r radio] [-m manual|cruise|auto]\n"
+            "       [-t throttle] [-s steering] [-q access_ns] [-i idle_ns] [-e eeprom] [-v]\n"
+            "  endpoints: pty, udp:<local port>:<remote port> or none\n", name);
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * @Function Sim_endpoint_open(endpoint_t *ep, const char *spec, int uart)
+ * @param ep, endpoint to open
+ * @param spec, pty, udp:<local port>:<remote port> or none
+ * @param uart, UART the endpoint connects to
+ * @return SUCCESS or ERROR
+ * @author Aaron Hunter
+ */
+static int Sim_endpoint_open(endpoint_t *ep, const char *spec, int uart) {
+    struct termios tio;
+    struct sockaddr_in local;
+    int local_port;
+    int remote_port;
+
+    memset(ep, 0, sizeof (*ep));
+    ep->uart = uart;
+    ep->fd = -1;
+    ep->slave_fd = -1;
+    if (strcmp(spec, "none") == 0) {
+        ep->type = EP_NONE;
+        Sim_uart_connect(uart, NULL);
+        return SUCCESS;
+    }
+    if (strcmp(spec, "pty") == 0) {
+        ep->fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (ep->fd < 0 || grantpt(ep->fd) < 0 || unlockpt(ep->fd) < 0) {
+            perror("sim: pty");
+            return ERROR;
+        }
+        /* raw, the link carries binary MAVLink */
+        ep->slave_fd = open(ptsname(ep->fd), O_RDWR | O_NOCTTY);
+        if (ep->slave_fd >= 0 && tcgetattr(ep->slave_fd, &tio) == 0) {
+            cfmakeraw(&tio);
+            tcsetattr(ep->slave_fd, TCSANOW, &tio);
+        }
+        fprintf(stderr, "sim: UART%d on %s\n", uart, ptsname(ep->fd));
+        ep->type = EP_PTY;
+    } else if (sscanf(spec, "udp:%d:%d", &local_port, &remote_port) == 2) {
+        ep->fd = socket(AF_INET, SOCK_DGRAM, 0);
+        memset(&local, 0, sizeof (local));
+        local.sin_family = AF_INET;
+        local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        local.sin_port = htons(local_port);
+        if (ep->fd < 0 || bind(ep->fd, (struct sockaddr *) &local, sizeof (local)) < 0) {
+            perror("sim: udp");
+            return ERROR;
+        }
+        fcntl(ep->fd, F_SETFL, O_NONBLOCK);
+        ep->remote.sin_family = AF_INET;
+        ep->remote.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ep->remote.sin_port = htons(remote_port);
+        fprintf(stderr, "sim: UART%d on udp 127.0.0.1:%d -> %d\n", uart, local_port, remote_port);
+        ep->type = EP_UDP;
+    } else {
+        fprintf(stderr, "sim: bad endpoint %s\n", spec);
+        return ERROR;
+    }
+    Sim_uart_connect(uart, Sim_endpoint_tx);
+    return SUCCESS;
+}
+
+/**
+ * @Function Sim_endpoint_tx(int uart, uint8_t c)
+ * @brief a byte left the UART, collected until the next host poll
+ * @author Aaron Hunter
+ */
+static void Sim_endpoint_tx(int uart, uint8_t c) {
+    endpoint_t *ep = uart == SIM_USB_UART ? &endpoints[0] : &endpoints[1];
+    if (ep->tx_len == HOST_BUFFER) {
+        Sim_endpoint_flush(ep);
+    }
+    ep->tx[ep->tx_len++] = c;
+}
+
+/**
+ * @Function Sim_endpoint_flush(endpoint_t *ep)
+ * @brief hands the bytes the app sent to the host, a UDP datagram per poll
+ * @author Aaron Hunter
+ */
+static void Sim_endpoint_flush(endpoint_t *ep) {
+    ssize_t n = 0;
+    if (ep->tx_len == 0) {
+        return;
+    }
+    if (ep->type == EP_PTY) {
+        n = write(ep->fd, ep->tx, ep->tx_len);
+        if (n < 0 && errno == EAGAIN) {
+            n = 0; // nobody reading, the pty buffer is full
+        }
+    } else if (ep->type == EP_UDP) {
+        sendto(ep->fd, ep->tx, ep->tx_len, 0, (struct sockaddr *) &ep->remote, sizeof (ep->remote));
+    }
+    /* bytes a full pty can't take are dropped like on an unplugged cable */
+    ep->tx_len = 0;
+}
+
+/**
+ * @Function Sim_endpoint_poll(endpoint_t *ep)
+ * @brief moves bytes from the host onto the UART RX pin
+ * @author Aaron Hunter
+ */
+static void Sim_endpoint_poll(endpoint_t *ep) {
+    ssize_t n;
+    int queued;
+
+    if (ep->type == EP_NONE) {
+        return;
+    }
+    if (ep->rx_len == 0) {
+        ep->rx_head = 0;
+        n = ep->type == EP_UDP ? recv(ep->fd, ep->rx, HOST_BUFFER, 0)
+                : read(ep->fd, ep->rx, HOST_BUFFER);
+        if (n <= 0) {
+            return;
+        }
+        ep->rx_len = (int) n;
+    }
+    queued = Sim_uart_feed(ep->uart, ep->rx + ep->rx_head, ep->rx_len);
+    ep->rx_head += queued;
+    ep->rx_len -= queued;
+}
+
+/**
+ * @Function Sim_stdout_write(void *cookie, const char *buf, size_t size)
+ * @brief stdout of the app, one _mon_putc() per character
+ * @author Aaron Hunter
+ */
+static ssize_t Sim_stdout_write(void *cookie, const char *buf, size_t size) {
+    size_t i;
+    for (i = 0; i < size; i++) {
+        _mon_putc(buf[i]);
+    }
+    return (ssize_t) size;
+}
+
+/**
+ * @Function Sim_real_time(void)
+ * @return seconds since the app started
+ * @author Aaron Hunter
+ */
+static double Sim_real_time(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - real_start.tv_sec) + (now.tv_nsec - real_start.tv_nsec) * 1e-9;
+}
+
+/**
+ * @Function Sim_pace(void)
+ * @brief sleeps while virtual time is ahead of sim_opts.speed * real time
+ * @author Aaron Hunter
+ */
+static void Sim_pace(void) {
+    struct timespec ts;
+    double ahead;
+    int64_t ns;
+
+    if (sim_opts.speed <= 0) {
+        return;
+    }
+    ahead = sim_now * 1e-9 / sim_opts.speed - Sim_real_time();
+    if (ahead <= 0) {
+        return;
+    }
+    ns = (int64_t) (ahead * 1e9);
+    ns = ns > MAX_SLEEP_NS ? MAX_SLEEP_NS : ns;
+    ts.tv_sec = ns / 1000000000LL;
+    ts.tv_nsec = ns % 1000000000LL;
+    nanosleep(&ts, NULL);
+}
+
+/**
+ * @Function Sim_report(void)
+ * @brief run statistics at exit, saves the EEPROM
+ * @author Aaron Hunter
+ */
+static void Sim_report(void) {
+    double real = Sim_real_time();
+    double virt = sim_now * 1e-9;
+    int i;
+
+    Sim_endpoint_flush(&endpoints[0]);
+    Sim_endpoint_flush(&endpoints[1]);
+    Sim_dev_save();
+    fprintf(stderr, "sim: %.3f s virtual in %.3f s real, %.1fx real time\n",
+            virt, real, real > 0 ? virt / real : 0.0);
+    fprintf(stderr, "sim: %llu register accesses, %.1f M/s\n",
+            (unsigned long long) sim_stats.accesses,
+            real > 0 ? sim_stats.accesses / real * 1e-6 : 0.0);
+    if (!sim_opts.verbose) {
+        return;
+    }
+    for (i = 0; i < SIM_NUM_VECTORS; i++) {
+        if (sim_stats.isr_count[i]) {
+            fprintf(stderr, "sim: vector %2d: %llu interrupts, %.3f ms\n", i,
+                    (unsigned long long) sim_stats.isr_count[i], sim_stats.isr_ns[i] * 1e-6);
+        }
+    }
+    for (i = 1; i <= SIM_NUM_UARTS; i++) {
+        if (sim_stats.uart_tx[i] || sim_stats.uart_rx[i]) {
+            fprintf(stderr, "sim: UART%d: %llu bytes out, %llu in, %llu overruns\n", i,
+                    (unsigned long long) sim_stats.uart_tx[i],
+                    (unsigned long long) sim_stats.uart_rx[i],
+                    (unsigned long long) sim_stats.uart_overrun[i]);
+        }
+    }
+    fprintf(stderr, "sim: SPI1 %llu, SPI2 %llu transfers, I2C1 %llu bytes, %llu DMA cells, %llu IMU samples\n",
+            (unsigned long long) sim_stats.spi_xfers[1],
+            (unsigned long long) sim_stats.spi_xfers[2],
+            (unsigned long long) sim_stats.i2c_bytes,
+            (unsigned long long) sim_stats.dma_cells,
+            (unsigned long long) sim_stats.imu_samples);
+}
+
+/**
+ * @Function Sim_on_signal(int sig)
+ * @brief stops at the next host poll so the report runs
+ * @author Aaron Hunter
+ */
+static void Sim_on_signal(int sig) {
+    if (stop_requested) {
+        _exit(EXIT_FAILURE); // second Ctrl-C, the app is stuck with interrupts off
+    }
+    stop_requested = TRUE;
+}
+
+#ifdef SIM_TESTING
+/* host check of the simulator with the lib drivers, no app or MAVLink needed */
+#include "SerialM32.h"
+#include "System_timer.h"
+#include "ICM_20948.h"
+#include "AS5047D.h"
+#include "RC_RX.h"
+#include "RC_servo.h"
+#include "NEO_M8N.h"
+#include "EEPROM2.h"
+
+static char usb_text[4096];
+static int usb_len = 0;
+static int failures = 0;
+
+static void capture_usb(int uart, uint8_t c) {
+    if (usb_len < (int) sizeof (usb_text) - 1) {
+        usb_text[usb_len++] = (char) c;
+    }
+}
+
+static void check(int pass, const char *name, double value) {
+    fprintf(stderr, "%s %-40s %.4f\n", pass ? "PASS" : "FAIL", name, value);
+    failures += pass ? 0 : 1;
+}
+
+/* waits in virtual time for a flag, FALSE on timeout */
+static int wait_for(int (*ready)(void), uint32_t timeout_ms) {
+    uint32_t start = Sys_timer_get_msec();
+    while (!ready()) {
+        if (Sys_timer_get_msec() - start > timeout_ms) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/* USB telemetry bench: the frames sent and the bytes seen on the wire */
+#define BENCH_LENGTH 8192
+static uint8_t bench_sent[BENCH_LENGTH];
+static uint8_t bench_wire[BENCH_LENGTH];
+static int bench_sent_len = 0;
+static int bench_wire_len = 0;
+static uint32_t bench_wire_total = 0; // bytes seen, also past BENCH_LENGTH
+static uint64_t bench_cpu_ns = 0; // foreground time in the send calls
+static uint32_t bench_done = 0; // bytes reported by the TX done callback
+
+static void capture_bench(int uart, uint8_t c) {
+    bench_wire_total++;
+    if (bench_wire_len < BENCH_LENGTH) {
+        bench_wire[bench_wire_len++] = c;
+    }
+}
+
+static void bench_tx_done(uint16_t length) {
+    bench_done += length;
+}
+
+static uint64_t isr_total_ns(void) {
+    uint64_t ns = 0;
+    int v;
+    for (v = 0; v < SIM_NUM_VECTORS; v++) {
+        ns += sim_stats.isr_ns[v];
+    }
+    return ns;
+}
+
+/* sends a frame like the GNC app's mavprint(), recording the CPU time spent,
+ * returns the Serial_write() result */
+static int8_t bench_frame(uint16_t length, uint8_t seq) {
+    uint8_t frame[300];
+    uint64_t start = sim_now;
+    uint64_t isr = isr_total_ns();
+    uint16_t i;
+    int8_t result;
+
+    for (i = 0; i < length; i++) {
+        frame[i] = (uint8_t) (seq * 31 + i);
+    }
+    result = Serial_write(frame, length);
+    bench_cpu_ns += (sim_now - start) - (isr_total_ns() - isr);
+    if (result == SUCCESS && bench_sent_len + length <= BENCH_LENGTH) {
+        memcpy(&bench_sent[bench_sent_len], frame, length);
+        bench_sent_len += length;
+    }
+    return result;
+}
+
+/* bytes/sec the USB port carries for 200 msec of 250 byte bulk frames
+ * written whenever they fit */
+static double bench_throughput(void) {
+    uint64_t virt_start = sim_now;
+    uint32_t wire_start = bench_wire_total;
+    uint32_t start = Sys_timer_get_msec();
+
+    while (Sys_timer_get_msec() - start < 200) {
+        if (Serial_tx_space(SERIAL_TX_BULK) >= 250) {
+            bench_frame(250, 12);
+        }
+    }
+    return (bench_wire_total - wire_start) / ((sim_now - virt_start) * 1e-9);
+}
+
+/* printf() between the frames, it goes out in call order */
+static void bench_text(int line) {
+    int length = sprintf((char *) &bench_sent[bench_sent_len], "line %d\r\n", line);
+    printf("line %d\r\n", line);
+    bench_sent_len += length;
+}
+
+static int tx_idle(void) {
+    return Serial_tx_idle();
+}
+
+static int imu_ready(void) {
+    return IMU_is_data_ready();
+}
+
+static int enc_ready(void) {
+    return Encoder_is_data_ready();
+}
+
+static int rc_ready(void) {
+    return RCRX_new_cmd_avail();
+}
+
+static int gps_ready(void) {
+    if (GPS_is_msg_avail()) {
+        GPS_parse_stream();
+    }
+    return GPS_is_data_avail();
+}
+
+int sim_app_main(void) {
+    struct IMU_out imu;
+    encoder_t enc[NUM_ENCODERS];
+    RCRX_channel_buffer channels[CHANNELS];
+    struct GPS_data gps;
+    uint8_t out[32];
+    uint8_t in[32];
+    uint8_t *frame;
+    uint32_t start;
+    uint64_t virt_start;
+    uint64_t uart_ns;
+    uint32_t samples;
+    uint32_t errors;
+    uint8_t rx_sent[4096];
+    uint8_t rx_got[4096];
+    double low_rate;
+    double high_rate;
+    double real;
+    double mag;
+    int i;
+
+    Board_init();
+    Serial_init();
+    Sys_timer_init();
+    Sim_uart_connect(SIM_USB_UART, capture_usb);
+    printf("sim test\r\n");
+    start = Sys_timer_get_msec();
+    while (Sys_timer_get_msec() - start < 20) {
+        ;
+    }
+    check(strstr(usb_text, "sim test") != NULL, "printf out UART1", usb_len);
+
+    /* virtual clock */
+    virt_start = sim_now;
+    start = Sys_timer_get_msec();
+    while (Sys_timer_get_msec() - start < 500) {
+        ;
+    }
+    check(fabs((sim_now - virt_start) * 1e-6 - 500.0) < 2.0, "Sys_timer msec vs virtual", (sim_now - virt_start) * 1e-6);
+
+    /* IMU, polled then on data ready */
+    check(IMU_init(IMU_SPI_MODE) == SUCCESS, "IMU_init WHO_AM_I", 0);
+    start = Sys_timer_get_msec();
+    while (Sys_timer_get_msec() - start < 10) { // first samples after wake up
+        ;
+    }
+    IMU_get_raw_data(&imu); // the RX flags of the polled init run the SPI ISR once
+    IMU_start_data_acq();
+    check(wait_for(imu_ready, 10), "IMU SPI read", 0);
+    IMU_get_scaled_data(&imu);
+    check(fabs(imu.acc.z - 1.0) < 0.02, "IMU acc z [g]", imu.acc.z);
+    mag = sqrt(imu.mag.x * imu.mag.x + imu.mag.y * imu.mag.y + imu.mag.z * imu.mag.z);
+    check(fabs(mag - 48.0) < 2.0, "IMU mag field [uT]", mag);
+    IMU_enable_drdy(8);
+    samples = 0;
+    start = Sys_timer_get_msec();
+    while (Sys_timer_get_msec() - start < 1000) {
+        if (IMU_is_data_ready()) {
+            IMU_get_raw_data(&imu);
+            samples++;
+        }
+    }
+    check(abs((int) samples - 125) <= 2, "IMU data ready rate [Hz]", samples);
+    check(IMU_get_drdy_overruns() == 0, "IMU data ready overruns", IMU_get_drdy_overruns());
+
+    /* encoders, RC servos driving the rover */
+    Encoder_init();
+    for (i = 0; i < 2; i++) { // the encoders answer the previous command
+        Encoder_start_data_acq();
+        wait_for(enc_ready, 10);
+        Encoder_get_data(enc);
+    }
+    Encoder_start_data_acq();
+    check(wait_for(enc_ready, 10), "encoder read", 0);
+    Encoder_get_data(enc);
+    check(abs(enc[HEADING].next_theta - 1805) <= 1, "steering encoder at center", enc[HEADING].next_theta);
+    RC_servo_init(ESC_BIDIRECTIONAL_TYPE, SERVO_PWM_1);
+    RC_servo_init(ESC_BIDIRECTIONAL_TYPE, SERVO_PWM_2);
+    RC_servo_init(RC_SERVO_TYPE, SERVO_PWM_3);
+    RC_servo_set_pulse(1750, SERVO_PWM_1);
+    RC_servo_set_pulse(1750, SERVO_PWM_2);
+    start = Sys_timer_get_msec();
+    while (Sys_timer_get_msec() - start < 100) {
+        ;
+    }
+    check(fabs(Sim_oc_pulse_us(2) - 1750) < 20, "OC2 pulse [usec]", Sim_oc_pulse_us(2));
+    Encoder_start_data_acq();
+    wait_for(enc_ready, 10);
+    Encoder_get_data(enc);
+    start = Sys_timer_get_msec();
+    while (Sys_timer_get_msec() - start < 100) {
+        ;
+    }
+    Encoder_start_data_acq();
+    wait_for(enc_ready, 10);
+    Encoder_get_data(enc);
+    check(enc[RIGHT_MOTOR].next_theta != enc[RIGHT_MOTOR].last_theta, "wheel turning", enc[RIGHT_MOTOR].next_theta - enc[RIGHT_MOTOR].last_theta);
+    RC_servo_set_pulse(RC_SERVO_CENTER_PULSE, SERVO_PWM_1);
+    RC_servo_set_pulse(RC_SERVO_CENTER_PULSE, SERVO_PWM_2);
+
+    /* RC receiver */
+    RCRX_init();
+    check(wait_for(rc_ready, 50), "SBUS frame", 0);
+    RCRX_get_cmd(channels);
+    check(channels[5] == RC_RX_MIN_COUNTS, "SBUS mode switch manual", channels[5]);
+    check(channels[4] == (channels[0] >> 2) + (channels[1] >> 2) + (channels[2] >> 2) + (channels[3] >> 2),
+            "SBUS hash", channels[4]);
+
+    /* GPS */
+    GPS_init();
+    check(wait_for(gps_ready, 250), "GPS RMC", 0);
+    GPS_get_data(&gps);
+    check(fabs(gps.lat - 36.9604) < 0.001, "GPS latitude", gps.lat);
+    check(fabs(gps.lon + 122.0329) < 0.001, "GPS longitude", gps.lon);
+
+    /* EEPROM roundtrip with the write cycle */
+    EEPROM_init();
+    for (i = 0; i < 16; i++) {
+        out[i] = (uint8_t) (i * 7 + 3);
+    }
+    EEPROM_write_byte_array(out, 16, 3, 8);
+    memset(in, 0, sizeof (in));
+    EEPROM_read_byte_array(in, 16, 3, 8);
+    check(memcmp(in, out, 16) == 0, "EEPROM roundtrip", 0);
+
+    /* USB telemetry CPU cost, the GNC publish set for one second: every 50 msec
+     * HIGHRES_IMU, three RAW_RPM, ATTITUDE_QUATERNION and LOCAL_POSITION_NED,
+     * GPS_RAW_INT every 100 msec and HEARTBEAT once, frame sizes with MAVLink 2
+     * framing */
+    Sim_uart_connect(SIM_USB_UART, capture_bench);
+    Serial_set_tx_done(bench_tx_done);
+    uart_ns = sim_stats.isr_ns[_UART_1_VECTOR] + sim_stats.isr_ns[_DMA_0_VECTOR];
+    bench_frame(21, 0);
+    for (i = 0; i < 20; i++) {
+        start = Sys_timer_get_msec();
+        bench_frame(75, 1);
+        bench_frame(17, 2);
+        bench_frame(17, 3);
+        bench_frame(17, 4);
+        bench_frame(44, 5);
+        bench_frame(40, 6);
+        if ((i & 1) == 0) {
+            bench_frame(52, 7);
+        }
+        while (Sys_timer_get_msec() - start < 50) {
+            ;
+        }
+    }
+    uart_ns = sim_stats.isr_ns[_UART_1_VECTOR] + sim_stats.isr_ns[_DMA_0_VECTOR] - uart_ns;
+    check((bench_cpu_ns + uart_ns) * 1e-3 < 200.0, "USB TX CPU [usec/sec]", (bench_cpu_ns + uart_ns) * 1e-3);
+    check(bench_done == bench_sent_len, "USB TX done callback [bytes]", bench_done);
+    /* text between frames and a burst past both blocks, whole frames are
+     * refused once the block being filled has no room */
+    samples = 0;
+    for (i = 0; i < 6; i++) {
+        samples += bench_frame(280, 8) == ERROR ? 1 : 0;
+        bench_text(i);
+    }
+    check(samples > 0, "USB frames refused when full", samples);
+    check(Serial_write(in, SERIAL_TX_BLOCK_LENGTH + 1) == ERROR, "USB write too long refused", 0);
+    /* bulk frames fill the block up to the headroom, an urgent frame still
+     * goes in after them, each refusal counted in its class */
+    samples = Serial_tx_dropped(SERIAL_TX_BULK);
+    while (bench_frame(64, 9) == SUCCESS) {
+        ;
+    }
+    check(Serial_tx_dropped(SERIAL_TX_BULK) == samples + 1 && Serial_tx_space(SERIAL_TX_BULK) < 64,
+            "USB bulk frame refused in headroom", Serial_tx_space(SERIAL_TX_BULK));
+    samples = Serial_tx_space(SERIAL_TX_URGENT);
+    frame = Serial_reserve(64, SERIAL_TX_URGENT);
+    check(frame != NULL && Serial_tx_dropped(SERIAL_TX_URGENT) == 0, "USB urgent frame in headroom", samples);
+    if (frame != NULL) {
+        memset(frame, 0x5A, 64);
+        Serial_commit(64);
+        memset(&bench_sent[bench_sent_len], 0x5A, 64);
+        bench_sent_len += 64;
+    }
+    start = Sys_timer_get_msec();
+    while (Sys_timer_get_msec() - start < 200) {
+        ;
+    }
+    check(Serial_tx_idle() && bench_wire_len == bench_sent_len && memcmp(bench_wire, bench_sent, bench_sent_len) == 0,
+            "USB frames and printf in order", bench_wire_len);
+    Serial_set_tx_done(NULL);
+
+    /* high speed: a rate the BRG cannot make is refused, a switch waits for
+     * the bytes queued at the old rate and the frames written meanwhile follow
+     * at the new one; then bulk throughput and a receive burst at the new rate */
+    check(Serial_set_baud(975000, SERIAL_FLOW_NONE) == ERROR, "USB 975000 baud refused", Serial_get_baud());
+    low_rate = bench_throughput();
+    start = Sys_timer_get_msec();
+    while (Sys_timer_get_msec() - start < 300) { // both blocks and the FIFO
+        ;
+    }
+    bench_wire_len = bench_sent_len = 0;
+    bench_frame(200, 10);
+    check(Serial_set_baud(921600, SERIAL_FLOW_NONE) == SUCCESS && Serial_get_baud() < 200000,
+            "USB 921600 baud after the queue", Serial_get_baud());
+    bench_frame(200, 11);
+    start = Sys_timer_get_msec();
+    while (Sys_timer_get_msec() - start < 50) {
+        ;
+    }
+    check(Serial_tx_idle() && bench_wire_len == bench_sent_len
+            && memcmp(bench_wire, bench_sent, bench_sent_len) == 0,
+            "USB frames in order across the switch", bench_wire_len);
+    check(fabs(Serial_get_baud() - 921600.0) < 921600.0 * SERIAL_BAUD_TOLERANCE / 100,
+            "USB baud 921600", Serial_get_baud());
+    high_rate = bench_throughput();
+    check(high_rate > 7.5 * low_rate, "USB bulk [bytes/sec] at 921600", high_rate);
+    errors = Serial_rx_errors() + Serial_rx_dropped();
+    for (i = 0; i < (int) sizeof (rx_sent); i++) {
+        rx_sent[i] = (uint8_t) (i * 13 + 5);
+    }
+    Sim_uart_feed(SIM_USB_UART, rx_sent, sizeof (rx_sent));
+    samples = 0;
+    start = Sys_timer_get_msec();
+    while (Sys_timer_get_msec() - start < 100) {
+        samples += Serial_read(&rx_got[samples], sizeof (rx_got) - samples);
+    }
+    check(samples == sizeof (rx_sent) && memcmp(rx_got, rx_sent, samples) == 0
+            && Serial_rx_errors() + Serial_rx_dropped() == errors, "USB RX at 921600", samples);
+    Serial_set_baud(SERIAL_BAUD_DEFAULT, SERIAL_FLOW_NONE);
+    wait_for(tx_idle, 500);
+    check(Serial_get_baud() < 200000, "USB back to the default baud", Serial_get_baud());
+
+    /* speed, busy loop on the clock as the apps do */
+    real = Sim_real_time();
+    virt_start = sim_now;
+    start = Sys_timer_get_msec();
+    while (Sys_timer_get_msec() - start < 2000) {
+        if (IMU_is_data_ready()) {
+            IMU_get_raw_data(&imu);
+        }
+    }
+    real = Sim_real_time() - real;
+    check(real < 2.0, "virtual / real time", (sim_now - virt_start) * 1e-9 / real);
+
+    fprintf(stderr, "%s\n", failures ? "FAILED" : "ALL PASSED");
+    exit(failures ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+#endif
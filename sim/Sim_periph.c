@@ -0,0 +1,1105 @@
+/*
+ * File:   Sim_periph.c
+ * Brief: PIC32MX peripheral models for the simulator: type B timers 2 to 5,
+ * output compare, UART 1 to 6 with 8 deep FIFOs paced at the character time,
+ * SPI 1 and 2 in standard buffer master mode, I2C 1 and 2 master and DMA
+ * channels 0 to 3 started by a UART TX interrupt request.  Data
+ * registers that are only written (UxTXREG, I2CxTRN) read back
+ * SIM_WRITE_ONLY so any store is seen by the commit, SPIxBUF hands out the
+ * received word when the buffer is full and SIM_WRITE_ONLY otherwise.  The
+ * CLR, SET and INV registers read 0 and are applied to their base register.
+ * Created on 10/16/2026
+ * Modified on 10/16/2026
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+#include <string.h>
+#include <xc.h>
+#include "Board.h"
+#include "Sim.h"
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#define NUM_TIMERS 4 // timers 2 to 5
+#define UART_FIFO 8
+#define UART_WIRE 65536 // bytes waiting on an RX pin, power of 2
+#define NUM_SPI 2
+#define NUM_I2C 2
+
+/* UxSTA bits */
+#define URXDA (1u << 0)
+#define OERR (1u << 1)
+#define TRMT (1u << 8)
+#define UTXBF (1u << 9)
+#define UXSTA_HW (URXDA | TRMT | UTXBF | (1u << 2) | (1u << 3) | (1u << 4))
+
+/* SPIxSTAT bits */
+#define SPIRBF (1u << 0)
+#define SPITBF (1u << 1)
+#define SPITBE (1u << 3)
+#define SPIRBE (1u << 5)
+#define SPIROV (1u << 6)
+#define SRMT (1u << 7)
+#define SPIBUSY (1u << 11)
+#define SPISTAT_HW (SPIRBF | SPITBF | SPITBE | SPIRBE | SRMT | SPIBUSY)
+
+/* I2CxCON and I2CxSTAT bits */
+#define SEN (1u << 0)
+#define RSEN (1u << 1)
+#define PEN (1u << 2)
+#define RCEN (1u << 3)
+#define ACKEN (1u << 4)
+#define I2C_OPS (SEN | RSEN | PEN | RCEN | ACKEN)
+#define I2C_SEND (1u << 8) // pseudo operation, I2CxTRN byte being sent
+#define TBF (1u << 0)
+#define RBF (1u << 1)
+#define I2C_S (1u << 3)
+#define I2C_P (1u << 4)
+#define TRSTAT (1u << 14)
+#define ACKSTAT (1u << 15)
+#define I2CSTAT_HW (TBF | RBF | I2C_S | I2C_P | TRSTAT | ACKSTAT)
+
+/* DMA registers of channel n, offsets follow SIM_DMA_CHANNEL() */
+#define DCH(n, r) (SIM_DCH0CON + (n) * SIM_DMA_REGS + (r))
+#define DMA_ON (1u << 15)
+#define CHAEN (1u << 4)
+#define CHEN (1u << 7)
+#define CHBUSY (1u << 15)
+#define SIRQEN (1u << 4)
+#define CABORT (1u << 6)
+#define CFORCE (1u << 7)
+#define CHTAIF (1u << 1)
+#define CHCCIF (1u << 2)
+#define CHBCIF (1u << 3)
+#define CHSDIF (1u << 7)
+
+/*******************************************************************************
+ * PRIVATE TYPEDEFS                                                            *
+ ******************************************************************************/
+typedef struct {
+    int con, tmr, pr; // register indices
+    uint32_t if_mask; // IFS0 flag
+    uint64_t base; // virtual time of count 0
+    uint64_t periods; // rollovers since base
+    uint64_t next; // next rollover
+    uint64_t tick_ps;
+} sim_timer_t;
+
+typedef struct {
+    int mode, sta, txreg, rxreg, brg;
+    int ifs;
+    uint32_t e_mask, rx_mask, tx_mask;
+    uint8_t txf[UART_FIFO];
+    int tx_head, tx_count;
+    int shifting;
+    uint8_t shift;
+    uint64_t shift_done;
+    uint8_t rxf[UART_FIFO];
+    int rx_head, rx_count;
+    uint8_t wire[UART_WIRE];
+    uint32_t wire_head, wire_tail;
+    uint64_t wire_next; // arrival of the byte at wire_tail
+    uint64_t wire_last; // arrival of the last byte delivered
+    sim_tx_fn sink;
+} sim_uart_t;
+
+typedef struct {
+    int con, stat, buf, statclr;
+    int ifs;
+    uint32_t rx_mask;
+    int busy;
+    uint32_t tx;
+    uint64_t done;
+    int tx_pending;
+    uint32_t tx_next;
+    uint32_t rx;
+    int rx_full;
+} sim_spi_t;
+
+typedef struct {
+    int con, stat, brg, trn, rcv;
+    int ifs;
+    uint32_t m_mask;
+    uint32_t op; // I2C_OPS bit or I2C_SEND
+    uint64_t done;
+    int address_next; // the next byte after a start is an address
+    uint8_t trn_val;
+    uint8_t rcv_val;
+} sim_i2c_t;
+
+/*******************************************************************************
+ * PRIVATE VARIABLES                                                           *
+ ******************************************************************************/
+static sim_timer_t timers[NUM_TIMERS] = {
+    {SIM_T2CON, SIM_TMR2, SIM_PR2, 1u << 8},
+    {SIM_T3CON, SIM_TMR3, SIM_PR3, 1u << 12},
+    {SIM_T4CON, SIM_TMR4, SIM_PR4, 1u << 16},
+    {SIM_T5CON, SIM_TMR5, SIM_PR5, 1u << 20},
+};
+static const uint16_t prescale[8] = {1, 2, 4, 8, 16, 32, 64, 256};
+
+static sim_uart_t uarts[SIM_NUM_UARTS + 1] = {
+    [1] = {SIM_U1MODE, SIM_U1STA, SIM_U1TXREG, SIM_U1RXREG, SIM_U1BRG,
+        SIM_IFS0, 1u << 26, 1u << 27, 1u << 28},
+    [2] = {SIM_U2MODE, SIM_U2STA, SIM_U2TXREG, SIM_U2RXREG, SIM_U2BRG,
+        SIM_IFS1, 1u << 8, 1u << 9, 1u << 10},
+    [3] = {SIM_U3MODE, SIM_U3STA, SIM_U3TXREG, SIM_U3RXREG, SIM_U3BRG,
+        SIM_IFS1, 1u << 5, 1u << 6, 1u << 7},
+    [4] = {SIM_U4MODE, SIM_U4STA, SIM_U4TXREG, SIM_U4RXREG, SIM_U4BRG,
+        SIM_IFS2, 1u << 3, 1u << 4, 1u << 5},
+    [5] = {SIM_U5MODE, SIM_U5STA, SIM_U5TXREG, SIM_U5RXREG, SIM_U5BRG,
+        SIM_IFS2, 1u << 9, 1u << 10, 1u << 11},
+    [6] = {SIM_U6MODE, SIM_U6STA, SIM_U6TXREG, SIM_U6RXREG, SIM_U6BRG,
+        SIM_IFS2, 1u << 6, 1u << 7, 1u << 8},
+};
+
+static sim_spi_t spis[NUM_SPI + 1] = {
+    [1] = {SIM_SPI1CON, SIM_SPI1STAT, SIM_SPI1BUF, SIM_SPI1STATCLR, SIM_IFS0, 1u << 24},
+    [2] = {SIM_SPI2CON, SIM_SPI2STAT, SIM_SPI2BUF, SIM_SPI2STATCLR, SIM_IFS1, 1u << 6},
+};
+
+static sim_i2c_t i2cs[NUM_I2C + 1] = {
+    [1] = {SIM_I2C1CON, SIM_I2C1STAT, SIM_I2C1BRG, SIM_I2C1TRN, SIM_I2C1RCV, SIM_IFS0, 1u << 31},
+    [2] = {SIM_I2C2CON, SIM_I2C2STAT, SIM_I2C2BRG, SIM_I2C2TRN, SIM_I2C2RCV, SIM_IFS1, 1u << 13},
+};
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                 *
+ ******************************************************************************/
+static uint64_t Sim_timer_run(sim_timer_t *t);
+static uint32_t Sim_timer_count(sim_timer_t *t, uint32_t pr);
+static void Sim_timer_rebase(sim_timer_t *t, uint32_t count);
+static uint64_t Sim_uart_run(int n);
+static void Sim_uart_status(sim_uart_t *u);
+static void Sim_uart_reset(sim_uart_t *u);
+static uint64_t Sim_spi_run(int n);
+static void Sim_spi_start(int n, uint32_t tx);
+static void Sim_spi_status(sim_spi_t *s);
+static uint64_t Sim_i2c_run(int n);
+static uint64_t Sim_i2c_bit_ns(sim_i2c_t *i);
+static int Sim_find(int reg, int *kind);
+static int Sim_uart_tx_level(sim_uart_t *u);
+static void Sim_dma_run(void);
+static int Sim_dma_cell(int n);
+
+enum {
+    KIND_NONE, KIND_TIMER, KIND_UART, KIND_SPI, KIND_I2C, KIND_DMA
+};
+
+enum {
+    DMA_CON, DMA_ECON, DMA_INT, DMA_SSA, DMA_DSA, DMA_SSIZ, DMA_DSIZ,
+    DMA_SPTR, DMA_DPTR, DMA_CSIZ, DMA_CPTR
+};
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function Sim_periph_init(void)
+ * @brief reset values of the peripheral registers
+ * @author Aaron Hunter
+ */
+void Sim_periph_init(void) {
+    int n;
+    for (n = 0; n < NUM_TIMERS; n++) {
+        sim_regs[timers[n].pr] = 0xFFFF;
+        timers[n].next = SIM_NEVER;
+    }
+    for (n = 1; n <= SIM_NUM_UARTS; n++) {
+        Sim_uart_reset(&uarts[n]);
+        uarts[n].wire_head = uarts[n].wire_tail = 0;
+        uarts[n].wire_last = 0;
+    }
+    for (n = 1; n <= NUM_SPI; n++) {
+        Sim_spi_status(&spis[n]);
+    }
+    sim_regs[SIM_TRISA] = sim_regs[SIM_TRISB] = sim_regs[SIM_TRISD] = 0xFFFF;
+    sim_regs[SIM_TRISE] = sim_regs[SIM_TRISF] = sim_regs[SIM_TRISG] = 0xFFFF;
+    sim_regs[SIM_DDPCON] = 1u << 3; // JTAGEN
+}
+
+/**
+ * @Function Sim_periph_run(void)
+ * @brief runs all peripheral, device and host events due by sim_now and sets
+ * sim_next_event
+ * @author Aaron Hunter
+ */
+void Sim_periph_run(void) {
+    uint64_t next = SIM_NEVER;
+    uint64_t t;
+    int n;
+
+    for (n = 0; n < NUM_TIMERS; n++) {
+        t = Sim_timer_run(&timers[n]);
+        next = t < next ? t : next;
+    }
+    for (n = 1; n <= SIM_NUM_UARTS; n++) {
+        t = Sim_uart_run(n);
+        next = t < next ? t : next;
+    }
+    for (n = 1; n <= NUM_SPI; n++) {
+        t = Sim_spi_run(n);
+        next = t < next ? t : next;
+    }
+    for (n = 1; n <= NUM_I2C; n++) {
+        t = Sim_i2c_run(n);
+        next = t < next ? t : next;
+    }
+    Sim_dma_run(); // refills the UART FIFOs that shifted out a byte
+    t = Sim_dev_run();
+    next = t < next ? t : next;
+    t = Sim_host_run();
+    next = t < next ? t : next;
+    /* a device feeding a UART may have scheduled an earlier byte */
+    for (n = 1; n <= SIM_NUM_UARTS; n++) {
+        if (uarts[n].wire_head != uarts[n].wire_tail && uarts[n].wire_next < next) {
+            next = uarts[n].wire_next;
+        }
+    }
+    sim_next_event = next;
+}
+
+/**
+ * @Function Sim_periph_read(int reg)
+ * @param reg, register about to be accessed
+ * @brief loads the register slot, e.g. pops the UART receive FIFO
+ * @author Aaron Hunter
+ */
+void Sim_periph_read(int reg) {
+    int kind;
+    int n = Sim_find(reg, &kind);
+    sim_uart_t *u;
+    sim_spi_t *s;
+
+    switch (reg) {
+        case SIM_IFS0CLR: case SIM_IFS1CLR: case SIM_IFS2CLR:
+        case SIM_IFS0SET: case SIM_IFS1SET: case SIM_IFS2SET:
+        case SIM_IEC0CLR: case SIM_IEC1CLR: case SIM_IEC2CLR:
+        case SIM_IEC0SET: case SIM_IEC1SET: case SIM_IEC2SET:
+        case SIM_LATACLR: case SIM_LATASET: case SIM_LATAINV:
+        case SIM_LATDCLR: case SIM_LATDSET: case SIM_LATDINV:
+        case SIM_LATECLR: case SIM_LATESET: case SIM_LATEINV:
+        case SIM_SPI1STATCLR: case SIM_SPI2STATCLR:
+            sim_regs[reg] = 0;
+            return;
+        default:
+            break;
+    }
+    switch (kind) {
+        case KIND_TIMER:
+            if (reg == timers[n].tmr && (sim_regs[timers[n].con] & (1u << 15))) {
+                sim_regs[reg] = Sim_timer_count(&timers[n], sim_regs[timers[n].pr]);
+            }
+            break;
+        case KIND_UART:
+            u = &uarts[n];
+            if (reg == u->txreg) {
+                sim_regs[reg] = SIM_WRITE_ONLY;
+            } else if (reg == u->rxreg && u->rx_count > 0) {
+                sim_regs[reg] = u->rxf[u->rx_head];
+                u->rx_head = (u->rx_head + 1) % UART_FIFO;
+                u->rx_count--;
+                sim_stats.uart_rx[n]++;
+                Sim_uart_status(u);
+                Sim_irq_changed();
+            }
+            break;
+        case KIND_SPI:
+            s = &spis[n];
+            if (reg == s->buf) {
+                if (s->rx_full) {
+                    sim_regs[reg] = s->rx;
+                    s->rx_full = FALSE;
+                    Sim_spi_status(s);
+                } else {
+                    sim_regs[reg] = SIM_WRITE_ONLY;
+                }
+            }
+            break;
+        case KIND_I2C:
+            if (reg == i2cs[n].trn) {
+                sim_regs[reg] = SIM_WRITE_ONLY;
+            } else if (reg == i2cs[n].rcv) {
+                sim_regs[reg] = i2cs[n].rcv_val;
+                sim_regs[i2cs[n].stat] &= ~RBF;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @Function Sim_periph_write(int reg, uint32_t old, uint32_t value)
+ * @param reg, register the app wrote
+ * @param old, value before the write
+ * @param value, value written
+ * @brief hardware side effects of a register write
+ * @author Aaron Hunter
+ */
+void Sim_periph_write(int reg, uint32_t old, uint32_t value) {
+    int kind;
+    int n;
+    uint32_t count;
+    uint32_t rise;
+    sim_timer_t *t;
+    sim_uart_t *u;
+    sim_spi_t *s;
+    sim_i2c_t *i;
+
+    switch (reg) {
+        case SIM_IFS0CLR: case SIM_IFS1CLR: case SIM_IFS2CLR:
+            sim_regs[SIM_IFS0 + reg - SIM_IFS0CLR] &= ~value;
+            Sim_irq_changed();
+            return;
+        case SIM_IFS0SET: case SIM_IFS1SET: case SIM_IFS2SET:
+            sim_regs[SIM_IFS0 + reg - SIM_IFS0SET] |= value;
+            Sim_irq_changed();
+            return;
+        case SIM_IEC0CLR: case SIM_IEC1CLR: case SIM_IEC2CLR:
+            sim_regs[SIM_IEC0 + reg - SIM_IEC0CLR] &= ~value;
+            Sim_irq_changed();
+            return;
+        case SIM_IEC0SET: case SIM_IEC1SET: case SIM_IEC2SET:
+            sim_regs[SIM_IEC0 + reg - SIM_IEC0SET] |= value;
+            Sim_irq_changed();
+            return;
+        case SIM_IFS0: case SIM_IFS1: case SIM_IFS2:
+        case SIM_IEC0: case SIM_IEC1: case SIM_IEC2:
+        case SIM_IPC0: case SIM_IPC1: case SIM_IPC2: case SIM_IPC3:
+        case SIM_IPC4: case SIM_IPC5: case SIM_IPC6: case SIM_IPC7:
+        case SIM_IPC8: case SIM_IPC9: case SIM_IPC10: case SIM_IPC11:
+        case SIM_IPC12: case SIM_INTCON:
+            Sim_irq_changed();
+            return;
+        case SIM_DMACON:
+            Sim_dma_run();
+            return;
+        case SIM_LATACLR: case SIM_LATASET: case SIM_LATAINV:
+        case SIM_LATDCLR: case SIM_LATDSET: case SIM_LATDINV:
+        case SIM_LATECLR: case SIM_LATESET: case SIM_LATEINV:
+        {
+            static const int base[] = {SIM_LATA, SIM_LATA, SIM_LATA,
+                SIM_LATD, SIM_LATD, SIM_LATD, SIM_LATE, SIM_LATE, SIM_LATE};
+            int op = (reg - SIM_LATACLR) % 3;
+            int lat = base[reg - SIM_LATACLR];
+            uint32_t prev = sim_regs[lat];
+            if (op == 0) {
+                sim_regs[lat] &= ~value;
+            } else if (op == 1) {
+                sim_regs[lat] |= value;
+            } else {
+                sim_regs[lat] ^= value;
+            }
+            Sim_dev_pins(lat, prev, sim_regs[lat]);
+            return;
+        }
+        case SIM_LATA: case SIM_LATB: case SIM_LATD: case SIM_LATE:
+        case SIM_LATF: case SIM_LATG:
+            Sim_dev_pins(reg, old, value);
+            return;
+        case SIM_SPI1STATCLR: case SIM_SPI2STATCLR:
+            n = reg == SIM_SPI1STATCLR ? 1 : 2;
+            sim_regs[spis[n].stat] &= ~value;
+            Sim_spi_status(&spis[n]);
+            return;
+        default:
+            break;
+    }
+
+    n = Sim_find(reg, &kind);
+    switch (kind) {
+        case KIND_TIMER:
+            t = &timers[n];
+            if (reg == t->con) {
+                if ((value & (1u << 15)) && !(old & (1u << 15))) {
+                    Sim_timer_rebase(t, sim_regs[t->tmr]);
+                } else if (old & (1u << 15)) {
+                    count = Sim_timer_count(t, sim_regs[t->pr]);
+                    if (value & (1u << 15)) { // prescaler change keeps the count
+                        Sim_timer_rebase(t, count);
+                    } else { // an off timer holds its count
+                        sim_regs[t->tmr] = count;
+                        t->next = SIM_NEVER;
+                    }
+                }
+            } else if (sim_regs[t->con] & (1u << 15)) {
+                if (reg == t->tmr) {
+                    Sim_timer_rebase(t, value);
+                } else { // period change keeps the count
+                    Sim_timer_rebase(t, Sim_timer_count(t, old));
+                }
+            }
+            break;
+        case KIND_UART:
+            u = &uarts[n];
+            if (reg == u->mode) {
+                if (!(value & (1u << 15))) {
+                    Sim_uart_reset(u);
+                }
+            } else if (reg == u->sta) {
+                /* OERR is the only status bit software can clear, that also
+                 * resets the receive FIFO */
+                if ((old & OERR) && !(value & OERR)) {
+                    u->rx_count = 0;
+                }
+                sim_regs[reg] = (value & ~UXSTA_HW & ~OERR) | (old & OERR & value);
+                Sim_uart_status(u);
+                Sim_dma_run(); // UTXEN or UTXISEL may start a channel
+            } else if (reg == u->txreg) {
+                if ((sim_regs[u->mode] & (1u << 15)) && (sim_regs[u->sta] & (1u << 10))) {
+                    if (!u->shifting) {
+                        u->shifting = TRUE;
+                        u->shift = (uint8_t) value;
+                        u->shift_done = sim_now + Sim_uart_char_ns(n);
+                        Sim_schedule(u->shift_done);
+                    } else if (u->tx_count < UART_FIFO) {
+                        u->txf[(u->tx_head + u->tx_count) % UART_FIFO] = (uint8_t) value;
+                        u->tx_count++;
+                    }
+                }
+                Sim_uart_status(u);
+            }
+            Sim_irq_changed();
+            break;
+        case KIND_SPI:
+            s = &spis[n];
+            if (reg == s->con) {
+                if (!(value & (1u << 15))) {
+                    s->busy = FALSE;
+                    s->tx_pending = FALSE;
+                    s->rx_full = FALSE;
+                    sim_regs[s->stat] &= ~SPIROV;
+                }
+                Sim_spi_status(s);
+            } else if (reg == s->stat) {
+                sim_regs[reg] = (value & ~SPISTAT_HW) | (old & SPISTAT_HW);
+                Sim_spi_status(s);
+            } else if (reg == s->buf) {
+                if (sim_regs[s->con] & (1u << 15)) {
+                    if (!s->busy) {
+                        Sim_spi_start(n, value);
+                    } else {
+                        s->tx_pending = TRUE;
+                        s->tx_next = value;
+                    }
+                }
+                Sim_spi_status(s);
+            }
+            break;
+        case KIND_DMA:
+            switch ((reg - SIM_DCH0CON) % SIM_DMA_REGS) {
+                case DMA_CON:
+                    sim_regs[reg] = (value & ~CHBUSY) | (old & CHBUSY);
+                    break;
+                case DMA_ECON:
+                    if (value & CABORT) { // abort resets the pointers
+                        sim_regs[DCH(n, DMA_CON)] &= ~CHEN;
+                        sim_regs[DCH(n, DMA_SPTR)] = sim_regs[DCH(n, DMA_DPTR)] = 0;
+                        sim_regs[DCH(n, DMA_CPTR)] = 0;
+                        sim_regs[reg] &= ~CABORT;
+                    }
+                    break;
+                case DMA_SSA: case DMA_DSA: case DMA_SSIZ: case DMA_DSIZ:
+                    sim_regs[DCH(n, DMA_SPTR)] = sim_regs[DCH(n, DMA_DPTR)] = 0;
+                    break;
+                case DMA_SPTR: case DMA_DPTR: case DMA_CPTR:
+                    sim_regs[reg] = old; // read only
+                    break;
+                default:
+                    break;
+            }
+            Sim_dma_run();
+            break;
+        case KIND_I2C:
+            i = &i2cs[n];
+            if (reg == i->con) {
+                rise = value & ~old & I2C_OPS;
+                if (!(value & (1u << 15))) {
+                    i->op = 0;
+                    sim_regs[i->con] &= ~I2C_OPS;
+                } else if (rise && i->op == 0) {
+                    i->op = rise & -rise; // one operation at a time
+                    i->done = sim_now + (i->op == RCEN ? 8 : 1) * Sim_i2c_bit_ns(i);
+                    Sim_schedule(i->done);
+                }
+            } else if (reg == i->stat) {
+                sim_regs[reg] = (value & ~I2CSTAT_HW) | (old & I2CSTAT_HW);
+            } else if (reg == i->trn) {
+                if ((sim_regs[i->con] & (1u << 15)) && i->op == 0) {
+                    i->op = I2C_SEND;
+                    i->trn_val = (uint8_t) value;
+                    sim_regs[i->stat] |= TBF | TRSTAT;
+                    i->done = sim_now + 9 * Sim_i2c_bit_ns(i);
+                    Sim_schedule(i->done);
+                }
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @Function Sim_periph_levels(void)
+ * @brief sets the level triggered interrupt flags (UART RX and TX) whose
+ * condition holds, the hardware sets them again after the ISR clears them
+ * @author Aaron Hunter
+ */
+void Sim_periph_levels(void) {
+    int n;
+    sim_uart_t *u;
+    uint32_t sta;
+    int rx_level;
+
+    for (n = 1; n <= SIM_NUM_UARTS; n++) {
+        u = &uarts[n];
+        if (!(sim_regs[u->mode] & (1u << 15))) {
+            continue;
+        }
+        sta = sim_regs[u->sta];
+        switch ((sta >> 6) & 0x3) { // URXISEL
+            case 0:
+                rx_level = u->rx_count > 0;
+                break;
+            case 1:
+                rx_level = u->rx_count >= UART_FIFO / 2;
+                break;
+            default:
+                rx_level = u->rx_count >= UART_FIFO * 3 / 4;
+                break;
+        }
+        if (rx_level) {
+            sim_regs[u->ifs] |= u->rx_mask;
+        }
+        if (Sim_uart_tx_level(u)) {
+            sim_regs[u->ifs] |= u->tx_mask;
+        }
+    }
+}
+
+/**
+ * @Function Sim_uart_connect(int uart, sim_tx_fn tx)
+ * @param uart, 1 to 6
+ * @param tx, called with every byte the UART sends, NULL drops them
+ * @author Aaron Hunter
+ */
+void Sim_uart_connect(int uart, sim_tx_fn tx) {
+    uarts[uart].sink = tx;
+}
+
+/**
+ * @Function Sim_uart_feed(int uart, const uint8_t *data, int len)
+ * @param uart, 1 to 6
+ * @param data, bytes arriving on the RX pin, one character time each
+ * @param len, number of bytes
+ * @return number of bytes queued
+ * @author Aaron Hunter
+ */
+int Sim_uart_feed(int uart, const uint8_t *data, int len) {
+    sim_uart_t *u = &uarts[uart];
+    int i;
+    if (u->wire_head == u->wire_tail) {
+        u->wire_next = (u->wire_last > sim_now ? u->wire_last : sim_now) + Sim_uart_char_ns(uart);
+        Sim_schedule(u->wire_next);
+    }
+    for (i = 0; i < len; i++) {
+        if (u->wire_head - u->wire_tail == UART_WIRE) {
+            break;
+        }
+        u->wire[u->wire_head++ & (UART_WIRE - 1)] = data[i];
+    }
+    return i;
+}
+
+/**
+ * @Function Sim_uart_char_ns(int uart)
+ * @param uart, 1 to 6
+ * @return nsec for one character at the configured baud rate and format
+ * @author Aaron Hunter
+ */
+uint64_t Sim_uart_char_ns(int uart) {
+    sim_uart_t *u = &uarts[uart];
+    uint32_t mode = sim_regs[u->mode];
+    uint64_t div = (mode & (1u << 3)) ? 4 : 16; // BRGH
+    uint64_t bits = 1 + 8 + 1; // start, data, stop
+    uint32_t pdsel = (mode >> 1) & 0x3;
+    if (pdsel == 1 || pdsel == 2) {
+        bits++; // parity
+    } else if (pdsel == 3) {
+        bits++; // 9 data bits
+    }
+    if (mode & 1) { // STSEL
+        bits++;
+    }
+    return bits * div * (sim_regs[u->brg] + 1) * SIM_PB_PS / 1000;
+}
+
+/**
+ * @Function Sim_oc_pulse_us(int oc)
+ * @param oc, output compare 1 to 5
+ * @return PWM pulse width in usec, 0 if the output is off
+ * @author Aaron Hunter
+ */
+float Sim_oc_pulse_us(int oc) {
+    static const int con[] = {0, SIM_OC1CON, SIM_OC2CON, SIM_OC3CON, SIM_OC4CON, SIM_OC5CON};
+    static const int rs[] = {0, SIM_OC1RS, SIM_OC2RS, SIM_OC3RS, SIM_OC4RS, SIM_OC5RS};
+    uint32_t c;
+    sim_timer_t *t;
+    if (oc < 1 || oc > SIM_NUM_OC) {
+        return 0;
+    }
+    c = sim_regs[con[oc]];
+    if (!(c & (1u << 15)) || (c & 0x7) < 5) {
+        return 0;
+    }
+    t = (c & (1u << 3)) ? &timers[1] : &timers[0]; // OCTSEL, timer 3 or 2
+    if (!(sim_regs[t->con] & (1u << 15))) {
+        return 0;
+    }
+    return (float) (sim_regs[rs[oc]] & 0xFFFF) * (float) t->tick_ps * 1e-6f;
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/**
+ * @Function Sim_find(int reg, int *kind)
+ * @return index of the peripheral that owns reg, kind set to its type
+ * @author Aaron Hunter
+ */
+static int Sim_find(int reg, int *kind) {
+    *kind = KIND_NONE;
+    if (reg >= SIM_T2CON && reg <= SIM_PR5) {
+        *kind = KIND_TIMER;
+        return (reg - SIM_T2CON) / 3;
+    }
+    if (reg >= SIM_U1MODE && reg <= SIM_U6BRG) {
+        *kind = KIND_UART;
+        return (reg - SIM_U1MODE) / 5 + 1;
+    }
+    if (reg >= SIM_SPI1CON && reg <= SIM_SPI2STATCLR) {
+        *kind = KIND_SPI;
+        return (reg - SIM_SPI1CON) / 5 + 1;
+    }
+    if (reg >= SIM_I2C1CON && reg <= SIM_I2C2RCV) {
+        *kind = KIND_I2C;
+        return (reg - SIM_I2C1CON) / 5 + 1;
+    }
+    if (reg >= SIM_DCH0CON && reg < SIM_DCH0CON + SIM_NUM_DMA * SIM_DMA_REGS) {
+        *kind = KIND_DMA;
+        return (reg - SIM_DCH0CON) / SIM_DMA_REGS;
+    }
+    return 0;
+}
+
+/**
+ * @Function Sim_uart_tx_level(sim_uart_t *u)
+ * @return TRUE while the TX interrupt request condition selected by UTXISEL
+ * holds, the CPU sees it as the TX flag and the DMA as a start event
+ * @author Aaron Hunter
+ */
+static int Sim_uart_tx_level(sim_uart_t *u) {
+    uint32_t sta = sim_regs[u->sta];
+
+    if (!(sim_regs[u->mode] & (1u << 15)) || !(sta & (1u << 10))) { // ON, UTXEN
+        return FALSE;
+    }
+    switch ((sta >> 14) & 0x3) { // UTXISEL
+        case 0:
+            return u->tx_count < UART_FIFO;
+        case 1:
+            return (sta & TRMT) != 0;
+        default:
+            return u->tx_count == 0;
+    }
+}
+
+/**
+ * @Function Sim_dma_run(void)
+ * @brief moves cells on the enabled channels while their start event holds.
+ * Only the UART TX requests are modeled as start events, they are levels so
+ * a channel feeding UxTXREG keeps the FIFO full until its block is done.
+ * Transfers take no CPU time.
+ * @author Aaron Hunter
+ */
+static void Sim_dma_run(void) {
+    int n;
+    int u;
+    int irq;
+    sim_uart_t *start;
+    uint32_t econ;
+    uint32_t flags;
+
+    if (!(sim_regs[SIM_DMACON] & DMA_ON)) {
+        return;
+    }
+    for (n = 0; n < SIM_NUM_DMA; n++) {
+        econ = sim_regs[DCH(n, DMA_ECON)];
+        sim_regs[DCH(n, DMA_ECON)] &= ~CFORCE;
+        if (!(sim_regs[DCH(n, DMA_CON)] & CHEN)) {
+            continue; // a forced transfer of a disabled channel is lost
+        }
+        if (econ & CFORCE) {
+            Sim_dma_cell(n);
+        }
+        if ((econ & SIRQEN) && (sim_regs[DCH(n, DMA_CON)] & CHEN)) {
+            irq = (econ >> 8) & 0xFF; // CHSIRQ
+            start = NULL;
+            for (u = 1; u <= SIM_NUM_UARTS; u++) {
+                if (32 * (uarts[u].ifs - SIM_IFS0) + __builtin_ctz(uarts[u].tx_mask) == irq) {
+                    start = &uarts[u];
+                }
+            }
+            while (start && Sim_uart_tx_level(start) && Sim_dma_cell(n)) {
+                ;
+            }
+        }
+        flags = sim_regs[DCH(n, DMA_INT)];
+        if (flags & (flags >> 16) & 0xFF) {
+            Sim_irq_set(SIM_IFS1, 1u << (16 + n));
+        }
+    }
+}
+
+/**
+ * @Function Sim_dma_cell(int n)
+ * @param n, DMA channel
+ * @return TRUE if the channel is still enabled for the next cell
+ * @brief moves one cell from the source to the destination, a register
+ * destination is written like a store from the CPU
+ * @author Aaron Hunter
+ */
+static int Sim_dma_cell(int n) {
+    uint32_t ssiz = sim_regs[DCH(n, DMA_SSIZ)] & 0xFF; // 8 bit sizes on the MX795
+    uint32_t dsiz = sim_regs[DCH(n, DMA_DSIZ)] & 0xFF;
+    uint32_t csiz = sim_regs[DCH(n, DMA_CSIZ)] & 0xFF;
+    uint32_t sptr = sim_regs[DCH(n, DMA_SPTR)];
+    uint32_t dptr = sim_regs[DCH(n, DMA_DPTR)];
+    uint32_t i;
+    uint32_t old;
+    uint8_t byte;
+    uint8_t *src;
+    uint8_t *dst;
+    int reg;
+
+    ssiz = ssiz ? ssiz : 256;
+    dsiz = dsiz ? dsiz : 256;
+    csiz = csiz ? csiz : 256;
+    for (i = 0; i < csiz; i++) {
+        reg = Sim_pa_to_reg(sim_regs[DCH(n, DMA_SSA)] + sptr);
+        src = Sim_pa_to_ram(sim_regs[DCH(n, DMA_SSA)] + sptr);
+        byte = reg >= 0 ? (uint8_t) sim_regs[reg] : src ? *src : 0;
+        reg = Sim_pa_to_reg(sim_regs[DCH(n, DMA_DSA)] + dptr);
+        dst = Sim_pa_to_ram(sim_regs[DCH(n, DMA_DSA)] + dptr);
+        if (reg >= 0) {
+            old = sim_regs[reg];
+            sim_regs[reg] = byte;
+            Sim_periph_write(reg, old, byte);
+        } else if (dst) {
+            *dst = byte;
+        } else {
+            sim_regs[DCH(n, DMA_INT)] |= CHTAIF; // address error
+            sim_regs[DCH(n, DMA_CON)] &= ~CHEN;
+            return FALSE;
+        }
+        sptr = sptr + 1 < ssiz ? sptr + 1 : 0;
+        dptr = dptr + 1 < dsiz ? dptr + 1 : 0;
+        if (sptr == 0 && ssiz >= dsiz) { // the larger size ends the block
+            dptr = 0;
+        } else if (dptr == 0 && dsiz > ssiz) {
+            sptr = 0;
+        } else {
+            continue;
+        }
+        sim_regs[DCH(n, DMA_INT)] |= CHBCIF | CHSDIF;
+        if (!(sim_regs[DCH(n, DMA_CON)] & CHAEN)) {
+            sim_regs[DCH(n, DMA_CON)] &= ~CHEN;
+        }
+        break;
+    }
+    sim_regs[DCH(n, DMA_SPTR)] = sptr;
+    sim_regs[DCH(n, DMA_DPTR)] = dptr;
+    sim_regs[DCH(n, DMA_INT)] |= CHCCIF;
+    sim_stats.dma_cells++;
+    return (sim_regs[DCH(n, DMA_CON)] & CHEN) != 0;
+}
+
+/**
+ * @Function Sim_timer_count(sim_timer_t *t, uint32_t pr)
+ * @param pr, period register the timer ran with
+ * @return the count of a running timer at sim_now
+ * @author Aaron Hunter
+ */
+static uint32_t Sim_timer_count(sim_timer_t *t, uint32_t pr) {
+    uint64_t ticks = (sim_now - t->base) * 1000 / t->tick_ps;
+    return (uint32_t) (ticks % ((uint64_t) (pr & 0xFFFF) + 1));
+}
+
+/**
+ * @Function Sim_timer_rebase(sim_timer_t *t, uint32_t count)
+ * @brief restarts the time base of a running timer at count
+ * @author Aaron Hunter
+ */
+static void Sim_timer_rebase(sim_timer_t *t, uint32_t count) {
+    uint32_t period = (sim_regs[t->pr] & 0xFFFF) + 1;
+    t->tick_ps = SIM_PB_PS * prescale[(sim_regs[t->con] >> 4) & 0x7];
+    count = count % period;
+    t->base = sim_now - (uint64_t) count * t->tick_ps / 1000;
+    t->periods = 0;
+    t->next = t->base + ((uint64_t) period * t->tick_ps + 999) / 1000;
+    Sim_schedule(t->next);
+}
+
+/**
+ * @Function Sim_timer_run(sim_timer_t *t)
+ * @return next period match
+ * @brief sets the interrupt flag on each period match
+ * @author Aaron Hunter
+ */
+static uint64_t Sim_timer_run(sim_timer_t *t) {
+    uint64_t period;
+    if (t->next == SIM_NEVER || !(sim_regs[t->con] & (1u << 15))) {
+        return SIM_NEVER;
+    }
+    if (sim_now >= t->next) {
+        period = (uint64_t) (sim_regs[t->pr] & 0xFFFF) + 1;
+        while (sim_now >= t->next) {
+            t->periods++;
+            t->next = t->base + ((t->periods + 1) * period * t->tick_ps + 999) / 1000;
+        }
+        Sim_irq_set(SIM_IFS0, t->if_mask);
+    }
+    return t->next;
+}
+
+/**
+ * @Function Sim_uart_reset(sim_uart_t *u)
+ * @brief UART off, FIFOs flushed
+ * @author Aaron Hunter
+ */
+static void Sim_uart_reset(sim_uart_t *u) {
+    u->tx_head = u->tx_count = 0;
+    u->rx_head = u->rx_count = 0;
+    u->shifting = FALSE;
+    sim_regs[u->sta] &= ~OERR;
+    Sim_uart_status(u);
+}
+
+/**
+ * @Function Sim_uart_status(sim_uart_t *u)
+ * @brief hardware bits of UxSTA from the FIFO state
+ * @author Aaron Hunter
+ */
+static void Sim_uart_status(sim_uart_t *u) {
+    uint32_t sta = sim_regs[u->sta] & ~(URXDA | TRMT | UTXBF);
+    if (u->rx_count > 0) {
+        sta |= URXDA;
+    }
+    if (!u->shifting && u->tx_count == 0) {
+        sta |= TRMT;
+    }
+    if (u->tx_count >= UART_FIFO) {
+        sta |= UTXBF;
+    }
+    sim_regs[u->sta] = sta;
+}
+
+/**
+ * @Function Sim_uart_run(int n)
+ * @return next character time
+ * @brief shifts out transmitted bytes and moves arriving bytes into the
+ * receive FIFO
+ * @author Aaron Hunter
+ */
+static uint64_t Sim_uart_run(int n) {
+    sim_uart_t *u = &uarts[n];
+    uint64_t next = SIM_NEVER;
+    int changed = FALSE;
+
+    while (u->shifting && sim_now >= u->shift_done) {
+        if (u->sink) {
+            u->sink(n, u->shift);
+        }
+        sim_stats.uart_tx[n]++;
+        changed = TRUE;
+        if (u->tx_count > 0) {
+            u->shift = u->txf[u->tx_head];
+            u->tx_head = (u->tx_head + 1) % UART_FIFO;
+            u->tx_count--;
+            u->shift_done += Sim_uart_char_ns(n);
+        } else {
+            u->shifting = FALSE;
+        }
+    }
+    while (u->wire_head != u->wire_tail && sim_now >= u->wire_next) {
+        uint8_t c = u->wire[u->wire_tail++ & (UART_WIRE - 1)];
+        u->wire_last = u->wire_next;
+        u->wire_next += Sim_uart_char_ns(n);
+        changed = TRUE;
+        if (!(sim_regs[u->mode] & (1u << 15)) || !(sim_regs[u->sta] & (1u << 12))) {
+            continue; // receiver off
+        }
+        if (sim_regs[u->sta] & OERR) {
+            sim_stats.uart_overrun[n]++;
+            continue;
+        }
+        if (u->rx_count == UART_FIFO) {
+            sim_regs[u->sta] |= OERR;
+            sim_stats.uart_overrun[n]++;
+            Sim_irq_set(u->ifs, u->e_mask);
+            continue;
+        }
+        u->rxf[(u->rx_head + u->rx_count) % UART_FIFO] = c;
+        u->rx_count++;
+    }
+    if (changed) {
+        Sim_uart_status(u);
+        Sim_irq_changed();
+    }
+    if (u->shifting) {
+        next = u->shift_done;
+    }
+    if (u->wire_head != u->wire_tail && u->wire_next < next) {
+        next = u->wire_next;
+    }
+    return next;
+}
+
+/**
+ * @Function Sim_spi_status(sim_spi_t *s)
+ * @brief hardware bits of SPIxSTAT from the buffer state
+ * @author Aaron Hunter
+ */
+static void Sim_spi_status(sim_spi_t *s) {
+    uint32_t stat = sim_regs[s->stat] & ~SPISTAT_HW;
+    stat |= s->rx_full ? SPIRBF : SPIRBE;
+    stat |= s->tx_pending ? SPITBF : SPITBE;
+    stat |= s->busy ? SPIBUSY : SRMT;
+    sim_regs[s->stat] = stat;
+}
+
+/**
+ * @Function Sim_spi_start(int n, uint32_t tx)
+ * @brief starts shifting a word at the SPIxBRG clock
+ * @author Aaron Hunter
+ */
+static void Sim_spi_start(int n, uint32_t tx) {
+    sim_spi_t *s = &spis[n];
+    uint32_t con = sim_regs[s->con];
+    uint64_t bits = (con & (1u << 11)) ? 32 : (con & (1u << 10)) ? 16 : 8;
+    s->busy = TRUE;
+    s->tx = tx;
+    s->done = sim_now + bits * 2 * (sim_regs[SIM_SPI1BRG + (n - 1) * 5] + 1) * SIM_PB_PS / 1000;
+    Sim_schedule(s->done);
+}
+
+/**
+ * @Function Sim_spi_run(int n)
+ * @return end of the transfer in progress
+ * @brief completes a transfer with the selected device, the receive buffer
+ * full sets SPIxRXIF
+ * @author Aaron Hunter
+ */
+static uint64_t Sim_spi_run(int n) {
+    sim_spi_t *s = &spis[n];
+    uint32_t con;
+    int bits;
+    uint32_t rx;
+
+    if (!s->busy) {
+        return SIM_NEVER;
+    }
+    if (sim_now < s->done) {
+        return s->done;
+    }
+    con = sim_regs[s->con];
+    bits = (con & (1u << 11)) ? 32 : (con & (1u << 10)) ? 16 : 8;
+    rx = Sim_dev_spi_xfer(n, bits == 32 ? s->tx : s->tx & ((1u << bits) - 1), bits);
+    sim_stats.spi_xfers[n]++;
+    s->busy = FALSE;
+    if (s->rx_full) {
+        sim_regs[s->stat] |= SPIROV; // new word lost
+    } else {
+        s->rx = rx;
+        s->rx_full = TRUE;
+    }
+    Sim_irq_set(s->ifs, s->rx_mask);
+    if (s->tx_pending) {
+        s->tx_pending = FALSE;
+        Sim_spi_start(n, s->tx_next);
+    }
+    Sim_spi_status(s);
+    return s->busy ? s->done : SIM_NEVER;
+}
+
+/**
+ * @Function Sim_i2c_bit_ns(sim_i2c_t *i)
+ * @return SCL period from I2CxBRG
+ * @author Aaron Hunter
+ */
+static uint64_t Sim_i2c_bit_ns(sim_i2c_t *i) {
+    return 2 * ((uint64_t) sim_regs[i->brg] + 2) * SIM_PB_PS / 1000;
+}
+
+/**
+ * @Function Sim_i2c_run(int n)
+ * @return end of the bus operation in progress
+ * @brief completes start, stop, acknowledge and byte operations, each sets
+ * the master interrupt flag
+ * @author Aaron Hunter
+ */
+static uint64_t Sim_i2c_run(int n) {
+    sim_i2c_t *i = &i2cs[n];
+    uint32_t stat;
+    int ack;
+
+    if (i->op == 0) {
+        return SIM_NEVER;
+    }
+    if (sim_now < i->done) {
+        return i->done;
+    }
+    stat = sim_regs[i->stat];
+    switch (i->op) {
+        case SEN:
+        case RSEN:
+            Sim_dev_i2c_start(n);
+            i->address_next = TRUE;
+            stat = (stat | I2C_S) & ~I2C_P;
+            break;
+        case PEN:
+            Sim_dev_i2c_stop(n);
+            stat = (stat | I2C_P) & ~I2C_S;
+            break;
+        case RCEN:
+            i->rcv_val = Sim_dev_i2c_read(n);
+            sim_stats.i2c_bytes++;
+            if (stat & RBF) {
+                stat |= 1u << 6; // I2COV
+            }
+            stat |= RBF;
+            break;
+        case ACKEN:
+            break;
+        case I2C_SEND:
+            ack = Sim_dev_i2c_write(n, i->trn_val, i->address_next);
+            i->address_next = FALSE;
+            sim_stats.i2c_bytes++;
+            stat &= ~(TBF | TRSTAT | ACKSTAT);
+            if (!ack) {
+                stat |= ACKSTAT;
+            }
+            break;
+    }
+    sim_regs[i->stat] = stat;
+    sim_regs[i->con] &= ~I2C_OPS;
+    i->op = 0;
+    Sim_irq_set(i->ifs, i->m_mask);
+    return SIM_NEVER;
+}
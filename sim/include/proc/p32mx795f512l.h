@@ -0,0 +1,699 @@
+/*
+ * File:   p32mx795f512l.h
+ * Brief: SIL stand-in for the XC32 PIC32MX795F512L register header.  Every
+ * special function register the libraries touch is a macro that calls
+ * sim_access(), which lets the simulator commit the previous access, advance
+ * virtual time, run the peripheral models and deliver interrupts before
+ * handing back a pointer to the register slot.  The bitfield views keep the
+ * datasheet bit positions so the driver code compiles unmodified.
+ * Only the registers used by the libraries are modeled, add new ones to
+ * SIM_REGISTERS() and as a macro below.
+ * Created on 10/16/2026
+ * Modified on 10/16/2026
+ */
+
+#ifndef SIM_P32MX795F512L_H // Header guard
+#define	SIM_P32MX795F512L_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+#include <stdint.h>
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+#define SIM_REGISTERS(X) \
+    X(CHECON) X(BMXCON) X(INTCON) X(DDPCON) \
+    X(IFS0) X(IFS1) X(IFS2) X(IEC0) X(IEC1) X(IEC2) \
+    X(IFS0CLR) X(IFS1CLR) X(IFS2CLR) X(IFS0SET) X(IFS1SET) X(IFS2SET) \
+    X(IEC0CLR) X(IEC1CLR) X(IEC2CLR) X(IEC0SET) X(IEC1SET) X(IEC2SET) \
+    X(IPC0) X(IPC1) X(IPC2) X(IPC3) X(IPC4) X(IPC5) X(IPC6) X(IPC7) \
+    X(IPC8) X(IPC9) X(IPC10) X(IPC11) X(IPC12) \
+    X(TRISA) X(TRISB) X(TRISD) X(TRISE) X(TRISF) X(TRISG) \
+    X(LATA) X(LATB) X(LATD) X(LATE) X(LATF) X(LATG) \
+    X(LATACLR) X(LATASET) X(LATAINV) X(LATDCLR) X(LATDSET) X(LATDINV) \
+    X(LATECLR) X(LATESET) X(LATEINV) \
+    X(T2CON) X(TMR2) X(PR2) X(T3CON) X(TMR3) X(PR3) \
+    X(T4CON) X(TMR4) X(PR4) X(T5CON) X(TMR5) X(PR5) \
+    X(OC1CON) X(OC1R) X(OC1RS) X(OC2CON) X(OC2R) X(OC2RS) \
+    X(OC3CON) X(OC3R) X(OC3RS) X(OC4CON) X(OC4R) X(OC4RS) \
+    X(OC5CON) X(OC5R) X(OC5RS) \
+    X(U1MODE) X(U1STA) X(U1TXREG) X(U1RXREG) X(U1BRG) \
+    X(U2MODE) X(U2STA) X(U2TXREG) X(U2RXREG) X(U2BRG) \
+    X(U3MODE) X(U3STA) X(U3TXREG) X(U3RXREG) X(U3BRG) \
+    X(U4MODE) X(U4STA) X(U4TXREG) X(U4RXREG) X(U4BRG) \
+    X(U5MODE) X(U5STA) X(U5TXREG) X(U5RXREG) X(U5BRG) \
+    X(U6MODE) X(U6STA) X(U6TXREG) X(U6RXREG) X(U6BRG) \
+    X(SPI1CON) X(SPI1STAT) X(SPI1BUF) X(SPI1BRG) X(SPI1STATCLR) \
+    X(SPI2CON) X(SPI2STAT) X(SPI2BUF) X(SPI2BRG) X(SPI2STATCLR) \
+    X(I2C1CON) X(I2C1STAT) X(I2C1BRG) X(I2C1TRN) X(I2C1RCV) \
+    X(I2C2CON) X(I2C2STAT) X(I2C2BRG) X(I2C2TRN) X(I2C2RCV) \
+    X(DMACON) SIM_DMA_CHANNEL(X, 0) SIM_DMA_CHANNEL(X, 1) \
+    SIM_DMA_CHANNEL(X, 2) SIM_DMA_CHANNEL(X, 3)
+
+/* the first four of the eight DMA channels */
+#define SIM_DMA_CHANNEL(X, n) \
+    X(DCH##n##CON) X(DCH##n##ECON) X(DCH##n##INT) X(DCH##n##SSA) X(DCH##n##DSA) \
+    X(DCH##n##SSIZ) X(DCH##n##DSIZ) X(DCH##n##SPTR) X(DCH##n##DPTR) \
+    X(DCH##n##CSIZ) X(DCH##n##CPTR)
+#define SIM_DMA_REGS 11 // registers per channel
+
+#define SIM_ENUM(name) SIM_##name,
+
+/* register and bitfield access through the simulator */
+#define SIM_REG(name) (*sim_access(SIM_##name))
+#define SIM_BITS(name, type) (*(volatile type *) sim_access(SIM_##name))
+
+/* XC32 built-ins, always available to the firmware */
+#define _CP0_CONFIG 16
+#define _CP0_CONFIG_SELECT 0
+#define _CP0_GET_COUNT() sim_core_count()
+#define _CP0_SET_COUNT(c) sim_core_set_count(c)
+#define __builtin_mtc0(reg, sel, val) ((void) (reg), (void) (sel), (void) (val))
+#define __builtin_disable_interrupts() sim_disable_interrupts()
+#define __builtin_enable_interrupts() sim_enable_interrupts()
+#define Nop() ((void) sim_access(-1))
+
+/* interrupt vectors */
+#define _CORE_TIMER_VECTOR 0
+#define _CORE_SOFTWARE_0_VECTOR 1
+#define _CORE_SOFTWARE_1_VECTOR 2
+#define _EXTERNAL_0_VECTOR 3
+#define _TIMER_1_VECTOR 4
+#define _INPUT_CAPTURE_1_VECTOR 5
+#define _OUTPUT_COMPARE_1_VECTOR 6
+#define _EXTERNAL_1_VECTOR 7
+#define _TIMER_2_VECTOR 8
+#define _INPUT_CAPTURE_2_VECTOR 9
+#define _OUTPUT_COMPARE_2_VECTOR 10
+#define _EXTERNAL_2_VECTOR 11
+#define _TIMER_3_VECTOR 12
+#define _INPUT_CAPTURE_3_VECTOR 13
+#define _OUTPUT_COMPARE_3_VECTOR 14
+#define _EXTERNAL_3_VECTOR 15
+#define _TIMER_4_VECTOR 16
+#define _INPUT_CAPTURE_4_VECTOR 17
+#define _OUTPUT_COMPARE_4_VECTOR 18
+#define _EXTERNAL_4_VECTOR 19
+#define _TIMER_5_VECTOR 20
+#define _INPUT_CAPTURE_5_VECTOR 21
+#define _OUTPUT_COMPARE_5_VECTOR 22
+#define _SPI_1_VECTOR 23
+#define _UART_1_VECTOR 24
+#define _I2C_3_VECTOR 24
+#define _SPI_3_VECTOR 24
+#define _I2C_1_VECTOR 25
+#define _I2C1_VECTOR 25
+#define _CHANGE_NOTICE_VECTOR 26
+#define _ADC_VECTOR 27
+#define _PMP_VECTOR 28
+#define _COMPARATOR_1_VECTOR 29
+#define _COMPARATOR_2_VECTOR 30
+#define _UART_3_VECTOR 31
+#define _SPI_2_VECTOR 31
+#define _I2C_4_VECTOR 31
+#define _UART_2_VECTOR 32
+#define _SPI_4_VECTOR 32
+#define _I2C_5_VECTOR 32
+#define _I2C_2_VECTOR 33
+#define _I2C2_VECTOR 33
+#define _FAIL_SAFE_MONITOR_VECTOR 34
+#define _RTCC_VECTOR 35
+#define _DMA_0_VECTOR 36
+#define _DMA_1_VECTOR 37
+#define _DMA_2_VECTOR 38
+#define _DMA_3_VECTOR 39
+#define _DMA_4_VECTOR 40
+#define _DMA_5_VECTOR 41
+#define _DMA_6_VECTOR 42
+#define _DMA_7_VECTOR 43
+#define _UART_4_VECTOR 49
+#define _UART_6_VECTOR 50
+#define _UART_5_VECTOR 51
+#define _Timer_3_Vector _TIMER_3_VECTOR
+
+/* interrupt request numbers, the DMA start and abort events */
+#define _UART1_TX_IRQ 28
+#define _UART2_TX_IRQ 42
+#define _UART4_TX_IRQ 69
+#define _UART5_TX_IRQ 75
+#define _UART6_TX_IRQ 72
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+enum sim_registers {
+    SIM_REGISTERS(SIM_ENUM)
+    SIM_NUM_REGISTERS
+};
+
+/* 16 pins of a port, e.g. LATE0 .. LATE15 */
+#define SIM_PIN16(p) \
+    unsigned p##0:1; unsigned p##1:1; unsigned p##2:1; unsigned p##3:1; \
+    unsigned p##4:1; unsigned p##5:1; unsigned p##6:1; unsigned p##7:1; \
+    unsigned p##8:1; unsigned p##9:1; unsigned p##10:1; unsigned p##11:1; \
+    unsigned p##12:1; unsigned p##13:1; unsigned p##14:1; unsigned p##15:1;
+
+#define SIM_PORT_T(p) typedef union { struct { SIM_PIN16(p) }; struct { unsigned w:32; }; } __##p##bits_t;
+SIM_PORT_T(TRISA) SIM_PORT_T(TRISB) SIM_PORT_T(TRISD) SIM_PORT_T(TRISE)
+SIM_PORT_T(TRISF) SIM_PORT_T(TRISG)
+SIM_PORT_T(LATA) SIM_PORT_T(LATB) SIM_PORT_T(LATD) SIM_PORT_T(LATE)
+SIM_PORT_T(LATF) SIM_PORT_T(LATG)
+
+/* interrupt flag and enable registers, S is IF or IE */
+#define SIM_INT_REG0(S) \
+    struct { \
+        unsigned CT##S:1; unsigned CS0##S:1; unsigned CS1##S:1; unsigned INT0##S:1; \
+        unsigned T1##S:1; unsigned IC1##S:1; unsigned OC1##S:1; unsigned INT1##S:1; \
+        unsigned T2##S:1; unsigned IC2##S:1; unsigned OC2##S:1; unsigned INT2##S:1; \
+        unsigned T3##S:1; unsigned IC3##S:1; unsigned OC3##S:1; unsigned INT3##S:1; \
+        unsigned T4##S:1; unsigned IC4##S:1; unsigned OC4##S:1; unsigned INT4##S:1; \
+        unsigned T5##S:1; unsigned IC5##S:1; unsigned OC5##S:1; unsigned SPI1E##S:1; \
+        unsigned SPI1RX##S:1; unsigned SPI1TX##S:1; unsigned U1E##S:1; unsigned U1RX##S:1; \
+        unsigned U1TX##S:1; unsigned I2C1B##S:1; unsigned I2C1S##S:1; unsigned I2C1M##S:1; \
+    }; \
+    struct { unsigned :26; unsigned SPI1AE##S:1; unsigned SPI1ARX##S:1; unsigned SPI1ATX##S:1; }; \
+    struct { unsigned :26; unsigned SPI3E##S:1; unsigned SPI3RX##S:1; unsigned SPI3TX##S:1; }; \
+    struct { unsigned :26; unsigned U1AE##S:1; unsigned U1ARX##S:1; unsigned U1ATX##S:1; }; \
+    struct { unsigned :26; unsigned I2C3B##S:1; unsigned I2C3S##S:1; unsigned I2C3M##S:1; }; \
+    struct { unsigned w:32; };
+
+#define SIM_INT_REG1(S) \
+    struct { \
+        unsigned CN##S:1; unsigned AD1##S:1; unsigned PMP##S:1; unsigned CMP1##S:1; \
+        unsigned CMP2##S:1; unsigned SPI2E##S:1; unsigned SPI2RX##S:1; unsigned SPI2TX##S:1; \
+        unsigned U2E##S:1; unsigned U2RX##S:1; unsigned U2TX##S:1; unsigned I2C2B##S:1; \
+        unsigned I2C2S##S:1; unsigned I2C2M##S:1; unsigned FSCM##S:1; unsigned RTCC##S:1; \
+        unsigned DMA0##S:1; unsigned DMA1##S:1; unsigned DMA2##S:1; unsigned DMA3##S:1; \
+        unsigned DMA4##S:1; unsigned DMA5##S:1; unsigned DMA6##S:1; unsigned DMA7##S:1; \
+        unsigned FCE##S:1; unsigned USB##S:1; unsigned CAN1##S:1; unsigned CAN2##S:1; \
+        unsigned ETH##S:1; unsigned IC1E##S:1; unsigned IC2E##S:1; unsigned IC3E##S:1; \
+    }; \
+    struct { unsigned :5; unsigned U3E##S:1; unsigned U3RX##S:1; unsigned U3TX##S:1; \
+        unsigned U2AE##S:1; unsigned U2ARX##S:1; unsigned U2ATX##S:1; }; \
+    struct { unsigned :5; unsigned SPI2AE##S:1; unsigned SPI2ARX##S:1; unsigned SPI2ATX##S:1; \
+        unsigned SPI4E##S:1; unsigned SPI4RX##S:1; unsigned SPI4TX##S:1; }; \
+    struct { unsigned w:32; };
+
+#define SIM_INT_REG2(S) \
+    struct { \
+        unsigned IC4E##S:1; unsigned IC5E##S:1; unsigned PMPE##S:1; unsigned U4E##S:1; \
+        unsigned U4RX##S:1; unsigned U4TX##S:1; unsigned U6E##S:1; unsigned U6RX##S:1; \
+        unsigned U6TX##S:1; unsigned U5E##S:1; unsigned U5RX##S:1; unsigned U5TX##S:1; \
+    }; \
+    struct { unsigned w:32; };
+
+typedef union { SIM_INT_REG0(IF) } __IFS0bits_t;
+typedef union { SIM_INT_REG1(IF) } __IFS1bits_t;
+typedef union { SIM_INT_REG2(IF) } __IFS2bits_t;
+typedef union { SIM_INT_REG0(IE) } __IEC0bits_t;
+typedef union { SIM_INT_REG1(IE) } __IEC1bits_t;
+typedef union { SIM_INT_REG2(IE) } __IEC2bits_t;
+
+/* priority registers, four vectors each */
+#define SIM_IPC_T(n, a, b, c, d) \
+    typedef union { \
+        struct { \
+            unsigned a##IS:2; unsigned a##IP:3; unsigned :3; \
+            unsigned b##IS:2; unsigned b##IP:3; unsigned :3; \
+            unsigned c##IS:2; unsigned c##IP:3; unsigned :3; \
+            unsigned d##IS:2; unsigned d##IP:3; unsigned :3; \
+        }; \
+        struct { unsigned w:32; }; \
+    } __IPC##n##bits_t;
+SIM_IPC_T(0, CT, CS0, CS1, INT0)
+SIM_IPC_T(1, T1, IC1, OC1, INT1)
+SIM_IPC_T(2, T2, IC2, OC2, INT2)
+SIM_IPC_T(3, T3, IC3, OC3, INT3)
+SIM_IPC_T(4, T4, IC4, OC4, INT4)
+SIM_IPC_T(5, T5, IC5, OC5, SPI1)
+SIM_IPC_T(6, U1, I2C1, CN, AD1)
+SIM_IPC_T(7, PMP, CMP1, CMP2, SPI2)
+SIM_IPC_T(8, U2, I2C2, FSCM, RTCC)
+SIM_IPC_T(9, DMA0, DMA1, DMA2, DMA3)
+SIM_IPC_T(10, DMA4, DMA5, DMA6, DMA7)
+SIM_IPC_T(11, FCE, USB, CAN1, CAN2)
+SIM_IPC_T(12, ETH, U4, U6, U5)
+
+typedef union {
+    struct {
+        unsigned PFMWS:3; unsigned :1; unsigned PREFEN:2; unsigned :2;
+        unsigned DCSZ:2; unsigned :6; unsigned CHECOH:1;
+    };
+    struct { unsigned w:32; };
+} __CHECONbits_t;
+
+typedef union {
+    struct {
+        unsigned BMXARB:3; unsigned :3; unsigned BMXWSDRM:1; unsigned :9;
+        unsigned BMXERRIS:1; unsigned BMXERRDS:1; unsigned BMXERRDMA:1;
+        unsigned BMXERRICD:1; unsigned BMXERRIXI:1; unsigned :1; unsigned BMXCHEDMA:1;
+    };
+    struct { unsigned w:32; };
+} __BMXCONbits_t;
+
+typedef union {
+    struct {
+        unsigned INT0EP:1; unsigned INT1EP:1; unsigned INT2EP:1; unsigned INT3EP:1;
+        unsigned INT4EP:1; unsigned :3; unsigned TPC:3; unsigned :1;
+        unsigned MVEC:1; unsigned :1; unsigned FRZ:1; unsigned :1; unsigned SS0:1;
+    };
+    struct { unsigned w:32; };
+} __INTCONbits_t;
+
+typedef union {
+    struct {
+        unsigned :2; unsigned TROEN:1; unsigned JTAGEN:1;
+    };
+    struct { unsigned w:32; };
+} __DDPCONbits_t;
+
+/* type B timers 2 to 5 */
+typedef union {
+    struct {
+        unsigned :1; unsigned TCS:1; unsigned :1; unsigned T32:1;
+        unsigned TCKPS:3; unsigned TGATE:1; unsigned :5; unsigned SIDL:1;
+        unsigned FRZ:1; unsigned ON:1;
+    };
+    struct { unsigned w:32; };
+} __TxCONbits_t;
+
+typedef union {
+    struct {
+        unsigned OCM:3; unsigned OCTSEL:1; unsigned OCFLT:1; unsigned OC32:1;
+        unsigned :7; unsigned SIDL:1; unsigned FRZ:1; unsigned ON:1;
+    };
+    struct { unsigned w:32; };
+} __OCxCONbits_t;
+
+typedef union {
+    struct {
+        unsigned STSEL:1; unsigned PDSEL:2; unsigned BRGH:1; unsigned RXINV:1;
+        unsigned ABAUD:1; unsigned LPBACK:1; unsigned WAKE:1; unsigned UEN:2;
+        unsigned :1; unsigned RTSMD:1; unsigned IREN:1; unsigned SIDL:1;
+        unsigned FRZ:1; unsigned ON:1;
+    };
+    struct { unsigned w:32; };
+} __UxMODEbits_t;
+
+typedef union {
+    struct {
+        unsigned URXDA:1; unsigned OERR:1; unsigned FERR:1; unsigned PERR:1;
+        unsigned RIDLE:1; unsigned ADDEN:1; unsigned URXISEL:2; unsigned TRMT:1;
+        unsigned UTXBF:1; unsigned UTXEN:1; unsigned UTXBRK:1; unsigned URXEN:1;
+        unsigned UTXINV:1; unsigned UTXISEL:2; unsigned ADDR:8; unsigned ADM_EN:1;
+    };
+    struct { unsigned w:32; };
+} __UxSTAbits_t;
+
+typedef union {
+    struct {
+        unsigned SRXISEL:2; unsigned STXISEL:2; unsigned DISSDI:1; unsigned MSTEN:1;
+        unsigned CKP:1; unsigned SSEN:1; unsigned CKE:1; unsigned SMP:1;
+        unsigned MODE16:1; unsigned MODE32:1; unsigned DISSDO:1; unsigned SIDL:1;
+        unsigned FRZ:1; unsigned ON:1; unsigned ENHBUF:1; unsigned SPIFE:1;
+        unsigned :10; unsigned MSSEN:1; unsigned FRMPOL:1; unsigned FRMSYNC:1;
+        unsigned FRMEN:1;
+    };
+    struct { unsigned w:32; };
+} __SPIxCONbits_t;
+
+typedef union {
+    struct {
+        unsigned SPIRBF:1; unsigned SPITBF:1; unsigned :1; unsigned SPITBE:1;
+        unsigned :1; unsigned SPIRBE:1; unsigned SPIROV:1; unsigned SRMT:1;
+        unsigned SPITUR:1; unsigned :2; unsigned SPIBUSY:1; unsigned FRMERR:1;
+        unsigned :3; unsigned TXBUFELM:5; unsigned :3; unsigned RXBUFELM:5;
+    };
+    struct { unsigned w:32; };
+} __SPIxSTATbits_t;
+
+typedef union {
+    struct {
+        unsigned SEN:1; unsigned RSEN:1; unsigned PEN:1; unsigned RCEN:1;
+        unsigned ACKEN:1; unsigned ACKDT:1; unsigned STREN:1; unsigned GCEN:1;
+        unsigned SMEN:1; unsigned DISSLW:1; unsigned A10M:1; unsigned STRICT:1;
+        unsigned SCLREL:1; unsigned SIDL:1; unsigned FRZ:1; unsigned ON:1;
+    };
+    struct { unsigned w:32; };
+} __I2CxCONbits_t;
+
+typedef union {
+    struct {
+        unsigned :11; unsigned DMABUSY:1; unsigned SUSPEND:1; unsigned :2;
+        unsigned ON:1;
+    };
+    struct { unsigned w:32; };
+} __DMACONbits_t;
+
+typedef union {
+    struct {
+        unsigned CHPRI:2; unsigned CHEDET:1; unsigned :1; unsigned CHAEN:1;
+        unsigned CHCHN:1; unsigned CHAED:1; unsigned CHEN:1; unsigned CHCHNS:1;
+        unsigned :6; unsigned CHBUSY:1;
+    };
+    struct { unsigned w:32; };
+} __DCHxCONbits_t;
+
+typedef union {
+    struct {
+        unsigned :3; unsigned AIRQEN:1; unsigned SIRQEN:1; unsigned PATEN:1;
+        unsigned CABORT:1; unsigned CFORCE:1; unsigned CHSIRQ:8; unsigned CHAIRQ:8;
+    };
+    struct { unsigned w:32; };
+} __DCHxECONbits_t;
+
+typedef union {
+    struct {
+        unsigned CHERIF:1; unsigned CHTAIF:1; unsigned CHCCIF:1; unsigned CHBCIF:1;
+        unsigned CHDHIF:1; unsigned CHDDIF:1; unsigned CHSHIF:1; unsigned CHSDIF:1;
+        unsigned :8;
+        unsigned CHERIE:1; unsigned CHTAIE:1; unsigned CHCCIE:1; unsigned CHBCIE:1;
+        unsigned CHDHIE:1; unsigned CHDDIE:1; unsigned CHSHIE:1; unsigned CHSDIE:1;
+    };
+    struct { unsigned w:32; };
+} __DCHxINTbits_t;
+
+typedef union {
+    struct {
+        unsigned TBF:1; unsigned RBF:1; unsigned R_W:1; unsigned S:1;
+        unsigned P:1; unsigned D_A:1; unsigned I2COV:1; unsigned IWCOL:1;
+        unsigned ADD10:1; unsigned GCSTAT:1; unsigned BCL:1; unsigned :3;
+        unsigned TRSTAT:1; unsigned ACKSTAT:1;
+    };
+    struct { unsigned w:32; };
+} __I2CxSTATbits_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function sim_access(int reg)
+ * @param reg, SIM_<register> index
+ * @return pointer to the register slot, valid until the next access
+ * @brief one CPU access to a special function register: commits the previous
+ * access, advances virtual time and services the peripherals and interrupts
+ * @author Aaron Hunter
+ */
+volatile uint32_t *sim_access(int reg);
+
+/**
+ * @Function sim_core_count(void)
+ * @return CP0 count, half the 80 MHz system clock, from virtual time
+ * @author Aaron Hunter
+ */
+uint32_t sim_core_count(void);
+
+/**
+ * @Function sim_core_set_count(uint32_t count)
+ * @param count, new CP0 count
+ * @author Aaron Hunter
+ */
+void sim_core_set_count(uint32_t count);
+
+/**
+ * @Function sim_disable_interrupts(void)
+ * @return previous status register, bit 0 is the interrupt enable
+ * @author Aaron Hunter
+ */
+unsigned int sim_disable_interrupts(void);
+
+/**
+ * @Function sim_enable_interrupts(void)
+ * @return previous status register, bit 0 is the interrupt enable
+ * @brief pending interrupts are delivered on the next register access
+ * @author Aaron Hunter
+ */
+unsigned int sim_enable_interrupts(void);
+
+/*******************************************************************************
+ * REGISTERS                                                                   *
+ ******************************************************************************/
+#define CHECON SIM_REG(CHECON)
+#define CHECONbits SIM_BITS(CHECON, __CHECONbits_t)
+#define BMXCON SIM_REG(BMXCON)
+#define BMXCONbits SIM_BITS(BMXCON, __BMXCONbits_t)
+#define INTCON SIM_REG(INTCON)
+#define INTCONbits SIM_BITS(INTCON, __INTCONbits_t)
+#define DDPCON SIM_REG(DDPCON)
+#define DDPCONbits SIM_BITS(DDPCON, __DDPCONbits_t)
+
+#define IFS0 SIM_REG(IFS0)
+#define IFS0bits SIM_BITS(IFS0, __IFS0bits_t)
+#define IFS0CLR SIM_REG(IFS0CLR)
+#define IFS0SET SIM_REG(IFS0SET)
+#define IFS1 SIM_REG(IFS1)
+#define IFS1bits SIM_BITS(IFS1, __IFS1bits_t)
+#define IFS1CLR SIM_REG(IFS1CLR)
+#define IFS1SET SIM_REG(IFS1SET)
+#define IFS2 SIM_REG(IFS2)
+#define IFS2bits SIM_BITS(IFS2, __IFS2bits_t)
+#define IFS2CLR SIM_REG(IFS2CLR)
+#define IFS2SET SIM_REG(IFS2SET)
+#define IEC0 SIM_REG(IEC0)
+#define IEC0bits SIM_BITS(IEC0, __IEC0bits_t)
+#define IEC0CLR SIM_REG(IEC0CLR)
+#define IEC0SET SIM_REG(IEC0SET)
+#define IEC1 SIM_REG(IEC1)
+#define IEC1bits SIM_BITS(IEC1, __IEC1bits_t)
+#define IEC1CLR SIM_REG(IEC1CLR)
+#define IEC1SET SIM_REG(IEC1SET)
+#define IEC2 SIM_REG(IEC2)
+#define IEC2bits SIM_BITS(IEC2, __IEC2bits_t)
+#define IEC2CLR SIM_REG(IEC2CLR)
+#define IEC2SET SIM_REG(IEC2SET)
+
+#define IPC0 SIM_REG(IPC0)
+#define IPC0bits SIM_BITS(IPC0, __IPC0bits_t)
+#define IPC1 SIM_REG(IPC1)
+#define IPC1bits SIM_BITS(IPC1, __IPC1bits_t)
+#define IPC2 SIM_REG(IPC2)
+#define IPC2bits SIM_BITS(IPC2, __IPC2bits_t)
+#define IPC3 SIM_REG(IPC3)
+#define IPC3bits SIM_BITS(IPC3, __IPC3bits_t)
+#define IPC4 SIM_REG(IPC4)
+#define IPC4bits SIM_BITS(IPC4, __IPC4bits_t)
+#define IPC5 SIM_REG(IPC5)
+#define IPC5bits SIM_BITS(IPC5, __IPC5bits_t)
+#define IPC6 SIM_REG(IPC6)
+#define IPC6bits SIM_BITS(IPC6, __IPC6bits_t)
+#define IPC7 SIM_REG(IPC7)
+#define IPC7bits SIM_BITS(IPC7, __IPC7bits_t)
+#define IPC8 SIM_REG(IPC8)
+#define IPC8bits SIM_BITS(IPC8, __IPC8bits_t)
+#define IPC9 SIM_REG(IPC9)
+#define IPC9bits SIM_BITS(IPC9, __IPC9bits_t)
+#define IPC10 SIM_REG(IPC10)
+#define IPC10bits SIM_BITS(IPC10, __IPC10bits_t)
+#define IPC11 SIM_REG(IPC11)
+#define IPC11bits SIM_BITS(IPC11, __IPC11bits_t)
+#define IPC12 SIM_REG(IPC12)
+#define IPC12bits SIM_BITS(IPC12, __IPC12bits_t)
+
+#define TRISA SIM_REG(TRISA)
+#define TRISAbits SIM_BITS(TRISA, __TRISAbits_t)
+#define TRISB SIM_REG(TRISB)
+#define TRISBbits SIM_BITS(TRISB, __TRISBbits_t)
+#define TRISD SIM_REG(TRISD)
+#define TRISDbits SIM_BITS(TRISD, __TRISDbits_t)
+#define TRISE SIM_REG(TRISE)
+#define TRISEbits SIM_BITS(TRISE, __TRISEbits_t)
+#define TRISF SIM_REG(TRISF)
+#define TRISFbits SIM_BITS(TRISF, __TRISFbits_t)
+#define TRISG SIM_REG(TRISG)
+#define TRISGbits SIM_BITS(TRISG, __TRISGbits_t)
+#define LATA SIM_REG(LATA)
+#define LATAbits SIM_BITS(LATA, __LATAbits_t)
+#define LATACLR SIM_REG(LATACLR)
+#define LATASET SIM_REG(LATASET)
+#define LATAINV SIM_REG(LATAINV)
+#define LATB SIM_REG(LATB)
+#define LATBbits SIM_BITS(LATB, __LATBbits_t)
+#define LATD SIM_REG(LATD)
+#define LATDbits SIM_BITS(LATD, __LATDbits_t)
+#define LATDCLR SIM_REG(LATDCLR)
+#define LATDSET SIM_REG(LATDSET)
+#define LATDINV SIM_REG(LATDINV)
+#define LATE SIM_REG(LATE)
+#define LATEbits SIM_BITS(LATE, __LATEbits_t)
+#define LATECLR SIM_REG(LATECLR)
+#define LATESET SIM_REG(LATESET)
+#define LATEINV SIM_REG(LATEINV)
+#define LATF SIM_REG(LATF)
+#define LATFbits SIM_BITS(LATF, __LATFbits_t)
+#define LATG SIM_REG(LATG)
+#define LATGbits SIM_BITS(LATG, __LATGbits_t)
+
+#define T2CON SIM_REG(T2CON)
+#define T2CONbits SIM_BITS(T2CON, __TxCONbits_t)
+#define TMR2 SIM_REG(TMR2)
+#define PR2 SIM_REG(PR2)
+#define T3CON SIM_REG(T3CON)
+#define T3CONbits SIM_BITS(T3CON, __TxCONbits_t)
+#define TMR3 SIM_REG(TMR3)
+#define PR3 SIM_REG(PR3)
+#define T4CON SIM_REG(T4CON)
+#define T4CONbits SIM_BITS(T4CON, __TxCONbits_t)
+#define TMR4 SIM_REG(TMR4)
+#define PR4 SIM_REG(PR4)
+#define T5CON SIM_REG(T5CON)
+#define T5CONbits SIM_BITS(T5CON, __TxCONbits_t)
+#define TMR5 SIM_REG(TMR5)
+#define PR5 SIM_REG(PR5)
+
+#define OC1CON SIM_REG(OC1CON)
+#define OC1CONbits SIM_BITS(OC1CON, __OCxCONbits_t)
+#define OC1R SIM_REG(OC1R)
+#define OC1RS SIM_REG(OC1RS)
+#define OC2CON SIM_REG(OC2CON)
+#define OC2CONbits SIM_BITS(OC2CON, __OCxCONbits_t)
+#define OC2R SIM_REG(OC2R)
+#define OC2RS SIM_REG(OC2RS)
+#define OC3CON SIM_REG(OC3CON)
+#define OC3CONbits SIM_BITS(OC3CON, __OCxCONbits_t)
+#define OC3R SIM_REG(OC3R)
+#define OC3RS SIM_REG(OC3RS)
+#define OC4CON SIM_REG(OC4CON)
+#define OC4CONbits SIM_BITS(OC4CON, __OCxCONbits_t)
+#define OC4R SIM_REG(OC4R)
+#define OC4RS SIM_REG(OC4RS)
+#define OC5CON SIM_REG(OC5CON)
+#define OC5CONbits SIM_BITS(OC5CON, __OCxCONbits_t)
+#define OC5R SIM_REG(OC5R)
+#define OC5RS SIM_REG(OC5RS)
+
+#define U1MODE SIM_REG(U1MODE)
+#define U1MODEbits SIM_BITS(U1MODE, __UxMODEbits_t)
+#define U1STA SIM_REG(U1STA)
+#define U1STAbits SIM_BITS(U1STA, __UxSTAbits_t)
+#define U1TXREG SIM_REG(U1TXREG)
+#define U1RXREG SIM_REG(U1RXREG)
+#define U1BRG SIM_REG(U1BRG)
+#define U2MODE SIM_REG(U2MODE)
+#define U2MODEbits SIM_BITS(U2MODE, __UxMODEbits_t)
+#define U2STA SIM_REG(U2STA)
+#define U2STAbits SIM_BITS(U2STA, __UxSTAbits_t)
+#define U2TXREG SIM_REG(U2TXREG)
+#define U2RXREG SIM_REG(U2RXREG)
+#define U2BRG SIM_REG(U2BRG)
+#define U3MODE SIM_REG(U3MODE)
+#define U3MODEbits SIM_BITS(U3MODE, __UxMODEbits_t)
+#define U3STA SIM_REG(U3STA)
+#define U3STAbits SIM_BITS(U3STA, __UxSTAbits_t)
+#define U3TXREG SIM_REG(U3TXREG)
+#define U3RXREG SIM_REG(U3RXREG)
+#define U3BRG SIM_REG(U3BRG)
+#define U4MODE SIM_REG(U4MODE)
+#define U4MODEbits SIM_BITS(U4MODE, __UxMODEbits_t)
+#define U4STA SIM_REG(U4STA)
+#define U4STAbits SIM_BITS(U4STA, __UxSTAbits_t)
+#define U4TXREG SIM_REG(U4TXREG)
+#define U4RXREG SIM_REG(U4RXREG)
+#define U4BRG SIM_REG(U4BRG)
+#define U5MODE SIM_REG(U5MODE)
+#define U5MODEbits SIM_BITS(U5MODE, __UxMODEbits_t)
+#define U5STA SIM_REG(U5STA)
+#define U5STAbits SIM_BITS(U5STA, __UxSTAbits_t)
+#define U5TXREG SIM_REG(U5TXREG)
+#define U5RXREG SIM_REG(U5RXREG)
+#define U5BRG SIM_REG(U5BRG)
+#define U6MODE SIM_REG(U6MODE)
+#define U6MODEbits SIM_BITS(U6MODE, __UxMODEbits_t)
+#define U6STA SIM_REG(U6STA)
+#define U6STAbits SIM_BITS(U6STA, __UxSTAbits_t)
+#define U6TXREG SIM_REG(U6TXREG)
+#define U6RXREG SIM_REG(U6RXREG)
+#define U6BRG SIM_REG(U6BRG)
+
+#define SPI1CON SIM_REG(SPI1CON)
+#define SPI1CONbits SIM_BITS(SPI1CON, __SPIxCONbits_t)
+#define SPI1STAT SIM_REG(SPI1STAT)
+#define SPI1STATbits SIM_BITS(SPI1STAT, __SPIxSTATbits_t)
+#define SPI1STATCLR SIM_REG(SPI1STATCLR)
+#define SPI1BUF SIM_REG(SPI1BUF)
+#define SPI1BRG SIM_REG(SPI1BRG)
+#define SPI2CON SIM_REG(SPI2CON)
+#define SPI2CONbits SIM_BITS(SPI2CON, __SPIxCONbits_t)
+#define SPI2STAT SIM_REG(SPI2STAT)
+#define SPI2STATbits SIM_BITS(SPI2STAT, __SPIxSTATbits_t)
+#define SPI2STATCLR SIM_REG(SPI2STATCLR)
+#define SPI2BUF SIM_REG(SPI2BUF)
+#define SPI2BRG SIM_REG(SPI2BRG)
+
+#define I2C1CON SIM_REG(I2C1CON)
+#define I2C1CONbits SIM_BITS(I2C1CON, __I2CxCONbits_t)
+#define I2C1STAT SIM_REG(I2C1STAT)
+#define I2C1STATbits SIM_BITS(I2C1STAT, __I2CxSTATbits_t)
+#define I2C1BRG SIM_REG(I2C1BRG)
+#define I2C1TRN SIM_REG(I2C1TRN)
+#define I2C1RCV SIM_REG(I2C1RCV)
+#define I2C2CON SIM_REG(I2C2CON)
+#define I2C2CONbits SIM_BITS(I2C2CON, __I2CxCONbits_t)
+#define I2C2STAT SIM_REG(I2C2STAT)
+#define I2C2STATbits SIM_BITS(I2C2STAT, __I2CxSTATbits_t)
+#define I2C2BRG SIM_REG(I2C2BRG)
+#define I2C2TRN SIM_REG(I2C2TRN)
+#define I2C2RCV SIM_REG(I2C2RCV)
+
+#define DMACON SIM_REG(DMACON)
+#define DMACONbits SIM_BITS(DMACON, __DMACONbits_t)
+#define DCH0CON SIM_REG(DCH0CON)
+#define DCH0CONbits SIM_BITS(DCH0CON, __DCHxCONbits_t)
+#define DCH0ECON SIM_REG(DCH0ECON)
+#define DCH0ECONbits SIM_BITS(DCH0ECON, __DCHxECONbits_t)
+#define DCH0INT SIM_REG(DCH0INT)
+#define DCH0INTbits SIM_BITS(DCH0INT, __DCHxINTbits_t)
+#define DCH0SSA SIM_REG(DCH0SSA)
+#define DCH0DSA SIM_REG(DCH0DSA)
+#define DCH0SSIZ SIM_REG(DCH0SSIZ)
+#define DCH0DSIZ SIM_REG(DCH0DSIZ)
+#define DCH0SPTR SIM_REG(DCH0SPTR)
+#define DCH0DPTR SIM_REG(DCH0DPTR)
+#define DCH0CSIZ SIM_REG(DCH0CSIZ)
+#define DCH0CPTR SIM_REG(DCH0CPTR)
+#define DCH1CON SIM_REG(DCH1CON)
+#define DCH1CONbits SIM_BITS(DCH1CON, __DCHxCONbits_t)
+#define DCH1ECON SIM_REG(DCH1ECON)
+#define DCH1ECONbits SIM_BITS(DCH1ECON, __DCHxECONbits_t)
+#define DCH1INT SIM_REG(DCH1INT)
+#define DCH1INTbits SIM_BITS(DCH1INT, __DCHxINTbits_t)
+#define DCH1SSA SIM_REG(DCH1SSA)
+#define DCH1DSA SIM_REG(DCH1DSA)
+#define DCH1SSIZ SIM_REG(DCH1SSIZ)
+#define DCH1DSIZ SIM_REG(DCH1DSIZ)
+#define DCH1SPTR SIM_REG(DCH1SPTR)
+#define DCH1DPTR SIM_REG(DCH1DPTR)
+#define DCH1CSIZ SIM_REG(DCH1CSIZ)
+#define DCH1CPTR SIM_REG(DCH1CPTR)
+#define DCH2CON SIM_REG(DCH2CON)
+#define DCH2CONbits SIM_BITS(DCH2CON, __DCHxCONbits_t)
+#define DCH2ECON SIM_REG(DCH2ECON)
+#define DCH2ECONbits SIM_BITS(DCH2ECON, __DCHxECONbits_t)
+#define DCH2INT SIM_REG(DCH2INT)
+#define DCH2INTbits SIM_BITS(DCH2INT, __DCHxINTbits_t)
+#define DCH2SSA SIM_REG(DCH2SSA)
+#define DCH2DSA SIM_REG(DCH2DSA)
+#define DCH2SSIZ SIM_REG(DCH2SSIZ)
+#define DCH2DSIZ SIM_REG(DCH2DSIZ)
+#define DCH2SPTR SIM_REG(DCH2SPTR)
+#define DCH2DPTR SIM_REG(DCH2DPTR)
+#define DCH2CSIZ SIM_REG(DCH2CSIZ)
+#define DCH2CPTR SIM_REG(DCH2CPTR)
+#define DCH3CON SIM_REG(DCH3CON)
+#define DCH3CONbits SIM_BITS(DCH3CON, __DCHxCONbits_t)
+#define DCH3ECON SIM_REG(DCH3ECON)
+#define DCH3ECONbits SIM_BITS(DCH3ECON, __DCHxECONbits_t)
+#define DCH3INT SIM_REG(DCH3INT)
+#define DCH3INTbits SIM_BITS(DCH3INT, __DCHxINTbits_t)
+#define DCH3SSA SIM_REG(DCH3SSA)
+#define DCH3DSA SIM_REG(DCH3DSA)
+#define DCH3SSIZ SIM_REG(DCH3SSIZ)
+#define DCH3DSIZ SIM_REG(DCH3DSIZ)
+#define DCH3SPTR SIM_REG(DCH3SPTR)
+#define DCH3DPTR SIM_REG(DCH3DPTR)
+#define DCH3CSIZ SIM_REG(DCH3CSIZ)
+#define DCH3CPTR SIM_REG(DCH3CPTR)
+
+#endif	/* SIM_P32MX795F512L_H */
@@ -0,0 +1,22 @@
+/*
+ * File:   attribs.h
+ * Brief: SIL stand-in for the XC32 ISR attributes.  __ISR() puts the handler
+ * in a section named for its vector so the simulator finds it through the
+ * linker's __start_sim_isr_<vector> symbol, static handlers included.  The
+ * priority argument is not used, the simulator takes the priority from the
+ * IPC registers like the interrupt controller does.
+ * Created on 10/16/2026
+ * Modified on 10/16/2026
+ */
+
+#ifndef SIM_ATTRIBS_H // Header guard
+#define	SIM_ATTRIBS_H //
+
+#define SIM_STR(x) #x
+#define SIM_XSTR(x) SIM_STR(x)
+
+#define __ISR(vector, ...) \
+    __attribute__((used, noinline, section("sim_isr_" SIM_XSTR(vector))))
+#define __ISR_AT_VECTOR(vector, ...) __ISR(vector)
+
+#endif	/* SIM_ATTRIBS_H */
@@ -0,0 +1,26 @@
+/*
+ * File:   kmem.h
+ * Brief: SIL stand-in for the XC32 address translation macros.  DMA channels
+ * take physical addresses, on the host the simulator hands out 32 bit
+ * addresses for the special function registers and for static RAM and maps
+ * them back when the DMA model moves data.
+ * Created on 10/16/2026
+ * Modified on 10/16/2026
+ */
+
+#ifndef SIM_KMEM_H // Header guard
+#define	SIM_KMEM_H //
+
+#include <stdint.h>
+
+#define KVA_TO_PA(v) sim_kva_to_pa((const volatile void *) (v))
+
+/**
+ * @Function sim_kva_to_pa(const volatile void *v)
+ * @param v, address of a register or of a static or global variable
+ * @return simulated physical address
+ * @author Aaron Hunter
+ */
+uint32_t sim_kva_to_pa(const volatile void *v);
+
+#endif	/* SIM_KMEM_H */
@@ -0,0 +1,15 @@
+/*
+ * File:   types.h
+ * Brief: XC32's sys/types.h also provides the stdint.h types, several lib
+ * headers rely on that
+ * Created on 10/16/2026
+ * Modified on 10/16/2026
+ */
+
+#ifndef SIM_SYS_TYPES_H // Header guard
+#define	SIM_SYS_TYPES_H //
+
+#include_next <sys/types.h>
+#include <stdint.h>
+
+#endif	/* SIM_SYS_TYPES_H */
@@ -0,0 +1,18 @@
+/*
+ * File:   xc.h
+ * Brief: SIL stand-in for the XC32 device header, pulls in the simulated
+ * PIC32MX795F512L registers and the ISR attributes.
+ * Created on 10/16/2026
+ * Modified on 10/16/2026
+ */
+
+#ifndef SIM_XC_H // Header guard
+#define	SIM_XC_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+#include <proc/p32mx795f512l.h>
+#include <sys/attribs.h>
+
+#endif	/* SIM_XC_H */